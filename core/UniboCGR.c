@@ -32,14 +32,28 @@
 #include "UniboCGRSAP.h"
 #include "contact_plan/contacts/contacts.h"
 #include "contact_plan/ranges/ranges.h"
+#include "contact_plan/nodes/node_index.h"
+#include "contact_plan/reservations/reservations.h"
+#include "contact_plan/binary_plan/binary_plan.h"
+#include "contact_plan/text_plan/text_plan.h"
+#include "contact_plan/delta/delta.h"
+#include "snapshot/snapshot.h"
+#include "cgr/route_cache.h"
 #include "routes/routes.h"
 #include "msr/msr_utils.h"
 #include "cgr/cgr.h"
 #include "msr/msr.h"
 #include "library/log/log.h"
+#include "library/pool/pool.h"
 #include "time_analysis/time.h"
 
 #define UNIBO_CGR_DTN_EPOCH 946684800
+/**
+ * \brief Max distance (seconds) of the internal current time from the time base.
+ *        Beyond it UniboCGR_feature_change_reference_time() moves the time base
+ *        (and rewrites all the stored times), otherwise it only records the new reference time.
+ */
+#define TIME_BASE_MAX_DISTANCE (MAX_POSIX_TIME / 2)
 
 typedef enum {
     UniboCGR_NoSession = 0,
@@ -60,15 +74,23 @@ struct UniboCGRSAP {
     /**
      * \brief Seconds elapsed since Unix epoch. Useful for debug/test purposes. In production code must be 0.
      *
+     * \details The value passed to UniboCGR_open() or to UniboCGR_feature_change_reference_time().
+     */
+    time_t reference_time;
+    /**
+     * \brief Unix time point of the internal time "0".
+     *
      * \details Each time passed to Unibo-CGR will be decreased by this quantity.
-     *          E.g. if the current time is "100" and the reference_time is "60"
+     *          E.g. if the current time is "100" and the time_base is "60"
      *          then Unibo-CGR interprets the current time as "40".
+     *          Set to the reference time by UniboCGR_open(); moved only when
+     *          the internal times would get too large (see TIME_BASE_MAX_DISTANCE).
      */
-    time_t reference_time;
+    time_t time_base;
     /**
      * \brief Keep the Unibo-CGR current time.
      *
-     * \details current_time + reference_time == Unix time point (seconds)
+     * \details current_time + time_base == Unix time point (seconds)
      */
     time_t current_time;
     /**
@@ -81,9 +103,17 @@ struct UniboCGRSAP {
     uint64_t localNode;
     /**
      * \brief True if it is safer to discard routing objects before process a routing call.
-     * \details e.g. contact/range insertion/removal/change or some routing-related feature has been enabled/disabled
+     * \details e.g. contact/range insertion, a contact/range change that may enable new routes
+     *          or some routing-related feature has been enabled/disabled.
+     *          The other contact/range changes only discard the routes of the destinations
+     *          reached through the changed contact/range.
      */
     bool mustClearRoutingObjects;
+    /**
+     * \brief Increased each time the contact plan or the features may have changed the routes.
+     * \details Used by the route cache to discard the entries filled before.
+     */
+    uint64_t contact_plan_epoch;
     /**
      * \brief Function implemented by interface. Used to retrieve information about a given neighbor during phase_two
      */
@@ -100,6 +130,19 @@ struct UniboCGRSAP {
      * \brief Handle the ranges graph.
      */
     RangeSAP* rangeSap;
+    /**
+     * \brief The shadow contacts (ranges) graph: edited while the routing keeps using
+     *        contactSap (rangeSap), then swapped with it by UniboCGR_shadow_contact_plan_publish().
+     *
+     * \details After a publish they keep the previous graphs (no more cited by any route),
+     *          reused by the next UniboCGR_shadow_contact_plan_open(). NULL until the first open.
+     */
+    ContactSAP* shadowContactSap;
+    RangeSAP* shadowRangeSap;
+    /**
+     * \brief True between UniboCGR_shadow_contact_plan_open() and publish/discard.
+     */
+    bool shadow_open;
     /**
      * \brief Handle the nodes graph.
      */
@@ -132,6 +175,32 @@ struct UniboCGRSAP {
      * \brief Used when time analysis is enabled.
      */
     TimeAnalysisSAP* timeAnalysisSap;
+    /**
+     * \brief Ledger of the volumes reserved by the routing calls.
+     */
+    ReservationSAP* reservationSap;
+    /**
+     * \brief Per-destination cache of the best routes.
+     */
+    RouteCacheSAP* routeCacheSap;
+    /**
+     * \brief Dense indexes of the ipn node numbers.
+     */
+    NodeIndexSAP* nodeIndexSap;
+    /**
+     * \brief Slab pools of the fixed-size objects: ContactBlock, Route, ListElt and RbtNode.
+     *
+     * \details NULL if MEMORY_POOLS is 0. Created first and destroyed last:
+     *          they must outlive every object taken from them.
+     */
+    Pool* contactPool;
+    Pool* routePool;
+    Pool* listEltPool;
+    Pool* rbtNodePool;
+    /**
+     * \brief Scratch arena of the per-call lists, reset by each routing call (see reset_cgr()).
+     */
+    Arena* scratchArena;
 
     ListElt* route_iterator;
     ListElt* hop_iterator;
@@ -145,6 +214,19 @@ struct UniboCGRSAP {
     bool feature_reactive_anti_loop;
     bool feature_proactive_anti_loop;
     bool feature_moderate_source_routing;
+    bool feature_volume_reservations;
+    bool feature_route_cache;
+    bool feature_contact_horizon;
+    /**
+     * \brief Horizon mode: the graph holds (at least) the contacts starting before
+     *        current_time + contact_horizon, the later ones are staged.
+     */
+    time_t contact_horizon;
+    /**
+     * \brief The horizon limit (internal time) of the routes: the contacts that start before it
+     *        are in the graph out of the contact plan sessions.
+     */
+    time_t contact_horizon_limit;
 };
 
 /* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
@@ -224,11 +306,71 @@ static UniboCGR_Error UniboCGR_force_update(UniboCGR uniboCgr) {
         return UniboCgr_ErrorSystem;
     }
 }
+static void UniboCGR_discard_contact_routes(UniboCGRSAP* uniboCgrSap, Contact* contact) {
+    discard_routes_citing_contact(contact);
+    if (contact->fromNode == uniboCgrSap->localNode) {
+        invalidate_local_node_neighbors_list(uniboCgrSap);
+    }
+}
+static void UniboCGR_discard_range_routes(UniboCGRSAP* uniboCgrSap, uint64_t sender, uint64_t receiver) {
+    discard_routes_through_node_pair(uniboCgrSap, sender, receiver);
+}
+/*
+ * Exchange the contact plan graphs with the shadow ones: the graph functions
+ * always work on the graphs set in the SAP.
+ */
+static void UniboCGR_swap_shadow_contact_plan(UniboCGRSAP* uniboCgrSap) {
+    ContactSAP* contactSap = uniboCgrSap->contactSap;
+    RangeSAP* rangeSap = uniboCgrSap->rangeSap;
+    uniboCgrSap->contactSap = uniboCgrSap->shadowContactSap;
+    uniboCgrSap->rangeSap = uniboCgrSap->shadowRangeSap;
+    uniboCgrSap->shadowContactSap = contactSap;
+    uniboCgrSap->shadowRangeSap = rangeSap;
+}
+/*
+ * Create the memory pools of the instance. On error the pools already created are kept:
+ * UniboCGR_close_memory_pools() destroys them.
+ */
+static int UniboCGR_open_memory_pools(UniboCGRSAP* uniboCgrSap) {
+#if (MEMORY_POOLS)
+    uniboCgrSap->contactPool = pool_create(sizeof(ContactBlock), MEMORY_POOLS_SLAB_ELEMENTS);
+    uniboCgrSap->routePool = pool_create(sizeof(Route), MEMORY_POOLS_SLAB_ELEMENTS);
+    uniboCgrSap->listEltPool = pool_create(sizeof(ListElt), MEMORY_POOLS_SLAB_ELEMENTS);
+    uniboCgrSap->rbtNodePool = pool_create(sizeof(RbtNode), MEMORY_POOLS_SLAB_ELEMENTS);
+    uniboCgrSap->scratchArena = arena_create(SCRATCH_ARENA_CHUNK_SIZE);
+    if (!uniboCgrSap->contactPool || !uniboCgrSap->routePool || !uniboCgrSap->listEltPool
+        || !uniboCgrSap->rbtNodePool || !uniboCgrSap->scratchArena) {
+        return -2;
+    }
+#else
+    (void) uniboCgrSap;
+#endif
+    return 0;
+}
+static void UniboCGR_close_memory_pools(UniboCGRSAP* uniboCgrSap) {
+    pool_destroy(uniboCgrSap->contactPool);
+    pool_destroy(uniboCgrSap->routePool);
+    pool_destroy(uniboCgrSap->listEltPool);
+    pool_destroy(uniboCgrSap->rbtNodePool);
+    arena_destroy(uniboCgrSap->scratchArena);
+    uniboCgrSap->contactPool = NULL;
+    uniboCgrSap->routePool = NULL;
+    uniboCgrSap->listEltPool = NULL;
+    uniboCgrSap->rbtNodePool = NULL;
+    uniboCgrSap->scratchArena = NULL;
+}
+static void UniboCGR_shadow_contact_plan_destroy(UniboCGRSAP* uniboCgrSap) {
+    UniboCGR_swap_shadow_contact_plan(uniboCgrSap);
+    ContactSAP_close(uniboCgrSap);
+    RangeSAP_close(uniboCgrSap);
+    UniboCGR_swap_shadow_contact_plan(uniboCgrSap);
+    uniboCgrSap->shadow_open = false;
+}
 static void UniboCGR_set_current_time(UniboCGR uniboCgr, time_t current_time) {
     if (!uniboCgr) { return; }
 
     UniboCGRSAP* uniboCgrSap = (UniboCGRSAP*) uniboCgr;
-    uniboCgrSap->current_time = current_time - uniboCgrSap->reference_time;
+    uniboCgrSap->current_time = current_time - uniboCgrSap->time_base;
     LogSAP_setLogTime(uniboCgrSap, uniboCgrSap->current_time);
 }
 const char* UniboCGR_get_error_string(UniboCGR_Error error) {
@@ -251,6 +393,11 @@ const char* UniboCGR_get_error_string(UniboCGR_Error error) {
         case UniboCGR_ErrorSessionAlreadyOpened:    return "Unibo-CGR: Session is already opened.";
         case UniboCGR_ErrorSessionClosed:           return "Unibo-CGR: Session is closed.";
         case UniboCGR_ErrorWrongSession:            return "Unibo-CGR: Wrong session.";
+        case UniboCGR_ErrorReservationNotFound:     return "Unibo-CGR: Reservation not found.";
+        case UniboCGR_ErrorBufferTooSmall:          return "Unibo-CGR: Buffer too small.";
+        case UniboCGR_ErrorCannotOpenFile:          return "Unibo-CGR: Cannot open file.";
+        case UniboCGR_ErrorMalformedFile:           return "Unibo-CGR: Malformed file.";
+        case UniboCGR_ErrorSnapshotMismatch:        return "Unibo-CGR: Snapshot of another contact plan.";
     }
     return "Unibo-CGR: Unknown error.";
 }
@@ -277,6 +424,11 @@ bool UniboCGR_check_fatal_error(UniboCGR_Error error) {
         case UniboCGR_ErrorSessionAlreadyOpened:    return false;
         case UniboCGR_ErrorSessionClosed:           return false;
         case UniboCGR_ErrorWrongSession:            return false;
+        case UniboCGR_ErrorReservationNotFound:     return false;
+        case UniboCGR_ErrorBufferTooSmall:          return false;
+        case UniboCGR_ErrorCannotOpenFile:          return false;
+        case UniboCGR_ErrorMalformedFile:           return false;
+        case UniboCGR_ErrorSnapshotMismatch:        return false;
     }
 
     return false;
@@ -298,7 +450,7 @@ UniboCGR_Error UniboCGR_find_contact(UniboCGR uniboCgr,
 
     UniboCGRSAP* uniboCgrSap = (UniboCGRSAP*) uniboCgr;
 
-    start_time -= uniboCgrSap->reference_time;
+    start_time -= uniboCgrSap->time_base;
     Contact* ct = get_contact(uniboCgrSap, sender, receiver, start_time, &uniboCgrSap->contact_iterator);
     if (ct == NULL) {
         return UniboCGR_ErrorContactNotFound;
@@ -340,7 +492,7 @@ UniboCGR_Error UniboCGR_find_range(UniboCGR uniboCgr,
 
     UniboCGRSAP* uniboCgrSap = (UniboCGRSAP*) uniboCgr;
 
-    start_time -= uniboCgrSap->reference_time;
+    start_time -= uniboCgrSap->time_base;
     Range* range = get_range(uniboCgrSap, sender, receiver, start_time, &uniboCgrSap->range_iterator);
     if (range == NULL) {
         return UniboCGR_ErrorRangeNotFound;
@@ -433,11 +585,16 @@ UniboCGR_Error UniboCGR_open(UniboCGR* uniboCgr,
     uniboCgrSap->mustClearRoutingObjects = true;
 
     uniboCgrSap->reference_time = time_zero;
-    uniboCgrSap->current_time = current_time - uniboCgrSap->reference_time;
+    uniboCgrSap->time_base = time_zero;
+    uniboCgrSap->current_time = current_time - uniboCgrSap->time_base;
     uniboCgrSap->localNode = local_node;
 
     int retval;
 
+    retval = UniboCGR_open_memory_pools(uniboCgrSap);
+    if (retval != 0) { UniboCGR_close(uniboCgr, current_time); return UniboCgr_ErrorSystem; }
+    retval = NodeIndexSAP_open(uniboCgrSap);
+    if (retval != 0) { UniboCGR_close(uniboCgr, current_time); return UniboCgr_ErrorSystem; }
     retval = PhaseOneSAP_open(uniboCgrSap);
     if (retval != 0) { UniboCGR_close(uniboCgr, current_time); return UniboCgr_ErrorSystem; }
     retval = PhaseTwoSAP_open(uniboCgrSap);
@@ -462,6 +619,10 @@ UniboCGR_Error UniboCGR_open(UniboCGR* uniboCgr,
     if (retval != 0) { UniboCGR_close(uniboCgr, current_time); return UniboCgr_ErrorSystem; }
     retval = TimeAnalysisSAP_open(uniboCgrSap);
     if (retval != 0) { UniboCGR_close(uniboCgr, current_time); return UniboCgr_ErrorSystem; }
+    retval = ReservationSAP_open(uniboCgrSap);
+    if (retval != 0) { UniboCGR_close(uniboCgr, current_time); return UniboCgr_ErrorSystem; }
+    retval = RouteCacheSAP_open(uniboCgrSap);
+    if (retval != 0) { UniboCGR_close(uniboCgr, current_time); return UniboCgr_ErrorSystem; }
 
     *uniboCgr = (UniboCGR) uniboCgrSap;
 
@@ -473,7 +634,7 @@ void UniboCGR_close(UniboCGR* uniboCgr, time_t current_time) {
 
     UniboCGRSAP* uniboCgrSap = (UniboCGRSAP*) *uniboCgr;
 
-    uniboCgrSap->current_time = current_time - uniboCgrSap->reference_time;
+    uniboCgrSap->current_time = current_time - uniboCgrSap->time_base;
     LogSAP_setLogTime(uniboCgrSap, uniboCgrSap->current_time);
     PhaseOneSAP_close(uniboCgrSap);
     PhaseTwoSAP_close(uniboCgrSap);
@@ -481,11 +642,16 @@ void UniboCGR_close(UniboCGR* uniboCgr, time_t current_time) {
     UniboCgrCurrentCallSAP_close(uniboCgrSap);
     MSRSAP_close(uniboCgrSap);
     NodeSAP_close(uniboCgrSap);
+    UniboCGR_shadow_contact_plan_destroy(uniboCgrSap);
     ContactSAP_close(uniboCgrSap);
     RangeSAP_close(uniboCgrSap);
     TimeAnalysisSAP_close(uniboCgrSap);
+    ReservationSAP_close(uniboCgrSap);
+    RouteCacheSAP_close(uniboCgrSap);
+    NodeIndexSAP_close(uniboCgrSap);
     writeLog(uniboCgrSap, "Shutdown.");
     LogSAP_close(uniboCgrSap);
+    UniboCGR_close_memory_pools(uniboCgrSap);
 
     memset(uniboCgrSap, 0, sizeof(UniboCGRSAP));
     MDEPOSIT(uniboCgrSap);
@@ -503,9 +669,15 @@ void UniboCGRSAP_MDEPOSIT(const char* file, int line, void* addr) {
 time_t UniboCGRSAP_get_current_time(UniboCGRSAP* uniboCgrSap) {
     return uniboCgrSap->current_time;
 }
+time_t UniboCGRSAP_get_time_base(UniboCGRSAP* uniboCgrSap) {
+    return uniboCgrSap->time_base;
+}
 uint64_t UniboCGRSAP_get_local_node(UniboCGRSAP* uniboCgrSap) {
     return uniboCgrSap->localNode;
 }
+uint64_t UniboCGRSAP_get_contact_plan_epoch(UniboCGRSAP* uniboCgrSap) {
+    return uniboCgrSap->contact_plan_epoch;
+}
 uint32_t UniboCGRSAP_get_bundle_count(UniboCGRSAP* uniboCgrSap) {
     return uniboCgrSap->count_bundles;
 }
@@ -547,6 +719,21 @@ int UniboCGRSAP_compute_applicable_backlog(UniboCGRSAP* uniboCgrSap,
     convert_uint64_to_scalar(total_backlog_u64, totalBacklog);
     return 0;
 }
+Pool* UniboCGRSAP_get_contact_pool(UniboCGRSAP* uniboCgrSap) {
+    return uniboCgrSap->contactPool;
+}
+Pool* UniboCGRSAP_get_route_pool(UniboCGRSAP* uniboCgrSap) {
+    return uniboCgrSap->routePool;
+}
+Pool* UniboCGRSAP_get_list_elt_pool(UniboCGRSAP* uniboCgrSap) {
+    return uniboCgrSap->listEltPool;
+}
+Pool* UniboCGRSAP_get_rbt_node_pool(UniboCGRSAP* uniboCgrSap) {
+    return uniboCgrSap->rbtNodePool;
+}
+Arena* UniboCGRSAP_get_scratch_arena(UniboCGRSAP* uniboCgrSap) {
+    return uniboCgrSap->scratchArena;
+}
 bool UniboCGRSAP_check_one_route_per_neighbor(UniboCGRSAP* uniboCgrSap, uint32_t* limit) {
     if (limit) {
         *limit = uniboCgrSap->feature_one_route_per_neighbor_limit;
@@ -568,6 +755,12 @@ bool UniboCGRSAP_check_proactive_anti_loop(UniboCGRSAP* uniboCgrSap) {
 bool UniboCGRSAP_check_moderate_source_routing(UniboCGRSAP* uniboCgrSap) {
     return uniboCgrSap->feature_moderate_source_routing;
 }
+bool UniboCGRSAP_check_volume_reservations(UniboCGRSAP* uniboCgrSap) {
+    return uniboCgrSap->feature_volume_reservations;
+}
+bool UniboCGRSAP_check_route_cache(UniboCGRSAP* uniboCgrSap) {
+    return uniboCgrSap->feature_route_cache;
+}
 void UniboCGRSAP_tweak_one_route_per_neighbor(UniboCGRSAP* uniboCgrSap, bool featureFlag, uint32_t limit) {
     uniboCgrSap->feature_one_route_per_neighbor = featureFlag;
     uniboCgrSap->feature_one_route_per_neighbor_limit = limit;
@@ -632,6 +825,24 @@ void UniboCGRSAP_set_TimeAnalysisSAP(UniboCGRSAP* uniboCgrSap, TimeAnalysisSAP*
 TimeAnalysisSAP* UniboCGRSAP_get_TimeAnalysisSAP(UniboCGRSAP* uniboCgrSap) {
     return uniboCgrSap->timeAnalysisSap;
 }
+void UniboCGRSAP_set_ReservationSAP(UniboCGRSAP* uniboCgrSap, ReservationSAP* reservationSap) {
+    uniboCgrSap->reservationSap = reservationSap;
+}
+ReservationSAP* UniboCGRSAP_get_ReservationSAP(UniboCGRSAP* uniboCgrSap) {
+    return uniboCgrSap->reservationSap;
+}
+void UniboCGRSAP_set_RouteCacheSAP(UniboCGRSAP* uniboCgrSap, RouteCacheSAP* routeCacheSap) {
+    uniboCgrSap->routeCacheSap = routeCacheSap;
+}
+RouteCacheSAP* UniboCGRSAP_get_RouteCacheSAP(UniboCGRSAP* uniboCgrSap) {
+    return uniboCgrSap->routeCacheSap;
+}
+void UniboCGRSAP_set_NodeIndexSAP(UniboCGRSAP* uniboCgrSap, NodeIndexSAP* nodeIndexSap) {
+    uniboCgrSap->nodeIndexSap = nodeIndexSap;
+}
+NodeIndexSAP* UniboCGRSAP_get_NodeIndexSAP(UniboCGRSAP* uniboCgrSap) {
+    return uniboCgrSap->nodeIndexSap;
+}
 
 /* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
  *                    UNIBO-CGR SESSION FEATURE                        *
@@ -649,24 +860,46 @@ UniboCGR_Error UniboCGR_feature_close(UniboCGR uniboCgr) {
     if (!uniboCgr) return UniboCGR_ErrorInvalidArgument;
     UniboCGRSAP* uniboCgrSap = (UniboCGRSAP *) uniboCgr;
     CHECK_EQUAL_SESSION(UniboCGR_Session_feature);
+    uniboCgrSap->contact_plan_epoch++; // cached routes may not reflect the new features
     uniboCgrSap->session = UniboCGR_NoSession;
     LogSAP_log_fflush(uniboCgrSap);
     return UniboCGR_NoError;
 }
-UniboCGR_Error UniboCGR_feature_change_reference_time(UniboCGR uniboCgr, time_t new_reference_time) {
-    if (!uniboCgr || new_reference_time < 0) return UniboCGR_ErrorInvalidArgument;
-    UniboCGRSAP* uniboCgrSap = (UniboCGRSAP *) uniboCgr;
-    const time_t diff = new_reference_time- uniboCgrSap->reference_time;
-    const time_t new_current_time = uniboCgrSap->current_time - diff;
-    if (new_current_time < 0) return UniboCGR_ErrorInvalidArgument;
-    UniboCGR_force_update(uniboCgr); // discard all routes
-    uniboCgrSap->current_time = new_current_time;
-    uniboCgrSap->reference_time = new_reference_time;
+static void UniboCGR_move_time_base(UniboCGRSAP* uniboCgrSap, time_t new_time_base) {
+    const time_t diff = new_time_base - uniboCgrSap->time_base;
+    UniboCGR_force_update((UniboCGR) uniboCgrSap); // discard all routes
+    uniboCgrSap->current_time -= diff;
+    uniboCgrSap->time_base = new_time_base;
     LogSAP_setLogTime(uniboCgrSap, uniboCgrSap->current_time);
     ContactSAP_decrease_time(uniboCgrSap, diff);
     RangeSAP_decrease_time(uniboCgrSap, diff);
+    if (uniboCgrSap->contact_horizon_limit != 0) {
+        uniboCgrSap->contact_horizon_limit -= diff;
+    }
+    if (uniboCgrSap->shadowContactSap) {
+        UniboCGR_swap_shadow_contact_plan(uniboCgrSap);
+        ContactSAP_decrease_time(uniboCgrSap, diff);
+        RangeSAP_decrease_time(uniboCgrSap, diff);
+        UniboCGR_swap_shadow_contact_plan(uniboCgrSap);
+    }
+    ReservationSAP_decrease_time(uniboCgrSap, diff);
     LogSAP_log_contact_plan(uniboCgrSap);
 
+    writeLog(uniboCgrSap, "New time base (Unix Time): %ld s.", (long int) new_time_base);
+}
+UniboCGR_Error UniboCGR_feature_change_reference_time(UniboCGR uniboCgr, time_t new_reference_time) {
+    if (!uniboCgr || new_reference_time < 0) return UniboCGR_ErrorInvalidArgument;
+    UniboCGRSAP* uniboCgrSap = (UniboCGRSAP *) uniboCgr;
+    const time_t current_time_unix = uniboCgrSap->current_time + uniboCgrSap->time_base;
+    if (current_time_unix < new_reference_time) return UniboCGR_ErrorInvalidArgument;
+    uniboCgrSap->reference_time = new_reference_time;
+
+    // internal times are relative to time_base: usually nothing else changes,
+    // contacts, ranges and computed routes are kept as they are.
+    if (uniboCgrSap->current_time > TIME_BASE_MAX_DISTANCE) {
+        UniboCGR_move_time_base(uniboCgrSap, new_reference_time);
+    }
+
     writeLog(uniboCgrSap, "New reference time (Unix Time): %ld s.", (long int) new_reference_time);
 
     return UniboCGR_NoError;
@@ -687,6 +920,7 @@ UniboCGR_Error UniboCGR_feature_logger_enable(UniboCGR uniboCgr, const char* log
                  UNIBO_CGR_VERSION_PATCH);
         writeLog(uniboCgrSap, "Local node number: %llu.", UniboCGRSAP_get_local_node(uniboCgrSap));
         writeLog(uniboCgrSap, "Reference time (Unix time): %" PRId64" s.", (int64_t) uniboCgrSap->reference_time);
+        writeLog(uniboCgrSap, "Time base (Unix time): %" PRId64" s.", (int64_t) uniboCgrSap->time_base);
         LogSAP_log_contact_plan(uniboCgrSap);
         return UniboCGR_NoError;
     } else if (retval == -2) {
@@ -748,9 +982,9 @@ UniboCGR_Error UniboCGR_feature_QueueDelay_enable(UniboCGR uniboCgr) {
     UniboCGRSAP* uniboCgrSap = (UniboCGRSAP*) uniboCgr;
     CHECK_EQUAL_SESSION(UniboCGR_Session_feature);
     if (!uniboCgrSap->feature_queue_delay) {
+        // applied by phase two at each call -- computed routes are still valid
         uniboCgrSap->feature_queue_delay = true;
         writeLog(uniboCgrSap, "Queue delay enabled - ETO on all hops.");
-        return UniboCGR_force_update(uniboCgr);
     }
     return UniboCGR_NoError;
 }
@@ -759,9 +993,9 @@ UniboCGR_Error UniboCGR_feature_QueueDelay_disable(UniboCGR uniboCgr) {
     UniboCGRSAP* uniboCgrSap = (UniboCGRSAP*) uniboCgr;
     CHECK_EQUAL_SESSION(UniboCGR_Session_feature);
     if (uniboCgrSap->feature_queue_delay) {
+        // applied by phase two at each call -- computed routes are still valid
         uniboCgrSap->feature_queue_delay = false;
         writeLog(uniboCgrSap, "Queue delay disabled - ETO only on the first hop.");
-        return UniboCGR_force_update(uniboCgr);
     }
     return UniboCGR_NoError;
 }
@@ -770,9 +1004,9 @@ UniboCGR_Error UniboCGR_feature_ModerateSourceRouting_enable(UniboCGR uniboCgr)
     UniboCGRSAP* uniboCgrSap = (UniboCGRSAP*) uniboCgr;
     CHECK_EQUAL_SESSION(UniboCGR_Session_feature);
     if (!uniboCgrSap->feature_moderate_source_routing) {
+        // MSR routes are rebuilt at each call -- computed routes are still valid
         uniboCgrSap->feature_moderate_source_routing = true;
         writeLog(uniboCgrSap, "Moderate Source Routing enabled.");
-        return UniboCGR_force_update(uniboCgr);
     }
     return UniboCGR_NoError;
 }
@@ -781,9 +1015,9 @@ UniboCGR_Error UniboCGR_feature_ModerateSourceRouting_disable(UniboCGR uniboCgr)
     UniboCGRSAP* uniboCgrSap = (UniboCGRSAP*) uniboCgr;
     CHECK_EQUAL_SESSION(UniboCGR_Session_feature);
     if (uniboCgrSap->feature_moderate_source_routing) {
+        // MSR routes are rebuilt at each call -- computed routes are still valid
         uniboCgrSap->feature_moderate_source_routing = false;
         writeLog(uniboCgrSap, "Moderate Source Routing disabled.");
-        return UniboCGR_force_update(uniboCgr);
     }
     return UniboCGR_NoError;
 }
@@ -792,9 +1026,9 @@ UniboCGR_Error UniboCGR_feature_ReactiveAntiLoop_enable(UniboCGR uniboCgr) {
     UniboCGRSAP* uniboCgrSap = (UniboCGRSAP*) uniboCgr;
     CHECK_EQUAL_SESSION(UniboCGR_Session_feature);
     if (!uniboCgrSap->feature_reactive_anti_loop) {
+        // applied by phase two/three at each call -- computed routes are still valid
         uniboCgrSap->feature_reactive_anti_loop = true;
         writeLog(uniboCgrSap, "Reactive anti-loop mechanism enabled.");
-        return UniboCGR_force_update(uniboCgr);
     }
     return UniboCGR_NoError;
 }
@@ -803,9 +1037,9 @@ UniboCGR_Error UniboCGR_feature_ReactiveAntiLoop_disable(UniboCGR uniboCgr) {
     UniboCGRSAP* uniboCgrSap = (UniboCGRSAP*) uniboCgr;
     CHECK_EQUAL_SESSION(UniboCGR_Session_feature);
     if (uniboCgrSap->feature_reactive_anti_loop) {
+        // applied by phase two/three at each call -- computed routes are still valid
         uniboCgrSap->feature_reactive_anti_loop = false;
         writeLog(uniboCgrSap, "Reactive anti-loop mechanism disabled.");
-        return UniboCGR_force_update(uniboCgr);
     }
     return UniboCGR_NoError;
 }
@@ -815,9 +1049,9 @@ UniboCGR_Error UniboCGR_feature_ProactiveAntiLoop_enable(UniboCGR uniboCgr) {
     UniboCGRSAP* uniboCgrSap = (UniboCGRSAP*) uniboCgr;
     CHECK_EQUAL_SESSION(UniboCGR_Session_feature);
     if (!uniboCgrSap->feature_proactive_anti_loop) {
+        // applied by phase two/three at each call -- computed routes are still valid
         uniboCgrSap->feature_proactive_anti_loop = true;
         writeLog(uniboCgrSap, "Proactive anti-loop mechanism enabled.");
-        return UniboCGR_force_update(uniboCgr);
     }
     return UniboCGR_NoError;
 }
@@ -826,9 +1060,85 @@ UniboCGR_Error UniboCGR_feature_ProactiveAntiLoop_disable(UniboCGR uniboCgr) {
     UniboCGRSAP* uniboCgrSap = (UniboCGRSAP*) uniboCgr;
     CHECK_EQUAL_SESSION(UniboCGR_Session_feature);
     if (uniboCgrSap->feature_proactive_anti_loop) {
+        // applied by phase two/three at each call -- computed routes are still valid
         uniboCgrSap->feature_proactive_anti_loop = false;
         writeLog(uniboCgrSap, "Proactive anti-loop mechanism disabled.");
-        return UniboCGR_force_update(uniboCgr);
+    }
+    return UniboCGR_NoError;
+}
+UniboCGR_Error UniboCGR_feature_VolumeReservations_enable(UniboCGR uniboCgr) {
+    if (!uniboCgr) return UniboCGR_ErrorInvalidArgument;
+    UniboCGRSAP* uniboCgrSap = (UniboCGRSAP*) uniboCgr;
+    CHECK_EQUAL_SESSION(UniboCGR_Session_feature);
+    if (!uniboCgrSap->feature_volume_reservations) {
+        // routes do not depend on this feature -- no need to discard them
+        uniboCgrSap->feature_volume_reservations = true;
+        writeLog(uniboCgrSap, "Volume reservations enabled.");
+    }
+    return UniboCGR_NoError;
+}
+UniboCGR_Error UniboCGR_feature_VolumeReservations_disable(UniboCGR uniboCgr) {
+    if (!uniboCgr) return UniboCGR_ErrorInvalidArgument;
+    UniboCGRSAP* uniboCgrSap = (UniboCGRSAP*) uniboCgr;
+    CHECK_EQUAL_SESSION(UniboCGR_Session_feature);
+    if (uniboCgrSap->feature_volume_reservations) {
+        // pending reservations are kept: they can still be committed or released
+        uniboCgrSap->feature_volume_reservations = false;
+        writeLog(uniboCgrSap, "Volume reservations disabled.");
+    }
+    return UniboCGR_NoError;
+}
+UniboCGR_Error UniboCGR_feature_RouteCache_enable(UniboCGR uniboCgr) {
+    if (!uniboCgr) return UniboCGR_ErrorInvalidArgument;
+    UniboCGRSAP* uniboCgrSap = (UniboCGRSAP*) uniboCgr;
+    CHECK_EQUAL_SESSION(UniboCGR_Session_feature);
+    if (!uniboCgrSap->feature_route_cache) {
+        // the cache is filled by the next routing calls -- no need to discard the routes
+        uniboCgrSap->feature_route_cache = true;
+        writeLog(uniboCgrSap, "Route cache enabled.");
+    }
+    return UniboCGR_NoError;
+}
+UniboCGR_Error UniboCGR_feature_RouteCache_disable(UniboCGR uniboCgr) {
+    if (!uniboCgr) return UniboCGR_ErrorInvalidArgument;
+    UniboCGRSAP* uniboCgrSap = (UniboCGRSAP*) uniboCgr;
+    CHECK_EQUAL_SESSION(UniboCGR_Session_feature);
+    if (uniboCgrSap->feature_route_cache) {
+        // the entries are discarded by the epoch increase at feature_close
+        uniboCgrSap->feature_route_cache = false;
+        writeLog(uniboCgrSap, "Route cache disabled.");
+    }
+    return UniboCGR_NoError;
+}
+UniboCGR_Error UniboCGR_feature_ContactHorizon_enable(UniboCGR uniboCgr, time_t horizon) {
+    if (!uniboCgr || horizon <= 0) return UniboCGR_ErrorInvalidArgument;
+    UniboCGRSAP* uniboCgrSap = (UniboCGRSAP*) uniboCgr;
+    CHECK_EQUAL_SESSION(UniboCGR_Session_feature);
+    // the contacts beyond the horizon are staged by the next update
+    uniboCgrSap->contact_horizon = horizon;
+    if (!uniboCgrSap->feature_contact_horizon) {
+        uniboCgrSap->feature_contact_horizon = true;
+        writeLog(uniboCgrSap, "Contact horizon enabled: %ld s.", (long int) horizon);
+    }
+    return UniboCGR_NoError;
+}
+UniboCGR_Error UniboCGR_feature_ContactHorizon_disable(UniboCGR uniboCgr) {
+    if (!uniboCgr) return UniboCGR_ErrorInvalidArgument;
+    UniboCGRSAP* uniboCgrSap = (UniboCGRSAP*) uniboCgr;
+    CHECK_EQUAL_SESSION(UniboCGR_Session_feature);
+    if (uniboCgrSap->feature_contact_horizon) {
+        uniboCgrSap->feature_contact_horizon = false;
+        uniboCgrSap->contact_horizon = 0;
+        uniboCgrSap->contact_horizon_limit = 0;
+        // every staged contact goes back to the graph
+        int promoted = set_contacts_horizon(uniboCgrSap, MAX_POSIX_TIME);
+        if (promoted < 0) {
+            return UniboCgr_ErrorSystem;
+        } else if (promoted > 0) {
+            uniboCgrSap->mustClearRoutingObjects = true;
+            invalidate_local_node_neighbors_list(uniboCgrSap);
+        }
+        writeLog(uniboCgrSap, "Contact horizon disabled.");
     }
     return UniboCGR_NoError;
 }
@@ -869,6 +1179,27 @@ bool UniboCGR_feature_ProactiveAntiLoop_check(UniboCGR uniboCgr) {
     UniboCGRSAP* uniboCgrSap = (UniboCGRSAP*) uniboCgr;
     return uniboCgrSap->feature_proactive_anti_loop;
 }
+bool UniboCGR_feature_VolumeReservations_check(UniboCGR uniboCgr) {
+    if (!uniboCgr) return false;
+    UniboCGRSAP* uniboCgrSap = (UniboCGRSAP*) uniboCgr;
+    return uniboCgrSap->feature_volume_reservations;
+}
+bool UniboCGR_feature_RouteCache_check(UniboCGR uniboCgr) {
+    if (!uniboCgr) return false;
+    UniboCGRSAP* uniboCgrSap = (UniboCGRSAP*) uniboCgr;
+    return uniboCgrSap->feature_route_cache;
+}
+bool UniboCGR_feature_ContactHorizon_check(UniboCGR uniboCgr, time_t* horizon) {
+    if (!uniboCgr) return false;
+    UniboCGRSAP* uniboCgrSap = (UniboCGRSAP*) uniboCgr;
+    if (uniboCgrSap->feature_contact_horizon) {
+        if (horizon) {
+            *horizon = uniboCgrSap->contact_horizon;
+        }
+        return true;
+    }
+    return false;
+}
 
 /* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
  *                   UNIBO-CGR SESSION CONTACT PLAN                    *
@@ -878,6 +1209,11 @@ UniboCGR_Error UniboCGR_contact_plan_open(UniboCGR uniboCgr, time_t time) {
     if (!uniboCgr) return UniboCGR_ErrorInvalidArgument;
     UniboCGRSAP* uniboCgrSap = (UniboCGRSAP *) uniboCgr;
     CHECK_OPEN_SESSION;
+    // horizon mode: the changes are applied to the whole contact plan,
+    // it is staged again by UniboCGR_contact_plan_close()
+    if (set_contacts_horizon(uniboCgrSap, MAX_POSIX_TIME) < 0) {
+        return UniboCgr_ErrorSystem;
+    }
     uniboCgrSap->session = UniboCGR_Session_contact_plan;
     UniboCGR_set_current_time(uniboCgr, time);
     return UniboCGR_NoError;
@@ -886,9 +1222,13 @@ UniboCGR_Error UniboCGR_contact_plan_close(UniboCGR uniboCgr) {
     if (!uniboCgr) return UniboCGR_ErrorInvalidArgument;
     UniboCGRSAP* uniboCgrSap = (UniboCGRSAP *) uniboCgr;
     CHECK_EQUAL_SESSION(UniboCGR_Session_contact_plan);
-    UniboCGR_force_update(uniboCgr);
-    LogSAP_log_contact_plan(uniboCgrSap);
+    // apply the pending updates -- routes not affected by the changes are kept
+    uniboCgrSap->contact_plan_epoch++;
     uniboCgrSap->session = UniboCGR_NoSession;
+    if (UniboCGRSAP_handle_updates(uniboCgrSap) < 0) {
+        return UniboCgr_ErrorSystem;
+    }
+    LogSAP_log_contact_plan(uniboCgrSap);
     LogSAP_log_fflush(uniboCgrSap);
     return UniboCGR_NoError;
 }
@@ -957,13 +1297,20 @@ UniboCGR_Error UniboCGR_contact_plan_change_contact_start_time(UniboCGR uniboCgr
     UniboCGRSAP* uniboCgrSap = (UniboCGRSAP*) uniboCgr;
     CHECK_EQUAL_SESSION(UniboCGR_Session_contact_plan);
 
-    start_time -= uniboCgrSap->reference_time;
-    new_start_time -= uniboCgrSap->reference_time;
+    start_time -= uniboCgrSap->time_base;
+    new_start_time -= uniboCgrSap->time_base;
+
+    Contact* contact = get_contact(uniboCgrSap, sender, receiver, start_time, NULL);
+    const bool widened = contact && new_start_time < contact->fromTime;
 
     int temp = revise_contact_start_time(uniboCgrSap, sender, receiver, start_time, new_start_time);
 
     if (temp == 0) {
-        uniboCgrSap->mustClearRoutingObjects = true;
+        if (widened) {
+            uniboCgrSap->mustClearRoutingObjects = true;
+        } else {
+            UniboCGR_discard_contact_routes(uniboCgrSap, contact);
+        }
         return UniboCGR_NoError;
     } else if (temp == -1) {
         return UniboCGR_ErrorContactNotFound;
@@ -987,8 +1334,8 @@ UniboCGR_Error UniboCGR_contact_plan_change_contact_end_time(UniboCGR uniboCgr,
     UniboCGRSAP* uniboCgrSap = (UniboCGRSAP*) uniboCgr;
     CHECK_EQUAL_SESSION(UniboCGR_Session_contact_plan);
 
-    start_time -= uniboCgrSap->reference_time;
-    new_end_time -= uniboCgrSap->reference_time;
+    start_time -= uniboCgrSap->time_base;
+    new_end_time -= uniboCgrSap->time_base;
 
     if (new_end_time <= uniboCgrSap->current_time) {
         UniboCGR_log_write(uniboCgr, "remove end time");
@@ -996,14 +1343,24 @@ UniboCGR_Error UniboCGR_contact_plan_change_contact_end_time(UniboCGR uniboCgr,
                                   start_time,
                                   sender,
                                   receiver);
+        if (sender == uniboCgrSap->localNode) {
+            invalidate_local_node_neighbors_list(uniboCgrSap);
+        }
         return UniboCGR_NoError;
     }
 
     UniboCGR_log_write(uniboCgr, "revise end time");
+    Contact* contact = get_contact(uniboCgrSap, sender, receiver, start_time, NULL);
+    const bool widened = contact && new_end_time > contact->toTime;
+
     int temp = revise_contact_end_time(uniboCgrSap, sender, receiver, start_time, new_end_time);
 
     if (temp == 0) {
-        uniboCgrSap->mustClearRoutingObjects = true;
+        if (widened) {
+            uniboCgrSap->mustClearRoutingObjects = true;
+        } else {
+            UniboCGR_discard_contact_routes(uniboCgrSap, contact);
+        }
         return UniboCGR_NoError;
     } else if (temp == -1) {
         return UniboCGR_ErrorContactNotFound;
@@ -1026,7 +1383,7 @@ UniboCGR_Error UniboCGR_contact_plan_change_contact_type(UniboCGR uniboCgr,
     UniboCGRSAP* uniboCgrSap = (UniboCGRSAP*) uniboCgr;
     CHECK_EQUAL_SESSION(UniboCGR_Session_contact_plan);
 
-    start_time -= uniboCgrSap->reference_time;
+    start_time -= uniboCgrSap->time_base;
     (void) contact_type;
     (void) sender;
     (void) receiver;
@@ -1054,7 +1411,10 @@ UniboCGR_Error UniboCGR_contact_plan_change_contact_confidence(UniboCGR uniboCgr
     UniboCGRSAP* uniboCgrSap = (UniboCGRSAP*) uniboCgr;
     CHECK_EQUAL_SESSION(UniboCGR_Session_contact_plan);
 
-    start_time -= uniboCgrSap->reference_time;
+    start_time -= uniboCgrSap->time_base;
+
+    Contact* contact = get_contact(uniboCgrSap, sender, receiver, start_time, NULL);
+    const bool widened = contact && new_confidence > contact->confidence;
 
     int retval = revise_confidence(uniboCgrSap,
                                    sender,
@@ -1063,7 +1423,11 @@ UniboCGR_Error UniboCGR_contact_plan_change_contact_confidence(UniboCGR uniboCgr
                                    new_confidence);
 
     if (retval == 0) {
-        uniboCgrSap->mustClearRoutingObjects = true;
+        if (widened) {
+            uniboCgrSap->mustClearRoutingObjects = true;
+        } else {
+            UniboCGR_discard_contact_routes(uniboCgrSap, contact);
+        }
         return UniboCGR_NoError;
     } else if (retval == -1) {
         return UniboCGR_ErrorContactNotFound;
@@ -1084,9 +1448,12 @@ UniboCGR_Error UniboCGR_contact_plan_change_contact_xmit_rate(UniboCGR uniboCgr,
     UniboCGRSAP* uniboCgrSap = (UniboCGRSAP*) uniboCgr;
     CHECK_EQUAL_SESSION(UniboCGR_Session_contact_plan);
 
-    start_time -= uniboCgrSap->reference_time;
+    start_time -= uniboCgrSap->time_base;
     // TODO QUA MANCA IL TIPO DEL CONTATTO
     (void) contact_type;
+    Contact* contact = get_contact(uniboCgrSap, sender, receiver, start_time, NULL);
+    const bool widened = contact && new_xmit_rate > contact->xmitRate;
+
     int retval = revise_xmit_rate(uniboCgrSap,
                                   sender,
                                   receiver,
@@ -1094,7 +1461,11 @@ UniboCGR_Error UniboCGR_contact_plan_change_contact_xmit_rate(UniboCGR uniboCgr,
                                   new_xmit_rate);
 
     if (retval == 0) {
-        uniboCgrSap->mustClearRoutingObjects = true;
+        if (widened) {
+            uniboCgrSap->mustClearRoutingObjects = true;
+        } else {
+            UniboCGR_discard_contact_routes(uniboCgrSap, contact);
+        }
         return UniboCGR_NoError;
     } else if (retval == -1) {
         return UniboCGR_ErrorContactNotFound;
@@ -1116,14 +1487,17 @@ UniboCGR_Error UniboCGR_contact_plan_remove_contact(UniboCGR uniboCgr,
 
     UniboCGR_log_write(uniboCgr, "Before contact remove 2");
 
-    start_time -= uniboCgrSap->reference_time;
+    start_time -= uniboCgrSap->time_base;
 
+    // the routes of the destinations reached through the contact are deleted along with it
     remove_contact_from_graph(uniboCgrSap,
                               start_time,
                               sender,
                               receiver);
 
-    uniboCgrSap->mustClearRoutingObjects = true;
+    if (sender == uniboCgrSap->localNode) {
+        invalidate_local_node_neighbors_list(uniboCgrSap);
+    }
     return UniboCGR_NoError;
 }
 UniboCGR_Error UniboCGR_contact_plan_add_range(UniboCGR uniboCgr,
@@ -1157,114 +1531,1619 @@ UniboCGR_Error UniboCGR_contact_plan_add_range(UniboCGR uniboCgr,
 
     return UniboCGR_ErrorUnknown;
 }
-UniboCGR_Error UniboCGR_contact_plan_change_range_start_time(UniboCGR uniboCgr,
-                                                             uint64_t sender,
-                                                             uint64_t receiver,
-                                                             time_t start_time,
-                                                             time_t new_start_time) {
-    if (!uniboCgr) { return UniboCGR_ErrorInvalidArgument; }
-    UniboCGRSAP* uniboCgrSap = (UniboCGRSAP*) uniboCgr;
-    CHECK_EQUAL_SESSION(UniboCGR_Session_contact_plan);
+/*
+ * Bulk insertion into the contacts graph currently set in the SAP (the contact plan or its shadow).
+ * *added is set to true if at least one contact has been inserted.
+ */
+static UniboCGR_Error add_flat_contacts_to_graph(UniboCGRSAP* uniboCgrSap,
+                                                 const UniboCGR_FlatContact* contacts,
+                                                 uint32_t count,
+                                                 bool copy_mtv,
+                                                 bool* added_any) {
+    *added_any = false;
+
+    // same arguments check of add_contact_to_graph()
+    for (uint32_t i = 0; i < count; i++) {
+        const UniboCGR_FlatContact* flat = &contacts[i];
+        if (flat->sender == 0 || flat->receiver == 0
+            || flat->start_time < uniboCgrSap->time_base
+            || flat->start_time > flat->end_time
+            || flat->confidence < 0.0 || flat->confidence > 1.0) {
+            return UniboCGR_ErrorInvalidArgument;
+        }
+    }
 
-    start_time -= uniboCgrSap->reference_time;
-    new_start_time -= uniboCgrSap->reference_time;
+    Contact** array = MWITHDRAW(sizeof(Contact*) * (count > 0 ? count : 1));
+    if (!array) { return UniboCgr_ErrorSystem; }
 
-    int temp = revise_range_start_time(uniboCgrSap, sender, receiver, start_time, new_start_time);
+    uint32_t added = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        const UniboCGR_FlatContact* flat = &contacts[i];
+        const time_t toTime = flat->end_time - uniboCgrSap->time_base;
+        if (toTime <= uniboCgrSap->current_time) {
+            continue; // already expired
+        }
+        Contact* contact = create_contact(uniboCgrSap, flat->sender,
+                                          flat->receiver,
+                                          flat->start_time - uniboCgrSap->time_base,
+                                          toTime,
+                                          flat->xmit_rate,
+                                          flat->confidence,
+                                          TypeScheduled);
+        if (!contact) {
+            for (uint32_t j = 0; j < added; j++) {
+                free_contact(array[j]);
+            }
+            MDEPOSIT(array);
+            return UniboCgr_ErrorSystem;
+        }
+        if (copy_mtv) {
+            for (int priority = 0; priority < 3; priority++) {
+                contact->mtv[priority] = convert_volume_to_mtv(flat->mtv[priority]);
+            }
+        }
+        array[added++] = contact;
+    }
 
-    if (temp == 0) {
-        uniboCgrSap->mustClearRoutingObjects = true;
+    // consumes the contacts
+    int retval = add_contacts_to_graph_bulk(uniboCgrSap, array, added);
+    MDEPOSIT(array);
+
+    if (retval > 0) {
+        *added_any = true;
         return UniboCGR_NoError;
-    } else if (temp == -1) {
-        return UniboCGR_ErrorRangeNotFound;
-    } else if (temp == -2) {
-        return UniboCGR_ErrorInvalidArgument;
-    } else if (temp == -3) {
-        return UniboCGR_ErrorFoundOverlappingRange;
+    } else if (retval == 0) {
+        return UniboCGR_NoError;
+    } else if (retval == -1) {
+        return UniboCGR_ErrorFoundOverlappingContact;
+    } else if (retval == -2) {
+        return UniboCgr_ErrorSystem;
     }
 
     return UniboCGR_ErrorUnknown;
 }
-
-UniboCGR_Error UniboCGR_contact_plan_change_range_end_time(UniboCGR uniboCgr,
-                                                           uint64_t sender,
-                                                           uint64_t receiver,
-                                                           time_t start_time,
-                                                           time_t new_end_time) {
-    if (!uniboCgr) { return UniboCGR_ErrorInvalidArgument; }
+UniboCGR_Error UniboCGR_contact_plan_add_contacts_bulk(UniboCGR uniboCgr,
+                                                       const UniboCGR_FlatContact* contacts,
+                                                       uint32_t count,
+                                                       bool copy_mtv) {
+    if (!uniboCgr || (!contacts && count > 0)) { return UniboCGR_ErrorInvalidArgument; }
     UniboCGRSAP* uniboCgrSap = (UniboCGRSAP*) uniboCgr;
     CHECK_EQUAL_SESSION(UniboCGR_Session_contact_plan);
 
-    start_time -= uniboCgrSap->reference_time;
-    new_end_time -= uniboCgrSap->reference_time;
-
-    if (new_end_time <= uniboCgrSap->current_time) {
-        remove_range_from_graph(uniboCgrSap,
-                                start_time,
-                                sender,
-                                receiver);
-        return UniboCGR_NoError;
-    }
-
-    int temp = revise_range_end_time(uniboCgrSap, sender, receiver, start_time, new_end_time);
-
-    if (temp == 0) {
+    bool added = false;
+    UniboCGR_Error error = add_flat_contacts_to_graph(uniboCgrSap, contacts, count, copy_mtv, &added);
+    if (added) {
         uniboCgrSap->mustClearRoutingObjects = true;
-        return UniboCGR_NoError;
-    } else if (temp == -1) {
-        return UniboCGR_ErrorRangeNotFound;
-    } else if (temp == -2) {
-        return UniboCGR_ErrorInvalidArgument;
-    } else if (temp == -3) {
-        return UniboCGR_ErrorFoundOverlappingRange;
     }
-
-    return UniboCGR_ErrorUnknown;
+    return error;
 }
-UniboCGR_Error UniboCGR_contact_plan_change_range_one_way_light_time(UniboCGR uniboCgr,
-                                                                     uint64_t sender,
-                                                                     uint64_t receiver,
-                                                                     time_t start_time,
-                                                                     uint64_t new_owlt) {
-    if (!uniboCgr) { return UniboCGR_ErrorInvalidArgument; }
-    UniboCGRSAP* uniboCgrSap = (UniboCGRSAP*) uniboCgr;
-    CHECK_EQUAL_SESSION(UniboCGR_Session_contact_plan);
+/*
+ * Bulk insertion into the ranges graph currently set in the SAP (the contact plan or its shadow).
+ * *added is set to true if at least one range has been inserted.
+ */
+static UniboCGR_Error add_flat_ranges_to_graph(UniboCGRSAP* uniboCgrSap,
+                                               const UniboCGR_FlatRange* ranges,
+                                               uint32_t count,
+                                               bool* added_any) {
+    *added_any = false;
+
+    Range** array = MWITHDRAW(sizeof(Range*) * (count > 0 ? count : 1));
+    if (!array) { return UniboCgr_ErrorSystem; }
+
+    uint32_t added = 0;
+    UniboCGR_Error error = UniboCGR_NoError;
+    for (uint32_t i = 0; i < count && error == UniboCGR_NoError; i++) {
+        const UniboCGR_FlatRange* flat = &ranges[i];
+        const time_t fromTime = flat->start_time - uniboCgrSap->time_base;
+        time_t toTime = flat->end_time - uniboCgrSap->time_base;
+        if (toTime <= uniboCgrSap->current_time) {
+            continue; // already expired
+        }
+        if (toTime == 0) {
+            toTime = MAX_POSIX_TIME; // same as add_range_to_graph()
+        }
+        if (toTime < fromTime || fromTime < 0 || flat->sender == 0 || flat->receiver == 0) {
+            error = UniboCGR_ErrorInvalidArgument;
+            continue;
+        }
+        Range* range = create_range(flat->sender, flat->receiver, fromTime, toTime, flat->one_way_light_time);
+        if (!range) {
+            error = UniboCgr_ErrorSystem;
+            continue;
+        }
+        array[added++] = range;
+    }
 
-    start_time -= uniboCgrSap->reference_time;
+    if (error != UniboCGR_NoError) {
+        for (uint32_t j = 0; j < added; j++) {
+            free_range(array[j]);
+        }
+        MDEPOSIT(array);
+        return error;
+    }
 
-    int retval = revise_owlt(uniboCgrSap,
-                             sender,
-                             receiver,
-                             start_time,
-                             new_owlt);
+    // consumes the ranges
+    int retval = add_ranges_to_graph_bulk(uniboCgrSap, array, added);
+    MDEPOSIT(array);
 
-    if (retval == 0) {
-        uniboCgrSap->mustClearRoutingObjects = true;
+    if (retval > 0) {
+        *added_any = true;
+        return UniboCGR_NoError;
+    } else if (retval == 0) {
         return UniboCGR_NoError;
     } else if (retval == -1) {
-        return UniboCGR_ErrorRangeNotFound;
+        return UniboCGR_ErrorFoundOverlappingRange;
     } else if (retval == -2) {
         return UniboCgr_ErrorSystem;
     }
 
     return UniboCGR_ErrorUnknown;
 }
-UniboCGR_Error UniboCGR_contact_plan_remove_range(UniboCGR uniboCgr,
-                                                  uint64_t sender,
-                                                  uint64_t receiver,
-                                                  time_t start_time) {
-    if (!uniboCgr) { return UniboCGR_ErrorInvalidArgument; }
+UniboCGR_Error UniboCGR_contact_plan_add_ranges_bulk(UniboCGR uniboCgr,
+                                                     const UniboCGR_FlatRange* ranges,
+                                                     uint32_t count) {
+    if (!uniboCgr || (!ranges && count > 0)) { return UniboCGR_ErrorInvalidArgument; }
     UniboCGRSAP* uniboCgrSap = (UniboCGRSAP*) uniboCgr;
     CHECK_EQUAL_SESSION(UniboCGR_Session_contact_plan);
 
-    start_time -= uniboCgrSap->reference_time;
-
-    remove_range_from_graph(uniboCgrSap,
-                            start_time,
-                            sender,
-                            receiver);
-
-    uniboCgrSap->mustClearRoutingObjects = true;
-    return UniboCGR_NoError;
+    bool added = false;
+    UniboCGR_Error error = add_flat_ranges_to_graph(uniboCgrSap, ranges, count, &added);
+    if (added) {
+        uniboCgrSap->mustClearRoutingObjects = true;
+    }
+    return error;
+}
+UniboCGR_Error UniboCGR_contact_plan_write_binary(const char* filename,
+                                                  const UniboCGR_FlatContact* contacts,
+                                                  uint32_t contacts_count,
+                                                  const UniboCGR_FlatRange* ranges,
+                                                  uint32_t ranges_count,
+                                                  bool with_adjacency) {
+    if (!filename || (!contacts && contacts_count > 0) || (!ranges && ranges_count > 0)) {
+        return UniboCGR_ErrorInvalidArgument;
+    }
+
+    BinaryPlanContact* binaryContacts = MWITHDRAW(sizeof(BinaryPlanContact) * (contacts_count > 0 ? contacts_count : 1));
+    BinaryPlanRange* binaryRanges = MWITHDRAW(sizeof(BinaryPlanRange) * (ranges_count > 0 ? ranges_count : 1));
+    if (!binaryContacts || !binaryRanges) {
+        if (binaryContacts) MDEPOSIT(binaryContacts);
+        if (binaryRanges) MDEPOSIT(binaryRanges);
+        return UniboCgr_ErrorSystem;
+    }
+
+    for (uint32_t i = 0; i < contacts_count; i++) {
+        BinaryPlanContact* record = &binaryContacts[i];
+        memset(record, 0, sizeof(BinaryPlanContact));
+        record->fromNode = contacts[i].sender;
+        record->toNode = contacts[i].receiver;
+        record->fromTime = (int64_t) contacts[i].start_time;
+        record->toTime = (int64_t) contacts[i].end_time;
+        record->xmitRate = contacts[i].xmit_rate;
+        record->confidence = contacts[i].confidence;
+        for (int priority = 0; priority < 3; priority++) {
+            record->mtv[priority] = contacts[i].mtv[priority];
+        }
+    }
+    for (uint32_t i = 0; i < ranges_count; i++) {
+        BinaryPlanRange* record = &binaryRanges[i];
+        record->fromNode = ranges[i].sender;
+        record->toNode = ranges[i].receiver;
+        record->fromTime = (int64_t) ranges[i].start_time;
+        record->toTime = (int64_t) ranges[i].end_time;
+        record->owlt = ranges[i].one_way_light_time;
+    }
+
+    int result = binary_plan_write(filename, binaryContacts, contacts_count, binaryRanges, ranges_count, with_adjacency ? 1 : 0);
+    MDEPOSIT(binaryContacts);
+    MDEPOSIT(binaryRanges);
+
+    return (result == 0) ? UniboCGR_NoError : UniboCGR_ErrorCannotOpenFile;
+}
+/*
+ * Undo add_flat_contacts_to_graph(): remove the contacts just added
+ * (the ones already expired have not been added).
+ */
+static void remove_flat_contacts_from_graph(UniboCGRSAP* uniboCgrSap,
+                                            const UniboCGR_FlatContact* contacts,
+                                            uint32_t count) {
+    bool localNeighborsChanged = false;
+    for (uint32_t i = 0; i < count; i++) {
+        const UniboCGR_FlatContact* flat = &contacts[i];
+        if (flat->end_time - uniboCgrSap->time_base <= uniboCgrSap->current_time) {
+            continue;
+        }
+        remove_contact_from_graph(uniboCgrSap, flat->start_time - uniboCgrSap->time_base, flat->sender, flat->receiver);
+        if (flat->sender == uniboCgrSap->localNode) {
+            localNeighborsChanged = true;
+        }
+    }
+    if (localNeighborsChanged) {
+        invalidate_local_node_neighbors_list(uniboCgrSap);
+    }
+}
+// times of the records are relative to time_offset; all the records are loaded, or none
+static UniboCGR_Error load_plan_records(UniboCGR uniboCgr,
+                                        const BinaryPlanContact* records_contacts,
+                                        uint64_t contactsCount,
+                                        const BinaryPlanRange* records_ranges,
+                                        uint64_t rangesCount,
+                                        time_t time_offset,
+                                        bool copy_mtv) {
+    if (contactsCount > UINT32_MAX || rangesCount > UINT32_MAX) {
+        return UniboCGR_ErrorMalformedFile;
+    }
+
+    UniboCGR_FlatContact* contacts = MWITHDRAW(sizeof(UniboCGR_FlatContact) * (contactsCount > 0 ? contactsCount : 1));
+    UniboCGR_FlatRange* ranges = MWITHDRAW(sizeof(UniboCGR_FlatRange) * (rangesCount > 0 ? rangesCount : 1));
+    if (!contacts || !ranges) {
+        if (contacts) MDEPOSIT(contacts);
+        if (ranges) MDEPOSIT(ranges);
+        return UniboCgr_ErrorSystem;
+    }
+
+    for (uint64_t i = 0; i < contactsCount; i++) {
+        const BinaryPlanContact* record = &records_contacts[i];
+        UniboCGR_FlatContact* flat = &contacts[i];
+        flat->sender = record->fromNode;
+        flat->receiver = record->toNode;
+        flat->start_time = (time_t) record->fromTime + time_offset;
+        flat->end_time = (time_t) record->toTime + time_offset;
+        flat->xmit_rate = record->xmitRate;
+        flat->confidence = record->confidence;
+        for (int priority = 0; priority < 3; priority++) {
+            flat->mtv[priority] = record->mtv[priority];
+        }
+    }
+    for (uint64_t i = 0; i < rangesCount; i++) {
+        const BinaryPlanRange* record = &records_ranges[i];
+        UniboCGR_FlatRange* flat = &ranges[i];
+        flat->sender = record->fromNode;
+        flat->receiver = record->toNode;
+        flat->start_time = (time_t) record->fromTime + time_offset;
+        flat->end_time = (time_t) record->toTime + time_offset;
+        flat->one_way_light_time = record->owlt;
+    }
+
+    UniboCGR_Error error = UniboCGR_contact_plan_add_contacts_bulk(uniboCgr, contacts, (uint32_t) contactsCount, copy_mtv);
+    if (error == UniboCGR_NoError) {
+        error = UniboCGR_contact_plan_add_ranges_bulk(uniboCgr, ranges, (uint32_t) rangesCount);
+        if (error != UniboCGR_NoError) {
+            // all or nothing: the contacts just added go away (the bulk functions add nothing on failure)
+            remove_flat_contacts_from_graph((UniboCGRSAP*) uniboCgr, contacts, (uint32_t) contactsCount);
+        }
+    }
+
+    MDEPOSIT(contacts);
+    MDEPOSIT(ranges);
+
+    return error;
+}
+UniboCGR_Error UniboCGR_contact_plan_load_binary(UniboCGR uniboCgr,
+                                                 const char* filename,
+                                                 time_t time_offset,
+                                                 bool copy_mtv) {
+    if (!uniboCgr || !filename) { return UniboCGR_ErrorInvalidArgument; }
+    UniboCGRSAP* uniboCgrSap = (UniboCGRSAP*) uniboCgr;
+    CHECK_EQUAL_SESSION(UniboCGR_Session_contact_plan);
+
+    BinaryPlan plan;
+    int result = binary_plan_map(filename, &plan);
+    if (result == -1) {
+        return UniboCGR_ErrorCannotOpenFile;
+    } else if (result < 0) {
+        return UniboCGR_ErrorMalformedFile;
+    }
+
+    UniboCGR_Error error = load_plan_records(uniboCgr,
+                                             plan.contacts, plan.header->contactsCount,
+                                             plan.ranges, plan.header->rangesCount,
+                                             time_offset, copy_mtv);
+    binary_plan_unmap(&plan);
+
+    return error;
+}
+static UniboCGR_Error parse_text_plan(const char* filename, time_t time_offset, uint32_t threads, TextPlan* plan, uint64_t* error_line) {
+    uint64_t errorLine = 0;
+    int result = text_plan_parse(filename, time_offset, threads, plan, &errorLine);
+    if (error_line) {
+        *error_line = errorLine;
+    }
+    if (result == -1) {
+        return UniboCGR_ErrorCannotOpenFile;
+    } else if (result == -2) {
+        return UniboCgr_ErrorSystem;
+    } else if (result < 0) {
+        return UniboCGR_ErrorMalformedFile;
+    }
+    return UniboCGR_NoError;
+}
+UniboCGR_Error UniboCGR_contact_plan_load_text(UniboCGR uniboCgr,
+                                               const char* filename,
+                                               time_t time_offset,
+                                               bool copy_mtv,
+                                               uint32_t threads,
+                                               uint64_t* error_line) {
+    if (!uniboCgr || !filename) { return UniboCGR_ErrorInvalidArgument; }
+    UniboCGRSAP* uniboCgrSap = (UniboCGRSAP*) uniboCgr;
+    CHECK_EQUAL_SESSION(UniboCGR_Session_contact_plan);
+
+    TextPlan plan;
+    UniboCGR_Error error = parse_text_plan(filename, time_offset, threads, &plan, error_line);
+    if (error != UniboCGR_NoError) {
+        return error;
+    }
+
+    error = load_plan_records(uniboCgr,
+                              plan.contacts, plan.contactsCount,
+                              plan.ranges, plan.rangesCount,
+                              time_offset, copy_mtv);
+    text_plan_destroy(&plan);
+
+    return error;
+}
+UniboCGR_Error UniboCGR_contact_plan_convert_text_to_binary(const char* text_filename,
+                                                            const char* binary_filename,
+                                                            time_t time_offset,
+                                                            uint32_t threads,
+                                                            uint64_t* error_line) {
+    if (!text_filename || !binary_filename) { return UniboCGR_ErrorInvalidArgument; }
+
+    TextPlan plan;
+    UniboCGR_Error error = parse_text_plan(text_filename, time_offset, threads, &plan, error_line);
+    if (error != UniboCGR_NoError) {
+        return error;
+    }
+
+    int result = binary_plan_write(binary_filename, plan.contacts, plan.contactsCount, plan.ranges, plan.rangesCount, 1);
+    text_plan_destroy(&plan);
+
+    return (result == 0) ? UniboCGR_NoError : UniboCGR_ErrorCannotOpenFile;
+}
+UniboCGR_Error UniboCGR_snapshot_save(UniboCGR uniboCgr, const char* filename) {
+    if (!uniboCgr || !filename) { return UniboCGR_ErrorInvalidArgument; }
+    UniboCGRSAP* uniboCgrSap = (UniboCGRSAP*) uniboCgr;
+    CHECK_OPEN_SESSION;
+
+    // the routes computed before the last contact plan changes are not saved
+    if (UniboCGRSAP_handle_updates(uniboCgrSap) < 0) {
+        return UniboCgr_ErrorSystem;
+    }
+    // horizon mode: the whole contact plan is saved, it is staged again by the next update
+    if (set_contacts_horizon(uniboCgrSap, MAX_POSIX_TIME) < 0) {
+        return UniboCgr_ErrorSystem;
+    }
+
+    int result = snapshot_write(uniboCgrSap, filename);
+    if (result == -2) {
+        return UniboCgr_ErrorSystem;
+    } else if (result < 0) {
+        return UniboCGR_ErrorCannotOpenFile;
+    }
+
+    writeLog(uniboCgrSap, "Snapshot saved: %s.", filename);
+
+    return UniboCGR_NoError;
+}
+UniboCGR_Error UniboCGR_snapshot_load(UniboCGR uniboCgr, const char* filename, uint32_t* restored_routes) {
+    if (!uniboCgr || !filename) { return UniboCGR_ErrorInvalidArgument; }
+    UniboCGRSAP* uniboCgrSap = (UniboCGRSAP*) uniboCgr;
+    CHECK_EQUAL_SESSION(UniboCGR_Session_contact_plan);
+
+    if (restored_routes) {
+        *restored_routes = 0;
+    }
+
+    Snapshot snapshot;
+    int result = snapshot_map(filename, &snapshot);
+    if (result == -1) {
+        return UniboCGR_ErrorCannotOpenFile;
+    } else if (result < 0) {
+        return UniboCGR_ErrorMalformedFile;
+    }
+
+    UniboCGR_Error error = UniboCGR_NoError;
+    bool loadedFromSnapshot = false;
+    if (!get_first_contact(uniboCgrSap, NULL) && !get_first_range(uniboCgrSap, NULL)) {
+        // empty contact plan: it is loaded from the snapshot
+        error = load_plan_records(uniboCgr,
+                                  snapshot.contacts, snapshot.header->contactsCount,
+                                  snapshot.ranges, snapshot.header->rangesCount,
+                                  (time_t) snapshot.header->timeBase, true);
+        loadedFromSnapshot = (error == UniboCGR_NoError);
+    }
+    if (error == UniboCGR_NoError && !snapshot_plan_matches(uniboCgrSap, &snapshot)) {
+        error = UniboCGR_ErrorSnapshotMismatch;
+    }
+    if (error == UniboCGR_NoError) {
+        // the snapshot routes replace all the routes
+        error = UniboCGR_force_update(uniboCgr);
+    }
+    if (error == UniboCGR_NoError) {
+        result = snapshot_restore(uniboCgrSap, &snapshot);
+        if (result < 0) {
+            error = UniboCgr_ErrorSystem;
+        } else {
+            if (restored_routes) {
+                *restored_routes = (uint32_t) result;
+            }
+            writeLog(uniboCgrSap, "Snapshot loaded: %s, %d routes restored.", filename, result);
+        }
+    }
+    if (error != UniboCGR_NoError && loadedFromSnapshot) {
+        // the contact plan loaded from a snapshot not restored goes away: it was empty
+        if (UniboCGR_contact_plan_reset(uniboCgr) != UniboCGR_NoError) {
+            error = UniboCgr_ErrorSystem;
+        }
+    }
+
+    snapshot_unmap(&snapshot);
+
+    return error;
+}
+UniboCGR_Error UniboCGR_ContactPlanDelta_create(UniboCGR_ContactPlanDelta* uniboCgrDelta) {
+    if (!uniboCgrDelta) { return UniboCGR_ErrorInvalidArgument; }
+    ContactPlanDelta* delta = delta_create();
+    if (!delta) {
+        return UniboCgr_ErrorSystem;
+    }
+    *uniboCgrDelta = (UniboCGR_ContactPlanDelta) delta;
+    return UniboCGR_NoError;
+}
+void UniboCGR_ContactPlanDelta_destroy(UniboCGR_ContactPlanDelta* uniboCgrDelta) {
+    if (!uniboCgrDelta) { return; }
+    delta_destroy((ContactPlanDelta*) *uniboCgrDelta);
+    *uniboCgrDelta = NULL;
+}
+void UniboCGR_ContactPlanDelta_reset(UniboCGR_ContactPlanDelta uniboCgrDelta) {
+    delta_clear((ContactPlanDelta*) uniboCgrDelta);
+}
+bool UniboCGR_ContactPlanDelta_is_empty(UniboCGR_ContactPlanDelta uniboCgrDelta) {
+    if (!uniboCgrDelta) { return true; }
+    ContactPlanDelta* delta = (ContactPlanDelta*) uniboCgrDelta;
+    return delta->contactsCount == 0 && delta->rangesCount == 0;
+}
+static UniboCGR_Error push_contact_operation(UniboCGR_ContactPlanDelta uniboCgrDelta,
+                                             DeltaOperationType type,
+                                             uint32_t fields,
+                                             const BinaryPlanContact* record) {
+    if (!uniboCgrDelta) { return UniboCGR_ErrorInvalidArgument; }
+    if (delta_push_contact((ContactPlanDelta*) uniboCgrDelta, type, fields, record) < 0) {
+        return UniboCgr_ErrorSystem;
+    }
+    return UniboCGR_NoError;
+}
+static UniboCGR_Error push_range_operation(UniboCGR_ContactPlanDelta uniboCgrDelta,
+                                           DeltaOperationType type,
+                                           uint32_t fields,
+                                           const BinaryPlanRange* record) {
+    if (!uniboCgrDelta) { return UniboCGR_ErrorInvalidArgument; }
+    if (delta_push_range((ContactPlanDelta*) uniboCgrDelta, type, fields, record) < 0) {
+        return UniboCgr_ErrorSystem;
+    }
+    return UniboCGR_NoError;
+}
+static void flat_contact_to_record(const UniboCGR_FlatContact* flat, BinaryPlanContact* record) {
+    memset(record, 0, sizeof(BinaryPlanContact));
+    record->fromNode = flat->sender;
+    record->toNode = flat->receiver;
+    record->fromTime = (int64_t) flat->start_time;
+    record->toTime = (int64_t) flat->end_time;
+    record->xmitRate = flat->xmit_rate;
+    record->confidence = flat->confidence;
+    for (int priority = 0; priority < 3; priority++) {
+        record->mtv[priority] = flat->mtv[priority];
+    }
+}
+static void flat_range_to_record(const UniboCGR_FlatRange* flat, BinaryPlanRange* record) {
+    record->fromNode = flat->sender;
+    record->toNode = flat->receiver;
+    record->fromTime = (int64_t) flat->start_time;
+    record->toTime = (int64_t) flat->end_time;
+    record->owlt = flat->one_way_light_time;
+}
+static void contact_key_to_record(uint64_t sender, uint64_t receiver, time_t start_time, BinaryPlanContact* record) {
+    memset(record, 0, sizeof(BinaryPlanContact));
+    record->fromNode = sender;
+    record->toNode = receiver;
+    record->fromTime = (int64_t) start_time;
+}
+static void range_key_to_record(uint64_t sender, uint64_t receiver, time_t start_time, BinaryPlanRange* record) {
+    memset(record, 0, sizeof(BinaryPlanRange));
+    record->fromNode = sender;
+    record->toNode = receiver;
+    record->fromTime = (int64_t) start_time;
+}
+UniboCGR_Error UniboCGR_ContactPlanDelta_add_contact(UniboCGR_ContactPlanDelta uniboCgrDelta,
+                                                     const UniboCGR_FlatContact* contact) {
+    if (!contact) { return UniboCGR_ErrorInvalidArgument; }
+    BinaryPlanContact record;
+    flat_contact_to_record(contact, &record);
+    return push_contact_operation(uniboCgrDelta, DeltaAdd, 0, &record);
+}
+UniboCGR_Error UniboCGR_ContactPlanDelta_remove_contact(UniboCGR_ContactPlanDelta uniboCgrDelta,
+                                                        uint64_t sender,
+                                                        uint64_t receiver,
+                                                        time_t start_time) {
+    BinaryPlanContact record;
+    contact_key_to_record(sender, receiver, start_time, &record);
+    return push_contact_operation(uniboCgrDelta, DeltaRemove, 0, &record);
+}
+UniboCGR_Error UniboCGR_ContactPlanDelta_change_contact_end_time(UniboCGR_ContactPlanDelta uniboCgrDelta,
+                                                                 uint64_t sender,
+                                                                 uint64_t receiver,
+                                                                 time_t start_time,
+                                                                 time_t new_end_time) {
+    BinaryPlanContact record;
+    contact_key_to_record(sender, receiver, start_time, &record);
+    record.toTime = (int64_t) new_end_time;
+    return push_contact_operation(uniboCgrDelta, DeltaChange, DELTA_END_TIME, &record);
+}
+UniboCGR_Error UniboCGR_ContactPlanDelta_change_contact_xmit_rate(UniboCGR_ContactPlanDelta uniboCgrDelta,
+                                                                  uint64_t sender,
+                                                                  uint64_t receiver,
+                                                                  time_t start_time,
+                                                                  uint64_t new_xmit_rate) {
+    BinaryPlanContact record;
+    contact_key_to_record(sender, receiver, start_time, &record);
+    record.xmitRate = new_xmit_rate;
+    return push_contact_operation(uniboCgrDelta, DeltaChange, DELTA_XMIT_RATE, &record);
+}
+UniboCGR_Error UniboCGR_ContactPlanDelta_change_contact_confidence(UniboCGR_ContactPlanDelta uniboCgrDelta,
+                                                                   uint64_t sender,
+                                                                   uint64_t receiver,
+                                                                   time_t start_time,
+                                                                   float new_confidence) {
+    BinaryPlanContact record;
+    contact_key_to_record(sender, receiver, start_time, &record);
+    record.confidence = new_confidence;
+    return push_contact_operation(uniboCgrDelta, DeltaChange, DELTA_CONFIDENCE, &record);
+}
+UniboCGR_Error UniboCGR_ContactPlanDelta_add_range(UniboCGR_ContactPlanDelta uniboCgrDelta,
+                                                   const UniboCGR_FlatRange* range) {
+    if (!range) { return UniboCGR_ErrorInvalidArgument; }
+    BinaryPlanRange record;
+    flat_range_to_record(range, &record);
+    return push_range_operation(uniboCgrDelta, DeltaAdd, 0, &record);
+}
+UniboCGR_Error UniboCGR_ContactPlanDelta_remove_range(UniboCGR_ContactPlanDelta uniboCgrDelta,
+                                                      uint64_t sender,
+                                                      uint64_t receiver,
+                                                      time_t start_time) {
+    BinaryPlanRange record;
+    range_key_to_record(sender, receiver, start_time, &record);
+    return push_range_operation(uniboCgrDelta, DeltaRemove, 0, &record);
+}
+UniboCGR_Error UniboCGR_ContactPlanDelta_change_range_end_time(UniboCGR_ContactPlanDelta uniboCgrDelta,
+                                                               uint64_t sender,
+                                                               uint64_t receiver,
+                                                               time_t start_time,
+                                                               time_t new_end_time) {
+    BinaryPlanRange record;
+    range_key_to_record(sender, receiver, start_time, &record);
+    record.toTime = (int64_t) new_end_time;
+    return push_range_operation(uniboCgrDelta, DeltaChange, DELTA_END_TIME, &record);
+}
+UniboCGR_Error UniboCGR_ContactPlanDelta_change_range_one_way_light_time(UniboCGR_ContactPlanDelta uniboCgrDelta,
+                                                                         uint64_t sender,
+                                                                         uint64_t receiver,
+                                                                         time_t start_time,
+                                                                         uint64_t new_owlt) {
+    BinaryPlanRange record;
+    range_key_to_record(sender, receiver, start_time, &record);
+    record.owlt = new_owlt;
+    return push_range_operation(uniboCgrDelta, DeltaChange, DELTA_OWLT, &record);
+}
+static int compare_flat_contacts(const void* first, const void* second) {
+    const UniboCGR_FlatContact* a = first;
+    const UniboCGR_FlatContact* b = second;
+    return delta_compare_keys(a->sender, a->receiver, (int64_t) a->start_time,
+                              b->sender, b->receiver, (int64_t) b->start_time);
+}
+static int compare_flat_ranges(const void* first, const void* second) {
+    const UniboCGR_FlatRange* a = first;
+    const UniboCGR_FlatRange* b = second;
+    return delta_compare_keys(a->sender, a->receiver, (int64_t) a->start_time,
+                              b->sender, b->receiver, (int64_t) b->start_time);
+}
+void UniboCGR_ContactPlanDelta_sort_contacts(UniboCGR_FlatContact* contacts, uint32_t count) {
+    if (contacts && count > 1) {
+        qsort(contacts, count, sizeof(UniboCGR_FlatContact), compare_flat_contacts);
+    }
+}
+void UniboCGR_ContactPlanDelta_sort_ranges(UniboCGR_FlatRange* ranges, uint32_t count) {
+    if (ranges && count > 1) {
+        qsort(ranges, count, sizeof(UniboCGR_FlatRange), compare_flat_ranges);
+    }
+}
+UniboCGR_Error UniboCGR_ContactPlanDelta_diff_contacts(UniboCGR_ContactPlanDelta uniboCgrDelta,
+                                                       const UniboCGR_FlatContact* old_contacts,
+                                                       uint32_t old_count,
+                                                       const UniboCGR_FlatContact* new_contacts,
+                                                       uint32_t new_count) {
+    if (!uniboCgrDelta || (!old_contacts && old_count > 0) || (!new_contacts && new_count > 0)) {
+        return UniboCGR_ErrorInvalidArgument;
+    }
+    // strictly increasing keys
+    for (uint32_t i = 1; i < old_count; i++) {
+        if (compare_flat_contacts(&old_contacts[i - 1], &old_contacts[i]) >= 0) return UniboCGR_ErrorInvalidArgument;
+    }
+    for (uint32_t i = 1; i < new_count; i++) {
+        if (compare_flat_contacts(&new_contacts[i - 1], &new_contacts[i]) >= 0) return UniboCGR_ErrorInvalidArgument;
+    }
+
+    ContactPlanDelta* delta = (ContactPlanDelta*) uniboCgrDelta;
+    BinaryPlanContact record;
+    uint32_t i = 0, j = 0;
+    int result = 0;
+    while (result == 0 && (i < old_count || j < new_count)) {
+        const int cmp = (i == old_count) ? 1
+                      : (j == new_count) ? -1
+                      : compare_flat_contacts(&old_contacts[i], &new_contacts[j]);
+        if (cmp < 0) {
+            contact_key_to_record(old_contacts[i].sender, old_contacts[i].receiver, old_contacts[i].start_time, &record);
+            result = delta_push_contact(delta, DeltaRemove, 0, &record);
+            i++;
+        } else if (cmp > 0) {
+            flat_contact_to_record(&new_contacts[j], &record);
+            result = delta_push_contact(delta, DeltaAdd, 0, &record);
+            j++;
+        } else {
+            const UniboCGR_FlatContact* oldContact = &old_contacts[i];
+            const UniboCGR_FlatContact* newContact = &new_contacts[j];
+            uint32_t fields = 0;
+            if (oldContact->end_time != newContact->end_time) fields |= DELTA_END_TIME;
+            if (oldContact->xmit_rate != newContact->xmit_rate) fields |= DELTA_XMIT_RATE;
+            if (oldContact->confidence != newContact->confidence) fields |= DELTA_CONFIDENCE;
+            if (fields != 0) {
+                flat_contact_to_record(newContact, &record);
+                result = delta_push_contact(delta, DeltaChange, fields, &record);
+            }
+            i++;
+            j++;
+        }
+    }
+
+    return (result == 0) ? UniboCGR_NoError : UniboCgr_ErrorSystem;
+}
+UniboCGR_Error UniboCGR_ContactPlanDelta_diff_ranges(UniboCGR_ContactPlanDelta uniboCgrDelta,
+                                                     const UniboCGR_FlatRange* old_ranges,
+                                                     uint32_t old_count,
+                                                     const UniboCGR_FlatRange* new_ranges,
+                                                     uint32_t new_count) {
+    if (!uniboCgrDelta || (!old_ranges && old_count > 0) || (!new_ranges && new_count > 0)) {
+        return UniboCGR_ErrorInvalidArgument;
+    }
+    for (uint32_t i = 1; i < old_count; i++) {
+        if (compare_flat_ranges(&old_ranges[i - 1], &old_ranges[i]) >= 0) return UniboCGR_ErrorInvalidArgument;
+    }
+    for (uint32_t i = 1; i < new_count; i++) {
+        if (compare_flat_ranges(&new_ranges[i - 1], &new_ranges[i]) >= 0) return UniboCGR_ErrorInvalidArgument;
+    }
+
+    ContactPlanDelta* delta = (ContactPlanDelta*) uniboCgrDelta;
+    BinaryPlanRange record;
+    uint32_t i = 0, j = 0;
+    int result = 0;
+    while (result == 0 && (i < old_count || j < new_count)) {
+        const int cmp = (i == old_count) ? 1
+                      : (j == new_count) ? -1
+                      : compare_flat_ranges(&old_ranges[i], &new_ranges[j]);
+        if (cmp < 0) {
+            range_key_to_record(old_ranges[i].sender, old_ranges[i].receiver, old_ranges[i].start_time, &record);
+            result = delta_push_range(delta, DeltaRemove, 0, &record);
+            i++;
+        } else if (cmp > 0) {
+            flat_range_to_record(&new_ranges[j], &record);
+            result = delta_push_range(delta, DeltaAdd, 0, &record);
+            j++;
+        } else {
+            uint32_t fields = 0;
+            if (old_ranges[i].end_time != new_ranges[j].end_time) fields |= DELTA_END_TIME;
+            if (old_ranges[i].one_way_light_time != new_ranges[j].one_way_light_time) fields |= DELTA_OWLT;
+            if (fields != 0) {
+                flat_range_to_record(&new_ranges[j], &record);
+                result = delta_push_range(delta, DeltaChange, fields, &record);
+            }
+            i++;
+            j++;
+        }
+    }
+
+    return (result == 0) ? UniboCGR_NoError : UniboCgr_ErrorSystem;
+}
+/*
+ * Contacts of a node pair in the contacts graph that the delta keeps (not removed,
+ * not ended by a revision), walked in key order along with the effects on them.
+ */
+typedef struct {
+    RbtNode* node;
+    Contact* contact; // NULL when no other contact of the node pair is kept
+    uint32_t effect;  // first effect not before the contact
+} KeptContactCursor;
+static bool delta_keeps_contact(UniboCGRSAP* uniboCgrSap,
+                                const DeltaContactEffect* effects,
+                                uint32_t last,
+                                uint32_t* effect,
+                                const Contact* contact) {
+    const time_t timeBase = uniboCgrSap->time_base;
+    while (*effect < last && (time_t) effects[*effect].record.fromTime - timeBase < contact->fromTime) {
+        (*effect)++;
+    }
+    if (*effect < last && (time_t) effects[*effect].record.fromTime - timeBase == contact->fromTime) {
+        const DeltaContactEffect* e = &effects[*effect];
+        if (e->remove) return false;
+        if ((e->fields & DELTA_END_TIME) && (time_t) e->record.toTime - timeBase <= uniboCgrSap->current_time) {
+            return false;
+        }
+    }
+    return true;
+}
+/*
+ * Move the cursor to the first kept contact that starts after fromTime.
+ */
+static Contact* delta_next_kept_contact(UniboCGRSAP* uniboCgrSap,
+                                        const DeltaContactEffect* effects,
+                                        uint32_t last,
+                                        KeptContactCursor* cursor,
+                                        time_t fromTime) {
+    const uint64_t sender = effects[0].record.fromNode;
+    const uint64_t receiver = effects[0].record.toNode;
+    Contact* contact = cursor->contact;
+    while (contact && (contact->fromTime <= fromTime || !delta_keeps_contact(uniboCgrSap, effects, last, &cursor->effect, contact))) {
+        contact = get_next_contact(&cursor->node);
+        if (contact && (contact->fromNode != sender || contact->toNode != receiver)) {
+            contact = NULL;
+        }
+    }
+    cursor->contact = contact;
+    return contact;
+}
+/*
+ * Simulate the delta on the contacts of a node pair (effects in key order, all of the same node pair):
+ * removals, then revisions, then additions, as they are applied.
+ * The operations that cannot be applied are dropped from the effects and written in the log:
+ * a change of a contact not in the contact plan, an invalid value, an end time that
+ * overlaps the next contact, an added contact that overlaps another one.
+ */
+static void filter_delta_contacts(UniboCGRSAP* uniboCgrSap,
+                                  DeltaContactEffect* effects,
+                                  uint32_t last,
+                                  bool* mustClear) {
+    const time_t timeBase = uniboCgrSap->time_base;
+    const uint64_t sender = effects[0].record.fromNode;
+    const uint64_t receiver = effects[0].record.toNode;
+    KeptContactCursor kept;
+    RbtNode* node = NULL;
+    Contact* contact = get_first_contact_from_node_to_node(uniboCgrSap, sender, receiver, &node);
+    bool hasPrevious = false;
+    time_t previousFromTime = 0;
+    time_t previousToTime = 0;
+    uint32_t i = 0;
+
+    kept.node = node;
+    kept.contact = contact;
+    kept.effect = 0;
+    if (contact && !delta_keeps_contact(uniboCgrSap, effects, last, &kept.effect, contact)) {
+        delta_next_kept_contact(uniboCgrSap, effects, last, &kept, contact->fromTime);
+    }
+
+    while (i < last || contact) {
+        const time_t effectFromTime = (i < last) ? (time_t) effects[i].record.fromTime - timeBase : 0;
+        if (contact && (i == last || contact->fromTime < effectFromTime)) {
+            // not touched by the delta
+            hasPrevious = true;
+            previousFromTime = contact->fromTime;
+            previousToTime = contact->toTime;
+        } else {
+            DeltaContactEffect* effect = &effects[i++];
+            BinaryPlanContact* record = &effect->record;
+            Contact* existing = NULL;
+            if (contact && contact->fromTime == effectFromTime) {
+                existing = contact;
+            }
+
+            if (effect->fields != 0 && !existing) {
+                writeLog(uniboCgrSap, "Delta: contact %" PRIu64 "->%" PRIu64 " (start %" PRId64 ") not found, change skipped.",
+                         record->fromNode, record->toNode, record->fromTime);
+                effect->fields = 0;
+            }
+            if (existing && !effect->remove) {
+                time_t toTime = existing->toTime;
+                bool isKept = true;
+                if (effect->fields & DELTA_END_TIME) {
+                    const time_t newToTime = (time_t) record->toTime - timeBase;
+                    Contact* next = delta_next_kept_contact(uniboCgrSap, effects, last, &kept, existing->fromTime);
+                    if (newToTime <= uniboCgrSap->current_time) {
+                        isKept = false; // removed
+                    } else if (newToTime < existing->fromTime) {
+                        writeLog(uniboCgrSap, "Delta: invalid end time of contact %" PRIu64 "->%" PRIu64 " (start %" PRId64 "), change skipped.",
+                                 record->fromNode, record->toNode, record->fromTime);
+                        effect->fields &= ~DELTA_END_TIME;
+                    } else if (next && next->fromTime < newToTime) {
+                        writeLog(uniboCgrSap, "Delta: end time of contact %" PRIu64 "->%" PRIu64 " (start %" PRId64 ") overlaps the next contact, change skipped.",
+                                 record->fromNode, record->toNode, record->fromTime);
+                        effect->fields &= ~DELTA_END_TIME;
+                    } else {
+                        if (newToTime > existing->toTime) *mustClear = true;
+                        toTime = newToTime;
+                    }
+                }
+                if (effect->fields & DELTA_CONFIDENCE) {
+                    if (record->confidence < 0.0 || record->confidence > 1.0) {
+                        writeLog(uniboCgrSap, "Delta: invalid confidence of contact %" PRIu64 "->%" PRIu64 " (start %" PRId64 "), change skipped.",
+                                 record->fromNode, record->toNode, record->fromTime);
+                        effect->fields &= ~DELTA_CONFIDENCE;
+                    } else if (record->confidence > existing->confidence) {
+                        *mustClear = true;
+                    }
+                }
+                if ((effect->fields & DELTA_XMIT_RATE) && record->xmitRate > existing->xmitRate) {
+                    *mustClear = true;
+                }
+                if (isKept) {
+                    hasPrevious = true;
+                    previousFromTime = existing->fromTime;
+                    previousToTime = toTime;
+                }
+            }
+            if (effect->add && (time_t) record->toTime - timeBase > uniboCgrSap->current_time) {
+                const time_t fromTime = (time_t) record->fromTime - timeBase;
+                const time_t toTime = (time_t) record->toTime - timeBase;
+                Contact* next = delta_next_kept_contact(uniboCgrSap, effects, last, &kept, fromTime);
+                // same arguments check of UniboCGR_contact_plan_add_contacts_bulk()
+                if (record->fromNode == 0 || record->toNode == 0
+                    || fromTime < 0 || fromTime > toTime
+                    || record->confidence < 0.0 || record->confidence > 1.0) {
+                    writeLog(uniboCgrSap, "Delta: invalid contact %" PRIu64 "->%" PRIu64 " (start %" PRId64 "), not added.",
+                             record->fromNode, record->toNode, record->fromTime);
+                    effect->add = 0;
+                } else if ((hasPrevious && (previousFromTime == fromTime || previousToTime > fromTime))
+                           || (next && next->fromTime < toTime)) {
+                    writeLog(uniboCgrSap, "Delta: contact %" PRIu64 "->%" PRIu64 " (start %" PRId64 ") overlaps another contact, not added.",
+                             record->fromNode, record->toNode, record->fromTime);
+                    effect->add = 0;
+                } else {
+                    *mustClear = true;
+                    hasPrevious = true;
+                    previousFromTime = fromTime;
+                    previousToTime = toTime;
+                }
+            }
+            if (!existing) {
+                continue;
+            }
+        }
+        contact = get_next_contact(&node);
+        if (contact && (contact->fromNode != sender || contact->toNode != receiver)) {
+            contact = NULL;
+        }
+    }
+}
+/*
+ * Ranges of a node pair that the delta keeps (see KeptContactCursor).
+ */
+typedef struct {
+    RbtNode* node;
+    Range* range; // NULL when no other range of the node pair is kept
+    uint32_t effect;
+} KeptRangeCursor;
+static bool delta_keeps_range(UniboCGRSAP* uniboCgrSap,
+                              const DeltaRangeEffect* effects,
+                              uint32_t last,
+                              uint32_t* effect,
+                              const Range* range) {
+    const time_t timeBase = uniboCgrSap->time_base;
+    while (*effect < last && (time_t) effects[*effect].record.fromTime - timeBase < range->fromTime) {
+        (*effect)++;
+    }
+    if (*effect < last && (time_t) effects[*effect].record.fromTime - timeBase == range->fromTime) {
+        const DeltaRangeEffect* e = &effects[*effect];
+        if (e->remove) return false;
+        if ((e->fields & DELTA_END_TIME) && (time_t) e->record.toTime - timeBase <= uniboCgrSap->current_time) {
+            return false;
+        }
+    }
+    return true;
+}
+static Range* delta_next_kept_range(UniboCGRSAP* uniboCgrSap,
+                                    const DeltaRangeEffect* effects,
+                                    uint32_t last,
+                                    KeptRangeCursor* cursor,
+                                    time_t fromTime) {
+    const uint64_t sender = effects[0].record.fromNode;
+    const uint64_t receiver = effects[0].record.toNode;
+    Range* range = cursor->range;
+    while (range && (range->fromTime <= fromTime || !delta_keeps_range(uniboCgrSap, effects, last, &cursor->effect, range))) {
+        range = get_next_range(&cursor->node);
+        if (range && (range->fromNode != sender || range->toNode != receiver)) {
+            range = NULL;
+        }
+    }
+    cursor->range = range;
+    return range;
+}
+/*
+ * Same as filter_delta_contacts(), for the ranges of a node pair.
+ */
+static void filter_delta_ranges(UniboCGRSAP* uniboCgrSap,
+                                DeltaRangeEffect* effects,
+                                uint32_t last,
+                                bool* mustClear) {
+    const time_t timeBase = uniboCgrSap->time_base;
+    const uint64_t sender = effects[0].record.fromNode;
+    const uint64_t receiver = effects[0].record.toNode;
+    KeptRangeCursor kept;
+    RbtNode* node = NULL;
+    Range* range = get_first_range_from_node_to_node(uniboCgrSap, sender, receiver, &node);
+    bool hasPrevious = false;
+    time_t previousFromTime = 0;
+    time_t previousToTime = 0;
+    uint32_t i = 0;
+
+    kept.node = node;
+    kept.range = range;
+    kept.effect = 0;
+    if (range && !delta_keeps_range(uniboCgrSap, effects, last, &kept.effect, range)) {
+        delta_next_kept_range(uniboCgrSap, effects, last, &kept, range->fromTime);
+    }
+
+    while (i < last || range) {
+        const time_t effectFromTime = (i < last) ? (time_t) effects[i].record.fromTime - timeBase : 0;
+        if (range && (i == last || range->fromTime < effectFromTime)) {
+            // not touched by the delta
+            hasPrevious = true;
+            previousFromTime = range->fromTime;
+            previousToTime = range->toTime;
+        } else {
+            DeltaRangeEffect* effect = &effects[i++];
+            BinaryPlanRange* record = &effect->record;
+            Range* existing = NULL;
+            if (range && range->fromTime == effectFromTime) {
+                existing = range;
+            }
+
+            if (effect->fields != 0 && !existing) {
+                writeLog(uniboCgrSap, "Delta: range %" PRIu64 "->%" PRIu64 " (start %" PRId64 ") not found, change skipped.",
+                         record->fromNode, record->toNode, record->fromTime);
+                effect->fields = 0;
+            }
+            if (existing && !effect->remove) {
+                time_t toTime = existing->toTime;
+                bool isKept = true;
+                if (effect->fields & DELTA_END_TIME) {
+                    const time_t newToTime = (time_t) record->toTime - timeBase;
+                    Range* next = delta_next_kept_range(uniboCgrSap, effects, last, &kept, existing->fromTime);
+                    if (newToTime <= uniboCgrSap->current_time) {
+                        isKept = false; // removed
+                    } else if (newToTime < existing->fromTime) {
+                        writeLog(uniboCgrSap, "Delta: invalid end time of range %" PRIu64 "->%" PRIu64 " (start %" PRId64 "), change skipped.",
+                                 record->fromNode, record->toNode, record->fromTime);
+                        effect->fields &= ~DELTA_END_TIME;
+                    } else if (next && next->fromTime < newToTime) {
+                        writeLog(uniboCgrSap, "Delta: end time of range %" PRIu64 "->%" PRIu64 " (start %" PRId64 ") overlaps the next range, change skipped.",
+                                 record->fromNode, record->toNode, record->fromTime);
+                        effect->fields &= ~DELTA_END_TIME;
+                    } else {
+                        if (newToTime > existing->toTime) *mustClear = true;
+                        toTime = newToTime;
+                    }
+                }
+                if ((effect->fields & DELTA_OWLT) && record->owlt < existing->owlt) {
+                    *mustClear = true;
+                }
+                if (isKept) {
+                    hasPrevious = true;
+                    previousFromTime = existing->fromTime;
+                    previousToTime = toTime;
+                }
+            }
+            if (effect->add && (time_t) record->toTime - timeBase > uniboCgrSap->current_time) {
+                const time_t fromTime = (time_t) record->fromTime - timeBase;
+                const time_t toTime = (time_t) record->toTime - timeBase;
+                Range* next = delta_next_kept_range(uniboCgrSap, effects, last, &kept, fromTime);
+                // same arguments check of UniboCGR_contact_plan_add_ranges_bulk()
+                if (toTime < fromTime || fromTime < 0 || record->fromNode == 0 || record->toNode == 0) {
+                    writeLog(uniboCgrSap, "Delta: invalid range %" PRIu64 "->%" PRIu64 " (start %" PRId64 "), not added.",
+                             record->fromNode, record->toNode, record->fromTime);
+                    effect->add = 0;
+                } else if ((hasPrevious && (previousFromTime == fromTime || previousToTime > fromTime))
+                           || (next && next->fromTime < toTime)) {
+                    writeLog(uniboCgrSap, "Delta: range %" PRIu64 "->%" PRIu64 " (start %" PRId64 ") overlaps another range, not added.",
+                             record->fromNode, record->toNode, record->fromTime);
+                    effect->add = 0;
+                } else {
+                    *mustClear = true;
+                    hasPrevious = true;
+                    previousFromTime = fromTime;
+                    previousToTime = toTime;
+                }
+            }
+            if (!existing) {
+                continue;
+            }
+        }
+        range = get_next_range(&node);
+        if (range && (range->fromNode != sender || range->toNode != receiver)) {
+            range = NULL;
+        }
+    }
+}
+/*
+ * Check the net effects before touching the contact plan, one node pair at a time:
+ * the operations that cannot be applied are dropped (see filter_delta_contacts()),
+ * so that the contact plan is never left half updated and a single bad record
+ * does not prevent the others to be applied.
+ * Tell if the routing objects must be cleared (something widened or added).
+ */
+static void check_delta_effects(UniboCGRSAP* uniboCgrSap,
+                                DeltaContactEffect* contactEffects,
+                                uint32_t contactEffectsCount,
+                                DeltaRangeEffect* rangeEffects,
+                                uint32_t rangeEffectsCount,
+                                bool* mustClear) {
+    uint32_t first, last;
+    *mustClear = false;
+
+    for (first = 0; first < contactEffectsCount; first = last) {
+        for (last = first + 1; last < contactEffectsCount
+                               && contactEffects[last].record.fromNode == contactEffects[first].record.fromNode
+                               && contactEffects[last].record.toNode == contactEffects[first].record.toNode; last++);
+        filter_delta_contacts(uniboCgrSap, &contactEffects[first], last - first, mustClear);
+    }
+    for (first = 0; first < rangeEffectsCount; first = last) {
+        for (last = first + 1; last < rangeEffectsCount
+                               && rangeEffects[last].record.fromNode == rangeEffects[first].record.fromNode
+                               && rangeEffects[last].record.toNode == rangeEffects[first].record.toNode; last++);
+        filter_delta_ranges(uniboCgrSap, &rangeEffects[first], last - first, mustClear);
+    }
+}
+/*
+ * Removals and revisions of the contacts and ranges already in the contact plan,
+ * filtered by check_delta_effects() (no overlap, no contact not found).
+ * The routes are discarded here only if the routing objects are not going to be cleared.
+ */
+static UniboCGR_Error apply_delta_removals_and_revisions(UniboCGRSAP* uniboCgrSap,
+                                                         const DeltaContactEffect* contactEffects,
+                                                         uint32_t contactEffectsCount,
+                                                         const DeltaRangeEffect* rangeEffects,
+                                                         uint32_t rangeEffectsCount,
+                                                         bool mustClear) {
+    const time_t timeBase = uniboCgrSap->time_base;
+    bool localNeighborsChanged = false;
+
+    // removals first: a revised end time could overlap a contact (range) removed by the delta
+    for (uint32_t i = 0; i < contactEffectsCount; i++) {
+        const BinaryPlanContact* record = &contactEffects[i].record;
+        const bool expired = (contactEffects[i].fields & DELTA_END_TIME)
+                             && (time_t) record->toTime - timeBase <= uniboCgrSap->current_time;
+        if (contactEffects[i].remove || expired) {
+            // the routes of the destinations reached through the contact are deleted along with it
+            remove_contact_from_graph(uniboCgrSap, (time_t) record->fromTime - timeBase, record->fromNode, record->toNode);
+            if (record->fromNode == uniboCgrSap->localNode) {
+                localNeighborsChanged = true;
+            }
+        }
+    }
+    uint64_t lastSender = 0, lastReceiver = 0;
+    for (uint32_t i = 0; i < rangeEffectsCount; i++) {
+        const BinaryPlanRange* record = &rangeEffects[i].record;
+        const bool expired = (rangeEffects[i].fields & DELTA_END_TIME)
+                             && (time_t) record->toTime - timeBase <= uniboCgrSap->current_time;
+        if (rangeEffects[i].remove || expired) {
+            remove_range_from_graph(uniboCgrSap, (time_t) record->fromTime - timeBase, record->fromNode, record->toNode);
+            if (!mustClear && (record->fromNode != lastSender || record->toNode != lastReceiver)) {
+                UniboCGR_discard_range_routes(uniboCgrSap, record->fromNode, record->toNode);
+                lastSender = record->fromNode;
+                lastReceiver = record->toNode;
+            }
+        }
+    }
+
+    for (uint32_t i = 0; i < contactEffectsCount; i++) {
+        const DeltaContactEffect* effect = &contactEffects[i];
+        const BinaryPlanContact* record = &effect->record;
+        const time_t fromTime = (time_t) record->fromTime - timeBase;
+        if (effect->fields == 0 || effect->remove) continue;
+        if ((effect->fields & DELTA_END_TIME) && (time_t) record->toTime - timeBase <= uniboCgrSap->current_time) {
+            continue; // removed
+        }
+        int retval = 0;
+        if (effect->fields & DELTA_END_TIME) {
+            retval = revise_contact_end_time(uniboCgrSap, record->fromNode, record->toNode, fromTime,
+                                             (time_t) record->toTime - timeBase);
+            if (retval == -3) return UniboCGR_ErrorFoundOverlappingContact;
+        }
+        if (retval == 0 && (effect->fields & DELTA_XMIT_RATE)) {
+            retval = revise_xmit_rate(uniboCgrSap, record->fromNode, record->toNode, fromTime, record->xmitRate);
+        }
+        if (retval == 0 && (effect->fields & DELTA_CONFIDENCE)) {
+            retval = revise_confidence(uniboCgrSap, record->fromNode, record->toNode, fromTime, record->confidence);
+        }
+        if (retval == -1) {
+            return UniboCGR_ErrorContactNotFound;
+        } else if (retval < 0) {
+            return UniboCGR_ErrorInvalidArgument;
+        }
+        if (!mustClear) {
+            discard_routes_citing_contact(get_contact(uniboCgrSap, record->fromNode, record->toNode, fromTime, NULL));
+            if (record->fromNode == uniboCgrSap->localNode) {
+                localNeighborsChanged = true;
+            }
+        }
+    }
+    for (uint32_t i = 0; i < rangeEffectsCount; i++) {
+        const DeltaRangeEffect* effect = &rangeEffects[i];
+        const BinaryPlanRange* record = &effect->record;
+        const time_t fromTime = (time_t) record->fromTime - timeBase;
+        if (effect->fields == 0 || effect->remove) continue;
+        if ((effect->fields & DELTA_END_TIME) && (time_t) record->toTime - timeBase <= uniboCgrSap->current_time) {
+            continue; // removed
+        }
+        int retval = 0;
+        if (effect->fields & DELTA_END_TIME) {
+            retval = revise_range_end_time(uniboCgrSap, record->fromNode, record->toNode, fromTime,
+                                           (time_t) record->toTime - timeBase);
+            if (retval == -3) return UniboCGR_ErrorFoundOverlappingRange;
+        }
+        if (retval == 0 && (effect->fields & DELTA_OWLT)) {
+            retval = revise_owlt(uniboCgrSap, record->fromNode, record->toNode, fromTime, record->owlt);
+        }
+        if (retval == -1) {
+            return UniboCGR_ErrorRangeNotFound;
+        } else if (retval < 0) {
+            return UniboCGR_ErrorInvalidArgument;
+        }
+        if (!mustClear && (record->fromNode != lastSender || record->toNode != lastReceiver)) {
+            UniboCGR_discard_range_routes(uniboCgrSap, record->fromNode, record->toNode);
+            lastSender = record->fromNode;
+            lastReceiver = record->toNode;
+        }
+    }
+
+    if (localNeighborsChanged) {
+        invalidate_local_node_neighbors_list(uniboCgrSap);
+    }
+
+    return UniboCGR_NoError;
+}
+/*
+ * Additions: through the bulk functions (one sorted merge for the contacts, one for the ranges).
+ * The contacts (ranges) already expired are skipped; the others have been checked
+ * by check_delta_effects() against the contact plan after the removals and the revisions.
+ */
+static UniboCGR_Error apply_delta_additions(UniboCGRSAP* uniboCgrSap,
+                                            const DeltaContactEffect* contactEffects,
+                                            uint32_t contactEffectsCount,
+                                            const DeltaRangeEffect* rangeEffects,
+                                            uint32_t rangeEffectsCount,
+                                            bool copy_mtv,
+                                            bool* mustClear) {
+    UniboCGR_FlatContact* contacts = MWITHDRAW(sizeof(UniboCGR_FlatContact) * (contactEffectsCount > 0 ? contactEffectsCount : 1));
+    UniboCGR_FlatRange* ranges = MWITHDRAW(sizeof(UniboCGR_FlatRange) * (rangeEffectsCount > 0 ? rangeEffectsCount : 1));
+    if (!contacts || !ranges) {
+        if (contacts) MDEPOSIT(contacts);
+        if (ranges) MDEPOSIT(ranges);
+        return UniboCgr_ErrorSystem;
+    }
+
+    const time_t currentTime = uniboCgrSap->time_base + uniboCgrSap->current_time;
+    uint32_t contactsCount = 0;
+    for (uint32_t i = 0; i < contactEffectsCount; i++) {
+        const BinaryPlanContact* record = &contactEffects[i].record;
+        if (!contactEffects[i].add || (time_t) record->toTime <= currentTime) continue;
+        UniboCGR_FlatContact* flat = &contacts[contactsCount++];
+        flat->sender = record->fromNode;
+        flat->receiver = record->toNode;
+        flat->start_time = (time_t) record->fromTime;
+        flat->end_time = (time_t) record->toTime;
+        flat->xmit_rate = record->xmitRate;
+        flat->confidence = record->confidence;
+        for (int priority = 0; priority < 3; priority++) {
+            flat->mtv[priority] = record->mtv[priority];
+        }
+    }
+    uint32_t rangesCount = 0;
+    for (uint32_t i = 0; i < rangeEffectsCount; i++) {
+        const BinaryPlanRange* record = &rangeEffects[i].record;
+        if (!rangeEffects[i].add || (time_t) record->toTime <= currentTime) continue;
+        UniboCGR_FlatRange* flat = &ranges[rangesCount++];
+        flat->sender = record->fromNode;
+        flat->receiver = record->toNode;
+        flat->start_time = (time_t) record->fromTime;
+        flat->end_time = (time_t) record->toTime;
+        flat->one_way_light_time = record->owlt;
+    }
+
+    bool added = false;
+    UniboCGR_Error error = add_flat_contacts_to_graph(uniboCgrSap, contacts, contactsCount, copy_mtv, &added);
+    if (added) *mustClear = true;
+    if (error == UniboCGR_NoError) {
+        error = add_flat_ranges_to_graph(uniboCgrSap, ranges, rangesCount, &added);
+        if (added) *mustClear = true;
+    }
+
+    MDEPOSIT(contacts);
+    MDEPOSIT(ranges);
+
+    return error;
+}
+/*
+ * Apply the delta to the graphs currently set in the SAP (the contact plan or its shadow).
+ * *mustClear is set to true if the delta may enable new routes.
+ * With discardRoutes set to false no route is discarded (the shadow graphs are not cited by any route).
+ */
+static UniboCGR_Error apply_delta_to_graphs(UniboCGRSAP* uniboCgrSap,
+                                            ContactPlanDelta* delta,
+                                            bool copy_mtv,
+                                            bool discardRoutes,
+                                            bool* mustClear) {
+    *mustClear = false;
+    if (delta->contactsCount == 0 && delta->rangesCount == 0) {
+        return UniboCGR_NoError;
+    }
+
+    DeltaContactEffect* contactEffects = MWITHDRAW(sizeof(DeltaContactEffect) * (delta->contactsCount > 0 ? delta->contactsCount : 1));
+    DeltaRangeEffect* rangeEffects = MWITHDRAW(sizeof(DeltaRangeEffect) * (delta->rangesCount > 0 ? delta->rangesCount : 1));
+    if (!contactEffects || !rangeEffects) {
+        if (contactEffects) MDEPOSIT(contactEffects);
+        if (rangeEffects) MDEPOSIT(rangeEffects);
+        return UniboCgr_ErrorSystem;
+    }
+
+    // sorted as the graphs: each contact (range) is looked up once, in key order
+    delta_sort(delta);
+
+    UniboCGR_Error error = UniboCGR_NoError;
+    uint32_t contactEffectsCount = 0;
+    uint32_t rangeEffectsCount = 0;
+    int result = delta_fold_contacts(delta, contactEffects, &contactEffectsCount);
+    if (result == -1) {
+        error = UniboCGR_ErrorContactNotFound;
+    } else if (result == -3) {
+        error = UniboCGR_ErrorFoundOverlappingContact;
+    }
+    if (error == UniboCGR_NoError) {
+        result = delta_fold_ranges(delta, rangeEffects, &rangeEffectsCount);
+        if (result == -1) {
+            error = UniboCGR_ErrorRangeNotFound;
+        } else if (result == -3) {
+            error = UniboCGR_ErrorFoundOverlappingRange;
+        }
+    }
+
+    if (error == UniboCGR_NoError) {
+        check_delta_effects(uniboCgrSap,
+                            contactEffects, contactEffectsCount,
+                            rangeEffects, rangeEffectsCount,
+                            mustClear);
+    }
+    if (error == UniboCGR_NoError) {
+        error = apply_delta_removals_and_revisions(uniboCgrSap,
+                                                   contactEffects, contactEffectsCount,
+                                                   rangeEffects, rangeEffectsCount,
+                                                   *mustClear || !discardRoutes);
+    }
+    if (error == UniboCGR_NoError) {
+        error = apply_delta_additions(uniboCgrSap,
+                                      contactEffects, contactEffectsCount,
+                                      rangeEffects, rangeEffectsCount,
+                                      copy_mtv, mustClear);
+    }
+
+    MDEPOSIT(contactEffects);
+    MDEPOSIT(rangeEffects);
+
+    return error;
+}
+UniboCGR_Error UniboCGR_contact_plan_apply_delta(UniboCGR uniboCgr,
+                                                 UniboCGR_ContactPlanDelta uniboCgrDelta,
+                                                 bool copy_mtv) {
+    if (!uniboCgr || !uniboCgrDelta) { return UniboCGR_ErrorInvalidArgument; }
+    UniboCGRSAP* uniboCgrSap = (UniboCGRSAP*) uniboCgr;
+    CHECK_EQUAL_SESSION(UniboCGR_Session_contact_plan);
+
+    bool mustClear = false;
+    UniboCGR_Error error = apply_delta_to_graphs(uniboCgrSap, (ContactPlanDelta*) uniboCgrDelta, copy_mtv, true, &mustClear);
+    if (mustClear) {
+        // single invalidation: all the routes are discarded at the end of the session
+        uniboCgrSap->mustClearRoutingObjects = true;
+    }
+
+    return error;
+}
+/*
+ * Copy the contacts (ranges) of the contact plan into the shadow graphs (empty).
+ * The MTVs are copied along with the contacts.
+ */
+static UniboCGR_Error copy_contact_plan_to_shadow(UniboCGRSAP* uniboCgrSap) {
+    uint32_t contactsCount = 0;
+    uint32_t rangesCount = 0;
+    RbtNode* node;
+    Contact* contact;
+    Range* range;
+    for (contact = get_first_contact(uniboCgrSap, &node); contact; contact = get_next_contact(&node)) {
+        contactsCount++;
+    }
+    for (range = get_first_range(uniboCgrSap, &node); range; range = get_next_range(&node)) {
+        rangesCount++;
+    }
+
+    Contact** contacts = MWITHDRAW(sizeof(Contact*) * (contactsCount > 0 ? contactsCount : 1));
+    Range** ranges = MWITHDRAW(sizeof(Range*) * (rangesCount > 0 ? rangesCount : 1));
+    if (!contacts || !ranges) {
+        if (contacts) MDEPOSIT(contacts);
+        if (ranges) MDEPOSIT(ranges);
+        return UniboCgr_ErrorSystem;
+    }
+
+    uint32_t copiedContacts = 0;
+    uint32_t copiedRanges = 0;
+    bool error = false;
+    for (contact = get_first_contact(uniboCgrSap, &node); contact && !error; contact = get_next_contact(&node)) {
+        Contact* copy = create_contact(uniboCgrSap, contact->fromNode, contact->toNode, contact->fromTime, contact->toTime,
+                                       contact->xmitRate, contact->confidence, contact->type);
+        if (!copy) {
+            error = true;
+            continue;
+        }
+        for (int priority = 0; priority < 3; priority++) {
+            copy->mtv[priority] = contact->mtv[priority];
+        }
+        contacts[copiedContacts++] = copy;
+    }
+    for (range = get_first_range(uniboCgrSap, &node); range && !error; range = get_next_range(&node)) {
+        Range* copy = create_range(range->fromNode, range->toNode, range->fromTime, range->toTime, range->owlt);
+        if (!copy) {
+            error = true;
+            continue;
+        }
+        ranges[copiedRanges++] = copy;
+    }
+    if (error) {
+        for (uint32_t i = 0; i < copiedContacts; i++) free_contact(contacts[i]);
+        for (uint32_t i = 0; i < copiedRanges; i++) free_range(ranges[i]);
+        MDEPOSIT(contacts);
+        MDEPOSIT(ranges);
+        return UniboCgr_ErrorSystem;
+    }
+
+    // already sorted and the shadow graphs are empty: both are built bottom-up
+    UniboCGR_swap_shadow_contact_plan(uniboCgrSap);
+    int retvalContacts = add_contacts_to_graph_bulk(uniboCgrSap, contacts, copiedContacts);
+    int retvalRanges = add_ranges_to_graph_bulk(uniboCgrSap, ranges, copiedRanges);
+    UniboCGR_swap_shadow_contact_plan(uniboCgrSap);
+
+    MDEPOSIT(contacts);
+    MDEPOSIT(ranges);
+
+    return (retvalContacts < 0 || retvalRanges < 0) ? UniboCgr_ErrorSystem : UniboCGR_NoError;
+}
+UniboCGR_Error UniboCGR_shadow_contact_plan_open(UniboCGR uniboCgr, time_t time, bool copy_contact_plan) {
+    if (!uniboCgr) { return UniboCGR_ErrorInvalidArgument; }
+    UniboCGRSAP* uniboCgrSap = (UniboCGRSAP*) uniboCgr;
+    CHECK_OPEN_SESSION;
+    UniboCGR_set_current_time(uniboCgr, time);
+
+    UniboCGR_swap_shadow_contact_plan(uniboCgrSap);
+    int retval = ContactSAP_open(uniboCgrSap);
+    if (retval == 0) {
+        retval = RangeSAP_open(uniboCgrSap);
+    }
+    if (retval == 0) {
+        // previous shadow or previous contact plan (after a publish): start over
+        reset_ContactsGraph(uniboCgrSap);
+        reset_RangesGraph(uniboCgrSap);
+    }
+    UniboCGR_swap_shadow_contact_plan(uniboCgrSap);
+    if (retval != 0) {
+        UniboCGR_shadow_contact_plan_destroy(uniboCgrSap);
+        return UniboCgr_ErrorSystem;
+    }
+
+    if (copy_contact_plan) {
+        // horizon mode: the staged contacts are copied too (staged again by the next update)
+        UniboCGR_Error error = (set_contacts_horizon(uniboCgrSap, MAX_POSIX_TIME) < 0)
+                               ? UniboCgr_ErrorSystem : copy_contact_plan_to_shadow(uniboCgrSap);
+        if (error != UniboCGR_NoError) {
+            UniboCGR_shadow_contact_plan_destroy(uniboCgrSap);
+            return error;
+        }
+    }
+
+    uniboCgrSap->shadow_open = true;
+    return UniboCGR_NoError;
+}
+UniboCGR_Error UniboCGR_shadow_contact_plan_apply_delta(UniboCGR uniboCgr,
+                                                        UniboCGR_ContactPlanDelta uniboCgrDelta,
+                                                        bool copy_mtv) {
+    if (!uniboCgr || !uniboCgrDelta) { return UniboCGR_ErrorInvalidArgument; }
+    UniboCGRSAP* uniboCgrSap = (UniboCGRSAP*) uniboCgr;
+    CHECK_OPEN_SESSION;
+    if (!uniboCgrSap->shadow_open) { return UniboCGR_ErrorSessionClosed; }
+
+    // the routes are not touched: they cite only the contact plan
+    bool mustClear = false;
+    UniboCGR_swap_shadow_contact_plan(uniboCgrSap);
+    UniboCGR_Error error = apply_delta_to_graphs(uniboCgrSap, (ContactPlanDelta*) uniboCgrDelta, copy_mtv, false, &mustClear);
+    UniboCGR_swap_shadow_contact_plan(uniboCgrSap);
+
+    return error;
+}
+UniboCGR_Error UniboCGR_shadow_contact_plan_discard(UniboCGR uniboCgr) {
+    if (!uniboCgr) { return UniboCGR_ErrorInvalidArgument; }
+    UniboCGRSAP* uniboCgrSap = (UniboCGRSAP*) uniboCgr;
+    CHECK_OPEN_SESSION;
+    if (!uniboCgrSap->shadow_open) { return UniboCGR_ErrorSessionClosed; }
+
+    UniboCGR_shadow_contact_plan_destroy(uniboCgrSap);
+    return UniboCGR_NoError;
+}
+UniboCGR_Error UniboCGR_shadow_contact_plan_publish(UniboCGR uniboCgr, time_t time) {
+    if (!uniboCgr) { return UniboCGR_ErrorInvalidArgument; }
+    UniboCGRSAP* uniboCgrSap = (UniboCGRSAP*) uniboCgr;
+    CHECK_OPEN_SESSION;
+    if (!uniboCgrSap->shadow_open) { return UniboCGR_ErrorSessionClosed; }
+    UniboCGR_set_current_time(uniboCgr, time);
+
+    // horizon mode: the routes migrate between whole contact plans,
+    // the new one is staged by the update below
+    if (set_contacts_horizon(uniboCgrSap, MAX_POSIX_TIME) < 0) {
+        return UniboCgr_ErrorSystem;
+    }
+
+    UniboCGR_swap_shadow_contact_plan(uniboCgrSap);
+    uniboCgrSap->shadow_open = false;
+
+    // the surviving routes move to the new graph, the destinations
+    // reached through a removed or changed contact (range) lose all their routes
+    int widened = migrate_routes_to_contacts_graph(uniboCgrSap, uniboCgrSap->shadowContactSap);
+    if (discard_routes_through_changed_ranges(uniboCgrSap, uniboCgrSap->shadowRangeSap) > 0) {
+        widened = 1;
+    }
+    if (widened) {
+        uniboCgrSap->mustClearRoutingObjects = true;
+    }
+    invalidate_local_node_neighbors_list(uniboCgrSap);
+
+    // as UniboCGR_contact_plan_close()
+    uniboCgrSap->contact_plan_epoch++;
+    if (UniboCGRSAP_handle_updates(uniboCgrSap) < 0) {
+        return UniboCgr_ErrorSystem;
+    }
+    LogSAP_log_contact_plan(uniboCgrSap);
+    LogSAP_log_fflush(uniboCgrSap);
+    return UniboCGR_NoError;
+}
+UniboCGR_Error UniboCGR_contact_plan_change_range_start_time(UniboCGR uniboCgr,
+                                                             uint64_t sender,
+                                                             uint64_t receiver,
+                                                             time_t start_time,
+                                                             time_t new_start_time) {
+    if (!uniboCgr) { return UniboCGR_ErrorInvalidArgument; }
+    UniboCGRSAP* uniboCgrSap = (UniboCGRSAP*) uniboCgr;
+    CHECK_EQUAL_SESSION(UniboCGR_Session_contact_plan);
+
+    start_time -= uniboCgrSap->time_base;
+    new_start_time -= uniboCgrSap->time_base;
+
+    Range* range = get_range(uniboCgrSap, sender, receiver, start_time, NULL);
+    const bool widened = range && new_start_time < range->fromTime;
+
+    int temp = revise_range_start_time(uniboCgrSap, sender, receiver, start_time, new_start_time);
+
+    if (temp == 0) {
+        if (widened) {
+            uniboCgrSap->mustClearRoutingObjects = true;
+        } else {
+            UniboCGR_discard_range_routes(uniboCgrSap, sender, receiver);
+        }
+        return UniboCGR_NoError;
+    } else if (temp == -1) {
+        return UniboCGR_ErrorRangeNotFound;
+    } else if (temp == -2) {
+        return UniboCGR_ErrorInvalidArgument;
+    } else if (temp == -3) {
+        return UniboCGR_ErrorFoundOverlappingRange;
+    }
+
+    return UniboCGR_ErrorUnknown;
+}
+
+UniboCGR_Error UniboCGR_contact_plan_change_range_end_time(UniboCGR uniboCgr,
+                                                           uint64_t sender,
+                                                           uint64_t receiver,
+                                                           time_t start_time,
+                                                           time_t new_end_time) {
+    if (!uniboCgr) { return UniboCGR_ErrorInvalidArgument; }
+    UniboCGRSAP* uniboCgrSap = (UniboCGRSAP*) uniboCgr;
+    CHECK_EQUAL_SESSION(UniboCGR_Session_contact_plan);
+
+    start_time -= uniboCgrSap->time_base;
+    new_end_time -= uniboCgrSap->time_base;
+
+    if (new_end_time <= uniboCgrSap->current_time) {
+        remove_range_from_graph(uniboCgrSap,
+                                start_time,
+                                sender,
+                                receiver);
+        UniboCGR_discard_range_routes(uniboCgrSap, sender, receiver);
+        return UniboCGR_NoError;
+    }
+
+    Range* range = get_range(uniboCgrSap, sender, receiver, start_time, NULL);
+    const bool widened = range && new_end_time > range->toTime;
+
+    int temp = revise_range_end_time(uniboCgrSap, sender, receiver, start_time, new_end_time);
+
+    if (temp == 0) {
+        if (widened) {
+            uniboCgrSap->mustClearRoutingObjects = true;
+        } else {
+            UniboCGR_discard_range_routes(uniboCgrSap, sender, receiver);
+        }
+        return UniboCGR_NoError;
+    } else if (temp == -1) {
+        return UniboCGR_ErrorRangeNotFound;
+    } else if (temp == -2) {
+        return UniboCGR_ErrorInvalidArgument;
+    } else if (temp == -3) {
+        return UniboCGR_ErrorFoundOverlappingRange;
+    }
+
+    return UniboCGR_ErrorUnknown;
+}
+UniboCGR_Error UniboCGR_contact_plan_change_range_one_way_light_time(UniboCGR uniboCgr,
+                                                                     uint64_t sender,
+                                                                     uint64_t receiver,
+                                                                     time_t start_time,
+                                                                     uint64_t new_owlt) {
+    if (!uniboCgr) { return UniboCGR_ErrorInvalidArgument; }
+    UniboCGRSAP* uniboCgrSap = (UniboCGRSAP*) uniboCgr;
+    CHECK_EQUAL_SESSION(UniboCGR_Session_contact_plan);
+
+    start_time -= uniboCgrSap->time_base;
+
+    Range* range = get_range(uniboCgrSap, sender, receiver, start_time, NULL);
+    const bool widened = range && new_owlt < range->owlt;
+
+    int retval = revise_owlt(uniboCgrSap,
+                             sender,
+                             receiver,
+                             start_time,
+                             new_owlt);
+
+    if (retval == 0) {
+        if (widened) {
+            uniboCgrSap->mustClearRoutingObjects = true;
+        } else {
+            UniboCGR_discard_range_routes(uniboCgrSap, sender, receiver);
+        }
+        return UniboCGR_NoError;
+    } else if (retval == -1) {
+        return UniboCGR_ErrorRangeNotFound;
+    } else if (retval == -2) {
+        return UniboCgr_ErrorSystem;
+    }
+
+    return UniboCGR_ErrorUnknown;
+}
+UniboCGR_Error UniboCGR_contact_plan_remove_range(UniboCGR uniboCgr,
+                                                  uint64_t sender,
+                                                  uint64_t receiver,
+                                                  time_t start_time) {
+    if (!uniboCgr) { return UniboCGR_ErrorInvalidArgument; }
+    UniboCGRSAP* uniboCgrSap = (UniboCGRSAP*) uniboCgr;
+    CHECK_EQUAL_SESSION(UniboCGR_Session_contact_plan);
+
+    start_time -= uniboCgrSap->time_base;
+
+    remove_range_from_graph(uniboCgrSap,
+                            start_time,
+                            sender,
+                            receiver);
+
+    UniboCGR_discard_range_routes(uniboCgrSap, sender, receiver);
+    return UniboCGR_NoError;
 }
 
 /* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
@@ -1290,19 +3169,7 @@ UniboCGR_Error UniboCGR_routing_close(UniboCGR uniboCgr) {
     LogSAP_log_fflush(uniboCgrSap);
     return UniboCGR_NoError;
 }
-UniboCGR_Error UniboCGR_routing(UniboCGR uniboCgr,
-                                UniboCGR_Bundle uniboCgrBundle,
-                                UniboCGR_excluded_neighbors_list excluded_neighbors_list,
-                                UniboCGR_route_list* route_list) {
-    if (!uniboCgr || !uniboCgrBundle || !excluded_neighbors_list || !route_list) {
-        return UniboCGR_ErrorInvalidArgument;
-    }
-
-    UniboCGRSAP* uniboCgrSap = (UniboCGRSAP*) uniboCgr;
-    CHECK_EQUAL_SESSION(UniboCGR_Session_routing);
-
-    CgrBundle* bundle = (CgrBundle*) uniboCgrBundle;
-
+static void UniboCGR_prepare_bundle_for_routing(UniboCGRSAP* uniboCgrSap, CgrBundle* bundle) {
     // first, set expiration time in seconds since DTN EPOCH (01.01.2000 00:00:00 UTC)
     if (bundle->bp_version == 7) {
         // creation time and lifetime are expressed in milliseconds (RFC 9171)
@@ -1315,24 +3182,14 @@ UniboCGR_Error UniboCGR_routing(UniboCGR uniboCgr,
     // second, convert from DTN time to Unix time (01.01.1970 00:00:00 UTC)
     bundle->expiration_time += UNIBO_CGR_DTN_EPOCH;
     // finally, convert from Unix time to relative time
-    bundle->expiration_time -= uniboCgrSap->reference_time;
+    bundle->expiration_time -= uniboCgrSap->time_base;
 
     bundle->evc = computeBundleEVC(
             bundle->primary_block_length
             + bundle->extension_blocks_length
             + bundle->payload_block_length);
-
-    uniboCgrSap->route_iterator = NULL;
-    uniboCgrSap->hop_iterator = NULL;
-
-    UniboCGR_log_bundle_routing_call(uniboCgr, uniboCgrBundle);
-    List internal_routes = NULL;
-    int retval = getBestRoutes(uniboCgrSap,
-                               (CgrBundle*) uniboCgrBundle,
-                               (List) excluded_neighbors_list,
-                               &internal_routes);
-    *route_list = (UniboCGR_route_list) internal_routes;
-
+}
+static UniboCGR_Error UniboCGR_routing_result_to_error(UniboCGRSAP* uniboCgrSap, int retval) {
     if (retval >= 0) {
         return UniboCGR_NoError;
     } else if (retval == -1) {
@@ -1353,6 +3210,170 @@ UniboCGR_Error UniboCGR_routing(UniboCGR uniboCgr,
         return error;
     }
 }
+/*
+ * Horizon mode: the search ran out of graph before the bundle deadline.
+ * The staged contacts that start before the deadline are promoted,
+ * only if one of them reaches the destination.
+ * Returns true if the routing must be repeated.
+ */
+static bool UniboCGR_grow_contact_horizon(UniboCGRSAP* uniboCgrSap, CgrBundle* bundle) {
+    if (!uniboCgrSap->feature_contact_horizon
+        || bundle->expiration_time <= get_contacts_horizon(uniboCgrSap)
+        || !staged_contact_reaches_node(uniboCgrSap, bundle->terminus_node, bundle->expiration_time)) {
+        return false;
+    }
+    if (set_contacts_horizon(uniboCgrSap, bundle->expiration_time) <= 0) {
+        return false;
+    }
+    uniboCgrSap->contact_horizon_limit = bundle->expiration_time;
+    uniboCgrSap->mustClearRoutingObjects = true;
+    invalidate_local_node_neighbors_list(uniboCgrSap);
+    writeLog(uniboCgrSap, "Contact horizon grown to %ld s.", (long int) bundle->expiration_time);
+    return true;
+}
+UniboCGR_Error UniboCGR_routing(UniboCGR uniboCgr,
+                                UniboCGR_Bundle uniboCgrBundle,
+                                UniboCGR_excluded_neighbors_list excluded_neighbors_list,
+                                UniboCGR_route_list* route_list) {
+    if (!uniboCgr || !uniboCgrBundle || !excluded_neighbors_list || !route_list) {
+        return UniboCGR_ErrorInvalidArgument;
+    }
+
+    UniboCGRSAP* uniboCgrSap = (UniboCGRSAP*) uniboCgr;
+    CHECK_EQUAL_SESSION(UniboCGR_Session_routing);
+
+    UniboCGR_prepare_bundle_for_routing(uniboCgrSap, (CgrBundle*) uniboCgrBundle);
+
+    uniboCgrSap->route_iterator = NULL;
+    uniboCgrSap->hop_iterator = NULL;
+
+    UniboCGR_log_bundle_routing_call(uniboCgr, uniboCgrBundle);
+    List internal_routes = NULL;
+    begin_reservation(uniboCgrSap);
+    int retval = getBestRoutes(uniboCgrSap,
+                               (CgrBundle*) uniboCgrBundle,
+                               (List) excluded_neighbors_list,
+                               &internal_routes);
+    if ((retval == 0 || retval == -1) && UniboCGR_grow_contact_horizon(uniboCgrSap, (CgrBundle*) uniboCgrBundle)) {
+        retval = getBestRoutes(uniboCgrSap,
+                               (CgrBundle*) uniboCgrBundle,
+                               (List) excluded_neighbors_list,
+                               &internal_routes);
+    }
+    end_reservation(uniboCgrSap);
+    *route_list = (UniboCGR_route_list) internal_routes;
+
+    return UniboCGR_routing_result_to_error(uniboCgrSap, retval);
+}
+typedef struct {
+    UniboCGR_routing_group_callback callback;
+    void* callback_arg;
+} UniboCGR_routing_group_context;
+static void UniboCGR_routing_group_internal_callback(UniboCGRSAP* uniboCgrSap, uint32_t index, int result, List bestRoutes, void* arg) {
+    UniboCGR_routing_group_context* context = (UniboCGR_routing_group_context*) arg;
+    uniboCgrSap->route_iterator = NULL;
+    uniboCgrSap->hop_iterator = NULL;
+    // the volumes reserved since the previous bundle of the group belong to this bundle
+    end_reservation(uniboCgrSap);
+    UniboCGR_Error error = UniboCGR_routing_result_to_error(uniboCgrSap, result);
+    context->callback((UniboCGR) uniboCgrSap, index, error, (UniboCGR_route_list) bestRoutes, context->callback_arg);
+    begin_reservation(uniboCgrSap);
+}
+UniboCGR_Error UniboCGR_routing_group(UniboCGR uniboCgr,
+                                      UniboCGR_Bundle* bundles,
+                                      uint32_t bundles_count,
+                                      UniboCGR_excluded_neighbors_list excluded_neighbors_list,
+                                      UniboCGR_routing_group_callback callback,
+                                      void* callback_arg) {
+    if (!uniboCgr || !bundles || bundles_count == 0 || !excluded_neighbors_list || !callback) {
+        return UniboCGR_ErrorInvalidArgument;
+    }
+
+    UniboCGRSAP* uniboCgrSap = (UniboCGRSAP*) uniboCgr;
+    CHECK_EQUAL_SESSION(UniboCGR_Session_routing);
+
+    for (uint32_t i = 0; i < bundles_count; i++) {
+        if (!bundles[i]) return UniboCGR_ErrorInvalidArgument;
+        UniboCGR_prepare_bundle_for_routing(uniboCgrSap, (CgrBundle*) bundles[i]);
+        UniboCGR_log_bundle_routing_call(uniboCgr, bundles[i]);
+    }
+
+    UniboCGR_routing_group_context context;
+    context.callback = callback;
+    context.callback_arg = callback_arg;
+
+    begin_reservation(uniboCgrSap);
+    int retval = getBestRoutesGroup(uniboCgrSap,
+                                    (CgrBundle**) bundles,
+                                    bundles_count,
+                                    (List) excluded_neighbors_list,
+                                    UniboCGR_routing_group_internal_callback,
+                                    &context);
+    end_reservation(uniboCgrSap);
+
+    return UniboCGR_routing_result_to_error(uniboCgrSap, retval);
+}
+UniboCGR_Error UniboCGR_routing_batch(UniboCGR uniboCgr,
+                                      UniboCGR_Bundle* bundles,
+                                      UniboCGR_excluded_neighbors_list* excluded_neighbors_lists,
+                                      uint32_t bundles_count,
+                                      UniboCGR_routing_group_callback callback,
+                                      void* callback_arg) {
+    if (!uniboCgr || !bundles || !excluded_neighbors_lists || bundles_count == 0 || !callback) {
+        return UniboCGR_ErrorInvalidArgument;
+    }
+
+    UniboCGRSAP* uniboCgrSap = (UniboCGRSAP*) uniboCgr;
+    CHECK_EQUAL_SESSION(UniboCGR_Session_routing);
+
+    for (uint32_t i = 0; i < bundles_count; i++) {
+        if (!bundles[i] || !excluded_neighbors_lists[i]) return UniboCGR_ErrorInvalidArgument;
+        UniboCGR_prepare_bundle_for_routing(uniboCgrSap, (CgrBundle*) bundles[i]);
+        UniboCGR_log_bundle_routing_call(uniboCgr, bundles[i]);
+    }
+
+    UniboCGR_routing_group_context context;
+    context.callback = callback;
+    context.callback_arg = callback_arg;
+
+    begin_reservation(uniboCgrSap);
+    int retval = getBestRoutesBatch(uniboCgrSap,
+                                    (CgrBundle**) bundles,
+                                    (List*) excluded_neighbors_lists,
+                                    bundles_count,
+                                    UniboCGR_routing_group_internal_callback,
+                                    &context);
+    end_reservation(uniboCgrSap);
+
+    return UniboCGR_routing_result_to_error(uniboCgrSap, retval);
+}
+UniboCGR_Reservation UniboCGR_get_reservation(UniboCGR uniboCgr) {
+    if (!uniboCgr) return 0;
+    return (UniboCGR_Reservation) get_last_reservation((UniboCGRSAP*) uniboCgr);
+}
+UniboCGR_Error UniboCGR_reservation_commit(UniboCGR uniboCgr, UniboCGR_Reservation reservation) {
+    if (!uniboCgr || reservation == 0) return UniboCGR_ErrorInvalidArgument;
+    UniboCGRSAP* uniboCgrSap = (UniboCGRSAP*) uniboCgr;
+    if (commit_reservation(uniboCgrSap, (uint64_t) reservation) < 0) {
+        return UniboCGR_ErrorReservationNotFound;
+    }
+    return UniboCGR_NoError;
+}
+UniboCGR_Error UniboCGR_reservation_release(UniboCGR uniboCgr, UniboCGR_Reservation reservation) {
+    if (!uniboCgr || reservation == 0) return UniboCGR_ErrorInvalidArgument;
+    UniboCGRSAP* uniboCgrSap = (UniboCGRSAP*) uniboCgr;
+    if (release_reservation(uniboCgrSap, (uint64_t) reservation) < 0) {
+        return UniboCGR_ErrorReservationNotFound;
+    }
+    // the released volume may make viable some route excluded by the cached results
+    route_cache_mtv_increased(uniboCgrSap);
+    return UniboCGR_NoError;
+}
+UniboCGR_Error UniboCGR_route_cache_get_counters(UniboCGR uniboCgr, uint64_t* hits, uint64_t* misses) {
+    if (!uniboCgr) return UniboCGR_ErrorInvalidArgument;
+    route_cache_get_counters((UniboCGRSAP*) uniboCgr, hits, misses);
+    return UniboCGR_NoError;
+}
 UniboCGR_RoutingAlgorithm UniboCGR_get_used_routing_algorithm(UniboCGR uniboCgr) {
     if (!uniboCgr) return UniboCGR_RoutingAlgorithm_Unknown;
     RoutingAlgorithm algorithm = get_last_call_routing_algorithm((UniboCGRSAP*) uniboCgr);
@@ -1427,7 +3448,7 @@ void UniboCGR_Contact_set_start_time(UniboCGR uniboCgr,
     UniboCGRSAP* uniboCgrSap = (UniboCGRSAP*) uniboCgr;
     Contact* contact = (Contact*) uniboCgrContact;
 
-    contact->fromTime = start_time - uniboCgrSap->reference_time;
+    contact->fromTime = start_time - uniboCgrSap->time_base;
 }
 void UniboCGR_Contact_set_end_time(UniboCGR uniboCgr,
                                    UniboCGR_Contact uniboCgrContact,
@@ -1438,7 +3459,7 @@ void UniboCGR_Contact_set_end_time(UniboCGR uniboCgr,
     UniboCGRSAP* uniboCgrSap = (UniboCGRSAP*) uniboCgr;
     Contact* contact = (Contact*) uniboCgrContact;
 
-    contact->toTime = end_time - uniboCgrSap->reference_time;
+    contact->toTime = end_time - uniboCgrSap->time_base;
 }
 void UniboCGR_Contact_set_xmit_rate(UniboCGR_Contact uniboCgrContact,
                                     uint64_t xmit_rate_bytes_per_second) {
@@ -1465,7 +3486,7 @@ void UniboCGR_Contact_set_mtv_bulk(UniboCGR_Contact uniboCgrContact,
     }
     Contact* contact = (Contact*) uniboCgrContact;
 
-    contact->mtv[0] = mtv;
+    contact->mtv[0] = convert_volume_to_mtv(mtv);
 }
 void UniboCGR_Contact_set_mtv_normal(UniboCGR_Contact uniboCgrContact,
                                      double mtv) {
@@ -1474,7 +3495,7 @@ void UniboCGR_Contact_set_mtv_normal(UniboCGR_Contact uniboCgrContact,
     }
     Contact* contact = (Contact*) uniboCgrContact;
 
-    contact->mtv[1] = mtv;
+    contact->mtv[1] = convert_volume_to_mtv(mtv);
 }
 void UniboCGR_Contact_set_mtv_expedited(UniboCGR_Contact uniboCgrContact,
                                         double mtv) {
@@ -1483,7 +3504,7 @@ void UniboCGR_Contact_set_mtv_expedited(UniboCGR_Contact uniboCgrContact,
     }
     Contact* contact = (Contact*) uniboCgrContact;
 
-    contact->mtv[2] = mtv;
+    contact->mtv[2] = convert_volume_to_mtv(mtv);
 }
 void UniboCGR_Contact_set_type(UniboCGR_Contact uniboCgrContact,
                                UniboCGR_ContactType type) {
@@ -1518,7 +3539,7 @@ time_t UniboCGR_Contact_get_start_time(UniboCGR uniboCgr,
     UniboCGRSAP* uniboCgrSap = (UniboCGRSAP*) uniboCgr;
     Contact* contact = (Contact*) uniboCgrContact;
 
-    return contact->fromTime + uniboCgrSap->reference_time;
+    return contact->fromTime + uniboCgrSap->time_base;
 }
 time_t UniboCGR_Contact_get_end_time(UniboCGR uniboCgr,
                                      UniboCGR_Contact uniboCgrContact) {
@@ -1528,7 +3549,7 @@ time_t UniboCGR_Contact_get_end_time(UniboCGR uniboCgr,
     UniboCGRSAP* uniboCgrSap = (UniboCGRSAP*) uniboCgr;
     Contact* contact = (Contact*) uniboCgrContact;
 
-    return contact->toTime + uniboCgrSap->reference_time;
+    return contact->toTime + uniboCgrSap->time_base;
 }
 uint64_t UniboCGR_Contact_get_xmit_rate(UniboCGR_Contact uniboCgrContact) {
     if (!uniboCgrContact) {
@@ -1552,7 +3573,7 @@ double UniboCGR_Contact_get_mtv_bulk(UniboCGR_Contact uniboCgrContact) {
     }
     Contact* contact = (Contact*) uniboCgrContact;
 
-    return contact->mtv[0];
+    return (double) contact->mtv[0];
 }
 double UniboCGR_Contact_get_mtv_normal(UniboCGR_Contact uniboCgrContact) {
     if (!uniboCgrContact) {
@@ -1560,7 +3581,7 @@ double UniboCGR_Contact_get_mtv_normal(UniboCGR_Contact uniboCgrContact) {
     }
     Contact* contact = (Contact*) uniboCgrContact;
 
-    return contact->mtv[1];
+    return (double) contact->mtv[1];
 }
 double UniboCGR_Contact_get_mtv_expedited(UniboCGR_Contact uniboCgrContact) {
     if (!uniboCgrContact) {
@@ -1568,7 +3589,7 @@ double UniboCGR_Contact_get_mtv_expedited(UniboCGR_Contact uniboCgrContact) {
     }
     Contact* contact = (Contact*) uniboCgrContact;
 
-    return contact->mtv[2];
+    return (double) contact->mtv[2];
 }
 UniboCGR_ContactType UniboCGR_Contact_get_type(UniboCGR_Contact uniboCgrContact) {
     if (!uniboCgrContact) {
@@ -1634,7 +3655,7 @@ void UniboCGR_Range_set_start_time(UniboCGR uniboCgr,
     UniboCGRSAP* uniboCgrSap = (UniboCGRSAP*) uniboCgr;
     Range* range = (Range*) uniboCgrRange;
 
-    range->fromTime = start_time - uniboCgrSap->reference_time;
+    range->fromTime = start_time - uniboCgrSap->time_base;
 }
 void UniboCGR_Range_set_end_time(UniboCGR uniboCgr,
                                  UniboCGR_Range uniboCgrRange,
@@ -1645,7 +3666,7 @@ void UniboCGR_Range_set_end_time(UniboCGR uniboCgr,
     UniboCGRSAP* uniboCgrSap = (UniboCGRSAP*) uniboCgr;
     Range* range = (Range*) uniboCgrRange;
 
-    range->toTime = end_time - uniboCgrSap->reference_time;
+    range->toTime = end_time - uniboCgrSap->time_base;
 }
 void UniboCGR_Range_set_one_way_light_time(UniboCGR_Range uniboCgrRange,
                                            uint64_t one_way_light_time_seconds) {
@@ -1680,7 +3701,7 @@ time_t UniboCGR_Range_get_start_time(UniboCGR uniboCgr,
     UniboCGRSAP* uniboCgrSap = (UniboCGRSAP*) uniboCgr;
     Range* range = (Range*) uniboCgrRange;
 
-    return range->fromTime + uniboCgrSap->reference_time;
+    return range->fromTime + uniboCgrSap->time_base;
 }
 time_t UniboCGR_Range_get_end_time(UniboCGR uniboCgr,
                                    UniboCGR_Range uniboCgrRange) {
@@ -1690,7 +3711,7 @@ time_t UniboCGR_Range_get_end_time(UniboCGR uniboCgr,
     UniboCGRSAP* uniboCgrSap = (UniboCGRSAP*) uniboCgr;
     Range* range = (Range*) uniboCgrRange;
 
-    return range->toTime + uniboCgrSap->reference_time;
+    return range->toTime + uniboCgrSap->time_base;
 }
 uint64_t UniboCGR_Range_get_one_way_light_time(UniboCGR_Range uniboCgrRange) {
     if (!uniboCgrRange) {
@@ -1945,7 +3966,7 @@ extern UniboCGR_Error  UniboCGR_add_moderate_source_routing_hop(UniboCGR uniboCg
 
     // TODO qua manca tipo contatto
 
-    Contact* contact = get_contact(uniboCgrSap, sender, receiver, start_time - uniboCgrSap->reference_time, NULL);
+    Contact* contact = get_contact(uniboCgrSap, sender, receiver, start_time - uniboCgrSap->time_base, NULL);
 
     if (!contact) return UniboCGR_ErrorContactNotFound;
 
@@ -2010,7 +4031,7 @@ time_t UniboCGR_Route_get_best_case_arrival_time(UniboCGR uniboCgr,
     UniboCGRSAP* uniboCgrSap = (UniboCGRSAP*) uniboCgr;
     Route* route = (Route*) uniboCgrRoute;
 
-    return route->arrivalTime + uniboCgrSap->reference_time;
+    return route->arrivalTime + uniboCgrSap->time_base;
 }
 time_t   UniboCGR_Route_get_eto(UniboCGR uniboCgr, UniboCGR_Route uniboCgrRoute) {
     if (!uniboCgr || !uniboCgrRoute) {
@@ -2019,7 +4040,7 @@ time_t   UniboCGR_Route_get_eto(UniboCGR uniboCgr, UniboCGR_Route uniboCgrRoute)
     UniboCGRSAP* uniboCgrSap = (UniboCGRSAP*) uniboCgr;
     Route* route = (Route*) uniboCgrRoute;
 
-    return route->eto + uniboCgrSap->reference_time;
+    return route->eto + uniboCgrSap->time_base;
 }
 double UniboCGR_Route_get_route_volume_limit(UniboCGR_Route uniboCgrRoute) {
     if (!uniboCgrRoute) {
@@ -2037,7 +4058,7 @@ time_t UniboCGR_Route_get_projected_bundle_arrival_time(UniboCGR uniboCgr,
     UniboCGRSAP* uniboCgrSap = (UniboCGRSAP*) uniboCgr;
     Route* route = (Route*) uniboCgrRoute;
 
-    return route->pbat + uniboCgrSap->reference_time;
+    return route->pbat + uniboCgrSap->time_base;
 }
 time_t UniboCGR_Route_get_best_case_transmission_time(UniboCGR uniboCgr,
                                                       UniboCGR_Route uniboCgrRoute) {
@@ -2047,7 +4068,7 @@ time_t UniboCGR_Route_get_best_case_transmission_time(UniboCGR uniboCgr,
     UniboCGRSAP* uniboCgrSap = (UniboCGRSAP*) uniboCgr;
     Route* route = (Route*) uniboCgrRoute;
 
-    return route->fromTime + uniboCgrSap->reference_time;
+    return route->fromTime + uniboCgrSap->time_base;
 }
 time_t UniboCGR_Route_get_expiration_time(UniboCGR uniboCgr,
                                           UniboCGR_Route uniboCgrRoute) {
@@ -2057,7 +4078,7 @@ time_t UniboCGR_Route_get_expiration_time(UniboCGR uniboCgr,
     UniboCGRSAP* uniboCgrSap = (UniboCGRSAP*) uniboCgr;
     Route* route = (Route*) uniboCgrRoute;
 
-    return route->toTime + uniboCgrSap->reference_time;
+    return route->toTime + uniboCgrSap->time_base;
 }
 uint64_t UniboCGR_Route_get_total_one_way_light_time(UniboCGR_Route uniboCgrRoute) {
     if (!uniboCgrRoute) {
@@ -2128,6 +4149,65 @@ UniboCGR_Error UniboCGR_get_next_route(UniboCGR uniboCgr, UniboCGR_Route* uniboC
 
     return UniboCGR_NoError;
 }
+UniboCGR_Error UniboCGR_route_list_export(UniboCGR uniboCgr,
+                                          UniboCGR_route_list uniboCgrRouteList,
+                                          UniboCGR_FlatRoute* routes,
+                                          uint32_t routesCapacity,
+                                          UniboCGR_FlatHop* hops,
+                                          uint32_t hopsCapacity,
+                                          uint32_t* routesCount,
+                                          uint32_t* hopsCount) {
+    if (!uniboCgr || !routesCount || (!routes && routesCapacity > 0)) return UniboCGR_ErrorInvalidArgument;
+    UniboCGRSAP* uniboCgrSap = (UniboCGRSAP*) uniboCgr;
+    const time_t time_base = uniboCgrSap->time_base;
+    uint32_t route_index = 0;
+    uint32_t hop_index = 0;
+
+    for (ListElt* routeElt = list_get_first_elt((List) uniboCgrRouteList); routeElt != NULL; routeElt = routeElt->next) {
+        Route* route = (Route*) routeElt->data;
+        if (!route) continue;
+
+        if (route_index < routesCapacity) {
+            UniboCGR_FlatRoute* flatRoute = &routes[route_index];
+            flatRoute->neighbor = route->neighbor;
+            flatRoute->best_case_transmission_time = route->fromTime + time_base;
+            flatRoute->expiration_time = route->toTime + time_base;
+            flatRoute->best_case_arrival_time = route->arrivalTime + time_base;
+            flatRoute->eto = route->eto + time_base;
+            flatRoute->projected_bundle_arrival_time = route->pbat + time_base;
+            flatRoute->total_one_way_light_time = route->owltSum;
+            flatRoute->overbooked = (uint64_t) (route->overbooked.gigs * ONE_GIG + route->overbooked.units);
+            flatRoute->committed = (uint64_t) (route->committed.gigs * ONE_GIG + route->committed.units);
+            flatRoute->route_volume_limit = route->routeVolumeLimit;
+            flatRoute->arrival_confidence = route->arrivalConfidence;
+            flatRoute->first_hop = hop_index;
+            flatRoute->hop_count = (uint32_t) list_get_length(route->hops);
+        }
+
+        for (ListElt* hopElt = list_get_first_elt(route->hops); hopElt != NULL; hopElt = hopElt->next) {
+            Contact* contact = (Contact*) hopElt->data;
+            if (hops && hop_index < hopsCapacity) {
+                hops[hop_index].sender = contact->fromNode;
+                hops[hop_index].receiver = contact->toNode;
+                hops[hop_index].start_time = contact->fromTime + time_base;
+            }
+            hop_index++;
+        }
+
+        route_index++;
+    }
+
+    *routesCount = route_index;
+    if (hopsCount) {
+        *hopsCount = hop_index;
+    }
+
+    if (route_index > routesCapacity || (hops && hop_index > hopsCapacity)) {
+        return UniboCGR_ErrorBufferTooSmall;
+    }
+
+    return UniboCGR_NoError;
+}
 UniboCGR_Error UniboCGR_create_excluded_neighbors_list(UniboCGR_excluded_neighbors_list* list) {
     if (!list) { return UniboCGR_ErrorInvalidArgument; }
     *list = (UniboCGR_excluded_neighbors_list) list_create(NULL, NULL, NULL, MDEPOSIT_wrapper);
@@ -2171,12 +4251,34 @@ UniboCGR_Error UniboCGR_add_excluded_neighbor(UniboCGR_excluded_neighbors_list l
     return UniboCGR_NoError;
 }
 int UniboCGRSAP_handle_updates(UniboCGRSAP* uniboCgrSap) {
+    if (uniboCgrSap->feature_contact_horizon && uniboCgrSap->session != UniboCGR_Session_contact_plan) {
+        time_t limit = uniboCgrSap->contact_horizon_limit;
+        if (limit < uniboCgrSap->current_time + uniboCgrSap->contact_horizon) {
+            // twice the horizon: the graph is extended once every horizon
+            limit = uniboCgrSap->current_time + 2 * uniboCgrSap->contact_horizon;
+            if (limit >= MAX_POSIX_TIME) {
+                limit = MAX_POSIX_TIME - 1;
+            }
+            // the routes computed so far ignore the contacts that start between the two limits
+            uniboCgrSap->contact_horizon_limit = limit;
+            uniboCgrSap->mustClearRoutingObjects = true;
+        }
+        // after the contact plan sessions the whole contact plan is in the graph
+        if (limit != get_contacts_horizon(uniboCgrSap)) {
+            if (set_contacts_horizon(uniboCgrSap, limit) < 0) {
+                return -2;
+            }
+            invalidate_local_node_neighbors_list(uniboCgrSap);
+        }
+    }
     if (uniboCgrSap->mustClearRoutingObjects) {
         uniboCgrSap->mustClearRoutingObjects = false;
+        uniboCgrSap->contact_plan_epoch++; // the cached routes are deleted
         reset_NodesTree(uniboCgrSap);
-        if (build_local_node_neighbors_list(uniboCgrSap) < 0) {
-            return -2;
-        }
+    }
+    // no-op if the neighbors list is still valid
+    if (build_local_node_neighbors_list(uniboCgrSap) < 0) {
+        return -2;
     }
     return 0;
 }
@@ -52,6 +52,11 @@ typedef struct RangeSAP RangeSAP;
 typedef struct NodeSAP NodeSAP;
 typedef struct LogSAP LogSAP;
 typedef struct TimeAnalysisSAP TimeAnalysisSAP;
+typedef struct ReservationSAP ReservationSAP;
+typedef struct RouteCacheSAP RouteCacheSAP;
+typedef struct NodeIndexSAP NodeIndexSAP;
+typedef struct Pool Pool;
+typedef struct Arena Arena;
 
 #define MWITHDRAW(size) UniboCGRSAP_MWITHDRAW(__FILE__, __LINE__, size)
 #define MDEPOSIT(addr) UniboCGRSAP_MDEPOSIT(__FILE__, __LINE__, addr)
@@ -70,7 +75,12 @@ extern void* UniboCGRSAP_MWITHDRAW(const char* file, int line, size_t size);
 extern void UniboCGRSAP_MDEPOSIT(const char* file, int line, void* addr);
 
 extern time_t UniboCGRSAP_get_current_time(UniboCGRSAP* uniboCgrSap);
+/**
+ * \brief Unix time point (seconds) of the internal time 0.
+ */
+extern time_t UniboCGRSAP_get_time_base(UniboCGRSAP* uniboCgrSap);
 extern uint64_t UniboCGRSAP_get_local_node(UniboCGRSAP* uniboCgrSap);
+extern uint64_t UniboCGRSAP_get_contact_plan_epoch(UniboCGRSAP* uniboCgrSap);
 extern uint32_t UniboCGRSAP_get_bundle_count(UniboCGRSAP* uniboCgrSap);
 extern void UniboCGRSAP_increase_bundle_count(UniboCGRSAP* uniboCgrSap);
 
@@ -89,11 +99,30 @@ extern int UniboCGRSAP_compute_applicable_backlog(UniboCGRSAP* uniboCgrSap,
                                                   CgrScalar *applicableBacklog,
                                                   CgrScalar *totalBacklog);
 
+/**
+ * \brief The slab pools of the instance, one for each type of fixed-size object.
+ *
+ * \note NULL if the memory pools are disabled (see MEMORY_POOLS in config.h):
+ *       the objects are then allocated one by one with MWITHDRAW.
+ */
+extern Pool* UniboCGRSAP_get_contact_pool(UniboCGRSAP* uniboCgrSap);
+extern Pool* UniboCGRSAP_get_route_pool(UniboCGRSAP* uniboCgrSap);
+extern Pool* UniboCGRSAP_get_list_elt_pool(UniboCGRSAP* uniboCgrSap);
+extern Pool* UniboCGRSAP_get_rbt_node_pool(UniboCGRSAP* uniboCgrSap);
+/**
+ * \brief The scratch arena of the routing call, released by each new call.
+ *
+ * \note NULL if the memory pools are disabled (see MEMORY_POOLS in config.h).
+ */
+extern Arena* UniboCGRSAP_get_scratch_arena(UniboCGRSAP* uniboCgrSap);
+
 extern bool UniboCGRSAP_check_one_route_per_neighbor(UniboCGRSAP* uniboCgrSap, uint32_t* limit);
 extern bool UniboCGRSAP_check_queue_delay(UniboCGRSAP* uniboCgrSap);
 extern bool UniboCGRSAP_check_reactive_anti_loop(UniboCGRSAP* uniboCgrSap);
 extern bool UniboCGRSAP_check_proactive_anti_loop(UniboCGRSAP* uniboCgrSap);
 extern bool UniboCGRSAP_check_moderate_source_routing(UniboCGRSAP* uniboCgrSap);
+extern bool UniboCGRSAP_check_volume_reservations(UniboCGRSAP* uniboCgrSap);
+extern bool UniboCGRSAP_check_route_cache(UniboCGRSAP* uniboCgrSap);
 
 extern void UniboCGRSAP_tweak_one_route_per_neighbor(UniboCGRSAP *uniboCgrSap, bool featureFlag, uint32_t limit);
 
@@ -127,6 +156,15 @@ extern LogSAP* UniboCGRSAP_get_LogSAP(UniboCGRSAP* uniboCgrSap);
 extern void             UniboCGRSAP_set_TimeAnalysisSAP(UniboCGRSAP* uniboCgrSap, TimeAnalysisSAP* timeAnalysisSap);
 extern TimeAnalysisSAP* UniboCGRSAP_get_TimeAnalysisSAP(UniboCGRSAP* uniboCgrSap);
 
+extern void            UniboCGRSAP_set_ReservationSAP(UniboCGRSAP* uniboCgrSap, ReservationSAP* reservationSap);
+extern ReservationSAP* UniboCGRSAP_get_ReservationSAP(UniboCGRSAP* uniboCgrSap);
+
+extern void           UniboCGRSAP_set_RouteCacheSAP(UniboCGRSAP* uniboCgrSap, RouteCacheSAP* routeCacheSap);
+extern RouteCacheSAP* UniboCGRSAP_get_RouteCacheSAP(UniboCGRSAP* uniboCgrSap);
+
+extern void          UniboCGRSAP_set_NodeIndexSAP(UniboCGRSAP* uniboCgrSap, NodeIndexSAP* nodeIndexSap);
+extern NodeIndexSAP* UniboCGRSAP_get_NodeIndexSAP(UniboCGRSAP* uniboCgrSap);
+
 #ifdef __cplusplus
 }
 #endif
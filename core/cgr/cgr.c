@@ -42,10 +42,12 @@
 #include "../contact_plan/contacts/contacts.h"
 #include "../contact_plan/ranges/ranges.h"
 #include "../library/list/list.h"
+#include "../library/pool/pool.h"
 #include "../msr/msr.h"
 #include "../routes/routes.h"
 #include "../time_analysis/time.h"
 #include "../library/log/log.h"
+#include "route_cache.h"
 
 /**
  * \brief Used to keep in one place the data used by Unibo-CGR during a call.
@@ -63,6 +65,23 @@ struct UniboCgrCurrentCallSAP {
 	 * \brief The algorithm used (with success) for the current call (i.e. CGR or MSR).
 	 */
 	RoutingAlgorithm algorithm;
+	/**
+	 * \brief Used during a bundles group call: the candidate routes still viable
+	 *        for the current bundle of the group (phase three input and output).
+	 */
+	List groupRoutes;
+	/**
+	 * \brief The excluded neighbors of the current call: a copy of the list
+	 *        passed by the caller, plus the sender node.
+	 *
+	 * \details The caller's list is never changed, so it can be shared
+	 *          by the bundles of a group or of a batch.
+	 */
+	List excludedNeighbors;
+	/**
+	 * \brief The sender node excluded in the current call (pointed by excludedNeighbors).
+	 */
+	uint64_t excludedSender;
 
 };
 
@@ -249,6 +268,8 @@ RoutingAlgorithm get_last_call_routing_algorithm(UniboCGRSAP* uniboCgrSap) {
  *  DD/MM/YY |  AUTHOR         |   DESCRIPTION
  *  -------- | --------------- | -----------------------------------------------
  *  15/02/20 | L. Persampieri  |  Initial Implementation and documentation.
+ *  18/10/26 | agent           |  Added the bundles group routes list.
+ *  18/10/26 | agent           |  Added the per-call excluded neighbors list.
  *****************************************************************************/
 int UniboCgrCurrentCallSAP_open(UniboCGRSAP *uniboCgrSap)
 {
@@ -259,6 +280,21 @@ int UniboCgrCurrentCallSAP_open(UniboCGRSAP *uniboCgrSap)
     UniboCGRSAP_set_UniboCgrCurrentCallSAP(uniboCgrSap, sap);
     memset(sap, 0, sizeof(UniboCgrCurrentCallSAP));
 
+    sap->groupRoutes = list_create(NULL, NULL, NULL, NULL);
+    if (!sap->groupRoutes) {
+        UniboCgrCurrentCallSAP_close(uniboCgrSap);
+        return -2;
+    }
+
+    // the nodes are borrowed from the caller's list: no delete_data_elt
+    sap->excludedNeighbors = list_create(NULL, NULL, NULL, NULL);
+    if (!sap->excludedNeighbors) {
+        UniboCgrCurrentCallSAP_close(uniboCgrSap);
+        return -2;
+    }
+    // per-call list: its elements are released by reset_cgr()
+    list_set_elt_arena(sap->excludedNeighbors, UniboCGRSAP_get_scratch_arena(uniboCgrSap));
+
     return 0;
 }
 
@@ -280,6 +316,8 @@ int UniboCgrCurrentCallSAP_open(UniboCGRSAP *uniboCgrSap)
  *  DD/MM/YY |  AUTHOR         |   DESCRIPTION
  *  -------- | --------------- | -----------------------------------------------
  *  15/02/20 | L. Persampieri  |  Initial Implementation and documentation.
+ *  18/10/26 | agent           |  Added the bundles group routes list.
+ *  18/10/26 | agent           |  Added the per-call excluded neighbors list.
  *****************************************************************************/
 void UniboCgrCurrentCallSAP_close(UniboCGRSAP* uniboCgrSap)
 {
@@ -291,6 +329,9 @@ void UniboCgrCurrentCallSAP_close(UniboCGRSAP* uniboCgrSap)
         closeBundleFile(&currentCallSap->file_call);
     }
 
+    free_list(currentCallSap->groupRoutes);
+    free_list(currentCallSap->excludedNeighbors);
+
     memset(currentCallSap, 0, sizeof(UniboCgrCurrentCallSAP));
     MDEPOSIT(currentCallSap);
     UniboCGRSAP_set_UniboCgrCurrentCallSAP(uniboCgrSap, NULL);
@@ -390,12 +431,19 @@ static void parse_excluded_nodes(List excludedNodes)
  *  DD/MM/YY |  AUTHOR         |   DESCRIPTION
  *  -------- | --------------- | -----------------------------------------------
  *  15/02/20 | L. Persampieri  |  Initial Implementation and documentation.
+ *  18/10/26 | agent           |  Reset the scratch arena.
+ *  18/10/26 | agent           |  Clear the per-call excluded neighbors list.
  *****************************************************************************/
 static void reset_cgr(UniboCGRSAP* uniboCgrSap)
 {
+	UniboCgrCurrentCallSAP *currentCallSap = UniboCGRSAP_get_UniboCgrCurrentCallSAP(uniboCgrSap);
+
 	reset_phase_one(uniboCgrSap);
 	reset_phase_two(uniboCgrSap);
 	reset_neighbors_temporary_fields(uniboCgrSap);
+	free_list_elts(currentCallSap->excludedNeighbors);
+	// the per-call lists are empty now: release all their elements at once
+	arena_reset(UniboCGRSAP_get_scratch_arena(uniboCgrSap));
 }
 
 /******************************************************************************
@@ -485,9 +533,10 @@ static int is_initialized_terminus_node(Node *terminusNode)
 /******************************************************************************
  *
  * \par Function Name:
- * 		excludeNeighbor
+ * 		excludeNeighbors
  *
- * \brief Insert a neighbor in the excluded neighbors list
+ * \brief Build the excluded neighbors list of the current call: a copy of
+ *        the caller's list plus the sender node.
  *
  *
  * \par Date Written:
@@ -495,86 +544,107 @@ static int is_initialized_terminus_node(Node *terminusNode)
  *
  * \return int
  *
- * \retval    0   Success case: neighbor inserted in the excluded neighbors list
+ * \retval    0   Success case: the per-call list is ready
  * \retval   -2   MWITHDRAW error
  *
- * \param[in]	excludedNeighbors   The excluded neighbors list
- * \param[in]	neighbor            The ipn node of the neighbor that we want to exclude
+ * \param[in]	excludedNeighbors   The excluded neighbors list passed by the caller
+ * \param[in]	neighbor            The ipn node of the sender, 0 to not exclude it
+ * \param[out]	*callExcludedNeighbors  The excluded neighbors list of the current call
  *
  * \warning excludedNeighbors doesn't have to be NULL
  *
+ * \par Notes:
+ *          1.  The caller's list is not changed, so the same list can be shared
+ *              by bundles with different senders (bundles group and batch).
+ *          2.  The per-call list borrows the nodes of the caller's list, which
+ *              must not change until the end of the call.
+ *
  * \par Revision History:
  *
  *  DD/MM/YY |  AUTHOR         |   DESCRIPTION
  *  -------- | --------------- | -----------------------------------------------
  *  15/02/20 | L. Persampieri  |  Initial Implementation and documentation.
+ *  18/10/26 | agent           |  Exclude the sender in a per-call copy of the list.
  *****************************************************************************/
-static int excludeNeighbor(List excludedNeighbors, uint64_t neighbor)
+static int excludeNeighbors(UniboCGRSAP* uniboCgrSap, List excludedNeighbors, uint64_t neighbor, List *callExcludedNeighbors)
 {
-	uint64_t *temp = (uint64_t*) MWITHDRAW(sizeof(uint64_t));
-	int result = -2;
-	if (temp != NULL)
-	{
-		*temp = neighbor;
+	ListElt *elt;
+	UniboCgrCurrentCallSAP *currentCallSap = UniboCGRSAP_get_UniboCgrCurrentCallSAP(uniboCgrSap);
+	List callList = currentCallSap->excludedNeighbors;
 
-		if (neighbor == 0 || list_insert_last(excludedNeighbors, temp) != NULL)
+	*callExcludedNeighbors = callList;
+	free_list_elts(callList);
+
+	for (elt = excludedNeighbors->first; elt != NULL; elt = elt->next)
+	{
+		if (elt->data != NULL && list_insert_last(callList, elt->data) == NULL)
 		{
-			result = 0;
+			return -2;
 		}
-		else
+	}
+
+	if (neighbor != 0)
+	{
+		currentCallSap->excludedSender = neighbor;
+		if (list_insert_last(callList, &(currentCallSap->excludedSender)) == NULL)
 		{
-			MDEPOSIT(temp);
+			return -2;
 		}
 	}
 
-	return result;
+	return 0;
 }
 
 /******************************************************************************
  *
- * \par Function Name: executeCGR
+ * \par Function Name: computeCandidateRoutes
  *
- * \brief Implementation of the CGR, call the 3 phases to choose
- *        the best routes for the forwarding of the bundle.
+ * \brief Call the phases one and two until phase two has enough
+ *        candidate routes for the forwarding of the bundle.
  *
  *
  * \par Date Written:
- * 		15/02/20
+ * 		18/10/26
  *
  * \return int
  *
- * \retval      ">= 0"  Success case: number of best routes found
+ * \retval      ">= 0"  Success case (candidateRoutes may be NULL)
  * \retval         -1   There aren't routes to reach the destination.
  * \retval         -2   MWITHDRAW error
  * \retval         -3   Arguments error (phase one error)
  *
  * \param[in]   *bundle            The bundle that has to be forwarded
- * \param[in]   *terminusNode      The destination Node of the bundel
+ * \param[in]   *terminusNode      The destination Node of the bundle
  * \param[in]   excludedNeighbors  The excluded neighbors list, the nodes to which
  *                                 the bundle hasn't to be forwarded as "first hop"
- * \param[out]  *bestRoutes        If result > 0: the list of best routes, NULL otherwise
+ * \param[out]  *candidateRoutes   The candidate routes list (phase two), or NULL
  *
  * \warning bundle doesn't have to be NULL
  * \warning terminusNode doesn't have to be NULL
  * \warning excludedNeighbors doesn't have to be NULL
- * \warning excludedNeighbor doesn't have to be NULL
+ * \warning candidateRoutes doesn't have to be NULL
  *
  *
  * \par Revision History:
  *
  *  DD/MM/YY |  AUTHOR         |   DESCRIPTION
  *  -------- | --------------- | -----------------------------------------------
- *  15/02/20 | L. Persampieri  |  Initial Implementation and documentation.
+ *  18/10/26 | agent           |  Initial Implementation and documentation (moved from executeCGR).
+ *  18/10/26 | agent           |  Invalidate the cached routes of the destination.
  *****************************************************************************/
-static int executeCGR(UniboCGRSAP* uniboCgrSap, CgrBundle *bundle, Node *terminusNode, List excludedNeighbors,
-                      List *bestRoutes)
+static int computeCandidateRoutes(UniboCGRSAP* uniboCgrSap, CgrBundle *bundle, Node *terminusNode, List excludedNeighbors,
+                                  List *candidateRoutes)
 {
 	int result = 0, stop = 0;
 	uint32_t missingNeighbors = 0;
-	List candidateRoutes = NULL;
 	List subsetComputedRoutes = NULL;
 	RtgObject *rtgObj = terminusNode->routingObject;
 
+	*candidateRoutes = NULL;
+
+	// phases one and two may delete or change the cached routes of this destination
+	route_cache_invalidate_destination(uniboCgrSap, terminusNode->nodeNbr);
+
 	if(get_local_node_neighbors_count(uniboCgrSap) == 0)
 	{
 		// 0 neighbors to reach destination...
@@ -583,7 +653,7 @@ static int executeCGR(UniboCGRSAP* uniboCgrSap, CgrBundle *bundle, Node *terminu
 
 	while (!stop)
 	{
-		result = getCandidateRoutes(uniboCgrSap, terminusNode, bundle, excludedNeighbors, rtgObj->selectedRoutes, &subsetComputedRoutes, &missingNeighbors, &candidateRoutes); //phase two
+		result = getCandidateRoutes(uniboCgrSap, terminusNode, bundle, excludedNeighbors, rtgObj->selectedRoutes, &subsetComputedRoutes, &missingNeighbors, candidateRoutes); //phase two
 
 		if (result != 0 || missingNeighbors == 0)
 		{
@@ -598,7 +668,57 @@ static int executeCGR(UniboCGRSAP* uniboCgrSap, CgrBundle *bundle, Node *terminu
 	}
 
 	print_phase_one_routes(get_file_call(uniboCgrSap), rtgObj->selectedRoutes);
-	print_phase_two_routes(uniboCgrSap, get_file_call(uniboCgrSap), candidateRoutes);
+	print_phase_two_routes(uniboCgrSap, get_file_call(uniboCgrSap), *candidateRoutes);
+
+	return result;
+}
+
+/******************************************************************************
+ *
+ * \par Function Name: executeCGR
+ *
+ * \brief Implementation of the CGR, call the 3 phases to choose
+ *        the best routes for the forwarding of the bundle.
+ *
+ *
+ * \par Date Written:
+ * 		15/02/20
+ *
+ * \return int
+ *
+ * \retval      ">= 0"  Success case: number of best routes found
+ * \retval         -1   There aren't routes to reach the destination.
+ * \retval         -2   MWITHDRAW error
+ * \retval         -3   Arguments error (phase one error)
+ *
+ * \param[in]   *bundle            The bundle that has to be forwarded
+ * \param[in]   *terminusNode      The destination Node of the bundel
+ * \param[in]   excludedNeighbors  The excluded neighbors list, the nodes to which
+ *                                 the bundle hasn't to be forwarded as "first hop"
+ * \param[out]  *bestRoutes        If result > 0: the list of best routes, NULL otherwise
+ *
+ * \warning bundle doesn't have to be NULL
+ * \warning terminusNode doesn't have to be NULL
+ * \warning excludedNeighbors doesn't have to be NULL
+ * \warning excludedNeighbor doesn't have to be NULL
+ *
+ *
+ * \par Revision History:
+ *
+ *  DD/MM/YY |  AUTHOR         |   DESCRIPTION
+ *  -------- | --------------- | -----------------------------------------------
+ *  15/02/20 | L. Persampieri  |  Initial Implementation and documentation.
+ *  18/10/26 | agent           |  Phases one and two moved to computeCandidateRoutes.
+ *****************************************************************************/
+static int executeCGR(UniboCGRSAP* uniboCgrSap, CgrBundle *bundle, Node *terminusNode, List excludedNeighbors,
+                      List *bestRoutes)
+{
+	int result;
+	List candidateRoutes = NULL;
+	RtgObject *rtgObj = terminusNode->routingObject;
+
+	result = computeCandidateRoutes(uniboCgrSap, bundle, terminusNode, excludedNeighbors, &candidateRoutes); //phases one and two
+
 	*bestRoutes = NULL;
 
 	if (result >= 0 && candidateRoutes != NULL && candidateRoutes->length > 0)
@@ -622,6 +742,138 @@ static int executeCGR(UniboCGRSAP* uniboCgrSap, CgrBundle *bundle, Node *terminu
 
 }
 
+/******************************************************************************
+ *
+ * \par Function Name:
+ *  	start_routing_call
+ *
+ * \brief  Prepare the contact graph, the destination node and the excluded
+ *         neighbors list for a routing call, then open the log file of the call.
+ *
+ *
+ * \par Date Written:
+ *  	18/10/26
+ *
+ * \return int
+ *
+ * \retval       0   Success case: terminusNode can be used
+ * \retval      -2   MWITHDRAW error (or routing objects can't be updated)
+ *
+ * \param[in]   *bundle              The bundle that has to be forwarded
+ * \param[in]   excludedNeighbors    The excluded neighbors list passed by the caller
+ * \param[out]  *terminusNode        The destination Node of the bundle
+ * \param[out]  *callExcludedNeighbors  The excluded neighbors list of the call
+ *                                      (the sender node included), see excludeNeighbors
+ *
+ * \par Notes:
+ *          1.  The log file of the call is opened only if the routing objects
+ *              have been updated successfully. The caller must close it.
+ *          2.  The caller's excluded neighbors list is not changed.
+ *
+ *
+ * \par Revision History:
+ *
+ *  DD/MM/YY |  AUTHOR         |   DESCRIPTION
+ *  -------- | --------------- | -----------------------------------------------
+ *  18/10/26 | agent           |  Initial Implementation and documentation (moved from getBestRoutes).
+ *****************************************************************************/
+static int start_routing_call(UniboCGRSAP* uniboCgrSap, CgrBundle *bundle, List excludedNeighbors, Node **terminusNode,
+                              List *callExcludedNeighbors)
+{
+	int result = 0;
+	uint64_t sender = 0;
+	UniboCgrCurrentCallSAP *currentCallSap = UniboCGRSAP_get_UniboCgrCurrentCallSAP(uniboCgrSap);
+
+	*terminusNode = NULL;
+	*callExcludedNeighbors = currentCallSap->excludedNeighbors;
+
+	if (UniboCGRSAP_handle_updates(uniboCgrSap) < 0) {
+		//writeLog(uniboCgrSap, "Need to discard all routes.");
+		verbose_debug_printf("Error...");
+		return -2;
+	}
+
+	removeExpiredContacts(uniboCgrSap);
+	removeExpiredRanges(uniboCgrSap);
+	removeOldNeighbors(uniboCgrSap);
+
+	*terminusNode = add_node(uniboCgrSap, bundle->terminus_node);
+
+	currentCallSap->destinationNode = *terminusNode;
+
+	if(!is_initialized_terminus_node(*terminusNode))
+	{
+		// Some error in the "Node graph" management
+		*terminusNode = NULL;
+	}
+
+	if (UniboCGRSAP_check_reactive_anti_loop(uniboCgrSap)) {
+		result = set_failed_neighbors_list(bundle, UniboCGRSAP_get_local_node(uniboCgrSap));
+	}
+	if (!(RETURN_TO_SENDER(bundle)))
+	{
+		sender = bundle->sender_node;
+	}
+	if (result >= 0)
+	{
+		result = excludeNeighbors(uniboCgrSap, excludedNeighbors, sender, callExcludedNeighbors);
+	}
+	parse_excluded_nodes(*callExcludedNeighbors);
+
+	currentCallSap->file_call = openBundleFile(uniboCgrSap);
+	print_bundle(uniboCgrSap, currentCallSap->file_call, bundle, *callExcludedNeighbors, UniboCGRSAP_get_current_time(uniboCgrSap));
+
+	if (*terminusNode == NULL || result < 0)
+	{
+		result = -2;
+	}
+	else
+	{
+		result = 0;
+	}
+
+	return result;
+}
+
+/******************************************************************************
+ *
+ * \par Function Name:
+ *  	print_result_call
+ *
+ * \brief  Print in the main log file the result of a routing call.
+ *
+ *
+ * \par Date Written:
+ *  	18/10/26
+ *
+ * \return void
+ *
+ * \param[in]   result         The getBestRoutes function result
+ * \param[in]   bestRoutes     The list of best routes
+ *
+ *
+ * \par Revision History:
+ *
+ *  DD/MM/YY |  AUTHOR         |   DESCRIPTION
+ *  -------- | --------------- | -----------------------------------------------
+ *  18/10/26 | agent           |  Initial Implementation and documentation (moved from getBestRoutes).
+ *****************************************************************************/
+static void print_result_call(UniboCGRSAP* uniboCgrSap, int result, List bestRoutes)
+{
+	if(result == -1)
+	{
+		writeLog(uniboCgrSap, "0 routes found to destination.");
+	}
+	else if(result == 0)
+	{
+		writeLog(uniboCgrSap, "Best routes found: 0.");
+	}
+	else if(result > 0)
+	{
+		print_result_cgr(uniboCgrSap, result, bestRoutes);
+	}
+}
+
 /******************************************************************************
  *
  * \par Function Name:
@@ -657,11 +909,16 @@ static int executeCGR(UniboCGRSAP* uniboCgrSap, CgrBundle *bundle, Node *terminu
  *  DD/MM/YY |  AUTHOR         |   DESCRIPTION
  *  -------- | --------------- | -----------------------------------------------
  *  15/02/20 | L. Persampieri  |  Initial Implementation and documentation.
+ *  18/10/26 | agent           |  Call preparation moved to start_routing_call.
+ *  18/10/26 | agent           |  Added the route cache.
+ *  18/10/26 | agent           |  Cache the unreachable destinations too.
+ *  18/10/26 | agent           |  The excluded neighbors list is no longer changed.
  *****************************************************************************/
 int getBestRoutes(UniboCGRSAP* uniboCgrSap, CgrBundle *bundle, List excludedNeighbors, List *bestRoutes)
 {
 	int result = -4;
 	Node *terminusNode;
+	List callExcludedNeighbors = NULL;
 	UniboCgrCurrentCallSAP *currentCallSap = UniboCGRSAP_get_UniboCgrCurrentCallSAP(uniboCgrSap);
     const time_t time = UniboCGRSAP_get_current_time(uniboCgrSap);
 
@@ -686,109 +943,678 @@ int getBestRoutes(UniboCGRSAP* uniboCgrSap, CgrBundle *bundle, List excludedNeig
 		}
 		else
 		{
-
-			result = 0;
-
             reset_cgr(uniboCgrSap);
 
-			bool originalOneRoutePerNeighborFeatureFlag = false;
-			uint32_t originalOneRoutePerNeighborLimit = 1;
+			// the key includes the sender node, excluded by start_routing_call
+			result = route_cache_lookup(uniboCgrSap, bundle, excludedNeighbors, bestRoutes);
 
-			if (IS_CRITICAL(bundle))
+			if (result > 0)
 			{
-				originalOneRoutePerNeighborFeatureFlag = UniboCGRSAP_check_one_route_per_neighbor(uniboCgrSap, &originalOneRoutePerNeighborLimit);
-				UniboCGRSAP_tweak_one_route_per_neighbor(uniboCgrSap, true, 0U);
+				currentCallSap->algorithm = cgr;
+				writeLog(uniboCgrSap, "Route cache hit.");
 			}
-
-            if (UniboCGRSAP_handle_updates(uniboCgrSap) < 0) {
-                //writeLog(uniboCgrSap, "Need to discard all routes.");
-                verbose_debug_printf("Error...");
-                result = -2;
-            }
-
-			if(result == 0)
+			else if (result == -1)
 			{
-                removeExpiredContacts(uniboCgrSap);
-                removeExpiredRanges(uniboCgrSap);
-                removeOldNeighbors(uniboCgrSap);
-
-				terminusNode = add_node(uniboCgrSap, bundle->terminus_node);
-
-				currentCallSap->destinationNode = terminusNode;
+				writeLog(uniboCgrSap, "Route cache hit: destination unreachable.");
+			}
+			else if (result == 0)
+			{
+				bool originalOneRoutePerNeighborFeatureFlag = false;
+				uint32_t originalOneRoutePerNeighborLimit = 1;
 
-				if(!is_initialized_terminus_node(terminusNode))
+				if (IS_CRITICAL(bundle))
 				{
-					// Some error in the "Node graph" management
-					terminusNode = NULL;
+					originalOneRoutePerNeighborFeatureFlag = UniboCGRSAP_check_one_route_per_neighbor(uniboCgrSap, &originalOneRoutePerNeighborLimit);
+					UniboCGRSAP_tweak_one_route_per_neighbor(uniboCgrSap, true, 0U);
 				}
 
-				result = 0;
+				result = start_routing_call(uniboCgrSap, bundle, excludedNeighbors, &terminusNode, &callExcludedNeighbors);
 
-                if (UniboCGRSAP_check_reactive_anti_loop(uniboCgrSap)) {
-                    result = set_failed_neighbors_list(bundle, UniboCGRSAP_get_local_node(uniboCgrSap));
-                }
-				if (result >= 0 && !(RETURN_TO_SENDER(bundle)) && bundle->sender_node != 0)
+				if (result == 0)
 				{
-					result = excludeNeighbor(excludedNeighbors, bundle->sender_node);
+					if (UniboCGRSAP_check_moderate_source_routing(uniboCgrSap)) {
+						result = tryMSR(uniboCgrSap, bundle, callExcludedNeighbors, currentCallSap->file_call, bestRoutes);
+						if(result > 0) {
+							currentCallSap->algorithm = msr;
+						}
+						if (result <= 0 && result != -2) {
+							result = executeCGR(uniboCgrSap, bundle, terminusNode, callExcludedNeighbors, bestRoutes);
+							if(result > 0) {
+								currentCallSap->algorithm = cgr;
+							}
+						}
+					} else {
+						result = executeCGR(uniboCgrSap, bundle, terminusNode, callExcludedNeighbors, bestRoutes);
+						if(result > 0) {
+							currentCallSap->algorithm = cgr;
+						}
+					}
 				}
-				parse_excluded_nodes(excludedNeighbors);
-
-				currentCallSap->file_call = openBundleFile(uniboCgrSap);
-				print_bundle(uniboCgrSap, currentCallSap->file_call, bundle, excludedNeighbors, UniboCGRSAP_get_current_time(uniboCgrSap));
 
-				if (terminusNode != NULL && result >= 0)
+				if (result > 0 && currentCallSap->algorithm == cgr
+						&& route_cache_store(uniboCgrSap, *bestRoutes) < 0)
 				{
-                    if (UniboCGRSAP_check_moderate_source_routing(uniboCgrSap)) {
-                        result = tryMSR(uniboCgrSap, bundle, excludedNeighbors, currentCallSap->file_call, bestRoutes);
-                        if(result > 0) {
-                            currentCallSap->algorithm = msr;
-                        }
-                        if (result <= 0 && result != -2) {
-                            result = executeCGR(uniboCgrSap, bundle, terminusNode, excludedNeighbors, bestRoutes);
-							if(result > 0) {
-                                currentCallSap->algorithm = cgr;
-                            }
-                        }
-                    } else {
-                        result = executeCGR(uniboCgrSap, bundle, terminusNode, excludedNeighbors, bestRoutes);
-						if(result > 0) {
-                            currentCallSap->algorithm = cgr;
-                        }
-                    }
+					result = -2;
 				}
-				else
+				else if (result == -1 && route_cache_store_unreachable(uniboCgrSap, bundle) < 0)
 				{
 					result = -2;
 				}
 
 				closeBundleFile(&(currentCallSap->file_call));
+
+				if (IS_CRITICAL(bundle))
+				{
+					UniboCGRSAP_tweak_one_route_per_neighbor(uniboCgrSap, originalOneRoutePerNeighborFeatureFlag, originalOneRoutePerNeighborLimit);
+				}
+			}
+		}
+
+		print_result_call(uniboCgrSap, result, *bestRoutes);
+	}
+
+	debug_printf("result -> %d", result);
+
+    UniboCGRSAP_increase_bundle_count(uniboCgrSap);
+
+	record_total_core_stop_time(uniboCgrSap);
+
+	return result;
+}
+
+/******************************************************************************
+ *
+ * \par Function Name:
+ *  	same_routing_class
+ *
+ * \brief  Boolean: to know if two bundles can share the phases one and two
+ *         of the same routing call.
+ *
+ *
+ * \par Date Written:
+ *  	18/10/26
+ *
+ * \return int
+ *
+ * \retval   1   The bundles belong to the same routing class
+ * \retval   0   The bundles must be routed separately
+ *
+ * \param[in]   *leader    The first bundle of the group
+ * \param[in]   *bundle    The bundle that we want to add to the group
+ *
+ * \par Notes:
+ *          1.  Two bundles belong to the same class if they have the same destination,
+ *              previous hop, priority, flags and delivery confidence, and the EVC of
+ *              one bundle is at most BUNDLES_GROUP_MAX_EVC_RATIO times the EVC of the other.
+ *          2.  The bundles with a geographic route or an MSR route are never grouped,
+ *              since the anti-loop mechanism and the MSR work on a per-bundle basis.
+ *
+ * \par Revision History:
+ *
+ *  DD/MM/YY |  AUTHOR         |   DESCRIPTION
+ *  -------- | --------------- | -----------------------------------------------
+ *  18/10/26 | agent           |  Initial Implementation and documentation.
+ *****************************************************************************/
+static int same_routing_class(CgrBundle *leader, CgrBundle *bundle)
+{
+	if (leader->terminus_node != bundle->terminus_node
+			|| leader->sender_node != bundle->sender_node
+			|| leader->priority_level != bundle->priority_level
+			|| leader->ordinal != bundle->ordinal
+			|| leader->flags != bundle->flags
+			|| leader->dlvConfidence != bundle->dlvConfidence)
+	{
+		return 0;
+	}
+
+	if (list_get_length(bundle->geoRoute) > 0
+			|| (bundle->msrRoute != NULL && list_get_length(bundle->msrRoute->hops) > 0))
+	{
+		return 0;
+	}
+
+	if (bundle->evc > leader->evc * BUNDLES_GROUP_MAX_EVC_RATIO
+			|| leader->evc > bundle->evc * BUNDLES_GROUP_MAX_EVC_RATIO)
+	{
+		return 0;
+	}
+
+	return 1;
+}
+
+/******************************************************************************
+ *
+ * \par Function Name:
+ *  	chooseGroupBestRoutes
+ *
+ * \brief  Phase three for a bundle of a group: choose the best routes between
+ *         the candidate routes of the group that still have enough volume for the bundle.
+ *
+ *
+ * \par Date Written:
+ *  	18/10/26
+ *
+ * \return int
+ *
+ * \retval  ">= 0"  The number of best routes found
+ * \retval     -2   MWITHDRAW error
+ *
+ * \param[in]   *bundle            The bundle that has to be forwarded
+ * \param[in]   candidateRoutes    The candidate routes of the group (phase two), can be NULL
+ * \param[out]  *bestRoutes        If result > 0: the list of best routes, NULL otherwise
+ *
+ * \par Notes:
+ *          1.  The volume of the best routes is reserved for the bundle (phase three),
+ *              so when the volume of the best route runs out the following bundles
+ *              of the group overflow onto the next-best route.
+ *          2.  The PBAT of each candidate route is computed again for the bundle
+ *              (checkRouteVolume), the other phase two checks are those of the
+ *              representative bundle.
+ *          3.  The best routes list is overwritten at the next call.
+ *
+ * \par Revision History:
+ *
+ *  DD/MM/YY |  AUTHOR         |   DESCRIPTION
+ *  -------- | --------------- | -----------------------------------------------
+ *  18/10/26 | agent           |  Initial Implementation and documentation.
+ *****************************************************************************/
+static int chooseGroupBestRoutes(UniboCGRSAP* uniboCgrSap, CgrBundle *bundle, List candidateRoutes, List *bestRoutes)
+{
+	int result = 0;
+	ListElt *elt;
+	Route *route;
+	UniboCgrCurrentCallSAP *currentCallSap = UniboCGRSAP_get_UniboCgrCurrentCallSAP(uniboCgrSap);
+	List groupRoutes = currentCallSap->groupRoutes;
+
+	*bestRoutes = NULL;
+	free_list_elts(groupRoutes);
+
+	if (candidateRoutes == NULL)
+	{
+		return 0;
+	}
+
+	for (elt = candidateRoutes->first; elt != NULL; elt = elt->next)
+	{
+		route = (Route*) elt->data;
+		if (checkRouteVolume(uniboCgrSap, bundle, route) == 0) //phase two checks for this bundle
+		{
+			if (list_insert_last(groupRoutes, route) == NULL)
+			{
+				return -2;
 			}
+		}
+	}
+
+	if (groupRoutes->length > 0)
+	{
+		record_phases_start_time(uniboCgrSap, phaseThree);
+
+		result = chooseBestRoutes(uniboCgrSap, bundle, groupRoutes); //phase three
+
+		record_phases_stop_time(uniboCgrSap, phaseThree);
 
-			if (IS_CRITICAL(bundle))
+		*bestRoutes = groupRoutes;
+	}
+
+	return result;
+}
+
+/******************************************************************************
+ *
+ * \par Function Name:
+ *  	getBestRoutesGroup
+ *
+ * \brief	 Implementation of the CGR for a group of bundles: get the best routes
+ *           list of each bundle, sharing the phases one and two between all the
+ *           bundles of the same routing class.
+ *
+ *
+ * \par Date Written:
+ *  	18/10/26
+ *
+ * \return int
+ *
+ * \retval         0   Success case: the callback has been called for each bundle
+ * \retval        -2   MWITHDRAW error
+ * \retval        -4   Arguments error
+ *
+ * \param[in]   **bundles            The bundles that have to be forwarded
+ * \param[in]   count                The number of bundles
+ * \param[in]   excludedNeighbors    The excluded neighbors list, the nodes to which
+ *                                   the bundles haven't to be forwarded as "first hop"
+ * \param[in]   callback             Called one time for each bundle with the index of the bundle,
+ *                                   the getBestRoutes-like result and the best routes list.
+ *                                   The list is valid only until the callback returns.
+ * \param[in]   *arg                 Passed to the callback
+ *
+ * \par Notes:
+ *          1.  The group is made up of the bundles that belong to the same routing class
+ *              of the first valid bundle (see same_routing_class). Phases one and two are
+ *              performed only one time, with the lower expiration time and the greater EVC
+ *              between the bundles of the group, so each candidate route is viable for each bundle.
+ *          2.  For each bundle of the group, in order, the PBAT of the candidate routes is
+ *              computed again for the bundle (computePBAT), then phase three reserves
+ *              the volume on the best routes as a single call does. A route without enough
+ *              residual volume is skipped, so the bundle overflows onto the next-best route.
+ *          3.  The bundles out of the group and the bundles of the group without a route
+ *              are routed one by one with getBestRoutes, in order, after all the other
+ *              bundles of the group: the callback is not called in the order of the array.
+ *
+ * \par Revision History:
+ *
+ *  DD/MM/YY |  AUTHOR         |   DESCRIPTION
+ *  -------- | --------------- | -----------------------------------------------
+ *  18/10/26 | agent           |  Initial Implementation and documentation.
+ *****************************************************************************/
+int getBestRoutesGroup(UniboCGRSAP* uniboCgrSap, CgrBundle **bundles, uint32_t count, List excludedNeighbors,
+                       BundlesGroupCallback callback, void *arg)
+{
+	int result = 0, check;
+	uint32_t i, members = 0;
+	unsigned char *pending;
+	CgrBundle *bundle, *leader = NULL;
+	CgrBundle representative;
+	Node *terminusNode = NULL;
+	List candidateRoutes = NULL, bestRoutes = NULL, callExcludedNeighbors = NULL;
+	UniboCgrCurrentCallSAP *currentCallSap = UniboCGRSAP_get_UniboCgrCurrentCallSAP(uniboCgrSap);
+	const time_t time = UniboCGRSAP_get_current_time(uniboCgrSap);
+
+	if (bundles == NULL || count == 0 || excludedNeighbors == NULL || callback == NULL)
+	{
+		return -4;
+	}
+
+	pending = (unsigned char*) MWITHDRAW(count * sizeof(unsigned char));
+	if (pending == NULL)
+	{
+		return -2;
+	}
+
+	for (i = 0; i < count; i++)
+	{
+		bundle = bundles[i];
+		pending[i] = 1;
+
+		if (bundle == NULL || check_bundle(bundle) != 0 || bundle->expiration_time < time)
+		{
+			continue; // getBestRoutes will handle it
+		}
+
+		if (leader == NULL)
+		{
+			leader = bundle;
+			representative = *bundle;
+		}
+
+		if (same_routing_class(leader, bundle))
+		{
+			pending[i] = 0;
+			members++;
+
+			if (bundle->evc > representative.evc)
+			{
+				representative.evc = bundle->evc;
+			}
+			if (bundle->expiration_time < representative.expiration_time)
 			{
-				UniboCGRSAP_tweak_one_route_per_neighbor(uniboCgrSap, originalOneRoutePerNeighborFeatureFlag, originalOneRoutePerNeighborLimit);
+				representative.expiration_time = bundle->expiration_time;
 			}
 		}
+	}
+
+	if (members == 1)
+	{
+		// a group of one bundle: routed by getBestRoutes below
+		for (i = 0; i < count; i++)
+		{
+			pending[i] = 1;
+		}
+	}
+	else if (members > 1)
+	{
+		record_total_core_start_time(uniboCgrSap);
+
+		currentCallSap->algorithm = unknown_algorithm;
+		debug_printf("Call n.: %" PRIu32 " (group of %" PRIu32 " bundles)", UniboCGRSAP_get_bundle_count(uniboCgrSap), members);
+		writeLog(uniboCgrSap, "Bundles group - Destination node number: %" PRIu64 ", bundles: %" PRIu32 ".",
+				leader->terminus_node, members);
+
+		reset_cgr(uniboCgrSap);
+
+		bool originalOneRoutePerNeighborFeatureFlag = false;
+		uint32_t originalOneRoutePerNeighborLimit = 1;
+
+		if (IS_CRITICAL(leader))
+		{
+			originalOneRoutePerNeighborFeatureFlag = UniboCGRSAP_check_one_route_per_neighbor(uniboCgrSap, &originalOneRoutePerNeighborLimit);
+			UniboCGRSAP_tweak_one_route_per_neighbor(uniboCgrSap, true, 0U);
+		}
+
+		check = start_routing_call(uniboCgrSap, &representative, excludedNeighbors, &terminusNode, &callExcludedNeighbors);
+
+		if (check == 0)
+		{
+			check = computeCandidateRoutes(uniboCgrSap, &representative, terminusNode, callExcludedNeighbors, &candidateRoutes); //phases one and two
+		}
 
-		if(result == -1)
+		for (i = 0; i < count; i++)
 		{
-			writeLog(uniboCgrSap, "0 routes found to destination.");
+			if (pending[i])
+			{
+				continue;
+			}
+
+			if (check == -1 || check == -2 || check == -3)
+			{
+				// 0 routes to destination or error: same result for each bundle of the group
+				print_result_call(uniboCgrSap, check, NULL);
+				callback(uniboCgrSap, i, check, NULL, arg);
+				UniboCGRSAP_increase_bundle_count(uniboCgrSap);
+				continue;
+			}
+
+			bundle = bundles[i];
+			result = chooseGroupBestRoutes(uniboCgrSap, bundle, candidateRoutes, &bestRoutes);
+
+			if (result > 0 || result == -2)
+			{
+				if (result > 0)
+				{
+					currentCallSap->algorithm = cgr;
+				}
+				print_phase_three_routes(get_file_call(uniboCgrSap), bestRoutes);
+				print_result_call(uniboCgrSap, result, bestRoutes);
+				callback(uniboCgrSap, i, result, bestRoutes, arg);
+				UniboCGRSAP_increase_bundle_count(uniboCgrSap);
+			}
+			else
+			{
+				// no route with enough volume for this bundle
+				pending[i] = 1;
+			}
 		}
-		else if(result == 0)
+
+		free_list_elts(currentCallSap->groupRoutes);
+
+		if (terminusNode != NULL)
 		{
-			writeLog(uniboCgrSap, "Best routes found: 0.");
+			clear_rtg_object(terminusNode->routingObject); //clear the temporary values
 		}
-		else if(result > 0)
+
+		closeBundleFile(&(currentCallSap->file_call));
+
+		if (IS_CRITICAL(leader))
 		{
-			print_result_cgr(uniboCgrSap, result, *bestRoutes);
+			UniboCGRSAP_tweak_one_route_per_neighbor(uniboCgrSap, originalOneRoutePerNeighborFeatureFlag, originalOneRoutePerNeighborLimit);
 		}
+
+		record_total_core_stop_time(uniboCgrSap);
 	}
 
-	debug_printf("result -> %d", result);
+	result = 0;
 
-    UniboCGRSAP_increase_bundle_count(uniboCgrSap);
+	for (i = 0; i < count; i++)
+	{
+		if (pending[i])
+		{
+			check = getBestRoutes(uniboCgrSap, bundles[i], excludedNeighbors, &bestRoutes);
+			callback(uniboCgrSap, i, check, bestRoutes, arg);
+		}
+	}
 
-	record_total_core_stop_time(uniboCgrSap);
+	MDEPOSIT(pending);
+
+	return result;
+}
+
+/**
+ * \brief A bundle of a batch, with its excluded neighbors list and its position in the batch.
+ */
+typedef struct
+{
+	CgrBundle *bundle;
+	List excludedNeighbors;
+	uint32_t index;
+} BatchSlot;
+
+/**
+ * \brief Used to translate the indexes of a group into the indexes of the batch.
+ */
+typedef struct
+{
+	BatchSlot *slots;
+	BundlesGroupCallback callback;
+	void *arg;
+} BatchContext;
+
+/******************************************************************************
+ *
+ * \par Function Name:
+ *  	compare_batch_slots
+ *
+ * \brief  Compare two bundles of a batch: the bundles of the same routing class
+ *         become contiguous, in the order of the batch.
+ *
+ *
+ * \par Date Written:
+ *  	18/10/26
+ *
+ * \return int
+ *
+ * \retval   0  Same slot
+ * \retval  -1  The first slot goes before the second slot
+ * \retval   1  The first slot goes after the second slot
+ *
+ * \param[in]   *first    The first BatchSlot
+ * \param[in]   *second   The second BatchSlot
+ *
+ * \par Notes:
+ *          1.  Ordered by destination, excluded neighbors list, previous hop, priority,
+ *              ordinal, flags, delivery confidence and position in the batch.
+ *
+ * \par Revision History:
+ *
+ *  DD/MM/YY |  AUTHOR         |   DESCRIPTION
+ *  -------- | --------------- | -----------------------------------------------
+ *  18/10/26 | agent           |  Initial Implementation and documentation.
+ *****************************************************************************/
+static int compare_batch_slots(const void *first, const void *second)
+{
+	const BatchSlot *a = (const BatchSlot*) first;
+	const BatchSlot *b = (const BatchSlot*) second;
+
+	if (a->bundle->terminus_node != b->bundle->terminus_node)
+	{
+		return (a->bundle->terminus_node < b->bundle->terminus_node) ? -1 : 1;
+	}
+	if (a->excludedNeighbors != b->excludedNeighbors)
+	{
+		return ((uintptr_t) a->excludedNeighbors < (uintptr_t) b->excludedNeighbors) ? -1 : 1;
+	}
+	if (a->bundle->sender_node != b->bundle->sender_node)
+	{
+		return (a->bundle->sender_node < b->bundle->sender_node) ? -1 : 1;
+	}
+	if (a->bundle->priority_level != b->bundle->priority_level)
+	{
+		return (a->bundle->priority_level < b->bundle->priority_level) ? -1 : 1;
+	}
+	if (a->bundle->ordinal != b->bundle->ordinal)
+	{
+		return (a->bundle->ordinal < b->bundle->ordinal) ? -1 : 1;
+	}
+	if (a->bundle->flags != b->bundle->flags)
+	{
+		return (a->bundle->flags < b->bundle->flags) ? -1 : 1;
+	}
+	if (a->bundle->dlvConfidence != b->bundle->dlvConfidence)
+	{
+		return (a->bundle->dlvConfidence < b->bundle->dlvConfidence) ? -1 : 1;
+	}
+	if (a->index != b->index)
+	{
+		return (a->index < b->index) ? -1 : 1;
+	}
+
+	return 0;
+}
+
+/******************************************************************************
+ *
+ * \par Function Name:
+ *  	batch_group_callback
+ *
+ * \brief  Forward the result of a bundle of a group to the batch callback,
+ *         with the index of the bundle in the batch.
+ *
+ *
+ * \par Date Written:
+ *  	18/10/26
+ *
+ * \return void
+ *
+ * \param[in]   index        The index of the bundle in the group
+ * \param[in]   result       The getBestRoutes-like result
+ * \param[in]   bestRoutes   The best routes list
+ * \param[in]   *arg         The BatchContext, slots points to the first slot of the group
+ *
+ * \par Revision History:
+ *
+ *  DD/MM/YY |  AUTHOR         |   DESCRIPTION
+ *  -------- | --------------- | -----------------------------------------------
+ *  18/10/26 | agent           |  Initial Implementation and documentation.
+ *****************************************************************************/
+static void batch_group_callback(UniboCGRSAP *uniboCgrSap, uint32_t index, int result, List bestRoutes, void *arg)
+{
+	BatchContext *context = (BatchContext*) arg;
+
+	context->callback(uniboCgrSap, context->slots[index].index, result, bestRoutes, context->arg);
+}
+
+/******************************************************************************
+ *
+ * \par Function Name:
+ *  	getBestRoutesBatch
+ *
+ * \brief	 Implementation of the CGR for a batch of bundles to any destination:
+ *           get the best routes list of each bundle, doing the per-call housekeeping
+ *           only one time and routing together the bundles of the same routing class.
+ *
+ *
+ * \par Date Written:
+ *  	18/10/26
+ *
+ * \return int
+ *
+ * \retval         0   Success case: the callback has been called for each bundle
+ * \retval        -2   MWITHDRAW error (or routing objects can't be updated)
+ * \retval        -4   Arguments error
+ *
+ * \param[in]   **bundles             The bundles that have to be forwarded
+ * \param[in]   *excludedNeighbors    The excluded neighbors list of each bundle
+ *                                    (the same list can be shared by many bundles,
+ *                                    also of different classes: it is not changed)
+ * \param[in]   count                 The number of bundles
+ * \param[in]   callback              Called one time for each bundle with the index of the
+ *                                    bundle in the batch, the getBestRoutes-like result and
+ *                                    the best routes list. The list is valid only until
+ *                                    the callback returns.
+ * \param[in]   *arg                  Passed to the callback
+ *
+ * \par Notes:
+ *          1.  The contact plan updates, the expired contacts/ranges and the old neighbors
+ *              are handled before the first bundle.
+ *          2.  The bundles are sorted by routing class (see compare_batch_slots) and each class
+ *              is routed by getBestRoutesGroup, so the bundles to the same destination share
+ *              the phases one and two. The callback is called class by class; the bundles
+ *              of the same class are routed in the order of the batch.
+ *
+ * \par Revision History:
+ *
+ *  DD/MM/YY |  AUTHOR         |   DESCRIPTION
+ *  -------- | --------------- | -----------------------------------------------
+ *  18/10/26 | agent           |  Initial Implementation and documentation.
+ *****************************************************************************/
+int getBestRoutesBatch(UniboCGRSAP* uniboCgrSap, CgrBundle **bundles, List *excludedNeighbors, uint32_t count,
+                       BundlesGroupCallback callback, void *arg)
+{
+	int result = 0;
+	uint32_t i, first;
+	BatchSlot *slots;
+	CgrBundle **groupBundles;
+	BatchContext context;
+
+	if (bundles == NULL || excludedNeighbors == NULL || count == 0 || callback == NULL)
+	{
+		return -4;
+	}
+
+	for (i = 0; i < count; i++)
+	{
+		if (bundles[i] == NULL || excludedNeighbors[i] == NULL)
+		{
+			return -4;
+		}
+	}
+
+	if (UniboCGRSAP_handle_updates(uniboCgrSap) < 0)
+	{
+		return -2;
+	}
+
+	// once for the whole batch: the next calls find nothing to remove
+	removeExpiredContacts(uniboCgrSap);
+	removeExpiredRanges(uniboCgrSap);
+	removeOldNeighbors(uniboCgrSap);
+
+	slots = (BatchSlot*) MWITHDRAW(count * sizeof(BatchSlot));
+	groupBundles = (CgrBundle**) MWITHDRAW(count * sizeof(CgrBundle*));
+	if (slots == NULL || groupBundles == NULL)
+	{
+		if (slots != NULL) MDEPOSIT(slots);
+		if (groupBundles != NULL) MDEPOSIT(groupBundles);
+		return -2;
+	}
+
+	for (i = 0; i < count; i++)
+	{
+		slots[i].bundle = bundles[i];
+		slots[i].excludedNeighbors = excludedNeighbors[i];
+		slots[i].index = i;
+	}
+
+	qsort(slots, count, sizeof(BatchSlot), compare_batch_slots);
+
+	context.callback = callback;
+	context.arg = arg;
+
+	for (first = 0; first < count && result == 0; first = i)
+	{
+		groupBundles[0] = slots[first].bundle;
+
+		for (i = first + 1; i < count; i++)
+		{
+			if (slots[i].bundle->terminus_node != slots[first].bundle->terminus_node
+					|| slots[i].excludedNeighbors != slots[first].excludedNeighbors
+					|| slots[i].bundle->sender_node != slots[first].bundle->sender_node
+					|| slots[i].bundle->priority_level != slots[first].bundle->priority_level
+					|| slots[i].bundle->ordinal != slots[first].bundle->ordinal
+					|| slots[i].bundle->flags != slots[first].bundle->flags
+					|| slots[i].bundle->dlvConfidence != slots[first].bundle->dlvConfidence)
+			{
+				break;
+			}
+			groupBundles[i - first] = slots[i].bundle;
+		}
+
+		context.slots = slots + first;
+		result = getBestRoutesGroup(uniboCgrSap, groupBundles, i - first, slots[first].excludedNeighbors,
+				batch_group_callback, &context);
+	}
+
+	MDEPOSIT(groupBundles);
+	MDEPOSIT(slots);
 
 	return result;
 }
@@ -50,7 +50,32 @@ typedef enum {
 	msr = 2
 } RoutingAlgorithm;
 
+#ifndef BUNDLES_GROUP_MAX_EVC_RATIO
+/**
+ * \brief   Two bundles are routed in the same group only if the EVC of one bundle
+ *          is at most BUNDLES_GROUP_MAX_EVC_RATIO times the EVC of the other.
+ *
+ * \details The phases one and two of a group are performed with the greater EVC
+ *          of the group, so a great ratio could discard routes viable for the smaller bundles.
+ *
+ * \hideinitializer
+ */
+#define BUNDLES_GROUP_MAX_EVC_RATIO 2
+#endif
+
+/**
+ * \brief Called by getBestRoutesGroup one time for each bundle of the group.
+ *
+ * \details result and bestRoutes have the same meaning of the getBestRoutes ones.
+ *          bestRoutes is valid only until the callback returns.
+ */
+typedef void (*BundlesGroupCallback)(UniboCGRSAP *uniboCgrSap, uint32_t index, int result, List bestRoutes, void *arg);
+
 extern int getBestRoutes(UniboCGRSAP *uniboCgrSap, CgrBundle *bundle, List excludedNeighbors, List *routes);
+extern int getBestRoutesGroup(UniboCGRSAP *uniboCgrSap, CgrBundle **bundles, uint32_t count, List excludedNeighbors,
+                              BundlesGroupCallback callback, void *arg);
+extern int getBestRoutesBatch(UniboCGRSAP *uniboCgrSap, CgrBundle **bundles, List *excludedNeighbors, uint32_t count,
+                              BundlesGroupCallback callback, void *arg);
 extern int UniboCgrCurrentCallSAP_open(UniboCGRSAP *uniboCgrSap);
 extern void UniboCgrCurrentCallSAP_close(UniboCGRSAP *uniboCgrSap);
 extern int64_t get_computed_routes_number(UniboCGRSAP *uniboCgrSap, uint64_t destination);
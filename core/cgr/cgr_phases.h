@@ -171,6 +171,7 @@ extern int PhaseTwoSAP_open(UniboCGRSAP* uniboCgrSap);
 extern void PhaseTwoSAP_close(UniboCGRSAP* uniboCgrSap);
 extern void reset_phase_two(UniboCGRSAP* uniboCgrSap);
 extern int checkRoute(UniboCGRSAP* uniboCgrSap, CgrBundle *bundle, List excludedNeighbors, Route *route);
+extern int checkRouteVolume(UniboCGRSAP* uniboCgrSap, CgrBundle *bundle, Route *route);
 extern int getCandidateRoutes(UniboCGRSAP* uniboCgrSap, Node *terminusNode, CgrBundle *bundle, List excludedNeighbors, List computedRoutes,
                               List *subsetComputedRoutes, uint32_t *missingNeighbors, List *candidateRoutes);
 /*********************************************************************/
@@ -182,6 +183,7 @@ extern void PhaseThreeSAP_close(UniboCGRSAP* uniboCgrSap);
 extern void PhaseThreeSAP_set_cost_function_default(UniboCGRSAP* uniboCgrSap);
 /* ... and here ... */
 extern int chooseBestRoutes(UniboCGRSAP* uniboCgrSap, CgrBundle *bundle, List candidateRoutes);
+extern int update_best_routes_volumes(UniboCGRSAP* uniboCgrSap, CgrBundle *bundle, List bestRoutes);
 /*********************************************************************/
 
 extern void print_phase_one_routes(FILE *file, List computedRoutes);
@@ -36,6 +36,7 @@
 #include "cgr_phases.h"
 #include "../contact_plan/contacts/contacts.h"
 #include "../contact_plan/nodes/nodes.h"
+#include "../contact_plan/nodes/node_index.h"
 #include "../contact_plan/ranges/ranges.h"
 #include "../library/list/list.h"
 #include "../routes/routes.h"
@@ -65,6 +66,18 @@ struct PhaseOneSAP {
 	 *        route (selectedRoutes)
 	 */
 	List excludedNeighbors;
+	/**
+	 * \brief For each node index, how many times the node is in the excludedNeighbors list.
+	 */
+	uint32_t *excludedCount;
+	/**
+	 * \brief The length of excludedCount.
+	 */
+	uint32_t excludedCountCapacity;
+	/**
+	 * \brief Boolean: 1 if some element of excludedCount could be not 0, 0 otherwise.
+	 */
+	int excludedCountDirty;
 	/**
 	 * \brief A trick to exclude only one time the "neighbors" for each CGR's call.
 	 *
@@ -130,6 +143,7 @@ typedef enum
 } SuppressedFlag;
 
 static int computeOneRoutePerNeighbor(UniboCGRSAP* uniboCgrSap, Node *terminusNode, uint32_t missingNeighbors);
+static void clear_excluded_neighbors(PhaseOneSAP* phaseOneSap);
 
 
 /******************************************************************************
@@ -303,9 +317,17 @@ int PhaseOneSAP_open(UniboCGRSAP* uniboCgrSap)
 		return -2;
 	}
     free_list_elts(sap->excludedNeighbors);
+    // per-call list: its elements are released by reset_cgr()
+    list_set_elt_arena(sap->excludedNeighbors, UniboCGRSAP_get_scratch_arena(uniboCgrSap));
     memset(&(sap->graphRoot), 0, sizeof(Contact));
     sap->graphRoot.fromNode = UniboCGRSAP_get_local_node(uniboCgrSap);
     sap->graphRoot.toNode = UniboCGRSAP_get_local_node(uniboCgrSap);
+    sap->graphRoot.fromNodeIndex = intern_node(uniboCgrSap, sap->graphRoot.fromNode);
+    sap->graphRoot.toNodeIndex = sap->graphRoot.fromNodeIndex;
+    if (sap->graphRoot.fromNodeIndex == NO_NODE_INDEX) {
+        PhaseOneSAP_close(uniboCgrSap);
+        return -2;
+    }
     sap->graphRoot.type = TypeScheduled;
     sap->graphRoot.toTime = MAX_POSIX_TIME;
     memset(&(sap->graphRootWork), 0, sizeof(ContactNote));
@@ -341,6 +363,7 @@ void PhaseOneSAP_close(UniboCGRSAP* uniboCgrSap)
 	PhaseOneSAP *sap  = UniboCGRSAP_get_PhaseOneSAP(uniboCgrSap);
     if (!sap) return;
 	free_list(sap->excludedNeighbors);
+    if (sap->excludedCount) MDEPOSIT(sap->excludedCount);
     memset(sap, 0, sizeof(PhaseOneSAP));
     MDEPOSIT(sap);
     UniboCGRSAP_set_PhaseOneSAP(uniboCgrSap, NULL);
@@ -375,7 +398,7 @@ void PhaseOneSAP_close(UniboCGRSAP* uniboCgrSap)
 void reset_phase_one(UniboCGRSAP* uniboCgrSap)
 {
 	PhaseOneSAP *sap = UniboCGRSAP_get_PhaseOneSAP(uniboCgrSap);
-	free_list_elts(sap->excludedNeighbors);
+	clear_excluded_neighbors(sap);
 	sap->alreadyExcluded = 0;
 	sap->knownRoutesUpdated = 0;
 	sap->graphCleaned = 0;
@@ -469,7 +492,7 @@ static void clear_work_areas(UniboCGRSAP* uniboCgrSap, ClearRule rule)
  * \retval 	1	The neighbor is included in the excludedNeighbors list
  * \retval 	0	The neighbor isn't included in the excludedNeighbors list
  *
- * \param[in]	neighbor  The ipn node number of the neighbor
+ * \param[in]	neighbor  The node index of the neighbor
  *
  * \warning excludedNeighbors doesn't have to be NULL.
  *
@@ -479,27 +502,11 @@ static void clear_work_areas(UniboCGRSAP* uniboCgrSap, ClearRule rule)
  *  DD/MM/YY | AUTHOR          |   DESCRIPTION
  *  -------- | --------------- |  -----------------------------------------------
  *  30/01/20 | L. Persampieri  |   Initial Implementation and documentation.
+ *  18/10/26 | agent           |   Look at excludedCount instead of scanning the list.
  *****************************************************************************/
-static int neighbor_is_excluded(PhaseOneSAP* phaseOneSap, uint64_t neighbor)
+static int neighbor_is_excluded(PhaseOneSAP* phaseOneSap, uint32_t neighbor)
 {
-	int result = 0;
-	ListElt *elt;
-	uint64_t *current;
-
-	for (elt = phaseOneSap->excludedNeighbors->first; elt != NULL && result == 0; elt = elt->next)
-	{
-		if (elt->data != NULL)
-		{
-			current = (uint64_t*) elt->data;
-			if (*current == neighbor)
-			{
-				result = 1;
-			}
-		}
-	}
-
-	return result;
-
+	return (neighbor < phaseOneSap->excludedCountCapacity && phaseOneSap->excludedCount[neighbor] > 0);
 }
 
 /******************************************************************************
@@ -531,15 +538,25 @@ static int neighbor_is_excluded(PhaseOneSAP* phaseOneSap, uint64_t neighbor)
  *  DD/MM/YY | AUTHOR          |   DESCRIPTION
  *  -------- | --------------- |  -----------------------------------------------
  *  30/01/20 | L. Persampieri  |   Initial Implementation and documentation.
+ *  18/10/26 | agent           |   Count the neighbor in excludedCount.
  *****************************************************************************/
-static int exclude_current_neighbor(PhaseOneSAP* phaseOneSap, Route *route)
+static int exclude_current_neighbor(UniboCGRSAP* uniboCgrSap, PhaseOneSAP* phaseOneSap, Route *route)
 {
 	int result = -1;
+	uint32_t index;
 
 	if(route != NULL)
 	{
-		if (list_insert_first(phaseOneSap->excludedNeighbors, &(route->neighbor)) != NULL)
+		index = get_node_index(uniboCgrSap, route->neighbor);
+		if (grow_node_indexed_array((void**) &(phaseOneSap->excludedCount), &(phaseOneSap->excludedCountCapacity),
+				sizeof(uint32_t), index + 1) < 0)
+		{
+			result = -2;
+		}
+		else if (list_insert_first(phaseOneSap->excludedNeighbors, &(route->neighbor)) != NULL)
 		{
+			phaseOneSap->excludedCount[index]++;
+			phaseOneSap->excludedCountDirty = 1;
 			result = 0;
 		}
 		else
@@ -551,6 +568,40 @@ static int exclude_current_neighbor(PhaseOneSAP* phaseOneSap, Route *route)
 	return result;
 }
 
+/******************************************************************************
+ *
+ * \par Function Name:
+ * 		clear_excluded_neighbors
+ *
+ * \brief Delete all the elements of the excludedNeighbors list.
+ *
+ *
+ * \par Date Written:
+ * 		18/10/26
+ *
+ * \return void
+ *
+ * \par Notes:
+ * 			1.	The list elements point to the neighbor field of routes that
+ * 				could be already deallocated, so excludedCount is zeroed all at once.
+ *
+ * \par Revision History:
+ *
+ *  DD/MM/YY | AUTHOR          |   DESCRIPTION
+ *  -------- | --------------- |  -----------------------------------------------
+ *  18/10/26 | agent           |   Initial Implementation and documentation.
+ *****************************************************************************/
+static void clear_excluded_neighbors(PhaseOneSAP* phaseOneSap)
+{
+	free_list_elts(phaseOneSap->excludedNeighbors);
+
+	if (phaseOneSap->excludedCountDirty)
+	{
+		memset(phaseOneSap->excludedCount, 0, sizeof(uint32_t) * phaseOneSap->excludedCountCapacity);
+		phaseOneSap->excludedCountDirty = 0;
+	}
+}
+
 /******************************************************************************
  *
  * \par Function Name:
@@ -580,7 +631,7 @@ static int exclude_current_neighbor(PhaseOneSAP* phaseOneSap, Route *route)
  *  -------- | --------------- |  -----------------------------------------------
  *  30/01/20 | L. Persampieri  |   Initial Implementation and documentation.
  *****************************************************************************/
-static int exclude_all_neighbors_from_computed_routes(PhaseOneSAP* phaseOneSap, List computedRoutes)
+static int exclude_all_neighbors_from_computed_routes(UniboCGRSAP* uniboCgrSap, PhaseOneSAP* phaseOneSap, List computedRoutes)
 {
 	int stop = 0, result = 0;
 	Route *route;
@@ -590,9 +641,9 @@ static int exclude_all_neighbors_from_computed_routes(PhaseOneSAP* phaseOneSap,
 	{
 		result++; //count the routes added by the add_route
 		route = (Route*) elt->data;
-		if (!neighbor_is_excluded(phaseOneSap, route->neighbor))
+		if (!neighbor_is_excluded(phaseOneSap, get_node_index(uniboCgrSap, route->neighbor)))
 		{
-			if (exclude_current_neighbor(phaseOneSap, route) < 0)
+			if (exclude_current_neighbor(uniboCgrSap, phaseOneSap, route) < 0)
 			{
 				result = -2;
 				stop = 1;
@@ -603,6 +654,70 @@ static int exclude_all_neighbors_from_computed_routes(PhaseOneSAP* phaseOneSap,
 	return result;
 }
 
+/******************************************************************************
+ *
+ * \par Function Name:
+ * 		get_validity_horizon
+ *
+ * \brief Get the last time for which the route keeps the same best-case
+ *        arrival time and the same owltSum.
+ *
+ *
+ * \par Date Written:
+ * 		18/10/26
+ *
+ * \return time_t
+ *
+ * \retval time_t  The validity horizon of the route
+ *
+ * \param[in]  *route        The route for which we want to get the horizon
+ *
+ * \warning route doesn't have to be NULL.
+ * \warning The ContactNote's owlt of each hop must be up to date.
+ *
+ * \par Notes:
+ *          1.  The best-case arrival time is max(t + O(1..n), max_k(from(k) + O(k..n))),
+ *              where t is the current time and O(i..j) the sum of the owlt (with margin)
+ *              from hop i to hop j. It doesn't depend on t while
+ *              t <= max_k(from(k) - O(1..k-1)).
+ *          2.  The hop k can still be used while t + O(1..k-1) <= to(k).
+ *
+ * \par Revision History:
+ *
+ *  DD/MM/YY | AUTHOR          |   DESCRIPTION
+ *  -------- | --------------- |  -----------------------------------------------
+ *  18/10/26 | agent           |   Initial Implementation and documentation.
+ *****************************************************************************/
+static time_t get_validity_horizon(Route *route)
+{
+	ListElt *elt;
+	Contact *contact;
+	uint64_t owlt, owltBefore = 0;
+	time_t latestStart = 0, earliestEnd = MAX_POSIX_TIME;
+	int first = 1;
+
+	for (elt = route->hops->first; elt != NULL; elt = elt->next)
+	{
+		contact = (Contact*) elt->data;
+
+		if (first || contact->fromTime - (time_t) owltBefore > latestStart)
+		{
+			latestStart = contact->fromTime - (time_t) owltBefore;
+			first = 0;
+		}
+		if (contact->toTime - (time_t) owltBefore < earliestEnd)
+		{
+			earliestEnd = contact->toTime - (time_t) owltBefore;
+		}
+
+		owlt = contact->routingObject->owlt;
+		owlt += ((MAX_SPEED_MPH / 3600) * owlt) / 186282;
+		owltBefore += owlt;
+	}
+
+	return (latestStart < earliestEnd) ? latestStart : earliestEnd;
+}
+
 /******************************************************************************
  *
  * \par Function Name:
@@ -638,6 +753,7 @@ static int exclude_all_neighbors_from_computed_routes(PhaseOneSAP* phaseOneSap,
  * 				-	fromTime
  * 				-	toTime
  * 				-	computedAtTime
+ * 				-	validUntil
  * 				-	rootOfSpur
  *
  *
@@ -646,6 +762,7 @@ static int exclude_all_neighbors_from_computed_routes(PhaseOneSAP* phaseOneSap,
  *  DD/MM/YY | AUTHOR          |   DESCRIPTION
  *  -------- | --------------- |  -----------------------------------------------
  *  30/01/20 | L. Persampieri  |   Initial Implementation and documentation.
+ *  18/10/26 | agent           |   Set the validity horizon of the route.
  *****************************************************************************/
 static int populate_route(PhaseOneSAP *sap, time_t current_time, Contact *finalContact, Contact *rootContact, Route *resultRoute)
 {
@@ -686,7 +803,7 @@ static int populate_route(PhaseOneSAP *sap, time_t current_time, Contact *finalC
 				resultRoute->rootOfSpur = elt;
 			}
 
-			elt = list_insert_last(contact->citations, elt);
+			elt = insert_contact_citation(contact, elt);
 
 			if (elt == NULL)
 			{
@@ -706,6 +823,7 @@ static int populate_route(PhaseOneSAP *sap, time_t current_time, Contact *finalC
 		resultRoute->neighbor = firstContact->toNode;
 		resultRoute->fromTime = firstContact->fromTime;
 		resultRoute->toTime = earliestEndTime;
+		resultRoute->validUntil = get_validity_horizon(resultRoute);
 	}
 
 	return result;
@@ -823,6 +941,7 @@ static int compare_dijkstra_edges(ContactNote *first, ContactNote *second)
  *  DD/MM/YY | AUTHOR          |   DESCRIPTION
  *  -------- | --------------- |  -----------------------------------------------
  *  30/01/20 | L. Persampieri  |   Initial Implementation and documentation.
+ *  18/10/26 | agent           |   Compare the node indexes.
  *****************************************************************************/
 static void compute_new_distances(UniboCGRSAP *uniboCgrSap, time_t current_time, Contact *current)
 {
@@ -840,11 +959,11 @@ static void compute_new_distances(UniboCGRSAP *uniboCgrSap, time_t current_time,
 	for (contact = get_first_contact_from_node(uniboCgrSap, current->toNode, &rbtNode); contact != NULL;
 			contact = get_next_contact(&rbtNode))
 	{
-		if (contact->fromNode != current->toNode)
+		if (contact->fromNodeIndex != current->toNodeIndex)
 		{
 			rbtNode = NULL; //I leave the loop
 		}
-		else if ((contact->toNode != current->fromNode && contact->fromNode != contact->toNode)
+		else if ((contact->toNodeIndex != current->fromNodeIndex && contact->fromNodeIndex != contact->toNodeIndex)
 				|| (current == &(phaseOneSap->graphRoot)))
 		{
 			//don't route back and permits loopback
@@ -870,7 +989,7 @@ static void compute_new_distances(UniboCGRSAP *uniboCgrSap, time_t current_time,
 					{
 						earliestTransmissionTime = current_time;
 					}
-					if (neighbor_is_excluded(phaseOneSap, contact->toNode))
+					if (neighbor_is_excluded(phaseOneSap, contact->toNodeIndex))
 					{
 						//helpful for "one route per neighbor"
 						work->suppressed = DijkstraSuppressed;
@@ -927,7 +1046,7 @@ static void compute_new_distances(UniboCGRSAP *uniboCgrSap, time_t current_time,
 						tempWork.arrivalConfidence = contact->confidence
 								* currentWork->arrivalConfidence;
 
-						if (contact->toNode != contact->fromNode)
+						if (contact->toNodeIndex != contact->fromNodeIndex)
 						{
 							tempWork.hopCount += 1;
 						}
@@ -1134,6 +1253,7 @@ static int dijkstra_search(UniboCGRSAP* uniboCgrSap, Contact *rootContact, uint6
  *  DD/MM/YY | AUTHOR          |   DESCRIPTION
  *  -------- | --------------- |  -----------------------------------------------
  *  30/01/20 | L. Persampieri  |   Initial Implementation and documentation.
+ *  18/10/26 | agent           |   Set the validity horizon of the route.
  *****************************************************************************/
 static int update_cost_values(UniboCGRSAP* uniboCgrSap, time_t current_time, Route *route)
 {
@@ -1200,6 +1320,7 @@ static int update_cost_values(UniboCGRSAP* uniboCgrSap, time_t current_time, Rou
 	{
 		route->arrivalTime = arrivalTime;
 		route->owltSum = owltSum;
+		route->validUntil = get_validity_horizon(route);
 	}
 
 	return result;
@@ -1794,6 +1915,7 @@ static int compute_all_spurs(UniboCGRSAP* uniboCgrSap, Route *fromRoute, Node *t
 	RtgObject *rtgObj = NULL;
 	uint64_t *current = NULL;
 	ListElt *foundElt = NULL;
+	uint32_t foundIndex = NO_NODE_INDEX;
 	int otherNeighbor = 0;
 	PhaseOneSAP *phaseOneSap = UniboCGRSAP_get_PhaseOneSAP(uniboCgrSap);
 	time_t current_time = UniboCGRSAP_get_current_time(uniboCgrSap);
@@ -1816,6 +1938,8 @@ static int compute_all_spurs(UniboCGRSAP* uniboCgrSap, Route *fromRoute, Node *t
 				//remove temporarily the neighbor from the excluded list
 				foundElt = elt;
 				elt->data = NULL;
+				foundIndex = get_node_index(uniboCgrSap, fromRoute->neighbor);
+				phaseOneSap->excludedCount[foundIndex]--;
 				stop = 1;
 			}
 		}
@@ -1837,7 +1961,7 @@ static int compute_all_spurs(UniboCGRSAP* uniboCgrSap, Route *fromRoute, Node *t
 	{
 		if (!created)
 		{
-			last_computed_route = create_cgr_route();
+			last_computed_route = create_cgr_route(uniboCgrSap);
 			created = 1;
 		}
 		if (last_computed_route == NULL)
@@ -1880,7 +2004,7 @@ static int compute_all_spurs(UniboCGRSAP* uniboCgrSap, Route *fromRoute, Node *t
                         {
                             debug_printf("Discovered route from new neighbor (%" PRIu64 ").", last_computed_route->neighbor);
                             otherNeighbor = 1;
-                            if (exclude_current_neighbor(phaseOneSap, last_computed_route) < 0)
+                            if (exclude_current_neighbor(uniboCgrSap, phaseOneSap, last_computed_route) < 0)
                             {
                                 result = -2;
                                 stop = 1;
@@ -1946,6 +2070,7 @@ static int compute_all_spurs(UniboCGRSAP* uniboCgrSap, Route *fromRoute, Node *t
 	{
 		//re-include the neighbor in the excluded list
 		foundElt->data = current;
+		phaseOneSap->excludedCount[foundIndex]++;
 	}
 
 	return result;
@@ -2086,6 +2211,8 @@ static int compute_another_route(UniboCGRSAP* uniboCgrSap, Route *fromRoute, Nod
  * \par Notes:
  *             1.  This function will updated the values of the previously
  *                 computed routes in knownRoutes. Previously == computed time < current time
+ *             2.  A route is not updated while the current time is inside
+ *                 its validity horizon (Route's validUntil field).
  *
  *
  *
@@ -2094,6 +2221,7 @@ static int compute_another_route(UniboCGRSAP* uniboCgrSap, Route *fromRoute, Nod
  *  DD/MM/YY | AUTHOR          |   DESCRIPTION
  *  -------- | --------------- |  -----------------------------------------------
  *  30/01/20 | L. Persampieri  |   Initial Implementation and documentation.
+ *  18/10/26 | agent           |   Skip the routes still inside their validity horizon.
  *****************************************************************************/
 static int computeOtherRoutes(UniboCGRSAP* uniboCgrSap, Node *terminusNode, List subsetComputedRoutes, uint32_t missingNeighbors)
 {
@@ -2117,7 +2245,8 @@ static int computeOtherRoutes(UniboCGRSAP* uniboCgrSap, Node *terminusNode, List
 		{
 			next = elt->next;
 			currentRoute = (Route*) elt->data;
-			if (currentRoute->computedAtTime != current_time)
+			// values still valid until the route's validity horizon
+			if (currentRoute->computedAtTime != current_time && current_time > currentRoute->validUntil)
 			{
 				update_cost_values(uniboCgrSap, current_time, currentRoute);
 			}
@@ -2131,7 +2260,7 @@ static int computeOtherRoutes(UniboCGRSAP* uniboCgrSap, Node *terminusNode, List
     if (one_route_per_neighbor_limit != 1) {
         if (!phaseOneSap->alreadyExcluded)
         {
-            if(exclude_all_neighbors_from_computed_routes(phaseOneSap, rtgObj->selectedRoutes) < 0)
+            if(exclude_all_neighbors_from_computed_routes(uniboCgrSap, phaseOneSap, rtgObj->selectedRoutes) < 0)
             {
                 result = -2;
             }
@@ -2181,7 +2310,7 @@ static int computeOtherRoutes(UniboCGRSAP* uniboCgrSap, Node *terminusNode, List
 
 			if(updateNeighbors)
 			{
-				exclude_all_neighbors_from_computed_routes(phaseOneSap, rtgObj->selectedRoutes);
+				exclude_all_neighbors_from_computed_routes(uniboCgrSap, phaseOneSap, rtgObj->selectedRoutes);
 			}
 		}
 
@@ -2254,7 +2383,7 @@ static int computeOneRoutePerNeighbor(UniboCGRSAP* uniboCgrSap, Node *terminusNo
 	// for which we already have a route and set alreadyExcluded to 1
 	if(!(phaseOneSap->alreadyExcluded))
 	{
-		result = exclude_all_neighbors_from_computed_routes(phaseOneSap, rtgObj->selectedRoutes);
+		result = exclude_all_neighbors_from_computed_routes(uniboCgrSap, phaseOneSap, rtgObj->selectedRoutes);
 
 		if(result < 0)
 		{
@@ -2290,7 +2419,7 @@ static int computeOneRoutePerNeighbor(UniboCGRSAP* uniboCgrSap, Node *terminusNo
 	{
 		while (!stop)
 		{
-			route = create_cgr_route();
+			route = create_cgr_route(uniboCgrSap);
 			if (route != NULL)
 			{
 				clear_work_areas(uniboCgrSap, rule);
@@ -2313,7 +2442,7 @@ static int computeOneRoutePerNeighbor(UniboCGRSAP* uniboCgrSap, Node *terminusNo
 							stop = 1;
 						}
 						// Necessarily a new neighbor
-						if (exclude_current_neighbor(phaseOneSap, route) < 0)
+						if (exclude_current_neighbor(uniboCgrSap, phaseOneSap, route) < 0)
 						{
 							result = -2;
 							stop = 1; //I leave the loop
@@ -2358,7 +2487,7 @@ static int computeOneRoutePerNeighbor(UniboCGRSAP* uniboCgrSap, Node *terminusNo
 	}
 
     if (one_route_per_neighbor_limit == 1) {
-        free_list_elts(phaseOneSap->excludedNeighbors);
+        clear_excluded_neighbors(phaseOneSap);
     }
 
 	return result;
@@ -2527,7 +2656,7 @@ static void print_phase_one_route(FILE *file, Route *route, unsigned int num)
 				{
 					contact = (Contact*) elt->data;
 					fprintf(file,
-							"%-15" PRIu64 " %-15" PRIu64 " %-15ld %-15ld %-15" PRIu64 " %-10.2f%-5s %-15g %-15g %g\n",
+							"%-15" PRIu64 " %-15" PRIu64 " %-15ld %-15ld %-15" PRIu64 " %-10.2f%-5s %-15" PRId64 " %-15" PRId64 " %" PRId64 "\n",
 							contact->fromNode, contact->toNode, (long int) contact->fromTime,
 							(long int) contact->toTime, contact->xmitRate, contact->confidence,
 							(elt == route->rootOfSpur) ? " x" : "", contact->mtv[0],
@@ -32,9 +32,11 @@
 
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 
 #include "cgr_phases.h"
 #include "../contact_plan/contacts/contacts.h"
+#include "../contact_plan/reservations/reservations.h"
 #include "../library/list/list.h"
 #include "../routes/routes.h"
 
@@ -48,11 +50,66 @@ static int best_route_cost_function(UniboCGRSAP* uniboCgrSap, void *first, void
 /* ... and here ... */
 
 
+/**
+ * \brief Bits used for a time in the packed sort key (enough for any relative or Unix time).
+ */
+#define SORT_KEY_TIME_BITS 40
+/**
+ * \brief Bits used for the hops number and the owltSum in the packed sort key.
+ */
+#define SORT_KEY_SMALL_BITS 24
+
+/**
+ * \brief Packed sort key of a candidate route: the lower the better.
+ *
+ * \details The fields are compared in order and give the same order
+ *          of best_route_cost_function, so that we compare integers
+ *          instead of following the whole chain of criteria for each pair of routes.
+ */
+typedef struct {
+    /**
+     * \brief checkValue (anti-loop enabled) or PBAT followed by hops number.
+     */
+    uint64_t major;
+    /**
+     * \brief Inverted toTime (later is better) followed by owltSum.
+     */
+    uint64_t minor;
+    /**
+     * \brief The neighbor, last tie-breaker.
+     */
+    uint64_t neighbor;
+} RouteSortKey;
+
+/**
+ * \brief Slot of the best route per neighbor table (open addressing).
+ */
+typedef struct {
+    /**
+     * \brief The element of the candidate routes list that keeps the best route
+     *        found to the neighbor. NULL for an empty slot.
+     */
+    ListElt *elt;
+    /**
+     * \brief The sort key of the best route.
+     */
+    RouteSortKey key;
+} NeighborBestRoute;
+
 /**
  * \brief Private data for phase three.
  */
 struct PhaseThreeSAP {
     getBestRouteFn costFunction;
+    /**
+     * \brief Best route per neighbor table, used for critical bundles.
+     *        The size is always a power of 2.
+     */
+    NeighborBestRoute *bestPerNeighbor;
+    /**
+     * \brief The number of slots of bestPerNeighbor.
+     */
+    uint32_t bestPerNeighborSize;
 };
 
 /******************************************************************************
@@ -105,10 +162,14 @@ int PhaseThreeSAP_open(UniboCGRSAP* uniboCgrSap) {
  *  DD/MM/YY | AUTHOR          |   DESCRIPTION
  *  -------- | --------------- |  -----------------------------------------------
  *  21/10/22 | L. Persampieri  |   Initial Implementation and documentation.
+ *  18/10/26 | agent           |   Deallocate the best route per neighbor table.
  *****************************************************************************/
 void PhaseThreeSAP_close(UniboCGRSAP* uniboCgrSap) {
     PhaseThreeSAP* sap = UniboCGRSAP_get_PhaseThreeSAP(uniboCgrSap);
     if (!sap) return;
+    if (sap->bestPerNeighbor) {
+        MDEPOSIT(sap->bestPerNeighbor);
+    }
     memset(sap, 0, sizeof(PhaseThreeSAP));
     MDEPOSIT(sap);
     UniboCGRSAP_set_PhaseThreeSAP(uniboCgrSap, NULL);
@@ -224,6 +285,194 @@ static int best_route_cost_function(UniboCGRSAP* uniboCgrSap, void *first, void
 	return result;
 }
 
+/******************************************************************************
+ *
+ * \par Function Name:
+ * 		clamp_sort_key_field
+ *
+ * \brief Clamp a value to the interval [0, 2^bits - 1]
+ *
+ *
+ * \par Date Written:
+ * 		18/10/26
+ *
+ * \return uint64_t
+ *
+ * \param[in]	value    The value to clamp
+ * \param[in]	bits     The bits available for the value in the sort key
+ *
+ * \par Revision History:
+ *
+ *  DD/MM/YY |  AUTHOR         |   DESCRIPTION
+ *  -------- | --------------- | -----------------------------------------------
+ *  18/10/26 | agent           |  Initial Implementation and documentation.
+ *****************************************************************************/
+static uint64_t clamp_sort_key_field(int64_t value, unsigned int bits)
+{
+	const uint64_t max = (((uint64_t) 1) << bits) - 1;
+
+	if (value < 0)
+	{
+		return 0;
+	}
+	if ((uint64_t) value > max)
+	{
+		return max;
+	}
+
+	return (uint64_t) value;
+}
+
+/******************************************************************************
+ *
+ * \par Function Name:
+ * 		compute_sort_key
+ *
+ * \brief Compute the packed sort key of a candidate route
+ *
+ *
+ * \par Date Written:
+ * 		18/10/26
+ *
+ * \return void
+ *
+ * \param[in]	*route     The candidate route
+ * \param[out]	*key       The sort key of the route
+ *
+ * \par Notes:
+ *          1.  The key follows the same criteria of best_route_cost_function:
+ *              - anti-loop enabled: checkValue
+ *              - otherwise: pbat, hops number, toTime (later is better), owltSum, neighbor
+ *
+ * \par Revision History:
+ *
+ *  DD/MM/YY |  AUTHOR         |   DESCRIPTION
+ *  -------- | --------------- | -----------------------------------------------
+ *  18/10/26 | agent           |  Initial Implementation and documentation.
+ *****************************************************************************/
+static void compute_sort_key(UniboCGRSAP* uniboCgrSap, Route *route, RouteSortKey *key)
+{
+	const uint64_t maxTime = (((uint64_t) 1) << SORT_KEY_TIME_BITS) - 1;
+
+	if (UniboCGRSAP_check_reactive_anti_loop(uniboCgrSap) || UniboCGRSAP_check_proactive_anti_loop(uniboCgrSap))
+	{
+		key->major = clamp_sort_key_field(route->checkValue, 32);
+		key->minor = 0;
+		key->neighbor = 0;
+	}
+	else
+	{
+		key->major = (clamp_sort_key_field(route->pbat, SORT_KEY_TIME_BITS) << SORT_KEY_SMALL_BITS)
+				| clamp_sort_key_field((int64_t) route->hops->length, SORT_KEY_SMALL_BITS);
+		key->minor = ((maxTime - clamp_sort_key_field(route->toTime, SORT_KEY_TIME_BITS)) << SORT_KEY_SMALL_BITS)
+				| clamp_sort_key_field((int64_t) (route->owltSum > INT64_MAX ? INT64_MAX : route->owltSum), SORT_KEY_SMALL_BITS);
+		key->neighbor = route->neighbor;
+	}
+}
+
+/******************************************************************************
+ *
+ * \par Function Name:
+ * 		is_better_key
+ *
+ * \brief Boolean: to know if the first key identifies a better route than the second one
+ *
+ *
+ * \par Date Written:
+ * 		18/10/26
+ *
+ * \return int
+ *
+ * \retval   1   The first route is better than the second one
+ * \retval   0   Otherwise
+ *
+ * \param[in]	*first           The sort key of the first route
+ * \param[in]	*second          The sort key of the second route
+ * \param[in]	tieToFirst       Set to 1 if the first route wins when the keys are equal
+ *
+ * \par Notes:
+ *          1.  With anti-loop enabled best_route_cost_function considers the first route better
+ *              when the checkValues are equal: tieToFirst keeps that behaviour.
+ *
+ * \par Revision History:
+ *
+ *  DD/MM/YY |  AUTHOR         |   DESCRIPTION
+ *  -------- | --------------- | -----------------------------------------------
+ *  18/10/26 | agent           |  Initial Implementation and documentation.
+ *****************************************************************************/
+static int is_better_key(const RouteSortKey *first, const RouteSortKey *second, int tieToFirst)
+{
+	if (first->major != second->major)
+	{
+		return first->major < second->major;
+	}
+	if (first->minor != second->minor)
+	{
+		return first->minor < second->minor;
+	}
+	if (first->neighbor != second->neighbor)
+	{
+		return first->neighbor < second->neighbor;
+	}
+
+	return tieToFirst;
+}
+
+/******************************************************************************
+ *
+ * \par Function Name:
+ * 		prepare_best_per_neighbor_table
+ *
+ * \brief Get an empty best route per neighbor table with at least
+ *        twice the slots of the candidate routes.
+ *
+ *
+ * \par Date Written:
+ * 		18/10/26
+ *
+ * \return int
+ *
+ * \retval   0   Success case: table ready
+ * \retval  -2   MWITHDRAW error
+ *
+ * \param[in]	routesNumber   The number of candidate routes
+ *
+ * \par Revision History:
+ *
+ *  DD/MM/YY |  AUTHOR         |   DESCRIPTION
+ *  -------- | --------------- | -----------------------------------------------
+ *  18/10/26 | agent           |  Initial Implementation and documentation.
+ *****************************************************************************/
+static int prepare_best_per_neighbor_table(PhaseThreeSAP *sap, unsigned long routesNumber)
+{
+	uint32_t size = 16;
+	NeighborBestRoute *table;
+
+	while ((unsigned long) size < 2 * routesNumber)
+	{
+		size <<= 1;
+	}
+
+	if (size > sap->bestPerNeighborSize)
+	{
+		table = (NeighborBestRoute*) MWITHDRAW(size * sizeof(NeighborBestRoute));
+		if (table == NULL)
+		{
+			return -2;
+		}
+		if (sap->bestPerNeighbor != NULL)
+		{
+			MDEPOSIT(sap->bestPerNeighbor);
+		}
+		sap->bestPerNeighbor = table;
+		sap->bestPerNeighborSize = size;
+	}
+
+	memset(sap->bestPerNeighbor, 0, sap->bestPerNeighborSize * sizeof(NeighborBestRoute));
+
+	return 0;
+}
+
 /******************************************************************************
  *
  * \par Function Name:
@@ -235,47 +484,77 @@ static int best_route_cost_function(UniboCGRSAP* uniboCgrSap, void *first, void
  * \par Date Written:
  * 		13/02/20
  *
- * \return void
+ * \return int
+ *
+ * \retval   0   Success case
+ * \retval  -2   MWITHDRAW error
  *
  * \param[in,out]   *candidateRoutes     Initially it contains all the candidateRoutes,
  *                                       at the end only the best route per neighbor remains in this list.
  *
  *\warning candidateRoutes doesn't have to be NULL.
  *
+ * \par Notes:
+ *          1.  Single pass: the best route of each neighbor is kept in a table indexed by neighbor
+ *              (open addressing), in the list element of the first route found to that neighbor.
+ *
  * \par Revision History:
  *
  *  DD/MM/YY |  AUTHOR         |   DESCRIPTION
  *  -------- | --------------- | -----------------------------------------------
  *  13/02/20 | L. Persampieri  |  Initial Implementation and documentation.
+ *  18/10/26 | agent           |  Single pass with best route per neighbor table and sort keys.
  *****************************************************************************/
-static void getOneBestRoutePerNeighbor(UniboCGRSAP* uniboCgrSap, List candidateRoutes)
+static int getOneBestRoutePerNeighbor(UniboCGRSAP* uniboCgrSap, List candidateRoutes)
 {
-	ListElt *elt, *next, *temp;
-	Route *currentNeighborFirstRoute, *currentRoute;
-	unsigned long long viaNeighbor;
+	ListElt *elt, *next;
+	Route *currentRoute;
+	RouteSortKey key;
+	NeighborBestRoute *slot;
+	uint32_t mask, index;
+	PhaseThreeSAP *sap = UniboCGRSAP_get_PhaseThreeSAP(uniboCgrSap);
+	const int tieToNew = (UniboCGRSAP_check_reactive_anti_loop(uniboCgrSap) || UniboCGRSAP_check_proactive_anti_loop(uniboCgrSap));
+
+	if (prepare_best_per_neighbor_table(sap, candidateRoutes->length) < 0)
+	{
+		return -2;
+	}
 
-	for (elt = candidateRoutes->first; elt != NULL; elt = elt->next)
+	mask = sap->bestPerNeighborSize - 1;
+
+	for (elt = candidateRoutes->first; elt != NULL; elt = next)
 	{
-		temp = elt->next;
-		currentNeighborFirstRoute = (Route*) elt->data;
-		viaNeighbor = currentNeighborFirstRoute->neighbor;
-		while (temp != NULL)
+		next = elt->next;
+		currentRoute = (Route*) elt->data;
+		compute_sort_key(uniboCgrSap, currentRoute, &key);
+
+		index = (uint32_t) ((currentRoute->neighbor ^ (currentRoute->neighbor >> 32)) & mask);
+		slot = &(sap->bestPerNeighbor[index]);
+		while (slot->elt != NULL && ((Route*) slot->elt->data)->neighbor != currentRoute->neighbor)
 		{
-			currentRoute = (Route*) temp->data;
-			next = temp->next;
-			if (viaNeighbor == currentRoute->neighbor)
-			{
-				if (best_route_cost_function(uniboCgrSap, (Route*) currentRoute, (Route*) elt->data) < 0)
-				{
-					elt->data = currentRoute;
-				}
+			index = (index + 1) & mask;
+			slot = &(sap->bestPerNeighbor[index]);
+		}
 
-				list_remove_elt(temp);
+		if (slot->elt == NULL)
+		{
+			// first route to this neighbor
+			slot->elt = elt;
+			slot->key = key;
+		}
+		else
+		{
+			if (is_better_key(&key, &(slot->key), tieToNew))
+			{
+				slot->elt->data = currentRoute;
+				slot->key = key;
 			}
 
-			temp = next;
+			list_remove_elt(elt);
 		}
 	}
+
+	return 0;
 }
 
 /******************************************************************************
@@ -302,10 +581,13 @@ static void getOneBestRoutePerNeighbor(UniboCGRSAP* uniboCgrSap, List candidateR
  *  DD/MM/YY |  AUTHOR         |   DESCRIPTION
  *  -------- | --------------- | -----------------------------------------------
  *  13/02/20 | L. Persampieri  |  Initial Implementation and documentation.
+ *  18/10/26 | agent           |  Compare routes by sort keys.
  *****************************************************************************/
 static void getBestRoute(UniboCGRSAP* uniboCgrSap, List candidateRoutes)
 {
 	ListElt *elt, *next, *bestElt = NULL;
+	RouteSortKey key, bestKey;
+	const int tieToNew = (UniboCGRSAP_check_reactive_anti_loop(uniboCgrSap) || UniboCGRSAP_check_proactive_anti_loop(uniboCgrSap));
 
 	elt = candidateRoutes->first;
 
@@ -313,15 +595,19 @@ static void getBestRoute(UniboCGRSAP* uniboCgrSap, List candidateRoutes)
 	{
 		next = elt->next;
 
+		compute_sort_key(uniboCgrSap, (Route*) elt->data, &key);
+
 		if (bestElt == NULL)
 		{
 			bestElt = elt;
+			bestKey = key;
 		}
 		else
 		{
-			if (best_route_cost_function(uniboCgrSap, (Route*) elt->data, (Route*) bestElt->data) < 0)
+			if (is_better_key(&key, &bestKey, tieToNew))
 			{
 				bestElt->data = elt->data;
+				bestKey = key;
 			}
 
 			list_remove_elt(elt);
@@ -334,7 +620,7 @@ static void getBestRoute(UniboCGRSAP* uniboCgrSap, List candidateRoutes)
 /******************************************************************************
  *
  * \par Function Name:
- * 		update_volumes
+ * 		update_best_routes_volumes
  *
  * \brief For each contact in the hops list of a best route
  *        this function will decrease the mtv field for all level of priority
@@ -345,7 +631,10 @@ static void getBestRoute(UniboCGRSAP* uniboCgrSap, List candidateRoutes)
  * \par Date Written:
  * 		13/02/20
  *
- * \return void
+ * \return int
+ *
+ * \retval   0   Success case
+ * \retval  -2   MWITHDRAW error
  *
  * \param[in]   *bundle         The bundle from we get the priority level and the EVC
  * \param[in]   bestRoutes      The list of best routes
@@ -353,33 +642,39 @@ static void getBestRoute(UniboCGRSAP* uniboCgrSap, List candidateRoutes)
  * \warning bundle doesn't have to be NULL.
  * \warning bestRoutes doesn't have to be NULL.
  *
+ * \par Notes:
+ *          1.  Each decreased volume is first recorded in the reservation of the current call
+ *              (if volume reservations are enabled), so that it can be released later.
+ *
  * \par Revision History:
  *
  *  DD/MM/YY |  AUTHOR         |   DESCRIPTION
  *  -------- | --------------- | -----------------------------------------------
  *  13/02/20 | L. Persampieri  |  Initial Implementation and documentation.
+ *  18/10/26 | agent           |  Record the decreased volumes in the reservation of the current call.
+ *  18/10/26 | agent           |  Integer MTV: batched saturating decrement of the hops.
+ *  18/10/26 | agent           |  Renamed and exported, used by the route cache.
  *****************************************************************************/
-static void update_volumes(CgrBundle *bundle, List bestRoutes)
+int update_best_routes_volumes(UniboCGRSAP* uniboCgrSap, CgrBundle *bundle, List bestRoutes)
 {
-	ListElt *routeElt, *hopElt;
-	Contact *contact;
+	ListElt *routeElt;
 	Route *route;
-	int i, priority = bundle->priority_level;
+	const int priority = bundle->priority_level;
+	const int64_t evc = convert_evc_to_mtv(bundle->evc);
 
 	for (routeElt = bestRoutes->first; routeElt != NULL; routeElt = routeElt->next)
 	{
 		route = (Route*) routeElt->data;
 
-		for (hopElt = route->hops->first; hopElt != NULL; hopElt = hopElt->next)
+		if (reserve_hops_volume(uniboCgrSap, route->hops, evc, priority) < 0)
 		{
-			contact = (Contact*) hopElt->data;
-
-			for (i = 0; i <= priority; i++)
-			{
-				contact->mtv[i] -= (double) bundle->evc;
-			}
+			return -2;
 		}
+
+		decrease_hops_mtv(route->hops, priority, evc);
 	}
+
+	return 0;
 }
 
 /******************************************************************************
@@ -398,6 +693,7 @@ static void update_volumes(CgrBundle *bundle, List bestRoutes)
  *
  * \retval  ">= 0"	The number of the best routes choosed.
  * \retval     -1	Arguments error: NULL pointer.
+ * \retval     -2	MWITHDRAW error
  *
  * \param[in]       *bundle             The bundle that has to be forwarded
  * \param[in,out]   candidateRoutes     Initially it contains the candidate routes,
@@ -413,28 +709,37 @@ static void update_volumes(CgrBundle *bundle, List bestRoutes)
  *  DD/MM/YY |  AUTHOR         |   DESCRIPTION
  *  -------- | --------------- | -----------------------------------------------
  *  13/02/20 | L. Persampieri  |  Initial Implementation and documentation.
+ *  18/10/26 | agent           |  Handle MWITHDRAW error of getOneBestRoutePerNeighbor.
+ *  18/10/26 | agent           |  Handle MWITHDRAW error of update_best_routes_volumes.
  *****************************************************************************/
 int chooseBestRoutes(UniboCGRSAP* uniboCgrSap, CgrBundle *bundle, List candidateRoutes)
 {
-    (void) uniboCgrSap;
 	int result = -1;
 
 	debug_printf("Entry point phase three.");
 
 	if (candidateRoutes != NULL && bundle != NULL)
 	{
+		result = 0;
+
 		if (IS_CRITICAL(bundle))
 		{
-			getOneBestRoutePerNeighbor(uniboCgrSap, candidateRoutes);
+			result = getOneBestRoutePerNeighbor(uniboCgrSap, candidateRoutes);
 		}
 		else
 		{
 			getBestRoute(uniboCgrSap, candidateRoutes);
 		}
 
-		update_volumes(bundle, candidateRoutes);
+		if (result == 0)
+		{
+			result = update_best_routes_volumes(uniboCgrSap, bundle, candidateRoutes);
+		}
 
-		result = (int) candidateRoutes->length;
+		if (result == 0)
+		{
+			result = (int) candidateRoutes->length;
+		}
 	}
 
 	debug_printf("Best routes chosen: %d", result);
@@ -75,6 +75,15 @@ struct PhaseTwoSAP {
 	 *        Reset to 0 at each call to CGR.
 	 */
 	uint32_t last_max_neighbors_number;
+	/**
+	 * \brief The first element of the computed routes list at the end of the
+	 *        previous iteration in phase two during the current call to CGR.
+	 *
+	 * \details Phase one always inserts the new computed routes as first elements,
+	 *          so at the next iteration we check only the routes that precede
+	 *          this element. Reset to NULL at each call to CGR.
+	 */
+	ListElt *checkedRoutesBound;
 };
 
 typedef enum {
@@ -127,6 +136,10 @@ int PhaseTwoSAP_open(UniboCGRSAP* uniboCgrSap)
 		free_list_elts(sap->routes);
 		free_list_elts(sap->subset);
 		free_list_elts(sap->suppressedNeighbors);
+		// per-call lists: their elements are released by reset_cgr()
+		list_set_elt_arena(sap->routes, UniboCGRSAP_get_scratch_arena(uniboCgrSap));
+		list_set_elt_arena(sap->subset, UniboCGRSAP_get_scratch_arena(uniboCgrSap));
+		list_set_elt_arena(sap->suppressedNeighbors, UniboCGRSAP_get_scratch_arena(uniboCgrSap));
 	}
 
 	return 0;
@@ -191,6 +204,7 @@ void PhaseTwoSAP_close(UniboCGRSAP* uniboCgrSap)
  *  DD/MM/YY | AUTHOR          |  DESCRIPTION
  *  -------- | --------------- | -----------------------------------------------
  *  06/02/20 | L. Persampieri  |  Initial Implementation and documentation.
+ *  18/10/26 | agent           |  Reset the checked routes bound.
  *****************************************************************************/
 void reset_phase_two(UniboCGRSAP* uniboCgrSap)
 {
@@ -198,6 +212,7 @@ void reset_phase_two(UniboCGRSAP* uniboCgrSap)
 
 	sap->neighborsFound = 0;
 	sap->last_max_neighbors_number = 0;
+	sap->checkedRoutesBound = NULL;
 	free_list_elts(sap->routes);
 	free_list_elts(sap->subset);
 	free_list_elts(sap->suppressedNeighbors);
@@ -463,7 +478,7 @@ static int computeResidualBacklog(UniboCGRSAP* uniboCgrSap, time_t current_time,
  * \param[in]		priority                The priority level of the bundle
  * \param[in]		firstByteTransmitTime   The first byte transmit time for the sender node of the contact
  * \param[in]		*elt                    The ListElt for which the contact is the data field
- * \param[out]		*effectiveVolumeLimit   The effective volume limit computed, only in success case
+ * \param[out]		*effectiveVolumeLimit   The effective volume limit computed (bytes), only in success case
  *
  * \warning contact doesn't have to be NULL
  * \warning elt doesn't have to be NULL
@@ -479,9 +494,10 @@ static int computeResidualBacklog(UniboCGRSAP* uniboCgrSap, time_t current_time,
  *  DD/MM/YY | AUTHOR          |  DESCRIPTION
  *  -------- | --------------- | -----------------------------------------------
  *  06/02/20 | L. Persampieri  |  Initial Implementation and documentation.
+ *  18/10/26 | agent           |  Integer volumes.
  *****************************************************************************/
 static int computeEffectiveVolumeLimit(Contact *contact, Priority priority,
-		time_t firstByteTransmitTime, ListElt *elt, double *effectiveVolumeLimit)
+		time_t firstByteTransmitTime, ListElt *elt, int64_t *effectiveVolumeLimit)
 {
 	time_t effectiveStopTime, effectiveDuration;
 	int result = 0;
@@ -508,8 +524,7 @@ static int computeEffectiveVolumeLimit(Contact *contact, Priority priority,
 	}
 	else
 	{
-		*effectiveVolumeLimit =
-				(double) ((uint64_t) effectiveDuration * contact->xmitRate);
+		*effectiveVolumeLimit = compute_contact_volume(effectiveDuration, contact->xmitRate);
 		if (contact->mtv[priority] < *effectiveVolumeLimit)
 		{
 			*effectiveVolumeLimit = contact->mtv[priority];
@@ -565,6 +580,7 @@ static int computeEffectiveVolumeLimit(Contact *contact, Priority priority,
  *  DD/MM/YY | AUTHOR          |  DESCRIPTION
  *  -------- | --------------- | -----------------------------------------------
  *  06/02/20 | L. Persampieri  |  Initial Implementation and documentation.
+ *  18/10/26 | agent           |  Integer MTV comparisons.
  *****************************************************************************/
 static int computeExpectedBundleDeliveryTime(UniboCGRSAP* uniboCgrSap, time_t current_time, CgrBundle *bundle, Route *route,
                                              CgrScalar *residualBacklog, time_t *lastByteArrivalTime)
@@ -573,7 +589,7 @@ static int computeExpectedBundleDeliveryTime(UniboCGRSAP* uniboCgrSap, time_t cu
 	uint64_t owlt, owltMargin, owltSum = 0;
 	CgrScalar applicableRadiationLatency;
 	time_t firstByteTransmitTime, lastByteTransmitTime, startTime, arrivalTime;
-	double effectiveVolumeLimit;
+	int64_t effectiveVolumeLimit;
 	Contact *contact, *nextContact;
 	ListElt *elt, *nextElt;
 	Priority priority;
@@ -653,7 +669,7 @@ static int computeExpectedBundleDeliveryTime(UniboCGRSAP* uniboCgrSap, time_t cu
 					arrivalTime = (time_t)((uint64_t) contact->fromTime + owlt + owltMargin);
 				}
 
-				if (contact->mtv[priority] <= 0.0) // SABR 3.2.6.8.11
+				if (contact->mtv[priority] <= 0) // SABR 3.2.6.8.11
 				{
 					viableRoute = 0;
 				}
@@ -664,7 +680,7 @@ static int computeExpectedBundleDeliveryTime(UniboCGRSAP* uniboCgrSap, time_t cu
 					{
 						viableRoute = 0;
 					}
-					else if (effectiveVolumeLimit < (double) bundle->evc) //TODO do not fragment
+					else if (effectiveVolumeLimit < convert_evc_to_mtv(bundle->evc)) //TODO do not fragment
 					{
 						viableRoute = 0;
 					}
@@ -672,8 +688,8 @@ static int computeExpectedBundleDeliveryTime(UniboCGRSAP* uniboCgrSap, time_t cu
 					{
 						//SABR 3.2.6.8.10: RVL
 						route->routeVolumeLimit =
-								(route->routeVolumeLimit < effectiveVolumeLimit) ?
-										route->routeVolumeLimit : effectiveVolumeLimit;
+								(route->routeVolumeLimit < (double) effectiveVolumeLimit) ?
+										route->routeVolumeLimit : (double) effectiveVolumeLimit;
 
 						contact = nextContact;
 						elt = nextElt;
@@ -687,9 +703,9 @@ static int computeExpectedBundleDeliveryTime(UniboCGRSAP* uniboCgrSap, time_t cu
 							 * for the selected bundle priority and nominal xmit rate of the contact
 							 */
 
-                                nominalContactVolume = (double) ((uint64_t) (contact->toTime
-                                                                             - contact->fromTime) * contact->xmitRate);
-                                queueDelay = (time_t) ((nominalContactVolume - contact->mtv[priority])
+                                nominalContactVolume = (double) compute_contact_volume(contact->toTime
+                                                                                       - contact->fromTime, contact->xmitRate);
+                                queueDelay = (time_t) ((nominalContactVolume - (double) contact->mtv[priority])
                                                        / ((double) contact->xmitRate));
 
                                 //ETO on all hops
@@ -1543,6 +1559,55 @@ int checkRoute(UniboCGRSAP* uniboCgrSap, CgrBundle *bundle, List excludedNeighbo
 	return result;
 }
 
+/******************************************************************************
+ *
+ * \par Function Name:
+ *      checkRouteVolume
+ *
+ * \brief Compute again the PBAT of a candidate route for another bundle (computePBAT).
+ *
+ *
+ * \par Date Written:
+ *      18/10/26
+ *
+ * \return int
+ *
+ * \retval    0  Success case: The route is still viable for the forwarding of the bundle
+ * \retval   -1  Route not viable: not enough volume or PBAT later than the bundle's deadline
+ *
+ * \param[in]    *bundle            The bundle that has to be forwarded
+ * \param[in]    *route             A candidate route found for a bundle of the same routing class
+ *
+ * \par Notes:
+ *                1.   Used by the bundles group call. Only computePBAT is repeated: the
+ *                     effective volume limit of each hop (the volume reserved by the previous
+ *                     bundles of the group included) must fit the bundle's EVC, and the PBAT
+ *                     must not be later than the bundle's deadline.
+ *                2.   The other checks of checkRoute are not repeated, the route's checkValue
+ *                     is the one set for the representative bundle of the group.
+ *                3.   In success case eto, pbat, routeVolumeLimit, owltSum, arrivalTime
+ *                     and overbooked are computed again for the bundle.
+ *
+ *
+ * \par Revision History:
+ *
+ *  DD/MM/YY | AUTHOR          |  DESCRIPTION
+ *  -------- | --------------- | -----------------------------------------------
+ *  18/10/26 | agent           |  Initial Implementation and documentation.
+ *****************************************************************************/
+int checkRouteVolume(UniboCGRSAP* uniboCgrSap, CgrBundle *bundle, Route *route)
+{
+	const time_t current_time = UniboCGRSAP_get_current_time(uniboCgrSap);
+	const uint64_t localNode = UniboCGRSAP_get_local_node(uniboCgrSap);
+
+	if (computePBAT(uniboCgrSap, current_time, localNode, route, bundle) < 0)
+	{
+		return -1;
+	}
+
+	return 0;
+}
+
 /******************************************************************************
  *
  * \par Function Name:
@@ -1576,6 +1641,10 @@ int checkRoute(UniboCGRSAP* uniboCgrSap, CgrBundle *bundle, List excludedNeighbo
  * \par Notes:
  *               1.  In success case candidateRoutes will be a subset of computedRoutes,
  *                   otherwise candidateRoutes will points to NULL
+ *               2.  Only the routes added by phase one since the previous iteration
+ *                   (during the current call) are checked. The routes already checked
+ *                   keep their classification, so the conversation with phase one
+ *                   costs linear time in the number of computed routes.
  *
  *
  *
@@ -1585,6 +1654,7 @@ int checkRoute(UniboCGRSAP* uniboCgrSap, CgrBundle *bundle, List excludedNeighbo
  *  -------- | --------------- | -----------------------------------------------
  *  06/02/20 | L. Persampieri  |  Initial Implementation and documentation.
  *  27/04/20 | L. Persampieri  |  Refactoring
+ *  18/10/26 | agent           |  Check only the routes computed since the previous iteration.
  *****************************************************************************/
 int getCandidateRoutes(UniboCGRSAP* uniboCgrSap, Node *terminusNode, CgrBundle *bundle, List excludedNeighbors, List computedRoutes,
                        List *subsetComputedRoutes, uint32_t *missingNeighbors, List *candidateRoutes)
@@ -1632,7 +1702,13 @@ int getCandidateRoutes(UniboCGRSAP* uniboCgrSap, Node *terminusNode, CgrBundle *
 			sap->last_max_neighbors_number = max_neighbors_number;
 		}
 
-		for (elt = computedRoutes->first; elt != NULL && !error; elt = elt->next)
+		if(sap->checkedRoutesBound != NULL && sap->checkedRoutesBound->list != computedRoutes)
+		{
+			// not the same list of the previous iteration, check all the routes
+			sap->checkedRoutesBound = NULL;
+		}
+
+		for (elt = computedRoutes->first; elt != NULL && elt != sap->checkedRoutesBound && !error; elt = elt->next)
 		{
 			if (elt->data != NULL)
 			{
@@ -1682,6 +1758,8 @@ int getCandidateRoutes(UniboCGRSAP* uniboCgrSap, Node *terminusNode, CgrBundle *
 			}
 		}
 
+		sap->checkedRoutesBound = computedRoutes->first;
+
 		debug_printf("New candidate routes: %d", result);
 
 		if (result < 0)
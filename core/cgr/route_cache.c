@@ -0,0 +1,969 @@
+/** \file route_cache.c
+ *
+ *  \brief  This file provides the implementation of the functions
+ *          to manage the per-destination cache of the routing results.
+ *
+ *  \details Many consecutive bundles to the same destination get the same best routes.
+ *           If the route cache is enabled the best routes of the last routing call to
+ *           each destination are kept here, together with the class of the bundle
+ *           (priority, flags, delivery confidence, excluded neighbors and EVC bucket).
+ *           A following bundle of the same class gets the same best routes without
+ *           phases one, two and three, as long as:
+ *           - the contact plan and the features have not changed (contact plan epoch);
+ *           - no MTV has been increased (MTV watermark), since a route excluded
+ *             for lack of volume could be viable again;
+ *           - no hop of the cached routes is expired;
+ *           - each cached route still has enough volume and arrives before the bundle's deadline.
+ *
+ *           The ETO and the PBAT of the cached routes are the ones computed by phase two for
+ *           the bundle that filled the entry, as for the bundles of a group (getBestRoutesGroup).
+ *
+ *           The destinations found unreachable are cached too (negative entries): a following
+ *           bundle of the same class, with no later deadline and no smaller EVC, is reported
+ *           as unreachable without any graph search until the next contact start time
+ *           (or until the contact plan, the features or some MTV change).
+ *
+ *
+ ** \copyright Copyright (c) 2020, Alma Mater Studiorum, University of Bologna, All rights reserved.
+ **
+ ** \par License
+ **
+ **    This file is part of Unibo-CGR.                                            <br>
+ **                                                                               <br>
+ **    Unibo-CGR is free software: you can redistribute it and/or modify
+ **    it under the terms of the GNU General Public License as published by
+ **    the Free Software Foundation, either version 3 of the License, or
+ **    (at your option) any later version.                                        <br>
+ **    Unibo-CGR is distributed in the hope that it will be useful,
+ **    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ **    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ **    GNU General Public License for more details.                               <br>
+ **                                                                               <br>
+ **    You should have received a copy of the GNU General Public License
+ **    along with Unibo-CGR.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  \author agent, agent@local
+ *
+ *  \par Supervisor
+ *       Carlo Caini, carlo.caini@unibo.it
+ */
+
+#include "route_cache.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "cgr_phases.h"
+#include "../contact_plan/contacts/contacts.h"
+#include "../routes/routes.h"
+#include "../library/list/list.h"
+#include "../library_from_ion/rbt/rbt.h"
+
+/**
+ * \brief The class of a bundle: bundles of the same class to the same destination
+ *        get the same best routes.
+ */
+typedef struct
+{
+	/**
+	 * \brief Ipn node number of the destination
+	 */
+	uint64_t destination;
+	/**
+	 * \brief Order-independent hash of the excluded neighbors (sender node included)
+	 */
+	uint64_t excludedFingerprint;
+	/**
+	 * \brief Position of the most significant bit of the EVC (0 for EVC 0)
+	 */
+	unsigned int evcBucket;
+	/**
+	 * \brief Bulk, Normal or Expedited
+	 */
+	Priority priority;
+	/**
+	 * \brief Ordinal (Expedited only)
+	 */
+	unsigned int ordinal;
+	/**
+	 * \brief Bundle flags (critical, backward propagation, ...)
+	 */
+	unsigned char flags;
+	/**
+	 * \brief Delivery confidence requested by the bundle
+	 */
+	float dlvConfidence;
+} RouteCacheKey;
+
+/**
+ * \brief The best routes of the last routing call to a destination.
+ */
+typedef struct
+{
+	RouteCacheKey key;
+	/**
+	 * \brief Contact plan epoch when the entry has been filled
+	 */
+	uint64_t epoch;
+	/**
+	 * \brief MTV watermark when the entry has been filled
+	 */
+	uint64_t mtvWatermark;
+	/**
+	 * \brief The lowest toTime of the cached routes: at that time the first hop expires.
+	 *        For a negative entry: the next contact start time.
+	 */
+	time_t expiry;
+	/**
+	 * \brief The best routes (Route*), the routes are owned by the destination's routing object
+	 */
+	List routes;
+	/**
+	 * \brief Boolean: 1 if the destination has been found unreachable (negative entry), 0 otherwise.
+	 */
+	int unreachable;
+	/**
+	 * \brief Negative entry: the expiration time of the bundle that filled the entry.
+	 */
+	time_t deadline;
+	/**
+	 * \brief Negative entry: the EVC of the bundle that filled the entry.
+	 */
+	uint64_t evc;
+} RouteCacheEntry;
+
+/**
+ * \brief This struct is used to keep in one place all the data used by
+ *        the route cache.
+ */
+struct RouteCacheSAP
+{
+	/**
+	 * \brief One RouteCacheEntry per destination, ordered by destination.
+	 */
+	Rbt *entries;
+	/**
+	 * \brief The key of the bundle of the current call (computed by route_cache_lookup).
+	 */
+	RouteCacheKey currentKey;
+	/**
+	 * \brief Boolean: 1 if the current bundle missed and its best routes can be stored, 0 otherwise.
+	 */
+	int storeCurrent;
+	/**
+	 * \brief Increased each time some MTV is increased.
+	 */
+	uint64_t mtvWatermark;
+	/**
+	 * \brief Routing calls served by the cache.
+	 */
+	uint64_t hits;
+	/**
+	 * \brief Cacheable routing calls not served by the cache.
+	 */
+	uint64_t misses;
+};
+
+/******************************************************************************
+ *
+ * \par Function Name:
+ *      compare_route_cache_entries
+ *
+ * \brief Compare two entries by destination
+ *
+ *
+ * \par Date Written:
+ *      18/10/26
+ *
+ * \return int
+ *
+ * \retval   0  The entries are equals
+ * \retval  -1  The first entry is less than the second entry
+ * \retval   1  The first entry is greater than the second entry
+ *
+ * \param[in]	*first   The first entry
+ * \param[in]	*second  The second entry
+ *
+ * \par Revision History:
+ *
+ *  DD/MM/YY |  AUTHOR         |   DESCRIPTION
+ *  -------- | --------------- | -----------------------------------------------
+ *  18/10/26 | agent           |  Initial Implementation and documentation.
+ *****************************************************************************/
+static int compare_route_cache_entries(void *first, void *second)
+{
+	RouteCacheEntry *a, *b;
+	int result = 0;
+
+	if (first != second && first != NULL && second != NULL)
+	{
+		a = (RouteCacheEntry*) first;
+		b = (RouteCacheEntry*) second;
+
+		if (a->key.destination < b->key.destination)
+		{
+			result = -1;
+		}
+		else if (a->key.destination > b->key.destination)
+		{
+			result = 1;
+		}
+	}
+
+	return result;
+}
+
+/******************************************************************************
+ *
+ * \par Function Name:
+ *      free_route_cache_entry
+ *
+ * \brief  Deallocate memory for a RouteCacheEntry type
+ *
+ *
+ * \par Date Written:
+ *      18/10/26
+ *
+ * \return void
+ *
+ * \param[in]  *entry  The RouteCacheEntry that we want to deallocate
+ *
+ * \par Notes:
+ *          1.  The cached routes are not touched: they may be already deleted.
+ *
+ * \par Revision History:
+ *
+ *  DD/MM/YY | AUTHOR          |  DESCRIPTION
+ *  -------- | --------------- | -----------------------------------------------
+ *  18/10/26 | agent           |  Initial Implementation and documentation.
+ *****************************************************************************/
+static void free_route_cache_entry(void *entry)
+{
+	RouteCacheEntry *temp;
+
+	if (entry != NULL)
+	{
+		temp = (RouteCacheEntry*) entry;
+		free_list(temp->routes);
+		memset(temp, 0, sizeof(RouteCacheEntry));
+		MDEPOSIT(temp);
+	}
+}
+
+/******************************************************************************
+ *
+ * \par Function Name:
+ *      create_route_cache_entry
+ *
+ * \brief  Allocate memory for a RouteCacheEntry type
+ *
+ *
+ * \par Date Written:
+ *      18/10/26
+ *
+ * \return RouteCacheEntry*
+ *
+ * \retval RouteCacheEntry*  The new allocated RouteCacheEntry
+ * \retval NULL              MWITHDRAW error
+ *
+ * \par Revision History:
+ *
+ *  DD/MM/YY |  AUTHOR         |   DESCRIPTION
+ *  -------- | --------------- | -----------------------------------------------
+ *  18/10/26 | agent           |  Initial Implementation and documentation.
+ *****************************************************************************/
+static RouteCacheEntry* create_route_cache_entry()
+{
+	RouteCacheEntry *entry = (RouteCacheEntry*) MWITHDRAW(sizeof(RouteCacheEntry));
+
+	if (entry != NULL)
+	{
+		memset(entry, 0, sizeof(RouteCacheEntry));
+		entry->routes = list_create(entry, NULL, NULL, NULL);
+
+		if (entry->routes == NULL)
+		{
+			MDEPOSIT(entry);
+			entry = NULL;
+		}
+	}
+
+	return entry;
+}
+
+/******************************************************************************
+ *
+ * \par Function Name:
+ *      RouteCacheSAP_open
+ *
+ * \brief  Allocate memory for the route cache
+ *
+ *
+ * \par Date Written:
+ *      18/10/26
+ *
+ * \return int
+ *
+ * \retval   0  Success case: the route cache now exists
+ * \retval  -2  MWITHDRAW error
+ *
+ *
+ * \par Revision History:
+ *
+ *  DD/MM/YY |  AUTHOR         |   DESCRIPTION
+ *  -------- | --------------- | -----------------------------------------------
+ *  18/10/26 | agent           |  Initial Implementation and documentation.
+ *****************************************************************************/
+int RouteCacheSAP_open(UniboCGRSAP* uniboCgrSap)
+{
+    if (UniboCGRSAP_get_RouteCacheSAP(uniboCgrSap)) return 0;
+    RouteCacheSAP* sap = MWITHDRAW(sizeof(RouteCacheSAP));
+    if (!sap) return -2;
+    UniboCGRSAP_set_RouteCacheSAP(uniboCgrSap, sap);
+    memset(sap, 0, sizeof(RouteCacheSAP));
+    sap->entries = rbt_create(free_route_cache_entry, compare_route_cache_entries);
+    if (!sap->entries) {
+        RouteCacheSAP_close(uniboCgrSap);
+        return -2;
+    }
+    rbt_set_node_pool(sap->entries, UniboCGRSAP_get_rbt_node_pool(uniboCgrSap));
+
+    return 0;
+}
+
+/******************************************************************************
+ *
+ * \par Function Name:
+ *      RouteCacheSAP_close
+ *
+ * \brief  Deallocate all the memory used by the route cache.
+ *
+ *
+ * \par Date Written:
+ *      18/10/26
+ *
+ * \return void
+ *
+ * \par Revision History:
+ *
+ *  DD/MM/YY |  AUTHOR         |   DESCRIPTION
+ *  -------- | --------------- | -----------------------------------------------
+ *  18/10/26 | agent           |  Initial Implementation and documentation.
+ *****************************************************************************/
+void RouteCacheSAP_close(UniboCGRSAP* uniboCgrSap)
+{
+    RouteCacheSAP* sap = UniboCGRSAP_get_RouteCacheSAP(uniboCgrSap);
+    if (!sap) return;
+    rbt_destroy(sap->entries);
+    memset(sap, 0, sizeof(RouteCacheSAP));
+    MDEPOSIT(sap);
+    UniboCGRSAP_set_RouteCacheSAP(uniboCgrSap, NULL);
+}
+
+/******************************************************************************
+ *
+ * \par Function Name:
+ *      mix_node_number
+ *
+ * \brief  Scramble the bits of an ipn node number (splitmix64 finalizer)
+ *
+ *
+ * \par Date Written:
+ *      18/10/26
+ *
+ * \return uint64_t
+ *
+ * \param[in]  node   The ipn node number
+ *
+ * \par Revision History:
+ *
+ *  DD/MM/YY |  AUTHOR         |   DESCRIPTION
+ *  -------- | --------------- | -----------------------------------------------
+ *  18/10/26 | agent           |  Initial Implementation and documentation.
+ *****************************************************************************/
+static uint64_t mix_node_number(uint64_t node)
+{
+	node ^= node >> 30;
+	node *= 0xbf58476d1ce4e5b9ULL;
+	node ^= node >> 27;
+	node *= 0x94d049bb133111ebULL;
+	node ^= node >> 31;
+
+	return node;
+}
+
+/******************************************************************************
+ *
+ * \par Function Name:
+ *      compute_route_cache_key
+ *
+ * \brief  Compute the class of the bundle
+ *
+ *
+ * \par Date Written:
+ *      18/10/26
+ *
+ * \return void
+ *
+ * \param[in]   *bundle              The bundle that has to be forwarded
+ * \param[in]   excludedNeighbors    The excluded neighbors list (as passed by the interface)
+ * \param[out]  *key                 The class of the bundle
+ *
+ * \par Notes:
+ *          1.  The sender node is added to the excluded neighbors fingerprint
+ *              as getBestRoutes does with the excluded neighbors list.
+ *
+ * \par Revision History:
+ *
+ *  DD/MM/YY |  AUTHOR         |   DESCRIPTION
+ *  -------- | --------------- | -----------------------------------------------
+ *  18/10/26 | agent           |  Initial Implementation and documentation.
+ *****************************************************************************/
+static void compute_route_cache_key(CgrBundle *bundle, List excludedNeighbors, RouteCacheKey *key)
+{
+	ListElt *elt;
+	uint64_t evc;
+
+	memset(key, 0, sizeof(RouteCacheKey));
+	key->destination = bundle->terminus_node;
+	key->priority = bundle->priority_level;
+	key->ordinal = bundle->ordinal;
+	key->flags = bundle->flags;
+	key->dlvConfidence = bundle->dlvConfidence;
+
+	for (evc = bundle->evc; evc > 0; evc >>= 1)
+	{
+		key->evcBucket++;
+	}
+
+	for (elt = excludedNeighbors->first; elt != NULL; elt = elt->next)
+	{
+		if (elt->data != NULL)
+		{
+			key->excludedFingerprint += mix_node_number(*((uint64_t*) elt->data));
+		}
+	}
+	if (!(RETURN_TO_SENDER(bundle)) && bundle->sender_node != 0)
+	{
+		key->excludedFingerprint += mix_node_number(bundle->sender_node);
+	}
+}
+
+/******************************************************************************
+ *
+ * \par Function Name:
+ *      same_route_cache_key
+ *
+ * \brief  Boolean: to know if two bundles belong to the same class
+ *
+ *
+ * \par Date Written:
+ *      18/10/26
+ *
+ * \return int
+ *
+ * \retval   1   Same class
+ * \retval   0   Different class
+ *
+ * \param[in]   *first    The first key
+ * \param[in]   *second   The second key
+ *
+ * \par Revision History:
+ *
+ *  DD/MM/YY |  AUTHOR         |   DESCRIPTION
+ *  -------- | --------------- | -----------------------------------------------
+ *  18/10/26 | agent           |  Initial Implementation and documentation.
+ *****************************************************************************/
+static int same_route_cache_key(const RouteCacheKey *first, const RouteCacheKey *second)
+{
+	return (first->destination == second->destination
+			&& first->excludedFingerprint == second->excludedFingerprint
+			&& first->evcBucket == second->evcBucket
+			&& first->priority == second->priority
+			&& first->ordinal == second->ordinal
+			&& first->flags == second->flags
+			&& first->dlvConfidence == second->dlvConfidence);
+}
+
+/******************************************************************************
+ *
+ * \par Function Name:
+ *      is_cacheable_bundle
+ *
+ * \brief  Boolean: to know if the best routes of the bundle can be cached
+ *
+ *
+ * \par Date Written:
+ *      18/10/26
+ *
+ * \return int
+ *
+ * \retval   1   The bundle can use the route cache
+ * \retval   0   The bundle must be routed by the CGR
+ *
+ * \param[in]   *bundle    The bundle that has to be forwarded
+ *
+ * \par Notes:
+ *          1.  The bundles with a geographic route or an MSR route are never cached,
+ *              since the anti-loop mechanism and the MSR work on a per-bundle basis.
+ *
+ * \par Revision History:
+ *
+ *  DD/MM/YY |  AUTHOR         |   DESCRIPTION
+ *  -------- | --------------- | -----------------------------------------------
+ *  18/10/26 | agent           |  Initial Implementation and documentation.
+ *****************************************************************************/
+static int is_cacheable_bundle(CgrBundle *bundle)
+{
+	if (list_get_length(bundle->geoRoute) > 0
+			|| list_get_length(bundle->failedNeighbors) > 0
+			|| (bundle->msrRoute != NULL && list_get_length(bundle->msrRoute->hops) > 0))
+	{
+		return 0;
+	}
+
+	return 1;
+}
+
+/******************************************************************************
+ *
+ * \par Function Name:
+ *      is_valid_entry
+ *
+ * \brief  Boolean: to know if the cached routes can be used for the bundle
+ *
+ *
+ * \par Date Written:
+ *      18/10/26
+ *
+ * \return int
+ *
+ * \retval   1   The cached routes (or the unreachable destination) can be used for the bundle
+ * \retval   0   The bundle must be routed by the CGR
+ *
+ * \param[in]   *sap       The route cache
+ * \param[in]   *entry     The entry of the bundle's destination
+ * \param[in]   *bundle    The bundle that has to be forwarded
+ *
+ * \par Notes:
+ *          1.  The routes are accessed only if the entry is still up to date,
+ *              otherwise they may be already deleted.
+ *
+ * \par Revision History:
+ *
+ *  DD/MM/YY |  AUTHOR         |   DESCRIPTION
+ *  -------- | --------------- | -----------------------------------------------
+ *  18/10/26 | agent           |  Initial Implementation and documentation.
+ *  18/10/26 | agent           |  Added the negative entries.
+ *****************************************************************************/
+static int is_valid_entry(UniboCGRSAP* uniboCgrSap, RouteCacheSAP *sap, RouteCacheEntry *entry, CgrBundle *bundle)
+{
+	ListElt *routeElt, *hopElt;
+	Route *route;
+	Contact *contact;
+	const int64_t evc = convert_evc_to_mtv(bundle->evc);
+
+	if (!same_route_cache_key(&(entry->key), &(sap->currentKey))
+			|| entry->epoch != UniboCGRSAP_get_contact_plan_epoch(uniboCgrSap)
+			|| entry->mtvWatermark != sap->mtvWatermark
+			|| entry->expiry <= UniboCGRSAP_get_current_time(uniboCgrSap))
+	{
+		return 0;
+	}
+
+	if (entry->unreachable)
+	{
+		// a later deadline or a smaller EVC could find a route
+		return (bundle->expiration_time <= entry->deadline && bundle->evc >= entry->evc);
+	}
+
+	if (entry->routes->length == 0)
+	{
+		return 0;
+	}
+
+	for (routeElt = entry->routes->first; routeElt != NULL; routeElt = routeElt->next)
+	{
+		route = (Route*) routeElt->data;
+
+		if (route->pbat > bundle->expiration_time)
+		{
+			return 0;
+		}
+
+		for (hopElt = route->hops->first; hopElt != NULL; hopElt = hopElt->next)
+		{
+			contact = (Contact*) hopElt->data;
+			if (contact->mtv[bundle->priority_level] < evc)
+			{
+				return 0;
+			}
+		}
+	}
+
+	return 1;
+}
+
+/******************************************************************************
+ *
+ * \par Function Name:
+ *      route_cache_lookup
+ *
+ * \brief  Get the best routes of the bundle from the route cache
+ *
+ *
+ * \par Date Written:
+ *      18/10/26
+ *
+ * \return int
+ *
+ * \retval  "> 0"  Hit: the number of best routes (phase three volumes already updated)
+ * \retval     0   Miss: the bundle must be routed by the CGR
+ * \retval    -1   Hit: the destination is unreachable
+ * \retval    -2   MWITHDRAW error
+ *
+ * \param[in]   *bundle              The bundle that has to be forwarded
+ * \param[in]   excludedNeighbors    The excluded neighbors list (as passed by the interface)
+ * \param[out]  *bestRoutes          If result > 0: the list of best routes, NULL otherwise
+ *
+ * \par Notes:
+ *          1.  Call it before getBestRoutes changes the excluded neighbors list.
+ *          2.  After a miss the best routes computed by the CGR must be passed
+ *              to route_cache_store (or route_cache_store_unreachable if
+ *              the CGR does not find any route).
+ *          3.  The best routes list is valid until the next routing call.
+ *
+ * \par Revision History:
+ *
+ *  DD/MM/YY |  AUTHOR         |   DESCRIPTION
+ *  -------- | --------------- | -----------------------------------------------
+ *  18/10/26 | agent           |  Initial Implementation and documentation.
+ *  18/10/26 | agent           |  Added the negative entries.
+ *****************************************************************************/
+int route_cache_lookup(UniboCGRSAP* uniboCgrSap, CgrBundle *bundle, List excludedNeighbors, List *bestRoutes)
+{
+	RouteCacheSAP *sap = UniboCGRSAP_get_RouteCacheSAP(uniboCgrSap);
+	RouteCacheEntry arg, *entry;
+	RbtNode *node;
+	int result;
+
+	*bestRoutes = NULL;
+	sap->storeCurrent = 0;
+
+	if (!UniboCGRSAP_check_route_cache(uniboCgrSap) || !is_cacheable_bundle(bundle))
+	{
+		return 0;
+	}
+
+	compute_route_cache_key(bundle, excludedNeighbors, &(sap->currentKey));
+
+	arg.key.destination = sap->currentKey.destination;
+	node = rbt_search(sap->entries, &arg, NULL);
+	entry = (node != NULL) ? (RouteCacheEntry*) node->data : NULL;
+
+	if (entry != NULL && is_valid_entry(uniboCgrSap, sap, entry, bundle))
+	{
+		if (entry->unreachable)
+		{
+			sap->hits++;
+			return -1;
+		}
+
+		result = update_best_routes_volumes(uniboCgrSap, bundle, entry->routes); //phase three volumes
+		if (result < 0)
+		{
+			return result;
+		}
+
+		sap->hits++;
+		*bestRoutes = entry->routes;
+		return (int) entry->routes->length;
+	}
+
+	sap->misses++;
+	sap->storeCurrent = 1;
+
+	return 0;
+}
+
+/******************************************************************************
+ *
+ * \par Function Name:
+ *      replace_route_cache_entry
+ *
+ * \brief  Replace the entry of the current bundle's destination with an empty entry
+ *
+ *
+ * \par Date Written:
+ *      18/10/26
+ *
+ * \return RouteCacheEntry*
+ *
+ * \retval RouteCacheEntry*  The new entry (already in the cache)
+ * \retval NULL              MWITHDRAW error
+ *
+ * \param[in]   *sap   The route cache
+ *
+ * \par Revision History:
+ *
+ *  DD/MM/YY |  AUTHOR         |   DESCRIPTION
+ *  -------- | --------------- | -----------------------------------------------
+ *  18/10/26 | agent           |  Initial Implementation and documentation.
+ *****************************************************************************/
+static RouteCacheEntry* replace_route_cache_entry(UniboCGRSAP* uniboCgrSap, RouteCacheSAP *sap)
+{
+	RouteCacheEntry *entry;
+
+	route_cache_invalidate_destination(uniboCgrSap, sap->currentKey.destination);
+
+	entry = create_route_cache_entry();
+	if (entry == NULL)
+	{
+		return NULL;
+	}
+
+	entry->key = sap->currentKey;
+	entry->epoch = UniboCGRSAP_get_contact_plan_epoch(uniboCgrSap);
+	entry->mtvWatermark = sap->mtvWatermark;
+	entry->expiry = MAX_POSIX_TIME;
+
+	if (rbt_insert(sap->entries, entry) == NULL)
+	{
+		free_route_cache_entry(entry);
+		return NULL;
+	}
+
+	return entry;
+}
+
+/******************************************************************************
+ *
+ * \par Function Name:
+ *      route_cache_store
+ *
+ * \brief  Keep the best routes of the current bundle for the following bundles of the same class
+ *
+ *
+ * \par Date Written:
+ *      18/10/26
+ *
+ * \return int
+ *
+ * \retval   0   Success case (or nothing to store)
+ * \retval  -2   MWITHDRAW error
+ *
+ * \param[in]   bestRoutes   The best routes computed by the CGR for the bundle passed
+ *                           to the previous route_cache_lookup (that missed)
+ *
+ * \par Notes:
+ *          1.  The previous entry of the destination is replaced.
+ *
+ * \par Revision History:
+ *
+ *  DD/MM/YY |  AUTHOR         |   DESCRIPTION
+ *  -------- | --------------- | -----------------------------------------------
+ *  18/10/26 | agent           |  Initial Implementation and documentation.
+ *****************************************************************************/
+int route_cache_store(UniboCGRSAP* uniboCgrSap, List bestRoutes)
+{
+	RouteCacheSAP *sap = UniboCGRSAP_get_RouteCacheSAP(uniboCgrSap);
+	RouteCacheEntry *entry;
+	ListElt *elt;
+	Route *route;
+
+	if (!sap->storeCurrent)
+	{
+		return 0;
+	}
+
+	sap->storeCurrent = 0;
+
+	if (bestRoutes == NULL || bestRoutes->length == 0)
+	{
+		return 0;
+	}
+
+	entry = replace_route_cache_entry(uniboCgrSap, sap);
+	if (entry == NULL)
+	{
+		return -2;
+	}
+
+	for (elt = bestRoutes->first; elt != NULL; elt = elt->next)
+	{
+		route = (Route*) elt->data;
+		if (list_insert_last(entry->routes, route) == NULL)
+		{
+			route_cache_invalidate_destination(uniboCgrSap, sap->currentKey.destination);
+			return -2;
+		}
+		if (route->toTime < entry->expiry)
+		{
+			entry->expiry = route->toTime;
+		}
+	}
+
+	return 0;
+}
+
+/******************************************************************************
+ *
+ * \par Function Name:
+ *      route_cache_store_unreachable
+ *
+ * \brief  Keep the destination of the current bundle as unreachable
+ *         for the following bundles of the same class
+ *
+ *
+ * \par Date Written:
+ *      18/10/26
+ *
+ * \return int
+ *
+ * \retval   0   Success case (or nothing to store)
+ * \retval  -2   MWITHDRAW error
+ *
+ * \param[in]   *bundle   The bundle passed to the previous route_cache_lookup (that missed),
+ *                        for which the CGR did not find any route
+ *
+ * \par Notes:
+ *          1.  The entry is valid until the next contact start time: the CGR
+ *              result may depend on the local node backlog (e.g. the ETO),
+ *              so the destination is not kept unreachable forever.
+ *              The next start time comes from the contacts graph (see get_next_contact_start()),
+ *              staged contacts included.
+ *
+ * \par Revision History:
+ *
+ *  DD/MM/YY |  AUTHOR         |   DESCRIPTION
+ *  -------- | --------------- | -----------------------------------------------
+ *  18/10/26 | agent           |  Initial Implementation and documentation.
+ *****************************************************************************/
+int route_cache_store_unreachable(UniboCGRSAP* uniboCgrSap, CgrBundle *bundle)
+{
+	RouteCacheSAP *sap = UniboCGRSAP_get_RouteCacheSAP(uniboCgrSap);
+	RouteCacheEntry *entry;
+
+	if (!sap->storeCurrent)
+	{
+		return 0;
+	}
+
+	sap->storeCurrent = 0;
+
+	entry = replace_route_cache_entry(uniboCgrSap, sap);
+	if (entry == NULL)
+	{
+		return -2;
+	}
+
+	entry->unreachable = 1;
+	entry->deadline = bundle->expiration_time;
+	entry->evc = bundle->evc;
+	entry->expiry = get_next_contact_start(uniboCgrSap);
+
+	return 0;
+}
+
+/******************************************************************************
+ *
+ * \par Function Name:
+ *      route_cache_invalidate_destination
+ *
+ * \brief  Discard the cached routes of a destination
+ *
+ *
+ * \par Date Written:
+ *      18/10/26
+ *
+ * \return void
+ *
+ * \param[in]   destination   The ipn node number of the destination
+ *
+ * \par Notes:
+ *          1.  Phases one and two change the routes of the destination:
+ *              they must call this function before touching them.
+ *
+ * \par Revision History:
+ *
+ *  DD/MM/YY |  AUTHOR         |   DESCRIPTION
+ *  -------- | --------------- | -----------------------------------------------
+ *  18/10/26 | agent           |  Initial Implementation and documentation.
+ *****************************************************************************/
+void route_cache_invalidate_destination(UniboCGRSAP* uniboCgrSap, uint64_t destination)
+{
+	RouteCacheSAP *sap = UniboCGRSAP_get_RouteCacheSAP(uniboCgrSap);
+	RouteCacheEntry arg;
+
+	if (rbt_length(sap->entries) > 0)
+	{
+		arg.key.destination = destination;
+		rbt_delete(sap->entries, &arg);
+	}
+}
+
+/******************************************************************************
+ *
+ * \par Function Name:
+ *      route_cache_mtv_increased
+ *
+ * \brief  Raise the MTV watermark: all the entries filled before are discarded
+ *
+ *
+ * \par Date Written:
+ *      18/10/26
+ *
+ * \return void
+ *
+ * \par Notes:
+ *          1.  Call it each time some MTV is increased (e.g. a reservation is released),
+ *              since a route excluded for lack of volume could be viable again.
+ *
+ * \par Revision History:
+ *
+ *  DD/MM/YY |  AUTHOR         |   DESCRIPTION
+ *  -------- | --------------- | -----------------------------------------------
+ *  18/10/26 | agent           |  Initial Implementation and documentation.
+ *****************************************************************************/
+void route_cache_mtv_increased(UniboCGRSAP* uniboCgrSap)
+{
+	RouteCacheSAP *sap = UniboCGRSAP_get_RouteCacheSAP(uniboCgrSap);
+
+	sap->mtvWatermark++;
+}
+
+/******************************************************************************
+ *
+ * \par Function Name:
+ *      route_cache_get_counters
+ *
+ * \brief  Get the number of routing calls served (hits) and not served (misses) by the route cache
+ *
+ *
+ * \par Date Written:
+ *      18/10/26
+ *
+ * \return void
+ *
+ * \param[out]  *hits     The routing calls served by the cache, unreachable destinations included (can be NULL)
+ * \param[out]  *misses   The cacheable routing calls routed by the CGR (can be NULL)
+ *
+ * \par Revision History:
+ *
+ *  DD/MM/YY |  AUTHOR         |   DESCRIPTION
+ *  -------- | --------------- | -----------------------------------------------
+ *  18/10/26 | agent           |  Initial Implementation and documentation.
+ *****************************************************************************/
+void route_cache_get_counters(UniboCGRSAP* uniboCgrSap, uint64_t *hits, uint64_t *misses)
+{
+	RouteCacheSAP *sap = UniboCGRSAP_get_RouteCacheSAP(uniboCgrSap);
+
+	if (hits != NULL)
+	{
+		*hits = sap->hits;
+	}
+	if (misses != NULL)
+	{
+		*misses = sap->misses;
+	}
+}
@@ -0,0 +1,60 @@
+/** \file route_cache.h
+ *
+ * \brief  This file provides the declarations of the functions
+ *         to manage the per-destination cache of the routing results.
+ *
+ *
+ ** \copyright Copyright (c) 2020, Alma Mater Studiorum, University of Bologna, All rights reserved.
+ **
+ ** \par License
+ **
+ **    This file is part of Unibo-CGR.                                            <br>
+ **                                                                               <br>
+ **    Unibo-CGR is free software: you can redistribute it and/or modify
+ **    it under the terms of the GNU General Public License as published by
+ **    the Free Software Foundation, either version 3 of the License, or
+ **    (at your option) any later version.                                        <br>
+ **    Unibo-CGR is distributed in the hope that it will be useful,
+ **    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ **    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ **    GNU General Public License for more details.                               <br>
+ **                                                                               <br>
+ **    You should have received a copy of the GNU General Public License
+ **    along with Unibo-CGR.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  \author agent, agent@local
+ *
+ *  \par Supervisor
+ *       Carlo Caini, carlo.caini@unibo.it
+ */
+
+#ifndef SOURCES_CGR_ROUTE_CACHE_H_
+#define SOURCES_CGR_ROUTE_CACHE_H_
+
+#include <sys/time.h>
+
+#include "../UniboCGRSAP.h"
+#include "../library/commonDefines.h"
+#include "../library/list/list_type.h"
+#include "../bundles/bundles.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+extern int RouteCacheSAP_open(UniboCGRSAP* uniboCgrSap);
+extern void RouteCacheSAP_close(UniboCGRSAP* uniboCgrSap);
+
+extern int route_cache_lookup(UniboCGRSAP* uniboCgrSap, CgrBundle *bundle, List excludedNeighbors, List *bestRoutes);
+extern int route_cache_store(UniboCGRSAP* uniboCgrSap, List bestRoutes);
+extern int route_cache_store_unreachable(UniboCGRSAP* uniboCgrSap, CgrBundle *bundle);
+extern void route_cache_invalidate_destination(UniboCGRSAP* uniboCgrSap, uint64_t destination);
+extern void route_cache_mtv_increased(UniboCGRSAP* uniboCgrSap);
+extern void route_cache_get_counters(UniboCGRSAP* uniboCgrSap, uint64_t *hits, uint64_t *misses);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SOURCES_CGR_ROUTE_CACHE_H_ */
@@ -239,6 +239,101 @@
 
 
 
+/************************************************************************************/
+/************************************************************************************/
+/****************************** CONTACT PLAN LOADING  *******************************/
+/************************************************************************************/
+/************************************************************************************/
+
+/*
+ * In this section you find the macros used by the contact plan text parser
+ * (UniboCGR_contact_plan_load_text()).
+ */
+
+#ifndef TEXT_PLAN_MAX_THREADS
+/**
+ * \brief   Maximum number of threads used to parse a contact plan text file.
+ *
+ * \details The file is split in line-aligned chunks parsed in parallel.
+ *          Set to 1 to parse in the calling thread only.
+ *
+ * \hideinitializer
+ */
+#define TEXT_PLAN_MAX_THREADS 8
+#endif
+
+#ifndef TEXT_PLAN_MIN_CHUNK_SIZE
+/**
+ * \brief   Minimum size (bytes) of the chunk parsed by each thread.
+ *
+ * \details Smaller files are parsed by fewer threads.
+ *
+ * \hideinitializer
+ */
+#define TEXT_PLAN_MIN_CHUNK_SIZE (1024 * 1024)
+#endif
+
+/************************************************************************************/
+/************************************************************************************/
+/************************************************************************************/
+/************************************************************************************/
+/************************************************************************************/
+
+
+
+
+/************************************************************************************/
+/************************************************************************************/
+/************************************ MEMORY ****************************************/
+/************************************************************************************/
+/************************************************************************************/
+
+/*
+ * In this section you find the macros used by the memory pools of each instance.
+ * The pools take their memory with MWITHDRAW, so they also work on top of
+ * the allocator set with UniboCGR_setup_memory_allocator().
+ */
+
+#ifndef MEMORY_POOLS
+/**
+ * \brief Boolean: Set to 1 to take contacts, routes, ListElts and RbtNodes from slab pools
+ *        and the per-call lists from a scratch arena, 0 to allocate each of them with MWITHDRAW.
+ *
+ * \par Notes:
+ *          1. Set to 0 when you look for memory errors with an external tool (e.g. valgrind).
+ *
+ * \hideinitializer
+ */
+#define MEMORY_POOLS 1
+#endif
+
+#ifndef MEMORY_POOLS_SLAB_ELEMENTS
+/**
+ * \brief   Number of elements allocated with each MWITHDRAW by a slab pool.
+ *
+ * \hideinitializer
+ */
+#define MEMORY_POOLS_SLAB_ELEMENTS 256
+#endif
+
+#ifndef SCRATCH_ARENA_CHUNK_SIZE
+/**
+ * \brief   Size (bytes) of each chunk allocated by the scratch arena of the routing calls.
+ *
+ * \hideinitializer
+ */
+#define SCRATCH_ARENA_CHUNK_SIZE (16 * 1024)
+#endif
+
+/************************************************************************************/
+/************************************************************************************/
+/************************************************************************************/
+/************************************************************************************/
+/************************************************************************************/
+
+
+
+
 /************************************************************************************/
 /************************************************************************************/
 /******************************* FATAL ERROR SECTION  *******************************/
@@ -266,6 +361,26 @@
 #if (MIN_CONVERGENCE_LAYER_OVERHEAD < 0)
 #error MIN_CONVERGENCE_LAYER_OVERHEAD cannot be negative.
 #endif
+
+#if (TEXT_PLAN_MAX_THREADS < 1)
+#error TEXT_PLAN_MAX_THREADS must be greater than 0.
+#endif
+
+#if (TEXT_PLAN_MIN_CHUNK_SIZE < 1)
+#error TEXT_PLAN_MIN_CHUNK_SIZE must be greater than 0.
+#endif
+
+#if (MEMORY_POOLS != 0 && MEMORY_POOLS != 1)
+#error MEMORY_POOLS must be 0 or 1.
+#endif
+
+#if (MEMORY_POOLS_SLAB_ELEMENTS < 1)
+#error MEMORY_POOLS_SLAB_ELEMENTS must be greater than 0.
+#endif
+
+#if (SCRATCH_ARENA_CHUNK_SIZE < 1)
+#error SCRATCH_ARENA_CHUNK_SIZE must be greater than 0.
+#endif
 /**
  * \endcond
  */
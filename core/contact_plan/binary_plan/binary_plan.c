@@ -0,0 +1,405 @@
+/** \file binary_plan.c
+ *
+ *  \brief  This file provides the implementation of the functions
+ *          to write and map a binary contact plan.
+ *
+ *
+ ** \copyright Copyright (c) 2020, Alma Mater Studiorum, University of Bologna, All rights reserved.
+ **
+ ** \par License
+ **
+ **    This file is part of Unibo-CGR.                                            <br>
+ **                                                                               <br>
+ **    Unibo-CGR is free software: you can redistribute it and/or modify
+ **    it under the terms of the GNU General Public License as published by
+ **    the Free Software Foundation, either version 3 of the License, or
+ **    (at your option) any later version.                                        <br>
+ **    Unibo-CGR is distributed in the hope that it will be useful,
+ **    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ **    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ **    GNU General Public License for more details.                               <br>
+ **                                                                               <br>
+ **    You should have received a copy of the GNU General Public License
+ **    along with Unibo-CGR.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  \author agent, agent@local
+ *
+ *  \par Supervisor
+ *       Carlo Caini, carlo.caini@unibo.it
+ */
+
+#include "binary_plan.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/******************************************************************************
+ *
+ * \par Function Name:
+ *      compare_binary_contacts
+ *
+ * \brief  qsort() comparator: same order of the contacts graph
+ *         (fromNode, toNode, fromTime).
+ *
+ *
+ * \par Date Written:
+ *      18/10/26
+ *
+ * \return int
+ *
+ * \param[in]	*first    Pointer to the first BinaryPlanContact
+ * \param[in]	*second   Pointer to the second BinaryPlanContact
+ *
+ * \par Revision History:
+ *
+ *  DD/MM/YY |  AUTHOR         |   DESCRIPTION
+ *  -------- | --------------- | -----------------------------------------------
+ *  18/10/26 | agent           |  Initial Implementation and documentation.
+ *****************************************************************************/
+static int compare_binary_contacts(const void *first, const void *second)
+{
+	const BinaryPlanContact *a = (const BinaryPlanContact*) first;
+	const BinaryPlanContact *b = (const BinaryPlanContact*) second;
+
+	if (a->fromNode != b->fromNode)
+	{
+		return (a->fromNode < b->fromNode) ? -1 : 1;
+	}
+	if (a->toNode != b->toNode)
+	{
+		return (a->toNode < b->toNode) ? -1 : 1;
+	}
+	if (a->fromTime != b->fromTime)
+	{
+		return (a->fromTime < b->fromTime) ? -1 : 1;
+	}
+
+	return 0;
+}
+
+/******************************************************************************
+ *
+ * \par Function Name:
+ *      compare_binary_ranges
+ *
+ * \brief  qsort() comparator: same order of the ranges graph
+ *         (fromNode, toNode, fromTime).
+ *
+ *
+ * \par Date Written:
+ *      18/10/26
+ *
+ * \return int
+ *
+ * \param[in]	*first    Pointer to the first BinaryPlanRange
+ * \param[in]	*second   Pointer to the second BinaryPlanRange
+ *
+ * \par Revision History:
+ *
+ *  DD/MM/YY |  AUTHOR         |   DESCRIPTION
+ *  -------- | --------------- | -----------------------------------------------
+ *  18/10/26 | agent           |  Initial Implementation and documentation.
+ *****************************************************************************/
+static int compare_binary_ranges(const void *first, const void *second)
+{
+	const BinaryPlanRange *a = (const BinaryPlanRange*) first;
+	const BinaryPlanRange *b = (const BinaryPlanRange*) second;
+
+	if (a->fromNode != b->fromNode)
+	{
+		return (a->fromNode < b->fromNode) ? -1 : 1;
+	}
+	if (a->toNode != b->toNode)
+	{
+		return (a->toNode < b->toNode) ? -1 : 1;
+	}
+	if (a->fromTime != b->fromTime)
+	{
+		return (a->fromTime < b->fromTime) ? -1 : 1;
+	}
+
+	return 0;
+}
+
+/******************************************************************************
+ *
+ * \par Function Name:
+ *      binary_plan_write
+ *
+ * \brief  Write a binary contact plan file
+ *
+ *
+ * \par Date Written:
+ *      18/10/26
+ *
+ * \return int
+ *
+ * \retval   0  Success case
+ * \retval  -1  Cannot open or write the file
+ *
+ * \param[in]      *fileName         The file to (over)write
+ * \param[in,out]  *contacts         The contacts, they will be sorted
+ * \param[in]      contactsCount     The number of contacts
+ * \param[in,out]  *ranges           The ranges, they will be sorted
+ * \param[in]      rangesCount       The number of ranges
+ * \param[in]      writeAdjacency    Set to != 0 to append the adjacency section
+ *
+ * \par Notes:
+ *          1.  The records are only sorted, they are not validated:
+ *              overlapping contacts are refused when the file is loaded.
+ *
+ * \par Revision History:
+ *
+ *  DD/MM/YY |  AUTHOR         |   DESCRIPTION
+ *  -------- | --------------- | -----------------------------------------------
+ *  18/10/26 | agent           |  Initial Implementation and documentation.
+ *****************************************************************************/
+int binary_plan_write(const char *fileName,
+		BinaryPlanContact *contacts, uint64_t contactsCount,
+		BinaryPlanRange *ranges, uint64_t rangesCount,
+		int writeAdjacency)
+{
+	BinaryPlanHeader header;
+	BinaryPlanAdjacency adjacency;
+	FILE *file;
+	uint64_t i, adjacencyCount = 0;
+	int result = 0;
+
+	if (contactsCount > 0)
+	{
+		qsort(contacts, contactsCount, sizeof(BinaryPlanContact), compare_binary_contacts);
+	}
+	if (rangesCount > 0)
+	{
+		qsort(ranges, rangesCount, sizeof(BinaryPlanRange), compare_binary_ranges);
+	}
+
+	if (writeAdjacency)
+	{
+		for (i = 0; i < contactsCount; i++)
+		{
+			if (i == 0 || contacts[i].fromNode != contacts[i - 1].fromNode)
+			{
+				adjacencyCount++;
+			}
+		}
+	}
+
+	memset(&header, 0, sizeof(BinaryPlanHeader));
+	memcpy(header.magic, BINARY_PLAN_MAGIC, sizeof(header.magic));
+	header.version = BINARY_PLAN_VERSION;
+	header.byteOrder = BINARY_PLAN_BYTE_ORDER;
+	header.headerSize = sizeof(BinaryPlanHeader);
+	header.contactRecordSize = sizeof(BinaryPlanContact);
+	header.rangeRecordSize = sizeof(BinaryPlanRange);
+	header.adjacencyRecordSize = sizeof(BinaryPlanAdjacency);
+	header.contactsCount = contactsCount;
+	header.contactsOffset = sizeof(BinaryPlanHeader);
+	header.rangesCount = rangesCount;
+	header.rangesOffset = header.contactsOffset + contactsCount * sizeof(BinaryPlanContact);
+	header.adjacencyCount = adjacencyCount;
+	header.adjacencyOffset = header.rangesOffset + rangesCount * sizeof(BinaryPlanRange);
+
+	file = fopen(fileName, "wb");
+	if (file == NULL)
+	{
+		return -1;
+	}
+
+	if (fwrite(&header, sizeof(BinaryPlanHeader), 1, file) != 1
+			|| fwrite(contacts, sizeof(BinaryPlanContact), contactsCount, file) != contactsCount
+			|| fwrite(ranges, sizeof(BinaryPlanRange), rangesCount, file) != rangesCount)
+	{
+		result = -1;
+	}
+
+	for (i = 0; result == 0 && adjacencyCount > 0 && i < contactsCount; i++)
+	{
+		if (i == 0 || contacts[i].fromNode != contacts[i - 1].fromNode)
+		{
+			adjacency.fromNode = contacts[i].fromNode;
+			adjacency.firstContact = i;
+			adjacency.contactsCount = 0;
+		}
+		adjacency.contactsCount++;
+		if (i + 1 == contactsCount || contacts[i + 1].fromNode != adjacency.fromNode)
+		{
+			if (fwrite(&adjacency, sizeof(BinaryPlanAdjacency), 1, file) != 1)
+			{
+				result = -1;
+			}
+		}
+	}
+
+	if (fclose(file) != 0)
+	{
+		result = -1;
+	}
+
+	return result;
+}
+
+/******************************************************************************
+ *
+ * \par Function Name:
+ *      check_section
+ *
+ * \brief  Check that a section of "count" records lies within the file.
+ *
+ *
+ * \par Date Written:
+ *      18/10/26
+ *
+ * \return int
+ *
+ * \retval   1  The section is valid
+ * \retval   0  The section is not valid
+ *
+ * \param[in]   fileSize     The size of the file
+ * \param[in]   offset       The section's offset
+ * \param[in]   count        The number of records
+ * \param[in]   recordSize   The size of each record
+ *
+ * \par Revision History:
+ *
+ *  DD/MM/YY |  AUTHOR         |   DESCRIPTION
+ *  -------- | --------------- | -----------------------------------------------
+ *  18/10/26 | agent           |  Initial Implementation and documentation.
+ *****************************************************************************/
+static int check_section(size_t fileSize, uint64_t offset, uint64_t count, size_t recordSize)
+{
+	if (offset % 8 != 0 || offset > fileSize)
+	{
+		return 0;
+	}
+
+	return (count <= (fileSize - offset) / recordSize);
+}
+
+/******************************************************************************
+ *
+ * \par Function Name:
+ *      binary_plan_map
+ *
+ * \brief  Map a binary contact plan file in memory (read only) and check its header.
+ *
+ *
+ * \par Date Written:
+ *      18/10/26
+ *
+ * \return int
+ *
+ * \retval   0  Success case: call binary_plan_unmap() when done
+ * \retval  -1  Cannot open or map the file
+ * \retval  -3  The file is not a binary contact plan of this version
+ *              (or it has been written on a host with different endianness)
+ *
+ * \param[in]   *fileName   The file to map
+ * \param[out]  *plan       The mapped contact plan
+ *
+ * \par Notes:
+ *          1.  The records are not parsed: the caller reads them in place.
+ *
+ * \par Revision History:
+ *
+ *  DD/MM/YY |  AUTHOR         |   DESCRIPTION
+ *  -------- | --------------- | -----------------------------------------------
+ *  18/10/26 | agent           |  Initial Implementation and documentation.
+ *****************************************************************************/
+int binary_plan_map(const char *fileName, BinaryPlan *plan)
+{
+	struct stat info;
+	const BinaryPlanHeader *header;
+	const char *base;
+	void *address;
+	size_t size;
+	int fd;
+
+	memset(plan, 0, sizeof(BinaryPlan));
+
+	fd = open(fileName, O_RDONLY);
+	if (fd < 0)
+	{
+		return -1;
+	}
+
+	if (fstat(fd, &info) != 0)
+	{
+		close(fd);
+		return -1;
+	}
+
+	size = (size_t) info.st_size;
+	if (size < sizeof(BinaryPlanHeader))
+	{
+		close(fd);
+		return -3;
+	}
+
+	address = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (address == MAP_FAILED)
+	{
+		return -1;
+	}
+
+	plan->base = address;
+	plan->size = size;
+
+	base = (const char*) address;
+	header = (const BinaryPlanHeader*) base;
+
+	if (memcmp(header->magic, BINARY_PLAN_MAGIC, sizeof(header->magic)) != 0
+			|| header->version != BINARY_PLAN_VERSION
+			|| header->byteOrder != BINARY_PLAN_BYTE_ORDER
+			|| header->headerSize != sizeof(BinaryPlanHeader)
+			|| header->contactRecordSize != sizeof(BinaryPlanContact)
+			|| header->rangeRecordSize != sizeof(BinaryPlanRange)
+			|| header->adjacencyRecordSize != sizeof(BinaryPlanAdjacency)
+			|| !check_section(size, header->contactsOffset, header->contactsCount, sizeof(BinaryPlanContact))
+			|| !check_section(size, header->rangesOffset, header->rangesCount, sizeof(BinaryPlanRange))
+			|| !check_section(size, header->adjacencyOffset, header->adjacencyCount, sizeof(BinaryPlanAdjacency)))
+	{
+		binary_plan_unmap(plan);
+		return -3;
+	}
+
+	plan->header = header;
+	plan->contacts = (const BinaryPlanContact*) (base + header->contactsOffset);
+	plan->ranges = (const BinaryPlanRange*) (base + header->rangesOffset);
+	plan->adjacency = (header->adjacencyCount > 0) ? (const BinaryPlanAdjacency*) (base + header->adjacencyOffset) : NULL;
+
+	return 0;
+}
+
+/******************************************************************************
+ *
+ * \par Function Name:
+ *      binary_plan_unmap
+ *
+ * \brief  Release a contact plan mapped by binary_plan_map()
+ *
+ *
+ * \par Date Written:
+ *      18/10/26
+ *
+ * \return void
+ *
+ * \param[in,out]  *plan   The mapped contact plan
+ *
+ * \par Revision History:
+ *
+ *  DD/MM/YY |  AUTHOR         |   DESCRIPTION
+ *  -------- | --------------- | -----------------------------------------------
+ *  18/10/26 | agent           |  Initial Implementation and documentation.
+ *****************************************************************************/
+void binary_plan_unmap(BinaryPlan *plan)
+{
+	if (plan->base != NULL)
+	{
+		munmap(plan->base, plan->size);
+	}
+	memset(plan, 0, sizeof(BinaryPlan));
+}
@@ -0,0 +1,163 @@
+/** \file binary_plan.h
+ *
+ * \brief  This file provides the definition of the binary contact plan file format,
+ *         with all the declarations of the functions to write and map a binary contact plan.
+ *
+ * \details File layout (all the fields in host byte order):
+ *          - BinaryPlanHeader
+ *          - contactsCount BinaryPlanContact, sorted as the contacts graph
+ *            (fromNode, toNode, fromTime)
+ *          - rangesCount BinaryPlanRange, sorted as the ranges graph
+ *            (fromNode, toNode, fromTime)
+ *          - adjacencyCount BinaryPlanAdjacency (optional, adjacencyCount can be 0),
+ *            sorted by fromNode
+ *
+ *          Every section starts at an offset multiple of 8, so the records
+ *          can be read in place from the mapped file.
+ *
+ *
+ ** \copyright Copyright (c) 2020, Alma Mater Studiorum, University of Bologna, All rights reserved.
+ **
+ ** \par License
+ **
+ **    This file is part of Unibo-CGR.                                            <br>
+ **                                                                               <br>
+ **    Unibo-CGR is free software: you can redistribute it and/or modify
+ **    it under the terms of the GNU General Public License as published by
+ **    the Free Software Foundation, either version 3 of the License, or
+ **    (at your option) any later version.                                        <br>
+ **    Unibo-CGR is distributed in the hope that it will be useful,
+ **    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ **    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ **    GNU General Public License for more details.                               <br>
+ **                                                                               <br>
+ **    You should have received a copy of the GNU General Public License
+ **    along with Unibo-CGR.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  \author agent, agent@local
+ *
+ *  \par Supervisor
+ *       Carlo Caini, carlo.caini@unibo.it
+ */
+
+#ifndef SOURCES_CONTACTS_PLAN_BINARY_PLAN_BINARY_PLAN_H_
+#define SOURCES_CONTACTS_PLAN_BINARY_PLAN_BINARY_PLAN_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "../../library/commonDefines.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#define BINARY_PLAN_MAGIC "UCGRPLAN"
+#define BINARY_PLAN_VERSION 1
+/**
+ * \brief Written as uint32_t: a file written on a host with different endianness
+ *        is refused.
+ */
+#define BINARY_PLAN_BYTE_ORDER 0x01020304
+
+typedef struct
+{
+	/**
+	 * \brief BINARY_PLAN_MAGIC (without the terminating '\0')
+	 */
+	char magic[8];
+	uint32_t version;
+	uint32_t byteOrder;
+	/**
+	 * \brief Size of the header and of each record, checked when the file is mapped
+	 */
+	uint32_t headerSize;
+	uint32_t contactRecordSize;
+	uint32_t rangeRecordSize;
+	uint32_t adjacencyRecordSize;
+	uint64_t contactsCount;
+	uint64_t contactsOffset;
+	uint64_t rangesCount;
+	uint64_t rangesOffset;
+	/**
+	 * \brief 0 if the file has not the adjacency section
+	 */
+	uint64_t adjacencyCount;
+	uint64_t adjacencyOffset;
+} BinaryPlanHeader;
+
+typedef struct
+{
+	uint64_t fromNode;
+	uint64_t toNode;
+	/**
+	 * \brief Start time, relative to the time offset given at load time
+	 */
+	int64_t fromTime;
+	/**
+	 * \brief End time, relative to the time offset given at load time
+	 */
+	int64_t toTime;
+	/**
+	 * \brief In bytes per second
+	 */
+	uint64_t xmitRate;
+	/**
+	 * \brief Bulk, normal, expedited (bytes)
+	 */
+	double mtv[3];
+	float confidence;
+	uint32_t reserved;
+} BinaryPlanContact;
+
+typedef struct
+{
+	uint64_t fromNode;
+	uint64_t toNode;
+	int64_t fromTime;
+	int64_t toTime;
+	/**
+	 * \brief One way light time (seconds)
+	 */
+	uint64_t owlt;
+} BinaryPlanRange;
+
+typedef struct
+{
+	uint64_t fromNode;
+	/**
+	 * \brief Index (in the contacts section) of the first contact sent by fromNode
+	 */
+	uint64_t firstContact;
+	/**
+	 * \brief Number of contacts sent by fromNode, they are contiguous
+	 */
+	uint64_t contactsCount;
+} BinaryPlanAdjacency;
+
+/**
+ * \brief A binary contact plan mapped in memory (read only).
+ */
+typedef struct
+{
+	void *base;
+	size_t size;
+	const BinaryPlanHeader *header;
+	const BinaryPlanContact *contacts;
+	const BinaryPlanRange *ranges;
+	const BinaryPlanAdjacency *adjacency;
+} BinaryPlan;
+
+extern int binary_plan_write(const char *fileName,
+		BinaryPlanContact *contacts, uint64_t contactsCount,
+		BinaryPlanRange *ranges, uint64_t rangesCount,
+		int writeAdjacency);
+extern int binary_plan_map(const char *fileName, BinaryPlan *plan);
+extern void binary_plan_unmap(BinaryPlan *plan);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SOURCES_CONTACTS_PLAN_BINARY_PLAN_BINARY_PLAN_H_ */
@@ -34,8 +34,11 @@
 
 #include "../../library/commonDefines.h"
 #include "../../library/list/list.h"
+#include "../../library/heap/heap.h"
 #include "../../library_from_ion/rbt/rbt.h"
 #include "../../routes/routes.h"
+#include "../nodes/node_index.h"
+#include "../../library/pool/pool.h"
 
 /**
  * \brief Get the absolute value of "a"
@@ -50,7 +53,8 @@
 static void erase_contact(Contact*);
 
 static void erase_contact_note(ContactNote *note);
-static ContactNote* create_contact_note();
+static void add_contact_to_heaps(ContactSAP *sap, Contact *contact);
+static void release_staged_contacts(ContactSAP *sap);
 
 /**
  * \brief This struct is used to keep in one place all the data used by
@@ -62,10 +66,38 @@ struct ContactSAP {
 	 */
 	Rbt *contacts;
 	/**
-	 * \brief The time of the next contact that expires.
+	 * \brief The expiration times (toTime) of the contacts, lowest first.
+	 *
+	 * \details It can hold stale entries (contacts deleted or revised),
+	 *          discarded when they reach the top.
 	 */
-	time_t timeContactToRemove;
-
+	Heap expirations;
+	/**
+	 * \brief The start times (fromTime) of the contacts not yet started, lowest first.
+	 *
+	 * \details Same stale entries of the expiration heap; the entries of the contacts
+	 *          already started are discarded by get_next_contact_start().
+	 */
+	Heap starts;
+	/**
+	 * \brief Set to 1 if an expiration or start time could not be stored (MWITHDRAW error):
+	 *        the heaps must be rebuilt from the contacts graph.
+	 */
+	int rebuildHeaps;
+	/**
+	 * \brief Horizon mode: the contacts with fromTime >= horizonLimit are not in the graph
+	 *        but staged. MAX_POSIX_TIME if every contact is in the graph.
+	 */
+	time_t horizonLimit;
+	/**
+	 * \brief The staged contacts, sorted by fromTime: the next one to promote is staged[stagedFirst].
+	 *
+	 * \details Only the contacts that fit a CompactContact are staged, the others stay in the graph.
+	 */
+	CompactContact *staged;
+	uint32_t stagedFirst;
+	uint32_t stagedCount;
+	uint32_t stagedCapacity;
 };
 
 /******************************************************************************
@@ -91,6 +123,7 @@ struct ContactSAP {
  *  -------- | --------------- | -----------------------------------------------
  *  13/01/20 | L. Persampieri  |  Initial Implementation and documentation.
  *  21/10/22 | L. Persampieri  |  Renamed function
+ *  18/10/26 | agent           |  Initialize the expiration heap.
  *****************************************************************************/
 int ContactSAP_open(UniboCGRSAP* uniboCgrSap)
 {
@@ -100,12 +133,15 @@ int ContactSAP_open(UniboCGRSAP* uniboCgrSap)
     if (!sap) { return -2; }
     UniboCGRSAP_set_ContactSAP(uniboCgrSap, sap);
     memset(sap, 0, sizeof(ContactSAP));
-    sap->timeContactToRemove = MAX_POSIX_TIME;
+    heap_init(&sap->expirations);
+    heap_init(&sap->starts);
+    sap->horizonLimit = MAX_POSIX_TIME;
     sap->contacts = rbt_create(free_contact, compare_contacts);
     if (!sap->contacts) {
         ContactSAP_close(uniboCgrSap);
         return -2;
     }
+    rbt_set_node_pool(sap->contacts, UniboCGRSAP_get_rbt_node_pool(uniboCgrSap));
 
     return 0;
 }
@@ -114,16 +150,123 @@ void ContactSAP_decrease_time(UniboCGRSAP* uniboCgrSap, time_t diff) {
     Contact *current;
     RbtNode *node;
     ContactSAP* contactSap = UniboCGRSAP_get_ContactSAP(uniboCgrSap);
-    contactSap->timeContactToRemove = MAX_POSIX_TIME;
     for (current = get_first_contact(uniboCgrSap, &node); current != NULL; current = get_next_contact(&node))
     {
         current->fromTime -= diff;
         current->toTime -= diff;
-
-        if (current->toTime < contactSap->timeContactToRemove) {
-            contactSap->timeContactToRemove = current->toTime;
-        }
     }
+    for (uint32_t i = contactSap->stagedFirst; i < contactSap->stagedCount; i++)
+    {
+        contactSap->staged[i].fromTime -= (int32_t) diff;
+    }
+    if (contactSap->horizonLimit != MAX_POSIX_TIME)
+    {
+        contactSap->horizonLimit -= diff;
+    }
+    heap_shift_times(&contactSap->expirations, diff);
+    heap_shift_times(&contactSap->starts, diff);
+}
+
+/******************************************************************************
+ *
+ * \par Function Name:
+ *      rebuild_contact_heaps
+ *
+ * \brief  Fill the expiration heap with the toTime of every contact in the graph,
+ *         and the start heap with the fromTime.
+ *
+ * \par Date Written:
+ *      18/10/26
+ *
+ * \return int
+ *
+ * \retval   0   Success case
+ * \retval  -2   MWITHDRAW error
+ *
+ * \par Notes:
+ *              1. The stale entries are discarded.
+ *              2. The start times of the contacts already started are discarded
+ *                 by get_next_contact_start().
+ *
+ * \par Revision History:
+ *
+ *  DD/MM/YY |  AUTHOR         |   DESCRIPTION
+ *  -------- | --------------- | -----------------------------------------------
+ *  18/10/26 | agent           |  Initial Implementation and documentation.
+ *****************************************************************************/
+static int rebuild_contact_heaps(ContactSAP *sap)
+{
+	RbtNode *node;
+	Contact *contact;
+
+	heap_clear(&sap->expirations);
+	heap_clear(&sap->starts);
+	if (heap_reserve(&sap->expirations, (uint32_t) sap->contacts->length) < 0
+			|| heap_reserve(&sap->starts, (uint32_t) sap->contacts->length) < 0)
+	{
+		sap->rebuildHeaps = 1;
+		return -2;
+	}
+
+	for (node = rbt_first(sap->contacts); node != NULL; node = rbt_next(node))
+	{
+		contact = (Contact*) node->data;
+		if (contact != NULL)
+		{
+			// capacity already reserved, cannot fail
+			heap_push(&sap->expirations, contact->toTime, contact->fromNode, contact->toNode, contact->fromTime);
+			heap_push(&sap->starts, contact->fromTime, contact->fromNode, contact->toNode, contact->fromTime);
+		}
+	}
+
+	sap->rebuildHeaps = 0;
+	return 0;
+}
+
+/******************************************************************************
+ *
+ * \par Function Name:
+ *      add_contact_to_heaps
+ *
+ * \brief  Insert the expiration and start times of a contact (already in the graph)
+ *         in the expiration and start heaps.
+ *
+ * \par Date Written:
+ *      18/10/26
+ *
+ * \return void
+ *
+ * \par Notes:
+ *              1. When the stale entries outnumber the contacts the heaps are rebuilt,
+ *                 so their size stays O(contacts).
+ *              2. In case of MWITHDRAW error the heaps are marked to be rebuilt
+ *                 by the next removeExpiredContacts (or get_next_contact_start).
+ *              3. The start time is pushed even if the contact is already started:
+ *                 get_next_contact_start() discards it.
+ *
+ * \par Revision History:
+ *
+ *  DD/MM/YY |  AUTHOR         |   DESCRIPTION
+ *  -------- | --------------- | -----------------------------------------------
+ *  18/10/26 | agent           |  Initial Implementation and documentation.
+ *****************************************************************************/
+static void add_contact_to_heaps(ContactSAP *sap, Contact *contact)
+{
+	if (sap->rebuildHeaps)
+	{
+		return; // the whole heaps will be rebuilt anyway
+	}
+
+	if (sap->expirations.length >= 2 * sap->contacts->length + 64
+			|| sap->starts.length >= 2 * sap->contacts->length + 64)
+	{
+		rebuild_contact_heaps(sap);
+	}
+	else if (heap_push(&sap->expirations, contact->toTime, contact->fromNode, contact->toNode, contact->fromTime) < 0
+			|| heap_push(&sap->starts, contact->fromTime, contact->fromNode, contact->toNode, contact->fromTime) < 0)
+	{
+		sap->rebuildHeaps = 1;
+	}
 }
 
 
@@ -158,6 +301,10 @@ void discardAllRoutesFromContactsGraph(UniboCGRSAP* uniboCgrSap)
 
 	for (current = get_first_contact(uniboCgrSap, &node); current != NULL; current = get_next_contact(&node))
 	{
+		if (current->citations == NULL)
+		{
+			continue; // never cited
+		}
 		delete_fn = current->citations->delete_data_elt;
 		current->citations->delete_data_elt = NULL;
 		free_list_elts(current->citations);
@@ -181,18 +328,20 @@ void discardAllRoutesFromContactsGraph(UniboCGRSAP* uniboCgrSap)
  * \par Notes:
  *              1. For every expired contact we will call the deleteFn, actually that means:
  *                 all routes where the expired contact appears will be deleted.
- *              2. The timeContactToRemove will be redefined.
+ *              2. Only the contacts on top of the expiration heap are visited:
+ *                 O(expired * log(contacts)) instead of a scan of the contacts graph.
  *
  * \par Revision History:
  *
  *  DD/MM/YY |  AUTHOR         |   DESCRIPTION
  *  -------- | --------------- | -----------------------------------------------
  *  13/01/20 | L. Persampieri  |  Initial Implementation and documentation.
+ *  18/10/26 | agent           |  Pop the expired contacts from the expiration heap.
  *****************************************************************************/
 void removeExpiredContacts(UniboCGRSAP* uniboCgrSap)
 {
-	time_t min = MAX_POSIX_TIME;
 	Contact *contact;
+	HeapEntry *entry;
     const time_t time = UniboCGRSAP_get_current_time(uniboCgrSap);
 	RbtNode *node, *next;
 #if DEBUG_CGR
@@ -200,38 +349,47 @@ void removeExpiredContacts(UniboCGRSAP* uniboCgrSap)
 #endif
 	ContactSAP *sap = UniboCGRSAP_get_ContactSAP(uniboCgrSap);
 
-
-	if (time >= sap->timeContactToRemove)
+	if (sap->rebuildHeaps && rebuild_contact_heaps(sap) < 0)
 	{
-		debug_printf("Remove the expired contacts.");
+		// fallback: scan all the contacts graph
+		debug_printf("Remove the expired contacts (full scan).");
 		node = rbt_first(sap->contacts);
 		while (node != NULL)
 		{
 			next = rbt_next(node);
-			if (node->data != NULL)
+			contact = (Contact*) node->data;
+			if (contact != NULL && contact->toTime <= time)
 			{
-				contact = (Contact*) node->data;
+				rbt_delete(sap->contacts, contact);
+			}
+			node = next;
+		}
+		return;
+	}
 
-				if (contact->toTime <= time)
-				{
-					rbt_delete(sap->contacts, contact);
+	entry = heap_top(&sap->expirations);
+	if (entry != NULL && entry->expirationTime <= time)
+	{
+		debug_printf("Remove the expired contacts.");
+		while (entry != NULL && entry->expirationTime <= time)
+		{
+			contact = get_contact(uniboCgrSap, entry->fromNode, entry->toNode, entry->fromTime, NULL);
+			heap_pop(&sap->expirations);
+
+			// otherwise stale entry: contact already deleted or revised
+			if (contact != NULL && contact->toTime <= time)
+			{
+				rbt_delete(sap->contacts, contact);
 #if DEBUG_CGR
-					tot++;
+				tot++;
 #endif
-				}
-				else if (contact->toTime < min)
-				{
-					min = contact->toTime;
-				}
 			}
 
-			node = next;
+			entry = heap_top(&sap->expirations);
 		}
 
-		sap->timeContactToRemove = min;
-
 		debug_printf("Removed %u contacts, next remove contacts time: %ld", tot,
-				(long int ) sap->timeContactToRemove);
+				(long int ) ((entry != NULL) ? entry->expirationTime : MAX_POSIX_TIME));
 	}
 }
 
@@ -344,12 +502,14 @@ int revise_contact_start_time(UniboCGRSAP* uniboCgrSap, uint64_t fromNode, uint6
         }
     }
 
-    const double max_new_mtv = (contact->toTime - newFromTime)*contact->xmitRate;
+    const int64_t max_new_mtv = compute_contact_volume(contact->toTime - newFromTime, contact->xmitRate);
     for (int i = 0; i < 3; i++) {
         // reset MTVs to max values
         contact->mtv[i] = max_new_mtv;
     }
     contact->fromTime = newFromTime;
+    // the key of the contact changed
+    add_contact_to_heaps(UniboCGRSAP_get_ContactSAP(uniboCgrSap), contact);
     return 0;
 }
 /**
@@ -388,17 +548,14 @@ int revise_contact_end_time(UniboCGRSAP* uniboCgrSap, uint64_t fromNode, uint64_
         }
     }
 
-    const double max_new_mtv = (newEndTime - contact->fromTime)*contact->xmitRate;
+    const int64_t max_new_mtv = compute_contact_volume(newEndTime - contact->fromTime, contact->xmitRate);
     for (int i = 0; i < 3; i++) {
         // reset MTVs to max values
         contact->mtv[i] = max_new_mtv;
     }
     contact->toTime = newEndTime;
 
-    struct ContactSAP* contactSap = UniboCGRSAP_get_ContactSAP(uniboCgrSap);
-    if (contact->toTime < contactSap->timeContactToRemove) {
-        contactSap->timeContactToRemove = contact->toTime;
-    }
+    add_contact_to_heaps(UniboCGRSAP_get_ContactSAP(uniboCgrSap), contact);
     return 0;
 }
 
@@ -481,6 +638,7 @@ int revise_confidence(UniboCGRSAP* uniboCgrSap, uint64_t fromNode, uint64_t toNo
  *  DD/MM/YY |  AUTHOR         |   DESCRIPTION
  *  -------- | --------------- | -----------------------------------------------
  *  13/01/20 | L. Persampieri  |  Initial Implementation and documentation.
+ *  18/10/26 | agent           |  Integer MTV.
  *****************************************************************************/
 int revise_xmit_rate(UniboCGRSAP* uniboCgrSap, uint64_t fromNode, uint64_t toNode, time_t fromTime, uint64_t xmitRate)
 {
@@ -494,7 +652,7 @@ int revise_xmit_rate(UniboCGRSAP* uniboCgrSap, uint64_t fromNode, uint64_t toNod
 		if(contact != NULL)
 		{
 			contact->xmitRate = xmitRate;
-            const double max_new_mtv = (contact->toTime - contact->fromTime)*xmitRate;
+            const int64_t max_new_mtv = compute_contact_volume(contact->toTime - contact->fromTime, xmitRate);
             for (int i = 0; i < 3; i++) {
                 // reset MTVs to max values
                 contact->mtv[i] = max_new_mtv;
@@ -600,6 +758,36 @@ static void erase_contact(Contact *contact)
     contact->type = TypeScheduled;
 }
 
+/******************************************************************************
+ *
+ * \par Function Name:
+ *      release_staged_contacts
+ *
+ * \brief Delete the staged contacts (horizon mode), but not the staging array
+ *
+ *
+ * \par Date Written:
+ *      18/10/26
+ *
+ * \return void
+ *
+ * \par Notes:
+ *             1. After this call every contact is in the graph (horizonLimit is MAX_POSIX_TIME).
+ *
+ * \par Revision History:
+ *
+ *  DD/MM/YY |  AUTHOR         |   DESCRIPTION
+ *  -------- | --------------- | -----------------------------------------------
+ *  18/10/26 | agent           |  Initial Implementation and documentation.
+ *  18/10/26 | agent           |  Compact staged contacts: nothing to release one by one.
+ *****************************************************************************/
+static void release_staged_contacts(ContactSAP *sap)
+{
+	sap->stagedFirst = 0;
+	sap->stagedCount = 0;
+	sap->horizonLimit = MAX_POSIX_TIME;
+}
+
 /******************************************************************************
  *
  * \par Function Name:
@@ -622,13 +810,18 @@ static void erase_contact(Contact *contact)
  *  DD/MM/YY |  AUTHOR         |   DESCRIPTION
  *  -------- | --------------- | -----------------------------------------------
  *  13/01/20 | L. Persampieri  |  Initial Implementation and documentation.
+ *  18/10/26 | agent           |  Clear the expiration and start heaps.
+ *  18/10/26 | agent           |  Delete the staged contacts.
  *****************************************************************************/
 void reset_ContactsGraph(UniboCGRSAP* uniboCgrSap)
 {
 	ContactSAP *sap = UniboCGRSAP_get_ContactSAP(uniboCgrSap);
 
 	rbt_clear(sap->contacts);
-	sap->timeContactToRemove = MAX_POSIX_TIME;
+	heap_clear(&sap->expirations);
+	heap_clear(&sap->starts);
+	sap->rebuildHeaps = 0;
+	release_staged_contacts(sap);
 }
 
 /******************************************************************************
@@ -654,6 +847,8 @@ void reset_ContactsGraph(UniboCGRSAP* uniboCgrSap)
  *  -------- | --------------- | -----------------------------------------------
  *  13/01/20 | L. Persampieri  |  Initial Implementation and documentation.
  *  21/10/22 | L. Persampieri  |  Renamed function
+ *  18/10/26 | agent           |  Destroy the expiration and start heaps.
+ *  18/10/26 | agent           |  Delete the staged contacts.
  *****************************************************************************/
 void ContactSAP_close(UniboCGRSAP* uniboCgrSap)
 {
@@ -662,6 +857,13 @@ void ContactSAP_close(UniboCGRSAP* uniboCgrSap)
 	ContactSAP *sap = UniboCGRSAP_get_ContactSAP(uniboCgrSap);
 
 	rbt_destroy(sap->contacts);
+	heap_destroy(&sap->expirations);
+	heap_destroy(&sap->starts);
+	release_staged_contacts(sap);
+	if (sap->staged != NULL)
+	{
+		MDEPOSIT(sap->staged);
+	}
 
     memset(sap, 0, sizeof(ContactSAP));
     MDEPOSIT(sap);
@@ -703,264 +905,920 @@ static void erase_contact_note(ContactNote *note)
 /******************************************************************************
  *
  * \par Function Name:
- *      create_contact_note
+ *      delete_routes_citing_contact
  *
- * \brief  Allocate (with MWITHDRAW) a memory area for a ContactNote
+ * \brief  Delete every route where the contact appears
  *
  *
  * \par Date Written:
- *      13/01/20
+ *      18/10/26
  *
- * \return ContactNote*
+ * \return  void
  *
- * \retval ContactNote*  The new allocated ContactNote
- * \retval NULL          MWITHDRAW error)
+ * \param[in]	*contact   The contact for which we want to delete the routes
  *
  * \par Notes:
- *              1. The new allocated ContactNote will have all fields erased.
- *              2. You must check that the return value of this function is not NULL.
+ *              1. At the end the citations list of the contact is empty.
+ *              2. The other routes of the same destinations are not touched:
+ *                 used when the contact is deleted at its expiration, or with the whole graph.
  *
  * \par Revision History:
  *
  *  DD/MM/YY |  AUTHOR         |   DESCRIPTION
  *  -------- | --------------- | -----------------------------------------------
- *  13/01/20 | L. Persampieri  |  Initial Implementation and documentation.
+ *  18/10/26 | agent           |  Initial Implementation and documentation (moved from free_contact).
  *****************************************************************************/
-static ContactNote* create_contact_note()
+static void delete_routes_citing_contact(Contact *contact)
 {
-	ContactNote *note = (ContactNote*) MWITHDRAW(sizeof(ContactNote));
+	ListElt *current, *temp;
+	ListElt *hop;
+	Route *route;
+	int deleted;
 
-	if (note != NULL)
+	if (contact != NULL && contact->citations != NULL)
 	{
-		erase_contact_note(note);
-	}
+		current = contact->citations->first;
+		while (current != NULL)
+		{
+			deleted = 0;
+			temp = current->next;
+
+			if (current->data != NULL)
+			{
+				hop = (ListElt*) current->data;
+				if (hop->list != NULL)
+				{
+					if (hop->list->userData != NULL)
+					{
+						deleted = 1;
+						route = (Route*) hop->list->userData;
+						delete_cgr_route(route); //this function remove the citation
+					}
+				}
+			}
+			if (deleted == 0)
+			{
+				flush_verbose_debug_printf("Error!!!");
+				list_remove_elt(current);
+			}
 
-	return note;
+			current = temp;
+		}
+	}
 }
 
 /******************************************************************************
  *
  * \par Function Name:
- *      free_contact
+ *      discard_routes_citing_contact
  *
- * \brief  Delete the contact pointed by data
+ * \brief  Delete the routes of every destination reached through the contact
  *
  *
  * \par Date Written:
- *      13/01/20
+ *      18/10/26
  *
  * \return  void
  *
- * \param[in]	*data   The contact that we want to delete
+ * \param[in]	*contact   The contact for which we want to delete the routes
  *
  * \par Notes:
- *              1. This function delete every route where the contact (data) appears.
- *              2. This function will delete the contact in its totality, included the
- *                 ContactNote and citations's list.
- *              3. The delete function used to deallocate memory is: MDEPOSIT.
+ *              1. At the end the citations list of the contact is empty.
+ *              2. The RtgObject of each destination with a route through the contact
+ *                 is reset (see reset_rtg_object): the Yen's state of the destination
+ *                 was derived from that route, the next call starts again from phase one.
+ *              3. The destinations never reached through the contact are not touched.
  *
  * \par Revision History:
  *
  *  DD/MM/YY |  AUTHOR         |   DESCRIPTION
  *  -------- | --------------- | -----------------------------------------------
- *  13/01/20 | L. Persampieri  |  Initial Implementation and documentation.
+ *  18/10/26 | agent           |  Initial Implementation and documentation.
  *****************************************************************************/
-void free_contact(void *data)
+void discard_routes_citing_contact(Contact *contact)
 {
-	Contact *contact;
-	ListElt *current, *temp;
+	ListElt *current;
 	ListElt *hop;
 	Route *route;
-	int deleted;
 
-	if (data != NULL)
+	if (contact != NULL && contact->citations != NULL)
 	{
-		contact = (Contact*) data;
-		if (contact->routingObject != NULL)
-		{
-			MDEPOSIT(contact->routingObject);
-		}
-
-		if (contact->citations != NULL)
+		// each step deletes at least the route of the first citation
+		while ((current = contact->citations->first) != NULL)
 		{
-			current = contact->citations->first;
-			while (current != NULL)
+			route = NULL;
+			hop = (ListElt*) current->data;
+			if (hop != NULL && hop->list != NULL)
 			{
-				deleted = 0;
-				temp = current->next;
-
-				if (current->data != NULL)
-				{
-					hop = (ListElt*) current->data;
-					if (hop->list != NULL)
-					{
-						if (hop->list->userData != NULL)
-						{
-							deleted = 1;
-							route = (Route*) hop->list->userData;
-							delete_cgr_route(route); //this function remove the citation
-						}
-					}
-				}
-				if (deleted == 0)
-				{
-					flush_verbose_debug_printf("Error!!!");
-					list_remove_elt(current);
-				}
-
-				current = temp;
+				route = (Route*) hop->list->userData;
 			}
 
-			MDEPOSIT(contact->citations);
-
+			if (route == NULL)
+			{
+				flush_verbose_debug_printf("Error!!!");
+				list_remove_elt(current);
+			}
+			else if (route->referenceElt != NULL && route->referenceElt->list != NULL
+					&& route->referenceElt->list->userData != NULL)
+			{
+				reset_rtg_object((RtgObject*) route->referenceElt->list->userData);
+			}
+			else
+			{
+				delete_cgr_route(route); //this function remove the citation
+			}
 		}
-		erase_contact(contact);
-		MDEPOSIT(contact);
-		data = NULL;
 	}
 }
 
 /******************************************************************************
  *
  * \par Function Name:
- *      create_contact
+ *      insert_contact_citation
  *
- * \brief  Allocate memory for a new contact
+ * \brief  Cite the contact from a hop of a route
  *
  *
  * \par Date Written:
- *      13/01/20
+ *      18/10/26
  *
- * \return Contact*
+ * \return ListElt*
  *
- * \retval Contact*  The pointer to the allocated contact 
- * \retval NULL      MWITHDRAW error
+ * \retval  ListElt*  The citation, its data is the hop
+ * \retval  NULL      MWITHDRAW error
  *
- * \param[in]	fromNode      The contact's sender node
- * \param[in]	toNode        The contact's receiver node
- * \param[in]	fromTime      The contact's start time
- * \param[in]	toTime        The contact's end time
- * \param[in]	xmitRate      In bytes per second
- * \param[in]	confidence    The confidence that the contact will effectively materialize
- * \param[in]	type          The type of the contact (Registration or Scheduled)
+ * \param[in]	*contact   The contact
+ * \param[in]	*hop       The element of the hops list of the Route that points to the contact
  *
  * \par Notes:
- *             1. You must check that the return value of this function is not NULL.
+ *              1. The citations list of the contact is allocated here the first time,
+ *                 its ListElts are taken from the pool of the hops list (if any).
  *
  * \par Revision History:
  *
  *  DD/MM/YY |  AUTHOR         |   DESCRIPTION
  *  -------- | --------------- | -----------------------------------------------
- *  13/01/20 | L. Persampieri  |  Initial Implementation and documentation.
+ *  18/10/26 | agent           |  Initial Implementation and documentation.
  *****************************************************************************/
-Contact* create_contact(uint64_t fromNode, uint64_t toNode, time_t fromTime,
-		time_t toTime, uint64_t xmitRate, float confidence, CtType type)
+ListElt *insert_contact_citation(Contact *contact, ListElt *hop)
 {
-	Contact *contact = NULL;
-	double volume;
-	contact = (Contact*) MWITHDRAW(sizeof(Contact));
-
-	if (contact != NULL)
+	if (contact->citations == NULL)
 	{
-		contact->fromNode = fromNode;
-		contact->toNode = toNode;
-		contact->fromTime = fromTime;
-		contact->toTime = toTime;
-		contact->xmitRate = xmitRate;
-		contact->confidence = confidence;
-		contact->type = type;
-		/* NOTE: We assume that toTime - fromTime is greater or equal to 0 */
-		volume = (double) (xmitRate * ((uint64_t) (toTime - fromTime)));
-		contact->mtv[0] = volume;
-		contact->mtv[1] = volume;
-		contact->mtv[2] = volume;
-
 		contact->citations = list_create(contact, NULL, NULL, NULL);
 		if (contact->citations == NULL)
 		{
-			MDEPOSIT(contact);
-			contact = NULL;
-		}
-		else
-		{
-			contact->routingObject = create_contact_note();
-			if (contact->routingObject == NULL)
-			{
-				MDEPOSIT(contact->citations);
-				MDEPOSIT(contact);
-				contact = NULL;
-			}
+			return NULL;
 		}
+		// same ListElt pool of the hops list
+		list_set_elt_pool(contact->citations, hop->list->eltPool);
 	}
 
-	return contact;
+	return list_insert_last(contact->citations, hop);
 }
 
 /******************************************************************************
  *
  * \par Function Name:
- *      add_contact_to_graph
+ *      discard_routes_through_node_pair
  *
- * \brief  Allocate memory for a contact, set the fields of the contacts to the
- *         passed arguments and add the contact to the contacts graph
+ * \brief  Delete the routes of every destination reached through a hop from fromNode to toNode
  *
  *
  * \par Date Written:
- *      13/01/20
- *
- * \return int
+ *      18/10/26
  *
- * \retval   1   Success case: contact added to the contacts graph
- * \retval   0   Arguments error case
- * \retval  -1   Overlapped contact (don't change it)
- * \retval  -2   MWITHDRAW error
+ * \return  void
  *
- * \param[in]	fromNode           The contact's sender node
- * \param[in]	toNode             The contact's receiver node
- * \param[in]	fromTime           The contact's start time
- * \param[in]	toTime             The contact's end time
- * \param[in]	xmitRate           In bytes per second
- * \param[in]	confidence         The confidence that the contact will effectively materialize
- * \param[in]   copyMTV            Set to 1 if you want to copy the MTV from mtv input parameter.
- *                                 Set to 0 otherwise
- * \param[in]   mtv                The contact's MTV: this must be an array of 3 elements.
+ * \param[in]	fromNode   The sender node of the hop
+ * \param[in]	toNode     The receiver node of the hop
  *
  * \par Notes:
- *             1. This function will change timeContactToRemove if the contact->toTime of the
- *                new contact is less than the current timeContactToRemove, in that case
- *                timeContactToRemove will be equals to contact->toTime
- *             2. Set copyMTV to 1 if you want to be compatible with the data gets
- *                for example from an interface.
+ *              1. Used when a range between the two nodes changes: only the routes
+ *                 through a contact from fromNode to toNode depend on that range.
+ *              2. See discard_routes_citing_contact.
  *
  * \par Revision History:
  *
  *  DD/MM/YY |  AUTHOR         |   DESCRIPTION
  *  -------- | --------------- | -----------------------------------------------
- *  13/01/20 | L. Persampieri  |  Initial Implementation and documentation.
+ *  18/10/26 | agent           |  Initial Implementation and documentation.
  *****************************************************************************/
-int add_contact_to_graph(UniboCGRSAP* uniboCgrSap, uint64_t fromNode, uint64_t toNode, time_t fromTime,
-                         time_t toTime, uint64_t xmitRate, float confidence, int copyMTV, const double mtv[])
+void discard_routes_through_node_pair(UniboCGRSAP* uniboCgrSap, uint64_t fromNode, uint64_t toNode)
 {
-	int result;
-	int overlapped;
-	Contact *contact, *temp;
-	RbtNode *elt = NULL;
-	CtType contactType;
-	ContactSAP *sap;
+	Contact *current;
+	RbtNode *node;
 
-	if (fromNode == 0 || toNode == 0 || toTime < 0 || (fromTime > toTime) || confidence < 0.0
-			|| confidence > 1.0)
+	for (current = get_first_contact_from_node_to_node(uniboCgrSap, fromNode, toNode, &node);
+			current != NULL && current->fromNode == fromNode && current->toNode == toNode;
+			current = get_next_contact(&node))
 	{
-		result = 0;
+		discard_routes_citing_contact(current);
 	}
-	else
-	{
-		sap = UniboCGRSAP_get_ContactSAP(uniboCgrSap);
+}
 
-		result = -1;
-			if (fromTime >= 0) /*Type: Scheduled	*/
-			{
-				temp = get_first_contact_from_node_to_node(uniboCgrSap, fromNode, toNode, &elt);
+/******************************************************************************
+ *
+ * \par Function Name:
+ *      migrate_routes_to_contacts_graph
+ *
+ * \brief  Move the routes from the contacts of a previous contacts graph
+ *         to the contacts with the same key in the current one.
+ *
+ *
+ * \par Date Written:
+ *      18/10/26
+ *
+ * \return int
+ *
+ * \retval   1  The current graph may enable new routes (contacts added or widened)
+ * \retval   0  Otherwise
+ *
+ * \param[in]	*previousSap   The previous contacts graph, no more set in the SAP
+ *
+ * \par Notes:
+ *              1. Both graphs are walked once, in key order: no lookup and no allocation.
+ *              2. A route keeps its hops only if each contact is unchanged in the current graph,
+ *                 otherwise the routes of its destination are deleted (see discard_routes_citing_contact).
+ *                 At the end no route cites the previous graph.
+ *              3. The MTVs (bookings) of the contacts with the same end time and
+ *                 transmit rate are carried over from the previous graph.
+ *
+ * \par Revision History:
+ *
+ *  DD/MM/YY |  AUTHOR         |   DESCRIPTION
+ *  -------- | --------------- | -----------------------------------------------
+ *  18/10/26 | agent           |  Initial Implementation and documentation.
+ *****************************************************************************/
+int migrate_routes_to_contacts_graph(UniboCGRSAP* uniboCgrSap, ContactSAP *previousSap)
+{
+	ContactSAP *sap = UniboCGRSAP_get_ContactSAP(uniboCgrSap);
+	RbtNode *oldNode = rbt_first(previousSap->contacts);
+	RbtNode *newNode = rbt_first(sap->contacts);
+	Contact *oldContact, *newContact;
+	ListElt *elt;
+	List temp;
+	int result = 0;
+	int cmp, priority;
+
+	while (oldNode != NULL || newNode != NULL)
+	{
+		oldContact = (oldNode != NULL) ? (Contact*) oldNode->data : NULL;
+		newContact = (newNode != NULL) ? (Contact*) newNode->data : NULL;
+
+		if (oldContact == NULL)
+		{
+			cmp = 1;
+		}
+		else if (newContact == NULL)
+		{
+			cmp = -1;
+		}
+		else
+		{
+			cmp = compare_contacts(oldContact, newContact);
+		}
+
+		if (cmp < 0)
+		{
+			// removed
+			discard_routes_citing_contact(oldContact);
+			oldNode = rbt_next(oldNode);
+		}
+		else if (cmp > 0)
+		{
+			// added
+			result = 1;
+			newNode = rbt_next(newNode);
+		}
+		else
+		{
+			if (newContact->toTime == oldContact->toTime && newContact->xmitRate == oldContact->xmitRate)
+			{
+				// same volume: the bookings are still valid
+				for (priority = 0; priority < 3; priority++)
+				{
+					newContact->mtv[priority] = oldContact->mtv[priority];
+				}
+			}
+			if (newContact->toTime != oldContact->toTime
+					|| newContact->xmitRate != oldContact->xmitRate
+					|| newContact->confidence != oldContact->confidence)
+			{
+				if (newContact->toTime > oldContact->toTime
+						|| newContact->xmitRate > oldContact->xmitRate
+						|| newContact->confidence > oldContact->confidence)
+				{
+					result = 1;
+				}
+				discard_routes_citing_contact(oldContact);
+			}
+			else
+			{
+				if (oldContact->citations != NULL && oldContact->citations->length > 0
+						&& (newContact->citations == NULL || newContact->citations->length == 0))
+				{
+					// the hops now point to the new contact
+					temp = newContact->citations;
+					newContact->citations = oldContact->citations;
+					oldContact->citations = temp;
+					newContact->citations->userData = newContact;
+					if (oldContact->citations != NULL)
+					{
+						oldContact->citations->userData = oldContact;
+					}
+					for (elt = newContact->citations->first; elt != NULL; elt = elt->next)
+					{
+						((ListElt*) elt->data)->data = newContact;
+					}
+				}
+				else
+				{
+					discard_routes_citing_contact(oldContact);
+				}
+			}
+			oldNode = rbt_next(oldNode);
+			newNode = rbt_next(newNode);
+		}
+	}
+
+	return result;
+}
+
+/******************************************************************************
+ *
+ * \par Function Name:
+ *      free_contact
+ *
+ * \brief  Delete the contact pointed by data
+ *
+ *
+ * \par Date Written:
+ *      13/01/20
+ *
+ * \return  void
+ *
+ * \param[in]	*data   The contact that we want to delete
+ *
+ * \par Notes:
+ *              1. This function delete every route where the contact (data) appears.
+ *              2. This function will delete the contact in its totality, included the
+ *                 ContactNote and citations's list.
+ *              3. The delete function used to deallocate memory is: MDEPOSIT.
+ *
+ * \par Revision History:
+ *
+ *  DD/MM/YY |  AUTHOR         |   DESCRIPTION
+ *  -------- | --------------- | -----------------------------------------------
+ *  13/01/20 | L. Persampieri  |  Initial Implementation and documentation.
+ *  18/10/26 | agent           |  Routes deletion moved to delete_routes_citing_contact.
+ *  18/10/26 | agent           |  ContactNote allocated with the contact.
+ *  18/10/26 | agent           |  Contact pool.
+ *****************************************************************************/
+void free_contact(void *data)
+{
+	Contact *contact;
+	ContactBlock *block;
+
+	if (data != NULL)
+	{
+		contact = (Contact*) data;
+		// only the contacts created by create_contact() have a ContactNote
+		block = (contact->routingObject == NULL) ? NULL
+				: (ContactBlock*) (((char*) contact) - offsetof(ContactBlock, contact));
+
+		if (contact->citations != NULL)
+		{
+			delete_routes_citing_contact(contact);
+			MDEPOSIT(contact->citations);
+		}
+		erase_contact(contact);
+		if (block == NULL)
+		{
+			MDEPOSIT(contact);
+		}
+		else if (block->pool != NULL)
+		{
+			pool_release(block->pool, block);
+		}
+		else
+		{
+			MDEPOSIT(block);
+		}
+		data = NULL;
+	}
+}
+
+/******************************************************************************
+ *
+ * \par Function Name:
+ *      compute_contact_volume
+ *
+ * \brief  Compute the volume (bytes) that can be transmitted in a time interval at a given rate
+ *
+ *
+ * \par Date Written:
+ *      18/10/26
+ *
+ * \return int64_t
+ *
+ * \retval ">= 0"  The volume, saturated to INT64_MAX
+ *
+ * \param[in]	duration      The time interval in seconds (negative values are treated as 0)
+ * \param[in]	xmitRate      In bytes per second
+ *
+ * \par Revision History:
+ *
+ *  DD/MM/YY |  AUTHOR         |   DESCRIPTION
+ *  -------- | --------------- | -----------------------------------------------
+ *  18/10/26 | agent           |  Initial Implementation and documentation.
+ *****************************************************************************/
+int64_t compute_contact_volume(time_t duration, uint64_t xmitRate)
+{
+	if (duration <= 0 || xmitRate == 0)
+	{
+		return 0;
+	}
+	if ((uint64_t) duration > ((uint64_t) INT64_MAX) / xmitRate)
+	{
+		return INT64_MAX;
+	}
+
+	return (int64_t) ((uint64_t) duration * xmitRate);
+}
+
+/******************************************************************************
+ *
+ * \par Function Name:
+ *      convert_volume_to_mtv
+ *
+ * \brief  Convert a volume expressed as floating point (interface side) to the MTV representation
+ *
+ *
+ * \par Date Written:
+ *      18/10/26
+ *
+ * \return int64_t
+ *
+ * \retval int64_t  The volume truncated to bytes and saturated to [INT64_MIN, INT64_MAX]
+ *
+ * \param[in]	volume    The volume in bytes
+ *
+ * \par Revision History:
+ *
+ *  DD/MM/YY |  AUTHOR         |   DESCRIPTION
+ *  -------- | --------------- | -----------------------------------------------
+ *  18/10/26 | agent           |  Initial Implementation and documentation.
+ *****************************************************************************/
+int64_t convert_volume_to_mtv(double volume)
+{
+	if (volume != volume) // NaN
+	{
+		return 0;
+	}
+	if (volume >= 9223372036854775807.0)
+	{
+		return INT64_MAX;
+	}
+	if (volume <= -9223372036854775808.0)
+	{
+		return INT64_MIN;
+	}
+
+	return (int64_t) volume;
+}
+
+/******************************************************************************
+ *
+ * \par Function Name:
+ *      convert_evc_to_mtv
+ *
+ * \brief  Convert the EVC of a bundle to the MTV representation
+ *
+ *
+ * \par Date Written:
+ *      18/10/26
+ *
+ * \return int64_t
+ *
+ * \retval ">= 0"  The EVC saturated to INT64_MAX
+ *
+ * \param[in]	evc    The estimated volume consumption of the bundle
+ *
+ * \par Revision History:
+ *
+ *  DD/MM/YY |  AUTHOR         |   DESCRIPTION
+ *  -------- | --------------- | -----------------------------------------------
+ *  18/10/26 | agent           |  Initial Implementation and documentation.
+ *****************************************************************************/
+int64_t convert_evc_to_mtv(uint64_t evc)
+{
+	return (evc > (uint64_t) INT64_MAX) ? INT64_MAX : (int64_t) evc;
+}
+
+/******************************************************************************
+ *
+ * \par Function Name:
+ *      decrease_mtv
+ *
+ * \brief  Decrease the MTV of a contact for all the levels of priority
+ *         less than or equal to the priority passed as argument.
+ *
+ *
+ * \par Date Written:
+ *      18/10/26
+ *
+ * \return void
+ *
+ * \param[in]	*contact    The contact
+ * \param[in]	priority    The bundle's priority
+ * \param[in]	volume      The volume to subtract (>= 0)
+ *
+ * \par Notes:
+ *          1.  The MTV saturates to INT64_MIN instead of wrapping around.
+ *
+ * \par Revision History:
+ *
+ *  DD/MM/YY |  AUTHOR         |   DESCRIPTION
+ *  -------- | --------------- | -----------------------------------------------
+ *  18/10/26 | agent           |  Initial Implementation and documentation.
+ *****************************************************************************/
+void decrease_mtv(Contact *contact, int priority, int64_t volume)
+{
+	int i;
+
+	for (i = 0; i <= priority; i++)
+	{
+		if (contact->mtv[i] < INT64_MIN + volume)
+		{
+			contact->mtv[i] = INT64_MIN;
+		}
+		else
+		{
+			contact->mtv[i] -= volume;
+		}
+	}
+}
+
+/******************************************************************************
+ *
+ * \par Function Name:
+ *      increase_mtv
+ *
+ * \brief  Increase the MTV of a contact for all the levels of priority
+ *         less than or equal to the priority passed as argument.
+ *
+ *
+ * \par Date Written:
+ *      18/10/26
+ *
+ * \return void
+ *
+ * \param[in]	*contact    The contact
+ * \param[in]	priority    The bundle's priority
+ * \param[in]	volume      The volume to add (>= 0)
+ *
+ * \par Notes:
+ *          1.  The MTV saturates to INT64_MAX instead of wrapping around.
+ *
+ * \par Revision History:
+ *
+ *  DD/MM/YY |  AUTHOR         |   DESCRIPTION
+ *  -------- | --------------- | -----------------------------------------------
+ *  18/10/26 | agent           |  Initial Implementation and documentation.
+ *****************************************************************************/
+void increase_mtv(Contact *contact, int priority, int64_t volume)
+{
+	int i;
+
+	for (i = 0; i <= priority; i++)
+	{
+		if (contact->mtv[i] > INT64_MAX - volume)
+		{
+			contact->mtv[i] = INT64_MAX;
+		}
+		else
+		{
+			contact->mtv[i] += volume;
+		}
+	}
+}
+
+/******************************************************************************
+ *
+ * \par Function Name:
+ *      decrease_hops_mtv
+ *
+ * \brief  Decrease the MTV of all the contacts of a route's hops list.
+ *
+ *
+ * \par Date Written:
+ *      18/10/26
+ *
+ * \return void
+ *
+ * \param[in]	hops        The hops list (list of Contact*)
+ * \param[in]	priority    The bundle's priority
+ * \param[in]	volume      The volume to subtract (>= 0)
+ *
+ * \par Revision History:
+ *
+ *  DD/MM/YY |  AUTHOR         |   DESCRIPTION
+ *  -------- | --------------- | -----------------------------------------------
+ *  18/10/26 | agent           |  Initial Implementation and documentation.
+ *****************************************************************************/
+void decrease_hops_mtv(List hops, int priority, int64_t volume)
+{
+	ListElt *elt;
+
+	for (elt = hops->first; elt != NULL; elt = elt->next)
+	{
+		decrease_mtv((Contact*) elt->data, priority, volume);
+	}
+}
+
+/******************************************************************************
+ *
+ * \par Function Name:
+ *      create_contact
+ *
+ * \brief  Allocate memory for a new contact
+ *
+ *
+ * \par Date Written:
+ *      13/01/20
+ *
+ * \return Contact*
+ *
+ * \retval Contact*  The pointer to the allocated contact 
+ * \retval NULL      MWITHDRAW error
+ *
+ * \param[in]	*uniboCgrSap  The UniboCGRSAP (owner of the contact pool)
+ * \param[in]	fromNode      The contact's sender node
+ * \param[in]	toNode        The contact's receiver node
+ * \param[in]	fromTime      The contact's start time
+ * \param[in]	toTime        The contact's end time
+ * \param[in]	xmitRate      In bytes per second
+ * \param[in]	confidence    The confidence that the contact will effectively materialize
+ * \param[in]	type          The type of the contact (Registration or Scheduled)
+ *
+ * \par Notes:
+ *             1. You must check that the return value of this function is not NULL.
+ *             2. The citations list is allocated by the first citation (see insert_contact_citation()).
+ *             3. The contact and its ContactNote are allocated together (see ContactBlock),
+ *                taken from the contact pool of the instance if any.
+ *
+ * \par Revision History:
+ *
+ *  DD/MM/YY |  AUTHOR         |   DESCRIPTION
+ *  -------- | --------------- | -----------------------------------------------
+ *  13/01/20 | L. Persampieri  |  Initial Implementation and documentation.
+ *  18/10/26 | agent           |  Integer MTV.
+ *  18/10/26 | agent           |  Lazily allocated citations list.
+ *  18/10/26 | agent           |  ContactNote allocated with the contact.
+ *  18/10/26 | agent           |  Contact pool.
+ *****************************************************************************/
+Contact* create_contact(UniboCGRSAP* uniboCgrSap, uint64_t fromNode, uint64_t toNode, time_t fromTime,
+		time_t toTime, uint64_t xmitRate, float confidence, CtType type)
+{
+	Contact *contact = NULL;
+	ContactBlock *block;
+	Pool *pool = UniboCGRSAP_get_contact_pool(uniboCgrSap);
+	int64_t volume;
+
+	if (pool != NULL)
+	{
+		block = (ContactBlock*) pool_take(pool);
+	}
+	else
+	{
+		block = (ContactBlock*) MWITHDRAW(sizeof(ContactBlock));
+	}
+
+	if (block != NULL)
+	{
+		block->pool = pool;
+		contact = &(block->contact);
+		contact->fromNode = fromNode;
+		contact->toNode = toNode;
+		contact->fromTime = fromTime;
+		contact->toTime = toTime;
+		contact->xmitRate = xmitRate;
+		contact->confidence = confidence;
+		contact->type = type;
+		/* NOTE: We assume that toTime - fromTime is greater or equal to 0 */
+		volume = compute_contact_volume(toTime - fromTime, xmitRate);
+		contact->mtv[0] = volume;
+		contact->mtv[1] = volume;
+		contact->mtv[2] = volume;
+
+		contact->citations = NULL; // allocated by the first citation
+		erase_contact_note(&(block->note));
+		contact->routingObject = &(block->note);
+	}
+
+	return contact;
+}
+
+/******************************************************************************
+ *
+ * \par Function Name:
+ *      compact_contact
+ *
+ * \brief  Get the CompactContact of a contact
+ *
+ *
+ * \par Date Written:
+ *      18/10/26
+ *
+ * \return int
+ *
+ * \retval   0   Success case: the record holds the contact
+ * \retval  -1   The contact doesn't fit a CompactContact (record untouched)
+ *
+ * \param[in]	*contact   The contact, already in the contacts graph (node indexes set)
+ * \param[out]	*record    The compact contact
+ *
+ * \par Notes:
+ *             1. A contact fits if it is scheduled, its times and its xmit rate fit 32 bits
+ *                and its MTVs are the same for each priority.
+ *             2. The routes that cite the contact are not kept.
+ *
+ * \par Revision History:
+ *
+ *  DD/MM/YY |  AUTHOR         |   DESCRIPTION
+ *  -------- | --------------- | -----------------------------------------------
+ *  18/10/26 | agent           |  Initial Implementation and documentation.
+ *****************************************************************************/
+int compact_contact(const Contact *contact, CompactContact *record)
+{
+	if (contact->type != TypeScheduled
+			|| contact->fromNodeIndex == NO_NODE_INDEX || contact->toNodeIndex == NO_NODE_INDEX
+			|| contact->fromTime < INT32_MIN || contact->fromTime > INT32_MAX
+			|| contact->toTime < contact->fromTime || contact->toTime - contact->fromTime > (time_t) UINT32_MAX
+			|| contact->xmitRate > UINT32_MAX
+			|| contact->mtv[0] != contact->mtv[1] || contact->mtv[1] != contact->mtv[2])
+	{
+		return -1;
+	}
+
+	record->fromNodeIndex = contact->fromNodeIndex;
+	record->toNodeIndex = contact->toNodeIndex;
+	record->fromTime = (int32_t) contact->fromTime;
+	record->duration = (uint32_t) (contact->toTime - contact->fromTime);
+	record->xmitRate = (uint32_t) contact->xmitRate;
+	record->confidence = contact->confidence;
+	record->mtv = contact->mtv[0];
+
+	return 0;
+}
+
+/******************************************************************************
+ *
+ * \par Function Name:
+ *      expand_contact
+ *
+ * \brief  Allocate the contact held by a CompactContact
+ *
+ *
+ * \par Date Written:
+ *      18/10/26
+ *
+ * \return Contact*
+ *
+ * \retval  Contact*  The new contact (not in the contacts graph)
+ * \retval  NULL      MWITHDRAW error
+ *
+ * \param[in]	*record    The compact contact
+ *
+ * \par Revision History:
+ *
+ *  DD/MM/YY |  AUTHOR         |   DESCRIPTION
+ *  -------- | --------------- | -----------------------------------------------
+ *  18/10/26 | agent           |  Initial Implementation and documentation.
+ *****************************************************************************/
+Contact* expand_contact(UniboCGRSAP* uniboCgrSap, const CompactContact *record)
+{
+	Contact *contact;
+
+	contact = create_contact(uniboCgrSap, get_node_number(uniboCgrSap, record->fromNodeIndex),
+			get_node_number(uniboCgrSap, record->toNodeIndex),
+			(time_t) record->fromTime, (time_t) record->fromTime + (time_t) record->duration,
+			(uint64_t) record->xmitRate, record->confidence, TypeScheduled);
+
+	if (contact != NULL)
+	{
+		contact->fromNodeIndex = record->fromNodeIndex;
+		contact->toNodeIndex = record->toNodeIndex;
+		contact->mtv[0] = record->mtv;
+		contact->mtv[1] = record->mtv;
+		contact->mtv[2] = record->mtv;
+	}
+
+	return contact;
+}
+
+/******************************************************************************
+ *
+ * \par Function Name:
+ *      intern_contact_nodes
+ *
+ * \brief  Set the node indexes of the contact's sender and receiver
+ *
+ *
+ * \par Date Written:
+ *      18/10/26
+ *
+ * \return int
+ *
+ * \retval   0   Success case
+ * \retval  -2   MWITHDRAW error
+ *
+ * \param[in]	*contact   The contact that is going to enter the contacts graph
+ *
+ * \par Revision History:
+ *
+ *  DD/MM/YY |  AUTHOR         |   DESCRIPTION
+ *  -------- | --------------- | -----------------------------------------------
+ *  18/10/26 | agent           |  Initial Implementation and documentation.
+ *****************************************************************************/
+static int intern_contact_nodes(UniboCGRSAP* uniboCgrSap, Contact *contact)
+{
+	contact->fromNodeIndex = intern_node(uniboCgrSap, contact->fromNode);
+	contact->toNodeIndex = intern_node(uniboCgrSap, contact->toNode);
+
+	if (contact->fromNodeIndex == NO_NODE_INDEX || contact->toNodeIndex == NO_NODE_INDEX)
+	{
+		return -2;
+	}
+
+	return 0;
+}
+
+/******************************************************************************
+ *
+ * \par Function Name:
+ *      add_contact_to_graph
+ *
+ * \brief  Allocate memory for a contact, set the fields of the contacts to the
+ *         passed arguments and add the contact to the contacts graph
+ *
+ *
+ * \par Date Written:
+ *      13/01/20
+ *
+ * \return int
+ *
+ * \retval   1   Success case: contact added to the contacts graph
+ * \retval   0   Arguments error case
+ * \retval  -1   Overlapped contact (don't change it)
+ * \retval  -2   MWITHDRAW error
+ *
+ * \param[in]	fromNode           The contact's sender node
+ * \param[in]	toNode             The contact's receiver node
+ * \param[in]	fromTime           The contact's start time
+ * \param[in]	toTime             The contact's end time
+ * \param[in]	xmitRate           In bytes per second
+ * \param[in]	confidence         The confidence that the contact will effectively materialize
+ * \param[in]   copyMTV            Set to 1 if you want to copy the MTV from mtv input parameter.
+ *                                 Set to 0 otherwise
+ * \param[in]   mtv                The contact's MTV: this must be an array of 3 elements.
+ *
+ * \par Notes:
+ *             1. The contact->toTime of the new contact is inserted in the expiration heap.
+ *             2. Set copyMTV to 1 if you want to be compatible with the data gets
+ *                for example from an interface.
+ *
+ * \par Revision History:
+ *
+ *  DD/MM/YY |  AUTHOR         |   DESCRIPTION
+ *  -------- | --------------- | -----------------------------------------------
+ *  13/01/20 | L. Persampieri  |  Initial Implementation and documentation.
+ *  18/10/26 | agent           |  MTVs as int64_t.
+ *  18/10/26 | agent           |  Insert the contact in the expiration heap.
+ *****************************************************************************/
+int add_contact_to_graph(UniboCGRSAP* uniboCgrSap, uint64_t fromNode, uint64_t toNode, time_t fromTime,
+                         time_t toTime, uint64_t xmitRate, float confidence, int copyMTV, const int64_t mtv[])
+{
+	int result;
+	int overlapped;
+	Contact *contact, *temp;
+	RbtNode *elt = NULL;
+	CtType contactType;
+	ContactSAP *sap;
+
+	if (fromNode == 0 || toNode == 0 || toTime < 0 || (fromTime > toTime) || confidence < 0.0
+			|| confidence > 1.0)
+	{
+		result = 0;
+	}
+	else
+	{
+		sap = UniboCGRSAP_get_ContactSAP(uniboCgrSap);
+
+		result = -1;
+			if (fromTime >= 0) /*Type: Scheduled	*/
+			{
+				temp = get_first_contact_from_node_to_node(uniboCgrSap, fromNode, toNode, &elt);
 				overlapped = 0;
 				while (temp != NULL)
 				{
@@ -998,35 +1856,667 @@ int add_contact_to_graph(UniboCGRSAP* uniboCgrSap, uint64_t fromNode, uint64_t t
 					}
 				}
 
-				if (overlapped == 0)
-				{
-					contactType = TypeScheduled;
-					contact = create_contact(fromNode, toNode, fromTime, toTime, xmitRate, confidence,
-							contactType);
-                    if (!contact) {
-                        return -2;
-                    }
+				if (overlapped == 0)
+				{
+					contactType = TypeScheduled;
+					contact = create_contact(uniboCgrSap, fromNode, toNode, fromTime, toTime, xmitRate, confidence,
+							contactType);
+                    if (!contact) {
+                        return -2;
+                    }
+
+					if(copyMTV != 0)
+					{
+						contact->mtv[0] = mtv[0];
+						contact->mtv[1] = mtv[1];
+						contact->mtv[2] = mtv[2];
+					}
+					if (intern_contact_nodes(uniboCgrSap, contact) < 0)
+					{
+						free_contact(contact);
+						return -2;
+					}
+					elt = rbt_insert(sap->contacts, contact);
+
+					result = ((elt != NULL) ? 1 : -2);
+
+					if (result == -2)
+					{
+						free_contact(contact);
+					}
+					else
+					{
+						add_contact_to_heaps(sap, contact);
+					}
+				}
+			}
+	}
+
+	return result;
+}
+
+static int compare_contact_pointers(const void *first, const void *second)
+{
+	return compare_contacts(*((Contact**) first), *((Contact**) second));
+}
+
+/******************************************************************************
+ *
+ * \par Function Name:
+ *      contact_overlaps_graph
+ *
+ * \brief  Check if a contact overlaps the contacts of the graph
+ *         between the same sender and receiver
+ *
+ *
+ * \par Date Written:
+ *      18/10/26
+ *
+ * \return int
+ *
+ * \retval   1   The contact overlaps (or is equal to) a contact of the graph
+ * \retval   0   The contact doesn't overlap
+ *
+ * \param[in]	*sap       The ContactSAP
+ * \param[in]	*contact   The contact (not in the graph)
+ *
+ * \par Notes:
+ *             1. Only the previous and the next contact (in the graph order) are checked:
+ *                the contacts between the same nodes don't overlap each other.
+ *
+ * \par Revision History:
+ *
+ *  DD/MM/YY |  AUTHOR         |   DESCRIPTION
+ *  -------- | --------------- | -----------------------------------------------
+ *  18/10/26 | agent           |  Initial Implementation and documentation.
+ *****************************************************************************/
+static int contact_overlaps_graph(ContactSAP *sap, Contact *contact)
+{
+	RbtNode *successor = NULL, *predecessor;
+	Contact *other;
+
+	if (rbt_search(sap->contacts, contact, &successor) != NULL)
+	{
+		return 1;
+	}
+
+	predecessor = (successor != NULL) ? rbt_prev(successor) : rbt_last(sap->contacts);
+
+	if (successor != NULL && (other = (Contact*) successor->data) != NULL
+			&& other->fromNode == contact->fromNode && other->toNode == contact->toNode
+			&& other->fromTime < contact->toTime)
+	{
+		return 1;
+	}
+	if (predecessor != NULL && (other = (Contact*) predecessor->data) != NULL
+			&& other->fromNode == contact->fromNode && other->toNode == contact->toNode
+			&& other->toTime > contact->fromTime)
+	{
+		return 1;
+	}
+
+	return 0;
+}
+
+/******************************************************************************
+ *
+ * \par Function Name:
+ *      add_contacts_to_graph_bulk
+ *
+ * \brief  Add many contacts to the contacts graph at once
+ *
+ *
+ * \par Date Written:
+ *      18/10/26
+ *
+ * \return int
+ *
+ * \retval  ">= 0"   Success case: number of contacts added to the contacts graph
+ * \retval     -1    Overlapped contacts (nothing added)
+ * \retval     -2    MWITHDRAW error (nothing added)
+ *
+ * \param[in]	**contacts   The contacts, allocated by create_contact(). The array will be sorted.
+ * \param[in]	count        The number of contacts
+ *
+ * \par Notes:
+ *             1. The contacts are always consumed: in case of error they are released.
+ *             2. The contacts are sorted once, the overlaps among them are checked
+ *                in one linear pass and the overlaps with the graph in O(log n) each.
+ *             3. If the graph is empty, or if the new contacts are not much fewer than
+ *                the contacts already in the graph, the whole graph is rebuilt bottom-up
+ *                in O(n), otherwise each contact is inserted in the graph.
+ *             4. The sort is skipped if the contacts are already sorted.
+ *
+ * \par Revision History:
+ *
+ *  DD/MM/YY |  AUTHOR         |   DESCRIPTION
+ *  -------- | --------------- | -----------------------------------------------
+ *  18/10/26 | agent           |  Initial Implementation and documentation.
+ *  18/10/26 | agent           |  Skip the sort for presorted contacts (binary contact plan).
+ *****************************************************************************/
+int add_contacts_to_graph_bulk(UniboCGRSAP* uniboCgrSap, Contact **contacts, uint32_t count)
+{
+	ContactSAP *sap = UniboCGRSAP_get_ContactSAP(uniboCgrSap);
+	unsigned long graphLength = (sap->contacts->root != NULL) ? sap->contacts->length : 0;
+	unsigned long total, i, j, k;
+	void **merged;
+	RbtNode *node;
+	Contact *prev, *current;
+	int result = 0;
+
+	// already sorted when they come from a binary contact plan
+	for (i = 1; i < count && compare_contacts(contacts[i - 1], contacts[i]) < 0; i++);
+	if (i < count)
+	{
+		qsort(contacts, count, sizeof(Contact*), compare_contact_pointers);
+	}
+
+	for (i = 0; i < count && result == 0; i++)
+	{
+		current = contacts[i];
+		if (i > 0)
+		{
+			prev = contacts[i - 1];
+			if (prev->fromNode == current->fromNode && prev->toNode == current->toNode
+					&& (prev->fromTime == current->fromTime || prev->toTime > current->fromTime))
+			{
+				result = -1;
+			}
+		}
+		if (result == 0 && graphLength > 0 && contact_overlaps_graph(sap, current))
+		{
+			result = -1;
+		}
+		if (result == 0 && intern_contact_nodes(uniboCgrSap, current) < 0)
+		{
+			result = -2;
+		}
+	}
+
+	if (result == 0 && (graphLength == 0 || count >= graphLength / 8))
+	{
+		// bottom-up rebuild: merge the contacts graph with the new (sorted) contacts
+		total = graphLength + count;
+		merged = (void**) MWITHDRAW(sizeof(void*) * (total > 0 ? total : 1));
+		if (merged == NULL)
+		{
+			result = -2;
+		}
+		else
+		{
+			node = rbt_first(sap->contacts);
+			j = 0;
+			for (k = 0; k < total; k++)
+			{
+				if (node != NULL && (j >= count || compare_contacts(node->data, contacts[j]) < 0))
+				{
+					merged[k] = node->data;
+					node = rbt_next(node);
+				}
+				else
+				{
+					merged[k] = contacts[j++];
+				}
+			}
+
+			result = rbt_rebuild_from_sorted(sap->contacts, merged, total);
+			MDEPOSIT(merged);
+
+			if (result == 0)
+			{
+				rebuild_contact_heaps(sap);
+			}
+		}
+	}
+	else if (result == 0)
+	{
+		for (i = 0; i < count && result == 0; i++)
+		{
+			if (rbt_insert(sap->contacts, contacts[i]) == NULL)
+			{
+				// roll back (rbt_delete releases the contact)
+				for (j = 0; j < i; j++)
+				{
+					rbt_delete(sap->contacts, contacts[j]);
+					contacts[j] = NULL;
+				}
+				result = -2;
+			}
+			else
+			{
+				add_contact_to_heaps(sap, contacts[i]);
+			}
+		}
+	}
+
+	if (result < 0)
+	{
+		for (i = 0; i < count; i++)
+		{
+			if (contacts[i] != NULL)
+			{
+				free_contact(contacts[i]);
+			}
+		}
+		return result;
+	}
 
-					if(copyMTV != 0)
-					{
-						contact->mtv[0] = mtv[0];
-						contact->mtv[1] = mtv[1];
-						contact->mtv[2] = mtv[2];
-					}
-					elt = rbt_insert(sap->contacts, contact);
+	return (int) count;
+}
 
-					result = ((elt != NULL) ? 1 : -2);
+/******************************************************************************
+ *
+ * \par Function Name:
+ *      compare_staged_contacts
+ *
+ * \brief  qsort() comparator for the staged contacts: by fromTime, then by sender and receiver
+ *
+ *
+ * \par Date Written:
+ *      18/10/26
+ *
+ * \return int
+ *
+ * \retval  <0  first starts before second
+ * \retval   0  same contact
+ * \retval  >0  first starts after second
+ *
+ * \par Revision History:
+ *
+ *  DD/MM/YY |  AUTHOR         |   DESCRIPTION
+ *  -------- | --------------- | -----------------------------------------------
+ *  18/10/26 | agent           |  Initial Implementation and documentation.
+ *  18/10/26 | agent           |  Compact staged contacts.
+ *****************************************************************************/
+static int compare_staged_contacts(const void *first, const void *second)
+{
+	const CompactContact *a = (const CompactContact*) first;
+	const CompactContact *b = (const CompactContact*) second;
 
-					if (result == -2)
-					{
-						free_contact(contact);
-					}
-					else if (sap->timeContactToRemove > toTime)
-					{
-						sap->timeContactToRemove = toTime;
-					}
+	if (a->fromTime != b->fromTime)
+	{
+		return (a->fromTime < b->fromTime) ? -1 : 1;
+	}
+	if (a->fromNodeIndex != b->fromNodeIndex)
+	{
+		return (a->fromNodeIndex < b->fromNodeIndex) ? -1 : 1;
+	}
+	if (a->toNodeIndex != b->toNodeIndex)
+	{
+		return (a->toNodeIndex < b->toNodeIndex) ? -1 : 1;
+	}
+
+	return 0;
+}
+
+/******************************************************************************
+ *
+ * \par Function Name:
+ *      stage_contacts
+ *
+ * \brief  Move from the contacts graph to the staging array every contact
+ *         with fromTime >= limit
+ *
+ *
+ * \par Date Written:
+ *      18/10/26
+ *
+ * \return int
+ *
+ * \retval   0   Success case
+ * \retval  -2   MWITHDRAW error (nothing moved)
+ *
+ * \param[in]	*sap    The ContactSAP
+ * \param[in]	limit   The new horizon limit, lower than the current one
+ *
+ * \par Notes:
+ *             1. The routes that cite a staged contact are deleted.
+ *             2. The graph is rebuilt bottom-up from the contacts kept, in O(n).
+ *             3. The staged contacts are kept as CompactContact and released from the graph;
+ *                the contacts that don't fit a CompactContact stay in the graph.
+ *
+ * \par Revision History:
+ *
+ *  DD/MM/YY |  AUTHOR         |   DESCRIPTION
+ *  -------- | --------------- | -----------------------------------------------
+ *  18/10/26 | agent           |  Initial Implementation and documentation.
+ *  18/10/26 | agent           |  Compact staged contacts.
+ *****************************************************************************/
+static int stage_contacts(ContactSAP *sap, time_t limit)
+{
+	unsigned long graphLength = (sap->contacts->root != NULL) ? sap->contacts->length : 0;
+	unsigned long kept = 0, moved = 0, i;
+	uint32_t pending = sap->stagedCount - sap->stagedFirst;
+	uint32_t capacity;
+	void **contacts;
+	CompactContact *staged, record;
+	RbtNode *node;
+	Contact *contact;
+
+	for (node = rbt_first(sap->contacts); node != NULL; node = rbt_next(node))
+	{
+		contact = (Contact*) node->data;
+		if (contact->fromTime >= limit && compact_contact(contact, &record) == 0)
+		{
+			moved++;
+		}
+	}
+	if (moved == 0)
+	{
+		sap->horizonLimit = limit;
+		return 0;
+	}
+
+	// the contacts kept from the start, the contacts to stage from the end
+	contacts = (void**) MWITHDRAW(sizeof(void*) * graphLength);
+	if (contacts == NULL)
+	{
+		return -2;
+	}
+	staged = sap->staged;
+	capacity = sap->stagedCapacity;
+	if (pending + moved > capacity)
+	{
+		capacity = (uint32_t) (pending + moved);
+		staged = (CompactContact*) MWITHDRAW(sizeof(CompactContact) * capacity);
+		if (staged == NULL)
+		{
+			MDEPOSIT(contacts);
+			return -2;
+		}
+	}
+
+	i = graphLength;
+	for (node = rbt_first(sap->contacts); node != NULL; node = rbt_next(node))
+	{
+		contact = (Contact*) node->data;
+		if (contact->fromTime >= limit && compact_contact(contact, &record) == 0)
+		{
+			contacts[--i] = contact;
+		}
+		else
+		{
+			contacts[kept++] = contact;
+		}
+	}
+
+	if (rbt_rebuild_from_sorted(sap->contacts, contacts, kept) < 0)
+	{
+		if (staged != sap->staged)
+		{
+			MDEPOSIT(staged);
+		}
+		MDEPOSIT(contacts);
+		return -2;
+	}
+
+	// the contacts still staged start after the old limit: they go after the moved ones
+	if (pending > 0)
+	{
+		memmove(staged + moved, sap->staged + sap->stagedFirst, sizeof(CompactContact) * pending);
+	}
+	for (i = 0; i < moved; i++)
+	{
+		contact = (Contact*) contacts[kept + i];
+		compact_contact(contact, staged + i);
+		free_contact(contact); // and the routes that cite it
+	}
+	MDEPOSIT(contacts);
+	qsort(staged, moved, sizeof(CompactContact), compare_staged_contacts);
+
+	if (staged != sap->staged)
+	{
+		if (sap->staged != NULL)
+		{
+			MDEPOSIT(sap->staged);
+		}
+		sap->staged = staged;
+		sap->stagedCapacity = capacity;
+	}
+	sap->stagedFirst = 0;
+	sap->stagedCount = (uint32_t) (pending + moved);
+	sap->horizonLimit = limit;
+
+	rebuild_contact_heaps(sap);
+
+	return 0;
+}
+
+/******************************************************************************
+ *
+ * \par Function Name:
+ *      set_contacts_horizon
+ *
+ * \brief  Keep in the contacts graph only the contacts that start before limit,
+ *         the later ones are staged
+ *
+ *
+ * \par Date Written:
+ *      18/10/26
+ *
+ * \return int
+ *
+ * \retval  ">= 0"   Success case: number of staged contacts promoted to the graph
+ * \retval     -2    MWITHDRAW error
+ *
+ * \param[in]	limit   The new horizon limit (internal time), MAX_POSIX_TIME to keep every contact in the graph
+ *
+ * \par Notes:
+ *             1. Raising the limit promotes the staged contacts in one bulk insertion
+ *                (they are sorted by fromTime, so the promoted ones are a prefix).
+ *             2. Lowering the limit stages the graph contacts that start at or after it,
+ *                deleting the routes that cite them.
+ *             3. In case of MWITHDRAW error nothing changes: the contacts to promote stay staged.
+ *
+ * \par Revision History:
+ *
+ *  DD/MM/YY |  AUTHOR         |   DESCRIPTION
+ *  -------- | --------------- | -----------------------------------------------
+ *  18/10/26 | agent           |  Initial Implementation and documentation.
+ *  18/10/26 | agent           |  Expand the compact staged contacts.
+ *****************************************************************************/
+int set_contacts_horizon(UniboCGRSAP* uniboCgrSap, time_t limit)
+{
+	ContactSAP *sap = UniboCGRSAP_get_ContactSAP(uniboCgrSap);
+	uint32_t first, last, i;
+	Contact **contacts;
+	int result;
+
+	if (limit < sap->horizonLimit)
+	{
+		return stage_contacts(sap, limit);
+	}
+
+	first = sap->stagedFirst;
+	for (last = first; last < sap->stagedCount && sap->staged[last].fromTime < limit; last++);
+
+	if (last > first)
+	{
+		contacts = (Contact**) MWITHDRAW(sizeof(Contact*) * (last - first));
+		if (contacts == NULL)
+		{
+			return -2;
+		}
+		for (i = first; i < last; i++)
+		{
+			contacts[i - first] = expand_contact(uniboCgrSap, sap->staged + i);
+			if (contacts[i - first] == NULL)
+			{
+				while (i > first)
+				{
+					i--;
+					free_contact(contacts[i - first]);
 				}
+				MDEPOSIT(contacts);
+				return -2;
+			}
+		}
+
+		// staged contacts never overlap the graph ones
+		result = add_contacts_to_graph_bulk(uniboCgrSap, contacts, last - first);
+		MDEPOSIT(contacts);
+		if (result < 0)
+		{
+			return -2;
+		}
+	}
+
+	sap->stagedFirst = last;
+	if (last == sap->stagedCount)
+	{
+		sap->stagedFirst = 0;
+		sap->stagedCount = 0;
+	}
+	sap->horizonLimit = limit;
+
+	return (int) (last - first);
+}
+
+/******************************************************************************
+ *
+ * \par Function Name:
+ *      get_contacts_horizon
+ *
+ * \brief  Get the horizon limit: the contacts that start at or after it are staged
+ *
+ *
+ * \par Date Written:
+ *      18/10/26
+ *
+ * \return time_t
+ *
+ * \retval  MAX_POSIX_TIME   Every contact is in the graph
+ * \retval  otherwise        The horizon limit (internal time)
+ *
+ * \par Revision History:
+ *
+ *  DD/MM/YY |  AUTHOR         |   DESCRIPTION
+ *  -------- | --------------- | -----------------------------------------------
+ *  18/10/26 | agent           |  Initial Implementation and documentation.
+ *****************************************************************************/
+time_t get_contacts_horizon(UniboCGRSAP* uniboCgrSap)
+{
+	return UniboCGRSAP_get_ContactSAP(uniboCgrSap)->horizonLimit;
+}
+
+/******************************************************************************
+ *
+ * \par Function Name:
+ *      staged_contact_reaches_node
+ *
+ * \brief  Check if a staged contact to a node starts before a time
+ *
+ *
+ * \par Date Written:
+ *      18/10/26
+ *
+ * \return int
+ *
+ * \retval   1   A staged contact to toNode starts before the time
+ * \retval   0   Otherwise
+ *
+ * \param[in]	toNode   The receiver node
+ * \param[in]	before   The time (internal)
+ *
+ * \par Notes:
+ *             1. Used to grow the horizon only when it can help a search that found no route.
+ *
+ * \par Revision History:
+ *
+ *  DD/MM/YY |  AUTHOR         |   DESCRIPTION
+ *  -------- | --------------- | -----------------------------------------------
+ *  18/10/26 | agent           |  Initial Implementation and documentation.
+ *****************************************************************************/
+int staged_contact_reaches_node(UniboCGRSAP* uniboCgrSap, uint64_t toNode, time_t before)
+{
+	ContactSAP *sap = UniboCGRSAP_get_ContactSAP(uniboCgrSap);
+	uint32_t toNodeIndex = get_node_index(uniboCgrSap, toNode);
+	uint32_t i;
+
+	if (toNodeIndex == NO_NODE_INDEX)
+	{
+		return 0;
+	}
+
+	for (i = sap->stagedFirst; i < sap->stagedCount && sap->staged[i].fromTime < before; i++)
+	{
+		if (sap->staged[i].toNodeIndex == toNodeIndex)
+		{
+			return 1;
+		}
+	}
+
+	return 0;
+}
+
+/******************************************************************************
+ *
+ * \par Function Name:
+ *      get_next_contact_start
+ *
+ * \brief  Get the first start time of a contact not yet started
+ *
+ *
+ * \par Date Written:
+ *      18/10/26
+ *
+ * \return time_t
+ *
+ * \retval time_t  The lowest fromTime greater than the current time (internal time),
+ *                 among the contacts in the graph and the staged ones;
+ *                 MAX_POSIX_TIME if all the contacts are already started
+ *
+ * \par Notes:
+ *             1. The entries of the start heap of the contacts already started, deleted
+ *                or revised are popped: O(log(contacts)) amortized instead of a scan
+ *                of the contacts graph.
+ *             2. The staged contacts are sorted by fromTime: only the first one is checked.
+ *
+ * \par Revision History:
+ *
+ *  DD/MM/YY |  AUTHOR         |   DESCRIPTION
+ *  -------- | --------------- | -----------------------------------------------
+ *  18/10/26 | agent           |  Initial Implementation and documentation.
+ *****************************************************************************/
+time_t get_next_contact_start(UniboCGRSAP* uniboCgrSap)
+{
+	ContactSAP *sap = UniboCGRSAP_get_ContactSAP(uniboCgrSap);
+	const time_t currentTime = UniboCGRSAP_get_current_time(uniboCgrSap);
+	time_t result = MAX_POSIX_TIME;
+	HeapEntry *entry;
+	Contact *contact;
+	RbtNode *node;
+
+	if (sap->rebuildHeaps && rebuild_contact_heaps(sap) < 0)
+	{
+		// fallback: scan all the contacts graph
+		for (contact = get_first_contact(uniboCgrSap, &node); contact != NULL; contact = get_next_contact(&node))
+		{
+			if (contact->fromTime > currentTime && contact->fromTime < result)
+			{
+				result = contact->fromTime;
+			}
+		}
+	}
+	else
+	{
+		for (entry = heap_top(&sap->starts); entry != NULL; entry = heap_top(&sap->starts))
+		{
+			contact = get_contact(uniboCgrSap, entry->fromNode, entry->toNode, entry->fromTime, NULL);
+			if (entry->expirationTime > currentTime && contact != NULL)
+			{
+				result = entry->expirationTime;
+				break;
 			}
+			// already started, or stale entry: contact deleted or revised
+			heap_pop(&sap->starts);
+		}
+	}
+
+	if (sap->stagedFirst < sap->stagedCount && sap->staged[sap->stagedFirst].fromTime > currentTime
+			&& sap->staged[sap->stagedFirst].fromTime < result)
+	{
+		result = sap->staged[sap->stagedFirst].fromTime;
 	}
 
 	return result;
@@ -1089,6 +2579,8 @@ void remove_contact_elt_from_graph(UniboCGRSAP* uniboCgrSap, Contact *elt)
  *
  * \par Notes:
  *             1. The free_contact will be called for the contact(s) removed.
+ *             2. The routes of the destinations reached through the contact
+ *                are discarded (see discard_routes_citing_contact).
  *
  *
  * \par Revision History:
@@ -1096,12 +2588,15 @@ void remove_contact_elt_from_graph(UniboCGRSAP* uniboCgrSap, Contact *elt)
  *  DD/MM/YY |  AUTHOR         |   DESCRIPTION
  *  -------- | --------------- | -----------------------------------------------
  *  13/01/20 | L. Persampieri  |  Initial Implementation and documentation.
+ *  18/10/26 | agent           |  Discard the routes of the destinations reached through the contact.
  *****************************************************************************/
 void remove_contact_from_graph(UniboCGRSAP* uniboCgrSap, time_t fromTime, uint64_t fromNode, uint64_t toNode)
 {
 	Contact arg;
 	ContactSAP *sap = UniboCGRSAP_get_ContactSAP(uniboCgrSap);
 
+    discard_routes_citing_contact(get_contact(uniboCgrSap, fromNode, toNode, fromTime, NULL));
+
     erase_contact(&arg);
     arg.fromNode = fromNode;
     arg.toNode = toNode;
@@ -1500,7 +2995,7 @@ static int printContact(FILE *file, void *data)
 		}
 		else
 		{
-			fprintf(file, "NULL\n");
+			fprintf(file, "0\n"); // never cited
 		}
 	}
 	else
@@ -57,16 +57,25 @@ typedef enum
     //TypeDiscovered
 } CtType;
 
+/**
+ * \brief A contact of the contacts graph.
+ *
+ * \details The fields read by each relaxation of the Dijkstra's search come first
+ *          (node indexes, times, confidence and the ContactNote pointer), so that
+ *          they share one cache line; the ipn node numbers, the volume and the
+ *          citations follow. The ContactNote of a contact created by create_contact()
+ *          is allocated in the same memory area, right before the contact.
+ */
 typedef struct
 {
 	/**
-	 * \brief Sender node (ipn node number)
+	 * \brief Sender node index (see node_index.h), set when the contact enters the graph
 	 */
-	uint64_t fromNode;
+	uint32_t fromNodeIndex;
 	/**
-	 * \brief Receiver node (ipn node number)
+	 * \brief Receiver node index (see node_index.h), set when the contact enters the graph
 	 */
-	uint64_t toNode;
+	uint32_t toNodeIndex;
 	/**
 	 * \brief Start transit time
 	 */
@@ -76,9 +85,9 @@ typedef struct
 	 */
 	time_t toTime;
 	/**
-	 * \brief In bytes per second
+	 * \brief Used by Dijkstra's search
 	 */
-	uint64_t xmitRate;
+	ContactNote *routingObject;
 	/**
 	 * \brief Confidence that the contact will materialize
 	 */
@@ -88,30 +97,82 @@ typedef struct
 	 */
 	CtType type;
 	/**
-	 * \brief Remaining volume (for each level of priority)
+	 * \brief Sender node (ipn node number)
 	 */
-	double mtv[3];
+	uint64_t fromNode;
 	/**
-	 * \brief Used by Dijkstra's search
+	 * \brief Receiver node (ipn node number)
 	 */
-	ContactNote *routingObject;
+	uint64_t toNode;
+	/**
+	 * \brief In bytes per second
+	 */
+	uint64_t xmitRate;
+	/**
+	 * \brief Remaining volume in bytes (for each level of priority)
+	 *
+	 * \details Signed: the bookings can exceed the volume of the contact.
+	 *          Always updated with saturating arithmetic, see decrease_mtv() and increase_mtv().
+	 */
+	int64_t mtv[3];
 	/**
 	 * \brief List of ListElt data.
 	 *
 	 * \details Each citation is a pointer to the element
 	 * of the hops list of the Route where the contact appears,
 	 * and this element of the hops list points to this contact.
+	 * NULL until the contact is cited the first time.
 	 */
 	List citations;
 } Contact;
 
-struct cgrContactNote
+/**
+ * \brief Compact (32 bytes) representation of a scheduled Contact with no routes,
+ *        used for the contacts staged out of the graph (horizon mode).
+ *
+ * \details The nodes are node indexes (see node_index.h), the times are internal times
+ *          (relative to the instance time base) and the same MTV holds for each priority.
+ *          compact_contact() tells which contacts fit.
+ */
+typedef struct
 {
 	/**
-	 * \brief Previous contact in the route, used to reconstruct the route at the end of
-	 * the Dijkstra's search
+	 * \brief Sender node index
 	 */
-	Contact *predecessor;
+	uint32_t fromNodeIndex;
+	/**
+	 * \brief Receiver node index
+	 */
+	uint32_t toNodeIndex;
+	/**
+	 * \brief Start transmit time (internal time)
+	 */
+	int32_t fromTime;
+	/**
+	 * \brief toTime - fromTime
+	 */
+	uint32_t duration;
+	/**
+	 * \brief In bytes per second
+	 */
+	uint32_t xmitRate;
+	/**
+	 * \brief Confidence that the contact will materialize
+	 */
+	float confidence;
+	/**
+	 * \brief Remaining volume in bytes, for each level of priority
+	 */
+	int64_t mtv;
+} CompactContact;
+
+/**
+ * \brief Dijkstra's search state of a contact.
+ *
+ * \details The fields updated by each relaxation come first.
+ */
+struct cgrContactNote
+{
 	/**
 	 * \brief Best case arrival time to the toNode of the contact
 	 */
@@ -128,19 +189,6 @@ struct cgrContactNote
 	 * \brief Flag used to identify each contact that belongs to the excluded set
 	 */
 	int suppressed;
-	/**
-	 * \brief Ranges sum to reach the toNode
-	 */
-	uint64_t owltSum;
-	/**
-	 * \brief Number of hops to reach this contact during Dijkstra's search.
-	 */
-	uint32_t hopCount;
-	/**
-	 * \brief Product of the confidence of each contacts in the path to
-	 * reach this contact and of the contact's confidence itself
-	 */
-	float arrivalConfidence;
 	/**
 	 * \brief Flag to known if we already get the range for this contact during the Dijkstra's search.
 	 *
@@ -157,16 +205,64 @@ struct cgrContactNote
 	 * \brief The owlt of the range found.
 	 */
 	uint32_t owlt;
+	/**
+	 * \brief Ranges sum to reach the toNode
+	 */
+	uint64_t owltSum;
+	/**
+	 * \brief Number of hops to reach this contact during Dijkstra's search.
+	 */
+	uint32_t hopCount;
+	/**
+	 * \brief Product of the confidence of each contacts in the path to
+	 * reach this contact and of the contact's confidence itself
+	 */
+	float arrivalConfidence;
+	/**
+	 * \brief Previous contact in the route, used to reconstruct the route at the end of
+	 * the Dijkstra's search
+	 */
+	Contact *predecessor;
 	/**
 	 * \brief
 	 */
 	Contact *nextContactInDijkstraQueue;
 };
 
+/**
+ * \brief The memory area of a contact created by create_contact().
+ *
+ * \details The ContactNote is placed right before the contact, so that a relaxation
+ *          of the Dijkstra's search reads the note and the first fields of the contact
+ *          from adjacent memory.
+ */
+typedef struct
+{
+	/**
+	 * \brief The pool from which the block has been taken, NULL if allocated with MWITHDRAW
+	 */
+	Pool *pool;
+	ContactNote note;
+	Contact contact;
+} ContactBlock;
+
 extern int compare_contacts(void *first, void *second);
-extern Contact* create_contact(uint64_t fromNode, uint64_t toNode,
+extern Contact* create_contact(UniboCGRSAP* uniboCgrSap, uint64_t fromNode, uint64_t toNode,
 		time_t fromTime, time_t toTime, uint64_t xmitRate, float confidence, CtType type);
 extern void free_contact(void*);
+extern int compact_contact(const Contact *contact, CompactContact *record);
+extern Contact* expand_contact(UniboCGRSAP* uniboCgrSap, const CompactContact *record);
+extern void discard_routes_citing_contact(Contact *contact);
+extern ListElt *insert_contact_citation(Contact *contact, ListElt *hop);
+extern void discard_routes_through_node_pair(UniboCGRSAP* uniboCgrSap, uint64_t fromNode, uint64_t toNode);
+extern int migrate_routes_to_contacts_graph(UniboCGRSAP* uniboCgrSap, ContactSAP *previousSap);
+
+extern int64_t compute_contact_volume(time_t duration, uint64_t xmitRate);
+extern int64_t convert_volume_to_mtv(double volume);
+extern int64_t convert_evc_to_mtv(uint64_t evc);
+extern void decrease_mtv(Contact *contact, int priority, int64_t volume);
+extern void increase_mtv(Contact *contact, int priority, int64_t volume);
+extern void decrease_hops_mtv(List hops, int priority, int64_t volume);
 
 extern int ContactSAP_open(UniboCGRSAP* uniboCgrSap);
 extern void ContactSAP_close(UniboCGRSAP* uniboCgrSap);
@@ -178,7 +274,12 @@ extern void removeExpiredContacts(UniboCGRSAP* uniboCgrSap);
 extern void remove_contact_from_graph(UniboCGRSAP* uniboCgrSap, time_t fromTime, uint64_t fromNode, uint64_t toNode);
 extern void remove_contact_elt_from_graph(UniboCGRSAP* uniboCgrSap, Contact *elt);
 int add_contact_to_graph(UniboCGRSAP* uniboCgrSap, uint64_t fromNode, uint64_t toNode, time_t fromTime,
-                         time_t toTime, uint64_t xmitRate, float confidence, int copyMTV, const double mtv[]);
+                         time_t toTime, uint64_t xmitRate, float confidence, int copyMTV, const int64_t mtv[]);
+extern int add_contacts_to_graph_bulk(UniboCGRSAP* uniboCgrSap, Contact **contacts, uint32_t count);
+extern int set_contacts_horizon(UniboCGRSAP* uniboCgrSap, time_t limit);
+extern time_t get_contacts_horizon(UniboCGRSAP* uniboCgrSap);
+extern int staged_contact_reaches_node(UniboCGRSAP* uniboCgrSap, uint64_t toNode, time_t before);
+extern time_t get_next_contact_start(UniboCGRSAP* uniboCgrSap);
 extern void discardAllRoutesFromContactsGraph(UniboCGRSAP* uniboCgrSap);
 
 extern Contact* get_contact(UniboCGRSAP* uniboCgrSap, uint64_t fromNode, uint64_t toNode, time_t fromTime,
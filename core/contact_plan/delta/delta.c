@@ -0,0 +1,701 @@
+/** \file delta.c
+ *
+ *  \brief  This file provides the implementation of the functions
+ *          to collect, sort and fold the operations of a contact plan delta.
+ *
+ *
+ ** \copyright Copyright (c) 2020, Alma Mater Studiorum, University of Bologna, All rights reserved.
+ **
+ ** \par License
+ **
+ **    This file is part of Unibo-CGR.                                            <br>
+ **                                                                               <br>
+ **    Unibo-CGR is free software: you can redistribute it and/or modify
+ **    it under the terms of the GNU General Public License as published by
+ **    the Free Software Foundation, either version 3 of the License, or
+ **    (at your option) any later version.                                        <br>
+ **    Unibo-CGR is distributed in the hope that it will be useful,
+ **    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ **    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ **    GNU General Public License for more details.                               <br>
+ **                                                                               <br>
+ **    You should have received a copy of the GNU General Public License
+ **    along with Unibo-CGR.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  \author agent, agent@local
+ *
+ *  \par Supervisor
+ *       Carlo Caini, carlo.caini@unibo.it
+ */
+
+#include "delta.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "../../UniboCGRSAP.h"
+
+#define DELTA_FIRST_CAPACITY 64
+
+/******************************************************************************
+ *
+ * \par Function Name:
+ *      delta_create
+ *
+ * \brief  Allocate an empty contact plan delta.
+ *
+ *
+ * \par Date Written:
+ *      18/10/26
+ *
+ * \return ContactPlanDelta*
+ *
+ * \retval ContactPlanDelta*  The new delta
+ * \retval NULL               MWITHDRAW error
+ *
+ * \par Revision History:
+ *
+ *  DD/MM/YY |  AUTHOR         |   DESCRIPTION
+ *  -------- | --------------- | -----------------------------------------------
+ *  18/10/26 | agent           |  Initial Implementation and documentation.
+ *****************************************************************************/
+ContactPlanDelta *delta_create()
+{
+	ContactPlanDelta *delta = MWITHDRAW(sizeof(ContactPlanDelta));
+
+	if (delta != NULL)
+	{
+		memset(delta, 0, sizeof(ContactPlanDelta));
+	}
+
+	return delta;
+}
+
+/******************************************************************************
+ *
+ * \par Function Name:
+ *      delta_destroy
+ *
+ * \brief  Deallocate a contact plan delta and all its operations.
+ *
+ *
+ * \par Date Written:
+ *      18/10/26
+ *
+ * \return void
+ *
+ * \param[in]   *delta   The delta, can be NULL
+ *
+ * \par Revision History:
+ *
+ *  DD/MM/YY |  AUTHOR         |   DESCRIPTION
+ *  -------- | --------------- | -----------------------------------------------
+ *  18/10/26 | agent           |  Initial Implementation and documentation.
+ *****************************************************************************/
+void delta_destroy(ContactPlanDelta *delta)
+{
+	if (delta != NULL)
+	{
+		if (delta->contacts != NULL)
+		{
+			MDEPOSIT(delta->contacts);
+		}
+		if (delta->ranges != NULL)
+		{
+			MDEPOSIT(delta->ranges);
+		}
+		MDEPOSIT(delta);
+	}
+}
+
+/******************************************************************************
+ *
+ * \par Function Name:
+ *      delta_clear
+ *
+ * \brief  Remove all the operations, keeping the allocated memory
+ *         for the next operations.
+ *
+ *
+ * \par Date Written:
+ *      18/10/26
+ *
+ * \return void
+ *
+ * \param[in]   *delta   The delta
+ *
+ * \par Revision History:
+ *
+ *  DD/MM/YY |  AUTHOR         |   DESCRIPTION
+ *  -------- | --------------- | -----------------------------------------------
+ *  18/10/26 | agent           |  Initial Implementation and documentation.
+ *****************************************************************************/
+void delta_clear(ContactPlanDelta *delta)
+{
+	if (delta != NULL)
+	{
+		delta->contactsCount = 0;
+		delta->rangesCount = 0;
+		delta->sequence = 0;
+	}
+}
+
+/******************************************************************************
+ *
+ * \par Function Name:
+ *      grow_array
+ *
+ * \brief  Double the capacity of an array of operations.
+ *
+ *
+ * \par Date Written:
+ *      18/10/26
+ *
+ * \return int
+ *
+ * \retval  0   Success case
+ * \retval -2   MWITHDRAW error (the array is not changed)
+ *
+ * \param[in,out]  **array      The array
+ * \param[in,out]  *capacity    The capacity of the array (elements)
+ * \param[in]      count        The elements in the array
+ * \param[in]      elementSize  The size of each element
+ *
+ * \par Revision History:
+ *
+ *  DD/MM/YY |  AUTHOR         |   DESCRIPTION
+ *  -------- | --------------- | -----------------------------------------------
+ *  18/10/26 | agent           |  Initial Implementation and documentation.
+ *****************************************************************************/
+static int grow_array(void **array, uint32_t *capacity, uint32_t count, size_t elementSize)
+{
+	uint32_t newCapacity = (*capacity == 0) ? DELTA_FIRST_CAPACITY : *capacity * 2;
+	void *newArray = MWITHDRAW(elementSize * newCapacity);
+
+	if (newArray == NULL)
+	{
+		return -2;
+	}
+
+	if (*array != NULL)
+	{
+		memcpy(newArray, *array, elementSize * count);
+		MDEPOSIT(*array);
+	}
+	*array = newArray;
+	*capacity = newCapacity;
+
+	return 0;
+}
+
+/******************************************************************************
+ *
+ * \par Function Name:
+ *      delta_push_contact
+ *
+ * \brief  Append an operation on a contact.
+ *
+ *
+ * \par Date Written:
+ *      18/10/26
+ *
+ * \return int
+ *
+ * \retval  0   Success case
+ * \retval -2   MWITHDRAW error
+ *
+ * \param[in]   *delta    The delta
+ * \param[in]   type      The operation
+ * \param[in]   fields    The DELTA_* fields revised (DeltaChange only)
+ * \param[in]   *record   The contact (DeltaAdd), or its key and the new values
+ *
+ * \par Revision History:
+ *
+ *  DD/MM/YY |  AUTHOR         |   DESCRIPTION
+ *  -------- | --------------- | -----------------------------------------------
+ *  18/10/26 | agent           |  Initial Implementation and documentation.
+ *****************************************************************************/
+int delta_push_contact(ContactPlanDelta *delta, DeltaOperationType type, uint32_t fields, const BinaryPlanContact *record)
+{
+	DeltaContactOperation *operation;
+
+	if (delta->contactsCount == delta->contactsCapacity)
+	{
+		if (grow_array((void **) &delta->contacts, &delta->contactsCapacity, delta->contactsCount,
+				sizeof(DeltaContactOperation)) < 0)
+		{
+			return -2;
+		}
+	}
+
+	operation = &delta->contacts[delta->contactsCount++];
+	operation->type = type;
+	operation->fields = (type == DeltaChange) ? fields : 0;
+	operation->sequence = delta->sequence++;
+	operation->record = *record;
+
+	return 0;
+}
+
+/******************************************************************************
+ *
+ * \par Function Name:
+ *      delta_push_range
+ *
+ * \brief  Append an operation on a range.
+ *
+ *
+ * \par Date Written:
+ *      18/10/26
+ *
+ * \return int
+ *
+ * \retval  0   Success case
+ * \retval -2   MWITHDRAW error
+ *
+ * \param[in]   *delta    The delta
+ * \param[in]   type      The operation
+ * \param[in]   fields    The DELTA_* fields revised (DeltaChange only)
+ * \param[in]   *record   The range (DeltaAdd), or its key and the new values
+ *
+ * \par Revision History:
+ *
+ *  DD/MM/YY |  AUTHOR         |   DESCRIPTION
+ *  -------- | --------------- | -----------------------------------------------
+ *  18/10/26 | agent           |  Initial Implementation and documentation.
+ *****************************************************************************/
+int delta_push_range(ContactPlanDelta *delta, DeltaOperationType type, uint32_t fields, const BinaryPlanRange *record)
+{
+	DeltaRangeOperation *operation;
+
+	if (delta->rangesCount == delta->rangesCapacity)
+	{
+		if (grow_array((void **) &delta->ranges, &delta->rangesCapacity, delta->rangesCount,
+				sizeof(DeltaRangeOperation)) < 0)
+		{
+			return -2;
+		}
+	}
+
+	operation = &delta->ranges[delta->rangesCount++];
+	operation->type = type;
+	operation->fields = (type == DeltaChange) ? fields : 0;
+	operation->sequence = delta->sequence++;
+	operation->record = *record;
+
+	return 0;
+}
+
+/******************************************************************************
+ *
+ * \par Function Name:
+ *      delta_compare_keys
+ *
+ * \brief  Compare two contacts (ranges) keys, in the same order
+ *         of the contacts (ranges) graph.
+ *
+ *
+ * \par Date Written:
+ *      18/10/26
+ *
+ * \return int
+ *
+ * \retval  -1  The first key is lower than the second
+ * \retval   0  Same key
+ * \retval   1  The first key is greater than the second
+ *
+ * \par Revision History:
+ *
+ *  DD/MM/YY |  AUTHOR         |   DESCRIPTION
+ *  -------- | --------------- | -----------------------------------------------
+ *  18/10/26 | agent           |  Initial Implementation and documentation.
+ *****************************************************************************/
+int delta_compare_keys(uint64_t fromNode1, uint64_t toNode1, int64_t fromTime1,
+		uint64_t fromNode2, uint64_t toNode2, int64_t fromTime2)
+{
+	if (fromNode1 != fromNode2)
+	{
+		return (fromNode1 < fromNode2) ? -1 : 1;
+	}
+	if (toNode1 != toNode2)
+	{
+		return (toNode1 < toNode2) ? -1 : 1;
+	}
+	if (fromTime1 != fromTime2)
+	{
+		return (fromTime1 < fromTime2) ? -1 : 1;
+	}
+
+	return 0;
+}
+
+/******************************************************************************
+ *
+ * \par Function Name:
+ *      compare_contact_operations
+ *
+ * \brief  qsort() comparator: by contact key, then by insertion order.
+ *
+ *
+ * \par Date Written:
+ *      18/10/26
+ *
+ * \return int
+ *
+ * \param[in]	*first    Pointer to the first DeltaContactOperation
+ * \param[in]	*second   Pointer to the second DeltaContactOperation
+ *
+ * \par Revision History:
+ *
+ *  DD/MM/YY |  AUTHOR         |   DESCRIPTION
+ *  -------- | --------------- | -----------------------------------------------
+ *  18/10/26 | agent           |  Initial Implementation and documentation.
+ *****************************************************************************/
+static int compare_contact_operations(const void *first, const void *second)
+{
+	const DeltaContactOperation *a = first;
+	const DeltaContactOperation *b = second;
+	int result = delta_compare_keys(a->record.fromNode, a->record.toNode, a->record.fromTime,
+			b->record.fromNode, b->record.toNode, b->record.fromTime);
+
+	if (result == 0)
+	{
+		result = (a->sequence < b->sequence) ? -1 : (a->sequence > b->sequence);
+	}
+
+	return result;
+}
+
+/******************************************************************************
+ *
+ * \par Function Name:
+ *      compare_range_operations
+ *
+ * \brief  qsort() comparator: by range key, then by insertion order.
+ *
+ *
+ * \par Date Written:
+ *      18/10/26
+ *
+ * \return int
+ *
+ * \param[in]	*first    Pointer to the first DeltaRangeOperation
+ * \param[in]	*second   Pointer to the second DeltaRangeOperation
+ *
+ * \par Revision History:
+ *
+ *  DD/MM/YY |  AUTHOR         |   DESCRIPTION
+ *  -------- | --------------- | -----------------------------------------------
+ *  18/10/26 | agent           |  Initial Implementation and documentation.
+ *****************************************************************************/
+static int compare_range_operations(const void *first, const void *second)
+{
+	const DeltaRangeOperation *a = first;
+	const DeltaRangeOperation *b = second;
+	int result = delta_compare_keys(a->record.fromNode, a->record.toNode, a->record.fromTime,
+			b->record.fromNode, b->record.toNode, b->record.fromTime);
+
+	if (result == 0)
+	{
+		result = (a->sequence < b->sequence) ? -1 : (a->sequence > b->sequence);
+	}
+
+	return result;
+}
+
+/******************************************************************************
+ *
+ * \par Function Name:
+ *      delta_sort
+ *
+ * \brief  Sort the operations as the contacts (ranges) graph; the operations
+ *         on the same contact (range) stay in insertion order.
+ *
+ *
+ * \par Date Written:
+ *      18/10/26
+ *
+ * \return void
+ *
+ * \param[in]   *delta   The delta
+ *
+ * \par Revision History:
+ *
+ *  DD/MM/YY |  AUTHOR         |   DESCRIPTION
+ *  -------- | --------------- | -----------------------------------------------
+ *  18/10/26 | agent           |  Initial Implementation and documentation.
+ *****************************************************************************/
+void delta_sort(ContactPlanDelta *delta)
+{
+	if (delta->contactsCount > 1)
+	{
+		qsort(delta->contacts, delta->contactsCount, sizeof(DeltaContactOperation), compare_contact_operations);
+	}
+	if (delta->rangesCount > 1)
+	{
+		qsort(delta->ranges, delta->rangesCount, sizeof(DeltaRangeOperation), compare_range_operations);
+	}
+}
+
+/******************************************************************************
+ *
+ * \par Function Name:
+ *      revise_contact_record
+ *
+ * \brief  Copy the fields revised by a DeltaChange operation.
+ *
+ *
+ * \par Date Written:
+ *      18/10/26
+ *
+ * \return void
+ *
+ * \param[out]  *record      The record to revise
+ * \param[in]   *operation   The DeltaChange operation
+ *
+ * \par Revision History:
+ *
+ *  DD/MM/YY |  AUTHOR         |   DESCRIPTION
+ *  -------- | --------------- | -----------------------------------------------
+ *  18/10/26 | agent           |  Initial Implementation and documentation.
+ *****************************************************************************/
+static void revise_contact_record(BinaryPlanContact *record, const DeltaContactOperation *operation)
+{
+	if (operation->fields & DELTA_END_TIME)
+	{
+		record->toTime = operation->record.toTime;
+	}
+	if (operation->fields & DELTA_XMIT_RATE)
+	{
+		record->xmitRate = operation->record.xmitRate;
+	}
+	if (operation->fields & DELTA_CONFIDENCE)
+	{
+		record->confidence = operation->record.confidence;
+	}
+}
+
+/******************************************************************************
+ *
+ * \par Function Name:
+ *      delta_fold_contacts
+ *
+ * \brief  Reduce the (sorted) operations on each contact to their net effect.
+ *
+ *
+ * \par Date Written:
+ *      18/10/26
+ *
+ * \return int
+ *
+ * \retval  0   Success case
+ * \retval -1   A contact is changed after it has been removed by the delta
+ * \retval -3   A contact is added twice by the delta
+ *
+ * \param[in]   *delta           The delta, sorted by delta_sort()
+ * \param[out]  *effects         At least delta->contactsCount elements
+ * \param[out]  *effectsCount    The number of effects, one for each contact, in key order
+ *
+ * \par Notes:
+ *          1. A contact added then changed is added with the new values;
+ *             a contact added then removed is not added.
+ *
+ * \par Revision History:
+ *
+ *  DD/MM/YY |  AUTHOR         |   DESCRIPTION
+ *  -------- | --------------- | -----------------------------------------------
+ *  18/10/26 | agent           |  Initial Implementation and documentation.
+ *****************************************************************************/
+int delta_fold_contacts(ContactPlanDelta *delta, DeltaContactEffect *effects, uint32_t *effectsCount)
+{
+	uint32_t i = 0, count = 0;
+
+	while (i < delta->contactsCount)
+	{
+		DeltaContactEffect *effect = &effects[count++];
+		const DeltaContactOperation *first = &delta->contacts[i];
+
+		memset(effect, 0, sizeof(DeltaContactEffect));
+		effect->record = first->record;
+
+		for (; i < delta->contactsCount; i++)
+		{
+			const DeltaContactOperation *operation = &delta->contacts[i];
+
+			if (delta_compare_keys(first->record.fromNode, first->record.toNode, first->record.fromTime,
+					operation->record.fromNode, operation->record.toNode, operation->record.fromTime) != 0)
+			{
+				break;
+			}
+
+			if (operation->type == DeltaAdd)
+			{
+				if (effect->add)
+				{
+					return -3;
+				}
+				effect->add = 1;
+				effect->record = operation->record;
+			}
+			else if (operation->type == DeltaRemove)
+			{
+				if (effect->add)
+				{
+					// drop the contact added by the delta: the removal of
+					// the contact in the plan (if any) has been already set
+					effect->add = 0;
+				}
+				else
+				{
+					effect->remove = 1;
+					effect->fields = 0;
+				}
+			}
+			else if (effect->add)
+			{
+				revise_contact_record(&effect->record, operation);
+			}
+			else if (effect->remove)
+			{
+				return -1;
+			}
+			else
+			{
+				revise_contact_record(&effect->record, operation);
+				effect->fields |= operation->fields;
+			}
+		}
+	}
+
+	*effectsCount = count;
+
+	return 0;
+}
+
+/******************************************************************************
+ *
+ * \par Function Name:
+ *      revise_range_record
+ *
+ * \brief  Copy the fields revised by a DeltaChange operation.
+ *
+ *
+ * \par Date Written:
+ *      18/10/26
+ *
+ * \return void
+ *
+ * \param[out]  *record      The record to revise
+ * \param[in]   *operation   The DeltaChange operation
+ *
+ * \par Revision History:
+ *
+ *  DD/MM/YY |  AUTHOR         |   DESCRIPTION
+ *  -------- | --------------- | -----------------------------------------------
+ *  18/10/26 | agent           |  Initial Implementation and documentation.
+ *****************************************************************************/
+static void revise_range_record(BinaryPlanRange *record, const DeltaRangeOperation *operation)
+{
+	if (operation->fields & DELTA_END_TIME)
+	{
+		record->toTime = operation->record.toTime;
+	}
+	if (operation->fields & DELTA_OWLT)
+	{
+		record->owlt = operation->record.owlt;
+	}
+}
+
+/******************************************************************************
+ *
+ * \par Function Name:
+ *      delta_fold_ranges
+ *
+ * \brief  Reduce the (sorted) operations on each range to their net effect.
+ *
+ *
+ * \par Date Written:
+ *      18/10/26
+ *
+ * \return int
+ *
+ * \retval  0   Success case
+ * \retval -1   A range is changed after it has been removed by the delta
+ * \retval -3   A range is added twice by the delta
+ *
+ * \param[in]   *delta           The delta, sorted by delta_sort()
+ * \param[out]  *effects         At least delta->rangesCount elements
+ * \param[out]  *effectsCount    The number of effects, one for each range, in key order
+ *
+ * \par Notes:
+ *          1. Same rules of delta_fold_contacts().
+ *
+ * \par Revision History:
+ *
+ *  DD/MM/YY |  AUTHOR         |   DESCRIPTION
+ *  -------- | --------------- | -----------------------------------------------
+ *  18/10/26 | agent           |  Initial Implementation and documentation.
+ *****************************************************************************/
+int delta_fold_ranges(ContactPlanDelta *delta, DeltaRangeEffect *effects, uint32_t *effectsCount)
+{
+	uint32_t i = 0, count = 0;
+
+	while (i < delta->rangesCount)
+	{
+		DeltaRangeEffect *effect = &effects[count++];
+		const DeltaRangeOperation *first = &delta->ranges[i];
+
+		memset(effect, 0, sizeof(DeltaRangeEffect));
+		effect->record = first->record;
+
+		for (; i < delta->rangesCount; i++)
+		{
+			const DeltaRangeOperation *operation = &delta->ranges[i];
+
+			if (delta_compare_keys(first->record.fromNode, first->record.toNode, first->record.fromTime,
+					operation->record.fromNode, operation->record.toNode, operation->record.fromTime) != 0)
+			{
+				break;
+			}
+
+			if (operation->type == DeltaAdd)
+			{
+				if (effect->add)
+				{
+					return -3;
+				}
+				effect->add = 1;
+				effect->record = operation->record;
+			}
+			else if (operation->type == DeltaRemove)
+			{
+				if (effect->add)
+				{
+					effect->add = 0;
+				}
+				else
+				{
+					effect->remove = 1;
+					effect->fields = 0;
+				}
+			}
+			else if (effect->add)
+			{
+				revise_range_record(&effect->record, operation);
+			}
+			else if (effect->remove)
+			{
+				return -1;
+			}
+			else
+			{
+				revise_range_record(&effect->record, operation);
+				effect->fields |= operation->fields;
+			}
+		}
+	}
+
+	*effectsCount = count;
+
+	return 0;
+}
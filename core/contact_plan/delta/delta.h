@@ -0,0 +1,146 @@
+/** \file delta.h
+ *
+ * \brief  This file provides the definition of the contact plan delta,
+ *         a batch of add/remove/change operations on contacts and ranges,
+ *         with all the declarations of the functions to collect and fold them.
+ *
+ * \details The operations are kept in insertion order; delta_sort() sorts them
+ *          as the contacts (ranges) graph, keeping the insertion order between
+ *          the operations on the same contact (range). Then delta_fold_contacts()
+ *          and delta_fold_ranges() reduce the operations on each contact (range)
+ *          to their net effect, that is applied once.
+ *          All the times are Unix times.
+ *
+ *
+ ** \copyright Copyright (c) 2020, Alma Mater Studiorum, University of Bologna, All rights reserved.
+ **
+ ** \par License
+ **
+ **    This file is part of Unibo-CGR.                                            <br>
+ **                                                                               <br>
+ **    Unibo-CGR is free software: you can redistribute it and/or modify
+ **    it under the terms of the GNU General Public License as published by
+ **    the Free Software Foundation, either version 3 of the License, or
+ **    (at your option) any later version.                                        <br>
+ **    Unibo-CGR is distributed in the hope that it will be useful,
+ **    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ **    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ **    GNU General Public License for more details.                               <br>
+ **                                                                               <br>
+ **    You should have received a copy of the GNU General Public License
+ **    along with Unibo-CGR.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  \author agent, agent@local
+ *
+ *  \par Supervisor
+ *       Carlo Caini, carlo.caini@unibo.it
+ */
+
+#ifndef SOURCES_CONTACTS_PLAN_DELTA_DELTA_H_
+#define SOURCES_CONTACTS_PLAN_DELTA_DELTA_H_
+
+#include <stdint.h>
+#include <sys/time.h>
+
+#include "../../library/commonDefines.h"
+#include "../binary_plan/binary_plan.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/**
+ * \brief Fields revised by a DeltaChange operation (bit mask).
+ */
+#define DELTA_END_TIME   1
+#define DELTA_XMIT_RATE  2
+#define DELTA_CONFIDENCE 4
+#define DELTA_OWLT       8
+
+typedef enum
+{
+	DeltaAdd = 0,
+	DeltaRemove,
+	DeltaChange
+} DeltaOperationType;
+
+typedef struct
+{
+	DeltaOperationType type;
+	/**
+	 * \brief DELTA_* fields revised (DeltaChange only)
+	 */
+	uint32_t fields;
+	/**
+	 * \brief Insertion order
+	 */
+	uint64_t sequence;
+	/**
+	 * \brief The contact (DeltaAdd), its key (DeltaRemove), its key and the new values (DeltaChange)
+	 */
+	BinaryPlanContact record;
+} DeltaContactOperation;
+
+typedef struct
+{
+	DeltaOperationType type;
+	uint32_t fields;
+	uint64_t sequence;
+	BinaryPlanRange record;
+} DeltaRangeOperation;
+
+typedef struct
+{
+	DeltaContactOperation *contacts;
+	uint32_t contactsCount;
+	uint32_t contactsCapacity;
+	DeltaRangeOperation *ranges;
+	uint32_t rangesCount;
+	uint32_t rangesCapacity;
+	uint64_t sequence;
+} ContactPlanDelta;
+
+/**
+ * \brief The net effect of the operations on the same contact.
+ *
+ * \details Applied in this order: the contact in the plan is removed (remove),
+ *          or revised (fields); then the contact in record is added (add).
+ */
+typedef struct
+{
+	int remove;
+	uint32_t fields;
+	int add;
+	BinaryPlanContact record;
+} DeltaContactEffect;
+
+/**
+ * \brief The net effect of the operations on the same range (see DeltaContactEffect).
+ */
+typedef struct
+{
+	int remove;
+	uint32_t fields;
+	int add;
+	BinaryPlanRange record;
+} DeltaRangeEffect;
+
+extern ContactPlanDelta *delta_create();
+extern void delta_destroy(ContactPlanDelta *delta);
+extern void delta_clear(ContactPlanDelta *delta);
+
+extern int delta_push_contact(ContactPlanDelta *delta, DeltaOperationType type, uint32_t fields, const BinaryPlanContact *record);
+extern int delta_push_range(ContactPlanDelta *delta, DeltaOperationType type, uint32_t fields, const BinaryPlanRange *record);
+
+extern int delta_compare_keys(uint64_t fromNode1, uint64_t toNode1, int64_t fromTime1,
+		uint64_t fromNode2, uint64_t toNode2, int64_t fromTime2);
+extern void delta_sort(ContactPlanDelta *delta);
+extern int delta_fold_contacts(ContactPlanDelta *delta, DeltaContactEffect *effects, uint32_t *effectsCount);
+extern int delta_fold_ranges(ContactPlanDelta *delta, DeltaRangeEffect *effects, uint32_t *effectsCount);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SOURCES_CONTACTS_PLAN_DELTA_DELTA_H_ */
@@ -0,0 +1,505 @@
+/** \file node_index.c
+ *
+ *  \brief  This file provides the implementation of the functions
+ *          to intern the ipn node numbers into dense node indexes.
+ *
+ *  \details Each ipn node number met at contact insertion gets a 32-bit index:
+ *           the indexes are assigned in order (1, 2, 3, ...), so the per-node state
+ *           (neighbors, excluded neighbors) can be kept in flat arrays indexed by node.
+ *           The index of a node never changes until the Unibo-CGR instance is closed,
+ *           even if all its contacts are removed or the contact plan is replaced.
+ *           The index 0 (NO_NODE_INDEX) is never assigned.
+ *
+ *
+ ** \copyright Copyright (c) 2020, Alma Mater Studiorum, University of Bologna, All rights reserved.
+ **
+ ** \par License
+ **
+ **    This file is part of Unibo-CGR.                                            <br>
+ **                                                                               <br>
+ **    Unibo-CGR is free software: you can redistribute it and/or modify
+ **    it under the terms of the GNU General Public License as published by
+ **    the Free Software Foundation, either version 3 of the License, or
+ **    (at your option) any later version.                                        <br>
+ **    Unibo-CGR is distributed in the hope that it will be useful,
+ **    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ **    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ **    GNU General Public License for more details.                               <br>
+ **                                                                               <br>
+ **    You should have received a copy of the GNU General Public License
+ **    along with Unibo-CGR.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  \author agent, agent@local
+ *
+ *  \par Supervisor
+ *       Carlo Caini, carlo.caini@unibo.it
+ */
+
+#include "node_index.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define NODE_INDEX_FIRST_CAPACITY 64
+
+typedef struct
+{
+	/**
+	 * \brief The ipn node number
+	 */
+	uint64_t nodeNbr;
+	/**
+	 * \brief The node index, NO_NODE_INDEX for the empty slots
+	 */
+	uint32_t index;
+} NodeIndexSlot;
+
+/**
+ * \brief This struct is used to keep in one place all the data used by
+ *        the node indexes.
+ */
+struct NodeIndexSAP
+{
+	/**
+	 * \brief Open addressing hash table (linear probing), never more than half full.
+	 */
+	NodeIndexSlot *slots;
+	/**
+	 * \brief The number of slots (a power of 2).
+	 */
+	uint32_t slotsCapacity;
+	/**
+	 * \brief The ipn node number of each node index.
+	 */
+	uint64_t *nodeNumbers;
+	/**
+	 * \brief The length of nodeNumbers.
+	 */
+	uint32_t nodeNumbersCapacity;
+	/**
+	 * \brief The next node index to assign: all the indexes are less than it.
+	 */
+	uint32_t bound;
+};
+
+/******************************************************************************
+ *
+ * \par Function Name:
+ *      hash_node_number
+ *
+ * \brief  Get the first slot to probe for the ipn node number
+ *
+ *
+ * \par Date Written:
+ *      18/10/26
+ *
+ * \return uint32_t
+ *
+ * \param[in]  nodeNbr        The ipn node number
+ * \param[in]  capacity       The number of slots (a power of 2)
+ *
+ * \par Notes:
+ *          1.  Fibonacci hashing: the node numbers are often consecutive.
+ *
+ * \par Revision History:
+ *
+ *  DD/MM/YY |  AUTHOR         |   DESCRIPTION
+ *  -------- | --------------- | -----------------------------------------------
+ *  18/10/26 | agent           |  Initial Implementation and documentation.
+ *****************************************************************************/
+static uint32_t hash_node_number(uint64_t nodeNbr, uint32_t capacity)
+{
+	return (uint32_t) ((nodeNbr * 0x9E3779B97F4A7C15ULL) >> 32) & (capacity - 1);
+}
+
+/******************************************************************************
+ *
+ * \par Function Name:
+ *      find_slot
+ *
+ * \brief  Get the slot of the ipn node number, or the empty slot where it goes
+ *
+ *
+ * \par Date Written:
+ *      18/10/26
+ *
+ * \return NodeIndexSlot*
+ *
+ * \param[in]  *sap      The NodeIndexSAP
+ * \param[in]  nodeNbr   The ipn node number
+ *
+ * \par Revision History:
+ *
+ *  DD/MM/YY |  AUTHOR         |   DESCRIPTION
+ *  -------- | --------------- | -----------------------------------------------
+ *  18/10/26 | agent           |  Initial Implementation and documentation.
+ *****************************************************************************/
+static NodeIndexSlot *find_slot(NodeIndexSAP *sap, uint64_t nodeNbr)
+{
+	uint32_t i = hash_node_number(nodeNbr, sap->slotsCapacity);
+
+	while (sap->slots[i].index != NO_NODE_INDEX && sap->slots[i].nodeNbr != nodeNbr)
+	{
+		i = (i + 1) & (sap->slotsCapacity - 1);
+	}
+
+	return &(sap->slots[i]);
+}
+
+/******************************************************************************
+ *
+ * \par Function Name:
+ *      grow_slots
+ *
+ * \brief  Double the hash table
+ *
+ *
+ * \par Date Written:
+ *      18/10/26
+ *
+ * \return int
+ *
+ * \retval   0  Success case
+ * \retval  -2  MWITHDRAW error (the hash table is unchanged)
+ *
+ * \param[in]  *sap   The NodeIndexSAP
+ *
+ * \par Revision History:
+ *
+ *  DD/MM/YY |  AUTHOR         |   DESCRIPTION
+ *  -------- | --------------- | -----------------------------------------------
+ *  18/10/26 | agent           |  Initial Implementation and documentation.
+ *****************************************************************************/
+static int grow_slots(NodeIndexSAP *sap)
+{
+	NodeIndexSlot *previous = sap->slots;
+	uint32_t previousCapacity = sap->slotsCapacity;
+	uint32_t i;
+
+	if (previousCapacity >= 0x80000000U)
+	{
+		return -2;
+	}
+
+	sap->slots = (NodeIndexSlot*) MWITHDRAW(sizeof(NodeIndexSlot) * previousCapacity * 2);
+	if (sap->slots == NULL)
+	{
+		sap->slots = previous;
+		return -2;
+	}
+	memset(sap->slots, 0, sizeof(NodeIndexSlot) * previousCapacity * 2);
+	sap->slotsCapacity = previousCapacity * 2;
+
+	for (i = 0; i < previousCapacity; i++)
+	{
+		if (previous[i].index != NO_NODE_INDEX)
+		{
+			*find_slot(sap, previous[i].nodeNbr) = previous[i];
+		}
+	}
+
+	MDEPOSIT(previous);
+
+	return 0;
+}
+
+/******************************************************************************
+ *
+ * \par Function Name:
+ *      grow_node_indexed_array
+ *
+ * \brief  Make room in an array indexed by node index for all the indexes less than bound
+ *
+ *
+ * \par Date Written:
+ *      18/10/26
+ *
+ * \return int
+ *
+ * \retval   0  Success case: *capacity >= bound
+ * \retval  -2  MWITHDRAW error (the array is unchanged)
+ *
+ * \param[in,out]  **array        The array (allocated by MWITHDRAW), NULL if never allocated
+ * \param[in,out]  *capacity      The number of elements of the array
+ * \param[in]      elementSize    The size of each element
+ * \param[in]      bound          The node indexes will be less than this value
+ *
+ * \par Notes:
+ *          1.  The new elements are zeroed, the old ones are kept.
+ *
+ * \par Revision History:
+ *
+ *  DD/MM/YY |  AUTHOR         |   DESCRIPTION
+ *  -------- | --------------- | -----------------------------------------------
+ *  18/10/26 | agent           |  Initial Implementation and documentation.
+ *****************************************************************************/
+int grow_node_indexed_array(void **array, uint32_t *capacity, size_t elementSize, uint32_t bound)
+{
+	uint32_t newCapacity;
+	void *newArray;
+
+	if (*capacity >= bound)
+	{
+		return 0;
+	}
+
+	newCapacity = (*capacity > 0) ? *capacity : NODE_INDEX_FIRST_CAPACITY;
+	while (newCapacity < bound)
+	{
+		newCapacity = (newCapacity > 0x7FFFFFFFU) ? bound : newCapacity * 2;
+	}
+
+	newArray = MWITHDRAW(elementSize * newCapacity);
+	if (newArray == NULL)
+	{
+		return -2;
+	}
+
+	memset(newArray, 0, elementSize * newCapacity);
+	if (*array != NULL)
+	{
+		memcpy(newArray, *array, elementSize * (*capacity));
+		MDEPOSIT(*array);
+	}
+
+	*array = newArray;
+	*capacity = newCapacity;
+
+	return 0;
+}
+
+/******************************************************************************
+ *
+ * \par Function Name:
+ *      NodeIndexSAP_open
+ *
+ * \brief  Allocate memory for the node indexes
+ *
+ *
+ * \par Date Written:
+ *      18/10/26
+ *
+ * \return int
+ *
+ * \retval   0  Success case: the node indexes now exist
+ * \retval  -2  MWITHDRAW error
+ *
+ *
+ * \par Revision History:
+ *
+ *  DD/MM/YY |  AUTHOR         |   DESCRIPTION
+ *  -------- | --------------- | -----------------------------------------------
+ *  18/10/26 | agent           |  Initial Implementation and documentation.
+ *****************************************************************************/
+int NodeIndexSAP_open(UniboCGRSAP* uniboCgrSap)
+{
+    if (UniboCGRSAP_get_NodeIndexSAP(uniboCgrSap)) return 0;
+    NodeIndexSAP* sap = MWITHDRAW(sizeof(NodeIndexSAP));
+    if (!sap) return -2;
+    UniboCGRSAP_set_NodeIndexSAP(uniboCgrSap, sap);
+    memset(sap, 0, sizeof(NodeIndexSAP));
+    sap->bound = NO_NODE_INDEX + 1;
+    sap->slots = MWITHDRAW(sizeof(NodeIndexSlot) * NODE_INDEX_FIRST_CAPACITY);
+    if (!sap->slots) {
+        NodeIndexSAP_close(uniboCgrSap);
+        return -2;
+    }
+    memset(sap->slots, 0, sizeof(NodeIndexSlot) * NODE_INDEX_FIRST_CAPACITY);
+    sap->slotsCapacity = NODE_INDEX_FIRST_CAPACITY;
+
+    return 0;
+}
+
+/******************************************************************************
+ *
+ * \par Function Name:
+ *      NodeIndexSAP_close
+ *
+ * \brief  Deallocate all the memory used by the node indexes.
+ *
+ *
+ * \par Date Written:
+ *      18/10/26
+ *
+ * \return void
+ *
+ * \par Revision History:
+ *
+ *  DD/MM/YY |  AUTHOR         |   DESCRIPTION
+ *  -------- | --------------- | -----------------------------------------------
+ *  18/10/26 | agent           |  Initial Implementation and documentation.
+ *****************************************************************************/
+void NodeIndexSAP_close(UniboCGRSAP* uniboCgrSap)
+{
+    NodeIndexSAP* sap = UniboCGRSAP_get_NodeIndexSAP(uniboCgrSap);
+    if (!sap) return;
+    if (sap->slots) MDEPOSIT(sap->slots);
+    if (sap->nodeNumbers) MDEPOSIT(sap->nodeNumbers);
+    memset(sap, 0, sizeof(NodeIndexSAP));
+    MDEPOSIT(sap);
+    UniboCGRSAP_set_NodeIndexSAP(uniboCgrSap, NULL);
+}
+
+/******************************************************************************
+ *
+ * \par Function Name:
+ *      intern_node
+ *
+ * \brief  Get the node index of the ipn node number, assigning the next one
+ *         if the node has never been met
+ *
+ *
+ * \par Date Written:
+ *      18/10/26
+ *
+ * \return uint32_t
+ *
+ * \retval  "> 0"           The node index
+ * \retval  NO_NODE_INDEX   MWITHDRAW error, or nodeNbr is 0
+ *
+ * \param[in]  nodeNbr   The ipn node number
+ *
+ * \par Revision History:
+ *
+ *  DD/MM/YY |  AUTHOR         |   DESCRIPTION
+ *  -------- | --------------- | -----------------------------------------------
+ *  18/10/26 | agent           |  Initial Implementation and documentation.
+ *****************************************************************************/
+uint32_t intern_node(UniboCGRSAP* uniboCgrSap, uint64_t nodeNbr)
+{
+	NodeIndexSAP *sap = UniboCGRSAP_get_NodeIndexSAP(uniboCgrSap);
+	NodeIndexSlot *slot;
+
+	if (nodeNbr == 0)
+	{
+		return NO_NODE_INDEX;
+	}
+
+	slot = find_slot(sap, nodeNbr);
+	if (slot->index != NO_NODE_INDEX)
+	{
+		return slot->index;
+	}
+
+	if (sap->bound == UINT32_MAX
+			|| grow_node_indexed_array((void**) &(sap->nodeNumbers), &(sap->nodeNumbersCapacity),
+					sizeof(uint64_t), sap->bound + 1) < 0)
+	{
+		return NO_NODE_INDEX;
+	}
+
+	if ((sap->bound + 1) * 2 > sap->slotsCapacity)
+	{
+		if (grow_slots(sap) < 0)
+		{
+			return NO_NODE_INDEX;
+		}
+		slot = find_slot(sap, nodeNbr);
+	}
+
+	slot->nodeNbr = nodeNbr;
+	slot->index = sap->bound;
+	sap->nodeNumbers[sap->bound] = nodeNbr;
+	sap->bound++;
+
+	return slot->index;
+}
+
+/******************************************************************************
+ *
+ * \par Function Name:
+ *      get_node_index
+ *
+ * \brief  Get the node index of the ipn node number
+ *
+ *
+ * \par Date Written:
+ *      18/10/26
+ *
+ * \return uint32_t
+ *
+ * \retval  "> 0"           The node index
+ * \retval  NO_NODE_INDEX   The node has never been interned
+ *
+ * \param[in]  nodeNbr   The ipn node number
+ *
+ * \par Revision History:
+ *
+ *  DD/MM/YY |  AUTHOR         |   DESCRIPTION
+ *  -------- | --------------- | -----------------------------------------------
+ *  18/10/26 | agent           |  Initial Implementation and documentation.
+ *****************************************************************************/
+uint32_t get_node_index(UniboCGRSAP* uniboCgrSap, uint64_t nodeNbr)
+{
+	NodeIndexSAP *sap = UniboCGRSAP_get_NodeIndexSAP(uniboCgrSap);
+
+	if (nodeNbr == 0)
+	{
+		return NO_NODE_INDEX;
+	}
+
+	return find_slot(sap, nodeNbr)->index;
+}
+
+/******************************************************************************
+ *
+ * \par Function Name:
+ *      get_node_number
+ *
+ * \brief  Get the ipn node number of the node index
+ *
+ *
+ * \par Date Written:
+ *      18/10/26
+ *
+ * \return uint64_t
+ *
+ * \retval  "> 0"  The ipn node number
+ * \retval      0  The node index has never been assigned
+ *
+ * \param[in]  index   The node index
+ *
+ * \par Revision History:
+ *
+ *  DD/MM/YY |  AUTHOR         |   DESCRIPTION
+ *  -------- | --------------- | -----------------------------------------------
+ *  18/10/26 | agent           |  Initial Implementation and documentation.
+ *****************************************************************************/
+uint64_t get_node_number(UniboCGRSAP* uniboCgrSap, uint32_t index)
+{
+	NodeIndexSAP *sap = UniboCGRSAP_get_NodeIndexSAP(uniboCgrSap);
+
+	if (index == NO_NODE_INDEX || index >= sap->bound)
+	{
+		return 0;
+	}
+
+	return sap->nodeNumbers[index];
+}
+
+/******************************************************************************
+ *
+ * \par Function Name:
+ *      get_node_index_bound
+ *
+ * \brief  Get the upper bound (excluded) of the node indexes assigned so far
+ *
+ *
+ * \par Date Written:
+ *      18/10/26
+ *
+ * \return uint32_t
+ *
+ * \par Notes:
+ *          1.  Use it to size the arrays indexed by node index.
+ *
+ * \par Revision History:
+ *
+ *  DD/MM/YY |  AUTHOR         |   DESCRIPTION
+ *  -------- | --------------- | -----------------------------------------------
+ *  18/10/26 | agent           |  Initial Implementation and documentation.
+ *****************************************************************************/
+uint32_t get_node_index_bound(UniboCGRSAP* uniboCgrSap)
+{
+	return UniboCGRSAP_get_NodeIndexSAP(uniboCgrSap)->bound;
+}
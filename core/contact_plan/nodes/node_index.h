@@ -0,0 +1,63 @@
+/** \file node_index.h
+ *
+ * \brief  This file provides the declarations of the functions
+ *         to intern the ipn node numbers into dense node indexes.
+ *
+ *
+ ** \copyright Copyright (c) 2020, Alma Mater Studiorum, University of Bologna, All rights reserved.
+ **
+ ** \par License
+ **
+ **    This file is part of Unibo-CGR.                                            <br>
+ **                                                                               <br>
+ **    Unibo-CGR is free software: you can redistribute it and/or modify
+ **    it under the terms of the GNU General Public License as published by
+ **    the Free Software Foundation, either version 3 of the License, or
+ **    (at your option) any later version.                                        <br>
+ **    Unibo-CGR is distributed in the hope that it will be useful,
+ **    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ **    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ **    GNU General Public License for more details.                               <br>
+ **                                                                               <br>
+ **    You should have received a copy of the GNU General Public License
+ **    along with Unibo-CGR.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  \author agent, agent@local
+ *
+ *  \par Supervisor
+ *       Carlo Caini, carlo.caini@unibo.it
+ */
+
+#ifndef SOURCES_CONTACTS_PLAN_NODES_NODE_INDEX_H_
+#define SOURCES_CONTACTS_PLAN_NODES_NODE_INDEX_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "../../UniboCGRSAP.h"
+#include "../../library/commonDefines.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/**
+ * \brief The node index of the nodes never interned.
+ */
+#define NO_NODE_INDEX 0
+
+extern int NodeIndexSAP_open(UniboCGRSAP* uniboCgrSap);
+extern void NodeIndexSAP_close(UniboCGRSAP* uniboCgrSap);
+
+extern uint32_t intern_node(UniboCGRSAP* uniboCgrSap, uint64_t nodeNbr);
+extern uint32_t get_node_index(UniboCGRSAP* uniboCgrSap, uint64_t nodeNbr);
+extern uint64_t get_node_number(UniboCGRSAP* uniboCgrSap, uint32_t index);
+extern uint32_t get_node_index_bound(UniboCGRSAP* uniboCgrSap);
+extern int grow_node_indexed_array(void **array, uint32_t *capacity, size_t elementSize, uint32_t bound);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SOURCES_CONTACTS_PLAN_NODES_NODE_INDEX_H_ */
@@ -32,6 +32,7 @@
 
 #include <stdlib.h>
 
+#include "node_index.h"
 #include "../contacts/contacts.h"
 #include "../../library/list/list.h"
 #include "../../library_from_ion/rbt/rbt.h"
@@ -56,6 +57,22 @@ typedef struct {
 	 * \brief 1 if has been performed the search of the local node's neighbors.
 	 */
 	int neighbors_list_built;
+	/**
+	 * \brief The neighbors of the local node indexed by node index (NULL if not a neighbor).
+	 */
+	Neighbor **byIndex;
+	/**
+	 * \brief The length of byIndex.
+	 */
+	uint32_t byIndexCapacity;
+	/**
+	 * \brief The destination whose neighbors have destinationMark equal to mark, NULL if none.
+	 */
+	Node *markedDestination;
+	/**
+	 * \brief Increased each time a destination is marked.
+	 */
+	uint64_t mark;
 } NeighborSAP;
 
 struct NodeSAP {
@@ -69,6 +86,7 @@ static void erase_node(Node*);
 static void erase_rtg_object(RtgObject *rtgObj);
 static void free_neighbor(void*);
 static void remove_citation(void*);
+static void clear_neighbors_index(NeighborSAP*);
 
 
 /******************************************************************************
@@ -98,6 +116,37 @@ static NeighborSAP *NeighborSAP_get(NodeSAP *nodeSap) {
 	return &nodeSap->neighborSap;
 }
 
+/******************************************************************************
+ *
+ * \par Function Name:
+ *      clear_neighbors_index
+ *
+ * \brief Forget all the neighbors indexed by node index
+ *
+ *
+ * \par Date Written:
+ *      18/10/26
+ *
+ * \return void
+ *
+ * \param[in] *neighborSap     The NeighborSAP
+ *
+ * \par Notes:
+ *             1.  Call it before the neighbors are removed from the local node's neighbors list.
+ *
+ * \par Revision History:
+ *
+ *  DD/MM/YY |  AUTHOR         |   DESCRIPTION
+ *  -------- | --------------- | -----------------------------------------------
+ *  18/10/26 | agent           |  Initial Implementation and documentation.
+ *****************************************************************************/
+static void clear_neighbors_index(NeighborSAP *neighborSap) {
+	if (neighborSap->byIndex != NULL) {
+		memset(neighborSap->byIndex, 0, sizeof(Neighbor*) * neighborSap->byIndexCapacity);
+	}
+	neighborSap->markedDestination = NULL;
+}
+
 /******************************************************************************
  *
  * \par Function Name:
@@ -325,6 +374,7 @@ int NodeSAP_open(UniboCGRSAP* uniboCgrSap)
         NodeSAP_close(uniboCgrSap);
         return -2;
     }
+    rbt_set_node_pool(sap->nodes, UniboCGRSAP_get_rbt_node_pool(uniboCgrSap));
 
     return 0;
 }
@@ -413,6 +463,46 @@ void discardAllRoutesFromNodesTree(UniboCGRSAP* uniboCgrSap)
 	}
 }
 
+/******************************************************************************
+ *
+ * \par Function Name:
+ *      reset_rtg_object
+ *
+ * \brief  Bring the RtgObject of a destination back to its state before any routing call
+ *
+ *
+ * \par Date Written:
+ *      18/10/26
+ *
+ * \return void
+ *
+ * \param[in]  *rtgObj   The RtgObject of the destination
+ *
+ * \par Notes:
+ *             1.  Both the Yen's lists are cleared: the known routes and the spurs
+ *                 bookkeeping were derived from the selected routes.
+ *             2.  The citations to the neighbors are removed, the next call
+ *                 discovers them again.
+ *             3.  The routes are deleted with delete_cgr_route, the citations in the
+ *                 contacts graph are removed too.
+ *
+ * \par Revision History:
+ *
+ *  DD/MM/YY |  AUTHOR         |   DESCRIPTION
+ *  -------- | --------------- | -----------------------------------------------
+ *  18/10/26 | agent           |  Initial Implementation and documentation.
+ *****************************************************************************/
+void reset_rtg_object(RtgObject *rtgObj)
+{
+	if (rtgObj != NULL)
+	{
+		clear_routes_list(rtgObj->knownRoutes);
+		clear_routes_list(rtgObj->selectedRoutes);
+		free_list_elts(rtgObj->citations);
+		CLEAR_FLAGS(rtgObj->flags);
+	}
+}
+
 /******************************************************************************
  *
  * \par Function Name:
@@ -440,6 +530,7 @@ void reset_NodesTree(UniboCGRSAP* uniboCgrSap)
 {
     NodeSAP* nodeSap = UniboCGRSAP_get_NodeSAP(uniboCgrSap);
     NeighborSAP* neighborSap = NeighborSAP_get(nodeSap);
+	clear_neighbors_index(neighborSap);
 	free_list_elts(neighborSap->local_node_neighbors);
 	rbt_clear(nodeSap->nodes);
 	neighborSap->neighbors_list_built = 0;
@@ -477,6 +568,10 @@ void NodeSAP_close(UniboCGRSAP* uniboCgrSap)
     NodeSAP* nodeSap = UniboCGRSAP_get_NodeSAP(uniboCgrSap);
 	NeighborSAP *neighborSap = NeighborSAP_get(nodeSap);
 	free_list(neighborSap->local_node_neighbors);
+	if (neighborSap->byIndex != NULL)
+	{
+		MDEPOSIT(neighborSap->byIndex);
+	}
 	rbt_destroy(nodeSap->nodes);
 
     memset(nodeSap, 0, sizeof(NodeSAP));
@@ -668,6 +763,7 @@ void remove_node_from_graph(UniboCGRSAP* uniboCgrSap, uint64_t nodeNbr)
 
 	node.nodeNbr = nodeNbr;
 	node.routingObject = NULL;
+	NeighborSAP_get(nodeSap)->markedDestination = NULL;
 	rbt_delete(nodeSap->nodes, &node);
 }
 
@@ -767,6 +863,94 @@ Node* get_node(UniboCGRSAP* uniboCgrSap, uint64_t nodeNbr)
 	return result;
 }
 
+/******************************************************************************
+ *
+ * \par Function Name:
+ *      get_first_node
+ *
+ * \brief  Get the first node of the nodes tree (lowest ipn node number)
+ *
+ *
+ * \par Date Written:
+ *      18/10/26
+ *
+ * \return Node*
+ *
+ * \retval Node*  The first node
+ * \retval NULL   The nodes tree is empty
+ *
+ * \param[out]  **node   If this argument isn't NULL, at the end it will
+ *                       contains the RbtNode that points to the node returned by the function
+ *
+ * \par Revision History:
+ *
+ *  DD/MM/YY  AUTHOR            DESCRIPTION
+ *  --------  ---------------  -----------------------------------------------
+ *  18/10/26  agent             Initial Implementation and documentation.
+ *****************************************************************************/
+Node* get_first_node(UniboCGRSAP* uniboCgrSap, RbtNode **node)
+{
+	Node *result = NULL;
+	RbtNode *currentNode;
+	NodeSAP* nodeSap = UniboCGRSAP_get_NodeSAP(uniboCgrSap);
+
+	currentNode = rbt_first(nodeSap->nodes);
+	if (currentNode != NULL)
+	{
+		result = (Node*) currentNode->data;
+	}
+	if (node != NULL)
+	{
+		*node = currentNode;
+	}
+
+	return result;
+}
+
+/******************************************************************************
+ *
+ * \par Function Name:
+ *      get_next_node
+ *
+ * \brief  Get the next node referring to the current node pointed by the argument "node"
+ *
+ *
+ * \par Date Written:
+ *      18/10/26
+ *
+ * \return Node*
+ *
+ * \retval Node*  The node found
+ * \retval NULL   There isn't the next node
+ *
+ * \param[in,out]  **node  The RbtNode of the current node, at the end it will
+ *                         contains the RbtNode that points to the node returned by the function
+ *
+ * \par Revision History:
+ *
+ *  DD/MM/YY  AUTHOR            DESCRIPTION
+ *  --------  ---------------  -----------------------------------------------
+ *  18/10/26  agent             Initial Implementation and documentation.
+ *****************************************************************************/
+Node* get_next_node(RbtNode **node)
+{
+	Node *result = NULL;
+	RbtNode *temp = NULL;
+
+	if (node != NULL)
+	{
+		temp = rbt_next(*node);
+		if (temp != NULL)
+		{
+			result = (Node*) temp->data;
+		}
+
+		*node = temp;
+	}
+
+	return result;
+}
+
 /******************************************************************************
  *
  * \par Function Name:
@@ -829,6 +1013,7 @@ static void remove_citation(void *data)
  * \retval NULL       MWITHDRAW or arguments error
  *
  * \param[in]  node_number  The neighbor's ipn number
+ * \param[in]  index        The neighbor's node index
  * \param[in]  to_time      The time when expires the last contact from the local node
  *                          to this neighbor
  *
@@ -837,8 +1022,9 @@ static void remove_citation(void *data)
  *  DD/MM/YY  AUTHOR            DESCRIPTION
  *  --------  ---------------  -----------------------------------------------
  *  28/04/20  L. Persampieri    Initial Implementation and documentation.
+ *  18/10/26  agent             Node index.
  *****************************************************************************/
-static Neighbor* create_neighbor(uint64_t node_number, time_t to_time)
+static Neighbor* create_neighbor(uint64_t node_number, uint32_t index, time_t to_time)
 {
 	Neighbor *result = NULL;
 
@@ -849,6 +1035,8 @@ static Neighbor* create_neighbor(uint64_t node_number, time_t to_time)
 		if(result != NULL)
 		{
 			result->ipn_number = node_number;
+			result->index = index;
+			result->destinationMark = 0;
 			result->toTime = to_time;
 			CLEAR_FLAGS(result->flags);
 			result->citations = list_create(result, NULL, NULL, remove_citation);
@@ -924,31 +1112,49 @@ static void free_neighbor(void *data)
  *  DD/MM/YY  AUTHOR            DESCRIPTION
  *  --------  ---------------  -----------------------------------------------
  *  28/04/20  L. Persampieri    Initial Implementation and documentation.
+ *  18/10/26  agent             Lookup by node index instead of a list scan.
  *****************************************************************************/
 Neighbor * get_neighbor(UniboCGRSAP* uniboCgrSap, uint64_t node_number)
 {
-	ListElt *elt;
-	Neighbor *result = NULL;
-	Neighbor *current;
+	return get_neighbor_by_index(uniboCgrSap, get_node_index(uniboCgrSap, node_number));
+}
+
+/******************************************************************************
+ *
+ * \par Function Name:
+ *      get_neighbor_by_index
+ *
+ * \brief  Get the local node's Neighbor with this node index
+ *
+ *
+ * \par Date Written:
+ *      18/10/26
+ *
+ * \return Neighbor*
+ *
+ * \retval  Neighbor*  The Neighbor found
+ * \retval  NULL       Neighbor not found
+ *
+ *
+ * \param[in]  index   The node index of the neighbor
+ *
+ * \par Revision History:
+ *
+ *  DD/MM/YY  AUTHOR            DESCRIPTION
+ *  --------  ---------------  -----------------------------------------------
+ *  18/10/26  agent             Initial Implementation and documentation.
+ *****************************************************************************/
+Neighbor * get_neighbor_by_index(UniboCGRSAP* uniboCgrSap, uint32_t index)
+{
     NodeSAP* nodeSap = UniboCGRSAP_get_NodeSAP(uniboCgrSap);
 	NeighborSAP *neighborSap = NeighborSAP_get(nodeSap);
 
-	if(neighborSap->local_node_neighbors!= NULL)
+	if(index >= neighborSap->byIndexCapacity)
 	{
-		for(elt = neighborSap->local_node_neighbors->first; elt != NULL && result == NULL; elt = elt->next)
-		{
-			if(elt->data != NULL)
-			{
-				current = (Neighbor *) elt->data;
-				if(current->ipn_number == node_number)
-				{
-					result = current;
-				}
-			}
-		}
+		return NULL;
 	}
 
-	return result;
+	return neighborSap->byIndex[index];
 }
 
 /******************************************************************************
@@ -1049,53 +1255,64 @@ static int insert_citation_to_neighbor(UniboCGRSAP* uniboCgrSap, RtgObject *rtgO
  * \param[in]  destination    The destination node
  * \param[in]         node    The node to search into the neighbors list
  *
+ * \par Notes:
+ *          1.  The neighbors of the last destination asked are marked (Neighbor's destinationMark),
+ *              the following calls for the same destination look at the mark only.
+ *              The mark is dropped each time a destination's neighbors list, a neighbor or a node is removed.
+ *
  * \par Revision History:
  *
  *  DD/MM/YY  AUTHOR            DESCRIPTION
  *  --------  ---------------  -----------------------------------------------
  *  28/04/20  L. Persampieri    Initial Implementation and documentation.
+ *  18/10/26  agent             Mark the destination's neighbors once instead of a list scan per call.
  *****************************************************************************/
 int is_node_in_destination_neighbors_list(UniboCGRSAP* uniboCgrSap, Node *destination, uint64_t node)
 {
-	int result = 0;
 	ListElt *elt, *current;
 	Neighbor *neighbor;
-	List neighbors;
 	RtgObject *rtgObj;
+    NodeSAP* nodeSap = UniboCGRSAP_get_NodeSAP(uniboCgrSap);
+	NeighborSAP *neighborSap = NeighborSAP_get(nodeSap);
 
-	if(destination != NULL && destination->routingObject != NULL &&
-			destination->routingObject->citations != NULL)
+	if(destination == NULL || destination->routingObject == NULL ||
+			destination->routingObject->citations == NULL)
 	{
-		rtgObj = destination->routingObject;
-		neighbors = destination->routingObject->citations;
+		return 0;
+	}
 
-		if(NEIGHBORS_DISCOVERED(rtgObj))
+	// the destination's neighbors are always local node's neighbors
+	neighbor = get_neighbor(uniboCgrSap, node);
+	if(neighbor == NULL)
+	{
+		return 0;
+	}
+
+	rtgObj = destination->routingObject;
+	if(!NEIGHBORS_DISCOVERED(rtgObj))
+	{
+		return 1;
+	}
+
+	if(neighborSap->markedDestination != destination)
+	{
+		neighborSap->mark++;
+		for(elt = rtgObj->citations->first; elt != NULL; elt = elt->next)
 		{
-			for(elt = neighbors->first; elt != NULL && result == 0; elt = elt->next)
+			if(elt->data != NULL)
 			{
-				if(elt->data != NULL)
-				{
-					current = (ListElt *) elt->data;
-
-					if(current->list != NULL && current->list->userData != NULL)
-					{
-						neighbor = (Neighbor *) current->list->userData;
+				current = (ListElt *) elt->data;
 
-						if(neighbor->ipn_number == node)
-						{
-							result = 1;
-						}
-					}
+				if(current->list != NULL && current->list->userData != NULL)
+				{
+					((Neighbor *) current->list->userData)->destinationMark = neighborSap->mark;
 				}
 			}
 		}
-		else if(get_neighbor(uniboCgrSap, node) != NULL)
-		{
-			result = 1;
-		}
+		neighborSap->markedDestination = destination;
 	}
 
-	return result;
+	return (neighbor->destinationMark == neighborSap->mark) ? 1 : 0;
 }
 
 /******************************************************************************
@@ -1163,6 +1380,7 @@ int insert_neighbors_to_reach_destination(UniboCGRSAP* uniboCgrSap, List neighbo
 		{
 			debug_printf("Discovered new total neighbors number (%lu) to reach destination %" PRIu64 ". Previous total number (%lu)", neighbors->length, destination->nodeNbr, rtgObj->citations->length);
 			free_list_elts(rtgObj->citations); //remove previous citations
+			neighborSap->markedDestination = NULL;
 			result = 0;
 			for(elt = neighbors->first; elt != NULL && !stop; elt = elt->next)
 			{
@@ -1227,11 +1445,13 @@ int insert_neighbors_to_reach_destination(UniboCGRSAP* uniboCgrSap, List neighbo
  *  DD/MM/YY  AUTHOR            DESCRIPTION
  *  --------  ---------------  -----------------------------------------------
  *  28/04/20  L. Persampieri    Initial Implementation and documentation.
+ *  18/10/26  agent             Index the neighbor by node index.
  *****************************************************************************/
 static int add_neighbor(UniboCGRSAP* uniboCgrSap, uint64_t node_number, time_t to_time)
 {
 	int result = -1;
 	Neighbor *neighbor;
+	uint32_t index;
     NodeSAP* nodeSap = UniboCGRSAP_get_NodeSAP(uniboCgrSap);
 	NeighborSAP *neighborSap = NeighborSAP_get(nodeSap);
 
@@ -1240,6 +1460,15 @@ static int add_neighbor(UniboCGRSAP* uniboCgrSap, uint64_t node_number, time_t t
 		return -3;
 	}
 
+	index = intern_node(uniboCgrSap, node_number);
+	if(index == NO_NODE_INDEX
+			|| grow_node_indexed_array((void**) &(neighborSap->byIndex), &(neighborSap->byIndexCapacity),
+					sizeof(Neighbor*), index + 1) < 0)
+	{
+		verbose_debug_printf("MWITHDRAW error");
+		return -2;
+	}
+
 	neighbor = get_neighbor(uniboCgrSap, node_number);
 	if (neighbor != NULL) {
 	    if (neighbor->toTime < to_time) {
@@ -1251,12 +1480,13 @@ static int add_neighbor(UniboCGRSAP* uniboCgrSap, uint64_t node_number, time_t t
 	else
 	{
 		//if neighbor not found
-		neighbor = create_neighbor(node_number, to_time);
+		neighbor = create_neighbor(node_number, index, to_time);
 		if(neighbor != NULL)
 		{
 			if(list_insert_last(neighborSap->local_node_neighbors, neighbor) != NULL)
 			{
 				result = 0;
+				neighborSap->byIndex[index] = neighbor;
 				if(to_time < neighborSap->timeNeighborToRemove)
 				{
 					neighborSap->timeNeighborToRemove = to_time;
@@ -1374,6 +1604,7 @@ void reset_neighbors_temporary_fields(UniboCGRSAP* uniboCgrSap)
  *  DD/MM/YY  AUTHOR            DESCRIPTION
  *  --------  ---------------  -----------------------------------------------
  *  28/04/20  L. Persampieri    Initial Implementation and documentation.
+ *  18/10/26  agent             Keep the neighbors index in sync.
  *****************************************************************************/
 void removeOldNeighbors(UniboCGRSAP* uniboCgrSap)
 {
@@ -1394,6 +1625,8 @@ void removeOldNeighbors(UniboCGRSAP* uniboCgrSap)
 			if(current->toTime <= current_time)
 			{
 				debug_printf("Deleted neighbor %" PRIu64 "...", current->ipn_number);
+				sap->byIndex[current->index] = NULL;
+				sap->markedDestination = NULL;
 				list_remove_elt(elt); //remove the citations to destination node
 			}
 			else if(current->toTime < sap->timeNeighborToRemove)
@@ -1431,6 +1664,7 @@ void removeOldNeighbors(UniboCGRSAP* uniboCgrSap)
  *  DD/MM/YY  AUTHOR            DESCRIPTION
  *  --------  ---------------  -----------------------------------------------
  *  28/04/20  L. Persampieri    Initial Implementation and documentation.
+ *  18/10/26  agent             Keep the neighbors index in sync.
  *****************************************************************************/
 int build_local_node_neighbors_list(UniboCGRSAP* uniboCgrSap)
 {
@@ -1446,6 +1680,7 @@ int build_local_node_neighbors_list(UniboCGRSAP* uniboCgrSap)
 		debug_printf("Building local node's neighbors list...");
 
 		neighborSap->neighbors_list_built = 1;
+		clear_neighbors_index(neighborSap);
 		free_list(neighborSap->local_node_neighbors);
 		neighborSap->local_node_neighbors = list_create(NULL, NULL, NULL, free_neighbor);
 		if(neighborSap->local_node_neighbors != NULL)
@@ -1505,3 +1740,35 @@ int build_local_node_neighbors_list(UniboCGRSAP* uniboCgrSap)
 
 	return result;
 }
+
+/******************************************************************************
+ *
+ * \par Function Name:
+ *      invalidate_local_node_neighbors_list
+ *
+ * \brief  Force the rebuild of the local node's neighbors list
+ *
+ *
+ * \par Date Written:
+ *      18/10/26
+ *
+ * \return void
+ *
+ * \par Notes:
+ *             1.  The list is rebuilt by the next build_local_node_neighbors_list call.
+ *             2.  The routes are not touched.
+ *
+ * \par Revision History:
+ *
+ *  DD/MM/YY  AUTHOR            DESCRIPTION
+ *  --------  ---------------  -----------------------------------------------
+ *  18/10/26  agent             Initial Implementation and documentation.
+ *****************************************************************************/
+void invalidate_local_node_neighbors_list(UniboCGRSAP* uniboCgrSap)
+{
+    NodeSAP* nodeSap = UniboCGRSAP_get_NodeSAP(uniboCgrSap);
+	NeighborSAP *neighborSap = NeighborSAP_get(nodeSap);
+
+	neighborSap->neighbors_list_built = 0;
+	neighborSap->timeNeighborToRemove = MAX_POSIX_TIME;
+}
@@ -35,6 +35,7 @@
 #include "../../UniboCGRSAP.h"
 #include "../../library/commonDefines.h"
 #include "../../library/list/list_type.h"
+#include "../../library_from_ion/rbt/rbt_type.h"
 
 #ifdef __cplusplus
 extern "C"
@@ -116,6 +117,15 @@ typedef struct
 	 * \brief The ipn number of the local node's neighbor
 	 */
 	uint64_t ipn_number;
+	/**
+	 * \brief The node index of the neighbor (see node_index.h)
+	 */
+	uint32_t index;
+	/**
+	 * \brief Equal to the destination mark of the NeighborSAP if the neighbor
+	 *        is in the neighbors list of the marked destination (see is_node_in_destination_neighbors_list())
+	 */
+	uint64_t destinationMark;
 	/**
 	 * \brief The time when the last contact to this neighbor expires
 	 */
@@ -159,6 +169,7 @@ extern void reset_NodesTree(UniboCGRSAP* uniboCgrSap);
 
 
 extern void discardAllRoutesFromNodesTree(UniboCGRSAP* uniboCgrSap);
+extern void reset_rtg_object(RtgObject *rtgObj);
 
 extern int add_node_to_graph(UniboCGRSAP* uniboCgrSap, uint64_t nodeNbrToAdd);
 extern Node* add_node(UniboCGRSAP* uniboCgrSap, uint64_t nodeNbr);
@@ -166,13 +177,17 @@ extern Node* add_node(UniboCGRSAP* uniboCgrSap, uint64_t nodeNbr);
 extern void remove_node_from_graph(UniboCGRSAP* uniboCgrSap, uint64_t nodeNbrToRemove);
 
 extern Node* get_node(UniboCGRSAP* uniboCgrSap, uint64_t nodeNbr);
+extern Node* get_first_node(UniboCGRSAP* uniboCgrSap, RbtNode **node);
+extern Node* get_next_node(RbtNode **node);
 
 extern Neighbor * get_neighbor(UniboCGRSAP* uniboCgrSap, uint64_t node_number);
+extern Neighbor * get_neighbor_by_index(UniboCGRSAP* uniboCgrSap, uint32_t index);
 extern uint64_t get_local_node_neighbors_count(UniboCGRSAP* uniboCgrSap);
 extern void reset_neighbors_temporary_fields(UniboCGRSAP* uniboCgrSap);
 extern int insert_neighbors_to_reach_destination(UniboCGRSAP* uniboCgrSap, List neighbors, Node *destination);
 extern void removeOldNeighbors(UniboCGRSAP* uniboCgrSap);
 extern int build_local_node_neighbors_list(UniboCGRSAP* uniboCgrSap);
+extern void invalidate_local_node_neighbors_list(UniboCGRSAP* uniboCgrSap);
 extern int is_node_in_destination_neighbors_list(UniboCGRSAP* uniboCgrSap, Node *destination, uint64_t node);
 
 #ifdef __cplusplus
@@ -33,10 +33,11 @@
 #include <stdlib.h>
 
 #include "../../library_from_ion/rbt/rbt.h"
+#include "../../library/heap/heap.h"
+#include "../contacts/contacts.h"
 
 static void erase_range(Range*);
-static Range* create_range(uint64_t fromNode, uint64_t toNode, time_t fromTime,
-		time_t toTime, uint64_t owlt);
+static void add_range_expiration(RangeSAP *sap, Range *range);
 
 /**
  * \brief This struct is used to keep in one place all the data used by
@@ -48,9 +49,17 @@ struct RangeSAP {
 	 */
 	Rbt *ranges;
 	/**
-	 * \brief The time when the next Range expires.
+	 * \brief The expiration times (toTime) of the ranges, lowest first.
+	 *
+	 * \details It can hold stale entries (ranges deleted or revised),
+	 *          discarded when they reach the top.
 	 */
-	time_t timeRangeToRemove;
+	Heap expirations;
+	/**
+	 * \brief Set to 1 if an expiration time could not be stored (MWITHDRAW error):
+	 *        the heap must be rebuilt from the ranges graph.
+	 */
+	int rebuildExpirations;
 };
 
 /******************************************************************************
@@ -158,6 +167,102 @@ static void erase_range(Range *range)
 	range->owlt = 0;
 }
 
+/******************************************************************************
+ *
+ * \par Function Name:
+ *      discard_routes_through_changed_ranges
+ *
+ * \brief  Compare a previous ranges graph with the current one and delete the routes
+ *         of the destinations reached through the node pairs whose ranges have been removed or changed.
+ *
+ *
+ * \par Date Written:
+ *      18/10/26
+ *
+ * \return int
+ *
+ * \retval   1  The current graph may enable new routes (ranges added or widened)
+ * \retval   0  Otherwise
+ *
+ * \param[in]	*previousSap   The previous ranges graph, no more set in the SAP
+ *
+ * \par Notes:
+ *              1. Both graphs are walked once, in key order.
+ *              2. The routes are searched in the current contacts graph: call this function
+ *                 after migrate_routes_to_contacts_graph().
+ *
+ * \par Revision History:
+ *
+ *  DD/MM/YY |  AUTHOR         |   DESCRIPTION
+ *  -------- | --------------- | -----------------------------------------------
+ *  18/10/26 | agent           |  Initial Implementation and documentation.
+ *****************************************************************************/
+int discard_routes_through_changed_ranges(UniboCGRSAP* uniboCgrSap, RangeSAP *previousSap)
+{
+	RangeSAP *sap = UniboCGRSAP_get_RangeSAP(uniboCgrSap);
+	RbtNode *oldNode = rbt_first(previousSap->ranges);
+	RbtNode *newNode = rbt_first(sap->ranges);
+	Range *oldRange, *newRange;
+	uint64_t lastFromNode = 0, lastToNode = 0;
+	int result = 0;
+	int cmp, changed;
+
+	while (oldNode != NULL || newNode != NULL)
+	{
+		oldRange = (oldNode != NULL) ? (Range*) oldNode->data : NULL;
+		newRange = (newNode != NULL) ? (Range*) newNode->data : NULL;
+		changed = 0;
+
+		if (oldRange == NULL)
+		{
+			cmp = 1;
+		}
+		else if (newRange == NULL)
+		{
+			cmp = -1;
+		}
+		else
+		{
+			cmp = compare_ranges(oldRange, newRange);
+		}
+
+		if (cmp < 0)
+		{
+			// removed
+			changed = 1;
+			oldNode = rbt_next(oldNode);
+		}
+		else if (cmp > 0)
+		{
+			// added
+			result = 1;
+			newNode = rbt_next(newNode);
+		}
+		else
+		{
+			if (newRange->toTime > oldRange->toTime || newRange->owlt < oldRange->owlt)
+			{
+				result = 1;
+			}
+			if (newRange->toTime != oldRange->toTime || newRange->owlt != oldRange->owlt)
+			{
+				changed = 1;
+			}
+			oldNode = rbt_next(oldNode);
+			newNode = rbt_next(newNode);
+		}
+
+		if (changed && (oldRange->fromNode != lastFromNode || oldRange->toNode != lastToNode))
+		{
+			discard_routes_through_node_pair(uniboCgrSap, oldRange->fromNode, oldRange->toNode);
+			lastFromNode = oldRange->fromNode;
+			lastToNode = oldRange->toNode;
+		}
+	}
+
+	return result;
+}
+
 /******************************************************************************
  *
  * \par Function Name:
@@ -221,8 +326,9 @@ void free_range(void *range)
  *  DD/MM/YY |  AUTHOR         |   DESCRIPTION
  *  -------- | --------------- | -----------------------------------------------
  *  19/01/20 | L. Persampieri  |  Initial Implementation and documentation.
+ *  18/10/26 | agent           |  Exported for add_ranges_to_graph_bulk callers.
  *****************************************************************************/
-static Range* create_range(uint64_t fromNode, uint64_t toNode, time_t fromTime,
+Range* create_range(uint64_t fromNode, uint64_t toNode, time_t fromTime,
 		time_t toTime, uint64_t owlt)
 {
 	Range *range = (Range*) MWITHDRAW(sizeof(Range));
@@ -262,6 +368,7 @@ static Range* create_range(uint64_t fromNode, uint64_t toNode, time_t fromTime,
  *  -------- | --------------- | -----------------------------------------------
  *  19/01/20 | L. Persampieri  |  Initial Implementation and documentation.
  *  21/10/22 | L. Persampieri  |  Renamed function.
+ *  18/10/26 | agent           |  Initialize the expiration heap.
  *****************************************************************************/
 int RangeSAP_open(UniboCGRSAP* uniboCgrSap)
 {
@@ -270,12 +377,13 @@ int RangeSAP_open(UniboCGRSAP* uniboCgrSap)
     if (!sap) return -2;
     UniboCGRSAP_set_RangeSAP(uniboCgrSap, sap);
     memset(sap, 0, sizeof(RangeSAP));
-    sap->timeRangeToRemove = MAX_POSIX_TIME;
+    heap_init(&sap->expirations);
     sap->ranges = rbt_create(free_range, compare_ranges);
 	if (!sap->ranges) {
         RangeSAP_close(uniboCgrSap);
         return -2;
     }
+    rbt_set_node_pool(sap->ranges, UniboCGRSAP_get_rbt_node_pool(uniboCgrSap));
 
 	return 0;
 }
@@ -284,16 +392,99 @@ void RangeSAP_decrease_time(UniboCGRSAP* uniboCgrSap, time_t diff) {
     Range *current;
     RbtNode *node;
     RangeSAP* rangeSap = UniboCGRSAP_get_RangeSAP(uniboCgrSap);
-    rangeSap->timeRangeToRemove = MAX_POSIX_TIME;
     for (current = get_first_range(uniboCgrSap, &node); current != NULL; current = get_next_range(&node))
     {
         current->fromTime -= diff;
         current->toTime -= diff;
-
-        if (current->toTime < rangeSap->timeRangeToRemove) {
-            rangeSap->timeRangeToRemove = current->toTime;
-        }
     }
+    heap_shift_times(&rangeSap->expirations, diff);
+}
+
+/******************************************************************************
+ *
+ * \par Function Name:
+ *      rebuild_range_expirations
+ *
+ * \brief  Fill the expiration heap with the toTime of every range in the graph.
+ *
+ * \par Date Written:
+ *      18/10/26
+ *
+ * \return int
+ *
+ * \retval   0   Success case
+ * \retval  -2   MWITHDRAW error
+ *
+ * \par Revision History:
+ *
+ *  DD/MM/YY |  AUTHOR         |   DESCRIPTION
+ *  -------- | --------------- | -----------------------------------------------
+ *  18/10/26 | agent           |  Initial Implementation and documentation.
+ *****************************************************************************/
+static int rebuild_range_expirations(RangeSAP *sap)
+{
+	RbtNode *node;
+	Range *range;
+
+	heap_clear(&sap->expirations);
+	if (heap_reserve(&sap->expirations, (uint32_t) sap->ranges->length) < 0)
+	{
+		sap->rebuildExpirations = 1;
+		return -2;
+	}
+
+	for (node = rbt_first(sap->ranges); node != NULL; node = rbt_next(node))
+	{
+		range = (Range*) node->data;
+		if (range != NULL)
+		{
+			// capacity already reserved, cannot fail
+			heap_push(&sap->expirations, range->toTime, range->fromNode, range->toNode, range->fromTime);
+		}
+	}
+
+	sap->rebuildExpirations = 0;
+	return 0;
+}
+
+/******************************************************************************
+ *
+ * \par Function Name:
+ *      add_range_expiration
+ *
+ * \brief  Insert the expiration time of a range (already in the graph) in the expiration heap.
+ *
+ * \par Date Written:
+ *      18/10/26
+ *
+ * \return void
+ *
+ * \par Notes:
+ *              1. When the stale entries outnumber the ranges the heap is rebuilt.
+ *              2. In case of MWITHDRAW error the heap is marked to be rebuilt
+ *                 by the next removeExpiredRanges.
+ *
+ * \par Revision History:
+ *
+ *  DD/MM/YY |  AUTHOR         |   DESCRIPTION
+ *  -------- | --------------- | -----------------------------------------------
+ *  18/10/26 | agent           |  Initial Implementation and documentation.
+ *****************************************************************************/
+static void add_range_expiration(RangeSAP *sap, Range *range)
+{
+	if (sap->rebuildExpirations)
+	{
+		return; // the whole heap will be rebuilt anyway
+	}
+
+	if (sap->expirations.length >= 2 * sap->ranges->length + 64)
+	{
+		rebuild_range_expirations(sap);
+	}
+	else if (heap_push(&sap->expirations, range->toTime, range->fromNode, range->toNode, range->fromTime) < 0)
+	{
+		sap->rebuildExpirations = 1;
+	}
 }
 
 /******************************************************************************
@@ -311,18 +502,20 @@ void RangeSAP_decrease_time(UniboCGRSAP* uniboCgrSap, time_t diff) {
  * \return void
  *
  * \par Notes:
- *             1.  The timeRangeToRemove will be redefined.
+ *             1.  Only the ranges on top of the expiration heap are visited:
+ *                 O(expired * log(ranges)) instead of a scan of the ranges graph.
  *
  * \par Revision History:
  *
  *  DD/MM/YY |  AUTHOR         |   DESCRIPTION
  *  -------- | --------------- | -----------------------------------------------
  *  19/01/20 | L. Persampieri  |  Initial Implementation and documentation.
+ *  18/10/26 | agent           |  Pop the expired ranges from the expiration heap.
  *****************************************************************************/
 void removeExpiredRanges(UniboCGRSAP* uniboCgrSap)
 {
-	time_t min = MAX_POSIX_TIME;
 	Range *range;
+	HeapEntry *entry;
     const time_t time = UniboCGRSAP_get_current_time(uniboCgrSap);
 	RbtNode *node, *next;
 #if (DEBUG_CGR)
@@ -330,36 +523,47 @@ void removeExpiredRanges(UniboCGRSAP* uniboCgrSap)
 #endif
 	RangeSAP *sap = UniboCGRSAP_get_RangeSAP(uniboCgrSap);
 
-	if (time >= sap->timeRangeToRemove)
+	if (sap->rebuildExpirations && rebuild_range_expirations(sap) < 0)
 	{
-		debug_printf("Remove the expired ranges.");
-
+		// fallback: scan all the ranges graph
+		debug_printf("Remove the expired ranges (full scan).");
 		node = rbt_first(sap->ranges);
 		while (node != NULL)
 		{
 			next = rbt_next(node);
-			if (node->data != NULL)
+			range = (Range*) node->data;
+			if (range != NULL && range->toTime <= time)
 			{
-				range = (Range*) node->data;
+				rbt_delete(sap->ranges, range);
+			}
+			node = next;
+		}
+		return;
+	}
 
-				if (range->toTime <= time)
-				{
-					rbt_delete(sap->ranges, range);
+	entry = heap_top(&sap->expirations);
+	if (entry != NULL && entry->expirationTime <= time)
+	{
+		debug_printf("Remove the expired ranges.");
+		while (entry != NULL && entry->expirationTime <= time)
+		{
+			range = get_range(uniboCgrSap, entry->fromNode, entry->toNode, entry->fromTime, NULL);
+			heap_pop(&sap->expirations);
+
+			// otherwise stale entry: range already deleted or revised
+			if (range != NULL && range->toTime <= time)
+			{
+				rbt_delete(sap->ranges, range);
 #if (DEBUG_CGR)
-					tot++;
+				tot++;
 #endif
-				}
-				else if (range->toTime < min)
-				{
-					min = range->toTime;
-				}
 			}
-			node = next;
+
+			entry = heap_top(&sap->expirations);
 		}
 
-		sap->timeRangeToRemove = min;
 		debug_printf("Removed %" PRIu32 " ranges, next remove ranges time: %ld", tot,
-				(long int ) sap->timeRangeToRemove);
+				(long int ) ((entry != NULL) ? entry->expirationTime : MAX_POSIX_TIME));
 	}
 
 }
@@ -400,6 +604,8 @@ int revise_range_start_time(UniboCGRSAP* uniboCgrSap, uint64_t fromNode, uint64_
     }
 
     range->fromTime = newFromTime;
+    // the key of the range changed
+    add_range_expiration(UniboCGRSAP_get_RangeSAP(uniboCgrSap), range);
     return 0;
 }
 /**
@@ -439,10 +645,7 @@ int revise_range_end_time(UniboCGRSAP* uniboCgrSap, uint64_t fromNode, uint64_t
     }
     range->toTime = newEndTime;
 
-    struct RangeSAP* rangeSap = UniboCGRSAP_get_RangeSAP(uniboCgrSap);
-    if (range->toTime < rangeSap->timeRangeToRemove) {
-        rangeSap->timeRangeToRemove = range->toTime;
-    }
+    add_range_expiration(UniboCGRSAP_get_RangeSAP(uniboCgrSap), range);
     return 0;
 }
 
@@ -520,15 +723,14 @@ int revise_owlt(UniboCGRSAP* uniboCgrSap, uint64_t fromNode, uint64_t toNode, ti
  * \param[in]	owlt        The distance from the sender node to the receiver node in light time
  *
  * \par Notes:
- *              1. This function will change timeRangeToRemove if the range->toTime of the
- *                 new range is less than the current timeRangeToRemove, in that case
- *                  timeRangeToRemove will be equals to range->toTime
+ *              1. The range->toTime of the new range is inserted in the expiration heap.
  *
  * \par Revision History:
  *
  *  DD/MM/YY |  AUTHOR         |   DESCRIPTION
  *  -------- | --------------- | -----------------------------------------------
  *  19/01/20 | L. Persampieri  |  Initial Implementation and documentation.
+ *  18/10/26 | agent           |  Insert the range in the expiration heap.
  *****************************************************************************/
 int add_range_to_graph(UniboCGRSAP* uniboCgrSap, uint64_t fromNode, uint64_t toNode, time_t fromTime,
                        time_t toTime, uint64_t owlt)
@@ -601,9 +803,9 @@ int add_range_to_graph(UniboCGRSAP* uniboCgrSap, uint64_t fromNode, uint64_t toN
 			{
 				free_range(range);
 			}
-			else if (sap->timeRangeToRemove > toTime)
+			else
 			{
-				sap->timeRangeToRemove = toTime;
+				add_range_expiration(sap, range);
 			}
 		}
 	}
@@ -611,6 +813,206 @@ int add_range_to_graph(UniboCGRSAP* uniboCgrSap, uint64_t fromNode, uint64_t toN
 	return result;
 }
 
+static int compare_range_pointers(const void *first, const void *second)
+{
+	return compare_ranges(*((Range**) first), *((Range**) second));
+}
+
+/******************************************************************************
+ *
+ * \par Function Name:
+ *      range_overlaps_graph
+ *
+ * \brief  Check if a range overlaps the ranges of the graph
+ *         between the same sender and receiver
+ *
+ *
+ * \par Date Written:
+ *      18/10/26
+ *
+ * \return int
+ *
+ * \retval   1   The range overlaps (or is equal to) a range of the graph
+ * \retval   0   The range doesn't overlap
+ *
+ * \param[in]	*sap     The RangeSAP
+ * \param[in]	*range   The range (not in the graph)
+ *
+ * \par Notes:
+ *             1. Only the previous and the next range (in the graph order) are checked:
+ *                the ranges between the same nodes don't overlap each other.
+ *
+ * \par Revision History:
+ *
+ *  DD/MM/YY |  AUTHOR         |   DESCRIPTION
+ *  -------- | --------------- | -----------------------------------------------
+ *  18/10/26 | agent           |  Initial Implementation and documentation.
+ *****************************************************************************/
+static int range_overlaps_graph(RangeSAP *sap, Range *range)
+{
+	RbtNode *successor = NULL, *predecessor;
+	Range *other;
+
+	if (rbt_search(sap->ranges, range, &successor) != NULL)
+	{
+		return 1;
+	}
+
+	predecessor = (successor != NULL) ? rbt_prev(successor) : rbt_last(sap->ranges);
+
+	if (successor != NULL && (other = (Range*) successor->data) != NULL
+			&& other->fromNode == range->fromNode && other->toNode == range->toNode
+			&& other->fromTime < range->toTime)
+	{
+		return 1;
+	}
+	if (predecessor != NULL && (other = (Range*) predecessor->data) != NULL
+			&& other->fromNode == range->fromNode && other->toNode == range->toNode
+			&& other->toTime > range->fromTime)
+	{
+		return 1;
+	}
+
+	return 0;
+}
+
+/******************************************************************************
+ *
+ * \par Function Name:
+ *      add_ranges_to_graph_bulk
+ *
+ * \brief  Add many ranges to the ranges graph at once
+ *
+ *
+ * \par Date Written:
+ *      18/10/26
+ *
+ * \return int
+ *
+ * \retval  ">= 0"   Success case: number of ranges added to the ranges graph
+ * \retval     -1    Overlapped ranges (nothing added)
+ * \retval     -2    MWITHDRAW error (nothing added)
+ *
+ * \param[in]	**ranges   The ranges, allocated by create_range(). The array will be sorted.
+ * \param[in]	count      The number of ranges
+ *
+ * \par Notes:
+ *             1. The ranges are always consumed: in case of error they are released.
+ *             2. Same strategy of add_contacts_to_graph_bulk().
+ *
+ * \par Revision History:
+ *
+ *  DD/MM/YY |  AUTHOR         |   DESCRIPTION
+ *  -------- | --------------- | -----------------------------------------------
+ *  18/10/26 | agent           |  Initial Implementation and documentation.
+ *  18/10/26 | agent           |  Skip the sort for presorted ranges (binary contact plan).
+ *****************************************************************************/
+int add_ranges_to_graph_bulk(UniboCGRSAP* uniboCgrSap, Range **ranges, uint32_t count)
+{
+	RangeSAP *sap = UniboCGRSAP_get_RangeSAP(uniboCgrSap);
+	unsigned long graphLength = (sap->ranges->root != NULL) ? sap->ranges->length : 0;
+	unsigned long total, i, j, k;
+	void **merged;
+	RbtNode *node;
+	Range *prev, *current;
+	int result = 0;
+
+	// already sorted when they come from a binary contact plan
+	for (i = 1; i < count && compare_ranges(ranges[i - 1], ranges[i]) < 0; i++);
+	if (i < count)
+	{
+		qsort(ranges, count, sizeof(Range*), compare_range_pointers);
+	}
+
+	for (i = 0; i < count && result == 0; i++)
+	{
+		current = ranges[i];
+		if (i > 0)
+		{
+			prev = ranges[i - 1];
+			if (prev->fromNode == current->fromNode && prev->toNode == current->toNode
+					&& (prev->fromTime == current->fromTime || prev->toTime > current->fromTime))
+			{
+				result = -1;
+			}
+		}
+		if (result == 0 && graphLength > 0 && range_overlaps_graph(sap, current))
+		{
+			result = -1;
+		}
+	}
+
+	if (result == 0 && (graphLength == 0 || count >= graphLength / 8))
+	{
+		// bottom-up rebuild: merge the ranges graph with the new (sorted) ranges
+		total = graphLength + count;
+		merged = (void**) MWITHDRAW(sizeof(void*) * (total > 0 ? total : 1));
+		if (merged == NULL)
+		{
+			result = -2;
+		}
+		else
+		{
+			node = rbt_first(sap->ranges);
+			j = 0;
+			for (k = 0; k < total; k++)
+			{
+				if (node != NULL && (j >= count || compare_ranges(node->data, ranges[j]) < 0))
+				{
+					merged[k] = node->data;
+					node = rbt_next(node);
+				}
+				else
+				{
+					merged[k] = ranges[j++];
+				}
+			}
+
+			result = rbt_rebuild_from_sorted(sap->ranges, merged, total);
+			MDEPOSIT(merged);
+
+			if (result == 0)
+			{
+				rebuild_range_expirations(sap);
+			}
+		}
+	}
+	else if (result == 0)
+	{
+		for (i = 0; i < count && result == 0; i++)
+		{
+			if (rbt_insert(sap->ranges, ranges[i]) == NULL)
+			{
+				// roll back (rbt_delete releases the range)
+				for (j = 0; j < i; j++)
+				{
+					rbt_delete(sap->ranges, ranges[j]);
+					ranges[j] = NULL;
+				}
+				result = -2;
+			}
+			else
+			{
+				add_range_expiration(sap, ranges[i]);
+			}
+		}
+	}
+
+	if (result < 0)
+	{
+		for (i = 0; i < count; i++)
+		{
+			if (ranges[i] != NULL)
+			{
+				free_range(ranges[i]);
+			}
+		}
+		return result;
+	}
+
+	return (int) count;
+}
+
 /******************************************************************************
  *
  * \par Function Name:
@@ -701,12 +1103,14 @@ void remove_range_from_graph(UniboCGRSAP* uniboCgrSap, time_t fromTime, uint64_t
  *  DD/MM/YY |  AUTHOR         |   DESCRIPTION
  *  -------- | --------------- | -----------------------------------------------
  *  19/01/20 | L. Persampieri  |  Initial Implementation and documentation.
+ *  18/10/26 | agent           |  Clear the expiration heap.
  *****************************************************************************/
 void reset_RangesGraph(UniboCGRSAP* uniboCgrSap)
 {
 	RangeSAP *sap = UniboCGRSAP_get_RangeSAP(uniboCgrSap);
 	rbt_clear(sap->ranges);
-	sap->timeRangeToRemove = MAX_POSIX_TIME;
+	heap_clear(&sap->expirations);
+	sap->rebuildExpirations = 0;
 }
 
 /******************************************************************************
@@ -729,6 +1133,7 @@ void reset_RangesGraph(UniboCGRSAP* uniboCgrSap)
  *  -------- | --------------- | -----------------------------------------------
  *  19/01/20 | L. Persampieri  |  Initial Implementation and documentation.
  *  21/10/22 | L. Persampieri  |  Renamed function
+ *  18/10/26 | agent           |  Destroy the expiration heap.
  *****************************************************************************/
 void RangeSAP_close(UniboCGRSAP* uniboCgrSap)
 {
@@ -736,6 +1141,7 @@ void RangeSAP_close(UniboCGRSAP* uniboCgrSap)
 
 	RangeSAP *sap = UniboCGRSAP_get_RangeSAP(uniboCgrSap);
 	rbt_destroy(sap->ranges);
+	heap_destroy(&sap->expirations);
 
     memset(sap, 0, sizeof(RangeSAP));
     MDEPOSIT(sap);
@@ -67,7 +67,9 @@ typedef struct
 } Range;
 
 extern int compare_ranges(void *first, void *second);
+extern Range* create_range(uint64_t fromNode, uint64_t toNode, time_t fromTime, time_t toTime, uint64_t owlt);
 extern void free_range(void*);
+extern int discard_routes_through_changed_ranges(UniboCGRSAP* uniboCgrSap, RangeSAP *previousSap);
 
 extern int RangeSAP_open(UniboCGRSAP* uniboCgrSap);
 extern void RangeSAP_close(UniboCGRSAP* uniboCgrSap);
@@ -78,6 +80,7 @@ extern void RangeSAP_decrease_time(UniboCGRSAP* uniboCgrSap, time_t diff);
 extern void removeExpiredRanges(UniboCGRSAP* uniboCgrSap);
 
 extern int add_range_to_graph(UniboCGRSAP* uniboCgrSap, uint64_t fromNode, uint64_t toNode, time_t fromTime, time_t toTime, uint64_t owlt);
+extern int add_ranges_to_graph_bulk(UniboCGRSAP* uniboCgrSap, Range **ranges, uint32_t count);
 extern void remove_range_from_graph(UniboCGRSAP* uniboCgrSap, time_t fromTime, uint64_t fromNode, uint64_t toNode);
 extern void remove_range_elt_from_graph(UniboCGRSAP* uniboCgrSap, Range *range);
 
@@ -0,0 +1,698 @@
+/** \file reservations.c
+ *
+ *  \brief  This file provides the implementation of the functions
+ *          to manage the ledger of the volumes reserved on the contacts by the routing calls.
+ *
+ *  \details Each routing call that chooses some best routes decreases the MTV of the contacts
+ *           of those routes (phase three). If the volume reservations are enabled the decreased
+ *           volumes are also recorded here, in a reservation identified by a handle.
+ *           Then the interface commits the reservation when the bundle is transmitted
+ *           (the volume remains consumed) or releases it when the forwarding is canceled
+ *           (the volume goes back to the contacts).
+ *
+ *
+ ** \copyright Copyright (c) 2020, Alma Mater Studiorum, University of Bologna, All rights reserved.
+ **
+ ** \par License
+ **
+ **    This file is part of Unibo-CGR.                                            <br>
+ **                                                                               <br>
+ **    Unibo-CGR is free software: you can redistribute it and/or modify
+ **    it under the terms of the GNU General Public License as published by
+ **    the Free Software Foundation, either version 3 of the License, or
+ **    (at your option) any later version.                                        <br>
+ **    Unibo-CGR is distributed in the hope that it will be useful,
+ **    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ **    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ **    GNU General Public License for more details.                               <br>
+ **                                                                               <br>
+ **    You should have received a copy of the GNU General Public License
+ **    along with Unibo-CGR.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  \author agent, agent@local
+ *
+ *  \par Supervisor
+ *       Carlo Caini, carlo.caini@unibo.it
+ */
+
+#include "reservations.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "../../library/list/list.h"
+#include "../../library_from_ion/rbt/rbt.h"
+
+/**
+ * \brief The volume reserved on a contact.
+ *
+ * \details The contact is identified by {fromNode, toNode, fromTime} and not by its address,
+ *          so a reservation can outlive the contact (e.g. expired or removed).
+ */
+typedef struct
+{
+	/**
+	 * \brief Sender node of the contact (ipn node number)
+	 */
+	uint64_t fromNode;
+	/**
+	 * \brief Receiver node of the contact (ipn node number)
+	 */
+	uint64_t toNode;
+	/**
+	 * \brief Start time of the contact
+	 */
+	time_t fromTime;
+	/**
+	 * \brief The volume (bytes) subtracted from the contact's MTV
+	 */
+	int64_t volume;
+	/**
+	 * \brief The volume has been subtracted from mtv[0] ... mtv[priority]
+	 */
+	int priority;
+} ReservedVolume;
+
+/**
+ * \brief All the volumes reserved by a routing call.
+ */
+typedef struct
+{
+	/**
+	 * \brief The handle of the reservation (never 0)
+	 */
+	uint64_t id;
+	/**
+	 * \brief List of ReservedVolume
+	 */
+	List volumes;
+} Reservation;
+
+/**
+ * \brief This struct is used to keep in one place all the data used by
+ *        the reservations ledger.
+ */
+struct ReservationSAP
+{
+	/**
+	 * \brief The reservations not yet committed or released, ordered by id.
+	 */
+	Rbt *reservations;
+	/**
+	 * \brief The reservation filled by the current routing call.
+	 *        NULL outside of the routing calls or if the volume reservations are disabled.
+	 */
+	Reservation *current;
+	/**
+	 * \brief The handle of the next reservation.
+	 */
+	uint64_t nextId;
+	/**
+	 * \brief The handle of the reservation of the last routing call (0 if nothing has been reserved).
+	 */
+	uint64_t lastReservation;
+};
+
+/******************************************************************************
+ *
+ * \par Function Name:
+ *      compare_reservations
+ *
+ * \brief Compare two reservations by id
+ *
+ *
+ * \par Date Written:
+ *      18/10/26
+ *
+ * \return int
+ *
+ * \retval   0  The reservations are equals
+ * \retval  -1  The first reservation is less than the second reservation
+ * \retval   1  The first reservation is greater than the second reservation
+ *
+ * \param[in]	*first   The first reservation
+ * \param[in]	*second  The second reservation
+ *
+ * \par Revision History:
+ *
+ *  DD/MM/YY |  AUTHOR         |   DESCRIPTION
+ *  -------- | --------------- | -----------------------------------------------
+ *  18/10/26 | agent           |  Initial Implementation and documentation.
+ *****************************************************************************/
+static int compare_reservations(void *first, void *second)
+{
+	Reservation *a, *b;
+	int result = 0;
+
+	if (first != second && first != NULL && second != NULL)
+	{
+		a = (Reservation*) first;
+		b = (Reservation*) second;
+
+		if (a->id < b->id)
+		{
+			result = -1;
+		}
+		else if (a->id > b->id)
+		{
+			result = 1;
+		}
+	}
+
+	return result;
+}
+
+/******************************************************************************
+ *
+ * \par Function Name:
+ *      free_reservation
+ *
+ * \brief  Deallocate memory for a Reservation type
+ *
+ *
+ * \par Date Written:
+ *      18/10/26
+ *
+ * \return void
+ *
+ * \param[in]  *reservation  The Reservation that we want to deallocate
+ *
+ * \par Revision History:
+ *
+ *  DD/MM/YY | AUTHOR          |  DESCRIPTION
+ *  -------- | --------------- | -----------------------------------------------
+ *  18/10/26 | agent           |  Initial Implementation and documentation.
+ *****************************************************************************/
+static void free_reservation(void *reservation)
+{
+	Reservation *temp;
+
+	if (reservation != NULL)
+	{
+		temp = (Reservation*) reservation;
+		free_list(temp->volumes);
+		memset(temp, 0, sizeof(Reservation));
+		MDEPOSIT(temp);
+	}
+}
+
+/******************************************************************************
+ *
+ * \par Function Name:
+ *      create_reservation
+ *
+ * \brief  Allocate memory for a Reservation type
+ *
+ *
+ * \par Date Written:
+ *      18/10/26
+ *
+ * \return Reservation*
+ *
+ * \retval Reservation*  The new allocated Reservation
+ * \retval NULL          MWITHDRAW error
+ *
+ * \par Revision History:
+ *
+ *  DD/MM/YY |  AUTHOR         |   DESCRIPTION
+ *  -------- | --------------- | -----------------------------------------------
+ *  18/10/26 | agent           |  Initial Implementation and documentation.
+ *****************************************************************************/
+static Reservation* create_reservation()
+{
+	Reservation *reservation = (Reservation*) MWITHDRAW(sizeof(Reservation));
+
+	if (reservation != NULL)
+	{
+		reservation->id = 0;
+		reservation->volumes = list_create(reservation, NULL, NULL, MDEPOSIT_wrapper);
+
+		if (reservation->volumes == NULL)
+		{
+			MDEPOSIT(reservation);
+			reservation = NULL;
+		}
+	}
+
+	return reservation;
+}
+
+/******************************************************************************
+ *
+ * \par Function Name:
+ *      ReservationSAP_open
+ *
+ * \brief  Allocate memory for the reservations ledger
+ *
+ *
+ * \par Date Written:
+ *      18/10/26
+ *
+ * \return int
+ *
+ * \retval   0  Success case: the reservations ledger now exists
+ * \retval  -2  MWITHDRAW error
+ *
+ *
+ * \par Revision History:
+ *
+ *  DD/MM/YY |  AUTHOR         |   DESCRIPTION
+ *  -------- | --------------- | -----------------------------------------------
+ *  18/10/26 | agent           |  Initial Implementation and documentation.
+ *****************************************************************************/
+int ReservationSAP_open(UniboCGRSAP* uniboCgrSap)
+{
+    if (UniboCGRSAP_get_ReservationSAP(uniboCgrSap)) return 0;
+    ReservationSAP* sap = MWITHDRAW(sizeof(ReservationSAP));
+    if (!sap) return -2;
+    UniboCGRSAP_set_ReservationSAP(uniboCgrSap, sap);
+    memset(sap, 0, sizeof(ReservationSAP));
+    sap->nextId = 1;
+    sap->reservations = rbt_create(free_reservation, compare_reservations);
+    if (!sap->reservations) {
+        ReservationSAP_close(uniboCgrSap);
+        return -2;
+    }
+    rbt_set_node_pool(sap->reservations, UniboCGRSAP_get_rbt_node_pool(uniboCgrSap));
+
+    return 0;
+}
+
+/******************************************************************************
+ *
+ * \par Function Name:
+ *      ReservationSAP_close
+ *
+ * \brief  Deallocate all the memory used by the reservations ledger.
+ *
+ *
+ * \par Date Written:
+ *      18/10/26
+ *
+ * \return void
+ *
+ * \par Notes:
+ *          1.  The reservations still pending are discarded: the MTVs are not restored.
+ *
+ * \par Revision History:
+ *
+ *  DD/MM/YY |  AUTHOR         |   DESCRIPTION
+ *  -------- | --------------- | -----------------------------------------------
+ *  18/10/26 | agent           |  Initial Implementation and documentation.
+ *****************************************************************************/
+void ReservationSAP_close(UniboCGRSAP* uniboCgrSap)
+{
+    ReservationSAP* sap = UniboCGRSAP_get_ReservationSAP(uniboCgrSap);
+    if (!sap) return;
+    free_reservation(sap->current);
+    rbt_destroy(sap->reservations);
+    memset(sap, 0, sizeof(ReservationSAP));
+    MDEPOSIT(sap);
+    UniboCGRSAP_set_ReservationSAP(uniboCgrSap, NULL);
+}
+
+/******************************************************************************
+ *
+ * \par Function Name:
+ *      ReservationSAP_decrease_time
+ *
+ * \brief  Shift the start time of the reserved contacts when the reference time changes,
+ *         to keep them aligned with the contacts graph.
+ *
+ *
+ * \par Date Written:
+ *      18/10/26
+ *
+ * \return void
+ *
+ * \param[in]  diff   The quantity subtracted from all times
+ *
+ * \par Revision History:
+ *
+ *  DD/MM/YY |  AUTHOR         |   DESCRIPTION
+ *  -------- | --------------- | -----------------------------------------------
+ *  18/10/26 | agent           |  Initial Implementation and documentation.
+ *****************************************************************************/
+void ReservationSAP_decrease_time(UniboCGRSAP* uniboCgrSap, time_t diff)
+{
+	RbtNode *node;
+	ListElt *elt;
+	Reservation *reservation;
+	ReservationSAP *sap = UniboCGRSAP_get_ReservationSAP(uniboCgrSap);
+
+	for (node = rbt_first(sap->reservations); node != NULL; node = rbt_next(node))
+	{
+		reservation = (Reservation*) rbt_data(node);
+
+		for (elt = reservation->volumes->first; elt != NULL; elt = elt->next)
+		{
+			((ReservedVolume*) elt->data)->fromTime -= diff;
+		}
+	}
+}
+
+/******************************************************************************
+ *
+ * \par Function Name:
+ *      begin_reservation
+ *
+ * \brief  Start to record the volumes reserved by a routing call.
+ *
+ *
+ * \par Date Written:
+ *      18/10/26
+ *
+ * \return void
+ *
+ * \par Notes:
+ *          1.  If the volume reservations are disabled nothing will be recorded
+ *              and the reservation kept for the next calls (if any) is freed.
+ *          2.  If the reservation can't be allocated nothing will be recorded:
+ *              the volumes will be consumed as if the volume reservations were disabled.
+ *
+ * \par Revision History:
+ *
+ *  DD/MM/YY |  AUTHOR         |   DESCRIPTION
+ *  -------- | --------------- | -----------------------------------------------
+ *  18/10/26 | agent           |  Initial Implementation and documentation.
+ *****************************************************************************/
+void begin_reservation(UniboCGRSAP* uniboCgrSap)
+{
+	ReservationSAP *sap = UniboCGRSAP_get_ReservationSAP(uniboCgrSap);
+
+	sap->lastReservation = 0;
+
+	if (!UniboCGRSAP_check_volume_reservations(uniboCgrSap))
+	{
+		if (sap->current != NULL)
+		{
+			free_reservation(sap->current);
+			sap->current = NULL;
+		}
+	}
+	else if (sap->current != NULL)
+	{
+		free_list_elts(sap->current->volumes);
+	}
+	else
+	{
+		sap->current = create_reservation();
+	}
+}
+
+/******************************************************************************
+ *
+ * \par Function Name:
+ *      reserve_hops_volume
+ *
+ * \brief  Record that a volume is going to be subtracted from the MTV of all the contacts
+ *         of a route's hops list by the current routing call.
+ *
+ *
+ * \par Date Written:
+ *      18/10/26
+ *
+ * \return int
+ *
+ * \retval   0  Success case: volumes recorded (or nothing to record)
+ * \retval  -2  MWITHDRAW error: nothing recorded
+ *
+ * \param[in]  hops       The hops list (list of Contact*)
+ * \param[in]  volume     The volume subtracted from the MTV of each contact
+ * \param[in]  priority   The volume is subtracted from mtv[0] ... mtv[priority]
+ *
+ * \par Notes:
+ *          1.  Call this function before to subtract the volume from the contacts,
+ *              so the ledger never misses a consumed volume.
+ *
+ * \par Revision History:
+ *
+ *  DD/MM/YY |  AUTHOR         |   DESCRIPTION
+ *  -------- | --------------- | -----------------------------------------------
+ *  18/10/26 | agent           |  Initial Implementation and documentation.
+ *****************************************************************************/
+int reserve_hops_volume(UniboCGRSAP* uniboCgrSap, List hops, int64_t volume, int priority)
+{
+	ListElt *elt;
+	Contact *contact;
+	ReservedVolume *reserved;
+	unsigned long int added = 0;
+	ReservationSAP *sap = UniboCGRSAP_get_ReservationSAP(uniboCgrSap);
+
+	if (sap->current == NULL)
+	{
+		return 0;
+	}
+
+	for (elt = hops->first; elt != NULL; elt = elt->next)
+	{
+		contact = (Contact*) elt->data;
+		reserved = (ReservedVolume*) MWITHDRAW(sizeof(ReservedVolume));
+
+		if (reserved != NULL)
+		{
+			reserved->fromNode = contact->fromNode;
+			reserved->toNode = contact->toNode;
+			reserved->fromTime = contact->fromTime;
+			reserved->volume = volume;
+			reserved->priority = priority;
+
+			if (list_insert_last(sap->current->volumes, reserved) == NULL)
+			{
+				MDEPOSIT(reserved);
+				reserved = NULL;
+			}
+		}
+
+		if (reserved == NULL)
+		{
+			// all or nothing: the caller will not subtract the volume
+			for (; added > 0; added--)
+			{
+				list_remove_last(sap->current->volumes);
+			}
+			return -2;
+		}
+
+		added++;
+	}
+
+	return 0;
+}
+
+/******************************************************************************
+ *
+ * \par Function Name:
+ *      end_reservation
+ *
+ * \brief  Stop to record the volumes reserved by a routing call
+ *         and add the reservation to the ledger.
+ *
+ *
+ * \par Date Written:
+ *      18/10/26
+ *
+ * \return uint64_t
+ *
+ * \retval  "> 0"  The handle of the reservation
+ * \retval     0   Nothing has been reserved (or MWITHDRAW error)
+ *
+ * \par Revision History:
+ *
+ *  DD/MM/YY |  AUTHOR         |   DESCRIPTION
+ *  -------- | --------------- | -----------------------------------------------
+ *  18/10/26 | agent           |  Initial Implementation and documentation.
+ *****************************************************************************/
+uint64_t end_reservation(UniboCGRSAP* uniboCgrSap)
+{
+	ReservationSAP *sap = UniboCGRSAP_get_ReservationSAP(uniboCgrSap);
+	Reservation *reservation = sap->current;
+
+	sap->lastReservation = 0;
+
+	if (reservation == NULL || reservation->volumes->length == 0)
+	{
+		return 0;
+	}
+
+	sap->current = NULL;
+	reservation->id = sap->nextId;
+
+	if (rbt_insert(sap->reservations, reservation) == NULL)
+	{
+		// the volumes stay consumed, as without reservations
+		free_reservation(reservation);
+		return 0;
+	}
+
+	sap->nextId++;
+	sap->lastReservation = reservation->id;
+
+	return reservation->id;
+}
+
+/******************************************************************************
+ *
+ * \par Function Name:
+ *      get_last_reservation
+ *
+ * \brief  Get the handle of the reservation of the last routing call.
+ *
+ *
+ * \par Date Written:
+ *      18/10/26
+ *
+ * \return uint64_t
+ *
+ * \retval  "> 0"  The handle of the reservation
+ * \retval     0   Nothing has been reserved
+ *
+ * \par Revision History:
+ *
+ *  DD/MM/YY |  AUTHOR         |   DESCRIPTION
+ *  -------- | --------------- | -----------------------------------------------
+ *  18/10/26 | agent           |  Initial Implementation and documentation.
+ *****************************************************************************/
+uint64_t get_last_reservation(UniboCGRSAP* uniboCgrSap)
+{
+	return UniboCGRSAP_get_ReservationSAP(uniboCgrSap)->lastReservation;
+}
+
+/******************************************************************************
+ *
+ * \par Function Name:
+ *      get_reservation
+ *
+ * \brief  Search a reservation in the ledger.
+ *
+ *
+ * \par Date Written:
+ *      18/10/26
+ *
+ * \return Reservation*
+ *
+ * \retval Reservation*  The reservation found
+ * \retval NULL          Reservation not found
+ *
+ * \param[in]  id   The handle of the reservation
+ *
+ * \par Revision History:
+ *
+ *  DD/MM/YY |  AUTHOR         |   DESCRIPTION
+ *  -------- | --------------- | -----------------------------------------------
+ *  18/10/26 | agent           |  Initial Implementation and documentation.
+ *****************************************************************************/
+static Reservation* get_reservation(ReservationSAP *sap, uint64_t id)
+{
+	Reservation key;
+	RbtNode *node;
+
+	if (id == 0)
+	{
+		return NULL;
+	}
+
+	key.id = id;
+	key.volumes = NULL;
+	node = rbt_search(sap->reservations, &key, NULL);
+
+	return (node != NULL) ? (Reservation*) rbt_data(node) : NULL;
+}
+
+/******************************************************************************
+ *
+ * \par Function Name:
+ *      commit_reservation
+ *
+ * \brief  The bundle has been transmitted: the reserved volumes remain consumed
+ *         and the reservation is removed from the ledger.
+ *
+ *
+ * \par Date Written:
+ *      18/10/26
+ *
+ * \return int
+ *
+ * \retval   0  Success case: reservation committed
+ * \retval  -1  Reservation not found
+ *
+ * \param[in]  id   The handle of the reservation
+ *
+ * \par Revision History:
+ *
+ *  DD/MM/YY |  AUTHOR         |   DESCRIPTION
+ *  -------- | --------------- | -----------------------------------------------
+ *  18/10/26 | agent           |  Initial Implementation and documentation.
+ *****************************************************************************/
+int commit_reservation(UniboCGRSAP* uniboCgrSap, uint64_t id)
+{
+	ReservationSAP *sap = UniboCGRSAP_get_ReservationSAP(uniboCgrSap);
+	Reservation *reservation = get_reservation(sap, id);
+
+	if (reservation == NULL)
+	{
+		return -1;
+	}
+
+	rbt_delete(sap->reservations, reservation);
+
+	return 0;
+}
+
+/******************************************************************************
+ *
+ * \par Function Name:
+ *      release_reservation
+ *
+ * \brief  The forwarding of the bundle has been canceled: the reserved volumes
+ *         go back to the contacts and the reservation is removed from the ledger.
+ *
+ *
+ * \par Date Written:
+ *      18/10/26
+ *
+ * \return int
+ *
+ * \retval   0  Success case: reservation released
+ * \retval  -1  Reservation not found
+ *
+ * \param[in]  id   The handle of the reservation
+ *
+ * \par Notes:
+ *          1.  The volumes of the contacts that no longer exist (expired or removed) are discarded.
+ *
+ * \par Revision History:
+ *
+ *  DD/MM/YY |  AUTHOR         |   DESCRIPTION
+ *  -------- | --------------- | -----------------------------------------------
+ *  18/10/26 | agent           |  Initial Implementation and documentation.
+ *  18/10/26 | agent           |  Integer MTV: saturating increment.
+ *****************************************************************************/
+int release_reservation(UniboCGRSAP* uniboCgrSap, uint64_t id)
+{
+	ListElt *elt;
+	ReservedVolume *reserved;
+	Contact *contact;
+	ReservationSAP *sap = UniboCGRSAP_get_ReservationSAP(uniboCgrSap);
+	Reservation *reservation = get_reservation(sap, id);
+
+	if (reservation == NULL)
+	{
+		return -1;
+	}
+
+	for (elt = reservation->volumes->first; elt != NULL; elt = elt->next)
+	{
+		reserved = (ReservedVolume*) elt->data;
+		contact = get_contact(uniboCgrSap, reserved->fromNode, reserved->toNode, reserved->fromTime, NULL);
+
+		if (contact != NULL)
+		{
+			increase_mtv(contact, reserved->priority, reserved->volume);
+		}
+	}
+
+	rbt_delete(sap->reservations, reservation);
+
+	return 0;
+}
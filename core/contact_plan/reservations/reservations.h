@@ -0,0 +1,63 @@
+/** \file reservations.h
+ *
+ * \brief  This file provides the declarations of the functions
+ *         to manage the ledger of the volumes reserved on the contacts by the routing calls.
+ *
+ *
+ ** \copyright Copyright (c) 2020, Alma Mater Studiorum, University of Bologna, All rights reserved.
+ **
+ ** \par License
+ **
+ **    This file is part of Unibo-CGR.                                            <br>
+ **                                                                               <br>
+ **    Unibo-CGR is free software: you can redistribute it and/or modify
+ **    it under the terms of the GNU General Public License as published by
+ **    the Free Software Foundation, either version 3 of the License, or
+ **    (at your option) any later version.                                        <br>
+ **    Unibo-CGR is distributed in the hope that it will be useful,
+ **    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ **    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ **    GNU General Public License for more details.                               <br>
+ **                                                                               <br>
+ **    You should have received a copy of the GNU General Public License
+ **    along with Unibo-CGR.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  \author agent, agent@local
+ *
+ *  \par Supervisor
+ *       Carlo Caini, carlo.caini@unibo.it
+ */
+
+#ifndef SOURCES_CONTACTS_PLAN_RESERVATIONS_RESERVATIONS_H_
+#define SOURCES_CONTACTS_PLAN_RESERVATIONS_RESERVATIONS_H_
+
+#include <sys/time.h>
+
+#include "../../UniboCGRSAP.h"
+#include "../../library/commonDefines.h"
+#include "../../library/list/list_type.h"
+#include "../contacts/contacts.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+extern int ReservationSAP_open(UniboCGRSAP* uniboCgrSap);
+extern void ReservationSAP_close(UniboCGRSAP* uniboCgrSap);
+
+extern void ReservationSAP_decrease_time(UniboCGRSAP* uniboCgrSap, time_t diff);
+
+extern void begin_reservation(UniboCGRSAP* uniboCgrSap);
+extern int reserve_hops_volume(UniboCGRSAP* uniboCgrSap, List hops, int64_t volume, int priority);
+extern uint64_t end_reservation(UniboCGRSAP* uniboCgrSap);
+extern uint64_t get_last_reservation(UniboCGRSAP* uniboCgrSap);
+
+extern int commit_reservation(UniboCGRSAP* uniboCgrSap, uint64_t id);
+extern int release_reservation(UniboCGRSAP* uniboCgrSap, uint64_t id);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SOURCES_CONTACTS_PLAN_RESERVATIONS_RESERVATIONS_H_ */
@@ -0,0 +1,1185 @@
+/** \file text_plan.c
+ *
+ *  \brief  This file provides the implementation of the functions
+ *          to parse a contact plan text file.
+ *
+ *  \details The file is mapped in memory and split in line-aligned chunks,
+ *           each chunk is parsed by its own thread in two passes:
+ *           the first pass counts the lines and the records, so that the
+ *           records can be allocated once (by the calling thread);
+ *           the second pass parses each record in its slot.
+ *
+ *
+ ** \copyright Copyright (c) 2020, Alma Mater Studiorum, University of Bologna, All rights reserved.
+ **
+ ** \par License
+ **
+ **    This file is part of Unibo-CGR.                                            <br>
+ **                                                                               <br>
+ **    Unibo-CGR is free software: you can redistribute it and/or modify
+ **    it under the terms of the GNU General Public License as published by
+ **    the Free Software Foundation, either version 3 of the License, or
+ **    (at your option) any later version.                                        <br>
+ **    Unibo-CGR is distributed in the hope that it will be useful,
+ **    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ **    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ **    GNU General Public License for more details.                               <br>
+ **                                                                               <br>
+ **    You should have received a copy of the GNU General Public License
+ **    along with Unibo-CGR.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  \author agent, agent@local
+ *
+ *  \par Supervisor
+ *       Carlo Caini, carlo.caini@unibo.it
+ */
+
+#include "text_plan.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "../../UniboCGRSAP.h"
+#include "../contacts/contacts.h"
+
+typedef enum
+{
+	LineNone = 0,
+	LineCsvContact,
+	LineCsvRange,
+	LineIonContact,
+	LineIonRange
+} TextPlanLine;
+
+/**
+ * \brief A line-aligned slice of the file, parsed by one thread.
+ */
+typedef struct
+{
+	const char *begin;
+	const char *end;
+	/**
+	 * \brief 1 to count, 2 to parse
+	 */
+	int pass;
+	time_t timeOffset;
+	/**
+	 * \brief Filled by the first pass
+	 */
+	uint64_t lines;
+	uint64_t contactsCount;
+	uint64_t rangesCount;
+	uint64_t ionRangesCount;
+	/**
+	 * \brief Set by the calling thread before the second pass
+	 */
+	uint64_t firstLine;
+	BinaryPlanContact *contacts;
+	BinaryPlanRange *ranges;
+	BinaryPlanRange *reverseRanges;
+	/**
+	 * \brief Filled by the second pass
+	 */
+	uint64_t reverseRangesCount;
+	/**
+	 * \brief The first line with a syntax error, 0 if none
+	 */
+	uint64_t errorLine;
+} TextPlanChunk;
+
+/******************************************************************************
+ *
+ * \par Function Name:
+ *      skip_blanks
+ *
+ * \brief  Skip spaces, tabs and carriage returns.
+ *
+ *
+ * \par Date Written:
+ *      18/10/26
+ *
+ * \return const char*
+ *
+ * \retval const char*  The first character that is not blank (or end)
+ *
+ * \param[in]   *p     The current character
+ * \param[in]   *end   The end of the line
+ *
+ * \par Revision History:
+ *
+ *  DD/MM/YY |  AUTHOR         |   DESCRIPTION
+ *  -------- | --------------- | -----------------------------------------------
+ *  18/10/26 | agent           |  Initial Implementation and documentation.
+ *****************************************************************************/
+static const char *skip_blanks(const char *p, const char *end)
+{
+	while (p < end && (*p == ' ' || *p == '\t' || *p == '\r'))
+	{
+		p++;
+	}
+
+	return p;
+}
+
+/******************************************************************************
+ *
+ * \par Function Name:
+ *      match_word
+ *
+ * \brief  Check if the line continues with the given word, followed
+ *         by a blank, a ',' or the end of the line.
+ *
+ *
+ * \par Date Written:
+ *      18/10/26
+ *
+ * \return const char*
+ *
+ * \retval const char*  The character after the word
+ * \retval NULL         The word does not match
+ *
+ * \param[in]   *p      The current character
+ * \param[in]   *end    The end of the line
+ * \param[in]   *word   The word
+ *
+ * \par Revision History:
+ *
+ *  DD/MM/YY |  AUTHOR         |   DESCRIPTION
+ *  -------- | --------------- | -----------------------------------------------
+ *  18/10/26 | agent           |  Initial Implementation and documentation.
+ *****************************************************************************/
+static const char *match_word(const char *p, const char *end, const char *word)
+{
+	while (*word != '\0')
+	{
+		if (p >= end || *p != *word)
+		{
+			return NULL;
+		}
+		p++;
+		word++;
+	}
+
+	if (p < end && *p != ' ' && *p != '\t' && *p != '\r' && *p != ',')
+	{
+		return NULL;
+	}
+
+	return p;
+}
+
+/******************************************************************************
+ *
+ * \par Function Name:
+ *      classify_line
+ *
+ * \brief  Find the kind of record of a line.
+ *
+ *
+ * \par Date Written:
+ *      18/10/26
+ *
+ * \return TextPlanLine
+ *
+ * \param[in]   *p      The first character of the line
+ * \param[in]   *end    The end of the line
+ * \param[out]  **next  The first character after the record's keyword(s)
+ *
+ * \par Revision History:
+ *
+ *  DD/MM/YY |  AUTHOR         |   DESCRIPTION
+ *  -------- | --------------- | -----------------------------------------------
+ *  18/10/26 | agent           |  Initial Implementation and documentation.
+ *****************************************************************************/
+static TextPlanLine classify_line(const char *p, const char *end, const char **next)
+{
+	const char *q;
+
+	p = skip_blanks(p, end);
+	if (p >= end || *p == '#')
+	{
+		return LineNone;
+	}
+
+	if ((q = match_word(p, end, "CONTACT")) != NULL)
+	{
+		q = skip_blanks(q, end);
+		if (q < end && *q == ',')
+		{
+			*next = q + 1;
+			return LineCsvContact;
+		}
+	}
+	else if ((q = match_word(p, end, "RANGE")) != NULL)
+	{
+		q = skip_blanks(q, end);
+		if (q < end && *q == ',')
+		{
+			*next = q + 1;
+			return LineCsvRange;
+		}
+	}
+	else if ((q = match_word(p, end, "a")) != NULL)
+	{
+		q = skip_blanks(q, end);
+		if ((p = match_word(q, end, "contact")) != NULL)
+		{
+			*next = p;
+			return LineIonContact;
+		}
+		if ((p = match_word(q, end, "range")) != NULL)
+		{
+			*next = p;
+			return LineIonRange;
+		}
+	}
+
+	return LineNone;
+}
+
+/******************************************************************************
+ *
+ * \par Function Name:
+ *      parse_unsigned
+ *
+ * \brief  Parse a decimal unsigned integer.
+ *
+ *
+ * \par Date Written:
+ *      18/10/26
+ *
+ * \return int
+ *
+ * \retval   0  Success case
+ * \retval  -1  No digits or overflow
+ *
+ * \param[in,out]  **cursor   The current character, moved after the number
+ * \param[in]      *end       The end of the line
+ * \param[out]     *value     The number
+ *
+ * \par Revision History:
+ *
+ *  DD/MM/YY |  AUTHOR         |   DESCRIPTION
+ *  -------- | --------------- | -----------------------------------------------
+ *  18/10/26 | agent           |  Initial Implementation and documentation.
+ *****************************************************************************/
+static int parse_unsigned(const char **cursor, const char *end, uint64_t *value)
+{
+	const char *p = *cursor;
+	uint64_t result = 0;
+	unsigned int digit;
+
+	if (p >= end || *p < '0' || *p > '9')
+	{
+		return -1;
+	}
+
+	while (p < end && *p >= '0' && *p <= '9')
+	{
+		digit = (unsigned int) (*p - '0');
+		if (result > (UINT64_MAX - digit) / 10)
+		{
+			return -1;
+		}
+		result = result * 10 + digit;
+		p++;
+	}
+
+	*cursor = p;
+	*value = result;
+
+	return 0;
+}
+
+/******************************************************************************
+ *
+ * \par Function Name:
+ *      parse_signed
+ *
+ * \brief  Parse a decimal integer with an optional sign.
+ *
+ *
+ * \par Date Written:
+ *      18/10/26
+ *
+ * \return int
+ *
+ * \retval   0  Success case
+ * \retval  -1  No digits or overflow
+ *
+ * \param[in,out]  **cursor   The current character, moved after the number
+ * \param[in]      *end       The end of the line
+ * \param[out]     *value     The number
+ *
+ * \par Revision History:
+ *
+ *  DD/MM/YY |  AUTHOR         |   DESCRIPTION
+ *  -------- | --------------- | -----------------------------------------------
+ *  18/10/26 | agent           |  Initial Implementation and documentation.
+ *****************************************************************************/
+static int parse_signed(const char **cursor, const char *end, int64_t *value)
+{
+	const char *p = *cursor;
+	uint64_t magnitude;
+	int negative = 0;
+
+	if (p < end && (*p == '-' || *p == '+'))
+	{
+		negative = (*p == '-');
+		p++;
+	}
+
+	if (parse_unsigned(&p, end, &magnitude) < 0 || magnitude > (uint64_t) INT64_MAX)
+	{
+		return -1;
+	}
+
+	*cursor = p;
+	*value = negative ? -((int64_t) magnitude) : (int64_t) magnitude;
+
+	return 0;
+}
+
+/******************************************************************************
+ *
+ * \par Function Name:
+ *      parse_real
+ *
+ * \brief  Parse a decimal real number: [sign] digits [. digits] [e [sign] digits]
+ *
+ *
+ * \par Date Written:
+ *      18/10/26
+ *
+ * \return int
+ *
+ * \retval   0  Success case
+ * \retval  -1  No digits or exponent out of range
+ *
+ * \param[in,out]  **cursor   The current character, moved after the number
+ * \param[in]      *end       The end of the line
+ * \param[out]     *value     The number
+ *
+ * \par Revision History:
+ *
+ *  DD/MM/YY |  AUTHOR         |   DESCRIPTION
+ *  -------- | --------------- | -----------------------------------------------
+ *  18/10/26 | agent           |  Initial Implementation and documentation.
+ *****************************************************************************/
+static int parse_real(const char **cursor, const char *end, double *value)
+{
+	const char *p = *cursor;
+	double result = 0.0, scale = 1.0;
+	int negative = 0, digits = 0;
+	int64_t exponent = 0;
+
+	if (p < end && (*p == '-' || *p == '+'))
+	{
+		negative = (*p == '-');
+		p++;
+	}
+
+	while (p < end && *p >= '0' && *p <= '9')
+	{
+		result = result * 10.0 + (double) (*p - '0');
+		digits++;
+		p++;
+	}
+
+	if (p < end && *p == '.')
+	{
+		p++;
+		while (p < end && *p >= '0' && *p <= '9')
+		{
+			scale /= 10.0;
+			result += (double) (*p - '0') * scale;
+			digits++;
+			p++;
+		}
+	}
+
+	if (digits == 0)
+	{
+		return -1;
+	}
+
+	if (p < end && (*p == 'e' || *p == 'E'))
+	{
+		p++;
+		if (parse_signed(&p, end, &exponent) < 0 || exponent > 308 || exponent < -308)
+		{
+			return -1;
+		}
+		for (; exponent > 0; exponent--)
+		{
+			result *= 10.0;
+		}
+		for (; exponent < 0; exponent++)
+		{
+			result /= 10.0;
+		}
+	}
+
+	*cursor = p;
+	*value = negative ? -result : result;
+
+	return 0;
+}
+
+/******************************************************************************
+ *
+ * \par Function Name:
+ *      days_from_civil
+ *
+ * \brief  Number of days from 1970/01/01 to the given date (proleptic Gregorian calendar).
+ *
+ *
+ * \par Date Written:
+ *      18/10/26
+ *
+ * \return int64_t
+ *
+ * \param[in]   year    The year
+ * \param[in]   month   The month [1,12]
+ * \param[in]   day     The day of the month [1,31]
+ *
+ * \par Revision History:
+ *
+ *  DD/MM/YY |  AUTHOR         |   DESCRIPTION
+ *  -------- | --------------- | -----------------------------------------------
+ *  18/10/26 | agent           |  Initial Implementation and documentation.
+ *****************************************************************************/
+static int64_t days_from_civil(int64_t year, int64_t month, int64_t day)
+{
+	int64_t era, yearOfEra, dayOfYear, dayOfEra;
+
+	year -= (month <= 2) ? 1 : 0;
+	era = ((year >= 0) ? year : year - 399) / 400;
+	yearOfEra = year - era * 400;
+	dayOfYear = (153 * (month + ((month > 2) ? -3 : 9)) + 2) / 5 + day - 1;
+	dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+
+	return era * 146097 + dayOfEra - 719468;
+}
+
+/******************************************************************************
+ *
+ * \par Function Name:
+ *      parse_ion_time
+ *
+ * \brief  Parse an ionadmin time: "+seconds" or "yyyy/mm/dd-hh:mm:ss" (UTC)
+ *
+ *
+ * \par Date Written:
+ *      18/10/26
+ *
+ * \return int
+ *
+ * \retval   0  Success case
+ * \retval  -1  Syntax error
+ *
+ * \param[in,out]  **cursor      The current character, moved after the time
+ * \param[in]      *end          The end of the line
+ * \param[in]      timeOffset    Subtracted from the absolute times
+ * \param[out]     *value        The time, relative to timeOffset
+ *
+ * \par Revision History:
+ *
+ *  DD/MM/YY |  AUTHOR         |   DESCRIPTION
+ *  -------- | --------------- | -----------------------------------------------
+ *  18/10/26 | agent           |  Initial Implementation and documentation.
+ *****************************************************************************/
+static int parse_ion_time(const char **cursor, const char *end, time_t timeOffset, int64_t *value)
+{
+	const char *p = *cursor;
+	const char separators[5] = { '/', '/', '-', ':', ':' };
+	uint64_t fields[6];
+	int i;
+
+	if (p < end && *p == '+')
+	{
+		return parse_signed(cursor, end, value);
+	}
+
+	for (i = 0; i < 6; i++)
+	{
+		if (parse_unsigned(&p, end, &fields[i]) < 0 || fields[i] > 1000000)
+		{
+			return -1;
+		}
+		if (i < 5)
+		{
+			if (p >= end || *p != separators[i])
+			{
+				return -1;
+			}
+			p++;
+		}
+	}
+
+	if (fields[1] < 1 || fields[1] > 12 || fields[2] < 1 || fields[2] > 31
+			|| fields[3] > 23 || fields[4] > 59 || fields[5] > 60)
+	{
+		return -1;
+	}
+
+	*value = days_from_civil((int64_t) fields[0], (int64_t) fields[1], (int64_t) fields[2]) * 86400
+			+ (int64_t) (fields[3] * 3600 + fields[4] * 60 + fields[5])
+			- (int64_t) timeOffset;
+	*cursor = p;
+
+	return 0;
+}
+
+/******************************************************************************
+ *
+ * \par Function Name:
+ *      end_of_field
+ *
+ * \brief  Check what follows a field.
+ *
+ *
+ * \par Date Written:
+ *      18/10/26
+ *
+ * \return int
+ *
+ * \retval   1  Another field follows (the separator has been skipped)
+ * \retval   0  End of the line
+ * \retval  -1  Syntax error (something else follows the field)
+ *
+ * \param[in,out]  **cursor   The character after the field
+ * \param[in]      *end       The end of the line
+ * \param[in]      csv        1 for a CSV line (fields separated by ','),
+ *                            0 for an ionadmin line (fields separated by blanks)
+ *
+ * \par Revision History:
+ *
+ *  DD/MM/YY |  AUTHOR         |   DESCRIPTION
+ *  -------- | --------------- | -----------------------------------------------
+ *  18/10/26 | agent           |  Initial Implementation and documentation.
+ *****************************************************************************/
+static int end_of_field(const char **cursor, const char *end, int csv)
+{
+	const char *p = skip_blanks(*cursor, end);
+
+	if (p >= end)
+	{
+		*cursor = p;
+		return 0;
+	}
+	if (csv)
+	{
+		if (*p != ',')
+		{
+			return -1;
+		}
+		*cursor = skip_blanks(p + 1, end);
+		return 1;
+	}
+	if (p == *cursor)
+	{
+		return -1; // no blank after the field
+	}
+
+	*cursor = p;
+	return 1;
+}
+
+/******************************************************************************
+ *
+ * \par Function Name:
+ *      parse_record
+ *
+ * \brief  Parse the fields of a record line.
+ *
+ *
+ * \par Date Written:
+ *      18/10/26
+ *
+ * \return int
+ *
+ * \retval   0  Success case
+ * \retval  -1  Syntax error
+ *
+ * \param[in]   kind          The kind of the line, from classify_line()
+ * \param[in]   *p            The first character after the record's keyword(s)
+ * \param[in]   *end          The end of the line
+ * \param[in]   timeOffset    Used for the ionadmin absolute times
+ * \param[out]  *contact      Filled for a contact line
+ * \param[out]  *range        Filled for a range line
+ *
+ * \par Revision History:
+ *
+ *  DD/MM/YY |  AUTHOR         |   DESCRIPTION
+ *  -------- | --------------- | -----------------------------------------------
+ *  18/10/26 | agent           |  Initial Implementation and documentation.
+ *****************************************************************************/
+static int parse_record(TextPlanLine kind, const char *p, const char *end, time_t timeOffset,
+		BinaryPlanContact *contact, BinaryPlanRange *range)
+{
+	double confidence;
+	int more, priority;
+
+	p = skip_blanks(p, end);
+
+	if (kind == LineCsvContact)
+	{
+		memset(contact, 0, sizeof(BinaryPlanContact));
+		if (parse_unsigned(&p, end, &contact->fromNode) < 0 || end_of_field(&p, end, 1) != 1
+				|| parse_unsigned(&p, end, &contact->toNode) < 0 || end_of_field(&p, end, 1) != 1
+				|| parse_signed(&p, end, &contact->fromTime) < 0 || end_of_field(&p, end, 1) != 1
+				|| parse_signed(&p, end, &contact->toTime) < 0 || end_of_field(&p, end, 1) != 1
+				|| parse_unsigned(&p, end, &contact->xmitRate) < 0 || end_of_field(&p, end, 1) != 1
+				|| parse_real(&p, end, &confidence) < 0)
+		{
+			return -1;
+		}
+		contact->confidence = (float) confidence;
+		for (priority = 0; priority < 3; priority++)
+		{
+			if (end_of_field(&p, end, 1) != 1 || parse_real(&p, end, &contact->mtv[priority]) < 0)
+			{
+				return -1;
+			}
+		}
+		// further fields are ignored
+		return (end_of_field(&p, end, 1) < 0) ? -1 : 0;
+	}
+	else if (kind == LineCsvRange)
+	{
+		if (parse_unsigned(&p, end, &range->fromNode) < 0 || end_of_field(&p, end, 1) != 1
+				|| parse_unsigned(&p, end, &range->toNode) < 0 || end_of_field(&p, end, 1) != 1
+				|| parse_signed(&p, end, &range->fromTime) < 0 || end_of_field(&p, end, 1) != 1
+				|| parse_signed(&p, end, &range->toTime) < 0 || (more = end_of_field(&p, end, 1)) < 0)
+		{
+			return -1;
+		}
+		range->owlt = 0; // optional
+		if (more && p < end)
+		{
+			if (parse_unsigned(&p, end, &range->owlt) < 0 || end_of_field(&p, end, 1) < 0)
+			{
+				return -1;
+			}
+		}
+		return 0;
+	}
+	else if (kind == LineIonContact)
+	{
+		memset(contact, 0, sizeof(BinaryPlanContact));
+		if (parse_ion_time(&p, end, timeOffset, &contact->fromTime) < 0 || end_of_field(&p, end, 0) != 1
+				|| parse_ion_time(&p, end, timeOffset, &contact->toTime) < 0 || end_of_field(&p, end, 0) != 1
+				|| parse_unsigned(&p, end, &contact->fromNode) < 0 || end_of_field(&p, end, 0) != 1
+				|| parse_unsigned(&p, end, &contact->toNode) < 0 || end_of_field(&p, end, 0) != 1
+				|| parse_unsigned(&p, end, &contact->xmitRate) < 0 || (more = end_of_field(&p, end, 0)) < 0)
+		{
+			return -1;
+		}
+		confidence = 1.0; // optional
+		if (more)
+		{
+			if (parse_real(&p, end, &confidence) < 0 || end_of_field(&p, end, 0) != 0)
+			{
+				return -1;
+			}
+		}
+		contact->confidence = (float) confidence;
+		// as if added without MTVs
+		for (priority = 0; priority < 3; priority++)
+		{
+			contact->mtv[priority] = (double) compute_contact_volume(
+					(time_t) (contact->toTime - contact->fromTime), contact->xmitRate);
+		}
+		return 0;
+	}
+	else if (kind == LineIonRange)
+	{
+		if (parse_ion_time(&p, end, timeOffset, &range->fromTime) < 0 || end_of_field(&p, end, 0) != 1
+				|| parse_ion_time(&p, end, timeOffset, &range->toTime) < 0 || end_of_field(&p, end, 0) != 1
+				|| parse_unsigned(&p, end, &range->fromNode) < 0 || end_of_field(&p, end, 0) != 1
+				|| parse_unsigned(&p, end, &range->toNode) < 0 || end_of_field(&p, end, 0) != 1
+				|| parse_unsigned(&p, end, &range->owlt) < 0 || end_of_field(&p, end, 0) != 0)
+		{
+			return -1;
+		}
+		return 0;
+	}
+
+	return -1;
+}
+
+/******************************************************************************
+ *
+ * \par Function Name:
+ *      parse_chunk
+ *
+ * \brief  Thread body: count (first pass) or parse (second pass) the records of a chunk.
+ *
+ *
+ * \par Date Written:
+ *      18/10/26
+ *
+ * \return void*
+ *
+ * \retval NULL  Always
+ *
+ * \param[in,out]  *arg   The TextPlanChunk
+ *
+ * \par Notes:
+ *          1.  No memory is allocated here: the second pass writes the records
+ *              in the slots reserved by the calling thread.
+ *
+ * \par Revision History:
+ *
+ *  DD/MM/YY |  AUTHOR         |   DESCRIPTION
+ *  -------- | --------------- | -----------------------------------------------
+ *  18/10/26 | agent           |  Initial Implementation and documentation.
+ *****************************************************************************/
+static void *parse_chunk(void *arg)
+{
+	TextPlanChunk *chunk = (TextPlanChunk*) arg;
+	const char *line, *lineEnd, *next;
+	uint64_t lineNumber, contactIndex = 0, rangeIndex = 0;
+	BinaryPlanRange *range;
+	TextPlanLine kind;
+
+	lineNumber = chunk->firstLine;
+	for (line = chunk->begin; line < chunk->end; line = lineEnd + 1)
+	{
+		lineEnd = memchr(line, '\n', (size_t) (chunk->end - line));
+		if (lineEnd == NULL)
+		{
+			lineEnd = chunk->end;
+		}
+
+		kind = classify_line(line, lineEnd, &next);
+
+		if (chunk->pass == 1)
+		{
+			chunk->lines++;
+			if (kind == LineCsvContact || kind == LineIonContact)
+			{
+				chunk->contactsCount++;
+			}
+			else if (kind == LineCsvRange)
+			{
+				chunk->rangesCount++;
+			}
+			else if (kind == LineIonRange)
+			{
+				chunk->rangesCount++;
+				chunk->ionRangesCount++;
+			}
+		}
+		else if (kind != LineNone)
+		{
+			if (kind == LineCsvContact || kind == LineIonContact)
+			{
+				if (parse_record(kind, next, lineEnd, chunk->timeOffset, &chunk->contacts[contactIndex], NULL) < 0)
+				{
+					chunk->errorLine = lineNumber;
+					return NULL;
+				}
+				contactIndex++;
+			}
+			else
+			{
+				range = &chunk->ranges[rangeIndex];
+				if (parse_record(kind, next, lineEnd, chunk->timeOffset, NULL, range) < 0)
+				{
+					chunk->errorLine = lineNumber;
+					return NULL;
+				}
+				rangeIndex++;
+				if (kind == LineIonRange && range->fromNode != range->toNode)
+				{
+					chunk->reverseRanges[chunk->reverseRangesCount] = *range;
+					chunk->reverseRanges[chunk->reverseRangesCount].fromNode = range->toNode;
+					chunk->reverseRanges[chunk->reverseRangesCount].toNode = range->fromNode;
+					chunk->reverseRangesCount++;
+				}
+			}
+		}
+
+		lineNumber++;
+	}
+
+	return NULL;
+}
+
+/******************************************************************************
+ *
+ * \par Function Name:
+ *      run_chunks
+ *
+ * \brief  Run parse_chunk() on each chunk, one thread per chunk.
+ *
+ *
+ * \par Date Written:
+ *      18/10/26
+ *
+ * \return void
+ *
+ * \param[in,out]  *chunks   The chunks
+ * \param[in]      count     The number of chunks
+ *
+ * \par Notes:
+ *          1.  The first chunk is parsed by the calling thread, as the chunks
+ *              whose thread cannot be created.
+ *
+ * \par Revision History:
+ *
+ *  DD/MM/YY |  AUTHOR         |   DESCRIPTION
+ *  -------- | --------------- | -----------------------------------------------
+ *  18/10/26 | agent           |  Initial Implementation and documentation.
+ *****************************************************************************/
+static void run_chunks(TextPlanChunk *chunks, uint32_t count)
+{
+	pthread_t threads[TEXT_PLAN_MAX_THREADS];
+	int started[TEXT_PLAN_MAX_THREADS];
+	uint32_t i;
+
+	for (i = 1; i < count; i++)
+	{
+		started[i] = (pthread_create(&threads[i], NULL, parse_chunk, &chunks[i]) == 0);
+	}
+
+	parse_chunk(&chunks[0]);
+
+	for (i = 1; i < count; i++)
+	{
+		if (started[i])
+		{
+			pthread_join(threads[i], NULL);
+		}
+		else
+		{
+			parse_chunk(&chunks[i]);
+		}
+	}
+}
+
+/******************************************************************************
+ *
+ * \par Function Name:
+ *      compare_ranges_records
+ *
+ * \brief  qsort() comparator for BinaryPlanRange (fromNode, toNode, fromTime).
+ *
+ *
+ * \par Date Written:
+ *      18/10/26
+ *
+ * \return int
+ *
+ * \param[in]	*first    Pointer to the first BinaryPlanRange
+ * \param[in]	*second   Pointer to the second BinaryPlanRange
+ *
+ * \par Revision History:
+ *
+ *  DD/MM/YY |  AUTHOR         |   DESCRIPTION
+ *  -------- | --------------- | -----------------------------------------------
+ *  18/10/26 | agent           |  Initial Implementation and documentation.
+ *****************************************************************************/
+static int compare_ranges_records(const void *first, const void *second)
+{
+	const BinaryPlanRange *a = (const BinaryPlanRange*) first;
+	const BinaryPlanRange *b = (const BinaryPlanRange*) second;
+
+	if (a->fromNode != b->fromNode)
+	{
+		return (a->fromNode < b->fromNode) ? -1 : 1;
+	}
+	if (a->toNode != b->toNode)
+	{
+		return (a->toNode < b->toNode) ? -1 : 1;
+	}
+	if (a->fromTime != b->fromTime)
+	{
+		return (a->fromTime < b->fromTime) ? -1 : 1;
+	}
+
+	return 0;
+}
+
+/******************************************************************************
+ *
+ * \par Function Name:
+ *      overlaps_declared_range
+ *
+ * \brief  Check if a range overlaps one of the (sorted) declared ranges
+ *         with the same sender and receiver.
+ *
+ *
+ * \par Date Written:
+ *      18/10/26
+ *
+ * \return int
+ *
+ * \retval   1  Overlap
+ * \retval   0  No overlap
+ *
+ * \param[in]   *ranges   The declared ranges, sorted by compare_ranges_records()
+ * \param[in]   count     The number of declared ranges
+ * \param[in]   *range    The range to check
+ *
+ * \par Revision History:
+ *
+ *  DD/MM/YY |  AUTHOR         |   DESCRIPTION
+ *  -------- | --------------- | -----------------------------------------------
+ *  18/10/26 | agent           |  Initial Implementation and documentation.
+ *****************************************************************************/
+static int overlaps_declared_range(const BinaryPlanRange *ranges, uint64_t count, const BinaryPlanRange *range)
+{
+	uint64_t low = 0, high = count, middle;
+
+	// first declared range not less than "range"
+	while (low < high)
+	{
+		middle = low + (high - low) / 2;
+		if (compare_ranges_records(&ranges[middle], range) < 0)
+		{
+			low = middle + 1;
+		}
+		else
+		{
+			high = middle;
+		}
+	}
+
+	if (low < count && ranges[low].fromNode == range->fromNode && ranges[low].toNode == range->toNode
+			&& ranges[low].fromTime < range->toTime)
+	{
+		return 1;
+	}
+	if (low > 0 && ranges[low - 1].fromNode == range->fromNode && ranges[low - 1].toNode == range->toNode
+			&& ranges[low - 1].toTime > range->fromTime)
+	{
+		return 1;
+	}
+
+	return 0;
+}
+
+/******************************************************************************
+ *
+ * \par Function Name:
+ *      text_plan_parse
+ *
+ * \brief  Parse a contact plan text file (see text_plan.h for the syntax).
+ *
+ *
+ * \par Date Written:
+ *      18/10/26
+ *
+ * \return int
+ *
+ * \retval   0  Success case: call text_plan_destroy() when done
+ * \retval  -1  Cannot open or map the file
+ * \retval  -2  MWITHDRAW error
+ * \retval  -3  Syntax error: the line is written in *errorLine
+ *
+ * \param[in]   *fileName     The file to parse
+ * \param[in]   timeOffset    The ionadmin absolute times are stored relative to it
+ * \param[in]   threads       Number of threads, 0 to use one thread for each online CPU
+ *                            (at most TEXT_PLAN_MAX_THREADS)
+ * \param[out]  *plan         The records
+ * \param[out]  *errorLine    In case of syntax error: the first wrong line (starting from 1)
+ *
+ * \par Notes:
+ *          1.  The records are not validated (overlaps, node numbers, ...),
+ *              it is up to the bulk ingestion.
+ *
+ * \par Revision History:
+ *
+ *  DD/MM/YY |  AUTHOR         |   DESCRIPTION
+ *  -------- | --------------- | -----------------------------------------------
+ *  18/10/26 | agent           |  Initial Implementation and documentation.
+ *****************************************************************************/
+int text_plan_parse(const char *fileName, time_t timeOffset, uint32_t threads, TextPlan *plan, uint64_t *errorLine)
+{
+	TextPlanChunk chunks[TEXT_PLAN_MAX_THREADS];
+	uint64_t contactsTotal = 0, rangesTotal = 0, reverseTotal = 0, reverseKept, line = 1, i;
+	uint32_t count, c;
+	struct stat info;
+	const char *base, *boundary;
+	void *address;
+	size_t size;
+	long online;
+	int fd, result = 0;
+
+	memset(plan, 0, sizeof(TextPlan));
+	*errorLine = 0;
+
+	fd = open(fileName, O_RDONLY);
+	if (fd < 0)
+	{
+		return -1;
+	}
+	if (fstat(fd, &info) != 0)
+	{
+		close(fd);
+		return -1;
+	}
+	size = (size_t) info.st_size;
+	if (size == 0)
+	{
+		close(fd);
+		return 0;
+	}
+	address = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (address == MAP_FAILED)
+	{
+		return -1;
+	}
+	base = (const char*) address;
+
+	if (threads == 0)
+	{
+		online = sysconf(_SC_NPROCESSORS_ONLN);
+		threads = (online > 0) ? (uint32_t) online : 1;
+	}
+	count = (uint32_t) ((size / TEXT_PLAN_MIN_CHUNK_SIZE) + 1);
+	count = (count < threads) ? count : threads;
+	count = (count < TEXT_PLAN_MAX_THREADS) ? count : TEXT_PLAN_MAX_THREADS;
+
+	// line-aligned chunks
+	memset(chunks, 0, sizeof(chunks));
+	boundary = base;
+	for (c = 0; c < count; c++)
+	{
+		chunks[c].begin = boundary;
+		if (c + 1 == count)
+		{
+			boundary = base + size;
+		}
+		else
+		{
+			boundary = base + (size / count) * (c + 1);
+			if (boundary < chunks[c].begin)
+			{
+				boundary = chunks[c].begin;
+			}
+			boundary = memchr(boundary, '\n', (size_t) (base + size - boundary));
+			boundary = (boundary == NULL) ? base + size : boundary + 1;
+		}
+		chunks[c].end = boundary;
+		chunks[c].timeOffset = timeOffset;
+		chunks[c].pass = 1;
+	}
+
+	run_chunks(chunks, count);
+
+	for (c = 0; c < count; c++)
+	{
+		contactsTotal += chunks[c].contactsCount;
+		rangesTotal += chunks[c].rangesCount;
+		reverseTotal += chunks[c].ionRangesCount;
+	}
+
+	plan->contacts = MWITHDRAW(sizeof(BinaryPlanContact) * (contactsTotal > 0 ? contactsTotal : 1));
+	plan->ranges = MWITHDRAW(sizeof(BinaryPlanRange) * ((rangesTotal + reverseTotal) > 0 ? (rangesTotal + reverseTotal) : 1));
+	if (plan->contacts == NULL || plan->ranges == NULL)
+	{
+		munmap(address, size);
+		text_plan_destroy(plan);
+		return -2;
+	}
+
+	// the reverse ranges are parsed after the declared ranges
+	contactsTotal = 0;
+	rangesTotal = 0;
+	for (c = 0; c < count; c++)
+	{
+		chunks[c].firstLine = line;
+		line += chunks[c].lines;
+		chunks[c].contacts = plan->contacts + contactsTotal;
+		contactsTotal += chunks[c].contactsCount;
+		chunks[c].ranges = plan->ranges + rangesTotal;
+		rangesTotal += chunks[c].rangesCount;
+		chunks[c].pass = 2;
+	}
+	reverseTotal = 0;
+	for (c = 0; c < count; c++)
+	{
+		chunks[c].reverseRanges = plan->ranges + rangesTotal + reverseTotal;
+		reverseTotal += chunks[c].ionRangesCount;
+	}
+
+	run_chunks(chunks, count);
+
+	munmap(address, size);
+
+	for (c = 0; c < count && result == 0; c++)
+	{
+		if (chunks[c].errorLine != 0)
+		{
+			*errorLine = chunks[c].errorLine;
+			result = -3;
+		}
+	}
+	if (result < 0)
+	{
+		text_plan_destroy(plan);
+		return result;
+	}
+
+	plan->contactsCount = contactsTotal;
+
+	// keep the reverse ranges that are not declared
+	qsort(plan->ranges, rangesTotal, sizeof(BinaryPlanRange), compare_ranges_records);
+	reverseKept = 0;
+	for (c = 0; c < count; c++)
+	{
+		for (i = 0; i < chunks[c].reverseRangesCount; i++)
+		{
+			if (!overlaps_declared_range(plan->ranges, rangesTotal, &chunks[c].reverseRanges[i]))
+			{
+				plan->ranges[rangesTotal + reverseKept] = chunks[c].reverseRanges[i];
+				reverseKept++;
+			}
+		}
+	}
+	plan->rangesCount = rangesTotal + reverseKept;
+
+	return 0;
+}
+
+/******************************************************************************
+ *
+ * \par Function Name:
+ *      text_plan_destroy
+ *
+ * \brief  Release the records parsed by text_plan_parse()
+ *
+ *
+ * \par Date Written:
+ *      18/10/26
+ *
+ * \return void
+ *
+ * \param[in,out]  *plan   The records
+ *
+ * \par Revision History:
+ *
+ *  DD/MM/YY |  AUTHOR         |   DESCRIPTION
+ *  -------- | --------------- | -----------------------------------------------
+ *  18/10/26 | agent           |  Initial Implementation and documentation.
+ *****************************************************************************/
+void text_plan_destroy(TextPlan *plan)
+{
+	if (plan->contacts != NULL)
+	{
+		MDEPOSIT(plan->contacts);
+	}
+	if (plan->ranges != NULL)
+	{
+		MDEPOSIT(plan->ranges);
+	}
+	memset(plan, 0, sizeof(TextPlan));
+}
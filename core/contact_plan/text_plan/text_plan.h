@@ -0,0 +1,76 @@
+/** \file text_plan.h
+ *
+ * \brief  This file provides the declarations of the functions
+ *         to parse a contact plan text file.
+ *
+ * \details Accepted lines (they can be mixed in the same file):
+ *          - CSV: "CONTACT,from,to,start,end,xmit_rate,confidence,mtv_bulk,mtv_normal,mtv_expedited"
+ *          - CSV: "RANGE,from,to,start,end[,owlt]" (owlt 0 if missing)
+ *          - ionadmin: "a contact <start> <end> <from> <to> <xmit_rate> [confidence]"
+ *          - ionadmin: "a range <start> <end> <from> <to> <owlt>"
+ *
+ *          CSV times are seconds relative to the time offset; ionadmin times are
+ *          "+seconds" (relative to the time offset) or "yyyy/mm/dd-hh:mm:ss" (UTC).
+ *          As in ION, an ionadmin range is symmetric: the reverse range is
+ *          added too, unless the file declares a range in the reverse direction
+ *          at the same time.
+ *          Empty lines, comments ('#') and any other line are ignored.
+ *
+ *
+ ** \copyright Copyright (c) 2020, Alma Mater Studiorum, University of Bologna, All rights reserved.
+ **
+ ** \par License
+ **
+ **    This file is part of Unibo-CGR.                                            <br>
+ **                                                                               <br>
+ **    Unibo-CGR is free software: you can redistribute it and/or modify
+ **    it under the terms of the GNU General Public License as published by
+ **    the Free Software Foundation, either version 3 of the License, or
+ **    (at your option) any later version.                                        <br>
+ **    Unibo-CGR is distributed in the hope that it will be useful,
+ **    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ **    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ **    GNU General Public License for more details.                               <br>
+ **                                                                               <br>
+ **    You should have received a copy of the GNU General Public License
+ **    along with Unibo-CGR.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  \author agent, agent@local
+ *
+ *  \par Supervisor
+ *       Carlo Caini, carlo.caini@unibo.it
+ */
+
+#ifndef SOURCES_CONTACTS_PLAN_TEXT_PLAN_TEXT_PLAN_H_
+#define SOURCES_CONTACTS_PLAN_TEXT_PLAN_TEXT_PLAN_H_
+
+#include <sys/time.h>
+
+#include "../../library/commonDefines.h"
+#include "../binary_plan/binary_plan.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/**
+ * \brief The records parsed from a contact plan text file,
+ *        in the same format of the binary contact plan.
+ */
+typedef struct
+{
+	BinaryPlanContact *contacts;
+	uint64_t contactsCount;
+	BinaryPlanRange *ranges;
+	uint64_t rangesCount;
+} TextPlan;
+
+extern int text_plan_parse(const char *fileName, time_t timeOffset, uint32_t threads, TextPlan *plan, uint64_t *errorLine);
+extern void text_plan_destroy(TextPlan *plan);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SOURCES_CONTACTS_PLAN_TEXT_PLAN_TEXT_PLAN_H_ */
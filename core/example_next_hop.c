@@ -7,15 +7,12 @@
 #include <stdlib.h>
 #include <string.h>
 #include <errno.h>
-#include <ctype.h>
 #include <inttypes.h>
 #include <time.h>
 #include <stdbool.h>
 
 #include "../include/UniboCGR.h"
 
-#define LINE_MAX 1000
-
 // Minimun callback for backlog (UniboCGR_open needs a callback)
 static int my_compute_applicable_backlog(uint64_t neighbor,
                                          UniboCGR_BundlePriority priority,
@@ -59,132 +56,51 @@ static void print_all_contacts(UniboCGR cgr) {
 }
 
 static int load_contact_plan_from_file(UniboCGR cgr, const char *filename, time_t now) {
-    FILE *f = fopen(filename, "r");
-    if (!f) {
+    uint64_t error_line = 0;
+    UniboCGR_Error rc = UniboCGR_contact_plan_load_text(cgr, filename, now, true, 0, &error_line);
+    if (rc == UniboCGR_ErrorMalformedFile) {
+        fprintf(stderr, "Parse error in %s:%" PRIu64 "\n", filename, error_line);
+        return -2;
+    } else if (rc == UniboCGR_ErrorCannotOpenFile) {
         fprintf(stderr, "Cannot open contact plan file '%s': %s\n", filename, strerror(errno));
         return -1;
+    } else if (rc != UniboCGR_NoError) {
+        fprintf(stderr, "Failed to load contact plan file '%s': %s\n", filename, UniboCGR_get_error_string(rc));
+        return -2;
     }
 
-    char line[LINE_MAX];
-    int lineno = 0;
-    while (fgets(line, sizeof(line), f) != NULL) {
-        lineno++;
-        size_t l = strlen(line);
-        while (l > 0 && (line[l-1] == '\n' || line[l-1] == '\r' || line[l-1] == ' ' || line[l-1] == '\t')) {
-            line[--l] = '\0';
-        }
-        char *p = line;
-        while (*p && isspace((unsigned char)*p)) p++;
-        if (*p == '\0' || *p == '#') continue;
-
-        char *save = NULL;
-        char *token = strtok_r(p, ",", &save);
-        if (!token) continue;
-
-        if (strcmp(token, "CONTACT") == 0) {
-            char *s_from = strtok_r(NULL, ",", &save);
-            char *s_to = strtok_r(NULL, ",", &save);
-            char *s_start = strtok_r(NULL, ",", &save);
-            char *s_end = strtok_r(NULL, ",", &save);
-            char *s_xmit = strtok_r(NULL, ",", &save);
-            char *s_conf = strtok_r(NULL, ",", &save);
-            char *s_mtv_bulk = strtok_r(NULL, ",", &save);
-            char *s_mtv_normal = strtok_r(NULL, ",", &save);
-            char *s_mtv_expedited = strtok_r(NULL, ",", &save);
-
-            if (!s_from || !s_to || !s_start || !s_end || !s_xmit || !s_conf || !s_mtv_bulk || !s_mtv_normal || !s_mtv_expedited) {
-                fprintf(stderr, "Parse error in %s:%d (CONTACT) -> not enough fields\n", filename, lineno);
-                fclose(f);
-                return -2;
-            }
-
-            uint64_t from = strtoull(s_from, NULL, 10);
-            uint64_t to = strtoull(s_to, NULL, 10);
-            long start = strtol(s_start, NULL, 10);
-            long end = strtol(s_end, NULL, 10);
-            uint64_t xmit = strtoull(s_xmit, NULL, 10);
-            float conf = strtof(s_conf, NULL);
-            double mtv_bulk = strtod(s_mtv_bulk, NULL);
-            double mtv_normal = strtod(s_mtv_normal, NULL);
-            double mtv_expedited = strtod(s_mtv_expedited, NULL);
-
-            UniboCGR_Contact c;
-            UniboCGR_Error rc = UniboCGR_Contact_create(&c);
-            if (rc != UniboCGR_NoError) {
-                fprintf(stderr, "Failed to create contact object (line %d)\n", lineno);
-                fclose(f);
-                return -2;
-            }
-            UniboCGR_Contact_set_sender(c, from);
-            UniboCGR_Contact_set_receiver(c, to);
-            UniboCGR_Contact_set_start_time(cgr, c, (time_t)start + now);
-            UniboCGR_Contact_set_end_time(cgr, c, (time_t)end + now);
-            UniboCGR_Contact_set_xmit_rate(c, (int)xmit);
-            UniboCGR_Contact_set_confidence(c, conf);
-            UniboCGR_Contact_set_mtv_bulk(c, mtv_bulk);
-            UniboCGR_Contact_set_mtv_normal(c, mtv_normal);
-            UniboCGR_Contact_set_mtv_expedited(c, mtv_expedited);
-
-            rc = UniboCGR_contact_plan_add_contact(cgr, c, true);
-            if (rc != UniboCGR_NoError) {
-                fprintf(stderr, "Failed to add contact (line %d): %s\n", lineno, UniboCGR_get_error_string(rc));
-                UniboCGR_Contact_destroy(&c);
-                fclose(f);
-                return -2;
-            }
-            UniboCGR_Contact_destroy(&c);
-
-        } else if (strcmp(token, "RANGE") == 0) {
-            char *s_from = strtok_r(NULL, ",", &save);
-            char *s_to = strtok_r(NULL, ",", &save);
-            char *s_start = strtok_r(NULL, ",", &save);
-            char *s_end = strtok_r(NULL, ",", &save);
-
-            if (!s_from || !s_to || !s_start || !s_end) {
-                fprintf(stderr, "Parse error in %s:%d (RANGE) -> not enough fields\n", filename, lineno);
-                fclose(f);
-                return -2;
-            }
-
-            uint64_t from = strtoull(s_from, NULL, 10);
-            uint64_t to = strtoull(s_to, NULL, 10);
-            long start = strtol(s_start, NULL, 10);
-            long end = strtol(s_end, NULL, 10);
-
-            UniboCGR_Range r;
-            UniboCGR_Error rc = UniboCGR_Range_create(&r);
-            if (rc != UniboCGR_NoError) {
-                fprintf(stderr, "Failed to create range object (line %d)\n", lineno);
-                fclose(f);
-                return -2;
-            }
-            UniboCGR_Range_set_sender(r, from);
-            UniboCGR_Range_set_receiver(r, to);
-            UniboCGR_Range_set_start_time(cgr, r, (time_t)start + now);
-            UniboCGR_Range_set_end_time(cgr, r, (time_t)end + now);
-            
-            rc = UniboCGR_contact_plan_add_range(cgr, r);
-
-            if (rc != UniboCGR_NoError) {
-                fprintf(stderr, "Failed to add range (line %d): %s\n", lineno, UniboCGR_get_error_string(rc));
-                UniboCGR_Range_destroy(&r);
-                fclose(f);
-                return -2;
-            }
-            UniboCGR_Range_destroy(&r);
-
-        } else {
-            fprintf(stderr, "Unknown record type '%s' in %s:%d -> ignored\n", token, filename, lineno);
-            continue;
-        }
+    return 0;
+}
+
+// text -> binary contact plan
+static int convert_contact_plan_file(const char *text_filename, const char *binary_filename) {
+    uint64_t error_line = 0;
+    UniboCGR_Error rc = UniboCGR_contact_plan_convert_text_to_binary(text_filename, binary_filename, 0, 0, &error_line);
+    if (rc == UniboCGR_ErrorMalformedFile) {
+        fprintf(stderr, "Parse error in %s:%" PRIu64 "\n", text_filename, error_line);
+        return -2;
+    } else if (rc != UniboCGR_NoError) {
+        fprintf(stderr, "Cannot convert '%s' to '%s': %s\n", text_filename, binary_filename, UniboCGR_get_error_string(rc));
+        return -2;
     }
 
-    fclose(f);
     return 0;
 }
 
-int main(void)
+static bool is_binary_contact_plan(const char *filename) {
+    size_t l = strlen(filename);
+    return l > 4 && strcmp(filename + l - 4, ".bin") == 0;
+}
+
+// usage: example_next_hop [contact_plan.txt | contact_plan.bin]
+//        example_next_hop --convert contact_plan.txt contact_plan.bin
+int main(int argc, char **argv)
 {
+    if (argc == 4 && strcmp(argv[1], "--convert") == 0) {
+        return (convert_contact_plan_file(argv[2], argv[3]) == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+    const char *contact_plan_file = (argc > 1) ? argv[1] : "contact_plan.txt";
+
     time_t now = time(NULL);
     time_t reference_time = 0; //current_time = now - reference_time -> 0
     uint64_t local_node = 1;
@@ -198,9 +114,16 @@ int main(void)
     rc = UniboCGR_contact_plan_open(cgr, now);
     check_and_exit_if_error(rc, "UniboCGR_contact_plan_open");
 
-    int err = load_contact_plan_from_file(cgr, "contact_plan.txt", now);
-    if (err != 0) {
-        fprintf(stderr, "Failed to load contact plan file (err=%d)\n", err);
+    if (is_binary_contact_plan(contact_plan_file)) {
+        rc = UniboCGR_contact_plan_load_binary(cgr, contact_plan_file, now, true);
+        if (rc != UniboCGR_NoError) {
+            fprintf(stderr, "Failed to load binary contact plan file: %s\n", UniboCGR_get_error_string(rc));
+        }
+    } else {
+        int err = load_contact_plan_from_file(cgr, contact_plan_file, now);
+        if (err != 0) {
+            fprintf(stderr, "Failed to load contact plan file (err=%d)\n", err);
+        }
     }
 
     rc = UniboCGR_contact_plan_close(cgr);
@@ -0,0 +1,360 @@
+/** \file heap.c
+ *
+ *  \brief  Implementation of a binary min-heap used to keep track
+ *          of the expiration times of the contact plan's elements.
+ *
+ ** \copyright Copyright (c) 2020, Alma Mater Studiorum, University of Bologna, All rights reserved.
+ **
+ ** \par License
+ **
+ **    This file is part of Unibo-CGR.                                            <br>
+ **                                                                               <br>
+ **    Unibo-CGR is free software: you can redistribute it and/or modify
+ **    it under the terms of the GNU General Public License as published by
+ **    the Free Software Foundation, either version 3 of the License, or
+ **    (at your option) any later version.                                        <br>
+ **    Unibo-CGR is distributed in the hope that it will be useful,
+ **    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ **    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ **    GNU General Public License for more details.                               <br>
+ **                                                                               <br>
+ **    You should have received a copy of the GNU General Public License
+ **    along with Unibo-CGR.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  \author agent, agent@local
+ *
+ *  \par Supervisor
+ *       Carlo Caini, carlo.caini@unibo.it
+ */
+
+#include "heap.h"
+#include "../../UniboCGRSAP.h"
+
+#define HEAP_MIN_CAPACITY 64
+
+/******************************************************************************
+ *
+ * \par Function Name:
+ *      heap_init
+ *
+ * \brief Initialize an empty heap (no memory allocated)
+ *
+ *
+ * \par Date Written:
+ *      18/10/26
+ *
+ * \return void
+ *
+ * \param[out]  *heap   The heap to initialize
+ *
+ * \par Revision History:
+ *
+ *  DD/MM/YY |  AUTHOR         |   DESCRIPTION
+ *  -------- | --------------- | -----------------------------------------------
+ *  18/10/26 | agent           |  Initial Implementation and documentation.
+ *****************************************************************************/
+void heap_init(Heap *heap)
+{
+	heap->entries = NULL;
+	heap->length = 0;
+	heap->capacity = 0;
+}
+
+/******************************************************************************
+ *
+ * \par Function Name:
+ *      heap_reserve
+ *
+ * \brief Make room for at least "capacity" entries
+ *
+ *
+ * \par Date Written:
+ *      18/10/26
+ *
+ * \return int
+ *
+ * \retval   0  Success case
+ * \retval  -2  MWITHDRAW error (the heap is left unchanged)
+ *
+ * \param[in,out]  *heap      The heap
+ * \param[in]      capacity   The number of entries the heap must be able to hold
+ *
+ * \par Revision History:
+ *
+ *  DD/MM/YY |  AUTHOR         |   DESCRIPTION
+ *  -------- | --------------- | -----------------------------------------------
+ *  18/10/26 | agent           |  Initial Implementation and documentation.
+ *****************************************************************************/
+int heap_reserve(Heap *heap, uint32_t capacity)
+{
+	HeapEntry *entries;
+	uint32_t newCapacity;
+
+	if (capacity <= heap->capacity)
+	{
+		return 0;
+	}
+
+	newCapacity = (heap->capacity < HEAP_MIN_CAPACITY) ? HEAP_MIN_CAPACITY : heap->capacity;
+	while (newCapacity < capacity)
+	{
+		newCapacity *= 2;
+	}
+
+	entries = MWITHDRAW(sizeof(HeapEntry) * newCapacity);
+	if (entries == NULL)
+	{
+		return -2;
+	}
+
+	if (heap->entries != NULL)
+	{
+		memcpy(entries, heap->entries, sizeof(HeapEntry) * heap->length);
+		MDEPOSIT(heap->entries);
+	}
+
+	heap->entries = entries;
+	heap->capacity = newCapacity;
+
+	return 0;
+}
+
+/******************************************************************************
+ *
+ * \par Function Name:
+ *      heap_push
+ *
+ * \brief Insert a new entry in the heap
+ *
+ *
+ * \par Date Written:
+ *      18/10/26
+ *
+ * \return int
+ *
+ * \retval   0  Success case
+ * \retval  -2  MWITHDRAW error
+ *
+ * \param[in,out]  *heap            The heap
+ * \param[in]      expirationTime   The key of the new entry
+ * \param[in]      fromNode         The fromNode of the element that expires
+ * \param[in]      toNode           The toNode of the element that expires
+ * \param[in]      fromTime         The fromTime of the element that expires
+ *
+ * \par Revision History:
+ *
+ *  DD/MM/YY |  AUTHOR         |   DESCRIPTION
+ *  -------- | --------------- | -----------------------------------------------
+ *  18/10/26 | agent           |  Initial Implementation and documentation.
+ *****************************************************************************/
+int heap_push(Heap *heap, time_t expirationTime, uint64_t fromNode, uint64_t toNode, time_t fromTime)
+{
+	uint32_t i, parent;
+	HeapEntry entry;
+
+	if (heap_reserve(heap, heap->length + 1) < 0)
+	{
+		return -2;
+	}
+
+	entry.expirationTime = expirationTime;
+	entry.fromNode = fromNode;
+	entry.toNode = toNode;
+	entry.fromTime = fromTime;
+
+	// sift up
+	i = heap->length;
+	while (i > 0)
+	{
+		parent = (i - 1) / 2;
+		if (heap->entries[parent].expirationTime <= expirationTime)
+		{
+			break;
+		}
+		heap->entries[i] = heap->entries[parent];
+		i = parent;
+	}
+
+	heap->entries[i] = entry;
+	heap->length++;
+
+	return 0;
+}
+
+/******************************************************************************
+ *
+ * \par Function Name:
+ *      heap_top
+ *
+ * \brief Get the entry with the lowest expiration time
+ *
+ *
+ * \par Date Written:
+ *      18/10/26
+ *
+ * \return HeapEntry*
+ *
+ * \retval HeapEntry*  The entry with the lowest expiration time
+ * \retval NULL        The heap is empty
+ *
+ * \param[in]  *heap   The heap
+ *
+ * \par Revision History:
+ *
+ *  DD/MM/YY |  AUTHOR         |   DESCRIPTION
+ *  -------- | --------------- | -----------------------------------------------
+ *  18/10/26 | agent           |  Initial Implementation and documentation.
+ *****************************************************************************/
+HeapEntry* heap_top(Heap *heap)
+{
+	return (heap->length > 0) ? &(heap->entries[0]) : NULL;
+}
+
+/******************************************************************************
+ *
+ * \par Function Name:
+ *      heap_pop
+ *
+ * \brief Remove the entry with the lowest expiration time
+ *
+ *
+ * \par Date Written:
+ *      18/10/26
+ *
+ * \return void
+ *
+ * \param[in,out]  *heap   The heap
+ *
+ * \par Revision History:
+ *
+ *  DD/MM/YY |  AUTHOR         |   DESCRIPTION
+ *  -------- | --------------- | -----------------------------------------------
+ *  18/10/26 | agent           |  Initial Implementation and documentation.
+ *****************************************************************************/
+void heap_pop(Heap *heap)
+{
+	uint32_t i, child;
+	HeapEntry last;
+
+	if (heap->length == 0)
+	{
+		return;
+	}
+
+	heap->length--;
+	last = heap->entries[heap->length];
+
+	// sift down
+	i = 0;
+	while ((child = 2 * i + 1) < heap->length)
+	{
+		if (child + 1 < heap->length
+				&& heap->entries[child + 1].expirationTime < heap->entries[child].expirationTime)
+		{
+			child++;
+		}
+		if (last.expirationTime <= heap->entries[child].expirationTime)
+		{
+			break;
+		}
+		heap->entries[i] = heap->entries[child];
+		i = child;
+	}
+
+	if (heap->length > 0)
+	{
+		heap->entries[i] = last;
+	}
+}
+
+/******************************************************************************
+ *
+ * \par Function Name:
+ *      heap_shift_times
+ *
+ * \brief Subtract "diff" from the times of every entry
+ *
+ *
+ * \par Date Written:
+ *      18/10/26
+ *
+ * \return void
+ *
+ * \param[in,out]  *heap   The heap
+ * \param[in]      diff    The value subtracted from expirationTime and fromTime
+ *
+ * \par Notes:
+ *          1.  All the keys are shifted by the same value, so the heap property holds.
+ *
+ * \par Revision History:
+ *
+ *  DD/MM/YY |  AUTHOR         |   DESCRIPTION
+ *  -------- | --------------- | -----------------------------------------------
+ *  18/10/26 | agent           |  Initial Implementation and documentation.
+ *****************************************************************************/
+void heap_shift_times(Heap *heap, time_t diff)
+{
+	uint32_t i;
+
+	for (i = 0; i < heap->length; i++)
+	{
+		heap->entries[i].expirationTime -= diff;
+		heap->entries[i].fromTime -= diff;
+	}
+}
+
+/******************************************************************************
+ *
+ * \par Function Name:
+ *      heap_clear
+ *
+ * \brief Remove all the entries from the heap, but keep the allocated memory
+ *
+ *
+ * \par Date Written:
+ *      18/10/26
+ *
+ * \return void
+ *
+ * \param[in,out]  *heap   The heap
+ *
+ * \par Revision History:
+ *
+ *  DD/MM/YY |  AUTHOR         |   DESCRIPTION
+ *  -------- | --------------- | -----------------------------------------------
+ *  18/10/26 | agent           |  Initial Implementation and documentation.
+ *****************************************************************************/
+void heap_clear(Heap *heap)
+{
+	heap->length = 0;
+}
+
+/******************************************************************************
+ *
+ * \par Function Name:
+ *      heap_destroy
+ *
+ * \brief Release the memory of the heap
+ *
+ *
+ * \par Date Written:
+ *      18/10/26
+ *
+ * \return void
+ *
+ * \param[in,out]  *heap   The heap
+ *
+ * \par Revision History:
+ *
+ *  DD/MM/YY |  AUTHOR         |   DESCRIPTION
+ *  -------- | --------------- | -----------------------------------------------
+ *  18/10/26 | agent           |  Initial Implementation and documentation.
+ *****************************************************************************/
+void heap_destroy(Heap *heap)
+{
+	if (heap->entries != NULL)
+	{
+		MDEPOSIT(heap->entries);
+	}
+	heap_init(heap);
+}
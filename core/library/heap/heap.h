@@ -0,0 +1,79 @@
+/** \file heap.h
+ *
+ *  \brief  This file provides the declarations of the expiration heap's functions implemented in heap.c
+ *
+ ** \copyright Copyright (c) 2020, Alma Mater Studiorum, University of Bologna, All rights reserved.
+ **
+ ** \par License
+ **
+ **    This file is part of Unibo-CGR.                                            <br>
+ **                                                                               <br>
+ **    Unibo-CGR is free software: you can redistribute it and/or modify
+ **    it under the terms of the GNU General Public License as published by
+ **    the Free Software Foundation, either version 3 of the License, or
+ **    (at your option) any later version.                                        <br>
+ **    Unibo-CGR is distributed in the hope that it will be useful,
+ **    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ **    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ **    GNU General Public License for more details.                               <br>
+ **                                                                               <br>
+ **    You should have received a copy of the GNU General Public License
+ **    along with Unibo-CGR.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  \author agent, agent@local
+ *
+ *  \par Supervisor
+ *       Carlo Caini, carlo.caini@unibo.it
+ */
+
+#ifndef CGR_HEAP_H
+#define CGR_HEAP_H
+
+#include "../commonDefines.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/**
+ * \brief An element of the expiration heap.
+ *
+ * \details The element is identified by its key {fromNode, toNode, fromTime}
+ *          (the same key used by the contacts and ranges graphs), not by address:
+ *          the owner looks it up when the entry is popped, so entries
+ *          of elements already deleted or revised are simply discarded.
+ */
+typedef struct {
+	/**
+	 * \brief The heap key: the time when the element expires
+	 */
+	time_t expirationTime;
+	uint64_t fromNode;
+	uint64_t toNode;
+	time_t fromTime;
+} HeapEntry;
+
+/**
+ * \brief Binary min-heap ordered by expirationTime.
+ */
+typedef struct {
+	HeapEntry *entries;
+	uint32_t length;
+	uint32_t capacity;
+} Heap;
+
+extern void heap_init(Heap *heap);
+extern int heap_reserve(Heap *heap, uint32_t capacity);
+extern int heap_push(Heap *heap, time_t expirationTime, uint64_t fromNode, uint64_t toNode, time_t fromTime);
+extern HeapEntry* heap_top(Heap *heap);
+extern void heap_pop(Heap *heap);
+extern void heap_shift_times(Heap *heap, time_t diff);
+extern void heap_clear(Heap *heap);
+extern void heap_destroy(Heap *heap);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -28,12 +28,16 @@
 
 #include "list.h"
 #include "../../UniboCGRSAP.h"
+#include "../pool/pool.h"
 
 #include <stdlib.h>
 #include <stdio.h>
 
 static void sort_list_algorithm(List, compare_function);
 static void erase_list(List);
+static void erase_elt(ListElt *elt);
+static ListElt* take_elt(List list);
+static void release_elt(List list, ListElt *elt);
 
 /******************************************************************************
  *
@@ -79,11 +83,176 @@ List list_create(void *userData, delete_function delete_userData, compare_functi
 		new_list->first = NULL;
 		new_list->last = NULL;
 		new_list->length = 0;
+		new_list->eltPool = NULL;
+		new_list->eltArena = NULL;
 	}
 
 	return new_list;
 }
 
+/******************************************************************************
+ *
+ * \par Function Name:
+ *      list_set_elt_pool
+ *
+ * \brief Take the ListElts of the list from a pool instead of MWITHDRAW
+ *
+ *
+ * \par Date Written:
+ *      18/10/26
+ *
+ * \return int
+ *
+ * \retval   0  Success case
+ * \retval  -1  Arguments error (list NULL or not empty)
+ *
+ * \param[in]  list   The list
+ * \param[in]  *pool  The pool of ListElts, it must outlive the list
+ *
+ * \par Revision History:
+ *
+ *  DD/MM/YY |  AUTHOR         |   DESCRIPTION
+ *  -------- | --------------- | -----------------------------------------------
+ *  18/10/26 | agent           |  Initial Implementation and documentation.
+ *****************************************************************************/
+int list_set_elt_pool(List list, Pool *pool)
+{
+	if (list == NULL || list->first != NULL)
+	{
+		return -1;
+	}
+
+	list->eltPool = pool;
+
+	return 0;
+}
+
+/******************************************************************************
+ *
+ * \par Function Name:
+ *      list_set_elt_arena
+ *
+ * \brief Take the ListElts of the list from an arena instead of MWITHDRAW
+ *
+ *
+ * \par Date Written:
+ *      18/10/26
+ *
+ * \return int
+ *
+ * \retval   0  Success case
+ * \retval  -1  Arguments error (list NULL or not empty)
+ *
+ * \param[in]  list    The list
+ * \param[in]  *arena  The arena
+ *
+ * \par Notes:
+ *      1. The list must be emptied before each arena_reset().
+ *      2. Removing an element doesn't release memory, so free_list_elts()
+ *         just forgets the elements, in O(1), if the list has no delete_data_elt.
+ *
+ * \par Revision History:
+ *
+ *  DD/MM/YY |  AUTHOR         |   DESCRIPTION
+ *  -------- | --------------- | -----------------------------------------------
+ *  18/10/26 | agent           |  Initial Implementation and documentation.
+ *****************************************************************************/
+int list_set_elt_arena(List list, Arena *arena)
+{
+	if (list == NULL || list->first != NULL)
+	{
+		return -1;
+	}
+
+	list->eltArena = arena;
+
+	return 0;
+}
+
+/******************************************************************************
+ *
+ * \par Function Name:
+ *      take_elt
+ *
+ * \brief Allocate a ListElt for the list (arena, pool or MWITHDRAW)
+ *
+ *
+ * \par Date Written:
+ *      18/10/26
+ *
+ * \return ListElt*
+ *
+ * \retval ListElt*  The new ListElt (not initialized)
+ * \retval NULL      MWITHDRAW error
+ *
+ * \param[in]  list   The list to which the element will belong
+ *
+ * \par Revision History:
+ *
+ *  DD/MM/YY |  AUTHOR         |   DESCRIPTION
+ *  -------- | --------------- | -----------------------------------------------
+ *  18/10/26 | agent           |  Initial Implementation and documentation.
+ *****************************************************************************/
+static ListElt* take_elt(List list)
+{
+	if (list->eltArena != NULL)
+	{
+		return (ListElt*) arena_take(list->eltArena, sizeof(ListElt));
+	}
+	if (list->eltPool != NULL)
+	{
+		return (ListElt*) pool_take(list->eltPool);
+	}
+
+	return (ListElt*) MWITHDRAW(sizeof(ListElt));
+}
+
+/******************************************************************************
+ *
+ * \par Function Name:
+ *      release_elt
+ *
+ * \brief Erase and deallocate a ListElt of the list (arena, pool or MDEPOSIT)
+ *
+ *
+ * \par Date Written:
+ *      18/10/26
+ *
+ * \return void
+ *
+ * \param[in]  list   The list to which the element belonged, or NULL
+ * \param[in]  *elt   The element
+ *
+ * \par Notes:
+ *      1. The arena's elements are released only by arena_reset().
+ *
+ * \par Revision History:
+ *
+ *  DD/MM/YY |  AUTHOR         |   DESCRIPTION
+ *  -------- | --------------- | -----------------------------------------------
+ *  18/10/26 | agent           |  Initial Implementation and documentation.
+ *****************************************************************************/
+static void release_elt(List list, ListElt *elt)
+{
+	erase_elt(elt);
+
+	if (list == NULL)
+	{
+		MDEPOSIT(elt);
+	}
+	else if (list->eltArena == NULL)
+	{
+		if (list->eltPool != NULL)
+		{
+			pool_release(list->eltPool, elt);
+		}
+		else
+		{
+			MDEPOSIT(elt);
+		}
+	}
+}
+
 /******************************************************************************
  *
  * \par Function Name:
@@ -173,19 +342,21 @@ long unsigned int list_get_length(List list)
  * \return int
  *
  * \retval   0   Success
- * \retval  -1   Parameters not initialized correctly
+ * \retval  -1   Parameters not initialized correctly, or lists with different ListElt allocators
  *
  * \param[in]  *elt		The element we want to move
  * \param[in]	other	The list where we want to move elt
  *
  * \par Notes:
  * 		1. In success case: elt->list == other, other->first == elt
+ * 		2. Both lists must take the ListElts from the same pool (arena), if any.
  *
  * \par Revision History:
  *
  *  DD/MM/YY |  AUTHOR         |   DESCRIPTION
  *  -------- | --------------- | -----------------------------------------------
  *  07/01/20 | L. Persampieri  |  Initial Implementation and documentation.
+ *  18/10/26 | agent           |  Check the ListElt allocators.
  *****************************************************************************/
 int move_elt_to_other_list(ListElt *elt, List other)
 {
@@ -193,7 +364,8 @@ int move_elt_to_other_list(ListElt *elt, List other)
 	ListElt *next_elt, *prev_elt;
 	List eltList;
 	int result = -1;
-	if (elt != NULL && other != NULL && elt->list != NULL)
+	if (elt != NULL && other != NULL && elt->list != NULL
+			&& elt->list->eltPool == other->eltPool && elt->list->eltArena == other->eltArena)
 	{
 		eltList = elt->list;
 		next_elt = elt->next;
@@ -835,20 +1007,19 @@ void free_list_elts(List list)
 				}
 				temp = elt;
 				elt = temp->next;
-				erase_elt(temp);
-				MDEPOSIT(temp);
+				release_elt(list, temp);
 			}
 		}
-		else
+		else if (list->eltArena == NULL)
 		{
 			while (elt != NULL)
 			{
 				temp = elt;
 				elt = elt->next;
-				erase_elt(temp);
-				MDEPOSIT(temp);
+				release_elt(list, temp);
 			}
 		}
+		// else: the arena's elements are released by arena_reset()
 
 		list->first = NULL;
 		list->last = NULL;
@@ -891,7 +1062,7 @@ ListElt* list_insert_first(List list, void *data)
 	ListElt *oldFirst;
 	if (list != NULL && data != NULL)
 	{
-		first = (ListElt*) MWITHDRAW(sizeof(ListElt));
+		first = take_elt(list);
 
 		if (first != NULL)
 		{
@@ -953,7 +1124,7 @@ ListElt* list_insert_last(List list, void *data)
 	if (list != NULL && data != NULL)
 	{
 
-		last = (ListElt*) MWITHDRAW(sizeof(ListElt));
+		last = take_elt(list);
 
 		if (last != NULL)
 		{
@@ -1027,8 +1198,7 @@ void list_remove_first(List list)
 		{
 			list->delete_data_elt(first->data);
 		}
-		erase_elt(first);
-		MDEPOSIT(first);
+		release_elt(list, first);
 	}
 }
 
@@ -1080,8 +1250,7 @@ void list_remove_last(List list)
 			list->delete_data_elt(last->data);
 		}
 
-		erase_elt(last);
-		MDEPOSIT(last);
+		release_elt(list, last);
 	}
 }
 
@@ -1124,7 +1293,7 @@ ListElt* list_insert_before(ListElt *target, void *data)
 
 		if (list != NULL)
 		{
-			elt = (ListElt*) MWITHDRAW(sizeof(ListElt));
+			elt = take_elt(list);
 			if (elt != NULL)
 			{
 				list->length += 1;
@@ -1190,7 +1359,7 @@ ListElt* list_insert_after(ListElt *target, void *data)
 
 		if (list != NULL)
 		{
-			elt = (ListElt*) MWITHDRAW(sizeof(ListElt));
+			elt = take_elt(list);
 			if (elt != NULL)
 			{
 				list->length += 1;
@@ -1276,8 +1445,7 @@ void list_remove_elt(ListElt *elt)
 			}
 		}
 
-		erase_elt(elt);
-		MDEPOSIT(elt);
+		release_elt(list, elt);
 	}
 
 	return;
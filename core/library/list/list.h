@@ -38,6 +38,8 @@ extern "C"
 #endif
 
 extern List list_create(void*, delete_function, compare_function, delete_function);
+extern int list_set_elt_pool(List, struct Pool*);
+extern int list_set_elt_arena(List, struct Arena*);
 extern void sort_list(List);
 
 extern unsigned long int list_get_length(List);
@@ -87,6 +87,14 @@ struct list {
      * \brief The function called to delete the userData of the list
      */
     delete_function delete_userData;
+    /**
+     * \brief The pool of the ListElts, NULL if they are allocated with MWITHDRAW (see list_set_elt_pool())
+     */
+    struct Pool *eltPool;
+    /**
+     * \brief The arena of the ListElts, NULL if not used (see list_set_elt_arena())
+     */
+    struct Arena *eltArena;
 };
 
 #ifdef __cplusplus
@@ -0,0 +1,469 @@
+/** \file pool.c
+ *
+ *  \brief  Implementation of the fixed-size slab pools and of the scratch arenas
+ *          used to reduce the number of calls to the memory allocator.
+ *
+ *  \details Both take their memory in large blocks with MWITHDRAW, so they work on top of
+ *           the allocator set with UniboCGR_setup_memory_allocator() (e.g. ION's MTAKE).
+ *           Neither is thread safe: each Unibo-CGR instance owns its own.
+ *
+ ** \copyright Copyright (c) 2020, Alma Mater Studiorum, University of Bologna, All rights reserved.
+ **
+ ** \par License
+ **
+ **    This file is part of Unibo-CGR.                                            <br>
+ **                                                                               <br>
+ **    Unibo-CGR is free software: you can redistribute it and/or modify
+ **    it under the terms of the GNU General Public License as published by
+ **    the Free Software Foundation, either version 3 of the License, or
+ **    (at your option) any later version.                                        <br>
+ **    Unibo-CGR is distributed in the hope that it will be useful,
+ **    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ **    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ **    GNU General Public License for more details.                               <br>
+ **                                                                               <br>
+ **    You should have received a copy of the GNU General Public License
+ **    along with Unibo-CGR.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  \author agent, agent@local
+ *
+ *  \par Supervisor
+ *       Carlo Caini, carlo.caini@unibo.it
+ */
+
+#include <string.h>
+
+#include "pool.h"
+
+/**
+ * \brief Alignment of the elements and of the arena's allocations.
+ *
+ * \hideinitializer
+ */
+#define POOL_ALIGNMENT 16
+#define align_size(size) ((((size) + POOL_ALIGNMENT - 1) / POOL_ALIGNMENT) * POOL_ALIGNMENT)
+
+/**
+ * \brief A block of memory from which the elements of a Pool (or the allocations of an Arena) are carved.
+ */
+typedef struct PoolBlock {
+	/**
+	 * \brief The next block (Pool: the previous one allocated)
+	 */
+	struct PoolBlock *next;
+	/**
+	 * \brief The usable size of the block (bytes)
+	 */
+	size_t size;
+} PoolBlock;
+
+#define BLOCK_HEADER_SIZE align_size(sizeof(PoolBlock))
+#define block_memory(block) (((char*) (block)) + BLOCK_HEADER_SIZE)
+
+/**
+ * \brief Released element of a Pool, waiting to be taken again.
+ */
+typedef struct PoolFreeElement {
+	struct PoolFreeElement *next;
+} PoolFreeElement;
+
+struct Pool {
+	/**
+	 * \brief The size of each element, rounded up to POOL_ALIGNMENT
+	 */
+	size_t elementSize;
+	/**
+	 * \brief Number of elements of each slab
+	 */
+	uint32_t slabElements;
+	/**
+	 * \brief The slabs, the last allocated first
+	 */
+	PoolBlock *slabs;
+	/**
+	 * \brief Number of elements of the last slab never taken
+	 */
+	uint32_t untouched;
+	/**
+	 * \brief The released elements, the last released first
+	 */
+	PoolFreeElement *released;
+};
+
+struct Arena {
+	/**
+	 * \brief The minimum size of each chunk
+	 */
+	size_t chunkSize;
+	/**
+	 * \brief The chunks, in allocation order
+	 */
+	PoolBlock *chunks;
+	/**
+	 * \brief The chunk in use (NULL if no chunk has been allocated yet)
+	 */
+	PoolBlock *current;
+	/**
+	 * \brief Bytes already taken from the current chunk
+	 */
+	size_t offset;
+};
+
+/******************************************************************************
+ *
+ * \par Function Name:
+ *      pool_create
+ *
+ * \brief Allocate a pool of elements of fixed size
+ *
+ *
+ * \par Date Written:
+ *      18/10/26
+ *
+ * \return Pool*
+ *
+ * \retval Pool*  The new pool (no slab allocated yet)
+ * \retval NULL   MWITHDRAW error
+ *
+ * \param[in]  elementSize    The size of each element
+ * \param[in]  slabElements   The number of elements allocated with each MWITHDRAW
+ *
+ * \par Revision History:
+ *
+ *  DD/MM/YY |  AUTHOR         |   DESCRIPTION
+ *  -------- | --------------- | -----------------------------------------------
+ *  18/10/26 | agent           |  Initial Implementation and documentation.
+ *****************************************************************************/
+Pool* pool_create(size_t elementSize, uint32_t slabElements)
+{
+	Pool *pool = (Pool*) MWITHDRAW(sizeof(Pool));
+
+	if (pool != NULL)
+	{
+		if (elementSize < sizeof(PoolFreeElement))
+		{
+			elementSize = sizeof(PoolFreeElement);
+		}
+		pool->elementSize = align_size(elementSize);
+		pool->slabElements = (slabElements > 0) ? slabElements : 1;
+		pool->slabs = NULL;
+		pool->untouched = 0;
+		pool->released = NULL;
+	}
+
+	return pool;
+}
+
+/******************************************************************************
+ *
+ * \par Function Name:
+ *      pool_take
+ *
+ * \brief Get an element from the pool
+ *
+ *
+ * \par Date Written:
+ *      18/10/26
+ *
+ * \return void*
+ *
+ * \retval void*  The element (not initialized)
+ * \retval NULL   MWITHDRAW error
+ *
+ * \param[in]  *pool   The pool
+ *
+ * \par Notes:
+ *      1. The last released element is taken first (it is likely still in cache).
+ *      2. A new slab is allocated only when no element is left.
+ *
+ * \par Revision History:
+ *
+ *  DD/MM/YY |  AUTHOR         |   DESCRIPTION
+ *  -------- | --------------- | -----------------------------------------------
+ *  18/10/26 | agent           |  Initial Implementation and documentation.
+ *****************************************************************************/
+void* pool_take(Pool *pool)
+{
+	PoolFreeElement *element;
+	PoolBlock *slab;
+
+	if (pool->released != NULL)
+	{
+		element = pool->released;
+		pool->released = element->next;
+		return element;
+	}
+
+	if (pool->untouched == 0)
+	{
+		slab = (PoolBlock*) MWITHDRAW(BLOCK_HEADER_SIZE + pool->elementSize * pool->slabElements);
+		if (slab == NULL)
+		{
+			return NULL;
+		}
+		slab->size = pool->elementSize * pool->slabElements;
+		slab->next = pool->slabs;
+		pool->slabs = slab;
+		pool->untouched = pool->slabElements;
+	}
+
+	pool->untouched--;
+	return block_memory(pool->slabs) + pool->slabs->size - (pool->untouched + 1) * pool->elementSize;
+}
+
+/******************************************************************************
+ *
+ * \par Function Name:
+ *      pool_release
+ *
+ * \brief Give back an element to the pool
+ *
+ *
+ * \par Date Written:
+ *      18/10/26
+ *
+ * \return void
+ *
+ * \param[in]  *pool      The pool
+ * \param[in]  *element   The element, previously taken from the same pool
+ *
+ * \par Notes:
+ *      1. The memory goes back to the allocator only with pool_destroy().
+ *
+ * \par Revision History:
+ *
+ *  DD/MM/YY |  AUTHOR         |   DESCRIPTION
+ *  -------- | --------------- | -----------------------------------------------
+ *  18/10/26 | agent           |  Initial Implementation and documentation.
+ *****************************************************************************/
+void pool_release(Pool *pool, void *element)
+{
+	PoolFreeElement *released;
+
+	if (element != NULL)
+	{
+		released = (PoolFreeElement*) element;
+		released->next = pool->released;
+		pool->released = released;
+	}
+}
+
+/******************************************************************************
+ *
+ * \par Function Name:
+ *      pool_destroy
+ *
+ * \brief Deallocate the pool and all its slabs
+ *
+ *
+ * \par Date Written:
+ *      18/10/26
+ *
+ * \return void
+ *
+ * \param[in]  *pool   The pool
+ *
+ * \par Notes:
+ *      1. Every element taken from the pool becomes invalid.
+ *
+ * \par Revision History:
+ *
+ *  DD/MM/YY |  AUTHOR         |   DESCRIPTION
+ *  -------- | --------------- | -----------------------------------------------
+ *  18/10/26 | agent           |  Initial Implementation and documentation.
+ *****************************************************************************/
+void pool_destroy(Pool *pool)
+{
+	PoolBlock *slab, *next;
+
+	if (pool != NULL)
+	{
+		for (slab = pool->slabs; slab != NULL; slab = next)
+		{
+			next = slab->next;
+			MDEPOSIT(slab);
+		}
+		memset(pool, 0, sizeof(Pool));
+		MDEPOSIT(pool);
+	}
+}
+
+/******************************************************************************
+ *
+ * \par Function Name:
+ *      arena_create
+ *
+ * \brief Allocate an arena: a bump allocator released all at once
+ *
+ *
+ * \par Date Written:
+ *      18/10/26
+ *
+ * \return Arena*
+ *
+ * \retval Arena*  The new arena (no chunk allocated yet)
+ * \retval NULL    MWITHDRAW error
+ *
+ * \param[in]  chunkSize   The minimum size of each chunk allocated with MWITHDRAW
+ *
+ * \par Revision History:
+ *
+ *  DD/MM/YY |  AUTHOR         |   DESCRIPTION
+ *  -------- | --------------- | -----------------------------------------------
+ *  18/10/26 | agent           |  Initial Implementation and documentation.
+ *****************************************************************************/
+Arena* arena_create(size_t chunkSize)
+{
+	Arena *arena = (Arena*) MWITHDRAW(sizeof(Arena));
+
+	if (arena != NULL)
+	{
+		arena->chunkSize = align_size(chunkSize > 0 ? chunkSize : 1);
+		arena->chunks = NULL;
+		arena->current = NULL;
+		arena->offset = 0;
+	}
+
+	return arena;
+}
+
+/******************************************************************************
+ *
+ * \par Function Name:
+ *      arena_take
+ *
+ * \brief Get a memory area from the arena
+ *
+ *
+ * \par Date Written:
+ *      18/10/26
+ *
+ * \return void*
+ *
+ * \retval void*  The memory area (not initialized)
+ * \retval NULL   MWITHDRAW error
+ *
+ * \param[in]  *arena   The arena
+ * \param[in]  size     The size of the memory area
+ *
+ * \par Notes:
+ *      1. There is no way to release a single memory area: all of them are released by arena_reset().
+ *      2. The chunks kept by arena_reset() are used before allocating a new one.
+ *
+ * \par Revision History:
+ *
+ *  DD/MM/YY |  AUTHOR         |   DESCRIPTION
+ *  -------- | --------------- | -----------------------------------------------
+ *  18/10/26 | agent           |  Initial Implementation and documentation.
+ *****************************************************************************/
+void* arena_take(Arena *arena, size_t size)
+{
+	PoolBlock *chunk;
+	void *result;
+
+	size = align_size(size > 0 ? size : 1);
+
+	while (arena->current == NULL || arena->offset + size > arena->current->size)
+	{
+		if (arena->current != NULL && arena->current->next != NULL)
+		{
+			arena->current = arena->current->next;
+		}
+		else
+		{
+			chunk = (PoolBlock*) MWITHDRAW(BLOCK_HEADER_SIZE + (size > arena->chunkSize ? size : arena->chunkSize));
+			if (chunk == NULL)
+			{
+				return NULL;
+			}
+			chunk->size = (size > arena->chunkSize ? size : arena->chunkSize);
+			chunk->next = NULL;
+			if (arena->current == NULL)
+			{
+				arena->chunks = chunk;
+			}
+			else
+			{
+				arena->current->next = chunk;
+			}
+			arena->current = chunk;
+		}
+		arena->offset = 0;
+	}
+
+	result = block_memory(arena->current) + arena->offset;
+	arena->offset += size;
+
+	return result;
+}
+
+/******************************************************************************
+ *
+ * \par Function Name:
+ *      arena_reset
+ *
+ * \brief Release all the memory areas taken from the arena, in O(1)
+ *
+ *
+ * \par Date Written:
+ *      18/10/26
+ *
+ * \return void
+ *
+ * \param[in]  *arena   The arena
+ *
+ * \par Notes:
+ *      1. The chunks are kept (and reused) until arena_destroy().
+ *      2. Every memory area taken from the arena becomes invalid.
+ *
+ * \par Revision History:
+ *
+ *  DD/MM/YY |  AUTHOR         |   DESCRIPTION
+ *  -------- | --------------- | -----------------------------------------------
+ *  18/10/26 | agent           |  Initial Implementation and documentation.
+ *****************************************************************************/
+void arena_reset(Arena *arena)
+{
+	if (arena != NULL)
+	{
+		arena->current = arena->chunks;
+		arena->offset = 0;
+	}
+}
+
+/******************************************************************************
+ *
+ * \par Function Name:
+ *      arena_destroy
+ *
+ * \brief Deallocate the arena and all its chunks
+ *
+ *
+ * \par Date Written:
+ *      18/10/26
+ *
+ * \return void
+ *
+ * \param[in]  *arena   The arena
+ *
+ * \par Revision History:
+ *
+ *  DD/MM/YY |  AUTHOR         |   DESCRIPTION
+ *  -------- | --------------- | -----------------------------------------------
+ *  18/10/26 | agent           |  Initial Implementation and documentation.
+ *****************************************************************************/
+void arena_destroy(Arena *arena)
+{
+	PoolBlock *chunk, *next;
+
+	if (arena != NULL)
+	{
+		for (chunk = arena->chunks; chunk != NULL; chunk = next)
+		{
+			next = chunk->next;
+			MDEPOSIT(chunk);
+		}
+		memset(arena, 0, sizeof(Arena));
+		MDEPOSIT(arena);
+	}
+}
@@ -0,0 +1,57 @@
+/** \file pool.h
+ *
+ *  \brief  This file provides the declarations of the slab pool's and scratch arena's
+ *          functions implemented in pool.c
+ *
+ ** \copyright Copyright (c) 2020, Alma Mater Studiorum, University of Bologna, All rights reserved.
+ **
+ ** \par License
+ **
+ **    This file is part of Unibo-CGR.                                            <br>
+ **                                                                               <br>
+ **    Unibo-CGR is free software: you can redistribute it and/or modify
+ **    it under the terms of the GNU General Public License as published by
+ **    the Free Software Foundation, either version 3 of the License, or
+ **    (at your option) any later version.                                        <br>
+ **    Unibo-CGR is distributed in the hope that it will be useful,
+ **    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ **    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ **    GNU General Public License for more details.                               <br>
+ **                                                                               <br>
+ **    You should have received a copy of the GNU General Public License
+ **    along with Unibo-CGR.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  \author agent, agent@local
+ *
+ *  \par Supervisor
+ *       Carlo Caini, carlo.caini@unibo.it
+ */
+
+#ifndef CGR_POOL_H
+#define CGR_POOL_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "../../UniboCGRSAP.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+extern Pool* pool_create(size_t elementSize, uint32_t slabElements);
+extern void* pool_take(Pool *pool);
+extern void pool_release(Pool *pool, void *element);
+extern void pool_destroy(Pool *pool);
+
+extern Arena* arena_create(size_t chunkSize);
+extern void* arena_take(Arena *arena, size_t size);
+extern void arena_reset(Arena *arena);
+extern void arena_destroy(Arena *arena);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -38,6 +38,7 @@
 
 #include "rbt.h"
 #include "../../UniboCGRSAP.h"
+#include "../../library/pool/pool.h"
 
 #include <stdlib.h>
 
@@ -182,11 +183,120 @@ Rbt* rbt_create(RbtDeleteFn deleteFn, RbtCompareFn compareFn)
 		eraseTree(rbt);
 		rbt->deleteFn = deleteFn;
 		rbt->compareFn = compareFn;
+		rbt->nodePool = NULL;
 	}
 
 	return rbt;
 }
 
+/******************************************************************************
+ *
+ * \par Function Name:
+ *      rbt_set_node_pool
+ *
+ * \brief Take the RbtNodes of the tree from a pool instead of MWITHDRAW
+ *
+ *
+ * \par Date Written:
+ *      18/10/26
+ *
+ * \return int
+ *
+ * \retval   0  Success case
+ * \retval  -1  Arguments error (rbt NULL or not empty)
+ *
+ * \param[in]  *rbt    The tree
+ * \param[in]  *pool   The pool of RbtNodes, it must outlive the tree
+ *
+ * \par Revision History:
+ *
+ *  DD/MM/YY | AUTHOR          |  DESCRIPTION
+ *  -------- | --------------- | -----------------------------------------------
+ *  18/10/26 | agent           |  Initial Implementation and documentation.
+ *******************************************************************************/
+int rbt_set_node_pool(Rbt *rbt, Pool *pool)
+{
+	if (rbt == NULL || rbt->root != NULL)
+	{
+		return -1;
+	}
+
+	rbt->nodePool = pool;
+
+	return 0;
+}
+
+/******************************************************************************
+ *
+ * \par Function Name:
+ *      takeNode
+ *
+ * \brief Allocate an RbtNode for the tree (pool or MWITHDRAW)
+ *
+ *
+ * \par Date Written:
+ *      18/10/26
+ *
+ * \return RbtNode*
+ *
+ * \retval RbtNode*  The new RbtNode (not initialized)
+ * \retval NULL      MWITHDRAW error
+ *
+ * \param[in]  *rbt   The tree to which the node will belong
+ *
+ * \par Revision History:
+ *
+ *  DD/MM/YY | AUTHOR          |  DESCRIPTION
+ *  -------- | --------------- | -----------------------------------------------
+ *  18/10/26 | agent           |  Initial Implementation and documentation.
+ *******************************************************************************/
+static RbtNode* takeNode(Rbt *rbt)
+{
+	if (rbt->nodePool != NULL)
+	{
+		return (RbtNode*) pool_take(rbt->nodePool);
+	}
+
+	return (RbtNode*) MWITHDRAW(sizeof(RbtNode));
+}
+
+/******************************************************************************
+ *
+ * \par Function Name:
+ *      releaseNode
+ *
+ * \brief Erase and deallocate an RbtNode of the tree (pool or MDEPOSIT)
+ *
+ *
+ * \par Date Written:
+ *      18/10/26
+ *
+ * \return void
+ *
+ * \param[in]  *rbt    The tree to which the node belonged
+ * \param[in]  *node   The node
+ *
+ * \par Revision History:
+ *
+ *  DD/MM/YY | AUTHOR          |  DESCRIPTION
+ *  -------- | --------------- | -----------------------------------------------
+ *  18/10/26 | agent           |  Initial Implementation and documentation.
+ *******************************************************************************/
+static void releaseNode(Rbt *rbt, RbtNode *node)
+{
+	/*	just in case user mistakenly accesses later...	*/
+	eraseTreeNode(node);
+
+	if (rbt->nodePool != NULL)
+	{
+		pool_release(rbt->nodePool, node);
+	}
+	else
+	{
+		MDEPOSIT(node);
+	}
+}
+
 /******************************************************************************
  *
  * \par Function Name:
@@ -246,9 +356,7 @@ static void destroyRbtNodes(Rbt *rbtPtr, RbtDeleteFn deleteFn)
 			deleteFn(nodePtr->data);
 		}
 
-		/*	just in case user mistakenly accesses later...	*/
-		eraseTreeNode(nodePtr);
-		MDEPOSIT(nodePtr);
+		releaseNode(rbtPtr, nodePtr);
 
 		/*	Now pop back up to this node's parent.		*/
 
@@ -308,6 +416,176 @@ void rbt_clear(Rbt *rbt)
 	}
 }
 
+/******************************************************************************
+ *
+ * \par Function Name:
+ *      freeSubtreeNodes
+ *
+ * \brief Release the nodes of a subtree, without deleting the data pointed by them
+ *
+ *
+ * \par Date Written:
+ *      18/10/26
+ *
+ * \return void
+ *
+ * \param[in]  *rbt    The tree to which the subtree belongs
+ * \param[in]  *node   The root of the subtree
+ *
+ * \par Revision History:
+ *
+ *  DD/MM/YY | AUTHOR          |  DESCRIPTION
+ *  -------- | --------------- | -----------------------------------------------
+ *  18/10/26 | agent           |  Initial Implementation and documentation.
+ *******************************************************************************/
+static void freeSubtreeNodes(Rbt *rbt, RbtNode *node)
+{
+	if (node != NULL)
+	{
+		freeSubtreeNodes(rbt, node->child[LEFT]);
+		freeSubtreeNodes(rbt, node->child[RIGHT]);
+		releaseNode(rbt, node);
+	}
+}
+
+/******************************************************************************
+ *
+ * \par Function Name:
+ *      buildSubtree
+ *
+ * \brief Build a perfectly balanced subtree from data[first]...data[last] (sorted)
+ *
+ *
+ * \par Date Written:
+ *      18/10/26
+ *
+ * \return int
+ *
+ * \retval   0  Success case
+ * \retval  -2  MWITHDRAW error (nothing allocated)
+ *
+ * \param[in]   *rbt        The tree to which the new nodes will belong
+ * \param[in]   *parent     The parent of the subtree's root
+ * \param[in]   **data      The sorted data
+ * \param[in]   first       The index of the first element of the subtree
+ * \param[in]   count       The number of elements of the subtree
+ * \param[in]   depth       The depth of the subtree's root
+ * \param[in]   redDepth    The nodes at this depth are red, all the others are black
+ * \param[out]  **subtree   The root of the new subtree
+ *
+ * \par Notes:
+ *      1. Splitting at the middle element every path from a node to a NULL child
+ *         has either the maximum depth or the maximum depth minus one,
+ *         so coloring red only the deepest nodes gives a valid red-black tree.
+ *
+ * \par Revision History:
+ *
+ *  DD/MM/YY | AUTHOR          |  DESCRIPTION
+ *  -------- | --------------- | -----------------------------------------------
+ *  18/10/26 | agent           |  Initial Implementation and documentation.
+ *******************************************************************************/
+static int buildSubtree(Rbt *rbt, RbtNode *parent, void **data, unsigned long first,
+		unsigned long count, int depth, int redDepth, RbtNode **subtree)
+{
+	RbtNode *node;
+	unsigned long middle;
+
+	*subtree = NULL;
+	if (count == 0)
+	{
+		return 0;
+	}
+
+	node = takeNode(rbt);
+	if (node == NULL)
+	{
+		return -2;
+	}
+
+	middle = first + count / 2;
+	node->rbt = rbt;
+	node->parent = parent;
+	node->data = data[middle];
+	node->isRed = (depth == redDepth && depth > 0) ? 1 : 0;
+
+	if (buildSubtree(rbt, node, data, first, middle - first, depth + 1, redDepth, &(node->child[LEFT])) < 0)
+	{
+		releaseNode(rbt, node);
+		return -2;
+	}
+	if (buildSubtree(rbt, node, data, middle + 1, first + count - middle - 1, depth + 1, redDepth, &(node->child[RIGHT])) < 0)
+	{
+		freeSubtreeNodes(rbt, node->child[LEFT]);
+		releaseNode(rbt, node);
+		return -2;
+	}
+
+	*subtree = node;
+	return 0;
+}
+
+/******************************************************************************
+ *
+ * \par Function Name:
+ *      rbt_rebuild_from_sorted
+ *
+ * \brief Replace all the nodes of the tree with a new balanced tree
+ *        built bottom-up from an array of sorted data, in O(n).
+ *
+ *
+ * \par Date Written:
+ *      18/10/26
+ *
+ * \return int
+ *
+ * \retval   0  Success case
+ * \retval  -1  Arguments error
+ * \retval  -2  MWITHDRAW error (the tree is left unchanged)
+ *
+ * \param[in]  *rbt     The tree
+ * \param[in]  **data   The data of the new tree, sorted by rbt->compareFn, without duplicates
+ * \param[in]  n        The number of elements in data
+ *
+ * \par Notes:
+ *      1. The old nodes are released but the deleteFn is NOT called:
+ *         the data already in the tree must be in the "data" array too,
+ *         otherwise the caller must delete it.
+ *      2. Any RbtNode pointer kept by the caller becomes invalid.
+ *
+ * \par Revision History:
+ *
+ *  DD/MM/YY | AUTHOR          |  DESCRIPTION
+ *  -------- | --------------- | -----------------------------------------------
+ *  18/10/26 | agent           |  Initial Implementation and documentation.
+ *******************************************************************************/
+int rbt_rebuild_from_sorted(Rbt *rbt, void **data, unsigned long n)
+{
+	RbtNode *root = NULL;
+	int redDepth = 0;
+
+	if (rbt == NULL || (n > 0 && data == NULL))
+	{
+		return -1;
+	}
+
+	// depth of the deepest nodes: smallest d such that 2^(d+1) - 1 >= n
+	while (((2UL << redDepth) - 1) < n)
+	{
+		redDepth++;
+	}
+
+	if (buildSubtree(rbt, NULL, data, 0, n, 0, redDepth, &root) < 0)
+	{
+		return -2;
+	}
+
+	destroyRbtNodes(rbt, NULL);
+	rbt->root = root;
+	rbt->length = n;
+
+	return 0;
+}
+
 /******************************************************************************
  *
  * \par Function Name:
@@ -585,7 +863,7 @@ static RbtNode* createNode(Rbt *rbt, RbtNode *parent, void *data, RbtNode **buff
 {
 	RbtNode *node;
 
-	node = (RbtNode*) MWITHDRAW(sizeof(RbtNode));
+	node = takeNode(rbt);
 
 	if (node != NULL)
 	{
@@ -1073,9 +1351,7 @@ void rbt_delete(Rbt *rbt, void *dataBuffer)
 
 			parent->child[i] = node->child[j];
 
-			/*	just in case user mistakenly accesses later...	*/
-			eraseTreeNode(node);
-			MDEPOSIT(node);
+			releaseNode(rbt, node);
 			rbt->length -= 1;
 		}
 
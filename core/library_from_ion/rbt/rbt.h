@@ -33,7 +33,9 @@ extern Rbt* rbt_create(RbtDeleteFn deleteFn, RbtCompareFn compareFn);
 extern void rbt_clear(Rbt *rbt);
 extern void rbt_destroy(Rbt *rbt);
 extern void rbt_user_data_set(Rbt *rbt, void *userData);
+extern int rbt_set_node_pool(Rbt *rbt, struct Pool *pool);
 extern RbtNode* rbt_insert(Rbt *rbt, void *data);
+extern int rbt_rebuild_from_sorted(Rbt *rbt, void **data, unsigned long n);
 extern void rbt_delete(Rbt *rbt, void *dataBuffer);
 
 extern RbtNode* rbt_search(Rbt *rbt, void *dataBuffer, RbtNode **successor);
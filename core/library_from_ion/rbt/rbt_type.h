@@ -74,6 +74,10 @@ struct rbt {
      * \brief The function called to compare the data field of the RbtNodes
      */
     RbtCompareFn compareFn;
+    /**
+     * \brief The pool of the RbtNodes, NULL if they are allocated with MWITHDRAW (see rbt_set_node_pool())
+     */
+    struct Pool *nodePool;
 };
 
 #ifdef __cplusplus
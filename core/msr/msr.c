@@ -269,7 +269,7 @@ static void print_msr_proposed_route(FILE *file, Route *route, unsigned int num)
 				{
 					contact = (Contact*) elt->data;
 					fprintf(file,
-							"%-15" PRIu64 " %-15" PRIu64 " %-15ld %-15ld %-15lu %-10.2f%-5s %-15g %-15g %g\n",
+							"%-15" PRIu64 " %-15" PRIu64 " %-15ld %-15ld %-15lu %-10.2f%-5s %-15" PRId64 " %-15" PRId64 " %" PRId64 "\n",
 							contact->fromNode, contact->toNode, (long int) contact->fromTime,
 							(long int) contact->toTime, contact->xmitRate, contact->confidence,
 							(elt == route->rootOfSpur) ? " x" : "", contact->mtv[0],
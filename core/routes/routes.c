@@ -34,6 +34,7 @@
 #include "../contact_plan/contacts/contacts.h"
 #include "../contact_plan/nodes/nodes.h"
 #include "../library/list/list.h"
+#include "../library/pool/pool.h"
 
 /******************************************************************************
  *
@@ -63,6 +64,43 @@ static void erase_cgr_route(Route *route)
 	memset(route, 0, sizeof(Route));
 }
 
+/******************************************************************************
+ *
+ * \par Function Name:
+ *      release_cgr_route
+ *
+ * \brief Erase the route and give its memory back to the route pool (or MDEPOSIT)
+ *
+ *
+ * \par Date Written:
+ *      18/10/26
+ *
+ * \return void
+ *
+ * \param[in]	*route	The Route to deallocate
+ *
+ *
+ * \par Revision History:
+ *
+ *  DD/MM/YY |  AUTHOR         |   DESCRIPTION
+ *  -------- | --------------- | -----------------------------------------------
+ *  18/10/26 | agent           |  Initial Implementation and documentation.
+ *****************************************************************************/
+static void release_cgr_route(Route *route)
+{
+	Pool *pool = route->pool;
+
+	erase_cgr_route(route);
+	if (pool != NULL)
+	{
+		pool_release(pool, route);
+	}
+	else
+	{
+		MDEPOSIT(route);
+	}
+}
+
 /******************************************************************************
  *
  * \par Function Name:
@@ -239,6 +277,7 @@ static void update_references(Route *route)
  *  DD/MM/YY |  AUTHOR         |   DESCRIPTION
  *  -------- | --------------- | -----------------------------------------------
  *  21/01/20 | L. Persampieri  |  Initial Implementation and documentation.
+ *  18/10/26 | agent           |  Route and ListElt pools.
  *****************************************************************************/
 void delete_cgr_route(void *data)
 {
@@ -259,11 +298,10 @@ void delete_cgr_route(void *data)
 				nextElt = elt->next;
 				contact = elt->data;
 				remove_citation(contact, elt); //delete citation from the contact
-				MDEPOSIT(elt);
 				elt = nextElt;
 			}
 
-			MDEPOSIT(route->hops);
+			free_list(route->hops);
 		}
 
 		update_references(route); //manage the references with other routes
@@ -283,8 +321,7 @@ void delete_cgr_route(void *data)
 			}
 
 		}
-		erase_cgr_route(route);
-		MDEPOSIT(route);
+		release_cgr_route(route);
 	}
 }
 
@@ -389,25 +426,39 @@ void destroy_routes_list(List routes)
  * \retval Route*  The new allocated Route
  * \retval NULL    MWITHDRAW error
  *
+ * \param[in]	*uniboCgrSap	The UniboCGRSAP (owner of the route and ListElt pools)
  *
  * \par Notes:
  * 			1. You must check that the return value of this function is not NULL.
  * 			2. The hops list will be allocated
  * 			3. The children list will be allocated
+ * 			4. The route and the ListElts of its lists are taken from the pools of the instance, if any.
  *
  * \par Revision History:
  *
  *  DD/MM/YY |  AUTHOR         |   DESCRIPTION
  *  -------- | --------------- | -----------------------------------------------
  *  21/01/20 | L. Persampieri  |  Initial Implementation and documentation.
+ *  18/10/26 | agent           |  Route and ListElt pools.
  *****************************************************************************/
-Route* create_cgr_route()
+Route* create_cgr_route(UniboCGRSAP* uniboCgrSap)
 {
 	Route *result;
-	result = (Route*) MWITHDRAW(sizeof(Route));
+	Pool *pool = UniboCGRSAP_get_route_pool(uniboCgrSap);
+
+	if (pool != NULL)
+	{
+		result = (Route*) pool_take(pool);
+	}
+	else
+	{
+		result = (Route*) MWITHDRAW(sizeof(Route));
+	}
+
 	if (result != NULL)
 	{
 		erase_cgr_route(result);
+		result->pool = pool;
 		result->hops = list_create(result, NULL, NULL, NULL);
 		result->children = list_create(result, NULL, NULL, remove_reference_from_son);
 
@@ -415,9 +466,14 @@ Route* create_cgr_route()
 		{
 			MDEPOSIT(result->hops);
 			MDEPOSIT(result->children);
-			MDEPOSIT(result);
+			release_cgr_route(result);
 			result = NULL;
 		}
+		else
+		{
+			list_set_elt_pool(result->hops, UniboCGRSAP_get_list_elt_pool(uniboCgrSap));
+			list_set_elt_pool(result->children, UniboCGRSAP_get_list_elt_pool(uniboCgrSap));
+		}
 	}
 
 	return result;
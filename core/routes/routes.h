@@ -92,6 +92,14 @@ typedef struct cgrRoute
 	 * \brief The time when this route has been computed
 	 */
 	time_t computedAtTime;
+	/**
+	 * \brief The last time for which arrivalTime and owltSum computed
+	 *        at computedAtTime are still the same.
+	 *
+	 * \details Within [computedAtTime, validUntil] the route doesn't need
+	 *          to be re-validated by phase one (see update_cost_values).
+	 */
+	time_t validUntil;
 
 	/**
 	 * \brief Actually only for logs: Number of the route in the selectedRoutes list
@@ -158,9 +166,13 @@ typedef struct cgrRoute
 	 */
 	CgrScalar committed;
 	/************************************************/
+	/**
+	 * \brief The pool from which the route has been taken, NULL if allocated with MWITHDRAW
+	 */
+	Pool *pool;
 } Route;
 
-extern Route* create_cgr_route();
+extern Route* create_cgr_route(UniboCGRSAP* uniboCgrSap);
 extern void delete_cgr_route(void*);
 extern void clear_routes_list(List routes);
 extern void destroy_routes_list(List routes);
@@ -0,0 +1,1270 @@
+/** \file snapshot.c
+ *
+ *  \brief  This file provides the implementation of the functions
+ *          to save and restore the contact plan and the computed routes.
+ *
+ *
+ ** \copyright Copyright (c) 2020, Alma Mater Studiorum, University of Bologna, All rights reserved.
+ **
+ ** \par License
+ **
+ **    This file is part of Unibo-CGR.                                            <br>
+ **                                                                               <br>
+ **    Unibo-CGR is free software: you can redistribute it and/or modify
+ **    it under the terms of the GNU General Public License as published by
+ **    the Free Software Foundation, either version 3 of the License, or
+ **    (at your option) any later version.                                        <br>
+ **    Unibo-CGR is distributed in the hope that it will be useful,
+ **    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ **    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ **    GNU General Public License for more details.                               <br>
+ **                                                                               <br>
+ **    You should have received a copy of the GNU General Public License
+ **    along with Unibo-CGR.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  \author agent, agent@local
+ *
+ *  \par Supervisor
+ *       Carlo Caini, carlo.caini@unibo.it
+ */
+
+#include "snapshot.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "../contact_plan/contacts/contacts.h"
+#include "../contact_plan/ranges/ranges.h"
+#include "../contact_plan/nodes/nodes.h"
+#include "../routes/routes.h"
+#include "../library/list/list.h"
+
+#define FNV_OFFSET_BASIS 14695981039346656037ULL
+#define FNV_PRIME 1099511628211ULL
+
+/**
+ * \brief A route to save, with the node and the list where it is stored.
+ */
+typedef struct
+{
+	Route *route;
+	uint64_t destination;
+	int known;
+} SavedRoute;
+
+/**
+ * \brief Used by snapshot_write() to find the index of a Route (father) by its address.
+ */
+typedef struct
+{
+	Route *route;
+	int64_t index;
+} RouteIndex;
+
+/******************************************************************************
+ *
+ * \par Function Name:
+ *      hash_value
+ *
+ * \brief  FNV-1a hash of a 64 bit value (byte order independent of the host).
+ *
+ *
+ * \par Date Written:
+ *      18/10/26
+ *
+ * \return uint64_t
+ *
+ * \retval uint64_t  The updated hash
+ *
+ * \param[in]	hash    The current hash
+ * \param[in]	value   The value to add to the hash
+ *
+ * \par Revision History:
+ *
+ *  DD/MM/YY |  AUTHOR         |   DESCRIPTION
+ *  -------- | --------------- | -----------------------------------------------
+ *  18/10/26 | agent           |  Initial Implementation and documentation.
+ *****************************************************************************/
+static uint64_t hash_value(uint64_t hash, uint64_t value)
+{
+	int i;
+
+	for (i = 0; i < 8; i++)
+	{
+		hash ^= (value >> (i * 8)) & 0xFF;
+		hash *= FNV_PRIME;
+	}
+
+	return hash;
+}
+
+/******************************************************************************
+ *
+ * \par Function Name:
+ *      hash_contact_record
+ *
+ * \brief  Add a contact to the contact plan hash, if it ends after "after" (Unix time).
+ *
+ *
+ * \par Date Written:
+ *      18/10/26
+ *
+ * \return uint64_t
+ *
+ * \retval uint64_t  The updated hash
+ *
+ * \param[in]	hash       The current hash
+ * \param[in]	*record    The contact, times relative to timeBase
+ * \param[in]	timeBase   Unix time of the record's time 0
+ * \param[in]	after      Unix time: the contacts that end before are not in the hash
+ *
+ * \par Notes:
+ *          1.  The MTVs are not in the hash: they change with the bookings.
+ *
+ * \par Revision History:
+ *
+ *  DD/MM/YY |  AUTHOR         |   DESCRIPTION
+ *  -------- | --------------- | -----------------------------------------------
+ *  18/10/26 | agent           |  Initial Implementation and documentation.
+ *****************************************************************************/
+static uint64_t hash_contact_record(uint64_t hash, const BinaryPlanContact *record, int64_t timeBase, int64_t after)
+{
+	uint32_t confidence;
+
+	if (record->toTime + timeBase <= after)
+	{
+		return hash;
+	}
+
+	memcpy(&confidence, &record->confidence, sizeof(uint32_t));
+	hash = hash_value(hash, record->fromNode);
+	hash = hash_value(hash, record->toNode);
+	hash = hash_value(hash, (uint64_t) (record->fromTime + timeBase));
+	hash = hash_value(hash, (uint64_t) (record->toTime + timeBase));
+	hash = hash_value(hash, record->xmitRate);
+	hash = hash_value(hash, (uint64_t) confidence);
+
+	return hash;
+}
+
+/******************************************************************************
+ *
+ * \par Function Name:
+ *      hash_range_record
+ *
+ * \brief  Add a range to the contact plan hash, if it ends after "after" (Unix time).
+ *
+ *
+ * \par Date Written:
+ *      18/10/26
+ *
+ * \return uint64_t
+ *
+ * \retval uint64_t  The updated hash
+ *
+ * \param[in]	hash       The current hash
+ * \param[in]	*record    The range, times relative to timeBase
+ * \param[in]	timeBase   Unix time of the record's time 0
+ * \param[in]	after      Unix time: the ranges that end before are not in the hash
+ *
+ * \par Revision History:
+ *
+ *  DD/MM/YY |  AUTHOR         |   DESCRIPTION
+ *  -------- | --------------- | -----------------------------------------------
+ *  18/10/26 | agent           |  Initial Implementation and documentation.
+ *****************************************************************************/
+static uint64_t hash_range_record(uint64_t hash, const BinaryPlanRange *record, int64_t timeBase, int64_t after)
+{
+	if (record->toTime + timeBase <= after)
+	{
+		return hash;
+	}
+
+	hash = hash_value(hash, record->fromNode);
+	hash = hash_value(hash, record->toNode);
+	hash = hash_value(hash, (uint64_t) (record->fromTime + timeBase));
+	hash = hash_value(hash, (uint64_t) (record->toTime + timeBase));
+	hash = hash_value(hash, record->owlt);
+
+	return hash;
+}
+
+/******************************************************************************
+ *
+ * \par Function Name:
+ *      hash_snapshot_plan
+ *
+ * \brief  Hash of the contacts and ranges of a mapped snapshot that end after "after".
+ *
+ *
+ * \par Date Written:
+ *      18/10/26
+ *
+ * \return uint64_t
+ *
+ * \retval uint64_t  The contact plan hash
+ *
+ * \param[in]	*snapshot   The mapped snapshot
+ * \param[in]	after       Unix time: the contacts and ranges that end before are not in the hash
+ *
+ * \par Revision History:
+ *
+ *  DD/MM/YY |  AUTHOR         |   DESCRIPTION
+ *  -------- | --------------- | -----------------------------------------------
+ *  18/10/26 | agent           |  Initial Implementation and documentation.
+ *****************************************************************************/
+static uint64_t hash_snapshot_plan(const Snapshot *snapshot, int64_t after)
+{
+	uint64_t i, hash = FNV_OFFSET_BASIS;
+	const int64_t timeBase = snapshot->header->timeBase;
+
+	for (i = 0; i < snapshot->header->contactsCount; i++)
+	{
+		hash = hash_contact_record(hash, &snapshot->contacts[i], timeBase, after);
+	}
+	// sections separator
+	hash = hash_value(hash, 0);
+	for (i = 0; i < snapshot->header->rangesCount; i++)
+	{
+		hash = hash_range_record(hash, &snapshot->ranges[i], timeBase, after);
+	}
+
+	return hash;
+}
+
+/******************************************************************************
+ *
+ * \par Function Name:
+ *      fill_contact_record
+ *
+ * \brief  Copy a contact of the graph in a snapshot record.
+ *
+ *
+ * \par Date Written:
+ *      18/10/26
+ *
+ * \return void
+ *
+ * \param[in]	*contact   The contact
+ * \param[out]	*record    The record, same times of the contact
+ *
+ * \par Revision History:
+ *
+ *  DD/MM/YY |  AUTHOR         |   DESCRIPTION
+ *  -------- | --------------- | -----------------------------------------------
+ *  18/10/26 | agent           |  Initial Implementation and documentation.
+ *****************************************************************************/
+static void fill_contact_record(const Contact *contact, BinaryPlanContact *record)
+{
+	int priority;
+
+	memset(record, 0, sizeof(BinaryPlanContact));
+	record->fromNode = contact->fromNode;
+	record->toNode = contact->toNode;
+	record->fromTime = (int64_t) contact->fromTime;
+	record->toTime = (int64_t) contact->toTime;
+	record->xmitRate = contact->xmitRate;
+	record->confidence = contact->confidence;
+	for (priority = 0; priority < 3; priority++)
+	{
+		record->mtv[priority] = (double) contact->mtv[priority];
+	}
+}
+
+/******************************************************************************
+ *
+ * \par Function Name:
+ *      fill_range_record
+ *
+ * \brief  Copy a range of the graph in a snapshot record.
+ *
+ *
+ * \par Date Written:
+ *      18/10/26
+ *
+ * \return void
+ *
+ * \param[in]	*range     The range
+ * \param[out]	*record    The record, same times of the range
+ *
+ * \par Revision History:
+ *
+ *  DD/MM/YY |  AUTHOR         |   DESCRIPTION
+ *  -------- | --------------- | -----------------------------------------------
+ *  18/10/26 | agent           |  Initial Implementation and documentation.
+ *****************************************************************************/
+static void fill_range_record(const Range *range, BinaryPlanRange *record)
+{
+	memset(record, 0, sizeof(BinaryPlanRange));
+	record->fromNode = range->fromNode;
+	record->toNode = range->toNode;
+	record->fromTime = (int64_t) range->fromTime;
+	record->toTime = (int64_t) range->toTime;
+	record->owlt = range->owlt;
+}
+
+/******************************************************************************
+ *
+ * \par Function Name:
+ *      compare_contacts_addresses
+ *
+ * \brief  bsearch() comparator on an array of Contact* sorted as the contacts graph.
+ *
+ *
+ * \par Date Written:
+ *      18/10/26
+ *
+ * \return int
+ *
+ * \param[in]	*first    Pointer to the first Contact*
+ * \param[in]	*second   Pointer to the second Contact*
+ *
+ * \par Revision History:
+ *
+ *  DD/MM/YY |  AUTHOR         |   DESCRIPTION
+ *  -------- | --------------- | -----------------------------------------------
+ *  18/10/26 | agent           |  Initial Implementation and documentation.
+ *****************************************************************************/
+static int compare_contacts_addresses(const void *first, const void *second)
+{
+	return compare_contacts(*((Contact**) first), *((Contact**) second));
+}
+
+/******************************************************************************
+ *
+ * \par Function Name:
+ *      compare_route_indexes
+ *
+ * \brief  qsort() and bsearch() comparator on RouteIndex (by address of the route).
+ *
+ *
+ * \par Date Written:
+ *      18/10/26
+ *
+ * \return int
+ *
+ * \param[in]	*first    Pointer to the first RouteIndex
+ * \param[in]	*second   Pointer to the second RouteIndex
+ *
+ * \par Revision History:
+ *
+ *  DD/MM/YY |  AUTHOR         |   DESCRIPTION
+ *  -------- | --------------- | -----------------------------------------------
+ *  18/10/26 | agent           |  Initial Implementation and documentation.
+ *****************************************************************************/
+static int compare_route_indexes(const void *first, const void *second)
+{
+	uintptr_t a = (uintptr_t) ((const RouteIndex*) first)->route;
+	uintptr_t b = (uintptr_t) ((const RouteIndex*) second)->route;
+
+	if (a == b)
+	{
+		return 0;
+	}
+
+	return (a < b) ? -1 : 1;
+}
+
+/******************************************************************************
+ *
+ * \par Function Name:
+ *      get_route_index
+ *
+ * \brief  Get the index (in the routes section) of a route.
+ *
+ *
+ * \par Date Written:
+ *      18/10/26
+ *
+ * \return int64_t
+ *
+ * \retval ">= 0"  The index of the route
+ * \retval -1      route is NULL or it is not saved in the snapshot
+ *
+ * \param[in]	*indexes   The routes sorted by address
+ * \param[in]	count      The number of routes
+ * \param[in]	*route     The route to search
+ *
+ * \par Revision History:
+ *
+ *  DD/MM/YY |  AUTHOR         |   DESCRIPTION
+ *  -------- | --------------- | -----------------------------------------------
+ *  18/10/26 | agent           |  Initial Implementation and documentation.
+ *****************************************************************************/
+static int64_t get_route_index(RouteIndex *indexes, uint64_t count, Route *route)
+{
+	RouteIndex key, *found;
+
+	if (route == NULL || count == 0)
+	{
+		return -1;
+	}
+
+	key.route = route;
+	found = (RouteIndex*) bsearch(&key, indexes, count, sizeof(RouteIndex), compare_route_indexes);
+
+	return (found != NULL) ? found->index : -1;
+}
+
+/******************************************************************************
+ *
+ * \par Function Name:
+ *      collect_routes
+ *
+ * \brief  Get the routes of all the nodes, in the snapshot order:
+ *         for each node (by ipn number) the selected routes then the known routes.
+ *
+ *
+ * \par Date Written:
+ *      18/10/26
+ *
+ * \return uint64_t
+ *
+ * \retval uint64_t  The number of routes
+ *
+ * \param[out]	*routes    If not NULL, the routes (the arrays must be large enough)
+ * \param[out]	*indexes   If not NULL, the routes with their index (unsorted)
+ *
+ * \par Revision History:
+ *
+ *  DD/MM/YY |  AUTHOR         |   DESCRIPTION
+ *  -------- | --------------- | -----------------------------------------------
+ *  18/10/26 | agent           |  Initial Implementation and documentation.
+ *****************************************************************************/
+static uint64_t collect_routes(UniboCGRSAP *uniboCgrSap, SavedRoute *routes, RouteIndex *indexes)
+{
+	RbtNode *rbtNode;
+	Node *node;
+	ListElt *elt;
+	List lists[2];
+	uint64_t count = 0;
+	int i;
+
+	for (node = get_first_node(uniboCgrSap, &rbtNode); node != NULL; node = get_next_node(&rbtNode))
+	{
+		if (node->routingObject == NULL)
+		{
+			continue;
+		}
+		lists[0] = node->routingObject->selectedRoutes;
+		lists[1] = node->routingObject->knownRoutes;
+		for (i = 0; i < 2; i++)
+		{
+			for (elt = (lists[i] != NULL) ? lists[i]->first : NULL; elt != NULL; elt = elt->next)
+			{
+				if (routes != NULL)
+				{
+					routes[count].route = (Route*) elt->data;
+					routes[count].destination = node->nodeNbr;
+					routes[count].known = i;
+				}
+				if (indexes != NULL)
+				{
+					indexes[count].route = (Route*) elt->data;
+					indexes[count].index = (int64_t) count;
+				}
+				count++;
+			}
+		}
+	}
+
+	return count;
+}
+
+/******************************************************************************
+ *
+ * \par Function Name:
+ *      write_padding
+ *
+ * \brief  Write zeros until the file offset is multiple of 8.
+ *
+ *
+ * \par Date Written:
+ *      18/10/26
+ *
+ * \return int
+ *
+ * \retval   0  Success case
+ * \retval  -1  Write error
+ *
+ * \param[in]	*file     The file
+ * \param[in]	offset    The current offset
+ *
+ * \par Revision History:
+ *
+ *  DD/MM/YY |  AUTHOR         |   DESCRIPTION
+ *  -------- | --------------- | -----------------------------------------------
+ *  18/10/26 | agent           |  Initial Implementation and documentation.
+ *****************************************************************************/
+static int write_padding(FILE *file, uint64_t offset)
+{
+	static const char zeros[8] = { 0 };
+	size_t padding = (size_t) ((8 - (offset % 8)) % 8);
+
+	if (padding > 0 && fwrite(zeros, 1, padding, file) != padding)
+	{
+		return -1;
+	}
+
+	return 0;
+}
+
+/******************************************************************************
+ *
+ * \par Function Name:
+ *      write_sections
+ *
+ * \brief  Write the contacts, ranges, routes and hops sections, filling the header.
+ *
+ *
+ * \par Date Written:
+ *      18/10/26
+ *
+ * \return int
+ *
+ * \retval   0  Success case
+ * \retval  -1  Write error
+ *
+ * \param[in]	*file           The file, positioned just after the header
+ * \param[in]	**contacts      The contacts of the graph, in graph order
+ * \param[in]	*routes         The routes, in snapshot order
+ * \param[in]	*indexes        The routes sorted by address
+ * \param[in,out]	*header     The header: counts, offsets and hash are set here
+ *
+ * \par Revision History:
+ *
+ *  DD/MM/YY |  AUTHOR         |   DESCRIPTION
+ *  -------- | --------------- | -----------------------------------------------
+ *  18/10/26 | agent           |  Initial Implementation and documentation.
+ *****************************************************************************/
+static int write_sections(UniboCGRSAP *uniboCgrSap, FILE *file, Contact **contacts,
+		SavedRoute *routes, RouteIndex *indexes, SnapshotHeader *header)
+{
+	BinaryPlanContact contactRecord;
+	BinaryPlanRange rangeRecord;
+	SnapshotRoute routeRecord;
+	Route *route;
+	Range *range;
+	RbtNode *rbtNode;
+	ListElt *elt;
+	Contact **found;
+	uint64_t i, hash = FNV_OFFSET_BASIS, firstHop = 0;
+	uint32_t hop;
+	int32_t position;
+
+	header->contactsOffset = sizeof(SnapshotHeader);
+	for (i = 0; i < header->contactsCount; i++)
+	{
+		fill_contact_record(contacts[i], &contactRecord);
+		hash = hash_contact_record(hash, &contactRecord, header->timeBase, INT64_MIN);
+		if (fwrite(&contactRecord, sizeof(BinaryPlanContact), 1, file) != 1)
+		{
+			return -1;
+		}
+	}
+	hash = hash_value(hash, 0);
+
+	header->rangesOffset = header->contactsOffset + header->contactsCount * sizeof(BinaryPlanContact);
+	header->rangesCount = 0;
+	for (range = get_first_range(uniboCgrSap, &rbtNode); range != NULL; range = get_next_range(&rbtNode))
+	{
+		fill_range_record(range, &rangeRecord);
+		hash = hash_range_record(hash, &rangeRecord, header->timeBase, INT64_MIN);
+		if (fwrite(&rangeRecord, sizeof(BinaryPlanRange), 1, file) != 1)
+		{
+			return -1;
+		}
+		header->rangesCount++;
+	}
+	header->planHash = hash;
+
+	header->routesOffset = header->rangesOffset + header->rangesCount * sizeof(BinaryPlanRange);
+	for (i = 0; i < header->routesCount; i++)
+	{
+		route = routes[i].route;
+		memset(&routeRecord, 0, sizeof(SnapshotRoute));
+		routeRecord.destination = routes[i].destination;
+		routeRecord.neighbor = route->neighbor;
+		routeRecord.owltSum = route->owltSum;
+		routeRecord.arrivalTime = (int64_t) route->arrivalTime;
+		routeRecord.computedAtTime = (int64_t) route->computedAtTime;
+		routeRecord.validUntil = (int64_t) route->validUntil;
+		routeRecord.fromTime = (int64_t) route->fromTime;
+		routeRecord.toTime = (int64_t) route->toTime;
+		routeRecord.firstHop = firstHop;
+		routeRecord.father = get_route_index(indexes, header->routesCount, get_route_father(route));
+		routeRecord.selectedFather = get_route_index(indexes, header->routesCount, route->selectedFather);
+		routeRecord.hopsCount = (uint32_t) route->hops->length;
+		routeRecord.rootOfSpur = -1;
+		for (elt = route->hops->first, position = 0; elt != NULL; elt = elt->next, position++)
+		{
+			if (elt == route->rootOfSpur)
+			{
+				routeRecord.rootOfSpur = position;
+			}
+		}
+		routeRecord.arrivalConfidence = route->arrivalConfidence;
+		routeRecord.known = (uint8_t) routes[i].known;
+		routeRecord.spursComputed = (uint8_t) route->spursComputed;
+		firstHop += routeRecord.hopsCount;
+
+		if (fwrite(&routeRecord, sizeof(SnapshotRoute), 1, file) != 1)
+		{
+			return -1;
+		}
+	}
+
+	header->hopsOffset = header->routesOffset + header->routesCount * sizeof(SnapshotRoute);
+	header->hopsCount = firstHop;
+	for (i = 0; i < header->routesCount; i++)
+	{
+		for (elt = routes[i].route->hops->first; elt != NULL; elt = elt->next)
+		{
+			found = (header->contactsCount == 0) ? NULL :
+					(Contact**) bsearch(&elt->data, contacts, header->contactsCount, sizeof(Contact*), compare_contacts_addresses);
+			// an index out of the contacts section: the route will not be restored
+			hop = (found != NULL) ? (uint32_t) (found - contacts) : UINT32_MAX;
+			if (fwrite(&hop, sizeof(uint32_t), 1, file) != 1)
+			{
+				return -1;
+			}
+		}
+	}
+
+	return write_padding(file, header->hopsOffset + header->hopsCount * sizeof(uint32_t));
+}
+
+/******************************************************************************
+ *
+ * \par Function Name:
+ *      snapshot_write
+ *
+ * \brief  Save the contact plan (with the current MTVs) and all the routes
+ *         stored in the nodes tree in a snapshot file.
+ *
+ *
+ * \par Date Written:
+ *      18/10/26
+ *
+ * \return int
+ *
+ * \retval   0  Success case
+ * \retval  -1  Cannot open or write the file
+ * \retval  -2  MWITHDRAW error
+ *
+ * \param[in]	*fileName   The snapshot file
+ *
+ * \par Notes:
+ *          1.  The routes must be valid for the current contact plan:
+ *              call it after UniboCGRSAP_handle_updates().
+ *
+ * \par Revision History:
+ *
+ *  DD/MM/YY |  AUTHOR         |   DESCRIPTION
+ *  -------- | --------------- | -----------------------------------------------
+ *  18/10/26 | agent           |  Initial Implementation and documentation.
+ *****************************************************************************/
+int snapshot_write(UniboCGRSAP *uniboCgrSap, const char *fileName)
+{
+	SnapshotHeader header;
+	Contact **contacts, *contact;
+	SavedRoute *routes;
+	RouteIndex *indexes;
+	RbtNode *rbtNode;
+	FILE *file;
+	uint64_t contactsCount = 0, routesCount;
+	int result;
+
+	for (contact = get_first_contact(uniboCgrSap, &rbtNode); contact != NULL; contact = get_next_contact(&rbtNode))
+	{
+		contactsCount++;
+	}
+	if (contactsCount >= UINT32_MAX)
+	{
+		return -1; // hops are 32 bit indexes
+	}
+	routesCount = collect_routes(uniboCgrSap, NULL, NULL);
+
+	contacts = (Contact**) MWITHDRAW(sizeof(Contact*) * (contactsCount > 0 ? contactsCount : 1));
+	routes = (SavedRoute*) MWITHDRAW(sizeof(SavedRoute) * (routesCount > 0 ? routesCount : 1));
+	indexes = (RouteIndex*) MWITHDRAW(sizeof(RouteIndex) * (routesCount > 0 ? routesCount : 1));
+	if (contacts == NULL || routes == NULL || indexes == NULL)
+	{
+		MDEPOSIT(contacts);
+		MDEPOSIT(routes);
+		MDEPOSIT(indexes);
+		return -2;
+	}
+
+	contactsCount = 0;
+	for (contact = get_first_contact(uniboCgrSap, &rbtNode); contact != NULL; contact = get_next_contact(&rbtNode))
+	{
+		contacts[contactsCount++] = contact;
+	}
+	collect_routes(uniboCgrSap, routes, indexes);
+	if (routesCount > 0)
+	{
+		qsort(indexes, routesCount, sizeof(RouteIndex), compare_route_indexes);
+	}
+
+	memset(&header, 0, sizeof(SnapshotHeader));
+	memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+	header.version = SNAPSHOT_VERSION;
+	header.byteOrder = BINARY_PLAN_BYTE_ORDER;
+	header.headerSize = sizeof(SnapshotHeader);
+	header.contactRecordSize = sizeof(BinaryPlanContact);
+	header.rangeRecordSize = sizeof(BinaryPlanRange);
+	header.routeRecordSize = sizeof(SnapshotRoute);
+	header.timeBase = (int64_t) UniboCGRSAP_get_time_base(uniboCgrSap);
+	header.contactsCount = contactsCount;
+	header.routesCount = routesCount;
+
+	result = -1;
+	file = fopen(fileName, "wb");
+	if (file != NULL)
+	{
+		// the header is written again at the end, with counts and offsets
+		if (fwrite(&header, sizeof(SnapshotHeader), 1, file) == 1
+				&& write_sections(uniboCgrSap, file, contacts, routes, indexes, &header) == 0
+				&& fseek(file, 0, SEEK_SET) == 0
+				&& fwrite(&header, sizeof(SnapshotHeader), 1, file) == 1)
+		{
+			result = 0;
+		}
+		if (fclose(file) != 0)
+		{
+			result = -1;
+		}
+	}
+
+	MDEPOSIT(contacts);
+	MDEPOSIT(routes);
+	MDEPOSIT(indexes);
+
+	return result;
+}
+
+/******************************************************************************
+ *
+ * \par Function Name:
+ *      check_section
+ *
+ * \brief  Check that a section is aligned and inside the file.
+ *
+ *
+ * \par Date Written:
+ *      18/10/26
+ *
+ * \return int
+ *
+ * \retval  1  The section is valid
+ * \retval  0  The section is not valid
+ *
+ * \param[in]	fileSize     The size of the file
+ * \param[in]	offset       The offset of the section
+ * \param[in]	count        The number of records
+ * \param[in]	recordSize   The size of each record
+ *
+ * \par Revision History:
+ *
+ *  DD/MM/YY |  AUTHOR         |   DESCRIPTION
+ *  -------- | --------------- | -----------------------------------------------
+ *  18/10/26 | agent           |  Initial Implementation and documentation.
+ *****************************************************************************/
+static int check_section(size_t fileSize, uint64_t offset, uint64_t count, size_t recordSize)
+{
+	if (offset % 8 != 0 || offset > fileSize)
+	{
+		return 0;
+	}
+
+	return (count <= (fileSize - offset) / recordSize);
+}
+
+/******************************************************************************
+ *
+ * \par Function Name:
+ *      check_routes
+ *
+ * \brief  Check that all the indexes of the routes section are inside their section.
+ *
+ *
+ * \par Date Written:
+ *      18/10/26
+ *
+ * \return int
+ *
+ * \retval  1  The routes are valid
+ * \retval  0  Some route is not valid
+ *
+ * \param[in]	*snapshot   The mapped snapshot
+ *
+ * \par Notes:
+ *          1.  The hops are not checked here: a route with an hop out of the
+ *              contacts section is not restored.
+ *
+ * \par Revision History:
+ *
+ *  DD/MM/YY |  AUTHOR         |   DESCRIPTION
+ *  -------- | --------------- | -----------------------------------------------
+ *  18/10/26 | agent           |  Initial Implementation and documentation.
+ *****************************************************************************/
+static int check_routes(const Snapshot *snapshot)
+{
+	const SnapshotHeader *header = snapshot->header;
+	const SnapshotRoute *route;
+	uint64_t i;
+
+	for (i = 0; i < header->routesCount; i++)
+	{
+		route = &snapshot->routes[i];
+		if (route->destination == 0
+				|| route->hopsCount == 0
+				|| route->firstHop > header->hopsCount
+				|| route->hopsCount > header->hopsCount - route->firstHop
+				|| route->rootOfSpur < -1 || route->rootOfSpur >= (int32_t) route->hopsCount
+				|| route->father < -1 || route->father >= (int64_t) header->routesCount
+				|| route->selectedFather < -1 || route->selectedFather >= (int64_t) header->routesCount
+				|| route->father == (int64_t) i || route->selectedFather == (int64_t) i)
+		{
+			return 0;
+		}
+	}
+
+	return 1;
+}
+
+/******************************************************************************
+ *
+ * \par Function Name:
+ *      snapshot_map
+ *
+ * \brief  Map a snapshot file in memory (read only) and check it.
+ *
+ *
+ * \par Date Written:
+ *      18/10/26
+ *
+ * \return int
+ *
+ * \retval   0  Success case: call snapshot_unmap() when done
+ * \retval  -1  Cannot open or map the file
+ * \retval  -3  The file is not a valid snapshot of this version
+ *              (or it has been written on a host with different endianness)
+ *
+ * \param[in]   *fileName   The file to map
+ * \param[out]  *snapshot   The mapped snapshot
+ *
+ * \par Notes:
+ *          1.  The contacts and ranges sections are checked against the contact plan hash
+ *              of the header.
+ *
+ * \par Revision History:
+ *
+ *  DD/MM/YY |  AUTHOR         |   DESCRIPTION
+ *  -------- | --------------- | -----------------------------------------------
+ *  18/10/26 | agent           |  Initial Implementation and documentation.
+ *****************************************************************************/
+int snapshot_map(const char *fileName, Snapshot *snapshot)
+{
+	struct stat info;
+	const SnapshotHeader *header;
+	const char *base;
+	void *address;
+	size_t size;
+	int fd;
+
+	memset(snapshot, 0, sizeof(Snapshot));
+
+	fd = open(fileName, O_RDONLY);
+	if (fd < 0)
+	{
+		return -1;
+	}
+
+	if (fstat(fd, &info) != 0)
+	{
+		close(fd);
+		return -1;
+	}
+
+	size = (size_t) info.st_size;
+	if (size < sizeof(SnapshotHeader))
+	{
+		close(fd);
+		return -3;
+	}
+
+	address = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (address == MAP_FAILED)
+	{
+		return -1;
+	}
+
+	snapshot->base = address;
+	snapshot->size = size;
+
+	base = (const char*) address;
+	header = (const SnapshotHeader*) base;
+
+	if (memcmp(header->magic, SNAPSHOT_MAGIC, sizeof(header->magic)) != 0
+			|| header->version != SNAPSHOT_VERSION
+			|| header->byteOrder != BINARY_PLAN_BYTE_ORDER
+			|| header->headerSize != sizeof(SnapshotHeader)
+			|| header->contactRecordSize != sizeof(BinaryPlanContact)
+			|| header->rangeRecordSize != sizeof(BinaryPlanRange)
+			|| header->routeRecordSize != sizeof(SnapshotRoute)
+			|| !check_section(size, header->contactsOffset, header->contactsCount, sizeof(BinaryPlanContact))
+			|| !check_section(size, header->rangesOffset, header->rangesCount, sizeof(BinaryPlanRange))
+			|| !check_section(size, header->routesOffset, header->routesCount, sizeof(SnapshotRoute))
+			|| !check_section(size, header->hopsOffset, header->hopsCount, sizeof(uint32_t)))
+	{
+		snapshot_unmap(snapshot);
+		return -3;
+	}
+
+	snapshot->header = header;
+	snapshot->contacts = (const BinaryPlanContact*) (base + header->contactsOffset);
+	snapshot->ranges = (const BinaryPlanRange*) (base + header->rangesOffset);
+	snapshot->routes = (const SnapshotRoute*) (base + header->routesOffset);
+	snapshot->hops = (const uint32_t*) (base + header->hopsOffset);
+
+	if (hash_snapshot_plan(snapshot, INT64_MIN) != header->planHash || !check_routes(snapshot))
+	{
+		snapshot_unmap(snapshot);
+		return -3;
+	}
+
+	return 0;
+}
+
+/******************************************************************************
+ *
+ * \par Function Name:
+ *      snapshot_unmap
+ *
+ * \brief  Release a snapshot mapped by snapshot_map()
+ *
+ *
+ * \par Date Written:
+ *      18/10/26
+ *
+ * \return void
+ *
+ * \param[in,out]  *snapshot   The mapped snapshot
+ *
+ * \par Revision History:
+ *
+ *  DD/MM/YY |  AUTHOR         |   DESCRIPTION
+ *  -------- | --------------- | -----------------------------------------------
+ *  18/10/26 | agent           |  Initial Implementation and documentation.
+ *****************************************************************************/
+void snapshot_unmap(Snapshot *snapshot)
+{
+	if (snapshot->base != NULL)
+	{
+		munmap(snapshot->base, snapshot->size);
+	}
+	memset(snapshot, 0, sizeof(Snapshot));
+}
+
+/******************************************************************************
+ *
+ * \par Function Name:
+ *      snapshot_plan_matches
+ *
+ * \brief  Check that the contact plan of the snapshot is the current contact plan.
+ *
+ *
+ * \par Date Written:
+ *      18/10/26
+ *
+ * \return int
+ *
+ * \retval  1  Same contact plan
+ * \retval  0  Different contact plans
+ *
+ * \param[in]   *snapshot   The mapped snapshot
+ *
+ * \par Notes:
+ *          1.  Only the contacts and ranges not yet expired are compared (by hash),
+ *              in Unix time: the snapshot can be taken with another time base.
+ *          2.  The MTVs are not compared.
+ *
+ * \par Revision History:
+ *
+ *  DD/MM/YY |  AUTHOR         |   DESCRIPTION
+ *  -------- | --------------- | -----------------------------------------------
+ *  18/10/26 | agent           |  Initial Implementation and documentation.
+ *****************************************************************************/
+int snapshot_plan_matches(UniboCGRSAP *uniboCgrSap, Snapshot *snapshot)
+{
+	BinaryPlanContact contactRecord;
+	BinaryPlanRange rangeRecord;
+	Contact *contact;
+	Range *range;
+	RbtNode *rbtNode;
+	uint64_t hash = FNV_OFFSET_BASIS;
+	const int64_t timeBase = (int64_t) UniboCGRSAP_get_time_base(uniboCgrSap);
+	const int64_t now = timeBase + (int64_t) UniboCGRSAP_get_current_time(uniboCgrSap);
+
+	for (contact = get_first_contact(uniboCgrSap, &rbtNode); contact != NULL; contact = get_next_contact(&rbtNode))
+	{
+		fill_contact_record(contact, &contactRecord);
+		hash = hash_contact_record(hash, &contactRecord, timeBase, now);
+	}
+	hash = hash_value(hash, 0);
+	for (range = get_first_range(uniboCgrSap, &rbtNode); range != NULL; range = get_next_range(&rbtNode))
+	{
+		fill_range_record(range, &rangeRecord);
+		hash = hash_range_record(hash, &rangeRecord, timeBase, now);
+	}
+
+	return (hash == hash_snapshot_plan(snapshot, now));
+}
+
+/******************************************************************************
+ *
+ * \par Function Name:
+ *      create_snapshot_route
+ *
+ * \brief  Create a route from a snapshot record, with its hops and the citations in the contacts.
+ *
+ *
+ * \par Date Written:
+ *      18/10/26
+ *
+ * \return int
+ *
+ * \retval   0  Success case: the route can be restored
+ * \retval  -1  The route has been created but some hop is no longer in the contacts graph
+ *              (only the previous hops have been inserted)
+ * \retval  -2  MWITHDRAW error (*route could be not NULL)
+ *
+ * \param[in]   *uniboCgrSap  The UniboCGRSAP
+ * \param[in]   *snapshot   The mapped snapshot
+ * \param[in]   *record     The route record
+ * \param[in]   **contacts  The contacts of the graph for each contact of the snapshot (NULL if missing)
+ * \param[in]   shift       Difference between the snapshot time base and the current time base
+ * \param[out]  **route     The route created
+ *
+ * \par Revision History:
+ *
+ *  DD/MM/YY |  AUTHOR         |   DESCRIPTION
+ *  -------- | --------------- | -----------------------------------------------
+ *  18/10/26 | agent           |  Initial Implementation and documentation.
+ *****************************************************************************/
+static int create_snapshot_route(UniboCGRSAP *uniboCgrSap, const Snapshot *snapshot, const SnapshotRoute *record,
+		Contact **contacts, time_t shift, Route **route)
+{
+	Route *result;
+	Contact *contact;
+	ListElt *elt;
+	uint32_t i, index;
+
+	result = create_cgr_route(uniboCgrSap);
+	*route = result;
+	if (result == NULL)
+	{
+		return -2;
+	}
+
+	result->neighbor = record->neighbor;
+	result->owltSum = record->owltSum;
+	result->arrivalTime = (time_t) record->arrivalTime + shift;
+	result->computedAtTime = (time_t) record->computedAtTime + shift;
+	result->validUntil = (time_t) record->validUntil + shift;
+	result->fromTime = (time_t) record->fromTime + shift;
+	result->toTime = (time_t) record->toTime + shift;
+	result->arrivalConfidence = record->arrivalConfidence;
+	result->spursComputed = record->spursComputed;
+
+	for (i = 0; i < record->hopsCount; i++)
+	{
+		index = snapshot->hops[record->firstHop + i];
+		contact = (index < snapshot->header->contactsCount) ? contacts[index] : NULL;
+		if (contact == NULL)
+		{
+			return -1;
+		}
+
+		elt = list_insert_last(result->hops, contact);
+		if (elt == NULL)
+		{
+			return -2;
+		}
+		if (insert_contact_citation(contact, elt) == NULL)
+		{
+			list_remove_elt(elt);
+			return -2;
+		}
+		if ((int32_t) i == record->rootOfSpur)
+		{
+			result->rootOfSpur = elt;
+		}
+	}
+
+	return 0;
+}
+
+/******************************************************************************
+ *
+ * \par Function Name:
+ *      snapshot_restore
+ *
+ * \brief  Restore the MTVs of the contacts and the routes saved in the snapshot.
+ *
+ *
+ * \par Date Written:
+ *      18/10/26
+ *
+ * \return int
+ *
+ * \retval ">= 0"  Success case: number of routes restored
+ * \retval  -2     MWITHDRAW error: all the routes have been discarded
+ *
+ * \param[in]   *snapshot   The mapped snapshot
+ *
+ * \par Notes:
+ *          1.  The snapshot must have the current contact plan (see snapshot_plan_matches())
+ *              and the nodes tree must have no routes.
+ *          2.  A route that passes through a contact no longer in the graph (expired)
+ *              is discarded as if the contact were removed after the route was computed:
+ *              the Yen's references of the other routes are updated.
+ *
+ * \par Revision History:
+ *
+ *  DD/MM/YY |  AUTHOR         |   DESCRIPTION
+ *  -------- | --------------- | -----------------------------------------------
+ *  18/10/26 | agent           |  Initial Implementation and documentation.
+ *****************************************************************************/
+int snapshot_restore(UniboCGRSAP *uniboCgrSap, Snapshot *snapshot)
+{
+	const SnapshotHeader *header = snapshot->header;
+	const SnapshotRoute *record;
+	Contact **contacts;
+	Route **routes, *father;
+	unsigned char *discarded;
+	Node *node;
+	uint64_t i, j;
+	int priority, temp, result = 0;
+	const time_t shift = (time_t) header->timeBase - UniboCGRSAP_get_time_base(uniboCgrSap);
+
+	contacts = (Contact**) MWITHDRAW(sizeof(Contact*) * (header->contactsCount > 0 ? header->contactsCount : 1));
+	routes = (Route**) MWITHDRAW(sizeof(Route*) * (header->routesCount > 0 ? header->routesCount : 1));
+	discarded = (unsigned char*) MWITHDRAW(header->routesCount > 0 ? header->routesCount : 1);
+	if (contacts == NULL || routes == NULL || discarded == NULL)
+	{
+		MDEPOSIT(contacts);
+		MDEPOSIT(routes);
+		MDEPOSIT(discarded);
+		return -2;
+	}
+	memset(routes, 0, sizeof(Route*) * header->routesCount);
+	memset(discarded, 0, header->routesCount);
+
+	for (i = 0; i < header->contactsCount; i++)
+	{
+		contacts[i] = get_contact(uniboCgrSap, snapshot->contacts[i].fromNode, snapshot->contacts[i].toNode,
+				(time_t) snapshot->contacts[i].fromTime + shift, NULL);
+		if (contacts[i] != NULL)
+		{
+			for (priority = 0; priority < 3; priority++)
+			{
+				contacts[i]->mtv[priority] = convert_volume_to_mtv(snapshot->contacts[i].mtv[priority]);
+			}
+		}
+	}
+
+	for (i = 0; i < header->routesCount && result == 0; i++)
+	{
+		temp = create_snapshot_route(uniboCgrSap, snapshot, &snapshot->routes[i], contacts, shift, &routes[i]);
+		if (temp == -1)
+		{
+			discarded[i] = 1;
+		}
+		else if (temp < 0)
+		{
+			result = -2;
+		}
+	}
+
+	// Yen's references, the fathers can follow their sons in the routes section
+	for (i = 0; i < header->routesCount && result == 0; i++)
+	{
+		record = &snapshot->routes[i];
+		if (record->father >= 0)
+		{
+			father = routes[record->father];
+			routes[i]->citationToFather = list_insert_last(father->children, routes[i]);
+			if (routes[i]->citationToFather == NULL)
+			{
+				result = -2;
+			}
+		}
+		if (record->selectedFather >= 0)
+		{
+			father = routes[record->selectedFather];
+			routes[i]->selectedFather = father;
+			father->selectedChild = routes[i];
+		}
+	}
+
+	// insert_*_route() insert as first element: backward to keep the saved order
+	for (j = header->routesCount; j > 0 && result == 0; j--)
+	{
+		i = j - 1;
+		if (discarded[i])
+		{
+			continue;
+		}
+		record = &snapshot->routes[i];
+		node = add_node(uniboCgrSap, record->destination);
+		if (node == NULL)
+		{
+			result = -2;
+		}
+		else if (record->known)
+		{
+			result = insert_known_route(node->routingObject, routes[i]);
+		}
+		else
+		{
+			result = insert_selected_route(node->routingObject, routes[i]);
+		}
+	}
+
+	for (i = 0; i < header->routesCount; i++)
+	{
+		// not inserted in the lists
+		if (routes[i] != NULL && routes[i]->referenceElt == NULL)
+		{
+			delete_cgr_route(routes[i]);
+		}
+	}
+
+	if (result < 0)
+	{
+		reset_NodesTree(uniboCgrSap);
+		result = -2;
+	}
+	else
+	{
+		for (i = 0; i < header->routesCount; i++)
+		{
+			if (!discarded[i])
+			{
+				result++;
+			}
+		}
+	}
+
+	MDEPOSIT(contacts);
+	MDEPOSIT(routes);
+	MDEPOSIT(discarded);
+
+	return result;
+}
@@ -0,0 +1,162 @@
+/** \file snapshot.h
+ *
+ * \brief  This file provides the definition of the snapshot file format,
+ *         with all the declarations of the functions to save and restore
+ *         the contact plan and the computed routes (warm restart).
+ *
+ * \details File layout (all the fields in host byte order):
+ *          - SnapshotHeader
+ *          - contactsCount BinaryPlanContact, in contacts graph order, with the current MTVs
+ *          - rangesCount BinaryPlanRange, in ranges graph order
+ *          - routesCount SnapshotRoute, grouped by destination: for each destination
+ *            the selected routes then the known routes, in list order
+ *          - hopsCount uint32_t: the hops of each route, as indexes of the contacts section
+ *
+ *          Contact, range and route times are relative to SnapshotHeader.timeBase.
+ *          The routes refer to other routes (Yen's father) by index of the routes section.
+ *
+ *
+ ** \copyright Copyright (c) 2020, Alma Mater Studiorum, University of Bologna, All rights reserved.
+ **
+ ** \par License
+ **
+ **    This file is part of Unibo-CGR.                                            <br>
+ **                                                                               <br>
+ **    Unibo-CGR is free software: you can redistribute it and/or modify
+ **    it under the terms of the GNU General Public License as published by
+ **    the Free Software Foundation, either version 3 of the License, or
+ **    (at your option) any later version.                                        <br>
+ **    Unibo-CGR is distributed in the hope that it will be useful,
+ **    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ **    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ **    GNU General Public License for more details.                               <br>
+ **                                                                               <br>
+ **    You should have received a copy of the GNU General Public License
+ **    along with Unibo-CGR.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  \author agent, agent@local
+ *
+ *  \par Supervisor
+ *       Carlo Caini, carlo.caini@unibo.it
+ */
+
+#ifndef SOURCES_SNAPSHOT_SNAPSHOT_H_
+#define SOURCES_SNAPSHOT_SNAPSHOT_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/time.h>
+
+#include "../UniboCGRSAP.h"
+#include "../library/commonDefines.h"
+#include "../contact_plan/binary_plan/binary_plan.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#define SNAPSHOT_MAGIC "UCGRSNAP"
+#define SNAPSHOT_VERSION 1
+
+typedef struct
+{
+	/**
+	 * \brief SNAPSHOT_MAGIC (without the terminating '\0')
+	 */
+	char magic[8];
+	uint32_t version;
+	/**
+	 * \brief BINARY_PLAN_BYTE_ORDER
+	 */
+	uint32_t byteOrder;
+	/**
+	 * \brief Size of the header and of each record, checked when the file is mapped
+	 */
+	uint32_t headerSize;
+	uint32_t contactRecordSize;
+	uint32_t rangeRecordSize;
+	uint32_t routeRecordSize;
+	/**
+	 * \brief Unix time of the internal time 0 when the snapshot has been saved
+	 */
+	int64_t timeBase;
+	/**
+	 * \brief Hash of the contacts and ranges sections (see snapshot_plan_matches())
+	 */
+	uint64_t planHash;
+	uint64_t contactsCount;
+	uint64_t contactsOffset;
+	uint64_t rangesCount;
+	uint64_t rangesOffset;
+	uint64_t routesCount;
+	uint64_t routesOffset;
+	uint64_t hopsCount;
+	uint64_t hopsOffset;
+} SnapshotHeader;
+
+typedef struct
+{
+	/**
+	 * \brief The node in which the route is stored
+	 */
+	uint64_t destination;
+	uint64_t neighbor;
+	uint64_t owltSum;
+	int64_t arrivalTime;
+	int64_t computedAtTime;
+	int64_t validUntil;
+	int64_t fromTime;
+	int64_t toTime;
+	/**
+	 * \brief Index (in the hops section) of the first hop
+	 */
+	uint64_t firstHop;
+	/**
+	 * \brief Index (in the routes section) of the Yen's father, -1 if none
+	 */
+	int64_t father;
+	/**
+	 * \brief Index (in the routes section) of the selected father, -1 if none
+	 */
+	int64_t selectedFather;
+	uint32_t hopsCount;
+	/**
+	 * \brief Position of the root of spur in the hops, -1 if none
+	 */
+	int32_t rootOfSpur;
+	float arrivalConfidence;
+	/**
+	 * \brief 1 if the route is in the known routes (Yen's "list B"),
+	 *        0 if it is in the selected routes
+	 */
+	uint8_t known;
+	uint8_t spursComputed;
+	uint16_t reserved;
+} SnapshotRoute;
+
+/**
+ * \brief A snapshot file mapped in memory (read only).
+ */
+typedef struct
+{
+	void *base;
+	size_t size;
+	const SnapshotHeader *header;
+	const BinaryPlanContact *contacts;
+	const BinaryPlanRange *ranges;
+	const SnapshotRoute *routes;
+	const uint32_t *hops;
+} Snapshot;
+
+extern int snapshot_write(UniboCGRSAP *uniboCgrSap, const char *fileName);
+extern int snapshot_map(const char *fileName, Snapshot *snapshot);
+extern void snapshot_unmap(Snapshot *snapshot);
+extern int snapshot_plan_matches(UniboCGRSAP *uniboCgrSap, Snapshot *snapshot);
+extern int snapshot_restore(UniboCGRSAP *uniboCgrSap, Snapshot *snapshot);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SOURCES_SNAPSHOT_SNAPSHOT_H_ */
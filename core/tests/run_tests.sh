@@ -0,0 +1,36 @@
+#!/bin/bash
+#
+# Build and run the Unibo-CGR regression tests.
+#
+# Each tests/test_*.c is linked with the core sources listed in c_files.txt
+# (example_next_hop.c excluded) and run from a temporary directory.
+#
+# Usage (from the core directory): ./tests/run_tests.sh [extra gcc flags]
+# e.g. ./tests/run_tests.sh -fsanitize=address,undefined
+
+CORE_DIR="$(cd "$(dirname "$0")/.." && pwd)"
+BUILD_DIR="$(mktemp -d)"
+trap 'rm -rf "$BUILD_DIR"' EXIT
+
+SOURCES=""
+for f in $(grep -v 'example_next_hop.c' "$CORE_DIR/c_files.txt" | sort -u); do
+    SOURCES="$SOURCES $CORE_DIR/$f"
+done
+
+failed=0
+for test in "$CORE_DIR"/tests/test_*.c; do
+    name="$(basename "$test" .c)"
+    if ! gcc -std=gnu99 -O1 -g "$@" -o "$BUILD_DIR/$name" "$test" $SOURCES -lm -lpthread; then
+        echo "BUILD FAILED: $name"
+        failed=1
+        continue
+    fi
+    if (cd "$BUILD_DIR" && "./$name"); then
+        echo "PASSED: $name"
+    else
+        echo "FAILED: $name"
+        failed=1
+    fi
+done
+
+exit $failed
@@ -0,0 +1,221 @@
+/*
+ * test_common.h
+ *
+ * Helpers shared by the Unibo-CGR regression tests (see run_tests.sh).
+ * Each test is a standalone program that uses only the public API (include/UniboCGR.h)
+ * and exits with EXIT_FAILURE if at least one check failed.
+ * The helpers are static inline: each test uses only some of them.
+ */
+
+#ifndef UNIBO_CGR_TESTS_TEST_COMMON_H
+#define UNIBO_CGR_TESTS_TEST_COMMON_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+#include <time.h>
+#include <stdbool.h>
+
+#include "../../include/UniboCGR.h"
+
+static int test_failures = 0;
+
+#define CHECK(cond) do { \
+        if (!(cond)) { \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+            test_failures++; \
+        } \
+    } while (0)
+
+#define CHECK_ERROR(expr, expected) do { \
+        UniboCGR_Error check_error_rc = (expr); \
+        if (check_error_rc != (expected)) { \
+            fprintf(stderr, "%s:%d: %s returned \"%s\", expected \"%s\"\n", __FILE__, __LINE__, #expr, \
+                    UniboCGR_get_error_string(check_error_rc), UniboCGR_get_error_string(expected)); \
+            test_failures++; \
+        } \
+    } while (0)
+
+#define TEST_RESULT() ((test_failures == 0) ? EXIT_SUCCESS : EXIT_FAILURE)
+
+// no bundles enqueued toward any neighbor
+static inline int test_backlog(uint64_t neighbor, UniboCGR_BundlePriority priority, uint8_t ordinal,
+                               uint64_t *applicableBacklog, uint64_t *totalBacklog, void *userArg) {
+    (void) neighbor; (void) priority; (void) ordinal; (void) userArg;
+    *applicableBacklog = 0;
+    *totalBacklog = 0;
+    return 0;
+}
+
+static inline UniboCGR test_open(time_t now, uint64_t local_node) {
+    UniboCGR uniboCgr = NULL;
+    if (UniboCGR_open(&uniboCgr, now, 0, local_node, PhaseThreeCostFunction_default, test_backlog, NULL) != UniboCGR_NoError) {
+        fprintf(stderr, "Cannot open Unibo-CGR.\n");
+        exit(EXIT_FAILURE);
+    }
+    return uniboCgr;
+}
+
+/*
+ * Fill an API contact; start and end are relative to now.
+ */
+static inline void test_fill_contact(UniboCGR uniboCgr, UniboCGR_Contact contact, time_t now,
+                                     uint64_t sender, uint64_t receiver, time_t start, time_t end,
+                                     uint64_t xmit_rate, double mtv) {
+    UniboCGR_Contact_reset(contact);
+    UniboCGR_Contact_set_sender(contact, sender);
+    UniboCGR_Contact_set_receiver(contact, receiver);
+    UniboCGR_Contact_set_start_time(uniboCgr, contact, now + start);
+    UniboCGR_Contact_set_end_time(uniboCgr, contact, now + end);
+    UniboCGR_Contact_set_xmit_rate(contact, xmit_rate);
+    UniboCGR_Contact_set_confidence(contact, 1.0F);
+    UniboCGR_Contact_set_mtv_bulk(contact, mtv);
+    UniboCGR_Contact_set_mtv_normal(contact, mtv);
+    UniboCGR_Contact_set_mtv_expedited(contact, mtv);
+}
+
+static inline void test_fill_range(UniboCGR uniboCgr, UniboCGR_Range range, time_t now,
+                                   uint64_t sender, uint64_t receiver, time_t start, time_t end, uint64_t owlt) {
+    UniboCGR_Range_reset(range);
+    UniboCGR_Range_set_sender(range, sender);
+    UniboCGR_Range_set_receiver(range, receiver);
+    UniboCGR_Range_set_start_time(uniboCgr, range, now + start);
+    UniboCGR_Range_set_end_time(uniboCgr, range, now + end);
+    UniboCGR_Range_set_one_way_light_time(range, owlt);
+}
+
+/*
+ * Add a contact and its range (owlt 1 s) in the current contact plan session.
+ * The volume of the contact is xmit_rate * (end - start).
+ */
+static inline UniboCGR_Error test_add_link(UniboCGR uniboCgr, time_t now, uint64_t sender, uint64_t receiver,
+                                           time_t start, time_t end, uint64_t xmit_rate) {
+    UniboCGR_Contact contact;
+    UniboCGR_Range range;
+    UniboCGR_Error error;
+
+    if (UniboCGR_Contact_create(&contact) != UniboCGR_NoError) return UniboCgr_ErrorSystem;
+    test_fill_contact(uniboCgr, contact, now, sender, receiver, start, end, xmit_rate,
+                      (double) (xmit_rate * (uint64_t) (end - start)));
+    error = UniboCGR_contact_plan_add_contact(uniboCgr, contact, true);
+    UniboCGR_Contact_destroy(&contact);
+    if (error != UniboCGR_NoError) return error;
+
+    if (UniboCGR_Range_create(&range) != UniboCGR_NoError) return UniboCgr_ErrorSystem;
+    test_fill_range(uniboCgr, range, now, sender, receiver, start, end, 1);
+    error = UniboCGR_contact_plan_add_range(uniboCgr, range);
+    UniboCGR_Range_destroy(&range);
+    return error;
+}
+
+static inline UniboCGR_Bundle test_bundle(time_t now, uint64_t destination, uint64_t previous_node, uint64_t payload) {
+    UniboCGR_Bundle bundle = NULL;
+    if (UniboCGR_Bundle_create(&bundle) != UniboCGR_NoError) {
+        fprintf(stderr, "Cannot create a bundle.\n");
+        exit(EXIT_FAILURE);
+    }
+    UniboCGR_Bundle_set_bundle_protocol_version(bundle, 7);
+    UniboCGR_Bundle_set_source_node_id(bundle, "ipn:100.1");
+    // DTN epoch (2000-01-01) in milliseconds
+    UniboCGR_Bundle_set_creation_time(bundle, (uint64_t) (now - 946684800) * 1000ULL);
+    UniboCGR_Bundle_set_lifetime(bundle, 100000ULL * 1000ULL);
+    UniboCGR_Bundle_set_destination_node_id(bundle, destination);
+    UniboCGR_Bundle_set_previous_node_id(bundle, previous_node);
+    UniboCGR_Bundle_set_payload_length(bundle, payload);
+    UniboCGR_Bundle_set_priority_normal(bundle);
+    return bundle;
+}
+
+/*
+ * Bitmask of the neighbors (node numbers < 64) of the routes in the list.
+ */
+static inline uint64_t test_route_neighbors(UniboCGR uniboCgr, UniboCGR_route_list routes) {
+    UniboCGR_Route route;
+    uint64_t mask = 0;
+
+    if (routes == NULL || UniboCGR_get_first_route(uniboCgr, routes, &route) != UniboCGR_NoError) {
+        return 0;
+    }
+    do {
+        uint64_t neighbor = UniboCGR_Route_get_neighbor(route);
+        if (neighbor < 64) mask |= (1ULL << neighbor);
+    } while (UniboCGR_get_next_route(uniboCgr, &route) == UniboCGR_NoError);
+
+    return mask;
+}
+
+#define NODE_BIT(node) (1ULL << (node))
+
+/*
+ * Route a bundle (payload 1000 bytes) created at created toward destination at the time now.
+ * critical: a route for each neighbor that can reach the destination.
+ * neighbors: bitmask of the neighbors of the routes found, 0 if none.
+ */
+static inline UniboCGR_Error test_route(UniboCGR uniboCgr, time_t created, time_t now, uint64_t destination,
+                                        bool critical, uint64_t *neighbors) {
+    UniboCGR_excluded_neighbors_list excluded;
+    UniboCGR_Bundle bundle = test_bundle(created, destination, 0, 1000);
+    UniboCGR_route_list routes = NULL;
+    UniboCGR_Error error;
+
+    UniboCGR_Bundle_set_flag_critical(bundle, critical);
+    CHECK_ERROR(UniboCGR_create_excluded_neighbors_list(&excluded), UniboCGR_NoError);
+    CHECK_ERROR(UniboCGR_routing_open(uniboCgr, now), UniboCGR_NoError);
+    error = UniboCGR_routing(uniboCgr, bundle, excluded, &routes);
+    *neighbors = (error == UniboCGR_NoError) ? test_route_neighbors(uniboCgr, routes) : 0;
+    CHECK_ERROR(UniboCGR_routing_close(uniboCgr), UniboCGR_NoError);
+
+    UniboCGR_destroy_excluded_neighbors_list(&excluded);
+    UniboCGR_Bundle_destroy(&bundle);
+    return error;
+}
+
+/*
+ * As test_route() for a bundle created now, returns the neighbors bitmask.
+ */
+static inline uint64_t test_route_to(UniboCGR uniboCgr, time_t now, uint64_t destination, bool critical) {
+    uint64_t neighbors = 0;
+    test_route(uniboCgr, now, now, destination, critical, &neighbors);
+    return neighbors;
+}
+
+/*
+ * The number of routes computed so far, counted through a snapshot
+ * (UniboCGR_snapshot_load() returns the routes restored).
+ */
+static inline uint32_t test_computed_routes(UniboCGR uniboCgr, time_t now, uint64_t local_node) {
+    UniboCGR other = test_open(now, local_node);
+    uint32_t routes = 0;
+
+    CHECK_ERROR(UniboCGR_snapshot_save(uniboCgr, "routes.snapshot"), UniboCGR_NoError);
+    CHECK_ERROR(UniboCGR_contact_plan_open(other, now), UniboCGR_NoError);
+    CHECK_ERROR(UniboCGR_snapshot_load(other, "routes.snapshot", &routes), UniboCGR_NoError);
+    CHECK_ERROR(UniboCGR_contact_plan_close(other), UniboCGR_NoError);
+    UniboCGR_close(&other, now);
+    return routes;
+}
+
+static inline uint32_t test_count_contacts(UniboCGR uniboCgr) {
+    UniboCGR_Contact contact;
+    uint32_t count = 0;
+    for (UniboCGR_Error error = UniboCGR_get_first_contact(uniboCgr, &contact);
+         error == UniboCGR_NoError;
+         error = UniboCGR_get_next_contact(uniboCgr, &contact)) {
+        count++;
+    }
+    return count;
+}
+
+static inline uint32_t test_count_ranges(UniboCGR uniboCgr) {
+    UniboCGR_Range range;
+    uint32_t count = 0;
+    for (UniboCGR_Error error = UniboCGR_get_first_range(uniboCgr, &range);
+         error == UniboCGR_NoError;
+         error = UniboCGR_get_next_range(uniboCgr, &range)) {
+        count++;
+    }
+    return count;
+}
+
+#endif /* UNIBO_CGR_TESTS_TEST_COMMON_H */
@@ -0,0 +1,108 @@
+/*
+ * test_contact_edits.c
+ *
+ * Contact changes that can only make a contact worse (removal, later start, earlier end)
+ * keep the routes of the destinations not reached through the contact. The routing results
+ * must be the same as an instance that computes every route again from the final
+ * contact plan (full reset).
+ * Critical bundles: a route through each neighbor that can reach the destination.
+ * The computed routes are counted through a snapshot (UniboCGR_snapshot_load() returns the routes restored).
+ */
+
+#include "test_common.h"
+
+#define LOCAL_NODE 1
+#define DESTINATION 9
+#define OTHER_DESTINATION 8
+
+typedef enum {
+    EditRemove,
+    EditStartTime,
+    EditEndTime
+} Edit;
+
+/*
+ * Neighbors 2, 3, 4 and 5 toward the destination, 6 toward the other destination.
+ * edited: the contacts from 3, 4 and 5 to the destination already changed.
+ */
+static void add_contact_plan(UniboCGR uniboCgr, time_t now, Edit edit, bool edited) {
+    CHECK_ERROR(UniboCGR_contact_plan_open(uniboCgr, now), UniboCGR_NoError);
+    for (uint64_t neighbor = 2; neighbor <= 5; neighbor++) {
+        const bool changed = edited && neighbor != 2;
+        CHECK_ERROR(test_add_link(uniboCgr, now, LOCAL_NODE, neighbor, 0, 1000, 100000), UniboCGR_NoError);
+        if (!changed) {
+            CHECK_ERROR(test_add_link(uniboCgr, now, neighbor, DESTINATION, 100, 1000, 100000), UniboCGR_NoError);
+        } else if (edit == EditStartTime) {
+            CHECK_ERROR(test_add_link(uniboCgr, now, neighbor, DESTINATION, 500, 1000, 100000), UniboCGR_NoError);
+        } else if (edit == EditEndTime) {
+            CHECK_ERROR(test_add_link(uniboCgr, now, neighbor, DESTINATION, 100, 500, 100000), UniboCGR_NoError);
+        }
+    }
+    CHECK_ERROR(test_add_link(uniboCgr, now, LOCAL_NODE, 6, 0, 1000, 100000), UniboCGR_NoError);
+    CHECK_ERROR(test_add_link(uniboCgr, now, 6, OTHER_DESTINATION, 0, 1000, 100000), UniboCGR_NoError);
+    CHECK_ERROR(UniboCGR_contact_plan_close(uniboCgr), UniboCGR_NoError);
+}
+
+static void edit_contact(UniboCGR uniboCgr, time_t now, Edit edit, uint64_t sender) {
+    switch (edit) {
+        case EditRemove:
+            CHECK_ERROR(UniboCGR_contact_plan_remove_contact(uniboCgr, UniboCGR_ContactType_Scheduled,
+                                                             sender, DESTINATION, now + 100),
+                        UniboCGR_NoError);
+            break;
+        case EditStartTime:
+            CHECK_ERROR(UniboCGR_contact_plan_change_contact_start_time(uniboCgr, UniboCGR_ContactType_Scheduled,
+                                                                        sender, DESTINATION, now + 100, now + 500),
+                        UniboCGR_NoError);
+            break;
+        case EditEndTime:
+            CHECK_ERROR(UniboCGR_contact_plan_change_contact_end_time(uniboCgr, UniboCGR_ContactType_Scheduled,
+                                                                      sender, DESTINATION, now + 100, now + 500),
+                        UniboCGR_NoError);
+            break;
+    }
+}
+
+static void run(time_t now, Edit edit) {
+    UniboCGR edited = test_open(now, LOCAL_NODE);
+    UniboCGR fresh = test_open(now, LOCAL_NODE);
+    uint64_t expected;
+    uint32_t otherRoutes;
+
+    add_contact_plan(edited, now, edit, false);
+    CHECK(test_route_to(edited, now, OTHER_DESTINATION, true) == NODE_BIT(6));
+    otherRoutes = test_computed_routes(edited, now, LOCAL_NODE);
+    CHECK(otherRoutes > 0);
+    CHECK(test_route_to(edited, now, DESTINATION, true) == (NODE_BIT(2) | NODE_BIT(3) | NODE_BIT(4) | NODE_BIT(5)));
+
+    // only the route through 2 is not affected: more neighbors to find than routes left
+    CHECK_ERROR(UniboCGR_contact_plan_open(edited, now), UniboCGR_NoError);
+    edit_contact(edited, now, edit, 3);
+    edit_contact(edited, now, edit, 4);
+    edit_contact(edited, now, edit, 5);
+    CHECK_ERROR(UniboCGR_contact_plan_close(edited), UniboCGR_NoError);
+    // the route through 2 was computed along with the changed ones: it goes away too,
+    // the routes of the other destination are kept
+    CHECK(test_computed_routes(edited, now, LOCAL_NODE) == otherRoutes);
+
+    add_contact_plan(fresh, now, edit, true);
+
+    expected = test_route_to(fresh, now, DESTINATION, true);
+    CHECK(expected == ((edit == EditRemove) ? NODE_BIT(2)
+                                            : (NODE_BIT(2) | NODE_BIT(3) | NODE_BIT(4) | NODE_BIT(5))));
+    CHECK(test_route_to(edited, now, DESTINATION, true) == expected);
+    CHECK(test_route_to(edited, now, OTHER_DESTINATION, true) == test_route_to(fresh, now, OTHER_DESTINATION, true));
+
+    UniboCGR_close(&edited, now);
+    UniboCGR_close(&fresh, now);
+}
+
+int main(void) {
+    time_t now = time(NULL);
+
+    run(now, EditRemove);
+    run(now, EditStartTime);
+    run(now, EditEndTime);
+
+    return TEST_RESULT();
+}
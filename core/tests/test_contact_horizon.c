@@ -0,0 +1,63 @@
+/*
+ * test_contact_horizon.c
+ *
+ * Contact horizon: the contacts that start beyond the horizon are kept apart,
+ * promoted as the time advances or when a routing call needs them.
+ */
+
+#include "test_common.h"
+
+#define LOCAL_NODE 1
+
+int main(void) {
+    time_t now = time(NULL);
+    UniboCGR uniboCgr = test_open(now, LOCAL_NODE);
+    time_t horizon = 0;
+
+    CHECK(!UniboCGR_feature_ContactHorizon_check(uniboCgr, &horizon));
+    CHECK_ERROR(UniboCGR_feature_open(uniboCgr, now), UniboCGR_NoError);
+    CHECK_ERROR(UniboCGR_feature_ContactHorizon_enable(uniboCgr, 0), UniboCGR_ErrorInvalidArgument);
+    CHECK_ERROR(UniboCGR_feature_ContactHorizon_enable(uniboCgr, 100), UniboCGR_NoError);
+    CHECK_ERROR(UniboCGR_feature_close(uniboCgr), UniboCGR_NoError);
+    CHECK(UniboCGR_feature_ContactHorizon_check(uniboCgr, &horizon));
+    CHECK(horizon == 100);
+
+    // 2 now, 3 and 4 far beyond the horizon
+    CHECK_ERROR(UniboCGR_contact_plan_open(uniboCgr, now), UniboCGR_NoError);
+    CHECK_ERROR(test_add_link(uniboCgr, now, LOCAL_NODE, 2, 0, 100000, 100000), UniboCGR_NoError);
+    CHECK_ERROR(test_add_link(uniboCgr, now, LOCAL_NODE, 3, 1000, 2000, 100000), UniboCGR_NoError);
+    CHECK_ERROR(test_add_link(uniboCgr, now, LOCAL_NODE, 4, 50000, 60000, 100000), UniboCGR_NoError);
+    CHECK_ERROR(UniboCGR_contact_plan_close(uniboCgr), UniboCGR_NoError);
+
+    // out of the contact plan sessions only the contacts within the horizon are visited
+    CHECK(test_count_contacts(uniboCgr) == 1);
+    CHECK(test_route_to(uniboCgr, now, 2, false) == NODE_BIT(2));
+
+    // the contact to 3 is needed: the horizon grows up to the bundle expiration
+    CHECK(test_route_to(uniboCgr, now, 3, false) == NODE_BIT(3));
+    CHECK(test_count_contacts(uniboCgr) == 3);
+
+    // disabled: every contact is in the graph
+    CHECK_ERROR(UniboCGR_feature_open(uniboCgr, now), UniboCGR_NoError);
+    CHECK_ERROR(UniboCGR_feature_ContactHorizon_disable(uniboCgr), UniboCGR_NoError);
+    CHECK_ERROR(UniboCGR_feature_close(uniboCgr), UniboCGR_NoError);
+    CHECK(!UniboCGR_feature_ContactHorizon_check(uniboCgr, NULL));
+    CHECK(test_count_contacts(uniboCgr) == 3);
+    UniboCGR_close(&uniboCgr, now);
+
+    // promoted as the time advances
+    uniboCgr = test_open(now, LOCAL_NODE);
+    CHECK_ERROR(UniboCGR_feature_open(uniboCgr, now), UniboCGR_NoError);
+    CHECK_ERROR(UniboCGR_feature_ContactHorizon_enable(uniboCgr, 100), UniboCGR_NoError);
+    CHECK_ERROR(UniboCGR_feature_close(uniboCgr), UniboCGR_NoError);
+    CHECK_ERROR(UniboCGR_contact_plan_open(uniboCgr, now), UniboCGR_NoError);
+    CHECK_ERROR(test_add_link(uniboCgr, now, LOCAL_NODE, 2, 0, 100000, 100000), UniboCGR_NoError);
+    CHECK_ERROR(test_add_link(uniboCgr, now, LOCAL_NODE, 3, 1000, 2000, 100000), UniboCGR_NoError);
+    CHECK_ERROR(UniboCGR_contact_plan_close(uniboCgr), UniboCGR_NoError);
+    CHECK(test_count_contacts(uniboCgr) == 1);
+    CHECK(test_route_to(uniboCgr, now + 950, 2, false) == NODE_BIT(2));
+    CHECK(test_count_contacts(uniboCgr) == 2);
+    UniboCGR_close(&uniboCgr, now + 950);
+
+    return TEST_RESULT();
+}
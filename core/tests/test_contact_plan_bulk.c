@@ -0,0 +1,86 @@
+/*
+ * test_contact_plan_bulk.c
+ *
+ * UniboCGR_contact_plan_add_contacts_bulk() / UniboCGR_contact_plan_add_ranges_bulk():
+ * unsorted input, merge with the contact plan (bottom-up rebuild), all or nothing.
+ */
+
+#include "test_common.h"
+
+#define LOCAL_NODE 1
+#define COUNT 600
+
+static void fill_contact(UniboCGR_FlatContact* contact, time_t now, uint64_t sender, uint64_t receiver,
+                         time_t start, time_t end) {
+    memset(contact, 0, sizeof(*contact));
+    contact->sender = sender;
+    contact->receiver = receiver;
+    contact->start_time = now + start;
+    contact->end_time = now + end;
+    contact->xmit_rate = 1000;
+    contact->confidence = 1.0F;
+    contact->mtv[0] = contact->mtv[1] = contact->mtv[2] = 123.0;
+}
+
+static void fill_range(UniboCGR_FlatRange* range, time_t now, uint64_t sender, uint64_t receiver,
+                       time_t start, time_t end) {
+    range->sender = sender;
+    range->receiver = receiver;
+    range->start_time = now + start;
+    range->end_time = now + end;
+    range->one_way_light_time = 1;
+}
+
+int main(void) {
+    time_t now = time(NULL);
+    UniboCGR uniboCgr = test_open(now, LOCAL_NODE);
+    static UniboCGR_FlatContact contacts[COUNT];
+    static UniboCGR_FlatRange ranges[COUNT];
+    UniboCGR_FlatContact extra[2];
+    UniboCGR_FlatRange extraRange;
+    UniboCGR_Contact contact;
+    uint32_t i;
+
+    CHECK_ERROR(UniboCGR_contact_plan_open(uniboCgr, now), UniboCGR_NoError);
+    // already in the contact plan: merged with the bulk ones
+    CHECK_ERROR(test_add_link(uniboCgr, now, 2, 3, 0, 10, 1000), UniboCGR_NoError);
+
+    // reverse order, 6 node pairs with 100 contacts each (the first one already expired)
+    for (i = 0; i < COUNT; i++) {
+        uint32_t k = COUNT - 1 - i;
+        time_t start = (time_t) (k % 100) * 20 - 20;
+        fill_contact(&contacts[i], now, 1 + k / 100, 10, start, start + 10);
+        fill_range(&ranges[i], now, 1 + k / 100, 10, start, start + 10);
+    }
+    CHECK_ERROR(UniboCGR_contact_plan_add_contacts_bulk(uniboCgr, contacts, COUNT, true), UniboCGR_NoError);
+    CHECK_ERROR(UniboCGR_contact_plan_add_ranges_bulk(uniboCgr, ranges, COUNT), UniboCGR_NoError);
+    // 1 + 6 * 99 (start -20: expired)
+    CHECK(test_count_contacts(uniboCgr) == 595);
+    CHECK(test_count_ranges(uniboCgr) == 595);
+    CHECK_ERROR(UniboCGR_find_contact(uniboCgr, UniboCGR_ContactType_Scheduled, 4, 10, now + 40, &contact), UniboCGR_NoError);
+    CHECK(UniboCGR_Contact_get_mtv_normal(contact) == 123.0);
+    CHECK_ERROR(UniboCGR_find_contact(uniboCgr, UniboCGR_ContactType_Scheduled, 4, 10, now - 20, &contact), UniboCGR_ErrorContactNotFound);
+
+    // all or nothing: a contact is not valid, or overlaps
+    fill_contact(&extra[0], now, 7, 10, 0, 10);
+    fill_contact(&extra[1], now, 8, 10, 20, 10);
+    CHECK_ERROR(UniboCGR_contact_plan_add_contacts_bulk(uniboCgr, extra, 2, false), UniboCGR_ErrorInvalidArgument);
+    fill_contact(&extra[1], now, 2, 3, 5, 15);
+    CHECK_ERROR(UniboCGR_contact_plan_add_contacts_bulk(uniboCgr, extra, 2, false), UniboCGR_ErrorFoundOverlappingContact);
+    fill_contact(&extra[1], now, 7, 10, 5, 15);
+    CHECK_ERROR(UniboCGR_contact_plan_add_contacts_bulk(uniboCgr, extra, 2, false), UniboCGR_ErrorFoundOverlappingContact);
+    CHECK(test_count_contacts(uniboCgr) == 595);
+
+    // an existing range is not revised
+    fill_range(&extraRange, now, 1, 10, 0, 15);
+    CHECK_ERROR(UniboCGR_contact_plan_add_ranges_bulk(uniboCgr, &extraRange, 1), UniboCGR_ErrorFoundOverlappingRange);
+    CHECK(test_count_ranges(uniboCgr) == 595);
+    CHECK_ERROR(UniboCGR_contact_plan_close(uniboCgr), UniboCGR_NoError);
+
+    // only within a contact plan session
+    CHECK_ERROR(UniboCGR_contact_plan_add_contacts_bulk(uniboCgr, extra, 1, false), UniboCGR_ErrorSessionClosed);
+
+    UniboCGR_close(&uniboCgr, now);
+
+    return TEST_RESULT();
+}
@@ -0,0 +1,227 @@
+/*
+ * test_contact_plan_delta.c
+ *
+ * UniboCGR_contact_plan_apply_delta(): the operations that cannot be applied are skipped
+ * one by one, the overlaps are checked against the contact plan after the removals,
+ * a delta rejected as a whole leaves the contact plan untouched.
+ * UniboCGR_ContactPlanDelta_diff_contacts(): the diff of two plans applied to the first one.
+ */
+
+#include "test_common.h"
+
+#define LOCAL_NODE 1
+
+static UniboCGR_FlatContact flat_contact(time_t now, uint64_t sender, uint64_t receiver,
+                                         time_t start, time_t end, uint64_t xmit_rate, float confidence) {
+    UniboCGR_FlatContact contact;
+    memset(&contact, 0, sizeof(contact));
+    contact.sender = sender;
+    contact.receiver = receiver;
+    contact.start_time = now + start;
+    contact.end_time = now + end;
+    contact.xmit_rate = xmit_rate;
+    contact.confidence = confidence;
+    return contact;
+}
+
+/*
+ * The contacts from 1 to 2 as "start-end,start-end,..." (relative to now).
+ */
+static void contacts_string(UniboCGR uniboCgr, time_t now, char *buffer, size_t size) {
+    UniboCGR_Contact contact;
+    size_t length = 0;
+    buffer[0] = '\0';
+    for (UniboCGR_Error error = UniboCGR_get_first_contact(uniboCgr, &contact);
+         error == UniboCGR_NoError && length < size;
+         error = UniboCGR_get_next_contact(uniboCgr, &contact)) {
+        if (UniboCGR_Contact_get_sender(contact) != 1 || UniboCGR_Contact_get_receiver(contact) != 2) continue;
+        length += (size_t) snprintf(buffer + length, size - length, "%s%ld-%ld", length > 0 ? "," : "",
+                                    (long) (UniboCGR_Contact_get_start_time(uniboCgr, contact) - now),
+                                    (long) (UniboCGR_Contact_get_end_time(uniboCgr, contact) - now));
+    }
+}
+
+static UniboCGR open_plan(time_t now) {
+    UniboCGR uniboCgr = test_open(now, LOCAL_NODE);
+    CHECK_ERROR(UniboCGR_contact_plan_open(uniboCgr, now), UniboCGR_NoError);
+    CHECK_ERROR(test_add_link(uniboCgr, now, 1, 2, 0, 100, 1000), UniboCGR_NoError);
+    CHECK_ERROR(test_add_link(uniboCgr, now, 1, 2, 200, 300, 1000), UniboCGR_NoError);
+    CHECK_ERROR(test_add_link(uniboCgr, now, 1, 2, 400, 500, 1000), UniboCGR_NoError);
+    CHECK_ERROR(UniboCGR_contact_plan_close(uniboCgr), UniboCGR_NoError);
+    return uniboCgr;
+}
+
+static UniboCGR_Error apply(UniboCGR uniboCgr, time_t now, UniboCGR_ContactPlanDelta delta) {
+    UniboCGR_Error error;
+    CHECK_ERROR(UniboCGR_contact_plan_open(uniboCgr, now), UniboCGR_NoError);
+    error = UniboCGR_contact_plan_apply_delta(uniboCgr, delta, false);
+    CHECK_ERROR(UniboCGR_contact_plan_close(uniboCgr), UniboCGR_NoError);
+    UniboCGR_ContactPlanDelta_reset(delta);
+    return error;
+}
+
+static void test_skip_invalid_records(void) {
+    time_t now = time(NULL);
+    UniboCGR uniboCgr = open_plan(now);
+    UniboCGR_ContactPlanDelta delta;
+    UniboCGR_FlatContact contact;
+    UniboCGR_Contact found;
+    UniboCGR_FlatRange range;
+    UniboCGR_Range foundRange;
+    char plan[256];
+
+    CHECK_ERROR(UniboCGR_ContactPlanDelta_create(&delta), UniboCGR_NoError);
+
+    // invalid confidence, start before the time base, overlap: only the valid contact is added
+    contact = flat_contact(now, 1, 2, 600, 700, 1000, 2.0F);
+    CHECK_ERROR(UniboCGR_ContactPlanDelta_add_contact(delta, &contact), UniboCGR_NoError);
+    contact = flat_contact(now, 1, 2, -1000, 50, 1000, 1.0F);
+    CHECK_ERROR(UniboCGR_ContactPlanDelta_add_contact(delta, &contact), UniboCGR_NoError);
+    contact = flat_contact(now, 1, 2, 250, 350, 1000, 1.0F);
+    CHECK_ERROR(UniboCGR_ContactPlanDelta_add_contact(delta, &contact), UniboCGR_NoError);
+    contact = flat_contact(now, 1, 2, 800, 900, 1000, 1.0F);
+    CHECK_ERROR(UniboCGR_ContactPlanDelta_add_contact(delta, &contact), UniboCGR_NoError);
+    // change of a contact not in the plan
+    CHECK_ERROR(UniboCGR_ContactPlanDelta_change_contact_xmit_rate(delta, 1, 2, now + 150, 5), UniboCGR_NoError);
+    CHECK_ERROR(apply(uniboCgr, now, delta), UniboCGR_NoError);
+    contacts_string(uniboCgr, now, plan, sizeof(plan));
+    CHECK(strcmp(plan, "0-100,200-300,400-500,800-900") == 0);
+
+    // the end time overlaps the next contact: only that change is skipped
+    CHECK_ERROR(UniboCGR_ContactPlanDelta_change_contact_end_time(delta, 1, 2, now, now + 250), UniboCGR_NoError);
+    CHECK_ERROR(UniboCGR_ContactPlanDelta_change_contact_xmit_rate(delta, 1, 2, now, 7), UniboCGR_NoError);
+    CHECK_ERROR(apply(uniboCgr, now, delta), UniboCGR_NoError);
+    contacts_string(uniboCgr, now, plan, sizeof(plan));
+    CHECK(strcmp(plan, "0-100,200-300,400-500,800-900") == 0);
+    CHECK_ERROR(UniboCGR_find_contact(uniboCgr, UniboCGR_ContactType_Scheduled, 1, 2, now, &found), UniboCGR_NoError);
+    CHECK(UniboCGR_Contact_get_xmit_rate(found) == 7);
+
+    // the same for the ranges
+    range.sender = 1;
+    range.receiver = 2;
+    range.one_way_light_time = 1;
+    range.start_time = now + 250;
+    range.end_time = now + 350;
+    CHECK_ERROR(UniboCGR_ContactPlanDelta_add_range(delta, &range), UniboCGR_NoError);
+    range.start_time = now + 800;
+    range.end_time = now + 900;
+    CHECK_ERROR(UniboCGR_ContactPlanDelta_add_range(delta, &range), UniboCGR_NoError);
+    range.receiver = 0;
+    CHECK_ERROR(UniboCGR_ContactPlanDelta_add_range(delta, &range), UniboCGR_NoError);
+    CHECK_ERROR(UniboCGR_ContactPlanDelta_change_range_end_time(delta, 1, 2, now + 200, now + 450), UniboCGR_NoError);
+    CHECK_ERROR(UniboCGR_ContactPlanDelta_change_range_one_way_light_time(delta, 1, 2, now + 200, 3), UniboCGR_NoError);
+    CHECK_ERROR(apply(uniboCgr, now, delta), UniboCGR_NoError);
+    CHECK_ERROR(UniboCGR_find_range(uniboCgr, 1, 2, now + 250, &foundRange), UniboCGR_ErrorRangeNotFound);
+    CHECK_ERROR(UniboCGR_find_range(uniboCgr, 1, 2, now + 800, &foundRange), UniboCGR_NoError);
+    CHECK_ERROR(UniboCGR_find_range(uniboCgr, 1, 2, now + 200, &foundRange), UniboCGR_NoError);
+    CHECK(UniboCGR_Range_get_end_time(uniboCgr, foundRange) == now + 300);
+    CHECK(UniboCGR_Range_get_one_way_light_time(foundRange) == 3);
+
+    UniboCGR_ContactPlanDelta_destroy(&delta);
+    UniboCGR_close(&uniboCgr, now);
+}
+
+static void test_overlaps_after_removals(void) {
+    time_t now = time(NULL);
+    UniboCGR uniboCgr = open_plan(now);
+    UniboCGR_ContactPlanDelta delta;
+    UniboCGR_FlatContact contact;
+    char plan[256];
+
+    CHECK_ERROR(UniboCGR_ContactPlanDelta_create(&delta), UniboCGR_NoError);
+
+    // the new contact overlaps only the removed one
+    CHECK_ERROR(UniboCGR_ContactPlanDelta_remove_contact(delta, 1, 2, now + 200), UniboCGR_NoError);
+    contact = flat_contact(now, 1, 2, 150, 350, 1000, 1.0F);
+    CHECK_ERROR(UniboCGR_ContactPlanDelta_add_contact(delta, &contact), UniboCGR_NoError);
+    // the end time overlaps only the removed contact... and the new one: the revision wins
+    CHECK_ERROR(UniboCGR_ContactPlanDelta_change_contact_end_time(delta, 1, 2, now + 400, now + 700), UniboCGR_NoError);
+    CHECK_ERROR(UniboCGR_ContactPlanDelta_remove_contact(delta, 1, 2, now + 800), UniboCGR_NoError);
+    contact = flat_contact(now, 1, 2, 600, 650, 1000, 1.0F);
+    CHECK_ERROR(UniboCGR_ContactPlanDelta_add_contact(delta, &contact), UniboCGR_NoError);
+    CHECK_ERROR(apply(uniboCgr, now, delta), UniboCGR_NoError);
+    contacts_string(uniboCgr, now, plan, sizeof(plan));
+    CHECK(strcmp(plan, "0-100,150-350,400-700") == 0);
+
+    // a contact ended now is removed: its successor can start earlier
+    CHECK_ERROR(UniboCGR_ContactPlanDelta_change_contact_end_time(delta, 1, 2, now + 150, now), UniboCGR_NoError);
+    CHECK_ERROR(UniboCGR_ContactPlanDelta_change_contact_end_time(delta, 1, 2, now, now + 120), UniboCGR_NoError);
+    contact = flat_contact(now, 1, 2, 130, 390, 1000, 1.0F);
+    CHECK_ERROR(UniboCGR_ContactPlanDelta_add_contact(delta, &contact), UniboCGR_NoError);
+    CHECK_ERROR(apply(uniboCgr, now, delta), UniboCGR_NoError);
+    contacts_string(uniboCgr, now, plan, sizeof(plan));
+    CHECK(strcmp(plan, "0-120,130-390,400-700") == 0);
+
+    UniboCGR_ContactPlanDelta_destroy(&delta);
+    UniboCGR_close(&uniboCgr, now);
+}
+
+static void test_rejected_delta(void) {
+    time_t now = time(NULL);
+    UniboCGR uniboCgr = open_plan(now);
+    UniboCGR_ContactPlanDelta delta;
+    UniboCGR_FlatContact contact;
+    char plan[256];
+
+    CHECK_ERROR(UniboCGR_ContactPlanDelta_create(&delta), UniboCGR_NoError);
+
+    // changed after removed: nothing is applied
+    CHECK_ERROR(UniboCGR_ContactPlanDelta_remove_contact(delta, 1, 2, now), UniboCGR_NoError);
+    CHECK_ERROR(UniboCGR_ContactPlanDelta_remove_contact(delta, 1, 2, now + 400), UniboCGR_NoError);
+    CHECK_ERROR(UniboCGR_ContactPlanDelta_change_contact_xmit_rate(delta, 1, 2, now + 400, 5), UniboCGR_NoError);
+    CHECK_ERROR(apply(uniboCgr, now, delta), UniboCGR_ErrorContactNotFound);
+    contacts_string(uniboCgr, now, plan, sizeof(plan));
+    CHECK(strcmp(plan, "0-100,200-300,400-500") == 0);
+
+    // added twice: nothing is applied
+    CHECK_ERROR(UniboCGR_ContactPlanDelta_remove_contact(delta, 1, 2, now), UniboCGR_NoError);
+    contact = flat_contact(now, 1, 2, 600, 700, 1000, 1.0F);
+    CHECK_ERROR(UniboCGR_ContactPlanDelta_add_contact(delta, &contact), UniboCGR_NoError);
+    CHECK_ERROR(UniboCGR_ContactPlanDelta_add_contact(delta, &contact), UniboCGR_NoError);
+    CHECK_ERROR(apply(uniboCgr, now, delta), UniboCGR_ErrorFoundOverlappingContact);
+    contacts_string(uniboCgr, now, plan, sizeof(plan));
+    CHECK(strcmp(plan, "0-100,200-300,400-500") == 0);
+
+    // outside of a contact plan session
+    CHECK_ERROR(UniboCGR_ContactPlanDelta_remove_contact(delta, 1, 2, now), UniboCGR_NoError);
+    CHECK(UniboCGR_contact_plan_apply_delta(uniboCgr, delta, false) != UniboCGR_NoError);
+
+    UniboCGR_ContactPlanDelta_destroy(&delta);
+    UniboCGR_close(&uniboCgr, now);
+}
+
+static void test_diff(void) {
+    time_t now = time(NULL);
+    UniboCGR uniboCgr = open_plan(now);
+    UniboCGR_ContactPlanDelta delta;
+    UniboCGR_FlatContact oldContacts[3], newContacts[3];
+    char plan[256];
+
+    oldContacts[0] = flat_contact(now, 1, 2, 0, 100, 1000, 1.0F);
+    oldContacts[1] = flat_contact(now, 1, 2, 200, 300, 1000, 1.0F);
+    oldContacts[2] = flat_contact(now, 1, 2, 400, 500, 1000, 1.0F);
+    // removed 200-300, changed 400-500, added 600-700 (given unsorted)
+    newContacts[0] = flat_contact(now, 1, 2, 600, 700, 1000, 1.0F);
+    newContacts[1] = flat_contact(now, 1, 2, 400, 450, 1000, 1.0F);
+    newContacts[2] = flat_contact(now, 1, 2, 0, 100, 1000, 1.0F);
+
+    CHECK_ERROR(UniboCGR_ContactPlanDelta_create(&delta), UniboCGR_NoError);
+    CHECK_ERROR(UniboCGR_ContactPlanDelta_diff_contacts(delta, oldContacts, 3, newContacts, 3), UniboCGR_ErrorInvalidArgument);
+    UniboCGR_ContactPlanDelta_reset(delta);
+    UniboCGR_ContactPlanDelta_sort_contacts(newContacts, 3);
+    CHECK_ERROR(UniboCGR_ContactPlanDelta_diff_contacts(delta, oldContacts, 3, newContacts, 3), UniboCGR_NoError);
+    CHECK_ERROR(apply(uniboCgr, now, delta), UniboCGR_NoError);
+    contacts_string(uniboCgr, now, plan, sizeof(plan));
+    CHECK(strcmp(plan, "0-100,400-450,600-700") == 0);
+
+    UniboCGR_ContactPlanDelta_destroy(&delta);
+    UniboCGR_close(&uniboCgr, now);
+}
+
+int main(void) {
+    test_skip_invalid_records();
+    test_overlaps_after_removals();
+    test_rejected_delta();
+    test_diff();
+    return TEST_RESULT();
+}
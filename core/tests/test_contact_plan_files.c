@@ -0,0 +1,166 @@
+/*
+ * test_contact_plan_files.c
+ *
+ * Text and binary contact plan files: parsing, round trip through the binary format,
+ * malformed files, and the all-or-nothing loading (no contact left if the ranges are refused).
+ */
+
+#include "test_common.h"
+
+#define LOCAL_NODE 1
+
+static void write_file(const char* filename, const char* content) {
+    FILE* file = fopen(filename, "w");
+    if (!file) {
+        fprintf(stderr, "Cannot write %s.\n", filename);
+        exit(EXIT_FAILURE);
+    }
+    fputs(content, file);
+    fclose(file);
+}
+
+static UniboCGR_Error load_text(UniboCGR uniboCgr, time_t now, const char* filename, uint32_t threads, uint64_t* error_line) {
+    UniboCGR_Error error;
+    CHECK_ERROR(UniboCGR_contact_plan_open(uniboCgr, now), UniboCGR_NoError);
+    error = UniboCGR_contact_plan_load_text(uniboCgr, filename, now, true, threads, error_line);
+    CHECK_ERROR(UniboCGR_contact_plan_close(uniboCgr), UniboCGR_NoError);
+    return error;
+}
+
+static void test_text_plan(void) {
+    time_t now = time(NULL);
+    UniboCGR uniboCgr = test_open(now, LOCAL_NODE);
+    UniboCGR_Contact contact;
+    UniboCGR_Range range;
+    uint64_t line = 0;
+
+    write_file("plan.txt",
+               "# CSV and ionadmin lines\n"
+               "CONTACT,1,2,0,100,1000,0.5,1,2,3\n"
+               "RANGE,1,2,0,100,2\n"
+               "RANGE , 2, 3, 0, 100\r\n"
+               "a contact +0 +3600 2 3 100000\n"
+               "a range +0 +3600 3 4 5\n"
+               "m production 1000000\n");
+    CHECK_ERROR(load_text(uniboCgr, now, "plan.txt", 2, &line), UniboCGR_NoError);
+    CHECK(test_count_contacts(uniboCgr) == 2);
+    // the ionadmin range is symmetric
+    CHECK(test_count_ranges(uniboCgr) == 4);
+    CHECK_ERROR(UniboCGR_find_contact(uniboCgr, UniboCGR_ContactType_Scheduled, 1, 2, now, &contact), UniboCGR_NoError);
+    CHECK(UniboCGR_Contact_get_end_time(uniboCgr, contact) == now + 100);
+    CHECK(UniboCGR_Contact_get_xmit_rate(contact) == 1000);
+    CHECK(UniboCGR_Contact_get_confidence(contact) == 0.5F);
+    CHECK_ERROR(UniboCGR_find_contact(uniboCgr, UniboCGR_ContactType_Scheduled, 2, 3, now, &contact), UniboCGR_NoError);
+    CHECK(UniboCGR_Contact_get_end_time(uniboCgr, contact) == now + 3600);
+    CHECK_ERROR(UniboCGR_find_range(uniboCgr, 2, 3, now, &range), UniboCGR_NoError);
+    CHECK(UniboCGR_Range_get_one_way_light_time(range) == 0);
+    CHECK_ERROR(UniboCGR_find_range(uniboCgr, 4, 3, now, &range), UniboCGR_NoError);
+    CHECK(UniboCGR_Range_get_one_way_light_time(range) == 5);
+
+    // syntax error: the line is reported and nothing is loaded
+    UniboCGR_close(&uniboCgr, now);
+    uniboCgr = test_open(now, LOCAL_NODE);
+    write_file("bad.txt",
+               "CONTACT,1,2,0,10,1,1,1,1,1\n"
+               "\n"
+               "CONTACT,1,2,20,x0,1,1,1,1,1\n");
+    CHECK_ERROR(load_text(uniboCgr, now, "bad.txt", 2, &line), UniboCGR_ErrorMalformedFile);
+    CHECK(line == 3);
+    CHECK(test_count_contacts(uniboCgr) == 0);
+    CHECK_ERROR(load_text(uniboCgr, now, "missing.txt", 1, NULL), UniboCGR_ErrorCannotOpenFile);
+
+    UniboCGR_close(&uniboCgr, now);
+}
+
+/*
+ * The ranges are refused (overlapping): the contacts must not stay in the contact plan.
+ */
+static void test_all_or_nothing(void) {
+    time_t now = time(NULL);
+    UniboCGR uniboCgr = test_open(now, LOCAL_NODE);
+    UniboCGR_FlatContact contacts[1];
+    UniboCGR_FlatRange ranges[1];
+
+    // already in the plan: a contact 1->2 and a range 1->2
+    CHECK_ERROR(UniboCGR_contact_plan_open(uniboCgr, now), UniboCGR_NoError);
+    CHECK_ERROR(test_add_link(uniboCgr, now, 1, 2, 0, 100, 1000), UniboCGR_NoError);
+    CHECK_ERROR(UniboCGR_contact_plan_close(uniboCgr), UniboCGR_NoError);
+
+    write_file("overlap.txt",
+               "CONTACT,1,3,0,100,1000,1,0,0,0\n"
+               "CONTACT,3,1,0,100,1000,1,0,0,0\n"
+               "CONTACT,1,2,200,300,1000,1,0,0,0\n"
+               "RANGE,1,3,0,100,1\n"
+               "RANGE,1,2,50,300,1\n");
+    CHECK_ERROR(load_text(uniboCgr, now, "overlap.txt", 1, NULL), UniboCGR_ErrorFoundOverlappingRange);
+    CHECK(test_count_contacts(uniboCgr) == 1);
+    CHECK(test_count_ranges(uniboCgr) == 1);
+
+    memset(contacts, 0, sizeof(contacts));
+    contacts[0].sender = 1;
+    contacts[0].receiver = 3;
+    contacts[0].start_time = 0;
+    contacts[0].end_time = 100;
+    contacts[0].xmit_rate = 1000;
+    contacts[0].confidence = 1.0F;
+    ranges[0].sender = 1;
+    ranges[0].receiver = 2;
+    ranges[0].start_time = 50;
+    ranges[0].end_time = 150;
+    ranges[0].one_way_light_time = 1;
+    CHECK_ERROR(UniboCGR_contact_plan_write_binary("overlap.bin", contacts, 1, ranges, 1, true), UniboCGR_NoError);
+    CHECK_ERROR(UniboCGR_contact_plan_open(uniboCgr, now), UniboCGR_NoError);
+    CHECK_ERROR(UniboCGR_contact_plan_load_binary(uniboCgr, "overlap.bin", now, false), UniboCGR_ErrorFoundOverlappingRange);
+    CHECK_ERROR(UniboCGR_contact_plan_close(uniboCgr), UniboCGR_NoError);
+    CHECK(test_count_contacts(uniboCgr) == 1);
+    CHECK(test_count_ranges(uniboCgr) == 1);
+
+    UniboCGR_close(&uniboCgr, now);
+}
+
+static void test_binary_plan(void) {
+    time_t now = time(NULL);
+    UniboCGR text = test_open(now, LOCAL_NODE);
+    UniboCGR binary = test_open(now, LOCAL_NODE);
+    UniboCGR_Contact contact;
+    UniboCGR_Range range;
+
+    write_file("plan.txt",
+               "CONTACT,1,2,0,100,1000,0.5,10,20,30\n"
+               "CONTACT,2,3,10,200,2000,1,0,0,0\n"
+               "RANGE,1,2,0,100,2\n"
+               "RANGE,2,3,10,200,3\n");
+    CHECK_ERROR(UniboCGR_contact_plan_convert_text_to_binary("plan.txt", "plan.bin", now, 1, NULL), UniboCGR_NoError);
+    CHECK_ERROR(load_text(text, now, "plan.txt", 1, NULL), UniboCGR_NoError);
+    CHECK_ERROR(UniboCGR_contact_plan_open(binary, now), UniboCGR_NoError);
+    CHECK_ERROR(UniboCGR_contact_plan_load_binary(binary, "plan.bin", now, true), UniboCGR_NoError);
+    CHECK_ERROR(UniboCGR_contact_plan_close(binary), UniboCGR_NoError);
+
+    CHECK(test_count_contacts(binary) == 2 && test_count_ranges(binary) == 2);
+    CHECK_ERROR(UniboCGR_find_contact(binary, UniboCGR_ContactType_Scheduled, 1, 2, now, &contact), UniboCGR_NoError);
+    CHECK(UniboCGR_Contact_get_end_time(binary, contact) == now + 100);
+    CHECK(UniboCGR_Contact_get_xmit_rate(contact) == 1000);
+    CHECK(UniboCGR_Contact_get_confidence(contact) == 0.5F);
+    CHECK(UniboCGR_Contact_get_mtv_normal(contact) == 20.0);
+    CHECK_ERROR(UniboCGR_find_range(binary, 2, 3, now + 10, &range), UniboCGR_NoError);
+    CHECK(UniboCGR_Range_get_end_time(binary, range) == now + 200);
+    CHECK(UniboCGR_Range_get_one_way_light_time(range) == 3);
+    CHECK_ERROR(UniboCGR_find_contact(text, UniboCGR_ContactType_Scheduled, 1, 2, now, &contact), UniboCGR_NoError);
+    CHECK(UniboCGR_Contact_get_mtv_normal(contact) == 20.0);
+
+    // not a binary contact plan
+    CHECK_ERROR(UniboCGR_contact_plan_open(binary, now), UniboCGR_NoError);
+    CHECK_ERROR(UniboCGR_contact_plan_load_binary(binary, "plan.txt", now, true), UniboCGR_ErrorMalformedFile);
+    CHECK_ERROR(UniboCGR_contact_plan_load_binary(binary, "missing.bin", now, true), UniboCGR_ErrorCannotOpenFile);
+    CHECK_ERROR(UniboCGR_contact_plan_close(binary), UniboCGR_NoError);
+
+    UniboCGR_close(&text, now);
+    UniboCGR_close(&binary, now);
+}
+
+int main(void) {
+    test_text_plan();
+    test_all_or_nothing();
+    test_binary_plan();
+    return TEST_RESULT();
+}
@@ -0,0 +1,68 @@
+/*
+ * test_feature_toggles.c
+ *
+ * Toggling the phase two/three features keeps the computed routes (and gives the same routing
+ * results); toggling one route per neighbor discards them. The computed routes are counted
+ * through a snapshot (UniboCGR_snapshot_load() returns the routes restored).
+ */
+
+#include "test_common.h"
+
+#define LOCAL_NODE 1
+#define DESTINATION 3
+
+int main(void) {
+    time_t now = time(NULL);
+    UniboCGR uniboCgr = test_open(now, LOCAL_NODE);
+    uint64_t neighbors;
+    uint32_t routes;
+
+    CHECK_ERROR(UniboCGR_contact_plan_open(uniboCgr, now), UniboCGR_NoError);
+    CHECK_ERROR(test_add_link(uniboCgr, now, LOCAL_NODE, 2, 0, 1000, 100000), UniboCGR_NoError);
+    CHECK_ERROR(test_add_link(uniboCgr, now, 2, DESTINATION, 0, 1000, 100000), UniboCGR_NoError);
+    CHECK_ERROR(UniboCGR_contact_plan_close(uniboCgr), UniboCGR_NoError);
+
+    neighbors = test_route_to(uniboCgr, now, DESTINATION, false);
+    CHECK(neighbors == NODE_BIT(2));
+    routes = test_computed_routes(uniboCgr, now, LOCAL_NODE);
+    CHECK(routes > 0);
+
+    // phase two/three features: the routes are kept
+    CHECK_ERROR(UniboCGR_feature_open(uniboCgr, now), UniboCGR_NoError);
+    CHECK_ERROR(UniboCGR_feature_QueueDelay_enable(uniboCgr), UniboCGR_NoError);
+    CHECK_ERROR(UniboCGR_feature_ModerateSourceRouting_enable(uniboCgr), UniboCGR_NoError);
+    CHECK_ERROR(UniboCGR_feature_ReactiveAntiLoop_enable(uniboCgr), UniboCGR_NoError);
+    CHECK_ERROR(UniboCGR_feature_ProactiveAntiLoop_enable(uniboCgr), UniboCGR_NoError);
+    CHECK_ERROR(UniboCGR_feature_VolumeReservations_enable(uniboCgr), UniboCGR_NoError);
+    CHECK_ERROR(UniboCGR_feature_close(uniboCgr), UniboCGR_NoError);
+    CHECK(UniboCGR_feature_QueueDelay_check(uniboCgr));
+    CHECK(UniboCGR_feature_ModerateSourceRouting_check(uniboCgr));
+    CHECK(UniboCGR_feature_ReactiveAntiLoop_check(uniboCgr));
+    CHECK(UniboCGR_feature_ProactiveAntiLoop_check(uniboCgr));
+    CHECK(UniboCGR_feature_VolumeReservations_check(uniboCgr));
+    CHECK(test_computed_routes(uniboCgr, now, LOCAL_NODE) == routes);
+    CHECK(test_route_to(uniboCgr, now, DESTINATION, false) == neighbors);
+
+    CHECK_ERROR(UniboCGR_feature_open(uniboCgr, now), UniboCGR_NoError);
+    CHECK_ERROR(UniboCGR_feature_QueueDelay_disable(uniboCgr), UniboCGR_NoError);
+    CHECK_ERROR(UniboCGR_feature_ModerateSourceRouting_disable(uniboCgr), UniboCGR_NoError);
+    CHECK_ERROR(UniboCGR_feature_ReactiveAntiLoop_disable(uniboCgr), UniboCGR_NoError);
+    CHECK_ERROR(UniboCGR_feature_ProactiveAntiLoop_disable(uniboCgr), UniboCGR_NoError);
+    CHECK_ERROR(UniboCGR_feature_VolumeReservations_disable(uniboCgr), UniboCGR_NoError);
+    CHECK_ERROR(UniboCGR_feature_close(uniboCgr), UniboCGR_NoError);
+    CHECK(!UniboCGR_feature_QueueDelay_check(uniboCgr));
+    CHECK(!UniboCGR_feature_ModerateSourceRouting_check(uniboCgr));
+    CHECK(test_computed_routes(uniboCgr, now, LOCAL_NODE) == routes);
+    CHECK(test_route_to(uniboCgr, now, DESTINATION, false) == neighbors);
+
+    // one route per neighbor drives the phase one: the routes are discarded
+    CHECK_ERROR(UniboCGR_feature_open(uniboCgr, now), UniboCGR_NoError);
+    CHECK_ERROR(UniboCGR_feature_OneRoutePerNeighbor_enable(uniboCgr, 0), UniboCGR_NoError);
+    CHECK_ERROR(UniboCGR_feature_close(uniboCgr), UniboCGR_NoError);
+    CHECK(test_computed_routes(uniboCgr, now, LOCAL_NODE) == 0);
+    CHECK(test_route_to(uniboCgr, now, DESTINATION, false) == neighbors);
+
+    UniboCGR_close(&uniboCgr, now);
+
+    return TEST_RESULT();
+}
@@ -0,0 +1,96 @@
+/*
+ * test_reservations.c
+ *
+ * Volume reservations: a released reservation gives back its volume to the contacts,
+ * a committed one keeps it consumed, nothing is reserved when the feature is disabled.
+ */
+
+#include "test_common.h"
+
+#define LOCAL_NODE 1
+#define DESTINATION 2
+
+static UniboCGR_Error route(UniboCGR uniboCgr, time_t now, UniboCGR_Bundle bundle,
+                            UniboCGR_excluded_neighbors_list excluded, uint64_t *neighbors) {
+    UniboCGR_route_list routes = NULL;
+    UniboCGR_Error error;
+
+    CHECK_ERROR(UniboCGR_routing_open(uniboCgr, now), UniboCGR_NoError);
+    error = UniboCGR_routing(uniboCgr, bundle, excluded, &routes);
+    *neighbors = (error == UniboCGR_NoError) ? test_route_neighbors(uniboCgr, routes) : 0;
+    return error;
+}
+
+int main(void) {
+    time_t now = time(NULL);
+    UniboCGR uniboCgr = test_open(now, LOCAL_NODE);
+    UniboCGR_excluded_neighbors_list excluded;
+    UniboCGR_Bundle bundle;
+    UniboCGR_Reservation first, second;
+    uint64_t neighbors;
+
+    // room for 2 bundles (EVC ~ 1000 bytes)
+    CHECK_ERROR(UniboCGR_contact_plan_open(uniboCgr, now), UniboCGR_NoError);
+    CHECK_ERROR(test_add_link(uniboCgr, now, LOCAL_NODE, DESTINATION, 0, 1000, 2), UniboCGR_NoError);
+    CHECK_ERROR(UniboCGR_contact_plan_close(uniboCgr), UniboCGR_NoError);
+
+    CHECK_ERROR(UniboCGR_feature_open(uniboCgr, now), UniboCGR_NoError);
+    CHECK_ERROR(UniboCGR_feature_VolumeReservations_enable(uniboCgr), UniboCGR_NoError);
+    CHECK_ERROR(UniboCGR_feature_close(uniboCgr), UniboCGR_NoError);
+    CHECK(UniboCGR_feature_VolumeReservations_check(uniboCgr));
+
+    CHECK_ERROR(UniboCGR_create_excluded_neighbors_list(&excluded), UniboCGR_NoError);
+    bundle = test_bundle(now, DESTINATION, 0, 900);
+
+    CHECK_ERROR(route(uniboCgr, now, bundle, excluded, &neighbors), UniboCGR_NoError);
+    CHECK(neighbors == NODE_BIT(DESTINATION));
+    first = UniboCGR_get_reservation(uniboCgr);
+    CHECK_ERROR(UniboCGR_routing_close(uniboCgr), UniboCGR_NoError);
+
+    CHECK_ERROR(route(uniboCgr, now, bundle, excluded, &neighbors), UniboCGR_NoError);
+    CHECK(neighbors == NODE_BIT(DESTINATION));
+    second = UniboCGR_get_reservation(uniboCgr);
+    CHECK_ERROR(UniboCGR_routing_close(uniboCgr), UniboCGR_NoError);
+
+    CHECK(first != 0 && second != 0 && first != second);
+
+    // the volume is over
+    route(uniboCgr, now, bundle, excluded, &neighbors);
+    CHECK(neighbors == 0);
+    CHECK(UniboCGR_get_reservation(uniboCgr) == 0);
+    CHECK_ERROR(UniboCGR_routing_close(uniboCgr), UniboCGR_NoError);
+
+    // the first bundle has not been forwarded: its volume can be used again
+    CHECK_ERROR(UniboCGR_reservation_release(uniboCgr, first), UniboCGR_NoError);
+    CHECK_ERROR(UniboCGR_reservation_release(uniboCgr, first), UniboCGR_ErrorReservationNotFound);
+    CHECK_ERROR(route(uniboCgr, now, bundle, excluded, &neighbors), UniboCGR_NoError);
+    CHECK(neighbors == NODE_BIT(DESTINATION));
+    first = UniboCGR_get_reservation(uniboCgr);
+    CHECK(first != 0);
+    CHECK_ERROR(UniboCGR_routing_close(uniboCgr), UniboCGR_NoError);
+
+    // committed: the volume stays consumed and the reservation is gone
+    CHECK_ERROR(UniboCGR_reservation_commit(uniboCgr, second), UniboCGR_NoError);
+    CHECK_ERROR(UniboCGR_reservation_release(uniboCgr, second), UniboCGR_ErrorReservationNotFound);
+    route(uniboCgr, now, bundle, excluded, &neighbors);
+    CHECK(neighbors == 0);
+    CHECK_ERROR(UniboCGR_routing_close(uniboCgr), UniboCGR_NoError);
+    CHECK_ERROR(UniboCGR_reservation_commit(uniboCgr, 0), UniboCGR_ErrorInvalidArgument);
+
+    // disabled: nothing is reserved anymore
+    CHECK_ERROR(UniboCGR_feature_open(uniboCgr, now), UniboCGR_NoError);
+    CHECK_ERROR(UniboCGR_feature_VolumeReservations_disable(uniboCgr), UniboCGR_NoError);
+    CHECK_ERROR(UniboCGR_feature_close(uniboCgr), UniboCGR_NoError);
+    CHECK(!UniboCGR_feature_VolumeReservations_check(uniboCgr));
+    CHECK_ERROR(UniboCGR_reservation_release(uniboCgr, first), UniboCGR_NoError);
+    CHECK_ERROR(route(uniboCgr, now, bundle, excluded, &neighbors), UniboCGR_NoError);
+    CHECK(neighbors == NODE_BIT(DESTINATION));
+    CHECK(UniboCGR_get_reservation(uniboCgr) == 0);
+    CHECK_ERROR(UniboCGR_routing_close(uniboCgr), UniboCGR_NoError);
+
+    UniboCGR_Bundle_destroy(&bundle);
+    UniboCGR_destroy_excluded_neighbors_list(&excluded);
+    UniboCGR_close(&uniboCgr, now);
+
+    return TEST_RESULT();
+}
@@ -0,0 +1,100 @@
+/*
+ * test_route_cache.c
+ *
+ * Route cache: the bundles of the same class are served by the cache, an unreachable
+ * destination stays cached until the next contact start (staged contacts included)
+ * or until the contact plan changes.
+ */
+
+#include "test_common.h"
+
+#define LOCAL_NODE 1
+#define DESTINATION 3
+
+static void enable_features(UniboCGR uniboCgr, time_t now, time_t horizon) {
+    CHECK_ERROR(UniboCGR_feature_open(uniboCgr, now), UniboCGR_NoError);
+    CHECK_ERROR(UniboCGR_feature_RouteCache_enable(uniboCgr), UniboCGR_NoError);
+    if (horizon > 0) {
+        CHECK_ERROR(UniboCGR_feature_ContactHorizon_enable(uniboCgr, horizon), UniboCGR_NoError);
+    }
+    CHECK_ERROR(UniboCGR_feature_close(uniboCgr), UniboCGR_NoError);
+    CHECK(UniboCGR_feature_RouteCache_check(uniboCgr));
+}
+
+/*
+ * Same class: the second bundle is a hit; a contact plan change invalidates the entry.
+ */
+static void test_hits_and_plan_change(void) {
+    time_t now = time(NULL);
+    UniboCGR uniboCgr = test_open(now, LOCAL_NODE);
+    uint64_t hits, misses, neighbors;
+
+    enable_features(uniboCgr, now, 0);
+    CHECK_ERROR(UniboCGR_contact_plan_open(uniboCgr, now), UniboCGR_NoError);
+    CHECK_ERROR(test_add_link(uniboCgr, now, LOCAL_NODE, 2, 0, 1000, 100000), UniboCGR_NoError);
+    CHECK_ERROR(test_add_link(uniboCgr, now, 2, DESTINATION, 0, 1000, 100000), UniboCGR_NoError);
+    CHECK_ERROR(UniboCGR_contact_plan_close(uniboCgr), UniboCGR_NoError);
+
+    CHECK_ERROR(test_route(uniboCgr, now, now, DESTINATION, false, &neighbors), UniboCGR_NoError);
+    CHECK(neighbors == NODE_BIT(2));
+    CHECK_ERROR(test_route(uniboCgr, now, now, DESTINATION, false, &neighbors), UniboCGR_NoError);
+    CHECK(neighbors == NODE_BIT(2));
+    CHECK_ERROR(UniboCGR_route_cache_get_counters(uniboCgr, &hits, &misses), UniboCGR_NoError);
+    CHECK(hits == 1 && misses == 1);
+
+    // a new neighbor toward the destination: the cached routes are not used anymore
+    CHECK_ERROR(UniboCGR_contact_plan_open(uniboCgr, now), UniboCGR_NoError);
+    CHECK_ERROR(test_add_link(uniboCgr, now, LOCAL_NODE, 4, 0, 1000, 100000), UniboCGR_NoError);
+    CHECK_ERROR(test_add_link(uniboCgr, now, 4, DESTINATION, 0, 1000, 100000), UniboCGR_NoError);
+    CHECK_ERROR(UniboCGR_contact_plan_close(uniboCgr), UniboCGR_NoError);
+    CHECK_ERROR(test_route(uniboCgr, now, now, DESTINATION, false, &neighbors), UniboCGR_NoError);
+    CHECK_ERROR(UniboCGR_route_cache_get_counters(uniboCgr, &hits, &misses), UniboCGR_NoError);
+    CHECK(hits == 1 && misses == 2);
+
+    UniboCGR_close(&uniboCgr, now);
+}
+
+/*
+ * The destination is unreachable: cached until the next contact start (at now + 100),
+ * in the graph or staged out of it (horizon mode).
+ */
+static void test_unreachable(time_t horizon) {
+    time_t now = time(NULL);
+    UniboCGR uniboCgr = test_open(now, LOCAL_NODE);
+    uint64_t hits, misses, neighbors;
+
+    enable_features(uniboCgr, now, horizon);
+    CHECK_ERROR(UniboCGR_contact_plan_open(uniboCgr, now), UniboCGR_NoError);
+    CHECK_ERROR(test_add_link(uniboCgr, now, LOCAL_NODE, 2, 0, 1000, 100000), UniboCGR_NoError);
+    CHECK_ERROR(test_add_link(uniboCgr, now, LOCAL_NODE, 4, 100, 1000, 100000), UniboCGR_NoError);
+    CHECK_ERROR(UniboCGR_contact_plan_close(uniboCgr), UniboCGR_NoError);
+
+    CHECK_ERROR(test_route(uniboCgr, now, now, DESTINATION, false, &neighbors), UniboCGR_ErrorRouteNotFound);
+    CHECK_ERROR(test_route(uniboCgr, now, now + 50, DESTINATION, false, &neighbors), UniboCGR_ErrorRouteNotFound);
+    CHECK_ERROR(UniboCGR_route_cache_get_counters(uniboCgr, &hits, &misses), UniboCGR_NoError);
+    CHECK(hits == 1 && misses == 1);
+
+    // the contact to 4 starts: the destination is searched again
+    CHECK_ERROR(test_route(uniboCgr, now, now + 100, DESTINATION, false, &neighbors), UniboCGR_ErrorRouteNotFound);
+    CHECK_ERROR(UniboCGR_route_cache_get_counters(uniboCgr, &hits, &misses), UniboCGR_NoError);
+    CHECK(hits == 1 && misses == 2);
+
+    // no contact starts anymore: the entry is valid until the contact plan changes
+    CHECK_ERROR(test_route(uniboCgr, now, now + 500, DESTINATION, false, &neighbors), UniboCGR_ErrorRouteNotFound);
+    CHECK_ERROR(UniboCGR_route_cache_get_counters(uniboCgr, &hits, &misses), UniboCGR_NoError);
+    CHECK(hits == 2 && misses == 2);
+    CHECK_ERROR(UniboCGR_contact_plan_open(uniboCgr, now + 500), UniboCGR_NoError);
+    CHECK_ERROR(test_add_link(uniboCgr, now, 2, DESTINATION, 500, 1000, 100000), UniboCGR_NoError);
+    CHECK_ERROR(UniboCGR_contact_plan_close(uniboCgr), UniboCGR_NoError);
+    CHECK_ERROR(test_route(uniboCgr, now, now + 500, DESTINATION, false, &neighbors), UniboCGR_NoError);
+    CHECK(neighbors == NODE_BIT(2));
+
+    UniboCGR_close(&uniboCgr, now + 500);
+}
+
+int main(void) {
+    test_hits_and_plan_change();
+    test_unreachable(0);
+    test_unreachable(50);
+    return TEST_RESULT();
+}
@@ -0,0 +1,110 @@
+/*
+ * test_route_list_export.c
+ *
+ * UniboCGR_route_list_export(): same routes and hops of the route/hop iterators,
+ * the sizes required when the arrays are too small.
+ */
+
+#include "test_common.h"
+
+#define LOCAL_NODE 1
+#define DESTINATION 3
+
+/*
+ * Compare an exported route with the route of the iterator.
+ */
+static void check_route(UniboCGR uniboCgr, UniboCGR_Route route, const UniboCGR_FlatRoute* flat,
+                        const UniboCGR_FlatHop* hops) {
+    UniboCGR_Contact contact;
+    uint64_t overbooked, committed;
+    uint32_t count = 0;
+
+    UniboCGR_Route_get_overbooking_management(route, &overbooked, &committed);
+    CHECK(flat->neighbor == UniboCGR_Route_get_neighbor(route));
+    CHECK(flat->best_case_arrival_time == UniboCGR_Route_get_best_case_arrival_time(uniboCgr, route));
+    CHECK(flat->best_case_transmission_time == UniboCGR_Route_get_best_case_transmission_time(uniboCgr, route));
+    CHECK(flat->expiration_time == UniboCGR_Route_get_expiration_time(uniboCgr, route));
+    CHECK(flat->eto == UniboCGR_Route_get_eto(uniboCgr, route));
+    CHECK(flat->projected_bundle_arrival_time == UniboCGR_Route_get_projected_bundle_arrival_time(uniboCgr, route));
+    CHECK(flat->total_one_way_light_time == UniboCGR_Route_get_total_one_way_light_time(route));
+    CHECK(flat->route_volume_limit == UniboCGR_Route_get_route_volume_limit(route));
+    CHECK(flat->arrival_confidence == UniboCGR_Route_get_arrival_confidence(route));
+    CHECK(flat->overbooked == overbooked && flat->committed == committed);
+
+    for (UniboCGR_Error error = UniboCGR_get_first_hop(uniboCgr, route, &contact);
+         error == UniboCGR_NoError;
+         error = UniboCGR_get_next_hop(uniboCgr, &contact)) {
+        CHECK(count < flat->hop_count);
+        if (count < flat->hop_count) {
+            const UniboCGR_FlatHop* hop = &hops[flat->first_hop + count];
+            CHECK(hop->sender == UniboCGR_Contact_get_sender(contact));
+            CHECK(hop->receiver == UniboCGR_Contact_get_receiver(contact));
+            CHECK(hop->start_time == UniboCGR_Contact_get_start_time(uniboCgr, contact));
+        }
+        count++;
+    }
+    CHECK(count == flat->hop_count);
+}
+
+int main(void) {
+    time_t now = time(NULL);
+    UniboCGR uniboCgr = test_open(now, LOCAL_NODE);
+    UniboCGR_excluded_neighbors_list excluded;
+    UniboCGR_Bundle bundle;
+    UniboCGR_route_list list = NULL;
+    UniboCGR_Route route;
+    UniboCGR_FlatRoute routes[4];
+    UniboCGR_FlatHop hops[8];
+    uint32_t routesCount, hopsCount, index;
+
+    // 1 -> 2 -> 3 and 1 -> 4 -> 3 (later)
+    CHECK_ERROR(UniboCGR_contact_plan_open(uniboCgr, now), UniboCGR_NoError);
+    CHECK_ERROR(test_add_link(uniboCgr, now, LOCAL_NODE, 2, 0, 1000, 100000), UniboCGR_NoError);
+    CHECK_ERROR(test_add_link(uniboCgr, now, 2, DESTINATION, 0, 1000, 100000), UniboCGR_NoError);
+    CHECK_ERROR(test_add_link(uniboCgr, now, LOCAL_NODE, 4, 10, 1000, 100000), UniboCGR_NoError);
+    CHECK_ERROR(test_add_link(uniboCgr, now, 4, DESTINATION, 20, 1000, 100000), UniboCGR_NoError);
+    CHECK_ERROR(UniboCGR_contact_plan_close(uniboCgr), UniboCGR_NoError);
+
+    CHECK_ERROR(UniboCGR_create_excluded_neighbors_list(&excluded), UniboCGR_NoError);
+    bundle = test_bundle(now, DESTINATION, 0, 1000);
+    // critical: a route for each neighbor
+    UniboCGR_Bundle_set_flag_critical(bundle, true);
+    CHECK_ERROR(UniboCGR_routing_open(uniboCgr, now), UniboCGR_NoError);
+    CHECK_ERROR(UniboCGR_routing(uniboCgr, bundle, excluded, &list), UniboCGR_NoError);
+    CHECK(test_route_neighbors(uniboCgr, list) == (NODE_BIT(2) | NODE_BIT(4)));
+
+    CHECK_ERROR(UniboCGR_route_list_export(uniboCgr, list, routes, 4, hops, 8, &routesCount, &hopsCount), UniboCGR_NoError);
+    CHECK(routesCount == UniboCGR_route_list_get_length(list));
+    CHECK(routesCount == 2 && hopsCount == 4);
+    index = 0;
+    for (UniboCGR_Error error = UniboCGR_get_first_route(uniboCgr, list, &route);
+         error == UniboCGR_NoError && index < routesCount;
+         error = UniboCGR_get_next_route(uniboCgr, &route)) {
+        check_route(uniboCgr, route, &routes[index], hops);
+        index++;
+    }
+    CHECK(index == routesCount);
+
+    // no hops wanted
+    CHECK_ERROR(UniboCGR_route_list_export(uniboCgr, list, routes, 4, NULL, 0, &routesCount, NULL), UniboCGR_NoError);
+    CHECK(routesCount == 2);
+
+    // too small: the sizes required
+    routesCount = hopsCount = 0;
+    CHECK_ERROR(UniboCGR_route_list_export(uniboCgr, list, routes, 1, hops, 8, &routesCount, &hopsCount), UniboCGR_ErrorBufferTooSmall);
+    CHECK(routesCount == 2 && hopsCount == 4);
+    routesCount = hopsCount = 0;
+    CHECK_ERROR(UniboCGR_route_list_export(uniboCgr, list, routes, 4, hops, 3, &routesCount, &hopsCount), UniboCGR_ErrorBufferTooSmall);
+    CHECK(routesCount == 2 && hopsCount == 4);
+
+    // no route list: no routes
+    CHECK_ERROR(UniboCGR_route_list_export(uniboCgr, NULL, routes, 4, hops, 8, &routesCount, &hopsCount), UniboCGR_NoError);
+    CHECK(routesCount == 0 && hopsCount == 0);
+    CHECK_ERROR(UniboCGR_routing_close(uniboCgr), UniboCGR_NoError);
+
+    UniboCGR_Bundle_destroy(&bundle);
+    UniboCGR_destroy_excluded_neighbors_list(&excluded);
+    UniboCGR_close(&uniboCgr, now);
+
+    return TEST_RESULT();
+}
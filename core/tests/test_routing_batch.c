@@ -0,0 +1,76 @@
+/*
+ * test_routing_batch.c
+ *
+ * UniboCGR_routing_batch(): the classes of bundles that share the same excluded
+ * neighbors list must not see the senders of the other classes.
+ */
+
+#include "test_common.h"
+
+#define LOCAL_NODE 1
+
+typedef struct {
+    uint64_t neighbors[8];
+    UniboCGR_Error errors[8];
+    uint32_t calls;
+} BatchResults;
+
+static void batch_callback(UniboCGR uniboCgr, uint32_t index, UniboCGR_Error error,
+                           UniboCGR_route_list routes, void *arg) {
+    BatchResults *results = (BatchResults*) arg;
+    results->calls++;
+    results->errors[index] = error;
+    results->neighbors[index] = (error == UniboCGR_NoError) ? test_route_neighbors(uniboCgr, routes) : 0;
+}
+
+int main(void) {
+    time_t now = time(NULL);
+    UniboCGR uniboCgr = test_open(now, LOCAL_NODE);
+    UniboCGR_excluded_neighbors_list shared, other;
+    UniboCGR_excluded_neighbors_list lists[5];
+    UniboCGR_Bundle bundles[5];
+    BatchResults results;
+
+    // neighbors 2 and 4 reach both 3 and 5
+    CHECK_ERROR(UniboCGR_contact_plan_open(uniboCgr, now), UniboCGR_NoError);
+    CHECK_ERROR(test_add_link(uniboCgr, now, LOCAL_NODE, 2, 0, 1000, 100000), UniboCGR_NoError);
+    CHECK_ERROR(test_add_link(uniboCgr, now, LOCAL_NODE, 4, 0, 1000, 100000), UniboCGR_NoError);
+    CHECK_ERROR(test_add_link(uniboCgr, now, 2, 3, 0, 1000, 100000), UniboCGR_NoError);
+    CHECK_ERROR(test_add_link(uniboCgr, now, 4, 3, 0, 1000, 100000), UniboCGR_NoError);
+    CHECK_ERROR(test_add_link(uniboCgr, now, 2, 5, 0, 1000, 100000), UniboCGR_NoError);
+    CHECK_ERROR(test_add_link(uniboCgr, now, 4, 5, 0, 1000, 100000), UniboCGR_NoError);
+    CHECK_ERROR(UniboCGR_contact_plan_close(uniboCgr), UniboCGR_NoError);
+
+    CHECK_ERROR(UniboCGR_create_excluded_neighbors_list(&shared), UniboCGR_NoError);
+    CHECK_ERROR(UniboCGR_create_excluded_neighbors_list(&other), UniboCGR_NoError);
+    CHECK_ERROR(UniboCGR_add_excluded_neighbor(other, 4), UniboCGR_NoError);
+
+    // two classes to 3 (senders 2 and 4) and one to 5 share the same list
+    bundles[0] = test_bundle(now, 3, 2, 1000); lists[0] = shared;
+    bundles[1] = test_bundle(now, 3, 4, 1000); lists[1] = shared;
+    bundles[2] = test_bundle(now, 3, 2, 1000); lists[2] = shared;
+    bundles[3] = test_bundle(now, 5, 0, 1000); lists[3] = shared;
+    bundles[4] = test_bundle(now, 5, 0, 1000); lists[4] = other;
+
+    memset(&results, 0, sizeof(results));
+    CHECK_ERROR(UniboCGR_routing_open(uniboCgr, now), UniboCGR_NoError);
+    CHECK_ERROR(UniboCGR_routing_batch(uniboCgr, bundles, lists, 5, batch_callback, &results), UniboCGR_NoError);
+    CHECK_ERROR(UniboCGR_routing_close(uniboCgr), UniboCGR_NoError);
+
+    CHECK(results.calls == 5);
+    for (int i = 0; i < 5; i++) {
+        CHECK(results.errors[i] == UniboCGR_NoError);
+    }
+    CHECK(results.neighbors[0] == NODE_BIT(4));
+    CHECK(results.neighbors[1] == NODE_BIT(2));
+    CHECK(results.neighbors[2] == NODE_BIT(4));
+    CHECK(results.neighbors[3] == NODE_BIT(2) || results.neighbors[3] == NODE_BIT(4));
+    CHECK(results.neighbors[4] == NODE_BIT(2));
+
+    for (int i = 0; i < 5; i++) UniboCGR_Bundle_destroy(&bundles[i]);
+    UniboCGR_destroy_excluded_neighbors_list(&shared);
+    UniboCGR_destroy_excluded_neighbors_list(&other);
+    UniboCGR_close(&uniboCgr, now);
+
+    return TEST_RESULT();
+}
@@ -0,0 +1,139 @@
+/*
+ * test_routing_group.c
+ *
+ * UniboCGR_routing_group(): the bundles of the group and the bundles routed
+ * one by one after the group must get the routes of a UniboCGR_routing() call.
+ */
+
+#include "test_common.h"
+
+#define LOCAL_NODE 1
+#define DESTINATION 3
+
+typedef struct {
+    uint64_t neighbors[8];
+    UniboCGR_Error errors[8];
+    uint32_t calls;
+} GroupResults;
+
+static void group_callback(UniboCGR uniboCgr, uint32_t index, UniboCGR_Error error,
+                           UniboCGR_route_list routes, void *arg) {
+    GroupResults *results = (GroupResults*) arg;
+    results->calls++;
+    results->errors[index] = error;
+    results->neighbors[index] = (error == UniboCGR_NoError) ? test_route_neighbors(uniboCgr, routes) : 0;
+}
+
+/*
+ * Two neighbors (2 and 4) reach the destination 3.
+ */
+static void load_plan(UniboCGR uniboCgr, time_t now, uint64_t xmit_rate) {
+    CHECK_ERROR(UniboCGR_contact_plan_open(uniboCgr, now), UniboCGR_NoError);
+    CHECK_ERROR(test_add_link(uniboCgr, now, LOCAL_NODE, 2, 0, 1000, xmit_rate), UniboCGR_NoError);
+    CHECK_ERROR(test_add_link(uniboCgr, now, 2, DESTINATION, 0, 1000, 100000), UniboCGR_NoError);
+    CHECK_ERROR(test_add_link(uniboCgr, now, LOCAL_NODE, 4, 0, 1000, xmit_rate), UniboCGR_NoError);
+    CHECK_ERROR(test_add_link(uniboCgr, now, 4, DESTINATION, 0, 1000, 100000), UniboCGR_NoError);
+    CHECK_ERROR(UniboCGR_contact_plan_close(uniboCgr), UniboCGR_NoError);
+}
+
+/*
+ * The sender of the group leader (2) is excluded only for the bundles of its group:
+ * a bundle received from 4 is routed through 2, as a single call does.
+ */
+static void test_sender_not_shared(void) {
+    time_t now = time(NULL);
+    UniboCGR uniboCgr = test_open(now, LOCAL_NODE);
+    UniboCGR_excluded_neighbors_list excluded;
+    UniboCGR_Bundle bundles[3];
+    GroupResults results;
+    UniboCGR_route_list routes;
+
+    load_plan(uniboCgr, now, 100000);
+    CHECK_ERROR(UniboCGR_create_excluded_neighbors_list(&excluded), UniboCGR_NoError);
+
+    bundles[0] = test_bundle(now, DESTINATION, 2, 1000);
+    bundles[1] = test_bundle(now, DESTINATION, 2, 1000);
+    bundles[2] = test_bundle(now, DESTINATION, 4, 1000);
+
+    memset(&results, 0, sizeof(results));
+    CHECK_ERROR(UniboCGR_routing_open(uniboCgr, now), UniboCGR_NoError);
+    CHECK_ERROR(UniboCGR_routing_group(uniboCgr, bundles, 3, excluded, group_callback, &results), UniboCGR_NoError);
+
+    CHECK(results.calls == 3);
+    CHECK(results.errors[0] == UniboCGR_NoError && results.neighbors[0] == NODE_BIT(4));
+    CHECK(results.errors[1] == UniboCGR_NoError && results.neighbors[1] == NODE_BIT(4));
+    CHECK(results.errors[2] == UniboCGR_NoError && results.neighbors[2] == NODE_BIT(2));
+
+    // the caller's list must not keep the sender of the group
+    CHECK_ERROR(UniboCGR_routing(uniboCgr, bundles[2], excluded, &routes), UniboCGR_NoError);
+    CHECK(test_route_neighbors(uniboCgr, routes) == NODE_BIT(2));
+    CHECK_ERROR(UniboCGR_routing_close(uniboCgr), UniboCGR_NoError);
+
+    for (int i = 0; i < 3; i++) UniboCGR_Bundle_destroy(&bundles[i]);
+    UniboCGR_destroy_excluded_neighbors_list(&excluded);
+    UniboCGR_close(&uniboCgr, now);
+}
+
+/*
+ * Without the group: each bundle routed by UniboCGR_routing().
+ */
+static void route_one_by_one(UniboCGR uniboCgr, UniboCGR_Bundle *bundles, uint32_t count,
+                             UniboCGR_excluded_neighbors_list excluded, GroupResults *results) {
+    UniboCGR_route_list routes;
+    memset(results, 0, sizeof(*results));
+    for (uint32_t i = 0; i < count; i++) {
+        results->errors[i] = UniboCGR_routing(uniboCgr, bundles[i], excluded, &routes);
+        results->neighbors[i] = (results->errors[i] == UniboCGR_NoError) ? test_route_neighbors(uniboCgr, routes) : 0;
+        results->calls++;
+    }
+}
+
+/*
+ * The contacts toward the neighbors have room for 2 bundles each:
+ * the bundles of the group overflow from a neighbor to the other as in single calls,
+ * and the last ones find no route.
+ */
+static void test_same_as_single_calls(void) {
+    time_t now = time(NULL);
+    UniboCGR_excluded_neighbors_list excluded;
+    UniboCGR_Bundle bundles[6];
+    GroupResults grouped, single;
+
+    for (int i = 0; i < 6; i++) {
+        bundles[i] = test_bundle(now, DESTINATION, 0, 900 + (uint64_t) i);
+    }
+    CHECK_ERROR(UniboCGR_create_excluded_neighbors_list(&excluded), UniboCGR_NoError);
+
+    for (int run = 0; run < 2; run++) {
+        UniboCGR uniboCgr = test_open(now, LOCAL_NODE);
+        // 2 bundles (EVC ~ 1000 bytes) per contact
+        load_plan(uniboCgr, now, 2);
+        CHECK_ERROR(UniboCGR_routing_open(uniboCgr, now), UniboCGR_NoError);
+        if (run == 0) {
+            memset(&grouped, 0, sizeof(grouped));
+            CHECK_ERROR(UniboCGR_routing_group(uniboCgr, bundles, 6, excluded, group_callback, &grouped), UniboCGR_NoError);
+        } else {
+            route_one_by_one(uniboCgr, bundles, 6, excluded, &single);
+        }
+        CHECK_ERROR(UniboCGR_routing_close(uniboCgr), UniboCGR_NoError);
+        UniboCGR_close(&uniboCgr, now);
+    }
+
+    CHECK(grouped.calls == 6);
+    for (int i = 0; i < 6; i++) {
+        CHECK(grouped.errors[i] == single.errors[i]);
+        CHECK(grouped.neighbors[i] == single.neighbors[i]);
+    }
+    // first through 2, then through 4, then the volume runs out
+    CHECK(single.neighbors[0] == NODE_BIT(2) && single.neighbors[2] == NODE_BIT(4));
+    CHECK(single.neighbors[5] == 0);
+
+    for (int i = 0; i < 6; i++) UniboCGR_Bundle_destroy(&bundles[i]);
+    UniboCGR_destroy_excluded_neighbors_list(&excluded);
+}
+
+int main(void) {
+    test_sender_not_shared();
+    test_same_as_single_calls();
+    return TEST_RESULT();
+}
@@ -0,0 +1,137 @@
+/*
+ * test_shadow_contact_plan.c
+ *
+ * Shadow contact plan: the routing uses the contact plan until the shadow one is published,
+ * a discarded shadow contact plan leaves the contact plan as it is, the MTVs of the
+ * unchanged contacts survive the publication, a critical bundle still gets every neighbor
+ * after a publication that changes some of the routes.
+ */
+
+#include "test_common.h"
+
+#define LOCAL_NODE 1
+#define DESTINATION 3
+
+static void fill_link(UniboCGR_ContactPlanDelta delta, time_t now, uint64_t sender, uint64_t receiver) {
+    UniboCGR_FlatContact contact;
+    UniboCGR_FlatRange range;
+
+    memset(&contact, 0, sizeof(contact));
+    contact.sender = sender;
+    contact.receiver = receiver;
+    contact.start_time = now;
+    contact.end_time = now + 1000;
+    contact.xmit_rate = 100000;
+    contact.confidence = 1.0F;
+    CHECK_ERROR(UniboCGR_ContactPlanDelta_add_contact(delta, &contact), UniboCGR_NoError);
+
+    memset(&range, 0, sizeof(range));
+    range.sender = sender;
+    range.receiver = receiver;
+    range.start_time = now;
+    range.end_time = now + 1000;
+    range.one_way_light_time = 1;
+    CHECK_ERROR(UniboCGR_ContactPlanDelta_add_range(delta, &range), UniboCGR_NoError);
+}
+
+static double mtv_normal(UniboCGR uniboCgr, time_t now, uint64_t sender, uint64_t receiver) {
+    UniboCGR_Contact contact;
+    if (UniboCGR_find_contact(uniboCgr, UniboCGR_ContactType_Scheduled, sender, receiver, now, &contact) != UniboCGR_NoError) {
+        return -1.0;
+    }
+    return UniboCGR_Contact_get_mtv_normal(contact);
+}
+
+int main(void) {
+    time_t now = time(NULL);
+    UniboCGR uniboCgr = test_open(now, LOCAL_NODE);
+    UniboCGR_ContactPlanDelta delta;
+    uint64_t neighbors;
+    double mtv;
+
+    CHECK_ERROR(UniboCGR_contact_plan_open(uniboCgr, now), UniboCGR_NoError);
+    CHECK_ERROR(test_add_link(uniboCgr, now, LOCAL_NODE, 2, 0, 1000, 100000), UniboCGR_NoError);
+    CHECK_ERROR(test_add_link(uniboCgr, now, 2, DESTINATION, 0, 1000, 100000), UniboCGR_NoError);
+    CHECK_ERROR(test_add_link(uniboCgr, now, 5, 6, 0, 1000, 100000), UniboCGR_NoError);
+    CHECK_ERROR(UniboCGR_contact_plan_close(uniboCgr), UniboCGR_NoError);
+    CHECK_ERROR(UniboCGR_ContactPlanDelta_create(&delta), UniboCGR_NoError);
+
+    // not opened
+    CHECK_ERROR(UniboCGR_shadow_contact_plan_apply_delta(uniboCgr, delta, false), UniboCGR_ErrorSessionClosed);
+    CHECK_ERROR(UniboCGR_shadow_contact_plan_publish(uniboCgr, now), UniboCGR_ErrorSessionClosed);
+    CHECK_ERROR(UniboCGR_shadow_contact_plan_discard(uniboCgr), UniboCGR_ErrorSessionClosed);
+    // no session must be opened
+    CHECK_ERROR(UniboCGR_routing_open(uniboCgr, now), UniboCGR_NoError);
+    CHECK_ERROR(UniboCGR_shadow_contact_plan_open(uniboCgr, now, true), UniboCGR_ErrorSessionAlreadyOpened);
+    CHECK_ERROR(UniboCGR_routing_close(uniboCgr), UniboCGR_NoError);
+
+    // a second neighbor toward the destination, in the shadow contact plan only
+    fill_link(delta, now, LOCAL_NODE, 4);
+    fill_link(delta, now, 4, DESTINATION);
+    CHECK_ERROR(UniboCGR_shadow_contact_plan_open(uniboCgr, now, true), UniboCGR_NoError);
+    CHECK_ERROR(UniboCGR_shadow_contact_plan_apply_delta(uniboCgr, delta, false), UniboCGR_NoError);
+    CHECK_ERROR(test_route(uniboCgr, now, now, DESTINATION, true, &neighbors), UniboCGR_NoError);
+    CHECK(neighbors == NODE_BIT(2));
+    CHECK(mtv_normal(uniboCgr, now, LOCAL_NODE, 4) < 0.0);
+
+    // discarded: nothing changes
+    CHECK_ERROR(UniboCGR_shadow_contact_plan_discard(uniboCgr), UniboCGR_NoError);
+    CHECK_ERROR(test_route(uniboCgr, now, now, DESTINATION, true, &neighbors), UniboCGR_NoError);
+    CHECK(neighbors == NODE_BIT(2));
+
+    // published: the routing uses the new neighbor too
+    CHECK_ERROR(UniboCGR_shadow_contact_plan_open(uniboCgr, now, true), UniboCGR_NoError);
+    CHECK_ERROR(UniboCGR_shadow_contact_plan_apply_delta(uniboCgr, delta, false), UniboCGR_NoError);
+    CHECK_ERROR(UniboCGR_shadow_contact_plan_publish(uniboCgr, now), UniboCGR_NoError);
+    CHECK(mtv_normal(uniboCgr, now, LOCAL_NODE, 4) > 0.0);
+    CHECK_ERROR(test_route(uniboCgr, now, now, DESTINATION, true, &neighbors), UniboCGR_NoError);
+    CHECK(neighbors == (NODE_BIT(2) | NODE_BIT(4)));
+
+    // only an unrelated contact removed: the volume consumed so far is kept
+    mtv = mtv_normal(uniboCgr, now, LOCAL_NODE, 2);
+    CHECK(mtv < 1000.0 * 100000.0);
+    UniboCGR_ContactPlanDelta_reset(delta);
+    CHECK_ERROR(UniboCGR_ContactPlanDelta_remove_contact(delta, 5, 6, now), UniboCGR_NoError);
+    CHECK_ERROR(UniboCGR_shadow_contact_plan_open(uniboCgr, now, true), UniboCGR_NoError);
+    CHECK_ERROR(UniboCGR_shadow_contact_plan_apply_delta(uniboCgr, delta, false), UniboCGR_NoError);
+    CHECK_ERROR(UniboCGR_shadow_contact_plan_publish(uniboCgr, now), UniboCGR_NoError);
+    CHECK(mtv_normal(uniboCgr, now, LOCAL_NODE, 2) == mtv);
+    CHECK(mtv_normal(uniboCgr, now, 5, 6) < 0.0);
+
+    // two more neighbors toward the destination
+    UniboCGR_ContactPlanDelta_reset(delta);
+    fill_link(delta, now, LOCAL_NODE, 7);
+    fill_link(delta, now, 7, DESTINATION);
+    fill_link(delta, now, LOCAL_NODE, 8);
+    fill_link(delta, now, 8, DESTINATION);
+    CHECK_ERROR(UniboCGR_shadow_contact_plan_open(uniboCgr, now, true), UniboCGR_NoError);
+    CHECK_ERROR(UniboCGR_shadow_contact_plan_apply_delta(uniboCgr, delta, false), UniboCGR_NoError);
+    CHECK_ERROR(UniboCGR_shadow_contact_plan_publish(uniboCgr, now), UniboCGR_NoError);
+    CHECK_ERROR(test_route(uniboCgr, now, now, DESTINATION, true, &neighbors), UniboCGR_NoError);
+    CHECK(neighbors == (NODE_BIT(2) | NODE_BIT(4) | NODE_BIT(7) | NODE_BIT(8)));
+
+    // a contact shrunk and one removed: the routes through 2 and 4 were computed along with
+    // the changed ones, they go away too and every neighbor is found again
+    UniboCGR_ContactPlanDelta_reset(delta);
+    CHECK_ERROR(UniboCGR_ContactPlanDelta_change_contact_end_time(delta, 7, DESTINATION, now, now + 500),
+                UniboCGR_NoError);
+    CHECK_ERROR(UniboCGR_ContactPlanDelta_remove_contact(delta, 8, DESTINATION, now), UniboCGR_NoError);
+    CHECK_ERROR(UniboCGR_shadow_contact_plan_open(uniboCgr, now, true), UniboCGR_NoError);
+    CHECK_ERROR(UniboCGR_shadow_contact_plan_apply_delta(uniboCgr, delta, false), UniboCGR_NoError);
+    CHECK_ERROR(UniboCGR_shadow_contact_plan_publish(uniboCgr, now), UniboCGR_NoError);
+    CHECK(test_computed_routes(uniboCgr, now, LOCAL_NODE) == 0);
+    CHECK_ERROR(test_route(uniboCgr, now, now, DESTINATION, true, &neighbors), UniboCGR_NoError);
+    CHECK(neighbors == (NODE_BIT(2) | NODE_BIT(4) | NODE_BIT(7)));
+
+    // empty shadow contact plan: the destination cannot be reached anymore
+    CHECK_ERROR(UniboCGR_shadow_contact_plan_open(uniboCgr, now, false), UniboCGR_NoError);
+    CHECK_ERROR(UniboCGR_shadow_contact_plan_publish(uniboCgr, now), UniboCGR_NoError);
+    test_route(uniboCgr, now, now, DESTINATION, true, &neighbors);
+    CHECK(neighbors == 0);
+    CHECK(mtv_normal(uniboCgr, now, LOCAL_NODE, 2) < 0.0);
+
+    UniboCGR_ContactPlanDelta_destroy(&delta);
+    UniboCGR_close(&uniboCgr, now);
+
+    return TEST_RESULT();
+}
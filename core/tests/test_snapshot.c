@@ -0,0 +1,108 @@
+/*
+ * test_snapshot.c
+ *
+ * UniboCGR_snapshot_save() / UniboCGR_snapshot_load(): round trip into an empty instance,
+ * another contact plan (nothing restored), corrupted and truncated files (nothing loaded).
+ */
+
+#include "test_common.h"
+
+#define LOCAL_NODE 1
+#define DESTINATION 3
+
+static UniboCGR_Error load_snapshot(UniboCGR uniboCgr, time_t now, const char* filename, uint32_t* restored) {
+    UniboCGR_Error error;
+    CHECK_ERROR(UniboCGR_contact_plan_open(uniboCgr, now), UniboCGR_NoError);
+    error = UniboCGR_snapshot_load(uniboCgr, filename, restored);
+    CHECK_ERROR(UniboCGR_contact_plan_close(uniboCgr), UniboCGR_NoError);
+    return error;
+}
+
+/*
+ * Copy a file changing it: the byte at offset is flipped (if offset < size),
+ * then the copy is cut at length bytes.
+ */
+static void copy_changed(const char* from, const char* to, long offset, long length) {
+    FILE* in = fopen(from, "rb");
+    FILE* out = fopen(to, "wb");
+    long position = 0;
+    int c;
+    if (!in || !out) {
+        fprintf(stderr, "Cannot copy %s.\n", from);
+        exit(EXIT_FAILURE);
+    }
+    while ((c = fgetc(in)) != EOF && position < length) {
+        fputc((position == offset) ? (c ^ 0xFF) : c, out);
+        position++;
+    }
+    fclose(in);
+    fclose(out);
+}
+
+static long file_size(const char* filename) {
+    FILE* file = fopen(filename, "rb");
+    long size;
+    if (!file) return 0;
+    fseek(file, 0, SEEK_END);
+    size = ftell(file);
+    fclose(file);
+    return size;
+}
+
+int main(void) {
+    time_t now = time(NULL);
+    UniboCGR saved = test_open(now, LOCAL_NODE);
+    UniboCGR restored;
+    uint32_t routes = 0;
+    long size;
+
+    // 1 -> 2 -> 3 and 1 -> 4 -> 3
+    CHECK_ERROR(UniboCGR_contact_plan_open(saved, now), UniboCGR_NoError);
+    CHECK_ERROR(test_add_link(saved, now, LOCAL_NODE, 2, 0, 1000, 100000), UniboCGR_NoError);
+    CHECK_ERROR(test_add_link(saved, now, 2, DESTINATION, 0, 1000, 100000), UniboCGR_NoError);
+    CHECK_ERROR(test_add_link(saved, now, LOCAL_NODE, 4, 0, 1000, 100000), UniboCGR_NoError);
+    CHECK_ERROR(test_add_link(saved, now, 4, DESTINATION, 0, 1000, 100000), UniboCGR_NoError);
+    CHECK_ERROR(UniboCGR_contact_plan_close(saved), UniboCGR_NoError);
+    CHECK(test_route_to(saved, now, DESTINATION, false) != 0);
+    CHECK_ERROR(UniboCGR_snapshot_save(saved, "cgr.snapshot"), UniboCGR_NoError);
+
+    // round trip: the contact plan comes from the snapshot, with the routes
+    restored = test_open(now, LOCAL_NODE);
+    CHECK_ERROR(load_snapshot(restored, now, "cgr.snapshot", &routes), UniboCGR_NoError);
+    CHECK(routes > 0);
+    CHECK(test_count_contacts(restored) == 4 && test_count_ranges(restored) == 4);
+    CHECK(test_route_to(restored, now, DESTINATION, false) == test_route_to(saved, now, DESTINATION, false));
+    // same contact plan already loaded: only the routes are restored
+    CHECK_ERROR(load_snapshot(restored, now, "cgr.snapshot", &routes), UniboCGR_NoError);
+    CHECK(routes > 0);
+    CHECK(test_count_contacts(restored) == 4);
+    UniboCGR_close(&restored, now);
+
+    // another contact plan: refused and left as it is
+    restored = test_open(now, LOCAL_NODE);
+    CHECK_ERROR(UniboCGR_contact_plan_open(restored, now), UniboCGR_NoError);
+    CHECK_ERROR(test_add_link(restored, now, LOCAL_NODE, 2, 0, 500, 100000), UniboCGR_NoError);
+    CHECK_ERROR(UniboCGR_contact_plan_close(restored), UniboCGR_NoError);
+    routes = 1;
+    CHECK_ERROR(load_snapshot(restored, now, "cgr.snapshot", &routes), UniboCGR_ErrorSnapshotMismatch);
+    CHECK(routes == 0);
+    CHECK(test_count_contacts(restored) == 1 && test_count_ranges(restored) == 1);
+    UniboCGR_close(&restored, now);
+
+    // corrupted (a byte of the records) and truncated files: nothing loaded
+    size = file_size("cgr.snapshot");
+    CHECK(size > 0);
+    copy_changed("cgr.snapshot", "corrupted.snapshot", size / 2, size);
+    copy_changed("cgr.snapshot", "truncated.snapshot", -1, size - 1);
+    restored = test_open(now, LOCAL_NODE);
+    CHECK_ERROR(load_snapshot(restored, now, "corrupted.snapshot", NULL), UniboCGR_ErrorMalformedFile);
+    CHECK_ERROR(load_snapshot(restored, now, "truncated.snapshot", NULL), UniboCGR_ErrorMalformedFile);
+    CHECK_ERROR(load_snapshot(restored, now, "missing.snapshot", NULL), UniboCGR_ErrorCannotOpenFile);
+    CHECK(test_count_contacts(restored) == 0 && test_count_ranges(restored) == 0);
+    CHECK(test_route_to(restored, now, DESTINATION, false) == 0);
+    UniboCGR_close(&restored, now);
+
+    UniboCGR_close(&saved, now);
+
+    return TEST_RESULT();
+}
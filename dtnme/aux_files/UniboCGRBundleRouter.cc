@@ -255,10 +255,13 @@ UniboCGRBundleRouter::handle_bundle_transmitted(BundleTransmittedEvent* event)
     //          event->success_?"success":"failure", bundle.object());
 
     if (!event->success_) {
+        // give back the volume reserved on the failed route before rerouting
+        releaseUniboCGRReservation(bundle.object());
         // try again if not successful the first time 
         // (only applicable to the LTPUDP CLA as of 2014-12-04)
         route_bundle(bundle.object());
     } else {
+        commitUniboCGRReservation(bundle.object());
         // if the bundle has a deferred single-copy transmission for
         // forwarding on any links, then remove the forwarding log entries
         remove_from_deferred(bundle, ForwardingInfo::FORWARD_ACTION);
@@ -305,6 +308,8 @@ UniboCGRBundleRouter::delete_bundle(const BundleRef& bundle)
 {
     //log_debug("delete *%p", bundle.object());
 
+    // no-op if the bundle has been transmitted (reservation already committed)
+    releaseUniboCGRReservation(bundle.object());
     remove_from_deferred(bundle, ForwardingInfo::ANY_ACTION);
 }
 
@@ -317,6 +322,8 @@ UniboCGRBundleRouter::handle_bundle_cancelled(BundleSendCancelledEvent* event)
     Bundle* bundle = event->bundleref_.object();
     //log_debug("handle bundle cancelled: *%p", bundle);
 
+    releaseUniboCGRReservation(bundle);
+
     // if the bundle has expired, we don't want to reroute it.
     // XXX/demmer this might warrant a more general handling instead?
     if (!bundle->expired()) {
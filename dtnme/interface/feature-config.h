@@ -67,6 +67,11 @@ extern "C" {
 #define UNIBO_CGR_FEATURE_QUEUE_DELAY 0
 #endif
 
+/* Enable/disable Volume Reservations (the volume of a route is given back if the bundle is not transmitted). */
+#ifndef UNIBO_CGR_FEATURE_VOLUME_RESERVATIONS
+#define UNIBO_CGR_FEATURE_VOLUME_RESERVATIONS 1
+#endif
+
 
 #ifdef __cplusplus
 }
@@ -38,6 +38,8 @@
 // include from system
 #include <cstdlib>
 #include <iostream>
+#include <map>
+#include <vector>
 
 // include from dtnme
 #include "../../../RouteEntry.h"
@@ -61,6 +63,9 @@ using dtn::Bundle;
 using dtn::ContactPlanManager;
 using dtn::UniboCGRBundleRouter;
 
+// reservation of the volume consumed by the routing of each bundle
+typedef std::map<dtn::bundleid_t, UniboCGR_Reservation> ReservationMap;
+
 struct DTNME_UniboCGR {
     struct timeval lastContactPlanUpdate;
 
@@ -68,9 +73,12 @@ struct DTNME_UniboCGR {
 
     UniboCGR uniboCgr; // Unibo-CGR instance
     UniboCGR_Bundle uniboCgrBundle; // cached Unibo-CGR bundle
-    UniboCGR_Contact uniboCgrContact; // cached Unibo-CGR contact
-    UniboCGR_Range uniboCgrRange; // cached Unibo-CGR range
     UniboCGR_excluded_neighbors_list uniboCgrExcludedNeighborsList; // cached Unibo-CGR Excluded Neighbors List
+    std::vector<UniboCGR_FlatRoute> flatRoutes; // routes of the latest routing call (grown on demand)
+    UniboCGR_ContactPlanDelta delta; // cached contact plan delta
+    std::vector<UniboCGR_FlatContact> oldContacts, newContacts; // contact plan sync buffers
+    std::vector<UniboCGR_FlatRange> oldRanges, newRanges; // contact plan sync buffers
+    ReservationMap reservations; // volume reserved for the bundles not yet transmitted
 
     /* * from DTNME * */
 
@@ -89,8 +97,7 @@ static int computeApplicableBacklog(uint64_t neighbor,
 static void DTNME_UniboCGR_destroy(DTNME_UniboCGR* instance, time_t current_time_unix) {
     if (!instance) return;
     UniboCGR_close(&instance->uniboCgr, current_time_unix);
-    UniboCGR_Contact_destroy(&instance->uniboCgrContact);
-    UniboCGR_Range_destroy(&instance->uniboCgrRange);
+    UniboCGR_ContactPlanDelta_destroy(&instance->delta);
     UniboCGR_Bundle_destroy(&instance->uniboCgrBundle);
     UniboCGR_destroy_excluded_neighbors_list(&instance->uniboCgrExcludedNeighborsList);
     delete instance;
@@ -107,15 +114,9 @@ static DTNME_UniboCGR* DTNME_UniboCGR_create(time_t current_time_unix,
     instance->uniborouter = router;
 
     UniboCGR_Error uniboCgrError;
-    uniboCgrError = UniboCGR_Contact_create(&instance->uniboCgrContact);
-    if (UniboCGR_check_error(uniboCgrError)) {
-        std::cerr << "Cannot create Unibo-CGR Contact: " << UniboCGR_get_error_string(uniboCgrError) << std::endl;
-        DTNME_UniboCGR_destroy(instance, current_time_unix);
-        return nullptr;
-    }
-    uniboCgrError = UniboCGR_Range_create(&instance->uniboCgrRange);
+    uniboCgrError = UniboCGR_ContactPlanDelta_create(&instance->delta);
     if (UniboCGR_check_error(uniboCgrError)) {
-        std::cerr << "Cannot create Unibo-CGR Range: " << UniboCGR_get_error_string(uniboCgrError) << std::endl;
+        std::cerr << "Cannot create Unibo-CGR Contact Plan Delta: " << UniboCGR_get_error_string(uniboCgrError) << std::endl;
         DTNME_UniboCGR_destroy(instance, current_time_unix);
         return nullptr;
     }
@@ -297,6 +298,7 @@ static int convert_bundle_from_dtn2_to_cgr(UniboCGR uniboCgr, dtn::Bundle *Dtn2B
  *
  * \return void
  *
+ * \param[in]     instance
  * \param[in]     cgrRoutes       The list of routes in CGR's format
  * \param[out]    *res        	 All the next hops that CGR found, separated by a single space
  *
@@ -307,259 +309,212 @@ static int convert_bundle_from_dtn2_to_cgr(UniboCGR uniboCgr, dtn::Bundle *Dtn2B
  *  -------- | --------------- | -----------------------------------------------
  *  16/07/20 | G. Gori         |  Initial Implementation and documentation.
  *  03/11/22 | L. Persampieri  |  Adapted to new Unibo-CGR version (2.0).
+ *  18/10/26 | L. Persampieri  |  Read the routes from a flat buffer.
  *****************************************************************************/
-static void convert_routes_from_cgr_to_dtn2(UniboCGR uniboCgr, UniboCGR_route_list cgrRoutes, std::string *res)
+static void convert_routes_from_cgr_to_dtn2(DTNME_UniboCGR* instance, UniboCGR_route_list cgrRoutes, std::string *res)
 {
-	int numRes = 0;
-    UniboCGR_Route uniboCgrRoute = NULL;
-    UniboCGR_Error okRoute = UniboCGR_get_first_route(uniboCgr, cgrRoutes, &uniboCgrRoute);
-    for (/* empty */; okRoute == UniboCGR_NoError; okRoute = UniboCGR_get_next_route(uniboCgr, &uniboCgrRoute)) {
-		if (uniboCgrRoute != NULL)
-		{
-			if(numRes>0)
-			{
-				// blank-separated neighbors EID
-				res->append(" ");
-			}
-            uint64_t neighbor = UniboCGR_Route_get_neighbor(uniboCgrRoute);
-			std::string toNode = "ipn:";
-			std::stringstream streamNode;
-			streamNode << toNode << neighbor;
-			res->append(streamNode.str());
-			// Always using 0 as service number
-			res->append(".0");
-			numRes++;
-		}
-	}
-}
-
-static void convert_UniboCGR_Contact_to_CPContact(UniboCGR uniboCgr, UniboCGR_Contact inputContact, dtn::CPContact& outputContact) {
-    outputContact.setFrom(UniboCGR_Contact_get_sender(inputContact));
-    outputContact.setTo(UniboCGR_Contact_get_receiver(inputContact));
-
-    /* note: we must subtract the reference time since Unibo-CGR returns absolute times (Unix) and ContactPlanManager uses relative times. */
-    outputContact.setStartTime(UniboCGR_Contact_get_start_time(uniboCgr, inputContact) - dtn::ContactPlanManager::instance()->get_time_zero());
-    outputContact.setEndTime(UniboCGR_Contact_get_end_time(uniboCgr, inputContact) - dtn::ContactPlanManager::instance()->get_time_zero());
+    uint32_t routesCount = 0;
+    UniboCGR_Error error = UniboCGR_route_list_export(instance->uniboCgr, cgrRoutes,
+                                                      instance->flatRoutes.data(), instance->flatRoutes.size(),
+                                                      NULL, 0, &routesCount, NULL);
+    if (error == UniboCGR_ErrorBufferTooSmall) {
+        // grow the buffer (twice the required size) and try again
+        instance->flatRoutes.resize(2 * routesCount);
+        error = UniboCGR_route_list_export(instance->uniboCgr, cgrRoutes,
+                                           instance->flatRoutes.data(), instance->flatRoutes.size(),
+                                           NULL, 0, &routesCount, NULL);
+    }
+    if (UniboCGR_check_error(error)) {
+        return;
+    }
 
-    outputContact.setTransmissionSpeed(UniboCGR_Contact_get_xmit_rate(inputContact));
+    for (uint32_t i = 0; i < routesCount; i++) {
+        if (i > 0)
+        {
+            // blank-separated neighbors EID
+            res->append(" ");
+        }
+        std::string toNode = "ipn:";
+        std::stringstream streamNode;
+        streamNode << toNode << instance->flatRoutes[i].neighbor;
+        res->append(streamNode.str());
+        // Always using 0 as service number
+        res->append(".0");
+    }
 }
 
-static void convert_CPContact_to_UniboCGR_Contact(UniboCGR uniboCgr, const dtn::CPContact& inputContact, UniboCGR_Contact outputContact) {
-    /* note: default values -- type and confidence are not part of CPContact */
-    UniboCGR_Contact_set_type(outputContact, UniboCGR_ContactType_Scheduled);
-    UniboCGR_Contact_set_confidence(outputContact, 1.0f);
-
-    UniboCGR_Contact_set_sender(outputContact, inputContact.getFrom());
-    UniboCGR_Contact_set_receiver(outputContact, inputContact.getTo());
+static void convert_CPContact_to_UniboCGR_FlatContact(const dtn::CPContact& inputContact, UniboCGR_FlatContact& outputContact) {
+    outputContact.sender = inputContact.getFrom();
+    outputContact.receiver = inputContact.getTo();
 
     /* note: we must add the reference time since Unibo-CGR wants absolute times (Unix) and ContactPlanManager uses relative times. */
-    UniboCGR_Contact_set_start_time(uniboCgr, outputContact, inputContact.getStartTime() + dtn::ContactPlanManager::instance()->get_time_zero());
-    UniboCGR_Contact_set_end_time(uniboCgr, outputContact, inputContact.getEndTime() + dtn::ContactPlanManager::instance()->get_time_zero());
+    outputContact.start_time = inputContact.getStartTime() + dtn::ContactPlanManager::instance()->get_time_zero();
+    outputContact.end_time = inputContact.getEndTime() + dtn::ContactPlanManager::instance()->get_time_zero();
 
-    UniboCGR_Contact_set_xmit_rate(outputContact, inputContact.getTransmissionSpeed());
+    outputContact.xmit_rate = inputContact.getTransmissionSpeed();
+    /* note: default values -- confidence and MTVs are not part of CPContact */
+    outputContact.confidence = 1.0f;
+    outputContact.mtv[0] = outputContact.mtv[1] = outputContact.mtv[2] = 0.0;
 }
 
-static void convert_UniboCGR_Range_to_CPRange(UniboCGR uniboCgr, UniboCGR_Range inputRange, dtn::CPRange& outputRange) {
-    outputRange.setFrom(UniboCGR_Range_get_sender(inputRange));
-    outputRange.setTo(UniboCGR_Range_get_receiver(inputRange));
-
-    /* note: we must subtract the reference time since Unibo-CGR returns absolute times (Unix) and ContactPlanManager uses relative times. */
-    outputRange.setStartTime(UniboCGR_Range_get_start_time(uniboCgr, inputRange) - dtn::ContactPlanManager::instance()->get_time_zero());
-    outputRange.setEndTime(UniboCGR_Range_get_end_time(uniboCgr, inputRange) - dtn::ContactPlanManager::instance()->get_time_zero());
-
-    outputRange.setDelay(UniboCGR_Range_get_one_way_light_time(inputRange));
-}
-
-static void convert_CPRange_to_UniboCGR_Range(UniboCGR uniboCgr, const dtn::CPRange& inputRange, UniboCGR_Range outputRange) {
-    UniboCGR_Range_set_sender(outputRange, inputRange.getFrom());
-    UniboCGR_Range_set_receiver(outputRange, inputRange.getTo());
+static void convert_CPRange_to_UniboCGR_FlatRange(const dtn::CPRange& inputRange, UniboCGR_FlatRange& outputRange) {
+    outputRange.sender = inputRange.getFrom();
+    outputRange.receiver = inputRange.getTo();
 
     /* note: we must add the reference time since Unibo-CGR wants absolute times (Unix) and ContactPlanManager uses relative times. */
-    UniboCGR_Range_set_start_time(uniboCgr, outputRange, inputRange.getStartTime() + dtn::ContactPlanManager::instance()->get_time_zero());
-    UniboCGR_Range_set_end_time(uniboCgr, outputRange, inputRange.getEndTime() + dtn::ContactPlanManager::instance()->get_time_zero());
+    outputRange.start_time = inputRange.getStartTime() + dtn::ContactPlanManager::instance()->get_time_zero();
+    outputRange.end_time = inputRange.getEndTime() + dtn::ContactPlanManager::instance()->get_time_zero();
 
-    UniboCGR_Range_set_one_way_light_time(outputRange, inputRange.getDelay());
+    outputRange.one_way_light_time = inputRange.getDelay();
 }
 
-enum UpdateType {
-      UpdateType_NoUpdate,
-      UpdateType_ChangeEndTime,
-      UpdateType_ChangeXmitRate,
-      UpdateType_ChangeOneWayLightTime,
-      UpdateType_Remove
-};
-
 /*
- * Run UniboCGR_contact_plan_change_contact_*() if a CPContact has been changed.
- * Run UniboCGR_contact_plan_remove_contact() if contact is not found.
- * Do nothing otherwise (and return UpdateType_NoUpdate).
+ * Copy the Unibo-CGR contact plan -- already sorted as UniboCGR_ContactPlanDelta_diff_contacts() wants.
  */
-static UpdateType handle_contact_update(UniboCGR uniboCgr, UniboCGR_Contact uniboCgrContact, const std::list<CPContact>& contact_list) {
-    dtn::CPContact cpContact;
-    convert_UniboCGR_Contact_to_CPContact(uniboCgr, uniboCgrContact, cpContact);
-
-    for (std::list<CPContact>::const_iterator it = contact_list.cbegin(); it != contact_list.cend(); ++it) {
-        const CPContact &currentCpContact = *it;
-        if (cpContact != currentCpContact) continue; // next iteration -- does not match sender/receiver/startTime
-
-        // cpContact found!
-
-        UniboCGR_Error error;
-
-        if (cpContact.getEndTime() != currentCpContact.getEndTime()) {
-            error = UniboCGR_contact_plan_change_contact_end_time(uniboCgr,
-                                                                  UniboCGR_Contact_get_type(uniboCgrContact),
-                                                                  UniboCGR_Contact_get_sender(uniboCgrContact),
-                                                                  UniboCGR_Contact_get_receiver(uniboCgrContact),
-                                                                  UniboCGR_Contact_get_start_time(uniboCgr, uniboCgrContact),
-                                                                  currentCpContact.getEndTime() + dtn::ContactPlanManager::instance()->get_time_zero());
-            if (error == UniboCGR_NoError) {
-                return UpdateType_ChangeEndTime;
-            }
-        }
-        if (cpContact.getTransmissionSpeed() != currentCpContact.getTransmissionSpeed()) {
-            UniboCGR_contact_plan_change_contact_xmit_rate(uniboCgr,
-                                                           UniboCGR_Contact_get_type(uniboCgrContact),
-                                                           UniboCGR_Contact_get_sender(uniboCgrContact),
-                                                           UniboCGR_Contact_get_receiver(uniboCgrContact),
-                                                           UniboCGR_Contact_get_start_time(uniboCgr, uniboCgrContact),
-                                                           currentCpContact.getTransmissionSpeed());
-            if (error == UniboCGR_NoError) {
-                return UpdateType_ChangeXmitRate;
-            }
-        }
+static void get_unibocgr_contact_plan(DTNME_UniboCGR* instance) {
+    instance->oldContacts.clear();
+    UniboCGR_Contact uniboCgrContact = NULL;
+    for (UniboCGR_Error ok = UniboCGR_get_first_contact(instance->uniboCgr, &uniboCgrContact);
+         ok == UniboCGR_NoError;
+         ok = UniboCGR_get_next_contact(instance->uniboCgr, &uniboCgrContact)) {
+        UniboCGR_FlatContact contact;
+        contact.sender = UniboCGR_Contact_get_sender(uniboCgrContact);
+        contact.receiver = UniboCGR_Contact_get_receiver(uniboCgrContact);
+        contact.start_time = UniboCGR_Contact_get_start_time(instance->uniboCgr, uniboCgrContact);
+        contact.end_time = UniboCGR_Contact_get_end_time(instance->uniboCgr, uniboCgrContact);
+        contact.xmit_rate = UniboCGR_Contact_get_xmit_rate(uniboCgrContact);
+        contact.confidence = UniboCGR_Contact_get_confidence(uniboCgrContact);
+        contact.mtv[0] = contact.mtv[1] = contact.mtv[2] = 0.0;
+        instance->oldContacts.push_back(contact);
+    }
 
-        // contact found but do not need to update it
-        return UpdateType_NoUpdate;
+    instance->oldRanges.clear();
+    UniboCGR_Range uniboCgrRange = NULL;
+    for (UniboCGR_Error ok = UniboCGR_get_first_range(instance->uniboCgr, &uniboCgrRange);
+         ok == UniboCGR_NoError;
+         ok = UniboCGR_get_next_range(instance->uniboCgr, &uniboCgrRange)) {
+        UniboCGR_FlatRange range;
+        range.sender = UniboCGR_Range_get_sender(uniboCgrRange);
+        range.receiver = UniboCGR_Range_get_receiver(uniboCgrRange);
+        range.start_time = UniboCGR_Range_get_start_time(instance->uniboCgr, uniboCgrRange);
+        range.end_time = UniboCGR_Range_get_end_time(instance->uniboCgr, uniboCgrRange);
+        range.one_way_light_time = UniboCGR_Range_get_one_way_light_time(uniboCgrRange);
+        instance->oldRanges.push_back(range);
     }
-    UniboCGR_log_write(uniboCgr, "Before contact remove");
-    // contact not found -- must remove it from Unibo-CGR
-    UniboCGR_contact_plan_remove_contact(uniboCgr,
-                                         UniboCGR_Contact_get_type(uniboCgrContact),
-                                         UniboCGR_Contact_get_sender(uniboCgrContact),
-                                         UniboCGR_Contact_get_receiver(uniboCgrContact),
-                                         UniboCGR_Contact_get_start_time(uniboCgr, uniboCgrContact));
-
-    return UpdateType_Remove;
 }
 
-
 /*
- * Run UniboCGR_contact_plan_change_range_*() if a CPRange has been changed.
- * Run UniboCGR_contact_plan_remove_range() if range is not found.
- * Do nothing otherwise (and return UpdateType_NoUpdate).
+ * Compute the delta between the Unibo-CGR contact plan and the ContactPlanManager one,
+ * then apply it at once (one invalidation of the routes, no iterator restarted).
  */
-static UpdateType handle_range_update(UniboCGR uniboCgr, UniboCGR_Range uniboCgrRange, const std::list<CPRange>& range_list) {
-    dtn::CPRange cpRange;
-    convert_UniboCGR_Range_to_CPRange(uniboCgr, uniboCgrRange, cpRange);
-
-    for (std::list<CPRange>::const_iterator it = range_list.cbegin(); it != range_list.cend(); ++it) {
-        const CPRange &currentCpRange = *it;
-        if (cpRange != currentCpRange) continue; // next iteration -- does not match sender/receiver/startTime
-
-        // cpRange found!
+static void update_contact_plan(DTNME_UniboCGR* instance, time_t current_time_unix) {
+    dtn::ContactPlanManager* cpm = dtn::ContactPlanManager::instance();
+    if (!cpm->check_for_updates(&instance->lastContactPlanUpdate)) {
+        return;
+    }
 
-        UniboCGR_Error error;
+    UniboCGR_contact_plan_open(instance->uniboCgr, current_time_unix);
+    get_unibocgr_contact_plan(instance);
 
-        if (cpRange.getEndTime() != currentCpRange.getEndTime()) {
-            error = UniboCGR_contact_plan_change_range_end_time(uniboCgr,
-                                                                UniboCGR_Range_get_sender(uniboCgrRange),
-                                                                UniboCGR_Range_get_receiver(uniboCgrRange),
-                                                                UniboCGR_Range_get_start_time(uniboCgr, uniboCgrRange),
-                                                                currentCpRange.getEndTime() + dtn::ContactPlanManager::instance()->get_time_zero());
-            if (error == UniboCGR_NoError) {
-                return UpdateType_ChangeEndTime;
-            }
+    std::list<CPContact> contact_list = cpm->get_contact_list();
+    instance->newContacts.resize(contact_list.size());
+    size_t i = 0;
+    for (std::list<CPContact>::const_iterator it = contact_list.cbegin(); it != contact_list.cend(); ++it) {
+        convert_CPContact_to_UniboCGR_FlatContact(*it, instance->newContacts[i++]);
+    }
+    std::list<CPRange> range_list = cpm->get_range_list();
+    instance->newRanges.resize(range_list.size());
+    i = 0;
+    for (std::list<CPRange>::const_iterator it = range_list.cbegin(); it != range_list.cend(); ++it) {
+        convert_CPRange_to_UniboCGR_FlatRange(*it, instance->newRanges[i++]);
+    }
+    UniboCGR_ContactPlanDelta_sort_contacts(instance->newContacts.data(), instance->newContacts.size());
+    UniboCGR_ContactPlanDelta_sort_ranges(instance->newRanges.data(), instance->newRanges.size());
+    // the diff wants unique keys and the plan does not allow overlapping contacts (ranges):
+    // keep the first one, as the previous contact-by-contact insertion did
+    // (the same merge loop of the ION interface: overlapping is not an equivalence relation)
+    size_t count = 0;
+    for (i = 0; i < instance->newContacts.size(); i++) {
+        const UniboCGR_FlatContact& contact = instance->newContacts[i];
+        if (count > 0
+            && instance->newContacts[count - 1].sender == contact.sender
+            && instance->newContacts[count - 1].receiver == contact.receiver
+            && contact.start_time < instance->newContacts[count - 1].end_time) {
+            continue;
         }
-        if (cpRange.getDelay() != currentCpRange.getDelay()) {
-            error = UniboCGR_contact_plan_change_range_one_way_light_time(uniboCgr,
-                                                                          UniboCGR_Range_get_sender(uniboCgrRange),
-                                                                          UniboCGR_Range_get_receiver(uniboCgrRange),
-                                                                          UniboCGR_Range_get_start_time(uniboCgr, uniboCgrRange),
-                                                                          currentCpRange.getDelay());
-            if (error == UniboCGR_NoError) {
-                return UpdateType_ChangeOneWayLightTime;
-            }
+        instance->newContacts[count++] = contact;
+    }
+    instance->newContacts.resize(count);
+    count = 0;
+    for (i = 0; i < instance->newRanges.size(); i++) {
+        const UniboCGR_FlatRange& range = instance->newRanges[i];
+        if (count > 0
+            && instance->newRanges[count - 1].sender == range.sender
+            && instance->newRanges[count - 1].receiver == range.receiver
+            && range.start_time < instance->newRanges[count - 1].end_time) {
+            continue;
         }
-
-        // range found but do not need to update it
-        return UpdateType_NoUpdate;
+        instance->newRanges[count++] = range;
+    }
+    instance->newRanges.resize(count);
+
+    UniboCGR_ContactPlanDelta_reset(instance->delta);
+    UniboCGR_Error error = UniboCGR_ContactPlanDelta_diff_contacts(instance->delta,
+                                                                   instance->oldContacts.data(), instance->oldContacts.size(),
+                                                                   instance->newContacts.data(), instance->newContacts.size());
+    if (error == UniboCGR_NoError) {
+        error = UniboCGR_ContactPlanDelta_diff_ranges(instance->delta,
+                                                      instance->oldRanges.data(), instance->oldRanges.size(),
+                                                      instance->newRanges.data(), instance->newRanges.size());
+    }
+    if (error == UniboCGR_NoError) {
+        error = UniboCGR_contact_plan_apply_delta(instance->uniboCgr, instance->delta, false);
+    }
+    if (UniboCGR_check_error(error)) {
+        std::cerr << "Cannot update Unibo-CGR contact plan: " << UniboCGR_get_error_string(error) << std::endl;
     }
 
-    // range not found -- must remove it from Unibo-CGR
-    UniboCGR_contact_plan_remove_range(uniboCgr,
-                                       UniboCGR_Range_get_sender(uniboCgrRange),
-                                       UniboCGR_Range_get_receiver(uniboCgrRange),
-                                       UniboCGR_Range_get_start_time(uniboCgr, uniboCgrRange));
-
-    return UpdateType_Remove;
+    UniboCGR_contact_plan_close(instance->uniboCgr);
 }
 
-static void update_contact_plan(DTNME_UniboCGR* instance, time_t current_time_unix) {
-    dtn::ContactPlanManager* cpm = dtn::ContactPlanManager::instance();
-    UniboCGR_log_write(instance->uniboCgr, "Before contact plan update");
-    if (cpm->check_for_updates(&instance->lastContactPlanUpdate)) {
-        UniboCGR_log_write(instance->uniboCgr, "Before contact plan open");
-        UniboCGR_contact_plan_open(instance->uniboCgr, current_time_unix);
-        UniboCGR_log_write(instance->uniboCgr, "Before get contact list");
-        std::list<CPContact> contact_list = cpm->get_contact_list();
-        UniboCGR_log_write(instance->uniboCgr, "Before contact update");
-        { /* check for contact to update/remove */
-            UniboCGR_Contact uniboCgrContact = NULL;
-            UniboCGR_Error okContact = UniboCGR_get_first_contact(instance->uniboCgr, &uniboCgrContact);
-            while (okContact == UniboCGR_NoError) {
-                UniboCGR_log_write(instance->uniboCgr, "sender %lu receiver %lu start %ld",
-                                   UniboCGR_Contact_get_sender(uniboCgrContact),
-                                   UniboCGR_Contact_get_receiver(uniboCgrContact),
-                                   UniboCGR_Contact_get_start_time(instance->uniboCgr, uniboCgrContact));
-                if (handle_contact_update(instance->uniboCgr, uniboCgrContact, contact_list) != UpdateType_NoUpdate) {
-                    // need to iterate again from first contact -- change occurred (current iterator invalidated)
-                    okContact = UniboCGR_get_first_contact(instance->uniboCgr, &uniboCgrContact);
-                    UniboCGR_log_write(instance->uniboCgr, "loop first contact");
-                } else {
-                    okContact = UniboCGR_get_next_contact(instance->uniboCgr, &uniboCgrContact);
-                    UniboCGR_log_write(instance->uniboCgr, "loop next contact");
-                }
-            }
-        }
-        UniboCGR_log_write(instance->uniboCgr, "Before contact add");
-        { /* check for contact to add */
-            for (std::list<CPContact>::iterator it = contact_list.begin(); it != contact_list.end(); ++it) {
-                convert_CPContact_to_UniboCGR_Contact(instance->uniboCgr, *it, instance->uniboCgrContact);
-                UniboCGR_contact_plan_add_contact(instance->uniboCgr,
-                                                  instance->uniboCgrContact,
-                                                  false);
-                UniboCGR_log_write(instance->uniboCgr, "loop add contact");
-            }
-        }
-        UniboCGR_log_write(instance->uniboCgr, "Before get range list");
-        std::list<CPRange> range_list = cpm->get_range_list();
-        UniboCGR_log_write(instance->uniboCgr, "Before range update");
-        { /* check for range to update/remove */
-            UniboCGR_Range uniboCgrRange = NULL;
-            UniboCGR_Error okRange = UniboCGR_get_first_range(instance->uniboCgr, &uniboCgrRange);
-            while (okRange == UniboCGR_NoError) {
-                if (handle_range_update(instance->uniboCgr, uniboCgrRange, range_list) != UpdateType_NoUpdate) {
-                    // need to iterate again from first range -- change occurred (current iterator invalidated)
-                    okRange = UniboCGR_get_first_range(instance->uniboCgr, &uniboCgrRange);
-                    UniboCGR_log_write(instance->uniboCgr, "loop first range");
-                } else {
-                    okRange = UniboCGR_get_next_range(instance->uniboCgr, &uniboCgrRange);
-                    UniboCGR_log_write(instance->uniboCgr, "loop next range");
-                }
-            }
-        }
-        UniboCGR_log_write(instance->uniboCgr, "Before range add");
-        { /* check for range to add */
-            for (std::list<CPRange>::iterator it = range_list.begin(); it != range_list.end(); ++it) {
-                convert_CPRange_to_UniboCGR_Range(instance->uniboCgr, *it, instance->uniboCgrRange);
-                UniboCGR_contact_plan_add_range(instance->uniboCgr,
-                                                instance->uniboCgrRange);
-                UniboCGR_log_write(instance->uniboCgr, "loop add range");
-            }
-        }
-
-        UniboCGR_contact_plan_close(instance->uniboCgr);
+/******************************************************************************
+ *
+ * \par Function Name:
+ *      store_reservation
+ *
+ * \brief  Keep the reservation of the last routing call until the bundle
+ *         is transmitted (commit) or not (release).
+ *
+ *
+ * \par Date Written:
+ *      18/10/26
+ *
+ * \return  void
+ *
+ * \param[in]  *instance     The Unibo-CGR instance
+ * \param[in]  bundleId      The routed bundle
+ * \param[in]  reservation   The reservation of the last routing call (0 if nothing reserved)
+ *
+ * \par Notes:
+ *          1.  If the bundle is rerouted while it is still queued (no transmitted
+ *              or canceled event yet), the previous reservation is committed:
+ *              the bundle may still be transmitted on the previous route.
+ *
+ * \par Revision History:
+ *
+ *  DD/MM/YY |  AUTHOR         |   DESCRIPTION
+ *  -------- | --------------- | -----------------------------------------------
+ *  18/10/26 | L. Persampieri  |  Initial Implementation and documentation.
+ *****************************************************************************/
+static void store_reservation(DTNME_UniboCGR* instance, dtn::bundleid_t bundleId, UniboCGR_Reservation reservation)
+{
+    ReservationMap::iterator it = instance->reservations.find(bundleId);
+    if (it != instance->reservations.end()) {
+        UniboCGR_reservation_commit(instance->uniboCgr, it->second);
+        instance->reservations.erase(it);
+    }
+    if (reservation != 0) {
+        instance->reservations[bundleId] = reservation;
     }
 }
 
@@ -593,6 +548,7 @@ static void update_contact_plan(DTNME_UniboCGR* instance, time_t current_time_un
  *  05/07/20 | G. Gori		    |  Initial Implementation and documentation.
  *  19/04/22 | Federico Le Pera |  Support to update contact plan only if it changes
  *  03/11/22 | Lorenzo Persampieri |  Adapted to new Unibo-CGR version (2.0).
+ *  18/10/26 | L. Persampieri  |  Keep the volume reservation of the bundle.
  *****************************************************************************/
 int callUniboCGR(time_t time, dtn::Bundle *bundle, std::string *res)
 {
@@ -634,13 +590,84 @@ int callUniboCGR(time_t time, dtn::Bundle *bundle, std::string *res)
         // route not found
         *res = "";
     } else {
-        convert_routes_from_cgr_to_dtn2(instance->uniboCgr, cgrRoutes, res);
+        convert_routes_from_cgr_to_dtn2(instance, cgrRoutes, res);
+        store_reservation(instance, bundle->bundleid(), UniboCGR_get_reservation(instance->uniboCgr));
         UniboCGR_routing_close(instance->uniboCgr);
     }
     
     return 0;
 }
 
+/******************************************************************************
+ *
+ * \par Function Name:
+ *      commitUniboCGRReservation
+ *
+ * \brief  The bundle has been transmitted: the volume reserved for it stays consumed.
+ *
+ *
+ * \par Date Written:
+ *      18/10/26
+ *
+ * \return  void
+ *
+ * \param[in]  *bundle  The transmitted bundle
+ *
+ *
+ * \par Revision History:
+ *
+ *  DD/MM/YY |  AUTHOR         |   DESCRIPTION
+ *  -------- | --------------- | -----------------------------------------------
+ *  18/10/26 | L. Persampieri  |  Initial Implementation and documentation.
+ *****************************************************************************/
+void commitUniboCGRReservation(dtn::Bundle *bundle)
+{
+    DTNME_UniboCGR* instance = get_unibo_cgr_instance();
+    if (!instance || !bundle) return;
+
+    ReservationMap::iterator it = instance->reservations.find(bundle->bundleid());
+    if (it != instance->reservations.end()) {
+        UniboCGR_reservation_commit(instance->uniboCgr, it->second);
+        instance->reservations.erase(it);
+    }
+}
+
+/******************************************************************************
+ *
+ * \par Function Name:
+ *      releaseUniboCGRReservation
+ *
+ * \brief  The bundle will not be transmitted on the route found by the last
+ *         routing call (transmission failed or canceled, bundle deleted):
+ *         give back to the contacts the volume reserved for it.
+ *
+ *
+ * \par Date Written:
+ *      18/10/26
+ *
+ * \return  void
+ *
+ * \param[in]  *bundle  The bundle
+ *
+ *
+ * \par Revision History:
+ *
+ *  DD/MM/YY |  AUTHOR         |   DESCRIPTION
+ *  -------- | --------------- | -----------------------------------------------
+ *  18/10/26 | L. Persampieri  |  Initial Implementation and documentation.
+ *****************************************************************************/
+void releaseUniboCGRReservation(dtn::Bundle *bundle)
+{
+    DTNME_UniboCGR* instance = get_unibo_cgr_instance();
+    if (!instance || !bundle) return;
+
+    ReservationMap::iterator it = instance->reservations.find(bundle->bundleid());
+    if (it != instance->reservations.end()) {
+        UniboCGR_reservation_release(instance->uniboCgr, it->second);
+        instance->reservations.erase(it);
+    }
+}
+
 /******************************************************************************
  *
  * \par Function Name:
@@ -740,6 +767,14 @@ static int enable_UniboCGR_default_features(UniboCGR uniboCgr, time_t current_ti
         return -1;
     }
 #endif
+#if UNIBO_CGR_FEATURE_VOLUME_RESERVATIONS
+    error = UniboCGR_feature_VolumeReservations_enable(uniboCgr);
+    if (UniboCGR_check_error(error)) {
+        UniboCGR_feature_close(uniboCgr);
+        std::cerr << "Cannot enable Unibo-CGR volume-reservations feature" << std::endl;
+        return -1;
+    }
+#endif
     
     UniboCGR_feature_close(uniboCgr);
 
@@ -40,6 +40,8 @@
 #include <string>
 
 extern int callUniboCGR(time_t time, dtn::Bundle *bundle, std::string *res);
+extern void commitUniboCGRReservation(dtn::Bundle *bundle);
+extern void releaseUniboCGRReservation(dtn::Bundle *bundle);
 extern void destroy_contact_graph_routing(time_t time);
 extern int initialize_contact_graph_routing(uint64_t ownNode, time_t time, dtn::UniboCGRBundleRouter* router);
 
@@ -69,6 +69,10 @@ typedef struct UniboCGR_Range_opaque* UniboCGR_Range;
 typedef struct UniboCGR_Route_opaque* UniboCGR_Route;
 typedef struct UniboCGR_route_list_opaque* UniboCGR_route_list;
 typedef struct UniboCGR_excluded_neighbors_list_opaque* UniboCGR_excluded_neighbors_list;
+/*
+ * Handle of the contacts volume reserved by a routing call. 0 means "nothing reserved".
+ */
+typedef uint64_t UniboCGR_Reservation;
 
 /*
  * Note: At the time of writing only UniboCGR_ContactType_Scheduled is supported
@@ -136,7 +140,12 @@ typedef enum {
     UniboCGR_ErrorMalformedMSRRoute         = -14,
     UniboCGR_ErrorSessionAlreadyOpened      = -15,
     UniboCGR_ErrorSessionClosed             = -16,
-    UniboCGR_ErrorWrongSession              = -17
+    UniboCGR_ErrorWrongSession              = -17,
+    UniboCGR_ErrorReservationNotFound       = -18,
+    UniboCGR_ErrorBufferTooSmall            = -19,
+    UniboCGR_ErrorCannotOpenFile            = -20,
+    UniboCGR_ErrorMalformedFile             = -21,
+    UniboCGR_ErrorSnapshotMismatch          = -22
 } UniboCGR_Error;
 
 extern const char* UniboCGR_get_error_string(UniboCGR_Error error);
@@ -332,6 +341,370 @@ extern UniboCGR_Error UniboCGR_contact_plan_change_range_one_way_light_time(Unib
                                                                             time_t start_time,
                                                                             uint64_t new_owlt);
 
+/**
+ * \brief A contact, as read by UniboCGR_contact_plan_add_contacts_bulk().
+ */
+typedef struct {
+    uint64_t sender;
+    uint64_t receiver;
+    time_t start_time; // Unix time
+    time_t end_time; // Unix time
+    uint64_t xmit_rate; // bytes per second
+    float confidence;
+    double mtv[3]; // bulk, normal, expedited (bytes) -- read only if copy_mtv is true
+} UniboCGR_FlatContact;
+
+/**
+ * \brief A range, as read by UniboCGR_contact_plan_add_ranges_bulk().
+ */
+typedef struct {
+    uint64_t sender;
+    uint64_t receiver;
+    time_t start_time; // Unix time
+    time_t end_time; // Unix time
+    uint64_t one_way_light_time; // seconds
+} UniboCGR_FlatRange;
+
+/**
+ * \brief Add many contacts at once. Same result of UniboCGR_contact_plan_add_contact() called
+ *        for each contact, but the contacts are sorted once and (when they are many)
+ *        the contacts graph is rebuilt bottom-up instead of inserting each contact.
+ *
+ * \details All or nothing: if a contact is not valid, or overlaps another contact
+ *          (of the array or of the contact plan), no contact is added.
+ *          The contacts already expired are skipped.
+ *
+ * \retval UniboCGR_NoError                        All the contacts added
+ * \retval UniboCGR_ErrorInvalidArgument           Some contact is not valid
+ * \retval UniboCGR_ErrorFoundOverlappingContact   Some contact overlaps another contact
+ * \retval UniboCgr_ErrorSystem                    Memory allocation error
+ */
+extern UniboCGR_Error UniboCGR_contact_plan_add_contacts_bulk(UniboCGR uniboCgr,
+                                                              const UniboCGR_FlatContact* contacts,
+                                                              uint32_t count,
+                                                              bool copy_mtv);
+
+/**
+ * \brief Add many ranges at once. Same result of UniboCGR_contact_plan_add_range() called
+ *        for each range (see UniboCGR_contact_plan_add_contacts_bulk()).
+ *
+ * \details All or nothing: an existing range is not revised, it is an overlapping range.
+ */
+extern UniboCGR_Error UniboCGR_contact_plan_add_ranges_bulk(UniboCGR uniboCgr,
+                                                            const UniboCGR_FlatRange* ranges,
+                                                            uint32_t count);
+
+/**
+ * \brief A batch of add/remove/change operations on contacts and ranges,
+ *        applied at once by UniboCGR_contact_plan_apply_delta().
+ *
+ * \details The contacts and ranges are identified by sender, receiver and start time (Unix time).
+ *          The operations on the same contact (range) are applied in insertion order:
+ *          a contact added then changed is added with the new values, a contact
+ *          added then removed is not added, a contact removed then added is replaced.
+ *          The start time is the key: change it by removing the contact and adding it again.
+ */
+typedef struct UniboCGR_ContactPlanDelta_opaque* UniboCGR_ContactPlanDelta;
+
+extern UniboCGR_Error UniboCGR_ContactPlanDelta_create(UniboCGR_ContactPlanDelta* uniboCgrDelta);
+extern void           UniboCGR_ContactPlanDelta_destroy(UniboCGR_ContactPlanDelta* uniboCgrDelta);
+/**
+ * \brief Remove all the operations (the delta can be filled again).
+ */
+extern void           UniboCGR_ContactPlanDelta_reset(UniboCGR_ContactPlanDelta uniboCgrDelta);
+extern bool           UniboCGR_ContactPlanDelta_is_empty(UniboCGR_ContactPlanDelta uniboCgrDelta);
+
+extern UniboCGR_Error UniboCGR_ContactPlanDelta_add_contact(UniboCGR_ContactPlanDelta uniboCgrDelta,
+                                                            const UniboCGR_FlatContact* contact);
+extern UniboCGR_Error UniboCGR_ContactPlanDelta_remove_contact(UniboCGR_ContactPlanDelta uniboCgrDelta,
+                                                               uint64_t sender,
+                                                               uint64_t receiver,
+                                                               time_t start_time);
+extern UniboCGR_Error UniboCGR_ContactPlanDelta_change_contact_end_time(UniboCGR_ContactPlanDelta uniboCgrDelta,
+                                                                        uint64_t sender,
+                                                                        uint64_t receiver,
+                                                                        time_t start_time,
+                                                                        time_t new_end_time);
+extern UniboCGR_Error UniboCGR_ContactPlanDelta_change_contact_xmit_rate(UniboCGR_ContactPlanDelta uniboCgrDelta,
+                                                                         uint64_t sender,
+                                                                         uint64_t receiver,
+                                                                         time_t start_time,
+                                                                         uint64_t new_xmit_rate);
+extern UniboCGR_Error UniboCGR_ContactPlanDelta_change_contact_confidence(UniboCGR_ContactPlanDelta uniboCgrDelta,
+                                                                          uint64_t sender,
+                                                                          uint64_t receiver,
+                                                                          time_t start_time,
+                                                                          float new_confidence);
+extern UniboCGR_Error UniboCGR_ContactPlanDelta_add_range(UniboCGR_ContactPlanDelta uniboCgrDelta,
+                                                          const UniboCGR_FlatRange* range);
+extern UniboCGR_Error UniboCGR_ContactPlanDelta_remove_range(UniboCGR_ContactPlanDelta uniboCgrDelta,
+                                                             uint64_t sender,
+                                                             uint64_t receiver,
+                                                             time_t start_time);
+extern UniboCGR_Error UniboCGR_ContactPlanDelta_change_range_end_time(UniboCGR_ContactPlanDelta uniboCgrDelta,
+                                                                      uint64_t sender,
+                                                                      uint64_t receiver,
+                                                                      time_t start_time,
+                                                                      time_t new_end_time);
+extern UniboCGR_Error UniboCGR_ContactPlanDelta_change_range_one_way_light_time(UniboCGR_ContactPlanDelta uniboCgrDelta,
+                                                                                uint64_t sender,
+                                                                                uint64_t receiver,
+                                                                                time_t start_time,
+                                                                                uint64_t new_owlt);
+
+/**
+ * \brief Sort contacts (ranges) as UniboCGR_ContactPlanDelta_diff_contacts() wants them:
+ *        by sender, receiver and start time (the order of UniboCGR_get_first_contact() and
+ *        UniboCGR_get_next_contact()).
+ */
+extern void UniboCGR_ContactPlanDelta_sort_contacts(UniboCGR_FlatContact* contacts, uint32_t count);
+extern void UniboCGR_ContactPlanDelta_sort_ranges(UniboCGR_FlatRange* ranges, uint32_t count);
+
+/**
+ * \brief Append to the delta the operations that turn old_contacts into new_contacts:
+ *        the contacts only in old_contacts are removed, the contacts only in new_contacts are added,
+ *        end time, transmission rate and confidence of the contacts in both are changed if they differ.
+ *
+ * \details Both arrays must be sorted (see UniboCGR_ContactPlanDelta_sort_contacts()),
+ *          without duplicates; they are merged in a single pass. The MTVs are not compared.
+ *
+ * \retval UniboCGR_NoError                 Success
+ * \retval UniboCGR_ErrorInvalidArgument    An array is not sorted or has duplicates
+ * \retval UniboCgr_ErrorSystem             Memory allocation error
+ */
+extern UniboCGR_Error UniboCGR_ContactPlanDelta_diff_contacts(UniboCGR_ContactPlanDelta uniboCgrDelta,
+                                                              const UniboCGR_FlatContact* old_contacts,
+                                                              uint32_t old_count,
+                                                              const UniboCGR_FlatContact* new_contacts,
+                                                              uint32_t new_count);
+/**
+ * \brief Same as UniboCGR_ContactPlanDelta_diff_contacts(), for the ranges
+ *        (end time and one way light time are compared).
+ */
+extern UniboCGR_Error UniboCGR_ContactPlanDelta_diff_ranges(UniboCGR_ContactPlanDelta uniboCgrDelta,
+                                                            const UniboCGR_FlatRange* old_ranges,
+                                                            uint32_t old_count,
+                                                            const UniboCGR_FlatRange* new_ranges,
+                                                            uint32_t new_count);
+
+/**
+ * \brief Apply all the operations of the delta, with a single invalidation of the routes.
+ *
+ * \details The operations are sorted as the contacts (ranges) graph and reduced to
+ *          their net effect on each contact (range), then checked against the contact plan
+ *          as it will be after the removals and the revisions.
+ *          Each operation that cannot be applied is skipped and written in the log, as it happens
+ *          adding the contacts (ranges) one by one: a change of a contact (range) not in the
+ *          contact plan, an invalid value, an end time that overlaps the next contact (range),
+ *          a new contact (range) that overlaps another one. The other operations are applied:
+ *          the contacts (ranges) are removed and revised in key order, and the new ones are added
+ *          through UniboCGR_contact_plan_add_contacts_bulk() and UniboCGR_contact_plan_add_ranges_bulk().
+ *          If something is added or widened all the routes are discarded once,
+ *          at the end of the session; otherwise only the routes through the removed or
+ *          reduced contacts (ranges) are discarded.
+ *          A change of end time to a time already elapsed removes the contact (range).
+ *          The delta is sorted but not emptied (see UniboCGR_ContactPlanDelta_reset()).
+ *
+ * \note Call it within a contact plan session.
+ *
+ * \retval UniboCGR_NoError                        Success (maybe some operation skipped)
+ * \retval UniboCGR_ErrorContactNotFound           The delta changes a contact after removing it
+ *                                                 (the contact plan is not touched)
+ * \retval UniboCGR_ErrorRangeNotFound             The delta changes a range after removing it (as above)
+ * \retval UniboCGR_ErrorFoundOverlappingContact   The delta adds a contact twice (as above)
+ * \retval UniboCGR_ErrorFoundOverlappingRange     The delta adds a range twice (as above)
+ * \retval UniboCgr_ErrorSystem                    Memory allocation error
+ */
+extern UniboCGR_Error UniboCGR_contact_plan_apply_delta(UniboCGR uniboCgr,
+                                                        UniboCGR_ContactPlanDelta uniboCgrDelta,
+                                                        bool copy_mtv);
+
+/**
+ * \brief Open the shadow contact plan: a second contact plan edited while the routing
+ *        keeps using the current one, then published at once by UniboCGR_shadow_contact_plan_publish().
+ *
+ * \details The shadow contact plan starts as a copy of the contact plan (MTVs included) if
+ *          copy_contact_plan is true, empty otherwise (e.g. to load the whole contact plan again).
+ *          A shadow contact plan already opened is discarded.
+ *          The shadow calls need no session and can be interleaved with the routing sessions:
+ *          an update split in many deltas never stops the routing for long.
+ *
+ * \note Call it when no session is opened.
+ *
+ * \retval UniboCGR_NoError                    Success
+ * \retval UniboCGR_ErrorSessionAlreadyOpened  A session is opened
+ * \retval UniboCgr_ErrorSystem                Memory allocation error
+ */
+extern UniboCGR_Error UniboCGR_shadow_contact_plan_open(UniboCGR uniboCgr, time_t time, bool copy_contact_plan);
+
+/**
+ * \brief Apply the delta to the shadow contact plan (see UniboCGR_contact_plan_apply_delta()).
+ *
+ * \details No route is discarded: the routes use the contact plan, not the shadow one.
+ *
+ * \retval UniboCGR_ErrorSessionClosed  The shadow contact plan is not opened
+ * \retval other                        As UniboCGR_contact_plan_apply_delta()
+ */
+extern UniboCGR_Error UniboCGR_shadow_contact_plan_apply_delta(UniboCGR uniboCgr,
+                                                               UniboCGR_ContactPlanDelta uniboCgrDelta,
+                                                               bool copy_mtv);
+
+/**
+ * \brief Drop the shadow contact plan, the contact plan is not touched.
+ *
+ * \retval UniboCGR_NoError            Success
+ * \retval UniboCGR_ErrorSessionClosed The shadow contact plan is not opened
+ */
+extern UniboCGR_Error UniboCGR_shadow_contact_plan_discard(UniboCGR uniboCgr);
+
+/**
+ * \brief The shadow contact plan becomes the contact plan.
+ *
+ * \details The two contact plans are swapped in constant time. Then both are walked once in key order:
+ *          the routes whose contacts are unchanged move to the new contact plan, along with
+ *          the MTVs of those contacts; all the routes of the destinations reached through removed
+ *          or changed contacts (ranges) are discarded. If something has been added or widened
+ *          all the routes are discarded.
+ *          The previous contact plan is kept and reused by the next UniboCGR_shadow_contact_plan_open().
+ *
+ * \note Call it when no session is opened.
+ *
+ * \retval UniboCGR_NoError                    Success
+ * \retval UniboCGR_ErrorSessionAlreadyOpened  A session is opened
+ * \retval UniboCGR_ErrorSessionClosed         The shadow contact plan is not opened
+ * \retval UniboCgr_ErrorSystem                Memory allocation error
+ */
+extern UniboCGR_Error UniboCGR_shadow_contact_plan_publish(UniboCGR uniboCgr, time_t time);
+
+/**
+ * \brief Write a binary contact plan file, that can be loaded by UniboCGR_contact_plan_load_binary().
+ *
+ * \details The file holds fixed-width contact and range records, sorted as the Unibo-CGR
+ *          contacts and ranges graphs, and (if with_adjacency is true) the index of the
+ *          contacts sent by each node. The file is written in host byte order.
+ *          Times are written as they are: they are relative to the time_offset
+ *          given to UniboCGR_contact_plan_load_binary(), the MTVs are always written.
+ *          Records are not validated here.
+ *
+ * \note No Unibo-CGR instance is needed: use it to convert other contact plan formats.
+ *
+ * \retval UniboCGR_NoError                 Success
+ * \retval UniboCGR_ErrorCannotOpenFile     Cannot open or write the file
+ * \retval UniboCgr_ErrorSystem             Memory allocation error
+ */
+extern UniboCGR_Error UniboCGR_contact_plan_write_binary(const char* filename,
+                                                         const UniboCGR_FlatContact* contacts,
+                                                         uint32_t contacts_count,
+                                                         const UniboCGR_FlatRange* ranges,
+                                                         uint32_t ranges_count,
+                                                         bool with_adjacency);
+
+/**
+ * \brief Load a binary contact plan file written by UniboCGR_contact_plan_write_binary().
+ *
+ * \details The file is mapped in memory (no parsing) and its contacts and ranges are
+ *          added through UniboCGR_contact_plan_add_contacts_bulk() and
+ *          UniboCGR_contact_plan_add_ranges_bulk(); time_offset is added to all times.
+ *          All the records are added, or none: if the ranges are refused the contacts added are removed.
+ *
+ * \retval UniboCGR_NoError                 Success
+ * \retval UniboCGR_ErrorCannotOpenFile     Cannot open or map the file
+ * \retval UniboCGR_ErrorMalformedFile      Not a binary contact plan (or of another version/byte order)
+ * \retval others                           See UniboCGR_contact_plan_add_contacts_bulk()
+ */
+extern UniboCGR_Error UniboCGR_contact_plan_load_binary(UniboCGR uniboCgr,
+                                                        const char* filename,
+                                                        time_t time_offset,
+                                                        bool copy_mtv);
+
+/**
+ * \brief Load a contact plan text file.
+ *
+ * \details Accepted lines (they can be mixed in the same file):
+ *          - "CONTACT,from,to,start,end,xmit_rate,confidence,mtv_bulk,mtv_normal,mtv_expedited"
+ *          - "RANGE,from,to,start,end[,owlt]" (owlt is 0 if missing)
+ *          - ionadmin "a contact <start> <end> <from> <to> <xmit_rate> [confidence]"
+ *          - ionadmin "a range <start> <end> <from> <to> <owlt>"
+ *
+ *          CSV times are seconds relative to time_offset; ionadmin times are "+seconds"
+ *          (relative to time_offset) or "yyyy/mm/dd-hh:mm:ss" (UTC).
+ *          As in ION, an ionadmin range is symmetric unless the reverse range is declared too.
+ *          Any other line is ignored.
+ *
+ *          The file is mapped in memory and parsed in parallel (up to "threads" threads,
+ *          0 to use all the online CPUs), then the records are added through
+ *          UniboCGR_contact_plan_add_contacts_bulk() and UniboCGR_contact_plan_add_ranges_bulk().
+ *          All the records are added, or none: if the ranges are refused the contacts added are removed.
+ *
+ * \param error_line If UniboCGR_ErrorMalformedFile is returned: the first line with a
+ *                   syntax error (starting from 1). Can be NULL.
+ *
+ * \retval UniboCGR_NoError                 Success
+ * \retval UniboCGR_ErrorCannotOpenFile     Cannot open or map the file
+ * \retval UniboCGR_ErrorMalformedFile      Syntax error at line *error_line
+ * \retval others                           See UniboCGR_contact_plan_add_contacts_bulk()
+ */
+extern UniboCGR_Error UniboCGR_contact_plan_load_text(UniboCGR uniboCgr,
+                                                      const char* filename,
+                                                      time_t time_offset,
+                                                      bool copy_mtv,
+                                                      uint32_t threads,
+                                                      uint64_t* error_line);
+
+/**
+ * \brief Convert a contact plan text file (see UniboCGR_contact_plan_load_text())
+ *        to a binary contact plan file (see UniboCGR_contact_plan_write_binary()).
+ *
+ * \details ionadmin absolute times are written relative to time_offset.
+ *          Records are not validated here.
+ */
+extern UniboCGR_Error UniboCGR_contact_plan_convert_text_to_binary(const char* text_filename,
+                                                                   const char* binary_filename,
+                                                                   time_t time_offset,
+                                                                   uint32_t threads,
+                                                                   uint64_t* error_line);
+
+/**
+ * \brief Save the contact plan (with the current MTVs) and the routes computed so far
+ *        to each destination in a snapshot file, to be restored after a restart
+ *        by UniboCGR_snapshot_load().
+ *
+ * \details The routes (selected and known, with the Yen's references between them) are
+ *          written as sequences of contact indexes, together with a hash of the contact plan.
+ *          The file is written in host byte order.
+ *
+ * \note No session must be open.
+ *
+ * \retval UniboCGR_NoError                 Success
+ * \retval UniboCGR_ErrorCannotOpenFile     Cannot open or write the file
+ * \retval UniboCgr_ErrorSystem             Memory allocation error
+ */
+extern UniboCGR_Error UniboCGR_snapshot_save(UniboCGR uniboCgr, const char* filename);
+
+/**
+ * \brief Restore a snapshot written by UniboCGR_snapshot_save(): the first bundles
+ *        to each destination use the restored routes instead of computing them again.
+ *
+ * \details If the contact plan is empty, the contacts (with their MTVs) and the ranges
+ *          are loaded from the snapshot. Otherwise the contact plan must be the snapshot's one:
+ *          the contacts and ranges not yet expired are compared by hash, then the MTVs are
+ *          restored. All the routes computed so far are replaced by the snapshot's ones;
+ *          the routes through contacts already expired are not restored.
+ *          The snapshot can be restored by an instance with another time base.
+ *          If the snapshot is not restored, the contact plan loaded from it is removed.
+ *
+ * \note Call it within a contact plan session.
+ *
+ * \param restored_routes The number of routes restored. Can be NULL.
+ *
+ * \retval UniboCGR_NoError                 Success
+ * \retval UniboCGR_ErrorCannotOpenFile     Cannot open or map the file
+ * \retval UniboCGR_ErrorMalformedFile      Not a snapshot (or of another version/byte order), or corrupted
+ * \retval UniboCGR_ErrorSnapshotMismatch   The contact plan is not the snapshot's one: nothing restored
+ * \retval others                           See UniboCGR_contact_plan_add_contacts_bulk()
+ */
+extern UniboCGR_Error UniboCGR_snapshot_load(UniboCGR uniboCgr, const char* filename, uint32_t* restored_routes);
+
 
 
 /* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
@@ -357,6 +730,111 @@ extern UniboCGR_Error UniboCGR_routing(UniboCGR uniboCgr,
                                        UniboCGR_excluded_neighbors_list excludedNeighborsList,
                                        UniboCGR_route_list* routeList);
 
+/**
+ * \brief Called by UniboCGR_routing_group() one time for each bundle of the group
+ *        (and by UniboCGR_routing_batch() for each bundle of the batch).
+ *
+ * \param uniboCgr
+ * \param index      Index of the bundle in the array passed to UniboCGR_routing_group() (or UniboCGR_routing_batch()).
+ * \param error      Same meaning of the UniboCGR_routing() return value.
+ * \param routeList  List of best routes found by Unibo-CGR for the bundle.
+ *                   It is valid only until the callback returns.
+ * \param callback_arg The argument passed to UniboCGR_routing_group() (or UniboCGR_routing_batch()).
+ */
+typedef void (*UniboCGR_routing_group_callback)(UniboCGR uniboCgr,
+                                                uint32_t index,
+                                                UniboCGR_Error error,
+                                                UniboCGR_route_list routeList,
+                                                void* callback_arg);
+
+/**
+ * \brief Call Unibo-CGR Routing algorithm for a burst of bundles.
+ *
+ * \details The bundles with the same destination, previous node, priority, flags, delivery confidence
+ *          and a similar EVC as the first valid bundle share a single route search (phases one and two),
+ *          done with the greatest EVC and the earliest expiration time of those bundles.
+ *          Then, bundle by bundle in the order of the array, the PBAT of the routes found is computed
+ *          again for the bundle (residual volume included) and the volume of the best routes is reserved,
+ *          so when a route runs out of volume the following bundles are moved onto the next-best route.
+ *          The other bundles, and the bundles of the group left without a route, are routed afterwards
+ *          one by one, as by UniboCGR_routing(), in the order of the array.
+ *          The callback is called in this order, so not necessarily in the order of the array.
+ *
+ * \note The search shared by the group may find fewer routes than a UniboCGR_routing() call
+ *       for each bundle: a route viable only for a smaller EVC or a later deadline is not found.
+ *       The bundles of the group left without a route are routed by UniboCGR_routing().
+ *       The excluded neighbors list is not changed.
+ *
+ * \param uniboCgr
+ * \param[in] bundles       Array of bundles.
+ * \param[in] bundlesCount  Number of bundles in the array.
+ * \param[in] excludedNeighborsList List of neighbors that must not appear as "proximate nodes" in the best routes list
+ *                                  (shared by all the bundles).
+ * \param[in] callback      Called for each bundle with its best routes list.
+ * \param[in] callback_arg  Passed to callback.
+ */
+extern UniboCGR_Error UniboCGR_routing_group(UniboCGR uniboCgr,
+                                             UniboCGR_Bundle* bundles,
+                                             uint32_t bundlesCount,
+                                             UniboCGR_excluded_neighbors_list excludedNeighborsList,
+                                             UniboCGR_routing_group_callback callback,
+                                             void* callback_arg);
+
+/**
+ * \brief Call Unibo-CGR Routing algorithm for a batch of bundles to any destination
+ *        (e.g. the backlog queued for a link that just came up).
+ *
+ * \details The per-call housekeeping (contact plan updates, expired contacts and ranges,
+ *          old neighbors) is done only one time for the whole batch.
+ *          The bundles are then sorted by destination, excluded neighbors list, previous node,
+ *          priority, flags and delivery confidence, and each set of bundles is routed as by
+ *          UniboCGR_routing_group(), so the bundles to the same destination share a single route search.
+ *          The bundles to the same destination are routed in the order of the array;
+ *          the callback is called destination by destination, not in the order of the array.
+ *
+ * \param uniboCgr
+ * \param[in] bundles                Array of bundles.
+ * \param[in] excludedNeighborsLists Array of excluded neighbors lists, one for each bundle.
+ *                                   The same list can be passed for many bundles.
+ * \param[in] bundlesCount           Number of bundles (and of excluded neighbors lists).
+ * \param[in] callback               Called for each bundle with its index in the array and its best routes list.
+ * \param[in] callback_arg           Passed to callback.
+ */
+extern UniboCGR_Error UniboCGR_routing_batch(UniboCGR uniboCgr,
+                                             UniboCGR_Bundle* bundles,
+                                             UniboCGR_excluded_neighbors_list* excludedNeighborsLists,
+                                             uint32_t bundlesCount,
+                                             UniboCGR_routing_group_callback callback,
+                                             void* callback_arg);
+
+/**
+ * \brief Get the reservation of the contacts volume consumed by the last UniboCGR_routing() call
+ *        (or by the current bundle, inside a UniboCGR_routing_group() or UniboCGR_routing_batch() callback).
+ *
+ * \details Meaningful only if the volume reservations feature is enabled.
+ *          You must pass the reservation to UniboCGR_reservation_commit() when the bundle
+ *          has been transmitted, or to UniboCGR_reservation_release() when the forwarding
+ *          is canceled (e.g. bundle expired or rerouted), otherwise the reservation is kept forever.
+ *
+ * \return The reservation, 0 if no volume has been reserved.
+ */
+extern UniboCGR_Reservation UniboCGR_get_reservation(UniboCGR uniboCgr);
+
+/**
+ * \brief The bundle has been transmitted: the reserved volume remains consumed.
+ *
+ * \note You can call this function in any session.
+ */
+extern UniboCGR_Error UniboCGR_reservation_commit(UniboCGR uniboCgr, UniboCGR_Reservation reservation);
+
+/**
+ * \brief The forwarding has been canceled: the reserved volume goes back to the contacts MTVs.
+ *
+ * \note You can call this function in any session.
+ * \note The volume of contacts that no longer exist is discarded.
+ */
+extern UniboCGR_Error UniboCGR_reservation_release(UniboCGR uniboCgr, UniboCGR_Reservation reservation);
+
 // meaningful only during routing session and after UniboCGR_routing() call.
 extern UniboCGR_RoutingAlgorithm UniboCGR_get_used_routing_algorithm(UniboCGR uniboCgr);
 
@@ -372,9 +850,11 @@ extern UniboCGR_Error UniboCGR_routing_close(UniboCGR uniboCgr);
  * As other sessions, each Unibo-CGR feature is enabled/disabled in a per-instance basis
  * (e.g. different Unibo-CGR instances might have different features enabled).
  *
- * Routing-related feature might trigger a full reset of the internal computed routes
- * (e.g. Unibo-CGR's phase one might be performed again).
- * However, contact plan information about contact utilization
+ * Only the "one route per neighbor" feature triggers a full reset of the internal computed routes
+ * (e.g. Unibo-CGR's phase one might be performed again), since it drives the phase one routes search.
+ * The other features act on phase two/three, evaluated again at each routing call,
+ * so they can be toggled at runtime without losing the computed routes.
+ * In any case, contact plan information about contact utilization
  * (like contact MTVs) will not be discarded.
  *
  * Features:
@@ -408,11 +888,43 @@ extern UniboCGR_Error UniboCGR_routing_close(UniboCGR uniboCgr);
  *     Enable moderate source routing algorithm.
  *     More information here: TODO link
  *
+ * - volume reservations
+ *     Keep a ledger of the contacts volume consumed by each routing call, so that
+ *     the interface can give it back when the forwarding is canceled
+ *     (see UniboCGR_get_reservation()). This makes unnecessary to reload the
+ *     whole contact plan just to resync the contacts MTVs.
+ *     It does not trigger a reset of the computed routes.
+ *
+ * - route cache
+ *     Keep the best routes of the last routing call to each destination.
+ *     A following bundle to the same destination with the same priority, ordinal, flags,
+ *     delivery confidence, excluded neighbors and EVC order of magnitude gets the same
+ *     best routes without running the CGR phases, as long as the contact plan and the
+ *     features have not changed, no MTV has been increased, no route's contact is expired
+ *     and each route still has enough volume for the bundle.
+ *     The ETO and the PBAT of the routes are the ones computed for the first bundle.
+ *     Bundles with a geographic route, an MSR route or failed neighbors always miss.
+ *     The unreachable destinations are cached too: until the next contact start time
+ *     a bundle of the same class (with no later deadline and no smaller EVC)
+ *     gets UniboCGR_ErrorRouteNotFound without any graph search.
+ *     See UniboCGR_route_cache_get_counters().
+ *     It does not trigger a reset of the computed routes.
+ *
  * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
 
 extern UniboCGR_Error UniboCGR_feature_open(UniboCGR uniboCgr, time_t time);
 extern UniboCGR_Error UniboCGR_feature_close(UniboCGR uniboCgr);
 
+/**
+ * \brief Change the reference time (must not be greater than the current time).
+ *
+ * \details Internally all times are relative to a time base set by UniboCGR_open().
+ *          Usually the time base does not change, so this is a O(1) operation
+ *          and the computed routes (and the route cache) are kept.
+ *          Only if the current time is too far from the time base (about 34 years),
+ *          the time base is moved to the new reference time: every stored time is rewritten
+ *          and all the computed routes are discarded.
+ */
 extern UniboCGR_Error UniboCGR_feature_change_reference_time(UniboCGR uniboCgr, time_t new_reference_time);
 
 extern UniboCGR_Error UniboCGR_feature_logger_enable(UniboCGR uniboCgr, const char* log_dir);
@@ -441,6 +953,32 @@ extern UniboCGR_Error UniboCGR_feature_ReactiveAntiLoop_disable(UniboCGR uniboCg
 extern UniboCGR_Error UniboCGR_feature_ProactiveAntiLoop_enable(UniboCGR uniboCgr);
 extern UniboCGR_Error UniboCGR_feature_ProactiveAntiLoop_disable(UniboCGR uniboCgr);
 
+extern UniboCGR_Error UniboCGR_feature_VolumeReservations_enable(UniboCGR uniboCgr);
+extern UniboCGR_Error UniboCGR_feature_VolumeReservations_disable(UniboCGR uniboCgr);
+
+extern UniboCGR_Error UniboCGR_feature_RouteCache_enable(UniboCGR uniboCgr);
+extern UniboCGR_Error UniboCGR_feature_RouteCache_disable(UniboCGR uniboCgr);
+
+/**
+ * \brief Keep in the contacts graph only the contacts that start within a time horizon.
+ *
+ * \details The contacts that start at or after the current time plus the horizon are kept apart,
+ *          in an array sorted by start time, and are not visited by the routing calls
+ *          (graph searches, expired contacts removal). They are promoted to the graph as the time advances:
+ *          once every horizon, the graph is extended up to twice the horizon from the current time.
+ *          If a routing call finds no route and a contact kept apart reaches the destination before
+ *          the bundle expiration, the horizon grows up to the bundle expiration and the routing is repeated.
+ *
+ * \param[in] horizon  The horizon in seconds, greater than 0.
+ *
+ * \note  The contact plan sessions (and the shadow contact plan copy, the snapshot save) work on the whole
+ *        contact plan; out of them UniboCGR_get_first_contact() and UniboCGR_get_next_contact()
+ *        visit only the contacts within the horizon.
+ *        Only UniboCGR_routing() grows the horizon on demand.
+ */
+extern UniboCGR_Error UniboCGR_feature_ContactHorizon_enable(UniboCGR uniboCgr, time_t horizon);
+extern UniboCGR_Error UniboCGR_feature_ContactHorizon_disable(UniboCGR uniboCgr);
+
 /* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
  *                                                UTILITIES
  * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
@@ -451,7 +989,8 @@ extern UniboCGR_Error UniboCGR_feature_ProactiveAntiLoop_disable(UniboCGR uniboC
  * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
 
 /**
- * \brief Retrieve Unibo-CGR reference time. Same value that you passed into UniboCGR_open().
+ * \brief Retrieve Unibo-CGR reference time. Same value that you passed into UniboCGR_open()
+ *        or into the last UniboCGR_feature_change_reference_time().
  */
 extern time_t UniboCGR_get_reference_time(UniboCGR uniboCgr);
 
@@ -461,6 +1000,18 @@ extern bool UniboCGR_feature_QueueDelay_check(UniboCGR uniboCgr);
 extern bool UniboCGR_feature_ModerateSourceRouting_check(UniboCGR uniboCgr);
 extern bool UniboCGR_feature_ReactiveAntiLoop_check(UniboCGR uniboCgr);
 extern bool UniboCGR_feature_ProactiveAntiLoop_check(UniboCGR uniboCgr);
+extern bool UniboCGR_feature_VolumeReservations_check(UniboCGR uniboCgr);
+extern bool UniboCGR_feature_RouteCache_check(UniboCGR uniboCgr);
+extern bool UniboCGR_feature_ContactHorizon_check(UniboCGR uniboCgr, time_t* horizon);
+
+/**
+ * \brief Get the number of routing calls served by the route cache (hits)
+ *        and the number of the cacheable routing calls routed by the CGR (misses).
+ *
+ * \param[out] hits    Can be NULL.
+ * \param[out] misses  Can be NULL.
+ */
+extern UniboCGR_Error UniboCGR_route_cache_get_counters(UniboCGR uniboCgr, uint64_t* hits, uint64_t* misses);
 
 extern void UniboCGR_log_write(UniboCGR uniboCgr, const char* fmt, ...);
 extern void UniboCGR_log_flush(UniboCGR uniboCgr);
@@ -756,6 +1307,68 @@ extern uint32_t UniboCGR_route_list_get_length(UniboCGR_route_list list);
 extern UniboCGR_Error UniboCGR_get_first_route(UniboCGR uniboCgr, UniboCGR_route_list uniboCgrRouteList, UniboCGR_Route* uniboCgrRoute);
 extern UniboCGR_Error UniboCGR_get_next_route(UniboCGR uniboCgr, UniboCGR_Route* uniboCgrRoute);
 
+/**
+ * \brief A route of a route list, as written by UniboCGR_route_list_export().
+ *
+ * \details Same values of the UniboCGR_Route_get_*() functions (times are Unix times).
+ *          The hops of the route are hops[first_hop] ... hops[first_hop + hop_count - 1].
+ */
+typedef struct {
+    uint64_t neighbor;
+    time_t   best_case_transmission_time;
+    time_t   expiration_time;
+    time_t   best_case_arrival_time;
+    time_t   eto;
+    time_t   projected_bundle_arrival_time;
+    uint64_t total_one_way_light_time;
+    uint64_t overbooked;
+    uint64_t committed;
+    double   route_volume_limit;
+    float    arrival_confidence;
+    uint32_t first_hop;
+    uint32_t hop_count;
+} UniboCGR_FlatRoute;
+
+/**
+ * \brief A hop (contact) of a route, as written by UniboCGR_route_list_export().
+ *
+ * \details The contact key: use UniboCGR_find_contact() for the other fields.
+ */
+typedef struct {
+    uint64_t sender;
+    uint64_t receiver;
+    time_t   start_time;
+} UniboCGR_FlatHop;
+
+/**
+ * \brief Write all the routes of a route list, and their hops, into caller-provided arrays.
+ *
+ * \details Nothing is allocated: you can keep the arrays between routing calls and grow them
+ *          only when UniboCGR_ErrorBufferTooSmall is returned.
+ *          Since the internal route/hop iterators are not used, you can call this function
+ *          while iterating with UniboCGR_get_first_route()/UniboCGR_get_next_route().
+ *
+ * \param uniboCgr
+ * \param[in]  uniboCgrRouteList  The route list returned by UniboCGR_routing() (can be NULL: 0 routes).
+ * \param[out] routes             Array of routes, in the same order of the route list.
+ * \param[in]  routesCapacity     Number of elements of routes.
+ * \param[out] hops               Array of hops. Can be NULL if you do not need the hops.
+ * \param[in]  hopsCapacity       Number of elements of hops (ignored if hops is NULL).
+ * \param[out] routesCount        Number of routes of the list.
+ * \param[out] hopsCount          Number of hops of all the routes of the list. Can be NULL.
+ *
+ * \return UniboCGR_ErrorBufferTooSmall if routesCount > routesCapacity or hopsCount > hopsCapacity;
+ *         the arrays are partially written, routesCount and hopsCount are the sizes required.
+ */
+extern UniboCGR_Error UniboCGR_route_list_export(UniboCGR uniboCgr,
+                                                 UniboCGR_route_list uniboCgrRouteList,
+                                                 UniboCGR_FlatRoute* routes,
+                                                 uint32_t routesCapacity,
+                                                 UniboCGR_FlatHop* hops,
+                                                 uint32_t hopsCapacity,
+                                                 uint32_t* routesCount,
+                                                 uint32_t* hopsCount);
+
 #ifdef __cplusplus
 }
 #endif
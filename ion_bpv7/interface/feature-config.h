@@ -95,6 +95,11 @@ extern "C" {
 #define UNIBO_CGR_FEATURE_MSR_TIME_TOLERANCE 2
 #endif
 
+/* Enable/disable Volume Reservations (the volume of a route is given back if the bundle is not forwarded). */
+#ifndef UNIBO_CGR_FEATURE_VOLUME_RESERVATIONS
+#define UNIBO_CGR_FEATURE_VOLUME_RESERVATIONS 1
+#endif
+
 /* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
 
 /* neighbor limit must be 1 when one route per neighbor is disabled. */
@@ -89,6 +89,18 @@
 
 #define NOMINAL_PRIMARY_BLKSIZE	29 // from ION 4.0.0: bpv7/library/libbpP.c
 
+/**
+ * \brief A copy of a contact plan, as flat contacts and ranges sorted by key.
+ */
+typedef struct {
+    UniboCGR_FlatContact* contacts;
+    uint32_t contactsCount;
+    uint32_t contactsCapacity;
+    UniboCGR_FlatRange* ranges;
+    uint32_t rangesCount;
+    uint32_t rangesCapacity;
+} ION_UniboCGR_PlanBuffer;
+
 /**
  * \brief Unibo-CGR instance wrapper. Keep also information about the processed bundle.
  */
@@ -109,14 +121,6 @@ typedef struct {
 	 * \brief Excluded neighbors for the current bundle.
 	 */
     UniboCGR_excluded_neighbors_list uniboCgrExcludedNeighbors;
-    /**
-     * \brief Unibo-CGR Contact instance.
-     */
-    UniboCGR_Contact uniboCgrContact;
-    /**
-     * \brief Unibo-CGR Range instance.
-     */
-    UniboCGR_Range uniboCgrRange;
     /**
      * \brief Region number.
      *
@@ -131,6 +135,22 @@ typedef struct {
      * \note Just an optimization to keep always a route in the "routes" list
      */
     bool first_route;
+    /**
+     * \brief Routes of the latest routing call (see UniboCGR_route_list_export()).
+     */
+    UniboCGR_FlatRoute* flatRoutes;
+    uint32_t flatRoutesCapacity;
+    /**
+     * \brief Hops of the latest routing call (see UniboCGR_route_list_export()).
+     */
+    UniboCGR_FlatHop* flatHops;
+    uint32_t flatHopsCapacity;
+    /**
+     * \brief Delta between the Unibo-CGR contact plan (oldPlan) and the ION one (newPlan).
+     */
+    UniboCGR_ContactPlanDelta delta;
+    ION_UniboCGR_PlanBuffer oldPlan;
+    ION_UniboCGR_PlanBuffer newPlan;
 
 } ION_UniboCGR;
 
@@ -144,6 +164,46 @@ typedef struct {
 } ION_UniboCGR_SAP;
 
 static void ION_UniboCGR_destroy(ION_UniboCGR* instance);
+
+/*
+ * Append a contact (range) to a sync buffer, growing it (twice) when full.
+ */
+static int push_plan_contact(ION_UniboCGR_PlanBuffer* buffer, const UniboCGR_FlatContact* contact) {
+    if (buffer->contactsCount == buffer->contactsCapacity) {
+        uint32_t capacity = (buffer->contactsCapacity == 0) ? 256 : 2 * buffer->contactsCapacity;
+        UniboCGR_FlatContact* contacts = MTAKE(capacity * sizeof(UniboCGR_FlatContact));
+        if (!contacts) return -1;
+        if (buffer->contacts) {
+            memcpy(contacts, buffer->contacts, buffer->contactsCount * sizeof(UniboCGR_FlatContact));
+            MRELEASE(buffer->contacts);
+        }
+        buffer->contacts = contacts;
+        buffer->contactsCapacity = capacity;
+    }
+    buffer->contacts[buffer->contactsCount++] = *contact;
+    return 0;
+}
+static int push_plan_range(ION_UniboCGR_PlanBuffer* buffer, const UniboCGR_FlatRange* range) {
+    if (buffer->rangesCount == buffer->rangesCapacity) {
+        uint32_t capacity = (buffer->rangesCapacity == 0) ? 256 : 2 * buffer->rangesCapacity;
+        UniboCGR_FlatRange* ranges = MTAKE(capacity * sizeof(UniboCGR_FlatRange));
+        if (!ranges) return -1;
+        if (buffer->ranges) {
+            memcpy(ranges, buffer->ranges, buffer->rangesCount * sizeof(UniboCGR_FlatRange));
+            MRELEASE(buffer->ranges);
+        }
+        buffer->ranges = ranges;
+        buffer->rangesCapacity = capacity;
+    }
+    buffer->ranges[buffer->rangesCount++] = *range;
+    return 0;
+}
+static void release_plan_buffer(ION_UniboCGR_PlanBuffer* buffer) {
+    if (buffer->contacts) MRELEASE(buffer->contacts);
+    if (buffer->ranges) MRELEASE(buffer->ranges);
+    memset(buffer, 0, sizeof(ION_UniboCGR_PlanBuffer));
+}
+
 static void destroyRouteElt(LystElt elt, void *arg);
 
 static uint64_t convert_scalar_to_uint64(Scalar* scalar) {
@@ -312,14 +372,9 @@ static ION_UniboCGR* ION_UniboCGR_create(uint64_t local_node, time_t reference_t
         putErrmsg("Can't create ION_UniboCGR object.", NULL);
         return NULL;
     }
+    memset(instance, 0, sizeof(ION_UniboCGR));
     UniboCGR_Error uniboCgrError;
-    uniboCgrError = UniboCGR_Contact_create(&instance->uniboCgrContact);
-    if (UniboCGR_check_error(uniboCgrError)) {
-        putErrmsg(UniboCGR_get_error_string(uniboCgrError), NULL);
-        ION_UniboCGR_destroy(instance);
-        return NULL;
-    }
-    uniboCgrError = UniboCGR_Range_create(&instance->uniboCgrRange);
+    uniboCgrError = UniboCGR_ContactPlanDelta_create(&instance->delta);
     if (UniboCGR_check_error(uniboCgrError)) {
         putErrmsg(UniboCGR_get_error_string(uniboCgrError), NULL);
         ION_UniboCGR_destroy(instance);
@@ -360,6 +415,11 @@ static ION_UniboCGR* ION_UniboCGR_create(uint64_t local_node, time_t reference_t
     }
 
     instance->first_route = true;
+
+    instance->flatRoutes = NULL;
+    instance->flatRoutesCapacity = 0;
+    instance->flatHops = NULL;
+    instance->flatHopsCapacity = 0;
     
     uniboCgrError = UniboCGR_open(&instance->uniboCgr,
                                   current_time,
@@ -380,12 +440,15 @@ static ION_UniboCGR* ION_UniboCGR_create(uint64_t local_node, time_t reference_t
 static void ION_UniboCGR_destroy(ION_UniboCGR* instance) {
     if (!instance) return;
     UniboCGR_close(&instance->uniboCgr, getCtime());
-    UniboCGR_Contact_destroy(&instance->uniboCgrContact);
-    UniboCGR_Range_destroy(&instance->uniboCgrRange);
+    UniboCGR_ContactPlanDelta_destroy(&instance->delta);
     UniboCGR_Bundle_destroy(&instance->uniboCgrBundle);
     UniboCGR_destroy_excluded_neighbors_list(&instance->uniboCgrExcludedNeighbors);
     lyst_delete_set(instance->routes, destroyRouteElt, NULL);
     lyst_destroy(instance->routes);
+    if (instance->flatRoutes) MRELEASE(instance->flatRoutes);
+    if (instance->flatHops) MRELEASE(instance->flatHops);
+    release_plan_buffer(&instance->oldPlan);
+    release_plan_buffer(&instance->newPlan);
     MRELEASE(instance);
 }
 
@@ -482,43 +545,6 @@ static void printDebugIonRoute(PsmPartition ionwm, CgrRoute *route)
 #define printDebugIonRoute(ionwm, route) do {  } while(0)
 #endif
 
-/******************************************************************************
- *
- * \par Function Name:
- *      convert_CtScheduled_from_ion_to_cgr
- *
- * \brief  Convert a Scheduled contact from ION to this CGR's implementation
- *
- *
- * \par Date Written:
- *      19/02/20
- *
- * \return int
- *
- * \retval  0   Success case
- *
- * \param[in]    ionContact
- * \param[out]   CgrContact
- *
- *
- * \par Revision History:
- *
- *  DD/MM/YY |  AUTHOR         |   DESCRIPTION
- *  -------- | --------------- | -----------------------------------------------
- *  19/02/20 | L. Persampieri  |  Initial Implementation and documentation.
- *****************************************************************************/
-static int convert_CtScheduled_from_ion_to_cgr(ION_UniboCGR* instance, IonCXref *ionContact, UniboCGR_Contact cgrContact)
-{
-    UniboCGR_Contact_set_sender(cgrContact, ionContact->fromNode);
-    UniboCGR_Contact_set_receiver(cgrContact, ionContact->toNode);
-    UniboCGR_Contact_set_start_time(instance->uniboCgr, cgrContact, ionContact->fromTime);
-    UniboCGR_Contact_set_end_time(instance->uniboCgr, cgrContact, ionContact->toTime);
-    UniboCGR_Contact_set_type(cgrContact, UniboCGR_ContactType_Scheduled);
-    UniboCGR_Contact_set_xmit_rate(cgrContact, ionContact->xmitRate);
-    UniboCGR_Contact_set_confidence(cgrContact, ionContact->confidence);
-    return 0;
-}
-
 /******************************************************************************
  *
  * \par Function Name:
@@ -562,43 +588,6 @@ static int convert_CtScheduled_from_cgr_to_ion(ION_UniboCGR* instance, UniboCGR_
 	return 0;
 }
 
-/******************************************************************************
- *
- * \par Function Name:
- *      convert_contact_from_ion_to_cgr
- *
- * \brief Convert a contact from ION to this CGR's implementation
- *
- *
- * \par Date Written:
- *      19/02/20
- *
- * \return int
- *
- * \retval   0  Success case
- * \retval  -2  Unknown contact's type
- *
- * \param[in]   ionContact
- * \param[out]  CgrContact
- *
- * \par	Notes:
- *             1.  Only Scheduled contacts are allowed.
- *
- * \par Revision History:
- *
- *  DD/MM/YY |  AUTHOR         |   DESCRIPTION
- *  -------- | --------------- | -----------------------------------------------
- *  19/02/20 | L. Persampieri  |  Initial Implementation and documentation.
- *****************************************************************************/
-static int convert_contact_from_ion_to_cgr(ION_UniboCGR* instance, IonCXref *ionContact, UniboCGR_Contact cgrContact)
-{
-    if (ionContact->type == CtScheduled) {
-        return convert_CtScheduled_from_ion_to_cgr(instance, ionContact, cgrContact);
-    }
-
-    return -2;
-}
-
 /******************************************************************************
  *
  * \par Function Name:
@@ -634,41 +623,6 @@ static int convert_contact_from_cgr_to_ion(ION_UniboCGR* instance, UniboCGR_Cont
     return -2;
 }
 
-/******************************************************************************
- *
- * \par Function Name:
- *      convert_range_from_ion_to_cgr
- *
- * \brief  Convert a range from ION to this CGR's implementation
- *
- *
- * \par Date Written:
- *      19/02/20
- *
- * \return int
- *
- * \retval   0   Success case
- *
- * \param[in]    IonRange
- * \param[out]   uniboCgrRange
- *
- *
- * \par Revision History:
- *
- *  DD/MM/YY |  AUTHOR         |   DESCRIPTION
- *  -------- | --------------- | -----------------------------------------------
- *  19/02/20 | L. Persampieri  |  Initial Implementation and documentation.
- *****************************************************************************/
-static int convert_range_from_ion_to_cgr(ION_UniboCGR* instance, IonRXref *IonRange, UniboCGR_Range uniboCgrRange)
-{
-    UniboCGR_Range_set_sender(uniboCgrRange, IonRange->fromNode);
-    UniboCGR_Range_set_receiver(uniboCgrRange, IonRange->toNode);
-    UniboCGR_Range_set_start_time(instance->uniboCgr, uniboCgrRange, IonRange->fromTime);
-    UniboCGR_Range_set_end_time(instance->uniboCgr, uniboCgrRange, IonRange->toTime);
-    UniboCGR_Range_set_one_way_light_time(uniboCgrRange, IonRange->owlt);
-    return 0;
-}
-
 /******************************************************************************
  *
  * \par Function Name:
@@ -1412,6 +1366,73 @@ static void resetIonRoutes(ION_UniboCGR* instance, PsmPartition ionwm) {
     instance->first_route = true;
 }
 
+/******************************************************************************
+ *
+ * \par Function Name:
+ *      export_routes_from_cgr
+ *
+ * \brief Write the routes (and hops) of a list of routes in CGR's format
+ *        into the flat buffers of the instance
+ *
+ *
+ * \par Date Written:
+ *      18/10/26
+ *
+ * \return int
+ *
+ * \retval   0  Success case
+ * \retval  -1  Fatal error
+ *
+ * \param[in]     instance
+ * \param[in]     uniboCgrRouteList
+ * \param[out]    routesCount         The number of routes in instance->flatRoutes
+ *
+ * \par Notes:
+ *          1.  The buffers are grown only when they are too small,
+ *              so in the usual case nothing is allocated.
+ *
+ *
+ * \par Revision History:
+ *
+ *  DD/MM/YY |  AUTHOR         |   DESCRIPTION
+ *  -------- | --------------- | -----------------------------------------------
+ *  18/10/26 | L. Persampieri  |  Initial Implementation and documentation.
+ *****************************************************************************/
+static int export_routes_from_cgr(ION_UniboCGR* instance, UniboCGR_route_list uniboCgrRouteList, uint32_t* routesCount) {
+    uint32_t hopsCount = 0;
+    UniboCGR_Error error = UniboCGR_route_list_export(instance->uniboCgr, uniboCgrRouteList,
+                                                      instance->flatRoutes, instance->flatRoutesCapacity,
+                                                      instance->flatHops, instance->flatHopsCapacity,
+                                                      routesCount, &hopsCount);
+    if (error != UniboCGR_ErrorBufferTooSmall) {
+        return UniboCGR_check_error(error) ? -1 : 0;
+    }
+
+    // grow the buffers (twice the required size) and try again
+    if (*routesCount > instance->flatRoutesCapacity) {
+        if (instance->flatRoutes) MRELEASE(instance->flatRoutes);
+        instance->flatRoutesCapacity = 2 * *routesCount;
+        instance->flatRoutes = MTAKE(instance->flatRoutesCapacity * sizeof(UniboCGR_FlatRoute));
+    }
+    if (hopsCount > instance->flatHopsCapacity) {
+        if (instance->flatHops) MRELEASE(instance->flatHops);
+        instance->flatHopsCapacity = 2 * hopsCount;
+        instance->flatHops = MTAKE(instance->flatHopsCapacity * sizeof(UniboCGR_FlatHop));
+    }
+    if (!instance->flatRoutes || !instance->flatHops) {
+        instance->flatRoutesCapacity = instance->flatRoutes ? instance->flatRoutesCapacity : 0;
+        instance->flatHopsCapacity = instance->flatHops ? instance->flatHopsCapacity : 0;
+        return -1;
+    }
+
+    error = UniboCGR_route_list_export(instance->uniboCgr, uniboCgrRouteList,
+                                       instance->flatRoutes, instance->flatRoutesCapacity,
+                                       instance->flatHops, instance->flatHopsCapacity,
+                                       routesCount, &hopsCount);
+
+    return UniboCGR_check_error(error) ? -1 : 0;
+}
+
 /******************************************************************************
  *
  * \par Function Name:
@@ -1426,14 +1447,12 @@ static void resetIonRoutes(ION_UniboCGR* instance, PsmPartition ionwm) {
  * \return int 
  *
  * \retval   0  All routes converted
- * \retval  -1  CGR's contact points to NULL
- * \retval  -2  Memory allocation error
+ * \retval  -1  Fatal error
  *
  * \param[in]     instance
  * \param[in]     ionwm
  * \param[in]     ionvdb
- * \param[in]     terminusNode   ION destination
- * \param[in]     uniboCgrRoutest
+ * \param[in]     uniboCgrRouteList
  * \param[out]    IonRoutes
  *
  *
@@ -1442,46 +1461,49 @@ static void resetIonRoutes(ION_UniboCGR* instance, PsmPartition ionwm) {
  *  DD/MM/YY |  AUTHOR         |   DESCRIPTION
  *  -------- | --------------- | -----------------------------------------------
  *  19/02/20 | L. Persampieri  |  Initial Implementation and documentation.
+ *  18/10/26 | L. Persampieri  |  Read the routes from the flat buffers.
  *****************************************************************************/
 static int convert_routes_from_cgr_to_ion(ION_UniboCGR* instance, PsmPartition ionwm, IonVdb *ionvdb,
                                           UniboCGR_route_list uniboCgrRouteList, Lyst IonRoutes) {
-    UniboCGR_Route uniboCgrRoute = NULL;
-    UniboCGR_Error okRoute = UniboCGR_get_first_route(instance->uniboCgr, uniboCgrRouteList, &uniboCgrRoute);
-    for (/* empty */; okRoute == UniboCGR_NoError; okRoute = UniboCGR_get_next_route(instance->uniboCgr, &uniboCgrRoute)) {
+    uint32_t routesCount = 0;
+    if (export_routes_from_cgr(instance, uniboCgrRouteList, &routesCount) < 0) {
+        return -1;
+    }
+    const uint64_t bundleECCC = UniboCGR_Bundle_get_estimated_volume_consumption(instance->uniboCgrBundle);
+
+    for (uint32_t i = 0; i < routesCount; i++) {
+        const UniboCGR_FlatRoute* flatRoute = &instance->flatRoutes[i];
         CgrRoute* IonRoute = getIonRoute(instance, ionwm);
         if (!IonRoute) {
             // fatal error
             return -1;
         }
 
-        IonRoute->toNodeNbr = UniboCGR_Route_get_neighbor(uniboCgrRoute);
-        IonRoute->fromTime = UniboCGR_Route_get_best_case_transmission_time(instance->uniboCgr, uniboCgrRoute);
-        IonRoute->toTime = UniboCGR_Route_get_expiration_time(instance->uniboCgr, uniboCgrRoute);
-        IonRoute->arrivalTime = UniboCGR_Route_get_best_case_arrival_time(instance->uniboCgr, uniboCgrRoute);
-        IonRoute->maxVolumeAvbl = UniboCGR_Route_get_route_volume_limit(uniboCgrRoute);
-        IonRoute->bundleECCC = UniboCGR_Bundle_get_estimated_volume_consumption(instance->uniboCgrBundle);
-        IonRoute->eto = UniboCGR_Route_get_eto(instance->uniboCgr, uniboCgrRoute);
-        IonRoute->pbat = UniboCGR_Route_get_projected_bundle_arrival_time(instance->uniboCgr, uniboCgrRoute);
-        IonRoute->arrivalConfidence = UniboCGR_Route_get_arrival_confidence(uniboCgrRoute);
-        uint64_t overbooked = 0;
-        uint64_t committed = 0;
-        UniboCGR_Route_get_overbooking_management(uniboCgrRoute, &overbooked, &committed);
-        convert_uint64_to_scalar(overbooked, &IonRoute->overbooked);
-        convert_uint64_to_scalar(committed, &IonRoute->committed);
+        IonRoute->toNodeNbr = flatRoute->neighbor;
+        IonRoute->fromTime = flatRoute->best_case_transmission_time;
+        IonRoute->toTime = flatRoute->expiration_time;
+        IonRoute->arrivalTime = flatRoute->best_case_arrival_time;
+        IonRoute->maxVolumeAvbl = flatRoute->route_volume_limit;
+        IonRoute->bundleECCC = bundleECCC;
+        IonRoute->eto = flatRoute->eto;
+        IonRoute->pbat = flatRoute->projected_bundle_arrival_time;
+        IonRoute->arrivalConfidence = flatRoute->arrival_confidence;
+        convert_uint64_to_scalar(flatRoute->overbooked, &IonRoute->overbooked);
+        convert_uint64_to_scalar(flatRoute->committed, &IonRoute->committed);
 
         // now create hop list
 
-        UniboCGR_Contact uniboCgrContact = NULL;
-        UniboCGR_Error okContact = UniboCGR_get_first_hop(instance->uniboCgr, uniboCgrRoute, &uniboCgrContact);
         bool skipRoute = false;
-        for (/* empty */; okContact == UniboCGR_NoError; okContact = UniboCGR_get_next_hop(instance->uniboCgr, &uniboCgrContact)) {
+        for (uint32_t h = flatRoute->first_hop; h < flatRoute->first_hop + flatRoute->hop_count; h++) {
+            const UniboCGR_FlatHop* flatHop = &instance->flatHops[h];
             IonCXref ionContactLocal;
-            if (convert_contact_from_cgr_to_ion(instance, uniboCgrContact, &ionContactLocal) < 0) {
-                // that sounds like a "core" bug -- should never happen
-                setIonRouteNotUsed(instance, IonRoute, ionwm);
-                skipRoute = true;
-                break;
-            }
+            memset(&ionContactLocal, 0, sizeof(IonCXref));
+            ionContactLocal.regionNbr = instance->regionNbr;
+            ionContactLocal.fromNode = flatHop->sender;
+            ionContactLocal.toNode = flatHop->receiver;
+            ionContactLocal.fromTime = flatHop->start_time;
+            ionContactLocal.type = CtScheduled;
+
             PsmAddress ionContactTreeNode = sm_rbt_search(ionwm, ionvdb->contactIndex, rfx_order_contacts, &ionContactLocal, 0);
 
             if (!ionContactTreeNode) {
@@ -1505,10 +1527,6 @@ static int convert_routes_from_cgr_to_ion(ION_UniboCGR* instance, PsmPartition i
             }
         }
 
-        if (UniboCGR_check_fatal_error(okContact)) {
-            return -1;
-        }
-
         if (skipRoute) {
             continue;
         }
@@ -1526,71 +1544,137 @@ static int convert_routes_from_cgr_to_ion(ION_UniboCGR* instance, PsmPartition i
         }
     }
 
-    if (UniboCGR_check_fatal_error(okRoute)) {
-        return -1;
-    }
-
     return 0;
 }
 
-/**
- * \param instance
- * \param current_time
- * \param ionwm
- * \param ionvdb
+/******************************************************************************
+ *
+ * \par Function Name:
+ *      get_unibocgr_contact_plan
+ *
+ * \brief  Copy the Unibo-CGR contact plan into instance->oldPlan.
+ *
+ *
+ * \par Date Written:
+ *      18/10/26
+ *
  * \return int
- * \retval  0    success
- * \retval "< 0" fatal error
- */
-static int update_region_contact_plan(ION_UniboCGR* instance, time_t current_time, PsmPartition ionwm, IonVdb *ionvdb) {
-    UniboCGR_Error error = UniboCGR_contact_plan_open(instance->uniboCgr, current_time);
-
-    if (UniboCGR_check_error(error)) {
-        putErrmsg(UniboCGR_get_error_string(error), NULL);
-        return -1;
+ *
+ * \retval   0  Success case
+ * \retval  -1  MTAKE error
+ *
+ * \param[in]   instance
+ *
+ * \par Notes:
+ *          1.  The contacts (ranges) are copied in the Unibo-CGR order,
+ *              already sorted as UniboCGR_ContactPlanDelta_diff_contacts() wants.
+ *
+ * \par Revision History:
+ *
+ *  DD/MM/YY |  AUTHOR         |   DESCRIPTION
+ *  -------- | --------------- | -----------------------------------------------
+ *  18/10/26 | L. Persampieri  |  Initial Implementation and documentation.
+ *****************************************************************************/
+static int get_unibocgr_contact_plan(ION_UniboCGR* instance) {
+    ION_UniboCGR_PlanBuffer* plan = &instance->oldPlan;
+    plan->contactsCount = 0;
+    plan->rangesCount = 0;
+
+    UniboCGR_Contact uniboCgrContact = NULL;
+    UniboCGR_Error ok;
+    for (ok = UniboCGR_get_first_contact(instance->uniboCgr, &uniboCgrContact);
+         ok == UniboCGR_NoError;
+         ok = UniboCGR_get_next_contact(instance->uniboCgr, &uniboCgrContact)) {
+        UniboCGR_FlatContact contact;
+        memset(&contact, 0, sizeof(UniboCGR_FlatContact));
+        contact.sender = UniboCGR_Contact_get_sender(uniboCgrContact);
+        contact.receiver = UniboCGR_Contact_get_receiver(uniboCgrContact);
+        contact.start_time = UniboCGR_Contact_get_start_time(instance->uniboCgr, uniboCgrContact);
+        contact.end_time = UniboCGR_Contact_get_end_time(instance->uniboCgr, uniboCgrContact);
+        contact.xmit_rate = UniboCGR_Contact_get_xmit_rate(uniboCgrContact);
+        contact.confidence = UniboCGR_Contact_get_confidence(uniboCgrContact);
+        if (push_plan_contact(plan, &contact) < 0) return -1;
+    }
+
+    UniboCGR_Range uniboCgrRange = NULL;
+    for (ok = UniboCGR_get_first_range(instance->uniboCgr, &uniboCgrRange);
+         ok == UniboCGR_NoError;
+         ok = UniboCGR_get_next_range(instance->uniboCgr, &uniboCgrRange)) {
+        UniboCGR_FlatRange range;
+        range.sender = UniboCGR_Range_get_sender(uniboCgrRange);
+        range.receiver = UniboCGR_Range_get_receiver(uniboCgrRange);
+        range.start_time = UniboCGR_Range_get_start_time(instance->uniboCgr, uniboCgrRange);
+        range.end_time = UniboCGR_Range_get_end_time(instance->uniboCgr, uniboCgrRange);
+        range.one_way_light_time = UniboCGR_Range_get_one_way_light_time(uniboCgrRange);
+        if (push_plan_range(plan, &range) < 0) return -1;
     }
 
-    // destroy previous contact plan -- then reload the whole contact plan from ION VDB
+    return 0;
+}
 
-    // note: we can do this only because ION stores MTVs into SDR (and we load MTV from SDR).
-    //       You are allowed to reset the contact plan before each update
-    //       only if you set to true the "copy MTV" flag when you call UniboCGR_contact_plan_add_contact().
-    UniboCGR_contact_plan_reset(instance->uniboCgr);
+/******************************************************************************
+ *
+ * \par Function Name:
+ *      get_ion_contact_plan
+ *
+ * \brief  Copy the ION contact plan (Scheduled contacts only, with the MTVs
+ *         stored into SDR) into instance->newPlan, sorted and without duplicated keys.
+ *
+ *
+ * \par Date Written:
+ *      18/10/26
+ *
+ * \return int
+ *
+ * \retval   0  Success case
+ * \retval  -1  MTAKE error
+ *
+ * \param[in]   instance
+ * \param[in]   ionwm
+ * \param[in]   *ionvdb
+ *
+ * \par Notes:
+ *          1.  Only the ranges between nodes with a contact are copied.
+ *
+ * \par Revision History:
+ *
+ *  DD/MM/YY |  AUTHOR         |   DESCRIPTION
+ *  -------- | --------------- | -----------------------------------------------
+ *  18/10/26 | L. Persampieri  |  Initial Implementation and documentation.
+ *****************************************************************************/
+static int get_ion_contact_plan(ION_UniboCGR* instance, PsmPartition ionwm, IonVdb *ionvdb) {
+    ION_UniboCGR_PlanBuffer* plan = &instance->newPlan;
+    plan->contactsCount = 0;
+    plan->rangesCount = 0;
 
+    Sdr sdr = getIonsdr();
     PsmAddress contactNodeAddr;
     uvast prevFromNode = 0;
     uvast prevToNode = 0;
     for (contactNodeAddr = sm_rbt_first(ionwm, ionvdb->contactIndex); contactNodeAddr; contactNodeAddr = sm_rbt_next(ionwm, contactNodeAddr)) {
         IonCXref* ionContact = convert_PsmAddress_to_IonCXref(ionwm, sm_rbt_data(ionwm, contactNodeAddr));
-        if (convert_contact_from_ion_to_cgr(instance, ionContact, instance->uniboCgrContact) < 0) {
+        if (ionContact->type != CtScheduled) {
             // unknown type
             continue;
         }
 
-        Sdr sdr = getIonsdr();
         IonContact contactBuf;
         Object contactObj = sdr_list_data(sdr, ionContact->contactElt);
         sdr_read(sdr, (char *) &contactBuf, contactObj, sizeof(IonContact));
-        UniboCGR_Contact_set_mtv_bulk(instance->uniboCgrContact, contactBuf.mtv[0]);
-        UniboCGR_Contact_set_mtv_normal(instance->uniboCgrContact, contactBuf.mtv[1]);
-        UniboCGR_Contact_set_mtv_expedited(instance->uniboCgrContact, contactBuf.mtv[2]);
-
-        UniboCGR_Error uniboCgrContactError;
-        uniboCgrContactError = UniboCGR_contact_plan_add_contact(instance->uniboCgr, instance->uniboCgrContact, true);
-        if (UniboCGR_check_error(uniboCgrContactError)) {
-            if (UniboCGR_check_fatal_error(uniboCgrContactError)) {
-                // some bad error occurred -- need to close contact plan session and return a negative value
-                putErrmsg(UniboCGR_get_error_string(uniboCgrContactError), NULL);
-                UniboCGR_contact_plan_close(instance->uniboCgr);
-                return -1;
-            }
-            // skip this contact
-            continue;
-        }
-
-        // ok contact added
 
-        // check if we already inserted ranges from sender to receiver
+        UniboCGR_FlatContact contact;
+        contact.sender = ionContact->fromNode;
+        contact.receiver = ionContact->toNode;
+        contact.start_time = ionContact->fromTime;
+        contact.end_time = ionContact->toTime;
+        contact.xmit_rate = ionContact->xmitRate;
+        contact.confidence = ionContact->confidence;
+        contact.mtv[0] = contactBuf.mtv[0];
+        contact.mtv[1] = contactBuf.mtv[1];
+        contact.mtv[2] = contactBuf.mtv[2];
+        if (push_plan_contact(plan, &contact) < 0) return -1;
+
+        // check if we already copied ranges from sender to receiver
         // we can perform this check since ION contacts are ordered by node number
         if (prevFromNode == ionContact->fromNode && prevToNode == ionContact->toNode) continue;
 
@@ -1598,7 +1682,7 @@ static int update_region_contact_plan(ION_UniboCGR* instance, time_t current_tim
         prevFromNode = ionContact->fromNode;
         prevToNode = ionContact->toNode;
 
-        // now insert all ranges from sender to receiver
+        // now copy all ranges from sender to receiver
 
         PsmAddress rangeNodeAddr;
         IonRXref IonRangeLocal;
@@ -1613,22 +1697,99 @@ static int update_region_contact_plan(ION_UniboCGR* instance, time_t current_tim
             if (IonRange->fromNode != IonRangeLocal.fromNode) break; // processed all ranges between sender and receiver
             if (IonRange->toNode != IonRangeLocal.toNode)     break; // processed all ranges between sender and receiver
 
-            convert_range_from_ion_to_cgr(instance, IonRange, instance->uniboCgrRange);
-            UniboCGR_Error uniboCgrRangeError;
-            uniboCgrRangeError = UniboCGR_contact_plan_add_range(instance->uniboCgr, instance->uniboCgrRange);
-            if (UniboCGR_check_error(uniboCgrRangeError)) {
-                if (UniboCGR_check_fatal_error(uniboCgrRangeError)) {
-                    // some bad error occurred -- need to close contact plan session and return a negative value
-                    putErrmsg(UniboCGR_get_error_string(uniboCgrRangeError), NULL);
-                    UniboCGR_contact_plan_close(instance->uniboCgr);
-                    return -1;
-                }
-                // skip this range
-                continue;
-            }
-            // ok range added
+            UniboCGR_FlatRange range;
+            range.sender = IonRange->fromNode;
+            range.receiver = IonRange->toNode;
+            range.start_time = IonRange->fromTime;
+            range.end_time = IonRange->toTime;
+            range.one_way_light_time = IonRange->owlt;
+            if (push_plan_range(plan, &range) < 0) return -1;
+        }
+    }
+
+    UniboCGR_ContactPlanDelta_sort_contacts(plan->contacts, plan->contactsCount);
+    UniboCGR_ContactPlanDelta_sort_ranges(plan->ranges, plan->rangesCount);
+
+    // the diff wants unique keys and the plan does not allow overlapping contacts (ranges):
+    // keep the first one, as the previous contact-by-contact insertion did
+    uint32_t i, count = 0;
+    for (i = 0; i < plan->contactsCount; i++) {
+        const UniboCGR_FlatContact* contact = &plan->contacts[i];
+        if (count > 0
+            && plan->contacts[count - 1].sender == contact->sender
+            && plan->contacts[count - 1].receiver == contact->receiver
+            && contact->start_time < plan->contacts[count - 1].end_time) {
+            continue;
+        }
+        plan->contacts[count++] = *contact;
+    }
+    plan->contactsCount = count;
+    count = 0;
+    for (i = 0; i < plan->rangesCount; i++) {
+        const UniboCGR_FlatRange* range = &plan->ranges[i];
+        if (count > 0
+            && plan->ranges[count - 1].sender == range->sender
+            && plan->ranges[count - 1].receiver == range->receiver
+            && range->start_time < plan->ranges[count - 1].end_time) {
+            continue;
+        }
+        plan->ranges[count++] = *range;
+    }
+    plan->rangesCount = count;
+
+    return 0;
+}
+
+/**
+ * \brief Apply to the Unibo-CGR contact plan the delta from the ION contact plan:
+ *        the contacts and ranges not changed are kept (with their MTVs), the routes
+ *        are invalidated once.
+ *
+ * \param instance
+ * \param current_time
+ * \param ionwm
+ * \param ionvdb
+ * \return int
+ * \retval  0    success
+ * \retval "< 0" fatal error
+ */
+static int update_region_contact_plan(ION_UniboCGR* instance, time_t current_time, PsmPartition ionwm, IonVdb *ionvdb) {
+    UniboCGR_Error error = UniboCGR_contact_plan_open(instance->uniboCgr, current_time);
+
+    if (UniboCGR_check_error(error)) {
+        putErrmsg(UniboCGR_get_error_string(error), NULL);
+        return -1;
+    }
+
+    if (get_unibocgr_contact_plan(instance) < 0 || get_ion_contact_plan(instance, ionwm, ionvdb) < 0) {
+        putErrmsg("Can't copy the contact plan.", NULL);
+        UniboCGR_contact_plan_close(instance->uniboCgr);
+        return -1;
+    }
+
+    // note: the MTVs (from SDR) are copied only for the contacts to add,
+    //       Unibo-CGR keeps updated the MTVs of the contacts already known.
+    UniboCGR_ContactPlanDelta_reset(instance->delta);
+    error = UniboCGR_ContactPlanDelta_diff_contacts(instance->delta,
+                                                    instance->oldPlan.contacts, instance->oldPlan.contactsCount,
+                                                    instance->newPlan.contacts, instance->newPlan.contactsCount);
+    if (error == UniboCGR_NoError) {
+        error = UniboCGR_ContactPlanDelta_diff_ranges(instance->delta,
+                                                      instance->oldPlan.ranges, instance->oldPlan.rangesCount,
+                                                      instance->newPlan.ranges, instance->newPlan.rangesCount);
+    }
+    if (error == UniboCGR_NoError) {
+        error = UniboCGR_contact_plan_apply_delta(instance->uniboCgr, instance->delta, true);
+    }
+    if (UniboCGR_check_error(error)) {
+        putErrmsg(UniboCGR_get_error_string(error), NULL);
+        if (UniboCGR_check_fatal_error(error)) {
+            // some bad error occurred -- need to close contact plan session and return a negative value
+            UniboCGR_contact_plan_close(instance->uniboCgr);
+            return -1;
         }
     }
+
     // contact plan update done -- close contact plan session and return success (0)
     UniboCGR_contact_plan_close(instance->uniboCgr);
     return 0;
@@ -1873,18 +2034,32 @@ int	cgr_identify_best_routes(IonNode *terminusNode, Bundle *bundle, Lyst exclude
         // route not found
         return 0;
     }
+    // volume consumed by this call (0 if volume reservations are disabled)
+    UniboCGR_Reservation reservation = UniboCGR_get_reservation(instance->uniboCgr);
     if (convert_routes_from_cgr_to_ion(instance, ionwm, ionvdb, uniboCgrBestRoutes, ionBestRoutes) < 0) {
         UniboCGR_log_write(instance->uniboCgr, "Fatal error - cannot convert Unibo-CGR routes into ION routes.");
+        if (reservation != 0) {
+            // ipnfw will not forward the bundle on these routes
+            UniboCGR_reservation_release(instance->uniboCgr, reservation);
+        }
         UniboCGR_routing_close(instance->uniboCgr);
         return -1;
     }
 #if (CGRREB)
     if(CGRR_management(instance, ionBestRoutes) < 0) {
         UniboCGR_log_write(instance->uniboCgr, "Fatal error - CGRR_management() failed.");
+        if (reservation != 0) {
+            UniboCGR_reservation_release(instance->uniboCgr, reservation);
+        }
         UniboCGR_routing_close(instance->uniboCgr);
         return -1;
     }
 #endif
+    if (reservation != 0) {
+        /* ipnfw enqueues the bundle to one of these routes: the volume stays consumed.
+         * If the bundle will be reforwarded the MTVs are restored by update_mtv_before_reforwarding(). */
+        UniboCGR_reservation_commit(instance->uniboCgr, reservation);
+    }
 
     UniboCGR_routing_close(instance->uniboCgr);
     UniboCGR_log_flush(instance->uniboCgr);
@@ -1984,6 +2159,14 @@ static int enable_UniboCGR_default_features(UniboCGR uniboCgr, const char* log_d
         return -1;
     }
 #endif
+#if UNIBO_CGR_FEATURE_VOLUME_RESERVATIONS
+    error = UniboCGR_feature_VolumeReservations_enable(uniboCgr);
+    if (UniboCGR_check_error(error)) {
+        UniboCGR_feature_close(uniboCgr);
+        putErrmsg("Cannot enable Unibo-CGR volume-reservations feature", NULL);
+        return -1;
+    }
+#endif
 
     UniboCGR_feature_close(uniboCgr);
     return 0;